@@ -16,7 +16,7 @@
 #define BMP_CS_Pin              GPIO_PIN_8
 #define BMP_CS_GPIO_Port        GPIOA
 
-#define BMP280_SPI_TIMEOUT      100
+#define BMP280_SPI_PRESCALER    SPI_BAUDRATEPRESCALER_4 // 9 MHz (10 MHz max)
 
 #define BMP280_DEVICE_ID        0x58
 #define BMP280_RESET_VALUE      0xB6
@@ -34,6 +34,10 @@
 #define BMP280_REG_ID           0xD0
 #define BMP280_REG_CALIB_00     0x88
 
+// BMP280_LinearAltitudeMm table: altitude every 1/256 of the reference pressure, down to 0.375
+#define BMP280_ALT_TABLE_SHIFT  8
+#define BMP280_ALT_TABLE_SIZE   161
+
 #define BMP280_MODE_LOW_POWER 0
 #define BMP280_MODE_NORMAL_POWER 1
 
@@ -84,8 +88,10 @@ typedef struct {
 } BMP280_CalibData;
 
 typedef struct {
+    uint32_t			press_Pa_Q8;	// Compensated pressure in Q24.8 (1/256 Pa), for integer comparisons
     float 				press_Pa;
     float				press_ref_Pa;
+    uint32_t			press_ref_inv;	// 2^56 / reference pressure (Q24.8), see BMP280_SetReference
     float 				temp_C;
     float				alt_m;
     int32_t 			t_fine;
@@ -97,12 +103,15 @@ int8_t BMP280_Init(BMP280 *BMP_data, SPI_HandleTypeDef *hspi);
 int8_t BMP280_SetMode(uint8_t mode);
 int8_t BMP280_ReadCalibrationData(BMP280 *BMP_data);
 int8_t BMP280_MeasureReference(BMP280 *BMP_data, uint16_t samples, uint8_t delay);
+void BMP280_SetReference(BMP280 *BMP_data, float press_ref_Pa);
 
 int8_t BMP280_ReadTemperature(BMP280 *BMP_data);
 int8_t BMP280_ReadPressure(BMP280 *BMP_data);
 
+int8_t BMP280_ReadMeasurement(BMP280 *BMP_data);
 int8_t BMP280_ReadAltitude(BMP280 *BMP_data);
 float BMP280_PressureToAltitude(float pressure, float pressure_ref);
+int32_t BMP280_LinearAltitudeMm(const BMP280 *BMP_data);
 
 int8_t BMP280_SoftReset();
 int8_t BMP280_Read(uint8_t reg, uint8_t RX_Buffer[], uint8_t size);
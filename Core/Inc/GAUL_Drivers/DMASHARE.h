@@ -0,0 +1,45 @@
+/*
+ * DMASHARE.h
+ *
+ * DMA1 Channel4 is the only channel of both USART1_TX (RFD900 radio) and SPI2_RX (IMU
+ * burst reads, see RM0008 table 78). "DMASHARE_Acquire" gives the channel to one user at
+ * a time and reprograms it for that user, "DMASHARE_Release" frees it at the end of the
+ * transfer. A user refused while the channel is busy is resumed at the release, before
+ * the releasing user can take the channel again, so neither user starves the other.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_DRIVERS_DMASHARE_H_
+#define INC_GAUL_DRIVERS_DMASHARE_H_
+
+// Users of the channel
+#define DMASHARE_USER_USART1_TX 0
+#define DMASHARE_USER_SPI2_RX   1
+#define DMASHARE_USERS          2
+
+#define DMASHARE_NONE           0xFF
+
+// Called (interrupt context) when the channel is released after the user was refused
+typedef void (*DMASHARE_Resume)(void);
+
+typedef struct {
+	uint32_t acquired[DMASHARE_USERS]; // Transfers started
+	uint32_t refused[DMASHARE_USERS];  // Channel busy with the other user
+	uint32_t switches;                 // Channel reprogrammed for another user
+} DMASHARE_Stats;
+
+void DMASHARE_Init();
+int8_t DMASHARE_Register(uint8_t user, DMA_HandleTypeDef *hdma, DMASHARE_Resume resume);
+
+int8_t DMASHARE_Acquire(uint8_t user);
+void DMASHARE_Release(uint8_t user);
+void DMASHARE_IRQHandler();
+
+uint8_t DMASHARE_Owner();
+const DMASHARE_Stats *DMASHARE_GetStats();
+
+#endif /* INC_GAUL_DRIVERS_DMASHARE_H_ */
@@ -0,0 +1,85 @@
+/*
+ * EPO.h
+ *
+ * Upload of EPO orbit predictions to the L76 (GNSS), without blocking: one PMTK721 sentence
+ * per satellite record, the next one queued by the acknowledge of the previous one (USART2
+ * interrupt), so the upload goes at the pace of the module whatever the main loop does.
+ * The EPO file comes from memory (flash) or from the ground station over the RFD900 link
+ * (USART1), in chunks with an index and a CRC: the ground tool sends the file in passes
+ * until every chunk went through (Tools/epo_upload.py).
+ *
+ * A failed record (no acknowledge after the L76LM33 retries) pauses the upload, EPO_Poll
+ * resumes it at the same record.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/L76LM33.h"
+
+#ifndef INC_GAUL_DRIVERS_EPO_H_
+#define INC_GAUL_DRIVERS_EPO_H_
+
+// EPO file: sets of 32 records (GPS satellites 1 to 32), 6 hours per set
+#define EPO_RECORD_SIZE      72
+#define EPO_SET_RECORDS      32
+#define EPO_MAX_RECORDS      (EPO_SET_RECORDS * 4 * 14) // 14 days
+#define EPO_SENTENCE_SIZE    184   // "$PMTK721,<sv>" + 18 words "," + 8 hex + "*CS\r\n" (178)
+
+// Pace and errors
+#define EPO_ACK_TIMEOUT_MS   1000  // Record written in the flash of the module
+#define EPO_CLEAR_TIMEOUT_MS 3000  // PMTK127, EPO flash erased
+#define EPO_RESUME_MS        500   // Pause after a failed record
+#define EPO_MAX_FAILURES     5     // Failed records in a row before giving up
+
+// Ground link chunks: "EP", index (uint16), count (uint16), record, CRC-16 of index to
+// record (PACKET_CRC16), little endian
+#define EPO_LINK_SYNC0       'E'
+#define EPO_LINK_SYNC1       'P'
+#define EPO_LINK_HEADER      6
+#define EPO_LINK_CHUNK       (EPO_LINK_HEADER + EPO_RECORD_SIZE + 2)
+#define EPO_LINK_BUFFER      256   // Power of 2, 3 chunks (the ground repeats the lost ones)
+
+// States
+#define EPO_IDLE             0
+#define EPO_LISTENING        1     // Ground link: waiting for the first chunk
+#define EPO_CLEARING         2     // PMTK127 in progress
+#define EPO_SENDING          3     // Record in progress
+#define EPO_WAITING          4     // Next record not received yet, or command queue full
+#define EPO_ENDING           5     // End of the transfer in progress
+#define EPO_PAUSED           6     // Command failed, resumed by EPO_Poll
+#define EPO_DONE             7
+#define EPO_FAILED           8     // EPO_MAX_FAILURES in a row
+
+// Module access, NULL: L76LM33 and HAL tick
+typedef struct {
+	int8_t (*command)(const char *body, uint16_t timeout_ms, uint8_t retries, L76LM33_Done done);
+	int8_t (*transfer)(const char *sentence, uint16_t size, uint16_t timeout_ms, uint8_t retries, L76LM33_Done done);
+	uint32_t (*tick)(void);
+} EPO_Port;
+
+typedef struct {
+	uint16_t records;       // Records of the file
+	uint16_t sent;          // Records acknowledged
+	uint32_t start_ms;      // PMTK127 queued
+	uint32_t end_ms;        // End acknowledged
+	uint32_t failures;      // Commands failed after the retries (each one paused the upload)
+	uint32_t resumes;
+	uint32_t chunks;        // Ground link: chunks with a valid CRC
+	uint32_t crc_errors;
+	uint32_t skipped;       // Ground link: chunks already sent or ahead (next passes)
+	uint32_t overflows;     // Ground link: bytes lost, receive buffer full
+} EPO_Stats;
+
+void EPO_Init(const EPO_Port *port);
+int8_t EPO_StartMemory(const uint8_t *file, uint32_t size);
+int8_t EPO_StartLink();
+void EPO_Receive(uint8_t byte);
+void EPO_Poll();
+void EPO_Abort();
+uint8_t EPO_GetState();
+const EPO_Stats *EPO_GetStats();
+
+#endif /* INC_GAUL_DRIVERS_EPO_H_ */
@@ -0,0 +1,116 @@
+/*
+ * GNSSAID.h
+ *
+ * Warm start of the L76 after a power cycle: the last fix (position, UTC date and time) is
+ * kept in the last page of the internal flash, and given back to the module at boot with
+ * PMTK740 (time) and PMTK741 (position). The UTC time is kept across the power cycle by the
+ * RTC of the backup domain (LSE and VBAT), set at the first fix: without it the time is
+ * unknown at boot and nothing is given (a stale time slows the module down).
+ *
+ * The EPO window stored in the module (PMTK607 query, "$PMTK707" reply) is checked at boot
+ * against the UTC time, and the time to first fix of every boot is measured.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/L76LM33.h"
+
+#ifndef INC_GAUL_DRIVERS_GNSSAID_H_
+#define INC_GAUL_DRIVERS_GNSSAID_H_
+
+// Records, appended in the page (erased when full)
+#define GNSSAID_PAGE_ADDRESS    0x0800FC00 // Last 1K page, out of FLASH in STM32F103C8TX_FLASH.ld
+#define GNSSAID_PAGE_SIZE       1024
+#define GNSSAID_RECORD_SIZE     32
+#define GNSSAID_RECORDS         (GNSSAID_PAGE_SIZE / GNSSAID_RECORD_SIZE)
+#define GNSSAID_MAGIC           0x6A1D
+#define GNSSAID_SAVE_PERIOD_S   600    // Saving again on the pad
+#define GNSSAID_MAX_AGE_S       604800 // Older position not given (the rocket may have moved)
+
+// Time
+#define GNSSAID_DAY_S           86400
+#define GNSSAID_RTC_TOLERANCE_S 2      // RTC set again when further from the fix
+#define GNSSAID_GPS_EPOCH_S     630720000 // 1980-01-06 (GPS week 0) to 2000-01-01
+#define GNSSAID_GPS_UTC_S       18     // GPS - UTC (leap seconds since 1980, 2017)
+#define GNSSAID_WEEK_S          604800
+
+// EPO query
+#define GNSSAID_EPO_TIMEOUT_MS  2000   // No "$PMTK707" after PMTK607
+#define GNSSAID_EPO_SET_S       21600  // One EPO set covers 6 hours from its start
+
+// GNSSAID_Update "save"
+#define GNSSAID_SAVE_NONE       0      // Flash not written (flight)
+#define GNSSAID_SAVE_ANY        1      // Program (~1 ms), erase the page when full (CPU stalled 20 to 40 ms)
+#define GNSSAID_SAVE_NO_ERASE   2      // Program only, nothing saved while the page is full
+
+// Aiding given at boot
+#define GNSSAID_AIDING_NONE     0      // UTC time unknown
+#define GNSSAID_AIDING_TIME     1      // PMTK740 only (no record or too old)
+#define GNSSAID_AIDING_POSITION 2      // PMTK740 and PMTK741
+
+// EPO stored in the module
+#define GNSSAID_EPO_PENDING     0      // Query sent
+#define GNSSAID_EPO_UNKNOWN     1      // No reply
+#define GNSSAID_EPO_NONE        2      // No set stored
+#define GNSSAID_EPO_STORED      3      // Window known, UTC time not known yet
+#define GNSSAID_EPO_VALID       4
+#define GNSSAID_EPO_EXPIRED     5      // Or not started
+
+// Flash record, programmed with half-words (erased: 0xFFFF)
+typedef struct {
+	uint16_t magic;         // GNSSAID_MAGIC
+	uint16_t sequence;      // Records saved since the first one
+	uint32_t utc_s;         // UTC of the fix, seconds since 2000-01-01
+	int32_t latitude_e7;
+	int32_t longitude_e7;
+	int16_t altitude_m;     // Above mean sea level, 0 if unknown
+	uint8_t aiding;         // GNSSAID_AIDING_x given at the boot that saved it
+	uint8_t epo;            // GNSSAID_EPO_x at that boot
+	uint32_t ttff_ms;       // Time to first fix of that boot
+	uint32_t epo_end_s;     // End of the EPO window at that boot (UTC), 0: none
+	uint16_t reserved;      // 0xFFFF
+	uint16_t crc;           // PACKET_CRC16 of the bytes before
+} GNSSAID_Record;
+
+// Flash, RTC and module access, NULL: HAL (last flash page, RTC counter in the backup
+// domain, L76LM33_Command). The tests replace it by a flash in RAM and a model of the L76.
+typedef struct {
+	const uint8_t *page;    // GNSSAID_PAGE_SIZE bytes, read directly
+	int8_t (*erase)(const uint8_t *page);
+	int8_t (*program)(const uint8_t *address, const uint16_t *data, uint16_t count); // Half-words
+	int8_t (*get_time)(uint32_t *utc_s); // 0: UTC kept across the power cycle, -1: unknown
+	void (*set_time)(uint32_t utc_s);
+	int8_t (*command)(const char *body, uint16_t timeout_ms, uint8_t retries, L76LM33_Done done);
+	uint32_t (*tick)(void);
+} GNSSAID_Port;
+
+typedef struct {
+	uint8_t loaded;         // 1: record found at boot ("previous")
+	uint8_t aiding;         // GNSSAID_AIDING_x given at boot
+	uint8_t acknowledged;   // Aiding commands acknowledged (PMTK740, PMTK741)
+	uint8_t rejected;       // Aiding commands rejected or not acknowledged, not queued
+	uint8_t epo;            // GNSSAID_EPO_x
+	uint8_t epo_sets;       // EPO sets stored in the module
+	uint32_t epo_start_s;   // EPO window (UTC, seconds since 2000-01-01)
+	uint32_t epo_end_s;
+	uint32_t ttff_ms;       // HAL tick of the first fix (the L76 is powered with the MCU), 0: no fix
+	uint32_t saves;         // Records saved since boot
+	uint32_t erases;
+	uint32_t errors;        // Flash erase or program failed
+	uint32_t time_sets;     // RTC set from a fix
+	GNSSAID_Record previous; // Record found at boot (TTFF and aiding of the previous boot)
+} GNSSAID_Stats;
+
+int8_t GNSSAID_Init(const GNSSAID_Port *port);
+int8_t GNSSAID_Start();
+void GNSSAID_Reply(const char *sentence);
+int8_t GNSSAID_Update(const L76LM33 *L76_data, uint8_t save);
+const GNSSAID_Stats *GNSSAID_GetStats();
+
+uint32_t GNSSAID_ToUtc(uint16_t year, uint8_t month, uint8_t day, uint32_t seconds);
+void GNSSAID_FromUtc(uint32_t utc_s, uint16_t *year, uint8_t *month, uint8_t *day, uint32_t *seconds);
+
+#endif /* INC_GAUL_DRIVERS_GNSSAID_H_ */
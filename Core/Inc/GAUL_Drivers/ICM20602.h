@@ -0,0 +1,126 @@
+/*
+ * ICM20602.h
+ *
+ * ICM-20602 accelerometer and gyroscope on the SPI2 bus (SPIBUS.h, chip select ICM_CS on
+ * PB0). The IMU samples at 1 kHz into its on-chip FIFO (1008 bytes,
+ * 72 samples), the FIFO is drained periodically with one burst read of many samples:
+ * "ICM20602_StartRead" reads the FIFO count and starts the burst (DMA), the IMU releases
+ * the bus at the end of the transfer and "ICM20602_Collect" returns the samples.
+ *
+ * The IMU does not timestamp the samples: the time of each sample is reconstructed from
+ * the drain time and the FIFO count (the newest sample in the FIFO is less than one period
+ * old), on a timeline that follows the IMU clock drift. The FIFO stops when it is full:
+ * an overflow is detected, the samples kept are returned, then the FIFO is reset and the
+ * samples lost are counted.
+ *
+ * FIFO packet (14 bytes, accelerometer and gyroscope enabled): register order from
+ * ACCEL_XOUT_H to GYRO_ZOUT_L, big-endian: accel X Y Z | temperature | gyro X Y Z.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_DRIVERS_ICM20602_H_
+#define INC_GAUL_DRIVERS_ICM20602_H_
+
+#define ICM_CS_Pin                GPIO_PIN_0
+#define ICM_CS_GPIO_Port          GPIOB
+
+#define ICM20602_SPI_PRESCALER    SPI_BAUDRATEPRESCALER_4 // 9 MHz (10 MHz max)
+#define ICM20602_RESET_DELAY_MS   100
+
+#define ICM20602_DEVICE_ID        0x12
+
+// Registers
+#define ICM20602_REG_SMPLRT_DIV   0x19
+#define ICM20602_REG_CONFIG       0x1A
+#define ICM20602_REG_GYRO_CONFIG  0x1B
+#define ICM20602_REG_ACCEL_CONFIG 0x1C
+#define ICM20602_REG_ACCEL_CFG2   0x1D
+#define ICM20602_REG_FIFO_EN      0x23
+#define ICM20602_REG_INT_STATUS   0x3A
+#define ICM20602_REG_ACCEL_XOUT_H 0x3B
+#define ICM20602_REG_USER_CTRL    0x6A
+#define ICM20602_REG_PWR_MGMT_1   0x6B
+#define ICM20602_REG_PWR_MGMT_2   0x6C
+#define ICM20602_REG_I2C_IF       0x70
+#define ICM20602_REG_FIFO_COUNTH  0x72
+#define ICM20602_REG_FIFO_R_W     0x74
+#define ICM20602_REG_WHO_AM_I     0x75
+
+#define ICM20602_READ             0x80 // Register address bit 7
+
+// Settings
+#define ICM20602_SETTING_RESET      0x80 // PWR_MGMT_1: DEVICE_RESET
+#define ICM20602_SETTING_CLOCK      0x01 // PWR_MGMT_1: best clock source (gyroscope PLL)
+#define ICM20602_SETTING_I2C_DIS    0x40 // I2C_IF: SPI only
+#define ICM20602_SETTING_CONFIG     0x41 // CONFIG: FIFO_MODE (stop when full), DLPF_CFG 1 (176 Hz, 1 kHz)
+#define ICM20602_SETTING_SMPLRT_DIV 0x00 // 1 kHz / (1 + 0)
+#define ICM20602_SETTING_GYRO       0x18 // GYRO_CONFIG: +/-2000 dps
+#define ICM20602_SETTING_ACCEL      0x18 // ACCEL_CONFIG: +/-16 g
+#define ICM20602_SETTING_ACCEL2     0x00 // ACCEL_CONFIG2: 218 Hz
+#define ICM20602_SETTING_FIFO_EN    0x18 // FIFO_EN: GYRO_FIFO_EN | ACCEL_FIFO_EN
+#define ICM20602_USER_FIFO_EN       0x40 // USER_CTRL
+#define ICM20602_USER_FIFO_RST      0x04
+#define ICM20602_INT_FIFO_OFLOW     0x10 // INT_STATUS
+
+#define ICM20602_FIFO_SIZE        1008
+#define ICM20602_PACKET_SIZE      14
+#define ICM20602_FIFO_SAMPLES     (ICM20602_FIFO_SIZE / ICM20602_PACKET_SIZE) // 72 ms at 1 kHz
+#define ICM20602_MAX_BURST        24   // Samples per burst read (336 bytes of RAM)
+#define ICM20602_PERIOD_NS        1000000 // 1 kHz
+#define ICM20602_DRIFT_SAMPLES    1000 // Samples between two period estimations
+
+#define ICM20602_ACCEL_LSB_PER_G  2048 // +/-16 g
+#define ICM20602_GYRO_LSB_PER_DPS 16.4f // +/-2000 dps
+#define ICM20602_TEMP_LSB_PER_C   326.8f // T = raw / 326.8 + 25
+
+// Read states
+#define ICM20602_STATE_IDLE       0
+#define ICM20602_STATE_DMA        1 // Burst read by DMA
+#define ICM20602_STATE_DONE       2 // Burst read complete, samples not collected
+
+// SPI access, NULL functions use the SPI bus (SPIBUS.h)
+typedef struct {
+	void (*select)(uint8_t selected);                   // 1: CS low
+	uint8_t (*exchange)(uint8_t byte);                  // Full duplex byte
+	void (*read)(uint8_t data[], uint16_t size);        // Burst read (blocking)
+	// Select, register address, burst read with DMA, deselect. Completion calls ICM20602_RxCallback
+	int8_t (*read_dma)(uint8_t reg, uint8_t data[], uint16_t size);
+} ICM20602_Port;
+
+typedef struct {
+	uint32_t time_us;          // Reconstructed sample time
+	int16_t accel[3];          // ICM20602_ACCEL_LSB_PER_G
+	int16_t gyro[3];
+	int16_t temp;
+} ICM20602_Sample;
+
+typedef struct {
+	uint32_t samples;          // Samples collected
+	uint32_t reads;            // Burst reads
+	uint32_t overflows;        // FIFO full, then reset
+	uint32_t lost;             // Samples lost by the overflows (from the timeline)
+	uint32_t dma_fallbacks;    // Burst reads done without DMA
+	uint32_t errors;           // FIFO count not a multiple of a packet (FIFO reset)
+	uint32_t resyncs;          // Timeline restarted
+	int32_t max_correction_us; // Largest timeline correction (drift and jitter)
+	uint32_t period_ns;        // Estimated sample period (IMU clock)
+} ICM20602_Stats;
+
+int8_t ICM20602_Init(SPI_HandleTypeDef *hspi, const ICM20602_Port *port);
+
+int8_t ICM20602_StartRead(uint32_t time_us);
+int16_t ICM20602_Collect(ICM20602_Sample samples[]);
+void ICM20602_RxCallback(SPI_HandleTypeDef *hspi);
+
+uint8_t ICM20602_GetState();
+uint16_t ICM20602_Pending();
+const ICM20602_Stats *ICM20602_GetStats();
+
+int8_t ICM20602_Read(uint8_t reg, uint8_t data[], uint16_t size);
+int8_t ICM20602_Write(uint8_t reg, uint8_t value);
+
+#endif /* INC_GAUL_DRIVERS_ICM20602_H_ */
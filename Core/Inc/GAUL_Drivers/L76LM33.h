@@ -14,22 +14,142 @@
 #define INC_GAUL_DRIVERS_L76LM33_H_
 
 #define L76LM33_BUFFER_SIZES 256  // NMEA sentence is around 80 char max, has to be a power of two.
-#define L76LM33_UART_TIMEOUT 1000 // For UART transmit
+
+// Link negotiation (L76LM33_Init)
+#define L76LM33_BAUD_DEFAULT    9600   // Factory baud rate, USART2 at reset
+#define L76LM33_BAUD_FAST       115200 // Asked with PMTK251
+#define L76LM33_FIX_PERIOD_MS   100    // 10 Hz at L76LM33_BAUD_FAST (PMTK220)
+#define L76LM33_SLOW_PERIOD_MS  200    // 5 Hz when staying at a slower baud rate (RMC + GGA ~80% of the line at 9600 baud)
+#define L76LM33_PROBE_MS        1200   // Listen at a baud rate for a valid sentence (1 Hz by default)
+#define L76LM33_SWITCH_MS       100    // Module restarts its UART after PMTK251
+#define L76LM33_VERIFY_SENTENCES 6     // RMC sentences timed to verify the fix interval
+#define L76LM33_PERIOD_TOLERANCE 4     // Measured period within 1/4 of the fix interval
+
+// Command engine (L76LM33_Command)
+#define L76LM33_COMMAND_QUEUE   4      // Commands waiting or in progress
+#define L76LM33_COMMAND_SIZE    64     // "$" + body + "*CS\r\n" (PMTK314 is 57)
+#define L76LM33_ACK_TIMEOUT_MS  1000   // $PMTK001 may wait behind a burst of sentences at 9600 baud
+#define L76LM33_RETRIES         2      // Transmissions after the first one (no or failed acknowledge)
+#define L76LM33_ACK_SIZE        24     // "$PMTK001,<cmd>,<flag>*CS"
+
+// Time of the fixes (L76LM33_Read, L76LM33_GetPosition)
+#define L76LM33_LINE_TICKS      8      // Arrival time kept for the last lines, power of two
+#define L76LM33_DAY_MS          86400000
+#define L76LM33_CLOCK_LEAK      16     // Clock offset raised 1 ms after this many later arrivals (drift)
+#define L76LM33_CLOCK_RESYNC_MS 3600000 // UTC jump larger than this: clock model restarted
+#define L76LM33_OUTPUT_DELAY_MS 0      // Fix epoch to first byte of the RMC (measure with the 1PPS output)
+#define L76LM33_MAX_EXTRAPOLATION_MS 2000 // Older fix: not extrapolated further
+#define L76LM33_KNOTS_TO_MPS    0.514444f
+#define L76LM33_EARTH_RADIUS_M  6371000.0f
+
+// $PMTK001 flags
+#define L76LM33_ACK_INVALID     0
+#define L76LM33_ACK_UNSUPPORTED 1
+#define L76LM33_ACK_FAILED      2      // Valid command, action failed (retried)
+#define L76LM33_ACK_SUCCESS     3
+
+// PMTK886 navigation modes
+#define L76LM33_NAVMODE_NORMAL   0
+#define L76LM33_NAVMODE_FITNESS  1
+#define L76LM33_NAVMODE_AVIATION 2     // Large accelerations, 10'000 m max
+#define L76LM33_NAVMODE_BALLOON  3
 
 typedef struct {
 	uint8_t status; // 1: OK, 0: Error
 	uint8_t fix; // 1: GPS Fix, 0: No GPS Fix
 	float latitude;
 	float longitude;
+	int32_t latitude_e7;  // Same position in 1e-7 degrees (no float rounding)
+	int32_t longitude_e7;
+	float speed_mps;    // Speed over ground
+	float course_deg;   // Course over ground, degrees from true north
+	uint32_t utc_ms;    // UTC time of the fix, ms of the day
+	uint16_t year;      // UTC date of the fix (RMC), day 0: unknown
+	uint8_t month;
+	uint8_t day;
+	uint32_t rx_ms;     // HAL tick at the first byte of the sentence
+	uint32_t fix_ms;    // HAL tick of the fix (clock model), position valid at this time
+	uint8_t altitude_fix; // 1: altitude_m valid (GGA with a fix)
+	uint8_t satellites; // Satellites used (GGA)
+	float altitude_m;   // Above mean sea level (GGA)
+	uint32_t altitude_ms; // HAL tick of the altitude, the RMC of the same fix may be read before
 } L76LM33;
 
-int8_t L76LM33_Init(UART_HandleTypeDef *huart);
+// Mapping from the UTC time of the fixes to the HAL tick: offset from the earliest arrival
+// of the sentences (the transmission and the reading add delay, never remove it)
+typedef struct {
+	uint8_t synced;     // 1: offset valid
+	uint32_t offset_ms; // HAL tick - UTC (unwrapped at midnight)
+	uint32_t utc_last_ms; // Last UTC time of the day
+	uint32_t utc_ms;    // UTC since the clock model started, unwrapped
+	uint8_t leak;       // Later arrivals since the last raise
+	uint16_t delay_ms;  // Arrival of the last sentence after the model
+	uint16_t max_delay_ms;
+	uint32_t fixes;
+	uint32_t resyncs;
+} L76LM33_Clock;
+
+typedef struct {
+	float latitude;     // Extrapolated to the time asked
+	float longitude;
+	uint32_t age_ms;    // Time since the fix
+} L76LM33_Position;
+
+// UART access, NULL: HAL (transmit with interrupts, USART2 re-initialized at the new baud
+// rate, reception restarted). The tests replace it by a model of the module.
+typedef struct {
+	int8_t (*transmit)(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size); // Starts, L76LM33_TxCallback at the end
+	int8_t (*set_baud)(UART_HandleTypeDef *huart, uint32_t baud);
+	uint32_t (*tick)(void);
+	void (*wait)(uint32_t ms);
+} L76LM33_Port;
+
+typedef struct {
+	uint32_t baud;          // Baud rate in use, 0: module not found
+	uint16_t period_ms;     // Measured RMC period, 0: not measured
+	uint16_t asked_ms;      // Fix interval asked with PMTK220
+	uint8_t fast;           // 1: running at L76LM33_BAUD_FAST
+	uint8_t rate_ok;        // 1: measured period matches the fix interval asked
+	uint8_t probes;         // Baud rates tried
+	uint32_t init_ms;       // Time taken by the negotiation
+} L76LM33_Link;
+
+// Called once per command, result 0: acknowledged (or sent when no acknowledge is expected),
+// -1: rejected or UART error, -3: no acknowledge after the retries. May be called from the
+// USART2 interrupt.
+typedef void (*L76LM33_Done)(uint16_t command, int8_t result);
+
+// Called with the checksum-valid "$PMTK..." lines other than $PMTK001 (replies to the
+// queries, "$PMTK707,..."), from L76LM33_Read.
+typedef void (*L76LM33_Reply)(const char *sentence);
+
+typedef struct {
+	uint32_t sent;          // Transmissions, retries included
+	uint32_t retries;
+	uint32_t acknowledged;  // $PMTK001 success
+	uint32_t rejected;      // $PMTK001 invalid or unsupported, failed on the last try, UART error
+	uint32_t timeouts;      // No $PMTK001 after the last try
+	uint32_t full;          // Queue full, command not queued
+} L76LM33_CommandStats;
+
+int8_t L76LM33_Init(UART_HandleTypeDef *huart, const L76LM33_Port *port);
+const L76LM33_Link *L76LM33_GetLink();
+
+int8_t L76LM33_Command(const char *body, uint16_t timeout_ms, uint8_t retries, L76LM33_Done done);
+int8_t L76LM33_Transfer(const char *sentence, uint16_t size, uint16_t timeout_ms, uint8_t retries, L76LM33_Done done);
+int8_t L76LM33_SetNavMode(uint8_t mode, L76LM33_Done done);
+void L76LM33_SetReplyHandler(L76LM33_Reply handler);
+void L76LM33_Poll();
+uint8_t L76LM33_CommandsPending();
+const L76LM33_CommandStats *L76LM33_GetCommandStats();
 
 void L76LM33_RxCallback(UART_HandleTypeDef *huart);
+int8_t L76LM33_RestartReceive();
+void L76LM33_TxCallback(UART_HandleTypeDef *huart);
 
 int8_t L76LM33_Read(L76LM33 *L76_data);
+int8_t L76LM33_GetPosition(const L76LM33 *L76_data, uint32_t now_ms, L76LM33_Position *position);
+const L76LM33_Clock *L76LM33_GetClock();
 int8_t L76LM33_ReadSentence();
 
-int8_t L76LM33_SendCommand(char command[], uint8_t size);
-
 #endif /* INC_GAUL_DRIVERS_L76LM33_H_ */
@@ -13,8 +13,9 @@
 #ifndef INC_GAUL_DRIVERS_NMEA_H
 #define INC_GAUL_DRIVERS_NMEA_H
 
-#define NMEA_MAX_TOKEN_TO_READ 7
-#define NMEA_MAX_RMC_LENGTH 90
+#define NMEA_MAX_TOKEN_TO_READ 10
+#define NMEA_MAX_GGA_TOKEN_TO_READ 10
+#define NMEA_MAX_RMC_LENGTH 90 // Also used for GGA (82 char max)
 
 typedef struct {
 	uint8_t hours;		// Hours when GPS fix acquired
@@ -22,14 +23,30 @@ typedef struct {
 	float seconds;		// Seconds when GPS fix acquired
 } time_t;
 
+typedef struct {
+	uint8_t day;		// 1 to 31, 0: date unknown
+	uint8_t month;		// 1 to 12
+	uint16_t year;		// 2000 to 2099
+} date_t;
+
 typedef struct {
     time_t time;		// Time when GPS fix acquired
+    date_t date;		// UTC date of the fix (RMC), day 0 if no fix or empty field
     int8_t fix;			// 1: GPS Fix, 0: No GPS Fix
     float latitude;		// Latitude in Decimal Degrees
     float longitude;	// Longitude in Decimal Degrees
+    int32_t latitude_e7;	// Same latitude in 1e-7 degrees, parsed without float (1.1 cm)
+    int32_t longitude_e7;
+    float speed_knots;	// Speed over ground, 0 if no fix
+    float course_deg;	// Course over ground, degrees from true north
+    float altitude_m;	// Altitude above mean sea level (GGA), 0 if no fix
+    uint8_t satellites;	// Satellites used (GGA)
 } GPS_Data;
 
 int8_t NMEA_ValidateRMC(const char *nmea_sentence);
+int8_t NMEA_ValidateChecksum(const char *nmea_sentence);
 int8_t NMEA_ParseRMC(const char *nmea_sentence, GPS_Data *gps_data);
+int8_t NMEA_ValidateGGA(const char *nmea_sentence);
+int8_t NMEA_ParseGGA(const char *nmea_sentence, GPS_Data *gps_data);
 
 #endif /* INC_GAUL_DRIVERS_NMEA_H */
@@ -0,0 +1,63 @@
+/*
+ * RFD900.h
+ *
+ * RFD900 telemetry radio on USART1 (RFD_TX/RFD_RX, PB6/PB7), non-blocking transmit.
+ * "RFD900_Send" copies a whole frame in a queue and returns immediately, the frame is sent
+ * with DMA (DMA1 Channel4, shared with SPI2_RX, see DMASHARE.h) and the TX complete
+ * interrupt ("RFD900_TxCallback") starts the next frame. When the queue is full, the newest
+ * frame (the one being sent by the caller) or the oldest waiting frame is dropped,
+ * depending on the policy. Bytes from the ground station are received with interrupts,
+ * one at a time, and given to a function ("RFD900_StartReceive").
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include <stddef.h>
+
+#ifndef INC_GAUL_DRIVERS_RFD900_H_
+#define INC_GAUL_DRIVERS_RFD900_H_
+
+#define RFD900_QUEUE_SIZE 8   // Waiting frames, power of 2 (+ 1 frame being sent)
+#define RFD900_FRAME_SIZE 48  // Bytes per frame at most (50 ms at 9600 baud), PACKET frames fit
+
+// Full queue policy
+#define RFD900_DROP_NEWEST 0 // Refuse the new frame (keep the history)
+#define RFD900_DROP_OLDEST 1 // Replace the oldest waiting frame (keep the latest data)
+
+// Start the transmission of a frame (returns 0 if started, -2 to retry at RFD900_Resume),
+// NULL: HAL_UART_Transmit_DMA. Completion is reported by calling RFD900_TxCallback.
+typedef int8_t (*RFD900_Transmit)(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+
+// Byte received from the ground station, called from the USART1 receive interrupt
+typedef void (*RFD900_Receive)(uint8_t byte);
+
+typedef struct {
+	uint32_t queued;         // Frames accepted by RFD900_Send
+	uint32_t sent;           // Frames fully sent
+	uint32_t sent_bytes;
+	uint32_t dropped_newest; // Frames refused because the queue was full
+	uint32_t dropped_oldest; // Waiting frames replaced by a newer frame
+	uint32_t errors;         // Frames lost because the transmission could not start
+	uint32_t channel_waits;  // Frames delayed, DMA channel used by SPI2_RX
+	uint8_t max_pending;     // Highest number of waiting frames (backpressure)
+	uint32_t received;       // Bytes received from the ground station
+} RFD900_Stats;
+
+int8_t RFD900_Init(UART_HandleTypeDef *huart, uint8_t policy, RFD900_Transmit transmit);
+
+int8_t RFD900_Send(const uint8_t data[], uint16_t size);
+void RFD900_TxCallback(UART_HandleTypeDef *huart);
+void RFD900_Resume();
+
+int8_t RFD900_StartReceive(RFD900_Receive receive);
+void RFD900_RxCallback(UART_HandleTypeDef *huart);
+int8_t RFD900_RestartReceive();
+
+uint8_t RFD900_Pending();
+uint8_t RFD900_Busy();
+const RFD900_Stats *RFD900_GetStats();
+
+#endif /* INC_GAUL_DRIVERS_RFD900_H_ */
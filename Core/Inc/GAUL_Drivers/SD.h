@@ -0,0 +1,104 @@
+/*
+ * SD.h
+ *
+ * SD card in SPI mode on the SPI2 bus (SPIBUS.h, chip select SD_CS on PB12).
+ * "SD_Init" initializes the card (SDSC or SDHC/SDXC) at boot. "SD_ReadBlock" and
+ * "SD_WriteBlock" are blocking single block accesses, for the pad only. During flight,
+ * blocks are written with one multi-block write: "SD_WriteStart" (ACMD23 pre-erase and
+ * CMD25), then "SD_WriteNext" queues each block on the bus (DMA) and returns immediately,
+ * and "SD_Poll" checks the card response and polls the card busy time one byte at a time.
+ * The card is deselected while it is busy, so the bus stays free for the other devices.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_DRIVERS_SD_H_
+#define INC_GAUL_DRIVERS_SD_H_
+
+#define SD_CS_Pin                 GPIO_PIN_12
+#define SD_CS_GPIO_Port           GPIOB
+
+#define SD_INIT_TIMEOUT_MS        1000 // ACMD41 initialization
+#define SD_READ_TIMEOUT_MS        100  // Data token after CMD17
+#define SD_BUSY_TIMEOUT_MS        500  // Programming time (250 ms max in the SD specification)
+#define SD_SLOW_PRESCALER         SPI_BAUDRATEPRESCALER_128 // 281 kHz, below 400 kHz for initialization
+#define SD_FAST_PRESCALER         SPI_BAUDRATEPRESCALER_2   // 18 MHz (SPI2 maximum, 25 MHz for the card)
+
+#define SD_BLOCK_SIZE             512
+
+// Commands
+#define SD_CMD0                   0  // GO_IDLE_STATE
+#define SD_CMD8                   8  // SEND_IF_COND
+#define SD_CMD12                  12 // STOP_TRANSMISSION
+#define SD_CMD13                  13 // SEND_STATUS
+#define SD_CMD16                  16 // SET_BLOCKLEN
+#define SD_CMD17                  17 // READ_SINGLE_BLOCK
+#define SD_CMD24                  24 // WRITE_BLOCK
+#define SD_CMD25                  25 // WRITE_MULTIPLE_BLOCK
+#define SD_CMD55                  55 // APP_CMD
+#define SD_CMD58                  58 // READ_OCR
+#define SD_ACMD23                 23 // SET_WR_BLK_ERASE_COUNT
+#define SD_ACMD41                 41 // SD_SEND_OP_COND
+
+// Tokens
+#define SD_TOKEN_START_BLOCK      0xFE // CMD17, CMD24
+#define SD_TOKEN_START_MULTI      0xFC // CMD25
+#define SD_TOKEN_STOP_TRAN        0xFD // End of CMD25
+#define SD_DATA_ACCEPTED          0x05 // Data response (5 low bits)
+
+#define SD_R1_IDLE                0x01
+#define SD_R1_ILLEGAL_COMMAND     0x04
+
+// Card types
+#define SD_TYPE_NONE              0
+#define SD_TYPE_SDSC              1 // Byte addressing
+#define SD_TYPE_SDHC              2 // Block addressing (SDHC and SDXC)
+
+// Write states
+#define SD_STATE_IDLE             0 // No multi-block write
+#define SD_STATE_READY            1 // Multi-block write, ready for the next block
+#define SD_STATE_DMA              2 // Block sent by DMA
+#define SD_STATE_DMA_DONE         3 // DMA complete, response not read yet
+#define SD_STATE_BUSY             4 // Card programming the block
+#define SD_STATE_STOPPING         5 // Stop token sent, card busy
+
+// SPI access, NULL functions use the SPI bus (SPIBUS.h)
+typedef struct {
+	void (*select)(uint8_t selected);          // 1: CS low, 0: CS high and one byte to release MISO
+	uint8_t (*exchange)(uint8_t byte);         // Full duplex byte
+	// Select, 0xFF and token, data with DMA, then receive the trailer (CRC and data response)
+	// and deselect. Completion calls SD_TxCallback.
+	int8_t (*write_dma)(uint8_t token, const uint8_t data[], uint16_t size, uint8_t trailer[],
+			uint8_t trailer_size);
+	void (*set_fast)(uint8_t fast);            // 0: initialization clock
+} SD_Port;
+
+typedef struct {
+	uint32_t blocks_written;   // Blocks accepted and programmed by the card
+	uint32_t errors;           // Data responses other than accepted
+	uint32_t dma_errors;       // Blocks sent without DMA (bus queue full)
+	uint32_t timeouts;         // Busy for more than SD_BUSY_TIMEOUT_MS
+	uint32_t max_busy_ms;      // Longest programming time
+	uint32_t busy_polls;       // SD_Poll calls that found the card busy
+} SD_Stats;
+
+int8_t SD_Init(SPI_HandleTypeDef *hspi, const SD_Port *port);
+
+int8_t SD_ReadBlock(uint32_t block, uint8_t data[]);
+int8_t SD_WriteBlock(uint32_t block, const uint8_t data[]);
+
+int8_t SD_WriteStart(uint32_t block, uint32_t pre_erase_blocks);
+int8_t SD_WriteNext(const uint8_t data[]);
+int8_t SD_WriteStop();
+int8_t SD_Poll();
+void SD_TxCallback(SPI_HandleTypeDef *hspi);
+
+uint8_t SD_GetType();
+uint8_t SD_GetState();
+uint8_t SD_DMABusy();
+const SD_Stats *SD_GetStats();
+
+#endif /* INC_GAUL_DRIVERS_SD_H_ */
@@ -0,0 +1,124 @@
+/*
+ * SPIBUS.h
+ *
+ * SPI2 bus manager, shared by the BMP280, the ICM-20602 and the SD card. Each device is
+ * added with its chip select and its own clock ("SPIBUS_AddDevice"), the prescaler is
+ * switched when the bus goes to another device.
+ *
+ * Two ways to use the bus:
+ * - Transactions ("SPIBUS_Submit"): a descriptor (device, priority, header, data, trailer,
+ *   callback) is queued and the function returns. The queue runs back to back: the end of
+ *   each transfer (DMA interrupt) starts the next one. The highest priority goes first,
+ *   so an IMU FIFO drain goes before an SD block already waiting.
+ * - Sessions ("SPIBUS_Select", "SPIBUS_Exchange", "SPIBUS_Deselect"): blocking byte
+ *   exchanges with the chip select held, for commands and short register accesses. A
+ *   session waits for the transfer in progress, then goes before the queued transactions.
+ *
+ * SPI2_RX uses DMA1 Channel4, shared with USART1_TX (see DMASHARE.h): a transaction that
+ * receives waits for the channel while the radio sends a frame, the transactions that only
+ * transmit (SPI2_TX on Channel5) can run meanwhile.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_DRIVERS_SPIBUS_H_
+#define INC_GAUL_DRIVERS_SPIBUS_H_
+
+#define SPIBUS_SPI_TIMEOUT      100
+#define SPIBUS_SELECT_TIMEOUT_MS 10  // Session waiting for the bus
+#define SPIBUS_MAX_DEVICES      4
+#define SPIBUS_QUEUE_SIZE       4    // Queued transactions (+ 1 transaction in progress)
+#define SPIBUS_HEADER_SIZE      4    // Bytes sent before the data (command, address)
+#define SPIBUS_TRAILER_SIZE     12   // Bytes received after the data (CRC, response)
+#define SPIBUS_DMA_MIN_SIZE     16   // Shorter data are exchanged without DMA
+
+#define SPIBUS_NONE             0xFF
+
+// Device flags
+#define SPIBUS_DEVICE_RELEASE_MISO 0x01 // One byte clocked with CS high after the device (SD card)
+
+// Transaction priorities
+#define SPIBUS_PRIORITY_LOW     0 // Bulk data (SD blocks)
+#define SPIBUS_PRIORITY_NORMAL  1
+#define SPIBUS_PRIORITY_HIGH    2 // Time critical (IMU FIFO drain)
+
+// Transaction status
+#define SPIBUS_STATUS_DONE      0
+#define SPIBUS_STATUS_ERROR     -1
+#define SPIBUS_STATUS_QUEUED    1
+#define SPIBUS_STATUS_RUNNING   2
+
+typedef struct SPIBUS_Transaction SPIBUS_Transaction;
+
+// End of a transaction (interrupt context when the data went by DMA)
+typedef void (*SPIBUS_Callback)(SPIBUS_Transaction *transaction);
+
+struct SPIBUS_Transaction {
+	uint8_t device;                        // From SPIBUS_AddDevice
+	uint8_t priority;                      // SPIBUS_PRIORITY_x
+	uint8_t header[SPIBUS_HEADER_SIZE];    // Sent first, received bytes discarded
+	uint8_t header_size;
+	const uint8_t *tx;                     // Data sent, NULL: 0xFF
+	uint8_t *rx;                           // Data received, NULL: discarded (can be tx)
+	uint16_t size;
+	uint8_t trailer[SPIBUS_TRAILER_SIZE];  // Received last (0xFF sent)
+	uint8_t trailer_size;
+	SPIBUS_Callback callback;              // NULL: none
+	void *context;                         // For the callback
+	volatile int8_t status;                // SPIBUS_STATUS_x
+};
+
+typedef struct {
+	GPIO_TypeDef *cs_port;
+	uint16_t cs_pin;
+	uint32_t prescaler;                    // SPI_BAUDRATEPRESCALER_x
+	uint8_t flags;                         // SPIBUS_DEVICE_x
+} SPIBUS_Device;
+
+// SPI access, NULL functions use the HAL
+typedef struct {
+	void (*select)(const SPIBUS_Device *device, uint8_t selected);         // 1: CS low
+	void (*set_prescaler)(uint32_t prescaler);
+	void (*transfer)(const uint8_t tx[], uint8_t rx[], uint16_t size);     // Blocking, tx NULL: 0xFF
+	int8_t (*transfer_dma)(const uint8_t tx[], uint8_t rx[], uint16_t size); // Completion calls SPIBUS_TxRxCallback
+	int8_t (*acquire_rx_dma)();            // 0: RX channel free, -2: busy (SPIBUS_Resume at its release)
+	void (*release_rx_dma)();
+} SPIBUS_Port;
+
+typedef struct {
+	uint32_t transactions;     // Transactions completed
+	uint32_t dma;              // With the data by DMA
+	uint32_t dma_errors;       // DMA could not start, data exchanged without DMA
+	uint32_t rx_dma_waits;     // Transaction delayed, RX DMA channel used by the radio
+	uint32_t reordered;        // Transactions queued before a lower priority one
+	uint32_t sessions;
+	uint32_t session_waits;    // Sessions that waited for a transfer in progress
+	uint32_t session_timeouts;
+	uint32_t prescaler_switches;
+	uint8_t max_queued;        // Highest number of queued transactions
+} SPIBUS_Stats;
+
+int8_t SPIBUS_Init(SPI_HandleTypeDef *hspi, const SPIBUS_Port *port);
+int8_t SPIBUS_AddDevice(GPIO_TypeDef *cs_port, uint16_t cs_pin, uint32_t prescaler, uint8_t flags);
+int8_t SPIBUS_SetPrescaler(uint8_t device, uint32_t prescaler);
+
+int8_t SPIBUS_Submit(SPIBUS_Transaction *transaction);
+void SPIBUS_TxRxCallback(SPI_HandleTypeDef *hspi);
+void SPIBUS_Resume();
+
+int8_t SPIBUS_Select(uint8_t device);
+uint8_t SPIBUS_Exchange(uint8_t byte);
+void SPIBUS_Transmit(const uint8_t data[], uint16_t size);
+void SPIBUS_Receive(uint8_t data[], uint16_t size);
+void SPIBUS_Deselect(uint8_t device);
+int8_t SPIBUS_Clock(uint8_t device, uint16_t count);
+
+uint8_t SPIBUS_Busy();
+uint8_t SPIBUS_Queued();
+const SPIBUS_Device *SPIBUS_GetDevice(uint8_t device);
+const SPIBUS_Stats *SPIBUS_GetStats();
+
+#endif /* INC_GAUL_DRIVERS_SPIBUS_H_ */
@@ -13,7 +13,8 @@
 #define DEBUG_Pin GPIO_PIN_5
 #define DEBUG_GPIO_Port GPIOB
 
-int8_t BMP280_TESTS_LogUART(UART_HandleTypeDef *huart);
+int8_t BMP280_TESTS_LogUART();
 int8_t BMP280_TESTS_LogSTLINK();
+int8_t BMP280_TESTS_LinearAltitude_LogSTLINK();
 
 #endif /* INC_GAUL_DRIVERS_TESTS_BMP280_TESTS_H_ */
@@ -0,0 +1,20 @@
+/*
+ * EPO_tests.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/EPO.h"
+
+#ifndef INC_GAUL_DRIVERS_TESTS_EPO_TESTS_H_
+#define INC_GAUL_DRIVERS_TESTS_EPO_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+void EPO_TESTS_Model_LogSTLINK();
+
+#endif /* INC_GAUL_DRIVERS_TESTS_EPO_TESTS_H_ */
@@ -0,0 +1,20 @@
+/*
+ * GNSSAID_tests.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/GNSSAID.h"
+
+#ifndef INC_GAUL_DRIVERS_TESTS_GNSSAID_TESTS_H_
+#define INC_GAUL_DRIVERS_TESTS_GNSSAID_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+void GNSSAID_TESTS_Model_LogSTLINK();
+
+#endif /* INC_GAUL_DRIVERS_TESTS_GNSSAID_TESTS_H_ */
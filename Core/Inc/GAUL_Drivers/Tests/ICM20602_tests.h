@@ -0,0 +1,52 @@
+/*
+ * ICM20602_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/ICM20602.h"
+
+#ifndef INC_GAUL_DRIVERS_TESTS_ICM20602_TESTS_H_
+#define INC_GAUL_DRIVERS_TESTS_ICM20602_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define ICM20602_TESTS_BYTE_NS    889  // 9 MHz (ICM20602_SPI_PRESCALER)
+#define ICM20602_TESTS_SELECT_NS  2000 // CS toggles and HAL call of a transaction
+
+// Simulated IMU
+typedef struct {
+	uint8_t present;
+	int32_t clock_error_ns;    // Sample period error (ns per 1 ms period, 1000 = +0.1%)
+	uint32_t phase_ns;         // Time of the first sample after the FIFO is enabled
+	uint8_t dma;               // 1: burst reads with DMA
+} ICM20602_TESTS_Device;
+
+// What the IMU saw
+typedef struct {
+	uint32_t transactions;     // CS low periods
+	uint32_t bytes;
+	uint32_t conflicts;        // Bytes exchanged during a DMA transfer
+	uint32_t overflows;        // Samples not written, FIFO full
+	uint64_t bus_ns;           // Time the SPI bus was used by the IMU
+	uint64_t cpu_ns;           // Part of bus_ns without DMA (CPU waiting)
+} ICM20602_TESTS_ModelStats;
+
+void ICM20602_TESTS_ModelReset(const ICM20602_TESTS_Device *device);
+void ICM20602_TESTS_ModelAdvance(uint32_t time_us);
+uint32_t ICM20602_TESTS_ModelTimeUs();
+uint32_t ICM20602_TESTS_ModelSampleTimeUs(uint32_t index);
+const ICM20602_TESTS_ModelStats *ICM20602_TESTS_ModelGetStats();
+int8_t ICM20602_TESTS_ModelInit();
+
+void ICM20602_TESTS_Model_LogSTLINK();
+void ICM20602_TESTS_Benchmark_LogSTLINK();
+void ICM20602_TESTS_Read_LogSTLINK(SPI_HandleTypeDef *hspi);
+
+void ICM20602_TESTS_LogStats();
+
+#endif /* INC_GAUL_DRIVERS_TESTS_ICM20602_TESTS_H_ */
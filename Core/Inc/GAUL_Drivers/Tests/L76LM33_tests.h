@@ -15,7 +15,9 @@
 #define DEBUG_Pin GPIO_PIN_5
 #define DEBUG_GPIO_Port GPIOB
 
-void L76LM33_TESTS_ReadSentence_LogUART(UART_HandleTypeDef *huart);
+void L76LM33_TESTS_Model_LogSTLINK();
+
+void L76LM33_TESTS_ReadSentence_LogUART();
 void L76LM33_TESTS_ReadSentence_LogSTLINK();
 void L76LM33_TESTS_Read_LogSTLINK();
 
@@ -19,6 +19,7 @@ void NMEA_TESTS_ValidateRMC_LogUART(UART_HandleTypeDef *huart);
 void NMEA_TESTS_ValidateRMC_LogSTLINK();
 
 void NMEA_TESTS_ParseRMC_LogSTLINK();
+void NMEA_TESTS_ParseGGA_LogSTLINK();
 
 void NMEA_TESTS_LogStructure(GPS_Data *gps_data);
 
@@ -0,0 +1,25 @@
+/*
+ * RFD900_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/RFD900.h"
+
+#ifndef INC_GAUL_DRIVERS_TESTS_RFD900_TESTS_H_
+#define INC_GAUL_DRIVERS_TESTS_RFD900_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define RFD900_TESTS_BAUD 9600 // huart1 baud rate
+
+void RFD900_TESTS_Model_LogSTLINK();
+void RFD900_TESTS_Send_LogSTLINK(UART_HandleTypeDef *huart);
+
+void RFD900_TESTS_LogStats();
+
+#endif /* INC_GAUL_DRIVERS_TESTS_RFD900_TESTS_H_ */
@@ -0,0 +1,63 @@
+/*
+ * SD_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/SD.h"
+
+#ifndef INC_GAUL_DRIVERS_TESTS_SD_TESTS_H_
+#define INC_GAUL_DRIVERS_TESTS_SD_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define SD_TESTS_MODEL_BLOCKS      256  // Blocks with a stored header (16 bytes)
+#define SD_TESTS_MODEL_FULL_BLOCKS 4    // Blocks stored entirely (index, read back tests)
+#define SD_TESTS_FAST_BYTE_NS      444  // 18 MHz (SD_FAST_PRESCALER)
+#define SD_TESTS_SLOW_BYTE_NS      28444 // 281 kHz (SD_SLOW_PRESCALER)
+
+// Simulated card
+typedef struct {
+	uint8_t present;
+	uint8_t sdhc;              // 1: SDHC (block addressing), 0: SDSC version 2 (byte addressing)
+	uint8_t init_polls;        // ACMD41 answered "idle" this number of times
+	uint32_t busy_us;          // Programming time of a block
+	uint32_t slow_busy_us;     // Programming time of every "slow_every" block (0: never)
+	uint16_t slow_every;
+} SD_TESTS_Card;
+
+// What the card saw
+typedef struct {
+	uint32_t init_clocks;      // Clocks with CS high before the first command
+	uint32_t commands;
+	uint32_t reads;            // CMD17
+	uint32_t pre_erase;        // Last ACMD23 argument
+	uint32_t blocks;           // Data blocks received
+	uint32_t log_blocks;       // Log blocks (SDLOG) received
+	uint32_t out_of_order;     // Blocks written outside the model
+	uint32_t bad_headers;      // Log blocks (SDLOG) with a wrong sequence
+	uint32_t payload_sum;      // Sum of the used bytes of the log blocks
+	uint32_t conflicts;        // Bytes exchanged during a DMA or while an other block is expected
+	uint32_t busy_us;          // Time the card was busy
+	uint64_t bus_ns;           // Time the SPI bus was used by the card
+} SD_TESTS_ModelStats;
+
+void SD_TESTS_ModelReset(const SD_TESTS_Card *card);
+void SD_TESTS_ModelPowerLoss();
+void SD_TESTS_ModelAdvance(uint32_t time_us);
+uint32_t SD_TESTS_ModelTimeUs();
+uint32_t SD_TESTS_ModelExchanges();
+uint8_t SD_TESTS_ModelSelected();
+const SD_TESTS_ModelStats *SD_TESTS_ModelGetStats();
+int8_t SD_TESTS_ModelInit();
+
+void SD_TESTS_Model_LogSTLINK();
+void SD_TESTS_Card_LogSTLINK(SPI_HandleTypeDef *hspi);
+
+void SD_TESTS_LogStats();
+
+#endif /* INC_GAUL_DRIVERS_TESTS_SD_TESTS_H_ */
@@ -0,0 +1,37 @@
+/*
+ * SPIBUS_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/SPIBUS.h"
+
+#ifndef INC_GAUL_DRIVERS_TESTS_SPIBUS_TESTS_H_
+#define INC_GAUL_DRIVERS_TESTS_SPIBUS_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define SPIBUS_TESTS_SPI_CLOCK_HZ 36000000 // APB1, SPI2 clock before the prescaler
+#define SPIBUS_TESTS_SELECT_NS    2000     // CS toggles and HAL call of a transaction
+#define SPIBUS_TESTS_DEVICES      3        // BMP280, ICM-20602, SD card
+#define SPIBUS_TESTS_MAX_ORDER    32       // Transactions and sessions recorded
+
+// What the devices saw
+typedef struct {
+	uint32_t selects[SPIBUS_TESTS_DEVICES];
+	uint32_t bytes[SPIBUS_TESTS_DEVICES];
+	uint32_t wrong_clock;      // Bytes exchanged with a device at another device clock
+	uint32_t conflicts;        // Two CS low, byte during a DMA, RX DMA without the channel
+	uint32_t free_clocks;      // Bytes clocked with every CS high
+	uint64_t bus_ns[SPIBUS_TESTS_DEVICES];
+} SPIBUS_TESTS_ModelStats;
+
+void SPIBUS_TESTS_Model_LogSTLINK();
+
+void SPIBUS_TESTS_LogStats();
+
+#endif /* INC_GAUL_DRIVERS_TESTS_SPIBUS_TESTS_H_ */
@@ -0,0 +1,20 @@
+/*
+ * UARTERR_tests.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/UARTERR.h"
+
+#ifndef INC_GAUL_DRIVERS_TESTS_UARTERR_TESTS_H_
+#define INC_GAUL_DRIVERS_TESTS_UARTERR_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+void UARTERR_TESTS_Inject_LogSTLINK();
+
+#endif /* INC_GAUL_DRIVERS_TESTS_UARTERR_TESTS_H_ */
@@ -0,0 +1,48 @@
+/*
+ * UARTERR.h
+ *
+ * Receive errors of USART1 and USART2 (overrun, framing, noise, parity) counted per port,
+ * and the reception restarted in the same interrupt when the HAL stopped it: without it,
+ * the driver never receives a byte again ("L76LM33_RxCallback" is not called anymore).
+ * "UARTERR_IRQHandler" replaces HAL_UART_IRQHandler in the USART interrupts (the HAL
+ * clears the error code when the driver starts the next byte, the error flags are read
+ * before), "UARTERR_ErrorCallback" counts the DMA errors (USART1_TX).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_DRIVERS_UARTERR_H_
+#define INC_GAUL_DRIVERS_UARTERR_H_
+
+// Ports
+#define UARTERR_PORT_GNSS  0 // USART2, L76LM33
+#define UARTERR_PORT_RADIO 1 // USART1, RFD900
+#define UARTERR_PORTS      2
+
+// Starts the reception of the driver again (HAL_UART_Receive_IT), from the interrupt.
+// 0: OK, -1: UART error, -2: the driver was not receiving.
+typedef int8_t (*UARTERR_Restart)(void);
+
+typedef struct {
+	uint32_t overruns[UARTERR_PORTS];  // ORE: byte lost
+	uint32_t framing[UARTERR_PORTS];   // FE: wrong baud rate, noise or break on the line
+	uint32_t noise[UARTERR_PORTS];     // NE
+	uint32_t parity[UARTERR_PORTS];    // PE (no parity configured)
+	uint32_t dma[UARTERR_PORTS];       // DMA transfer error (USART1_TX)
+	uint32_t restarts[UARTERR_PORTS];  // Reception stopped by the HAL and restarted
+	uint32_t restart_errors[UARTERR_PORTS]; // Restart refused, reception still stopped
+} UARTERR_Stats;
+
+void UARTERR_Init();
+int8_t UARTERR_Register(uint8_t port, UART_HandleTypeDef *huart, UARTERR_Restart restart);
+void UARTERR_IRQHandler(UART_HandleTypeDef *huart);
+void UARTERR_ErrorCallback(UART_HandleTypeDef *huart);
+
+uint32_t UARTERR_Errors(uint8_t port);
+void UARTERR_Clear(uint8_t port);
+const UARTERR_Stats *UARTERR_GetStats();
+
+#endif /* INC_GAUL_DRIVERS_UARTERR_H_ */
@@ -0,0 +1,93 @@
+/*
+ * APOGEE.h
+ *
+ * Apogee detection from the barometric altitude stream.
+ * Main functions are "APOGEE_Arm" to start detection at launch, and "APOGEE_Update"
+ * to feed every altitude sample. APOGEE_Update returns 1 once, when apogee is confirmed.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_FLIGHT_APOGEE_H_
+#define INC_GAUL_FLIGHT_APOGEE_H_
+
+// Number of samples between the two points of the velocity finite difference.
+// Longer window = less noise, but the velocity sign change is seen WINDOW/2 samples late.
+#define APOGEE_VELOCITY_WINDOW 8
+
+// After this many consecutive rejected samples, the outlier gate re-seeds on the new
+// altitude instead of rejecting forever (e.g. after a real step in the signal).
+#define APOGEE_MAX_REJECTED 5
+
+// Decision pipeline stages that can be enabled in APOGEE_Config.gates
+#define APOGEE_GATE_MEDIAN   0x01 // Median of 3 on altitude (removes single-sample spikes)
+#define APOGEE_GATE_OUTLIER  0x02 // Reject samples too far from the predicted altitude
+#define APOGEE_GATE_MIN_ALT  0x04 // Ignore apogee below a minimum altitude
+#define APOGEE_GATE_LOCKOUT  0x08 // Ignore apogee for some time after launch
+#define APOGEE_GATE_ALL      0x0F
+
+// Default configuration (see APOGEE_DefaultConfig)
+#define APOGEE_DEFAULT_DESCENDING_SAMPLES 5
+#define APOGEE_DEFAULT_MIN_ALT_M          100.0f
+#define APOGEE_DEFAULT_MAX_STEP_M         30.0f
+#define APOGEE_DEFAULT_LOCKOUT_MS         5000
+
+typedef struct {
+	uint8_t gates;              // Enabled pipeline stages (APOGEE_GATE_x)
+	uint8_t descending_samples; // Consecutive descending samples needed to confirm apogee
+	float min_alt_m;            // Highest altitude must be above this to detect apogee (AGL)
+	float max_step_m;           // Maximum distance between a sample and the predicted altitude
+	uint32_t lockout_ms;        // Detection disabled for this long after APOGEE_Arm()
+} APOGEE_Config;
+
+typedef struct {
+	uint32_t timestamp_ms;        // Timestamp of the sample that confirmed apogee
+	uint32_t apogee_timestamp_ms; // Timestamp of the highest filtered sample
+	float apogee_alt_m;           // Highest filtered altitude
+	uint16_t latency_samples;     // Samples between the highest sample and the detection
+} APOGEE_Event;
+
+typedef struct {
+	APOGEE_Config config;
+
+	uint8_t armed;              // 1: APOGEE_Arm() called, 0: not armed
+	uint8_t detected;           // 1: apogee event already produced
+	uint32_t arm_time_ms;
+
+	// Median filter
+	float median_buffer[3];
+	uint8_t median_count;
+
+	// Filtered altitude history for the velocity finite difference
+	float alt_history[APOGEE_VELOCITY_WINDOW + 1];
+	uint32_t time_history[APOGEE_VELOCITY_WINDOW + 1];
+	uint8_t history_count;
+	uint8_t history_index;      // Index of the next write
+
+	float alt_m;                // Last accepted filtered altitude
+	uint32_t time_ms;           // Timestamp of the last accepted sample
+	float velocity_mps;         // Vertical velocity estimate
+
+	float max_alt_m;
+	uint32_t max_alt_time_ms;
+	uint16_t samples_since_max;
+	uint8_t descending_count;
+
+	uint8_t rejected_in_row;
+	uint32_t rejected_samples;  // Total samples rejected by the outlier gate
+
+	APOGEE_Event event;
+} APOGEE_Detector;
+
+void APOGEE_DefaultConfig(APOGEE_Config *config);
+
+int8_t APOGEE_Init(APOGEE_Detector *detector, const APOGEE_Config *config);
+void APOGEE_Arm(APOGEE_Detector *detector, uint32_t launch_time_ms);
+
+int8_t APOGEE_Update(APOGEE_Detector *detector, float alt_m, uint32_t time_ms);
+void APOGEE_Propagate(APOGEE_Detector *detector, float velocity_mps, uint32_t time_ms);
+
+#endif /* INC_GAUL_FLIGHT_APOGEE_H_ */
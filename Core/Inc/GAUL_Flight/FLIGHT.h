@@ -0,0 +1,124 @@
+/*
+ * FLIGHT.h
+ *
+ * Flight state machine. Owns the flight phases (pad, boost, coast, apogee, drogue, main,
+ * landed) and the acquisition rates of each phase.
+ * Main functions are "FLIGHT_Update" to call on every barometer sample, and
+ * "FLIGHT_GetRates" to know how often each task must run in the current phase.
+ * "FLIGHT_UpdateAccel" gives every accelerometer sample to the launch detector.
+ * After both, flight->transition and flight->lock.transition tell the caller what to log.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/APOGEE.h"
+#include "GAUL_Flight/LAUNCH.h"
+#include "GAUL_Flight/MACHLOCK.h"
+#include "GAUL_Flight/THRESHOLD.h"
+
+#ifndef INC_GAUL_FLIGHT_FLIGHT_H_
+#define INC_GAUL_FLIGHT_FLIGHT_H_
+
+#define FLIGHT_PHASE_PAD     0
+#define FLIGHT_PHASE_BOOST   1
+#define FLIGHT_PHASE_COAST   2
+#define FLIGHT_PHASE_APOGEE  3 // Drogue deployment time, waiting for separation
+#define FLIGHT_PHASE_DROGUE  4
+#define FLIGHT_PHASE_MAIN    5
+#define FLIGHT_PHASE_LANDED  6
+#define FLIGHT_PHASE_COUNT   7
+
+#define FLIGHT_REASON_NONE      0
+#define FLIGHT_REASON_ACCEL     1 // Accelerometer threshold
+#define FLIGHT_REASON_ALTITUDE  2 // Barometric altitude threshold
+#define FLIGHT_REASON_TIMEOUT   3 // Phase lasted too long
+#define FLIGHT_REASON_APOGEE    4 // Apogee detector
+#define FLIGHT_REASON_DELAY     5 // Fixed delay elapsed
+#define FLIGHT_REASON_STABLE    6 // Altitude stable
+#define FLIGHT_REASON_COMBINED  7 // Low thrust confirmed by the barometric altitude
+
+// Default configuration (see FLIGHT_DefaultConfig)
+#define FLIGHT_DEFAULT_BURNOUT_ACCEL_MPS2 5.0f  // Specific force ~0 when coasting
+#define FLIGHT_DEFAULT_BURNOUT_SAMPLES    3
+#define FLIGHT_DEFAULT_MAX_BOOST_MS       6000  // Burnout without accelerometer
+#define FLIGHT_DEFAULT_DROGUE_DELAY_MS    1000
+#define FLIGHT_DEFAULT_MAIN_ALT_M         450.0f
+#define FLIGHT_DEFAULT_MAIN_SAMPLES       3
+#define FLIGHT_DEFAULT_LANDED_WINDOW_M    2.0f
+#define FLIGHT_DEFAULT_LANDED_TIME_MS     5000
+
+typedef struct {
+	uint16_t baro_period_ms;      // Barometer sampling (and FLIGHT_Update)
+	uint16_t gnss_period_ms;      // GNSS read and parse
+	uint16_t telemetry_period_ms; // Telemetry packet to the radio
+	uint16_t log_period_ms;       // Flight log record
+} FLIGHT_Rates;
+
+typedef struct {
+	float burnout_accel_mps2;     // Coast when specific force is below this
+	uint8_t burnout_samples;
+	uint32_t max_boost_ms;        // Coast after this time in boost in any case
+	uint32_t drogue_delay_ms;     // Time in apogee phase before drogue phase
+	float main_alt_m;             // Main deploy altitude AGL
+	uint8_t main_samples;
+	float landed_window_m;        // Landed when altitude stays in +/- window...
+	uint32_t landed_time_ms;      // ...for this long
+
+	FLIGHT_Rates rates[FLIGHT_PHASE_COUNT];
+} FLIGHT_Config;
+
+typedef struct {
+	uint32_t time_ms;             // Barometer sample timestamp (HAL tick)
+	float alt_m;                  // Barometric altitude AGL
+	uint32_t press_Pa_Q8;         // Compensated pressure (BMP280 press_Pa_Q8)
+	float accel_mps2;             // Vertical specific force (1g on the pad)
+	uint8_t has_accel;            // 1 if accel_mps2 is valid
+} FLIGHT_Measurement;
+
+typedef struct {
+	uint32_t time_ms;             // Time of the transition (launch is back-dated)
+	uint8_t from;                 // FLIGHT_PHASE_x
+	uint8_t to;                   // FLIGHT_PHASE_x
+	uint8_t reason;               // FLIGHT_REASON_x
+	float alt_m;                  // Altitude when the transition was decided
+} FLIGHT_Event;
+
+typedef struct {
+	FLIGHT_Config config;
+
+	uint8_t phase;                // FLIGHT_PHASE_x
+	uint32_t phase_time_ms;       // Time when the current phase was entered
+	uint32_t launch_time_ms;
+	float alt_m;                  // Last barometric altitude
+	uint8_t baro_trusted;         // 0: last sample ignored by Mach lock
+
+	LAUNCH launch;
+	uint8_t accel_stream;         // 1: launch detector fed by FLIGHT_UpdateAccel
+	APOGEE_Detector apogee;
+	MACHLOCK lock;
+	THRESHOLD_Engine thresholds;
+	int8_t main_threshold;        // Id of the main deploy threshold
+
+	uint8_t burnout_count;
+	float landed_ref_alt_m;
+	uint32_t landed_ref_time_ms;
+
+	uint8_t transition;           // 1: last update changed the phase, see event
+	FLIGHT_Event event;           // Last transition
+	FLIGHT_Event events[FLIGHT_PHASE_COUNT]; // All transitions of the flight
+	uint8_t event_count;
+} FLIGHT;
+
+void FLIGHT_DefaultConfig(FLIGHT_Config *config);
+
+int8_t FLIGHT_Init(FLIGHT *flight, const FLIGHT_Config *config, float press_ref_Pa);
+int8_t FLIGHT_Update(FLIGHT *flight, const FLIGHT_Measurement *measurement);
+int8_t FLIGHT_UpdateAccel(FLIGHT *flight, int32_t accel_mms2, uint32_t time_us, uint32_t time_ms);
+
+const FLIGHT_Rates *FLIGHT_GetRates(const FLIGHT *flight);
+const char *FLIGHT_PhaseName(uint8_t phase);
+
+#endif /* INC_GAUL_FLIGHT_FLIGHT_H_ */
@@ -0,0 +1,106 @@
+/*
+ * FUSION.h
+ *
+ * Vertical state estimator (altitude, velocity, accelerometer bias) fusing the
+ * accelerometer and the barometer, in fixed point.
+ * "FUSION_Predict" integrates every accelerometer sample (1 kHz), "FUSION_UpdateBaro"
+ * corrects the state with a barometric altitude at its own rate. Both take the time of the
+ * measurement: late barometer samples are applied at their time, early ones wait for the
+ * accelerometer to reach them.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_FLIGHT_FUSION_H_
+#define INC_GAUL_FLIGHT_FUSION_H_
+
+#define FUSION_GRAVITY_MMS2 9807
+
+#define FUSION_HISTORY_SIZE   32      // Altitude history for late barometer samples (32 ms at 1 kHz)
+#define FUSION_BARO_QUEUE     4       // Barometer samples ahead of the accelerometer
+#define FUSION_IMU_TIMEOUT_US 50000   // Barometer this far ahead: continue without accelerometer
+#define FUSION_MAX_STEP_US    500000  // Longest integration step (longer gaps are split)
+#define FUSION_MAX_PERIOD_US  200000  // Longest barometer period used for the gains
+#define FUSION_MAX_REJECTED   5       // Rejected samples in a row before the gate opens again
+
+// Default configuration (see FUSION_DefaultConfig)
+#define FUSION_DEFAULT_OMEGA_RAD_S        0.7f
+#define FUSION_DEFAULT_LOCKED_OMEGA_RAD_S 0.1f
+#define FUSION_DEFAULT_GATE_M             15.0f
+
+typedef struct {
+	float omega_rad_s;        // Barometer/accelerometer crossover, higher = follow the barometer more
+	float locked_omega_rad_s; // Crossover while the barometer is untrusted (Mach lock)
+	float gate_m;             // Barometer samples further than this from the estimate are rejected
+} FUSION_Config;
+
+typedef struct {
+	uint32_t time_us;
+	int32_t alt_mm;
+	int32_t vel_mms;
+	int32_t accel_mms2;       // Vertical acceleration (accelerometer - gravity - bias)
+	int32_t bias_mms2;        // Accelerometer bias estimate
+} FUSION_State;
+
+typedef struct {
+	uint32_t predictions;     // Accelerometer samples integrated
+	uint32_t imu_late;        // Accelerometer samples older than the state, ignored
+	uint32_t baro_updates;    // Barometer samples applied
+	uint32_t baro_retro;      // Barometer samples applied in the past (from the history)
+	uint32_t baro_queued;     // Barometer samples ahead of the accelerometer
+	uint32_t baro_late;       // Barometer samples older than the history, ignored
+	uint32_t baro_rejected;   // Barometer samples rejected by the gate
+	uint32_t baro_only;       // Steps without accelerometer (queue full or accelerometer timeout)
+} FUSION_Stats;
+
+typedef struct {
+	uint32_t time_us;
+	int32_t alt_q16;          // Altitude in Q16.16 m
+} FUSION_History;
+
+typedef struct {
+	uint32_t time_us;
+	int32_t alt_q16;
+	uint8_t trusted;
+} FUSION_Baro;
+
+typedef struct {
+	FUSION_Config config;
+	int32_t omega_q16;        // Config in Q16.16
+	int32_t locked_omega_q16;
+	int32_t gate_q16;
+
+	uint8_t started;          // 1: time_us is valid
+	uint8_t initialized;      // 1: state seeded by a barometer sample
+	uint32_t time_us;         // Time of the state
+	int64_t alt_q32;          // Altitude in Q32.32 m
+	int64_t vel_q32;          // Velocity in Q32.32 m/s
+	int32_t bias_q16;         // Accelerometer bias in Q16.16 m/s^2
+	int32_t accel_q16;        // Last vertical acceleration in Q16.16 m/s^2
+
+	uint32_t baro_time_us;    // Most recent barometer sample applied
+	uint32_t baro_period_us;  // Time covered by the last barometer sample (gains)
+	uint8_t rejected_in_row;
+
+	FUSION_History history[FUSION_HISTORY_SIZE];
+	uint8_t history_index;    // Index of the next write
+	uint8_t history_count;
+
+	FUSION_Baro queue[FUSION_BARO_QUEUE]; // Sorted by time
+	uint8_t queue_count;
+
+	FUSION_Stats stats;
+} FUSION;
+
+void FUSION_DefaultConfig(FUSION_Config *config);
+int8_t FUSION_Init(FUSION *fusion, const FUSION_Config *config);
+
+int8_t FUSION_Predict(FUSION *fusion, int32_t accel_mms2, uint32_t time_us);
+int8_t FUSION_UpdateBaro(FUSION *fusion, int32_t alt_mm, uint32_t time_us, uint8_t trusted);
+
+void FUSION_GetState(const FUSION *fusion, FUSION_State *state);
+
+#endif /* INC_GAUL_FLIGHT_FUSION_H_ */
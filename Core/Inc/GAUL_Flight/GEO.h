@@ -0,0 +1,42 @@
+/*
+ * GEO.h
+ *
+ * Fixed-point geodesy around the pad (WGS84): latitude and longitude (1e-7 degree) to
+ * East-North offsets in cm and back, range and bearing from the pad, sine and cosine.
+ * "GEO_SetPad" computes the linearisation once per pad fix, every conversion after that is
+ * a few 64 bit multiplications, range and bearing are CORDIC (shifts and additions).
+ *
+ * Error against the ellipsoid (Vincenty), pad from the equator to 70 degrees, see GEO_tests.c:
+ *   East-North position, range  < 0.02 m up to 5 km, < 0.1 m up to 20 km (0.04 m below 55 degrees)
+ *   Bearing                     < 0.0054 degree beyond 100 m (0.005: rounding to 0.01 degree)
+ *   Sine, cosine                < 2e-8
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_FLIGHT_GEO_H_
+#define INC_GAUL_FLIGHT_GEO_H_
+
+#define GEO_MAX_LATITUDE_E7   850000000 // Pad closer to a pole: longitude scale too small
+#define GEO_CORDIC_ITERATIONS 30
+
+typedef struct {
+	int32_t latitude_e7;      // Pad, origin of the frame
+	int32_t longitude_e7;
+	int32_t north_q30;        // cm per 1e-7 degree of latitude at the pad (meridian radius), Q30
+	int32_t north_slope;      // Change of north_q30 per 1e-7 degree, at the middle latitude, Q30 / 2^24
+	int32_t east_q30;         // cm per 1e-7 degree of longitude at the pad (parallel radius), Q30
+	int32_t east_slope;
+	int32_t convergence;      // Meridian convergence / 2 (rad) per 1e-7 degree of longitude, Q54
+} GEO;
+
+int8_t GEO_SetPad(GEO *geo, int32_t latitude_e7, int32_t longitude_e7);
+int8_t GEO_ToLocal(const GEO *geo, int32_t latitude_e7, int32_t longitude_e7, int32_t *east_cm, int32_t *north_cm);
+int8_t GEO_ToGlobal(const GEO *geo, int32_t east_cm, int32_t north_cm, int32_t *latitude_e7, int32_t *longitude_e7);
+void GEO_RangeBearing(int32_t east_cm, int32_t north_cm, uint32_t *range_cm, uint16_t *bearing_cdeg);
+void GEO_SinCos(int32_t angle_cdeg, int32_t *sin_q30, int32_t *cos_q30);
+
+#endif /* INC_GAUL_FLIGHT_GEO_H_ */
@@ -0,0 +1,122 @@
+/*
+ * LAUNCH.h
+ *
+ * Launch (lift-off) detection from the accelerometer and the barometer.
+ * "LAUNCH_UpdateAccel" is called on every accelerometer sample (1 kHz) and
+ * "LAUNCH_UpdateBaro" on every barometer sample. Both return 1 once, when launch is
+ * detected. The lift-off time (launch->launch_time_us) is back-dated to the start of
+ * the thrust, before the detection time. The microsecond time base wraps (71.6 min), so
+ * callers on another time base use launch->backdate_us, relative to the detection sample.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_FLIGHT_LAUNCH_H_
+#define INC_GAUL_FLIGHT_LAUNCH_H_
+
+#define LAUNCH_GRAVITY_MMS2 9807
+
+#define LAUNCH_REASON_NONE     0
+#define LAUNCH_REASON_ACCEL    1 // Sustained acceleration
+#define LAUNCH_REASON_BARO     2 // Altitude gain, still climbing (no accelerometer)
+#define LAUNCH_REASON_COMBINED 3 // Thrust too low for the accelerometer alone, confirmed by the altitude
+
+#define LAUNCH_REF_SHIFT   8     // Pad reference altitude filter, 1/256 of each sample
+#define LAUNCH_MAX_GAP_US  20000 // Longest accelerometer gap integrated
+#define LAUNCH_ACCEL_TIMEOUT_US 50000 // Accelerometer run this old is ignored by the barometer
+#define LAUNCH_MAX_BACKDATE_US 3000000 // Barometer lift-off estimate at most this early
+#define LAUNCH_REBASE_US 10000000 // Out of the pad band this long: new pad reference
+
+// Default configuration (see LAUNCH_DefaultConfig)
+#define LAUNCH_DEFAULT_ACCEL_MPS2      30.0f // ~3g specific force
+#define LAUNCH_DEFAULT_ACCEL_MIN_MS    20    // Shocks (pad handling) are shorter
+#define LAUNCH_DEFAULT_VELOCITY_MPS    1.5f  // Velocity gained above the threshold
+#define LAUNCH_DEFAULT_LIFTOFF_MPS2    12.75f // ~1.3g, start of the thrust (back-dating)
+#define LAUNCH_DEFAULT_DROPOUT_MS      3     // Samples below a threshold tolerated in a run
+#define LAUNCH_DEFAULT_ALT_GAIN_M      20.0f
+#define LAUNCH_DEFAULT_HOLD_MS         300
+#define LAUNCH_DEFAULT_RISE_M          5.0f
+#define LAUNCH_DEFAULT_PAD_BAND_M      2.0f
+#define LAUNCH_DEFAULT_COMBINED_MS     100
+#define LAUNCH_DEFAULT_COMBINED_ALT_M  3.0f
+
+typedef struct {
+	float accel_mps2;         // Accelerometer: specific force above this...
+	uint16_t accel_min_ms;    // ...for at least this long...
+	float velocity_mps;       // ...and velocity gained above this
+	float liftoff_mps2;       // Lift-off is the start of the run above this specific force
+	uint8_t dropout_ms;       // Gap below a threshold that does not end a run
+	float alt_gain_m;         // Barometer: altitude above the pad reference...
+	uint16_t hold_ms;         // ...for this long...
+	float rise_m;             // ...while climbing this much, not slower in the second half (gust guard)
+	float pad_band_m;         // Altitude within this of the pad reference: still on the pad
+	uint16_t combined_ms;     // Combined: specific force above liftoff for this long...
+	float combined_alt_m;     // ...and altitude above the pad reference by this much
+} LAUNCH_Config;
+
+typedef struct {
+	uint32_t accel_candidates; // Runs above the acceleration threshold
+	uint32_t accel_rejected;   // Runs ended before launch (shocks, vibrations, handling)
+	uint32_t baro_candidates;  // Altitude gains above the threshold
+	uint32_t baro_rejected;    // Gains that did not hold or stopped climbing (gusts)
+} LAUNCH_Stats;
+
+typedef struct {
+	LAUNCH_Config config;
+	int32_t accel_mms2;        // Config in integer units
+	uint32_t accel_min_us;
+	int32_t velocity_ums;      // um/s
+	int32_t liftoff_mms2;
+	uint32_t dropout_us;
+	int32_t alt_gain_mm;
+	uint32_t hold_us;
+	int32_t rise_mm;
+	int32_t pad_band_mm;
+	uint32_t combined_us;
+	int32_t combined_alt_mm;
+
+	uint8_t launched;          // 1: launch detected
+	uint8_t reason;            // LAUNCH_REASON_x
+	uint32_t launch_time_us;   // Back-dated lift-off
+	uint32_t detect_time_us;   // Time of the sample that confirmed launch
+	uint32_t backdate_us;      // detect_time_us - launch_time_us
+
+	// Accelerometer
+	uint8_t accel_started;
+	uint32_t accel_time_us;    // Last sample
+	uint8_t rise;              // 1: run above liftoff_mps2
+	uint32_t rise_start_us;
+	uint32_t rise_last_us;     // Last sample above liftoff_mps2
+	uint8_t candidate;         // 1: run above accel_mps2
+	uint32_t candidate_start_us;
+	uint32_t candidate_last_us;
+	int32_t velocity;          // Velocity gained since the start of the candidate run (um/s)
+
+	// Barometer
+	uint8_t baro_started;
+	uint32_t baro_time_us;     // Last sample
+	int32_t ref_q8;            // Pad reference altitude (mm, Q24.8)
+	int32_t gain_mm;           // Last altitude above the pad reference
+	uint32_t exit_time_us;     // First sample out of the pad band
+	int32_t exit_gain_mm;
+	uint8_t on_pad;            // 1: last sample in the pad band
+	uint8_t climb;             // 1: gain above alt_gain_m
+	uint32_t climb_start_us;
+	int32_t climb_start_mm;
+	int32_t climb_mid_mm;
+	uint8_t climb_has_mid;
+
+	LAUNCH_Stats stats;
+} LAUNCH;
+
+void LAUNCH_DefaultConfig(LAUNCH_Config *config);
+int8_t LAUNCH_Init(LAUNCH *launch, const LAUNCH_Config *config);
+
+int8_t LAUNCH_UpdateAccel(LAUNCH *launch, int32_t accel_mms2, uint32_t time_us);
+int8_t LAUNCH_UpdateBaro(LAUNCH *launch, int32_t alt_mm, uint32_t time_us);
+uint8_t LAUNCH_IsIdle(const LAUNCH *launch);
+
+#endif /* INC_GAUL_FLIGHT_LAUNCH_H_ */
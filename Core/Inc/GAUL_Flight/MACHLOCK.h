@@ -0,0 +1,76 @@
+/*
+ * MACHLOCK.h
+ *
+ * Mach lock marks barometer samples as untrusted while the rocket is near Mach 1,
+ * because the shock waves around the static port make the pressure (and altitude) jump.
+ * Main functions are "MACHLOCK_Launch" to lock at lift-off, and "MACHLOCK_Update"
+ * to call on every barometer sample to know if the sample can be trusted.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_FLIGHT_MACHLOCK_H_
+#define INC_GAUL_FLIGHT_MACHLOCK_H_
+
+#define MACHLOCK_GRAVITY 9.81f
+
+#define MACHLOCK_STATE_IDLE      0 // Waiting for launch, barometer trusted
+#define MACHLOCK_STATE_LOCKED    1 // Barometer untrusted
+#define MACHLOCK_STATE_UNLOCKED  2 // Barometer trusted
+
+#define MACHLOCK_TRANSITION_NONE  0
+#define MACHLOCK_TRANSITION_ENTER 1
+#define MACHLOCK_TRANSITION_EXIT  2
+
+#define MACHLOCK_REASON_NONE      0
+#define MACHLOCK_REASON_LAUNCH    1 // Enter: MACHLOCK_Launch() called
+#define MACHLOCK_REASON_VELOCITY  2 // Enter: trusted velocity above enter threshold
+                                    // Exit: propagated velocity below exit threshold
+#define MACHLOCK_REASON_TIMER     3 // Exit: min_lock_ms elapsed, no accelerometer for accel_timeout_ms
+#define MACHLOCK_REASON_TIMEOUT   4 // Exit: max_lock_ms elapsed
+
+// Default configuration (see MACHLOCK_DefaultConfig)
+#define MACHLOCK_DEFAULT_MIN_LOCK_MS        4000
+#define MACHLOCK_DEFAULT_MAX_LOCK_MS        20000
+#define MACHLOCK_DEFAULT_ENTER_VELOCITY_MPS 270.0f // ~Mach 0.8
+#define MACHLOCK_DEFAULT_EXIT_VELOCITY_MPS  240.0f // ~Mach 0.7
+#define MACHLOCK_DEFAULT_ACCEL_TIMEOUT_MS   500
+
+typedef struct {
+	uint32_t min_lock_ms;     // Lock at least this long after entering
+	uint32_t max_lock_ms;     // Never lock longer than this (unlock before apogee)
+	float enter_velocity_mps; // Lock when trusted velocity goes above this
+	float exit_velocity_mps;  // Unlock when propagated velocity goes below this
+	uint32_t accel_timeout_ms; // Accelerometer missing this long: timer lock
+} MACHLOCK_Config;
+
+typedef struct {
+	MACHLOCK_Config config;
+
+	uint8_t state;            // MACHLOCK_STATE_x
+	uint32_t time_ms;         // Time of last update
+
+	float velocity_mps;       // Velocity propagated with the accelerometer while locked
+	uint8_t has_accel;        // 1: accel_mps2 received since lock entry
+	float accel_mps2;         // Last accelerometer sample, used while it is missing
+	uint32_t accel_time_ms;
+
+	uint8_t transition;       // Transition produced by the last update (MACHLOCK_TRANSITION_x)
+	uint8_t reason;           // Reason of the last transition (MACHLOCK_REASON_x)
+	uint32_t enter_time_ms;
+	uint32_t exit_time_ms;
+
+	uint32_t untrusted_samples; // Samples marked untrusted since launch
+} MACHLOCK;
+
+void MACHLOCK_DefaultConfig(MACHLOCK_Config *config);
+
+int8_t MACHLOCK_Init(MACHLOCK *lock, const MACHLOCK_Config *config);
+void MACHLOCK_Launch(MACHLOCK *lock, uint32_t launch_time_ms);
+
+int8_t MACHLOCK_Update(MACHLOCK *lock, uint32_t time_ms, float velocity_mps, float accel_mps2, uint8_t has_accel);
+
+#endif /* INC_GAUL_FLIGHT_MACHLOCK_H_ */
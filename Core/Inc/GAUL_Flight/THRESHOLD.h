@@ -0,0 +1,54 @@
+/*
+ * THRESHOLD.h
+ *
+ * Altitude event thresholds evaluated in the pressure domain.
+ * Thresholds are added in meters AGL with "THRESHOLD_Add", converted to pressure once by
+ * "THRESHOLD_Arm" using the ground reference pressure, then "THRESHOLD_Update" compares
+ * the raw compensated pressure (BMP280 press_Pa_Q8) on every sample, without pow().
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_FLIGHT_THRESHOLD_H_
+#define INC_GAUL_FLIGHT_THRESHOLD_H_
+
+#define THRESHOLD_MAX 8 // Triggered thresholds are returned as a uint8_t bit mask
+
+#define THRESHOLD_ABOVE 0 // Event when altitude > threshold
+#define THRESHOLD_BELOW 1 // Event when altitude < threshold
+
+// Pressure search range for the conversion (Q24.8), BMP280 range is 300 to 1100 hPa
+#define THRESHOLD_PRESS_MIN_Q8 ((uint32_t)1 << 8)
+#define THRESHOLD_PRESS_MAX_Q8 ((uint32_t)200000 << 8)
+
+typedef struct {
+	float alt_m;          // Altitude threshold AGL
+	uint8_t direction;    // THRESHOLD_ABOVE or THRESHOLD_BELOW
+	uint8_t samples;      // Consecutive samples needed to trigger
+	uint8_t enabled;      // 0: not evaluated (e.g. main deploy before apogee)
+	uint8_t count;        // Current number of consecutive samples
+	uint8_t triggered;    // 1: event already produced
+	uint32_t press_Pa_Q8; // Pressure bound computed by THRESHOLD_Arm (Q24.8)
+} THRESHOLD;
+
+typedef struct {
+	THRESHOLD thresholds[THRESHOLD_MAX];
+	uint8_t size;         // Number of thresholds added
+	uint8_t armed;        // 1: pressure bounds computed
+	float press_ref_Pa;   // Ground reference used for the conversion
+} THRESHOLD_Engine;
+
+void THRESHOLD_Init(THRESHOLD_Engine *engine);
+int8_t THRESHOLD_Add(THRESHOLD_Engine *engine, float alt_m, uint8_t direction, uint8_t samples);
+int8_t THRESHOLD_Arm(THRESHOLD_Engine *engine, float press_ref_Pa);
+
+void THRESHOLD_SetEnabled(THRESHOLD_Engine *engine, int8_t id, uint8_t enabled);
+
+uint8_t THRESHOLD_Update(THRESHOLD_Engine *engine, uint32_t press_Pa_Q8);
+uint8_t THRESHOLD_IsTriggered(THRESHOLD_Engine *engine, int8_t id);
+uint8_t THRESHOLD_Compare(const THRESHOLD *threshold, uint32_t press_Pa_Q8);
+
+#endif /* INC_GAUL_FLIGHT_THRESHOLD_H_ */
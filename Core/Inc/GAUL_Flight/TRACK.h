@@ -0,0 +1,133 @@
+/*
+ * TRACK.h
+ *
+ * GNSS position between the fixes (dead reckoning), in a local East-North-Up frame anchored
+ * at the pad (GEO), in integers. "TRACK_Update" is given every fix (position, speed and course
+ * over ground, altitude), "TRACK_Predict" the position at any HAL tick, with the time since
+ * the fix used (extrapolation age). A new fix is blended in over TRACK_DEFAULT_BLEND_MS so
+ * the estimate does not jump at each fix.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/GEO.h"
+
+#ifndef INC_GAUL_FLIGHT_TRACK_H_
+#define INC_GAUL_FLIGHT_TRACK_H_
+
+#define TRACK_HISTORY          4     // Last fixes kept for the acceleration and the vertical velocity (power of two)
+#define TRACK_MIN_SPAN_MS      150   // History shorter than this: no acceleration, no vertical velocity
+
+// Default configuration (see TRACK_DefaultConfig)
+#define TRACK_DEFAULT_BLEND_MS     300   // Difference between the estimate and a new fix removed over this time
+#define TRACK_DEFAULT_SNAP_M       50.0f // Larger difference: the estimate jumps to the fix (reacquisition)
+#define TRACK_DEFAULT_ACCEL_MS     1000  // Acceleration extrapolated for this long, then constant velocity
+#define TRACK_DEFAULT_MAX_AGE_MS   2000  // Older fix: not extrapolated further
+
+typedef struct {
+	uint16_t blend_ms;        // 0: no blending, the estimate jumps at each fix
+	float snap_m;
+	uint16_t accel_ms;        // 0: constant velocity
+	uint16_t max_age_ms;
+} TRACK_Config;
+
+typedef struct {
+	uint32_t time_ms;         // HAL tick of the fix (L76LM33 fix_ms)
+	int32_t latitude_e7;      // 1e-7 degrees
+	int32_t longitude_e7;
+	int32_t speed_cms;        // Speed over ground
+	int32_t course_cdeg;      // Course over ground, 0.01 degree from true north
+	uint8_t altitude;         // 1: altitude_cm valid
+	uint32_t altitude_ms;     // HAL tick of the altitude (GGA, may be an older fix)
+	int32_t altitude_cm;      // Above mean sea level
+} TRACK_Fix;
+
+typedef struct {
+	int32_t east_cm;          // From the pad
+	int32_t north_cm;
+	int32_t up_cm;            // 0 without altitude
+	int32_t ve_cms;
+	int32_t vn_cms;
+	int32_t vu_cms;
+	int32_t latitude_e7;      // Same position, for the log and the telemetry
+	int32_t longitude_e7;
+	uint32_t range_cm;        // Horizontal distance from the pad
+	uint16_t bearing_cdeg;    // From the pad, 0.01 degree from true north
+	int32_t altitude_cm;      // Above mean sea level, 0 without altitude
+	uint8_t altitude;         // 1: up_cm and altitude_cm valid
+	uint32_t age_ms;          // Time since the fix (extrapolation)
+	uint32_t altitude_age_ms;
+} TRACK_Estimate;
+
+typedef struct {
+	uint32_t fixes;           // Horizontal fixes applied
+	uint32_t altitudes;       // Altitudes applied
+	uint32_t late;            // Fixes not newer than the last one, ignored
+	uint32_t snaps;           // Fixes too far from the estimate, not blended
+	int32_t last_correction_cm; // Estimate - fix at the last fix (prediction error)
+	int32_t max_correction_cm;
+} TRACK_Stats;
+
+typedef struct {
+	uint32_t time_ms;
+	int32_t ve_cms;
+	int32_t vn_cms;
+} TRACK_Velocity;
+
+typedef struct {
+	uint32_t time_ms;
+	int32_t up_cm;
+} TRACK_Altitude;
+
+typedef struct {
+	TRACK_Config config;
+	int32_t snap_cm;          // Config in integer units
+
+	// Pad, origin of the frame
+	uint8_t padded;           // 1: pad set
+	uint8_t pad_altitude;     // 1: pad_altitude_cm set
+	GEO geo;                  // Pad latitude and longitude, linearisation
+	int32_t pad_altitude_cm;
+
+	// Horizontal: last fix, velocity from its speed and course, acceleration from the history
+	uint8_t started;
+	uint32_t time_ms;
+	int32_t east_cm;
+	int32_t north_cm;
+	int32_t ve_cms;
+	int32_t vn_cms;
+	int32_t ae_cms2;
+	int32_t an_cms2;
+	uint32_t blend_ms;        // Start of the blend
+	int32_t blend_east_cm;    // Previous estimate - new fix model, at blend_ms
+	int32_t blend_north_cm;
+
+	// Vertical: last altitude, velocity from the history (no vertical speed in the NMEA)
+	uint8_t altitude_started;
+	uint32_t altitude_ms;
+	int32_t up_cm;
+	int32_t vu_cms;
+	uint32_t blend_up_ms;
+	int32_t blend_up_cm;
+
+	TRACK_Velocity velocities[TRACK_HISTORY];
+	uint8_t velocity_index;   // Index of the next write
+	uint8_t velocity_count;
+	TRACK_Altitude altitudes[TRACK_HISTORY];
+	uint8_t altitude_index;
+	uint8_t altitude_count;
+
+	TRACK_Stats stats;
+} TRACK;
+
+void TRACK_DefaultConfig(TRACK_Config *config);
+int8_t TRACK_Init(TRACK *track, const TRACK_Config *config);
+
+int8_t TRACK_SetPad(TRACK *track, const TRACK_Fix *fix);
+int8_t TRACK_Update(TRACK *track, const TRACK_Fix *fix, uint32_t now_ms);
+int8_t TRACK_Predict(const TRACK *track, uint32_t now_ms, TRACK_Estimate *estimate);
+
+#endif /* INC_GAUL_FLIGHT_TRACK_H_ */
@@ -0,0 +1,29 @@
+/*
+ * APOGEE_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/APOGEE.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_APOGEE_TESTS_H_
+#define INC_GAUL_FLIGHT_TESTS_APOGEE_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define APOGEE_TESTS_FLIGHTS 200
+#define APOGEE_TESTS_HISTOGRAM_SIZE 16 // Last bucket counts latencies >= 15 samples
+#define APOGEE_TESTS_MAX_LATENCY 30    // 0.6 s at 50 Hz
+#define APOGEE_TESTS_FALSE_VELOCITY 5.0f // Detection above this true velocity is a false apogee
+
+#define APOGEE_TESTS_FALSE  -1000
+#define APOGEE_TESTS_MISSED -1001
+
+void APOGEE_TESTS_Replay_LogSTLINK();
+int32_t APOGEE_TESTS_ReplayRecording(const float alt_m[], const uint32_t time_ms[], uint16_t count, uint32_t apogee_time_ms, uint32_t period_ms, const APOGEE_Config *config);
+
+#endif /* INC_GAUL_FLIGHT_TESTS_APOGEE_TESTS_H_ */
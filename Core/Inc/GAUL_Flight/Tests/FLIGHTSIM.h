@@ -0,0 +1,75 @@
+/*
+ * FLIGHTSIM.h
+ *
+ * Synthetic flight generator used by the flight module tests. Produces a pad wait,
+ * a constant acceleration boost, a ballistic coast, a drogue descent and a main descent,
+ * with barometer noise and transonic pressure spikes.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_FLIGHTSIM_H_
+#define INC_GAUL_FLIGHT_TESTS_FLIGHTSIM_H_
+
+#define FLIGHTSIM_GRAVITY         9.81f
+#define FLIGHTSIM_SPEED_OF_SOUND  340.0f
+#define FLIGHTSIM_DROGUE_MPS      -25.0f
+#define FLIGHTSIM_MAIN_MPS        -6.0f
+#define FLIGHTSIM_MAIN_ALT_M      450.0f
+#define FLIGHTSIM_PRESS_REF_PA    101325.0f
+
+#define FLIGHTSIM_PHASE_PAD     0
+#define FLIGHTSIM_PHASE_BOOST   1
+#define FLIGHTSIM_PHASE_COAST   2
+#define FLIGHTSIM_PHASE_DROGUE  3
+#define FLIGHTSIM_PHASE_MAIN    4
+#define FLIGHTSIM_PHASE_LANDED  5
+
+typedef struct {
+	uint32_t sample_period_ms;
+	uint32_t pad_time_ms;     // Time on the pad before launch
+	float boost_accel_mps2;   // Net acceleration during boost
+	uint32_t boost_time_ms;
+	float noise_m;            // Barometric altitude noise amplitude
+	float accel_noise_mps2;   // Accelerometer noise amplitude
+	float spike_m;            // Transonic spike amplitude, 0 to disable
+	uint8_t spike_percent;    // Probability of a spike per sample while above Mach 0.8
+	float disturbance_m;      // Altitude reads up to this much high between Mach 0.9 and 1.1, 0 to disable
+	uint32_t seed;            // Pseudo random seed, same seed = same flight
+} FLIGHTSIM_Profile;
+
+typedef struct {
+	uint32_t time_ms;
+	uint8_t phase;            // FLIGHTSIM_PHASE_x
+	float true_alt_m;
+	float true_vel_mps;
+	float baro_alt_m;         // Altitude seen by the barometer (noise + spikes)
+	float press_Pa;           // Pressure matching baro_alt_m
+	float accel_mps2;         // Vertical acceleration seen by the accelerometer (1g on pad)
+	uint8_t spike;            // 1: baro_alt_m contains a transonic spike
+} FLIGHTSIM_Sample;
+
+typedef struct {
+	FLIGHTSIM_Profile profile;
+	uint32_t rng;
+	uint32_t time_ms;
+	uint8_t phase;
+	float alt_m;
+	float vel_mps;
+	float max_alt_m;
+	uint32_t apogee_time_ms;  // Time of the true apogee (0 before apogee)
+	uint32_t launch_time_ms;
+} FLIGHTSIM;
+
+void FLIGHTSIM_DefaultProfile(FLIGHTSIM_Profile *profile, uint32_t seed);
+void FLIGHTSIM_Init(FLIGHTSIM *sim, const FLIGHTSIM_Profile *profile);
+int8_t FLIGHTSIM_Step(FLIGHTSIM *sim, FLIGHTSIM_Sample *sample);
+
+uint32_t FLIGHTSIM_Random(FLIGHTSIM *sim);
+float FLIGHTSIM_Noise(FLIGHTSIM *sim, float amplitude);
+float FLIGHTSIM_AltitudeToPressure(float alt_m, float pressure_ref);
+
+#endif /* INC_GAUL_FLIGHT_TESTS_FLIGHTSIM_H_ */
@@ -0,0 +1,34 @@
+/*
+ * FLIGHT_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/FLIGHT.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_FLIGHT_TESTS_H_
+#define INC_GAUL_FLIGHT_TESTS_FLIGHT_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define FLIGHT_TESTS_FLIGHTS 100
+#define FLIGHT_TESTS_SIM_PERIOD_MS 10    // Simulation runs at the fastest barometer rate
+#define FLIGHT_TESTS_GROUND_MS 20000     // Samples generated after landing
+#define FLIGHT_TESTS_WRAP_MS 4294967     // HAL tick where time_ms * 1000 wraps (71.6 min)
+
+// Maximum delay between the true event and the transition
+#define FLIGHT_TESTS_LAUNCH_MS  300
+#define FLIGHT_TESTS_BURNOUT_MS 200
+#define FLIGHT_TESTS_APOGEE_MS  1000
+#define FLIGHT_TESTS_MAIN_MS    500
+#define FLIGHT_TESTS_LANDED_MS  (FLIGHT_DEFAULT_LANDED_TIME_MS + 3000) // Window restarts on ground noise
+
+void FLIGHT_TESTS_Replay_LogSTLINK();
+
+void FLIGHT_TESTS_LogEvent(const FLIGHT_Event *event);
+
+#endif /* INC_GAUL_FLIGHT_TESTS_FLIGHT_TESTS_H_ */
@@ -0,0 +1,37 @@
+/*
+ * FUSION_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/FUSION.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_FUSION_TESTS_H_
+#define INC_GAUL_FLIGHT_TESTS_FUSION_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define FUSION_TESTS_FLIGHTS      20
+#define FUSION_TESTS_DESCENT_MS   5000  // Simulated after apogee
+#define FUSION_TESTS_BURST_MS     10    // Accelerometer samples given in bursts (IMU task period)
+#define FUSION_TESTS_MAX_LATENCY  12    // Barometer samples given up to this many ms after their time
+#define FUSION_TESTS_ACCEL_LSB_PER_G 2048 // ICM-20602 at +/-16 g
+
+// Fixed point against the double precision reference (same inputs)
+#define FUSION_TESTS_REF_ALT_M    0.01f
+#define FUSION_TESTS_REF_VEL_MPS  0.01f
+
+// Estimate against the true flight, pad to apogee
+#define FUSION_TESTS_ALT_M        3.0f
+#define FUSION_TESTS_VEL_MPS      3.0f
+#define FUSION_TESTS_APOGEE_MPS   50.0f  // Velocity below this: approaching apogee
+#define FUSION_TESTS_BARO_VEL_MPS 10.0f  // Without accelerometer, approaching apogee
+#define FUSION_TESTS_BIAS_MPS2    0.1f
+
+void FUSION_TESTS_Replay_LogSTLINK();
+
+#endif /* INC_GAUL_FLIGHT_TESTS_FUSION_TESTS_H_ */
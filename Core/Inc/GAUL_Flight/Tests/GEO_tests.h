@@ -0,0 +1,36 @@
+/*
+ * GEO_tests.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/GEO.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_GEO_TESTS_H_
+#define INC_GAUL_FLIGHT_TESTS_GEO_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define GEO_TESTS_POINTS        2000   // Random points per pad
+#define GEO_TESTS_NEAR_M        5000.0
+#define GEO_TESTS_FAR_M         20000.0
+
+// Pass criteria (bounds documented in GEO.h)
+#define GEO_TESTS_SINCOS        2e-8   // Against sin and cos in double precision
+#define GEO_TESTS_RANGE_CM      0.51   // CORDIC against hypot (0.5: rounding)...
+#define GEO_TESTS_RANGE_RELATIVE 5e-8  // ...plus this part of the range
+#define GEO_TESTS_BEARING_CDEG  0.51   // CORDIC against atan2 (0.5: rounding)
+#define GEO_TESTS_NEAR_ENU_M    0.02   // East-North against the azimuth and distance of Vincenty
+#define GEO_TESTS_FAR_ENU_M     0.1
+#define GEO_TESTS_NEAR_RANGE_M  0.02
+#define GEO_TESTS_FAR_RANGE_M   0.1
+#define GEO_TESTS_VINCENTY_CDEG 0.6    // Bearing against the azimuth at the pad, beyond 100 m
+#define GEO_TESTS_ROUND_TRIP_CM 2      // GEO_ToLocal(GEO_ToGlobal()), steps of 1e-7 degree and 1 cm
+
+void GEO_TESTS_Vincenty_LogSTLINK();
+
+#endif /* INC_GAUL_FLIGHT_TESTS_GEO_TESTS_H_ */
@@ -0,0 +1,43 @@
+/*
+ * LAUNCH_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/LAUNCH.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_LAUNCH_TESTS_H_
+#define INC_GAUL_FLIGHT_TESTS_LAUNCH_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define LAUNCH_TESTS_FLIGHTS       20
+#define LAUNCH_TESTS_PAD_MS        30000  // Pad time of the launch profiles (with pad handling)
+#define LAUNCH_TESTS_NOISE_RUNS    6
+#define LAUNCH_TESTS_NOISE_MS      600000 // Pad only, per noise run (6 x 10 min = 1 h)
+#define LAUNCH_TESTS_BARO_MS       20     // Barometer period on the pad (FLIGHT rates)
+#define LAUNCH_TESTS_ACCEL_LSB_PER_G 2048 // ICM-20602 at +/-16 g
+#define LAUNCH_TESTS_LOW_THRUST_MPS2 12.0f // Net acceleration, below the accelerometer threshold
+
+// Pad handling and wind, one event at a time
+#define LAUNCH_TESTS_EVENT_GAP_MS  4000   // Up to this between two events
+#define LAUNCH_TESTS_QUIET_MS      2000   // No event this long before lift-off
+#define LAUNCH_TESTS_SHOCK_G       16.0f  // Knock on the rail, up to 8 ms
+#define LAUNCH_TESTS_LIFT_M        1.2f   // Picked up and put back, 1.5 to 3 s
+#define LAUNCH_TESTS_VIBRATION_MPS2 40.0f // Up to 2 s at 50 to 100 Hz
+#define LAUNCH_TESTS_GUST_M        25.0f  // Dynamic pressure on the static port
+
+// Pass criteria
+#define LAUNCH_TESTS_ACCEL_LATENCY_MS    100
+#define LAUNCH_TESTS_ACCEL_ERROR_MS      5
+#define LAUNCH_TESTS_COMBINED_LATENCY_MS 1000
+#define LAUNCH_TESTS_BARO_LATENCY_MS     2000
+#define LAUNCH_TESTS_BARO_ERROR_MS       150
+
+void LAUNCH_TESTS_Replay_LogSTLINK();
+
+#endif /* INC_GAUL_FLIGHT_TESTS_LAUNCH_TESTS_H_ */
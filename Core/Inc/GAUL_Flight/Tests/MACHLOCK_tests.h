@@ -0,0 +1,28 @@
+/*
+ * MACHLOCK_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/MACHLOCK.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_MACHLOCK_TESTS_H_
+#define INC_GAUL_FLIGHT_TESTS_MACHLOCK_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define MACHLOCK_TESTS_FLIGHTS 200
+#define MACHLOCK_TESTS_DISTURBANCE_M 150.0f
+#define MACHLOCK_TESTS_TIMER_LOCK_MS 10000 // Covers Mach 0.9 for the FLIGHTSIM default profiles
+#define MACHLOCK_TESTS_PERIOD_MS 10
+#define MACHLOCK_TESTS_MACH12_MPS 408.0f
+
+void MACHLOCK_TESTS_Replay_LogSTLINK();
+
+void MACHLOCK_TESTS_LogTransition(MACHLOCK *lock);
+
+#endif /* INC_GAUL_FLIGHT_TESTS_MACHLOCK_TESTS_H_ */
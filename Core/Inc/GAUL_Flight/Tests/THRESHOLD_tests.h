@@ -0,0 +1,23 @@
+/*
+ * THRESHOLD_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/THRESHOLD.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_THRESHOLD_TESTS_H_
+#define INC_GAUL_FLIGHT_TESTS_THRESHOLD_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define THRESHOLD_TESTS_SWEEP_Q8 2048     // +/- 8 Pa around each bound, every Q24.8 step
+#define THRESHOLD_TESTS_RANDOM_SAMPLES 10000
+
+void THRESHOLD_TESTS_Equivalence_LogSTLINK();
+
+#endif /* INC_GAUL_FLIGHT_TESTS_THRESHOLD_TESTS_H_ */
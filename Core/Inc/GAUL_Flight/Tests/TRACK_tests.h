@@ -0,0 +1,34 @@
+/*
+ * TRACK_tests.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/TRACK.h"
+
+#ifndef INC_GAUL_FLIGHT_TESTS_TRACK_TESTS_H_
+#define INC_GAUL_FLIGHT_TESTS_TRACK_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define TRACK_TESTS_DURATION_MS  20000
+#define TRACK_TESTS_QUERY_MS     10     // Estimate asked at the rate of the fastest task
+#define TRACK_TESTS_LATENCY_MS   60     // Fix epoch to TRACK_Update (output delay, line, GNSS task)
+#define TRACK_TESTS_NOISE_M      0.2    // Horizontal position noise (standard deviation)
+#define TRACK_TESTS_ALT_NOISE_M  0.3
+#define TRACK_TESTS_SPEED_NOISE_MPS 0.05
+#define TRACK_TESTS_COURSE_NOISE_DEG 0.3
+
+// Pass criteria
+#define TRACK_TESTS_CRUISE_M     0.5    // Mean horizontal error, straight track, 1 to 10 Hz
+#define TRACK_TESTS_BOOST_M      1.0    // Mean horizontal error, accelerating, 10 Hz
+#define TRACK_TESTS_TURN_M       1.0    // Mean horizontal error, turning, 10 Hz
+#define TRACK_TESTS_DESCENT_M    0.5    // Mean vertical error, descent, 10 Hz
+
+void TRACK_TESTS_Trajectories_LogSTLINK();
+
+#endif /* INC_GAUL_FLIGHT_TESTS_TRACK_TESTS_H_ */
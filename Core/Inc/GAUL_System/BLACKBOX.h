@@ -0,0 +1,114 @@
+/*
+ * BLACKBOX.h
+ *
+ * Pre-trigger capture of the full-rate barometer and GNSS samples. While armed (on the
+ * pad), the samples are delta-compressed in a ring of pages in RAM and the oldest page is
+ * overwritten: the ring always holds the last seconds before now. "BLACKBOX_Trigger"
+ * (launch, apogee) freezes the pages already captured: they are written to the flight log
+ * (LOGREC_TYPE_CAPTURE records) by "BLACKBOX_Flush", followed without a gap by the samples
+ * of the next "post_ms", which are not overwritten before being written. The ring is then
+ * armed again for the next trigger.
+ *
+ * Page:   sequence (2) | samples | 0x00 padding
+ * Sample: tag (1) | values. The first sample of each type in a page is a key sample (tag
+ * with BLACKBOX_TAG_KEY, absolute values), the next ones are differences with the previous
+ * sample of the type (time as an unsigned varint, values as zigzag varints), so a page
+ * decodes alone. At 50 Hz, a barometer sample takes about 5 bytes.
+ *
+ * Key BARO:    time ms (4) | pressure Pa Q8 (4) | temperature cC (2), little-endian
+ * Key GNSS:    time ms (4) | latitude 1e-7 deg (4) | longitude 1e-7 deg (4) | fix (1)
+ * TRIGGER:     time ms (4) | reason (1), always absolute
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/LOGREC.h"
+
+#ifndef INC_GAUL_SYSTEM_BLACKBOX_H_
+#define INC_GAUL_SYSTEM_BLACKBOX_H_
+
+#define BLACKBOX_CHUNK_SIZE   (LOGREC_PAYLOAD_SIZE - 1) // Page bytes per CAPTURE record (after the chunk index)
+#define BLACKBOX_PAGE_CHUNKS  28
+#define BLACKBOX_PAGE_SIZE    (BLACKBOX_PAGE_CHUNKS * BLACKBOX_CHUNK_SIZE) // 252 bytes
+#define BLACKBOX_PAGES        16  // Power of two, 4 KB (of the 20 KB of RAM), ~13 s at 50 Hz
+#define BLACKBOX_PAGE_HEADER  2
+#define BLACKBOX_MAX_SAMPLE   17  // Longest sample (GNSS difference)
+
+#define BLACKBOX_DEFAULT_POST_MS 10000
+
+// Sample tags
+#define BLACKBOX_TAG_END      0x00 // Padding, end of the page
+#define BLACKBOX_TAG_BARO     0x01
+#define BLACKBOX_TAG_GNSS     0x02
+#define BLACKBOX_TAG_TRIGGER  0x03
+#define BLACKBOX_TAG_KEY      0x80 // Absolute values
+
+#define BLACKBOX_STATE_ARMED     0 // Oldest page overwritten
+#define BLACKBOX_STATE_STREAMING 1 // Every page is written to the log
+
+typedef struct {
+	uint8_t type;             // BLACKBOX_TAG_x (without BLACKBOX_TAG_KEY)
+	uint32_t time_ms;
+	uint32_t press_Pa_Q8;     // BLACKBOX_TAG_BARO
+	int16_t temp_cC;
+	int32_t latitude_e7;      // BLACKBOX_TAG_GNSS
+	int32_t longitude_e7;
+	uint8_t fix;
+	uint8_t reason;           // BLACKBOX_TAG_TRIGGER (FLIGHT_PHASE_x reached)
+} BLACKBOX_Sample;
+
+typedef struct {
+	uint32_t samples;         // Samples captured
+	uint32_t bytes;           // Compressed bytes
+	uint32_t dropped;         // Samples lost, every page waiting for the log
+	uint32_t overwritten;     // Pages overwritten while armed
+	uint32_t triggers;
+	uint32_t chunks;          // CAPTURE records written
+} BLACKBOX_Stats;
+
+typedef struct {
+	uint8_t pages[BLACKBOX_PAGES][BLACKBOX_PAGE_SIZE];
+	uint16_t head;            // Page filling (free running)
+	uint16_t tail;            // Oldest page kept
+	uint16_t flush;           // Next page to write to the log
+	uint16_t flush_end;       // First page not to write (follows head while streaming)
+	uint8_t flush_chunk;      // Next chunk of the page "flush"
+	uint8_t filling;          // 1: page at head is started
+	uint16_t used;            // Bytes in the page at head
+	uint8_t state;            // BLACKBOX_STATE_x
+	uint32_t post_ms;
+	uint32_t stream_end_ms;   // End of the post-trigger samples
+	uint32_t last_time_ms;    // Last sample
+
+	// Previous sample of the page (differences)
+	uint8_t has_baro;
+	uint32_t baro_time_ms;
+	uint32_t press_Pa_Q8;
+	int16_t temp_cC;
+	uint8_t has_gnss;
+	uint32_t gnss_time_ms;
+	int32_t latitude_e7;
+	int32_t longitude_e7;
+
+	BLACKBOX_Stats stats;
+} BLACKBOX;
+
+void BLACKBOX_Init(BLACKBOX *blackbox, uint32_t post_ms);
+
+void BLACKBOX_AddBaro(BLACKBOX *blackbox, uint32_t time_ms, uint32_t press_Pa_Q8, int16_t temp_cC);
+void BLACKBOX_AddGNSS(BLACKBOX *blackbox, uint32_t time_ms, int32_t latitude_e7, int32_t longitude_e7,
+		uint8_t fix);
+void BLACKBOX_Trigger(BLACKBOX *blackbox, uint32_t time_ms, uint8_t reason);
+
+uint16_t BLACKBOX_Pending(const BLACKBOX *blackbox);
+uint8_t BLACKBOX_PeekChunk(const BLACKBOX *blackbox, uint8_t chunk[LOGREC_PAYLOAD_SIZE]);
+void BLACKBOX_PopChunk(BLACKBOX *blackbox);
+uint16_t BLACKBOX_Flush(BLACKBOX *blackbox, LOGREC *log, uint32_t time_ms, uint16_t max_chunks);
+
+uint32_t BLACKBOX_WindowMs(const BLACKBOX *blackbox);
+int16_t BLACKBOX_DecodePage(const uint8_t page[], BLACKBOX_Sample samples[], uint16_t max);
+
+#endif /* INC_GAUL_SYSTEM_BLACKBOX_H_ */
@@ -0,0 +1,134 @@
+/*
+ * LOGREC.h
+ *
+ * Record format of the flight log (SDLOG.h). Every record is 16 bytes: a type, a sequence
+ * number, the time since the TIME record of the block and a CRC-16, so 31 records fill the
+ * payload of a block exactly and a record never needs a length field. "LOGREC_Write"
+ * starts every block with a TIME record (absolute time, session and block sequence): a
+ * block decodes alone and a corrupted record only loses itself (the whole block if it is
+ * the TIME record). After a power loss, only the last block written has to be scanned
+ * (LOGREC_ScanBlock), the card holds no other state to repair.
+ *
+ * Record:   type (1) | sequence (1) | delta ms (2) | payload (10) | CRC-16 (2)
+ * Little-endian fields, CRC-16/CCITT-FALSE (PACKET_CRC16) of the first 14 bytes, most
+ * significant byte first. Type 0x00 and 0xFF are never used (erased or padded card).
+ * Tools/log_decoder.py is the host decoder.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/SDLOG.h"
+
+#ifndef INC_GAUL_SYSTEM_LOGREC_H_
+#define INC_GAUL_SYSTEM_LOGREC_H_
+
+#define LOGREC_SIZE          16
+#define LOGREC_PAYLOAD_SIZE  10
+#define LOGREC_PER_BLOCK     (SDLOG_PAYLOAD_SIZE / LOGREC_SIZE)
+#define LOGREC_MAX_DELTA_MS  0xFFFF // Longer gaps start a new block
+
+// Record types
+#define LOGREC_TYPE_TIME    1 // Absolute time, first record of every block
+#define LOGREC_TYPE_BARO    2 // Pressure, temperature, barometric altitude
+#define LOGREC_TYPE_FLIGHT  3 // Altitude, vertical velocity and acceleration, flight phase
+#define LOGREC_TYPE_GNSS    4 // Position
+#define LOGREC_TYPE_EVENT   5 // Flight phase transition
+#define LOGREC_TYPE_HEALTH  6 // Error counters (PACKET_COUNTER_x)
+#define LOGREC_TYPE_CAPTURE 7 // Bytes of a pre-trigger capture page (BLACKBOX.h)
+#define LOGREC_TYPE_UART    8 // Error counters of a UART (UARTERR.h)
+#define LOGREC_TYPE_MACHLOCK 9 // Mach lock enter or exit (MACHLOCK.h)
+#define LOGREC_TYPE_COUNT   10
+
+#define LOGREC_COUNTER_COUNT 5 // Same order as PACKET_COUNTER_x
+
+typedef struct {
+	// All types
+	uint32_t time_ms;         // HAL tick
+	uint8_t sequence;         // Set by the encoder, a gap is a lost record
+
+	// LOGREC_TYPE_TIME (set by LOGREC_Write)
+	uint16_t session;
+	uint32_t block;           // Block sequence in the session
+
+	// LOGREC_TYPE_BARO
+	uint32_t press_Pa_Q8;     // BMP280 compensated pressure
+	int16_t temp_cC;          // Temperature (0.01 C)
+
+	// LOGREC_TYPE_BARO, LOGREC_TYPE_FLIGHT, LOGREC_TYPE_EVENT, LOGREC_TYPE_MACHLOCK
+	int32_t alt_cm;           // Altitude AGL
+
+	// LOGREC_TYPE_FLIGHT, LOGREC_TYPE_MACHLOCK
+	int16_t vel_dms;          // Vertical velocity (0.1 m/s), +/- 3276 m/s
+
+	// LOGREC_TYPE_FLIGHT
+	int16_t accel_cms2;       // Vertical acceleration (0.01 m/s^2), +/- 33 g
+	uint8_t phase;            // FLIGHT_PHASE_x
+	uint8_t flags;            // LOGREC_FLAG_x
+
+	// LOGREC_TYPE_GNSS
+	int32_t latitude_e7;      // 1e-7 degree
+	int32_t longitude_e7;
+	uint8_t fix;
+	uint8_t satellites;
+
+	// LOGREC_TYPE_EVENT
+	uint8_t from;             // FLIGHT_PHASE_x
+	uint8_t to;
+
+	// LOGREC_TYPE_EVENT, LOGREC_TYPE_MACHLOCK
+	uint8_t reason;           // FLIGHT_REASON_x or MACHLOCK_REASON_x
+
+	// LOGREC_TYPE_MACHLOCK
+	uint8_t lock;             // MACHLOCK_TRANSITION_x
+
+	// LOGREC_TYPE_HEALTH
+	uint16_t counters[LOGREC_COUNTER_COUNT];
+
+	// LOGREC_TYPE_CAPTURE
+	uint8_t capture[LOGREC_PAYLOAD_SIZE];
+
+	// LOGREC_TYPE_UART
+	uint8_t uart;             // UARTERR_PORT_x
+	uint16_t overruns;
+	uint16_t framing;
+	uint16_t noise;
+	uint16_t dma;
+	uint8_t parity;
+} LOGREC_Data;
+
+#define LOGREC_FLAG_FIX       0x01 // GNSS fix
+#define LOGREC_FLAG_ACCEL     0x02 // Acceleration measured (IMU)
+
+// Encoder state, one per log
+typedef struct {
+	uint32_t base_time_ms;    // Time of the TIME record of the block
+	uint8_t sequence;
+	uint8_t synced;           // 0: next record starts a block with a TIME record
+	uint32_t records;
+	uint32_t syncs;           // TIME records written
+	uint32_t dropped;         // Records not written (SDLOG_Write error)
+} LOGREC;
+
+// Decoder state, one per block or per session
+typedef struct {
+	uint32_t base_time_ms;    // Time of the last TIME record
+	uint8_t sequence;
+	uint8_t synced;           // 1: TIME record decoded
+	uint8_t started;          // 1: "sequence" is valid
+	uint32_t records;
+	uint32_t lost;            // Sequence numbers missing (dropped or invalid records)
+	uint32_t invalid;         // CRC error, unknown type or no TIME record before
+} LOGREC_Decoder;
+
+void LOGREC_Init(LOGREC *log);
+uint8_t LOGREC_Encode(LOGREC *log, uint8_t type, const LOGREC_Data *data, uint8_t record[]);
+int8_t LOGREC_Write(LOGREC *log, uint8_t type, const LOGREC_Data *data);
+
+void LOGREC_DecoderInit(LOGREC_Decoder *decoder);
+int8_t LOGREC_Decode(LOGREC_Decoder *decoder, const uint8_t record[], uint8_t *type, LOGREC_Data *data);
+int16_t LOGREC_ScanBlock(const uint8_t block[], uint16_t session, uint32_t sequence, LOGREC_Data *last);
+
+#endif /* INC_GAUL_SYSTEM_LOGREC_H_ */
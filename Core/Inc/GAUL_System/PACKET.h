@@ -0,0 +1,96 @@
+/*
+ * PACKET.h
+ *
+ * Binary telemetry packets for the ground station (RFD900 link).
+ * "PACKET_Encode" packs the fields of one packet type in fixed-point, adds a CRC-16 and
+ * frames the result with COBS, ready for "RFD900_Send". "PACKET_Receive" splits a byte
+ * stream on the 0x00 delimiters and "PACKET_Decode" checks and unpacks a frame. The module
+ * does not depend on the hardware, the ground station can use it as is
+ * (Tools/packet_decoder.py is the Python version).
+ *
+ * Frame: COBS(header, payload, CRC-16) 0x00
+ * Header (5 bytes): version (3 bits), type (5 bits), sequence (8 bits), time (24 bits, ms)
+ * CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) of header and payload,
+ * most significant byte first. Fields are packed most significant bit first, see PACKET.c.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef INC_GAUL_SYSTEM_PACKET_H_
+#define INC_GAUL_SYSTEM_PACKET_H_
+
+#define PACKET_VERSION 3
+
+// Packet types
+#define PACKET_TYPE_FLIGHT 1 // Altitude, vertical velocity, flight phase, GNSS fix
+#define PACKET_TYPE_BARO   2 // Pressure, temperature
+#define PACKET_TYPE_GNSS   3 // Position relative to the pad
+#define PACKET_TYPE_HEALTH 4 // Error counters and CPU load
+#define PACKET_TYPE_COUNT  5 // Type 0 is not used
+
+#define PACKET_HEADER_SIZE      5
+#define PACKET_CRC_SIZE         2
+#define PACKET_MAX_PAYLOAD_SIZE 16
+// COBS adds 1 byte for less than 254 bytes, plus the 0x00 delimiter
+#define PACKET_MAX_FRAME_SIZE   (PACKET_HEADER_SIZE + PACKET_MAX_PAYLOAD_SIZE + PACKET_CRC_SIZE + 2)
+
+// Health counters
+#define PACKET_COUNTER_RADIO_DROPPED   0 // Telemetry frames dropped by the RFD900 queue
+#define PACKET_COUNTER_TRACE_DROPPED   1 // Trace records dropped
+#define PACKET_COUNTER_TASK_OVERRUNS   2 // Scheduler deadline overruns (all tasks)
+#define PACKET_COUNTER_BARO_ERRORS     3
+#define PACKET_COUNTER_GNSS_ERRORS     4
+#define PACKET_COUNTER_GNSS_UART       5 // USART2 errors (UARTERR, all classes)
+#define PACKET_COUNTER_RADIO_UART      6 // USART1 errors (UARTERR, all classes)
+#define PACKET_COUNTER_COUNT           7
+
+typedef struct {
+	// Header (all types)
+	uint8_t sequence;         // Incremented by the caller for every packet, to count losses
+	uint32_t time_ms;         // HAL tick, 24 bits are sent (wraps after 4.6 hours)
+
+	// PACKET_TYPE_FLIGHT
+	int32_t alt_dm;           // Altitude AGL (0.1 m), +/- 52 km
+	int16_t vel_dms;          // Vertical velocity (0.1 m/s), +/- 819 m/s
+	uint8_t phase;            // FLIGHT_PHASE_x (3 bits)
+	uint8_t fix;              // 1: GNSS fix
+
+	// PACKET_TYPE_BARO
+	uint32_t press_Pa;        // 0 to 131071 Pa
+	int16_t temp_dC;          // Temperature (0.1 C), +/- 102 C
+
+	// PACKET_TYPE_GNSS (fix is also sent)
+	int32_t north_m;          // From the pad (TRACK, tangent plane), +/- 524 km
+	int32_t east_m;
+
+	// PACKET_TYPE_HEALTH
+	uint16_t counters[PACKET_COUNTER_COUNT]; // PACKET_COUNTER_x, saturated at 65535
+	uint16_t load_permille;   // CPU load (SCHEDULER_Load), 10 bits
+} PACKET_Data;
+
+// Stream receiver, bytes are accumulated until the 0x00 delimiter
+typedef struct {
+	uint8_t frame[PACKET_MAX_FRAME_SIZE];
+	uint16_t size;
+	uint8_t overflow;         // 1: frame too long, ignored until the next delimiter
+	uint8_t complete;         // 1: frame returned, cleared at the next byte
+} PACKET_Receiver;
+
+uint16_t PACKET_Encode(uint8_t type, const PACKET_Data *data, uint8_t frame[]);
+int8_t PACKET_Decode(const uint8_t frame[], uint16_t size, uint8_t *type, PACKET_Data *data);
+
+void PACKET_ReceiverInit(PACKET_Receiver *receiver);
+int8_t PACKET_Receive(PACKET_Receiver *receiver, uint8_t byte);
+
+uint8_t PACKET_PayloadSize(uint8_t type);
+uint8_t PACKET_FrameSize(uint8_t type);
+
+uint16_t PACKET_CRC16(const uint8_t data[], uint16_t size);
+uint16_t PACKET_COBSEncode(const uint8_t input[], uint16_t size, uint8_t output[]);
+int16_t PACKET_COBSDecode(const uint8_t input[], uint16_t size, uint8_t output[]);
+
+#endif /* INC_GAUL_SYSTEM_PACKET_H_ */
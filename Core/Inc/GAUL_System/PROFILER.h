@@ -0,0 +1,66 @@
+/*
+ * PROFILER.h
+ *
+ * Execution time profiler using the Cortex-M3 DWT cycle counter (1 cycle = 1/72 us).
+ * Code to measure is surrounded by "PROFILER_BEGIN(zone)" and "PROFILER_END(zone)".
+ * Each zone keeps min/max/mean and a log2 histogram in RAM, "PROFILER_Dump" sends
+ * the statistics over ITM (STLINK) or a UART.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_SYSTEM_PROFILER_H_
+#define INC_GAUL_SYSTEM_PROFILER_H_
+
+// Set to 0 to remove all probes from the build
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Zones (add the name in PROFILER.c)
+#define PROFILER_ZONE_BMP280_READ         0
+#define PROFILER_ZONE_L76LM33_READ        1
+#define PROFILER_ZONE_NMEA_PARSERMC       2
+#define PROFILER_ZONE_FLIGHT_UPDATE       3
+#define PROFILER_ZONE_ICM20602_READ       4
+#define PROFILER_ZONE_FUSION_PREDICT      5
+#define PROFILER_ZONE_APOGEE_UPDATE       6
+#define PROFILER_ZONE_COUNT               7
+
+// Histogram bucket i counts durations in [2^(i-1), 2^i) cycles, bucket 0 counts 0 cycles.
+// Last bucket counts everything above 2^22 cycles (58 ms).
+#define PROFILER_HISTOGRAM_SIZE 24
+
+#define PROFILER_UART_TIMEOUT 100
+
+#if PROFILER_ENABLED
+#define PROFILER_BEGIN(zone) uint32_t profiler_start_##zone = DWT->CYCCNT
+#define PROFILER_END(zone) PROFILER_Record((zone), DWT->CYCCNT - profiler_start_##zone)
+#else
+#define PROFILER_BEGIN(zone)
+#define PROFILER_END(zone)
+#endif
+
+typedef struct {
+	uint32_t count;
+	uint32_t min_cycles;
+	uint32_t max_cycles;
+	uint64_t sum_cycles;
+	uint32_t histogram[PROFILER_HISTOGRAM_SIZE];
+} PROFILER_Zone;
+
+int8_t PROFILER_Init();
+
+void PROFILER_Record(uint8_t zone, uint32_t cycles);
+void PROFILER_Reset();
+
+const PROFILER_Zone *PROFILER_GetZone(uint8_t zone);
+uint32_t PROFILER_Mean(uint8_t zone);
+uint8_t PROFILER_Bucket(uint32_t cycles);
+
+void PROFILER_Dump(UART_HandleTypeDef *huart);
+
+#endif /* INC_GAUL_SYSTEM_PROFILER_H_ */
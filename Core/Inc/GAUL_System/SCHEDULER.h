@@ -0,0 +1,70 @@
+/*
+ * SCHEDULER.h
+ *
+ * Cooperative time-triggered scheduler. Tasks are declared in a static table with a
+ * period, an offset and a deadline. Table order is the priority: when several tasks are
+ * due, the first one in the table runs first. Tasks run to completion (no preemption).
+ * Main function is "SCHEDULER_Dispatch", to call in the main loop.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#ifndef INC_GAUL_SYSTEM_SCHEDULER_H_
+#define INC_GAUL_SYSTEM_SCHEDULER_H_
+
+#define SCHEDULER_MAX_TASKS    8
+#define SCHEDULER_LOAD_WINDOW_MS 10000 // Load measured over the last 10 to 20 s (the us clock wraps)
+
+typedef void (*SCHEDULER_Function)(void);
+typedef uint32_t (*SCHEDULER_Clock)(void);          // Time in microseconds (wraps after ~71 min)
+typedef void (*SCHEDULER_Idle)(uint32_t sleep_us);  // Nothing to run for sleep_us
+
+typedef struct {
+	// Configuration (static table)
+	const char *name;
+	SCHEDULER_Function function;
+	uint32_t period_ms;
+	uint32_t offset_ms;     // First release after SCHEDULER_Init
+	uint32_t deadline_ms;   // Must finish this long after its release, 0: period
+
+	// Runtime
+	uint32_t release_us;    // Next release
+	uint32_t last_us;       // Last execution time
+	uint32_t wcet_us;       // Measured worst-case execution time
+	uint32_t max_latency_us; // Longest time between release and start
+	uint32_t runs;
+	uint32_t overruns;      // Runs finished after the deadline
+	uint32_t skipped;       // Releases missed because the task ran too late
+	uint8_t rephased;       // 1: period changed, the next run is not counted late
+} SCHEDULER_Task;
+
+typedef struct {
+	SCHEDULER_Task *tasks;
+	uint8_t size;
+	SCHEDULER_Clock clock;
+	SCHEDULER_Idle idle;
+
+	uint32_t stats_start_us; // Start of the measured load window
+	uint32_t busy_us;        // Time spent in tasks since stats_start_us
+	uint32_t last_window_us; // Length of the previous window, 0: none
+	uint32_t last_busy_us;   // Time spent in tasks in the previous window
+	uint32_t idle_calls;
+} SCHEDULER;
+
+int8_t SCHEDULER_Init(SCHEDULER *scheduler, SCHEDULER_Task tasks[], uint8_t size, SCHEDULER_Clock clock, SCHEDULER_Idle idle);
+int8_t SCHEDULER_Dispatch(SCHEDULER *scheduler);
+
+int8_t SCHEDULER_SetPeriod(SCHEDULER *scheduler, uint8_t id, uint32_t period_ms);
+
+uint16_t SCHEDULER_Utilisation(SCHEDULER *scheduler);
+uint16_t SCHEDULER_Load(SCHEDULER *scheduler);
+void SCHEDULER_ResetStats(SCHEDULER *scheduler);
+
+uint32_t SCHEDULER_TimeUs(void);
+uint32_t SCHEDULER_Time(uint32_t *time_ms);
+void SCHEDULER_Sleep(uint32_t sleep_us);
+
+#endif /* INC_GAUL_SYSTEM_SCHEDULER_H_ */
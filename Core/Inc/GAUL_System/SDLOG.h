@@ -0,0 +1,80 @@
+/*
+ * SDLOG.h
+ *
+ * Append-only flight log on the SD card (SD.h). Records are copied in 512 bytes blocks
+ * (ping-pong buffers): while one block is sent by DMA and programmed by the card, the next
+ * one fills. "SDLOG_Write" only copies the record, it never waits for the card: if every
+ * buffer is full, the record is dropped and counted. "SDLOG_Process" starts the next block
+ * and follows the card busy time, call it from the logging task.
+ *
+ * The card is used without file system. Block "first_block" is an index of the logging
+ * sessions (first and last block of each power-up), so the host tool finds a flight
+ * without scanning the card. Every data block starts with a header (magic, session, block
+ * sequence), the end of a session not closed (power loss) is found by a binary search on
+ * the sequence numbers.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Drivers/SD.h"
+
+#ifndef INC_GAUL_SYSTEM_SDLOG_H_
+#define INC_GAUL_SYSTEM_SDLOG_H_
+
+#define SDLOG_BUFFER_BLOCKS       2       // Ping-pong
+#define SDLOG_HEADER_SIZE         16
+#define SDLOG_PAYLOAD_SIZE        (SD_BLOCK_SIZE - SDLOG_HEADER_SIZE)
+#define SDLOG_MAGIC               0x474F4C47 // "GLOG"
+#define SDLOG_INDEX_MAGIC         0x58444947 // "GIDX"
+#define SDLOG_INDEX_VERSION       1
+#define SDLOG_INDEX_HEADER_SIZE   8
+#define SDLOG_SESSION_SIZE        16
+#define SDLOG_MAX_SESSIONS        ((SD_BLOCK_SIZE - SDLOG_INDEX_HEADER_SIZE) / SDLOG_SESSION_SIZE)
+#define SDLOG_OPEN                0xFFFFFFFF // End block of a session not closed
+#define SDLOG_CLOSE_TIMEOUT_MS    1000
+
+#define SDLOG_DEFAULT_FIRST_BLOCK     0
+#define SDLOG_DEFAULT_BLOCKS          0x400000 // 2 GB
+#define SDLOG_DEFAULT_RESERVE_BLOCKS  16384    // Pre-erased: 8 MB, 27 min at 10 blocks/s
+
+/*
+ * Data block:   magic (4) | sequence (4) | session (2) | used (2) | reserved (4) | records
+ * Index block:  magic (4) | version (2) | count (2) | sessions
+ * Session:      start block (4) | end block (4) | start time ms (4) | reserved blocks (4)
+ * Little-endian, "sequence" is the block number in the session, "used" the record bytes.
+ */
+
+typedef struct {
+	uint32_t start_block;
+	uint32_t end_block;        // First block after the session, SDLOG_OPEN while logging
+	uint32_t start_time_ms;
+	uint32_t reserved_blocks;  // Pre-erased with ACMD23
+} SDLOG_Session;
+
+typedef struct {
+	uint32_t records;          // Records written in a block
+	uint32_t bytes;
+	uint32_t dropped;          // Records dropped, every buffer full
+	uint32_t blocks_sealed;    // Blocks filled
+	uint32_t blocks_written;   // Blocks sent to the card
+	uint8_t max_waiting;       // Most sealed blocks waiting for the card
+} SDLOG_Stats;
+
+int8_t SDLOG_Init(uint32_t first_block, uint32_t blocks, uint32_t reserve_blocks, uint32_t time_ms);
+int8_t SDLOG_Write(const uint8_t data[], uint16_t size);
+void SDLOG_Flush();
+int8_t SDLOG_Process();
+int8_t SDLOG_Close();
+
+int8_t SDLOG_ReadSession(uint32_t first_block, uint16_t session, SDLOG_Session *entry);
+int8_t SDLOG_FindEnd(uint16_t session, const SDLOG_Session *entry, uint32_t limit_block, uint32_t *end_block);
+
+uint16_t SDLOG_Free();
+uint8_t SDLOG_IsOpen();
+uint16_t SDLOG_GetSession();
+const SDLOG_Stats *SDLOG_GetStats();
+
+#endif /* INC_GAUL_SYSTEM_SDLOG_H_ */
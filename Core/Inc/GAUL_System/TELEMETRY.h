@@ -0,0 +1,70 @@
+/*
+ * TELEMETRY.h
+ *
+ * Bandwidth-aware choice of the telemetry packets (PACKET.h) sent on the radio link.
+ * Every flight phase has a period and a priority order for each packet type: altitude and
+ * velocity (FLIGHT) at every telemetry run during ascent, position (GNSS) at 1 Hz on the pad
+ * and at every run in descent, health counters occasionally. "TELEMETRY_Next" returns the
+ * next packet type to send, while keeping the link below a bytes per second ceiling and
+ * backing off when the radio queue fills up. It never waits.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_Flight/FLIGHT.h"
+#include "GAUL_System/PACKET.h"
+
+#ifndef INC_GAUL_SYSTEM_TELEMETRY_H_
+#define INC_GAUL_SYSTEM_TELEMETRY_H_
+
+#define TELEMETRY_EVERY_RUN 0      // Period: at every telemetry run (as fast as the budget allows)
+#define TELEMETRY_NEVER     0xFFFF // Period: not sent in this phase
+
+#define TELEMETRY_TYPE_COUNT (PACKET_TYPE_COUNT - 1) // Packet types 1 to PACKET_TYPE_COUNT - 1
+
+// Default configuration (see TELEMETRY_DefaultConfig)
+#define TELEMETRY_DEFAULT_MAX_BYTES_PER_S 720 // 75% of the 960 bytes/s of 9600 baud
+#define TELEMETRY_DEFAULT_BURST_BYTES     64
+#define TELEMETRY_DEFAULT_QUEUE_HIGH      2  // Waiting frames: only the first priority is sent
+#define TELEMETRY_DEFAULT_QUEUE_FULL      4  // Waiting frames: nothing is sent
+
+typedef struct {
+	uint16_t period_ms[FLIGHT_PHASE_COUNT][PACKET_TYPE_COUNT];    // Per phase and packet type (index 0 unused)
+	uint8_t order[FLIGHT_PHASE_COUNT][TELEMETRY_TYPE_COUNT];     // Packet types, highest priority first
+	uint16_t max_bytes_per_s;  // Link budget ceiling
+	uint16_t burst_bytes;      // Budget saved when nothing is sent (bucket size)
+	uint8_t queue_high;
+	uint8_t queue_full;
+} TELEMETRY_Config;
+
+typedef struct {
+	uint32_t next_ms;          // Next release
+	uint32_t last_ms;          // Last packet
+	uint32_t sent;             // Packets since the phase started
+	uint32_t bytes;
+	uint32_t deferred;         // Runs where the packet was due but the budget or the queue was full
+} TELEMETRY_Type;
+
+typedef struct {
+	TELEMETRY_Config config;
+
+	uint8_t phase;             // FLIGHT_PHASE_x
+	uint32_t phase_time_ms;    // Statistics start
+	uint32_t budget_mbytes;    // Token bucket (1/1000 byte)
+	uint32_t budget_time_ms;   // Last refill
+	TELEMETRY_Type types[PACKET_TYPE_COUNT];
+} TELEMETRY;
+
+void TELEMETRY_DefaultConfig(TELEMETRY_Config *config);
+int8_t TELEMETRY_Init(TELEMETRY *telemetry, const TELEMETRY_Config *config, uint32_t time_ms);
+void TELEMETRY_SetPhase(TELEMETRY *telemetry, uint8_t phase, uint32_t time_ms);
+
+uint8_t TELEMETRY_Next(TELEMETRY *telemetry, uint32_t time_ms, uint8_t queue_pending);
+
+uint32_t TELEMETRY_RatemHz(const TELEMETRY *telemetry, uint8_t type, uint32_t time_ms);
+uint32_t TELEMETRY_BytesPerSecond(const TELEMETRY *telemetry, uint32_t time_ms);
+
+#endif /* INC_GAUL_SYSTEM_TELEMETRY_H_ */
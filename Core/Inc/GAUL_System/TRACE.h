@@ -0,0 +1,68 @@
+/*
+ * TRACE.h
+ *
+ * Binary trace over ITM (SWO) with deferred formatting. Call sites log a message id
+ * (TRACE_MESSAGES.h) and raw 32-bit arguments in a RAM ring with "TRACE" (a few tens of
+ * cycles), and a low priority task sends the ring over ITM stimulus port 1 with
+ * "TRACE_Flush". printf text stays on port 0.
+ *
+ * Record format (32-bit words): header, timestamp (HAL tick), arguments.
+ * Header: bits 31-24 TRACE_SYNC, bits 19-16 number of arguments, bits 15-0 message id.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include <stddef.h>
+
+#ifndef INC_GAUL_SYSTEM_TRACE_H_
+#define INC_GAUL_SYSTEM_TRACE_H_
+
+#define TRACE_BUFFER_WORDS 512  // Must be a power of 2 (2 KB)
+#define TRACE_MAX_ARGS     8
+#define TRACE_PORT         1    // ITM stimulus port, enable it in the SWV configuration
+#define TRACE_SYNC         0xA5
+
+typedef enum {
+#define TRACE_MESSAGE(id, format) id,
+#include "GAUL_System/TRACE_MESSAGES.h"
+#undef TRACE_MESSAGE
+	TRACE_ID_COUNT
+} TRACE_Id;
+
+// Output of one word, returns 0 if sent, -1 if busy (try later). NULL: ITM.
+typedef int8_t (*TRACE_Output)(uint32_t word);
+
+typedef struct {
+	uint32_t records;      // Records written in the ring
+	uint32_t dropped;      // Records dropped because the ring was full
+	uint16_t max_used;     // Highest ring usage (words)
+} TRACE_Stats;
+
+// Log a message with arguments (integers, or floats converted with TRACE_Float)
+#define TRACE(id, ...) TRACE_Write((id), sizeof((uint32_t[]){ __VA_ARGS__ }) / sizeof(uint32_t), \
+		(const uint32_t[]){ __VA_ARGS__ })
+// Log a message without argument
+#define TRACE0(id) TRACE_Write((id), 0, NULL)
+
+/**
+ * Raw bits of a float, to pass a float argument to TRACE.
+ */
+static inline uint32_t TRACE_Float(float value) {
+	union {
+		float f;
+		uint32_t u;
+	} bits = { .f = value };
+	return bits.u;
+}
+
+void TRACE_Init(TRACE_Output output);
+
+void TRACE_Write(uint16_t id, uint8_t argc, const uint32_t args[]);
+uint16_t TRACE_Flush(uint16_t max_words);
+
+const TRACE_Stats *TRACE_GetStats();
+
+#endif /* INC_GAUL_SYSTEM_TRACE_H_ */
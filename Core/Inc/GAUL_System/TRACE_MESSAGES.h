@@ -0,0 +1,23 @@
+/*
+ * TRACE_MESSAGES.h
+ *
+ * Trace message table: TRACE_MESSAGE(id, format). The format strings are never compiled
+ * in the firmware, only the id (position in this table) and the raw arguments are sent.
+ * Tools/trace_decoder.py reads this file to restore the messages on the computer.
+ *
+ * Arguments are 32-bit words: use %lu, %ld or %lx for integers, and %f (any precision)
+ * for floats given with TRACE_Float(). Only add messages at the end of the table.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+// No include guard, included several times with different TRACE_MESSAGE definitions
+
+TRACE_MESSAGE(TRACE_ID_DROPPED, "trace: %lu records dropped")
+TRACE_MESSAGE(TRACE_ID_FLIGHT_TRANSITION, "%lu ms: phase %lu -> %lu (reason %lu, %.1f m)")
+TRACE_MESSAGE(TRACE_ID_TELEMETRY, "phase %lu %.1f m fix %lu")
+TRACE_MESSAGE(TRACE_ID_GNSS_FIRST_FIX, "GNSS first fix %lu ms (aiding %lu, EPO %lu), previous boot %lu ms (aiding %lu)")
+TRACE_MESSAGE(TRACE_ID_EPO_UPLOAD, "EPO upload state %lu: %lu/%lu records in %lu ms (%lu failures, %lu CRC errors)")
+TRACE_MESSAGE(TRACE_ID_MACHLOCK, "%lu ms: Mach lock %lu (1 enter, 2 exit), reason %lu, %.1f m/s, %.1f m")
+TRACE_MESSAGE(TRACE_ID_GNSS_NOT_FOUND, "GNSS module not found in %lu ms, USART2 left at %lu baud")
@@ -0,0 +1,25 @@
+/*
+ * BLACKBOX_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/BLACKBOX.h"
+
+#ifndef INC_GAUL_SYSTEM_TESTS_BLACKBOX_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_BLACKBOX_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define BLACKBOX_TESTS_PERIOD_MS  20 // Barometer at 50 Hz
+#define BLACKBOX_TESTS_GNSS_EVERY 50 // GNSS at 1 Hz
+
+void BLACKBOX_TESTS_Capture_LogSTLINK();
+
+void BLACKBOX_TESTS_LogStats(const BLACKBOX *blackbox);
+
+#endif /* INC_GAUL_SYSTEM_TESTS_BLACKBOX_TESTS_H_ */
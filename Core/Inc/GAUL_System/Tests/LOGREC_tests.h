@@ -0,0 +1,25 @@
+/*
+ * LOGREC_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/LOGREC.h"
+
+#ifndef INC_GAUL_SYSTEM_TESTS_LOGREC_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_LOGREC_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define LOGREC_TESTS_FUZZ_ITERATIONS 2000
+
+void LOGREC_TESTS_Fuzz_LogSTLINK();
+void LOGREC_TESTS_Model_LogSTLINK();
+
+void LOGREC_TESTS_LogData(uint8_t type, const LOGREC_Data *data);
+
+#endif /* INC_GAUL_SYSTEM_TESTS_LOGREC_TESTS_H_ */
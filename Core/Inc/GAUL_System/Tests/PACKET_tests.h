@@ -0,0 +1,25 @@
+/*
+ * PACKET_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/PACKET.h"
+
+#ifndef INC_GAUL_SYSTEM_TESTS_PACKET_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_PACKET_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define PACKET_TESTS_LINK_BYTES_PER_S 960 // 9600 baud, 10 bits per byte
+
+void PACKET_TESTS_RoundTrip_LogSTLINK();
+void PACKET_TESTS_Report_LogSTLINK();
+
+void PACKET_TESTS_LogData(uint8_t type, const PACKET_Data *data);
+
+#endif /* INC_GAUL_SYSTEM_TESTS_PACKET_TESTS_H_ */
@@ -0,0 +1,17 @@
+/*
+ * PROFILER_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/PROFILER.h"
+
+#ifndef INC_GAUL_SYSTEM_TESTS_PROFILER_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_PROFILER_TESTS_H_
+
+void PROFILER_TESTS_LogSTLINK();
+
+#endif /* INC_GAUL_SYSTEM_TESTS_PROFILER_TESTS_H_ */
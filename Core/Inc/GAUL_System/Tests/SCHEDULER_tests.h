@@ -0,0 +1,24 @@
+/*
+ * SCHEDULER_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/SCHEDULER.h"
+
+#ifndef INC_GAUL_SYSTEM_TESTS_SCHEDULER_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_SCHEDULER_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define SCHEDULER_TESTS_DURATION_US 10000000 // 10 s of simulated time
+
+void SCHEDULER_TESTS_Simulation_LogSTLINK();
+
+void SCHEDULER_TESTS_LogStats(SCHEDULER *scheduler);
+
+#endif /* INC_GAUL_SYSTEM_TESTS_SCHEDULER_TESTS_H_ */
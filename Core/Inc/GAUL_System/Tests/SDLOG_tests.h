@@ -0,0 +1,25 @@
+/*
+ * SDLOG_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/SDLOG.h"
+
+#ifndef INC_GAUL_SYSTEM_TESTS_SDLOG_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_SDLOG_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define SDLOG_TESTS_TASK_PERIOD_MS 10 // Logging task period in flight
+#define SDLOG_TESTS_RESERVE_BLOCKS 64
+
+void SDLOG_TESTS_Model_LogSTLINK();
+
+void SDLOG_TESTS_LogStats();
+
+#endif /* INC_GAUL_SYSTEM_TESTS_SDLOG_TESTS_H_ */
@@ -0,0 +1,24 @@
+/*
+ * TELEMETRY_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/TELEMETRY.h"
+
+#ifndef INC_GAUL_SYSTEM_TESTS_TELEMETRY_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_TELEMETRY_TESTS_H_
+
+#define DEBUG_Pin GPIO_PIN_5
+#define DEBUG_GPIO_Port GPIOB
+
+#define TELEMETRY_TESTS_PHASE_MS 20000 // Simulated time in each flight phase
+
+void TELEMETRY_TESTS_Simulation_LogSTLINK();
+
+void TELEMETRY_TESTS_LogRates(const TELEMETRY *telemetry, uint32_t time_ms);
+
+#endif /* INC_GAUL_SYSTEM_TESTS_TELEMETRY_TESTS_H_ */
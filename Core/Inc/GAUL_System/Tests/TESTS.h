@@ -0,0 +1,38 @@
+/*
+ * TESTS.h
+ *
+ * Helpers shared by the tests: "TESTS_Random" pseudo random generator (xorshift32, each
+ * test keeps its own state so a failing test replays the same values), and
+ * "TESTS_FieldsEqual" comparing the fields listed in a table (TESTS_FIELD) of two
+ * structures, for the round trips where only the fields of one type are kept.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include <stddef.h>
+
+#ifndef INC_GAUL_SYSTEM_TESTS_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_TESTS_H_
+
+// Field of a structure compared by TESTS_FieldsEqual
+#define TESTS_FIELD(type, member) { offsetof(type, member), sizeof(((type *)0)->member) }
+// Table of fields with its size, for a TESTS_Fields initializer
+#define TESTS_FIELDS(table) { (table), sizeof(table) / sizeof((table)[0]) }
+
+typedef struct {
+	uint16_t offset;
+	uint16_t size;
+} TESTS_Field;
+
+typedef struct {
+	const TESTS_Field *fields; // NULL: type without fields
+	uint8_t count;
+} TESTS_Fields;
+
+uint32_t TESTS_Random(uint32_t *state);
+uint8_t TESTS_FieldsEqual(const void *a, const void *b, const TESTS_Fields *fields);
+
+#endif /* INC_GAUL_SYSTEM_TESTS_TESTS_H_ */
@@ -0,0 +1,19 @@
+/*
+ * TRACE_tests.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "stm32f1xx_hal.h"
+
+#include "GAUL_System/TRACE.h"
+
+#ifndef INC_GAUL_SYSTEM_TESTS_TRACE_TESTS_H_
+#define INC_GAUL_SYSTEM_TESTS_TRACE_TESTS_H_
+
+#define TRACE_TESTS_CAPTURE_WORDS 1024
+
+void TRACE_TESTS_LogSTLINK();
+
+#endif /* INC_GAUL_SYSTEM_TESTS_TRACE_TESTS_H_ */
@@ -46,6 +46,13 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
+// Text on the ITM port 0 (printf), Debug configuration only: the flight firmware (Release)
+// has no printf, its messages go through TRACE
+#ifdef DEBUG
+#define DEBUG_PRINTF(...) printf(__VA_ARGS__)
+#else
+#define DEBUG_PRINTF(...) ((void)0)
+#endif
 
 /* USER CODE END EM */
 
@@ -61,8 +68,12 @@ void Error_Handler(void);
 #define GPS_TX_GPIO_Port GPIOA
 #define GPS_RX_Pin GPIO_PIN_3
 #define GPS_RX_GPIO_Port GPIOA
+#define ICM_CS_Pin GPIO_PIN_0
+#define ICM_CS_GPIO_Port GPIOB
 #define BMP_CS_Pin GPIO_PIN_8
 #define BMP_CS_GPIO_Port GPIOA
+#define SD_CS_Pin GPIO_PIN_12
+#define SD_CS_GPIO_Port GPIOB
 #define DEBUG_Pin GPIO_PIN_5
 #define DEBUG_GPIO_Port GPIOB
 #define RFD_TX_Pin GPIO_PIN_6
@@ -3,7 +3,8 @@
  *
  * BMP280 is a barometer used to get the altitude of the rocket.
  * Main functions are "BMP280_Init" to configure BMP280, and "BMP280_ReadAltitude"
- * to update values in a BMP280 structure.
+ * to update values in a BMP280 structure. In flight, "BMP280_ReadMeasurement" reads the
+ * pressure only and "BMP280_LinearAltitudeMm" converts it without pow().
  *
  *  Created on: May 18, 2024
  *      Author: gagnon
@@ -14,18 +15,48 @@
  */
 
 #include "GAUL_Drivers/BMP280.h"
+#include "GAUL_Drivers/SPIBUS.h"
 
 #include "math.h" // for pow()
 
 // Pointer to SPI handler
 SPI_HandleTypeDef *BMP_hspi;
 
+// Device number on the SPI2 bus
+static int8_t BMP_device = -1;
+
 // Multi purpose receiving buffer
 uint8_t BMP_RX_Buffer[26];
 
+// BMP280_PressureToAltitude (mm) at pressure ratios 1 - i / 256, i = 0 to BMP280_ALT_TABLE_SIZE - 1
+// (ground to 7.5 km). Linear interpolation error below 0.1 m.
+static const int32_t BMP280_ALT_TABLE_MM[BMP280_ALT_TABLE_SIZE] = {
+	0, 33005, 66116, 99332, 132654, 166084, 199622, 233268,
+	267025, 300891, 334869, 368959, 403161, 437478, 471908, 506455,
+	541117, 575897, 610795, 645811, 680948, 716205, 751584, 787085,
+	822710, 858460, 894335, 930337, 966466, 1002724, 1039111, 1075629,
+	1112279, 1149061, 1185977, 1223028, 1260215, 1297539, 1335002, 1372603,
+	1410346, 1448230, 1486257, 1524428, 1562745, 1601208, 1639819, 1678579,
+	1717490, 1756552, 1795768, 1835138, 1874664, 1914347, 1954188, 1994190,
+	2034353, 2074679, 2115169, 2155826, 2196649, 2237642, 2278806, 2320141,
+	2361651, 2403335, 2445197, 2487238, 2529459, 2571862, 2614449, 2657223,
+	2700183, 2743334, 2786675, 2830210, 2873940, 2917867, 2961994, 3006321,
+	3050852, 3095588, 3140532, 3185685, 3231050, 3276629, 3322424, 3368438,
+	3414673, 3461132, 3507816, 3554729, 3601872, 3649249, 3696861, 3744712,
+	3792805, 3841141, 3889724, 3938557, 3987642, 4036983, 4086582, 4136443,
+	4186568, 4236961, 4287625, 4338563, 4389778, 4441275, 4493056, 4545125,
+	4597486, 4650142, 4703096, 4756354, 4809919, 4863794, 4917983, 4972492,
+	5027324, 5082483, 5137974, 5193802, 5249970, 5306484, 5363349, 5420568,
+	5478148, 5536094, 5594410, 5653101, 5712175, 5771635, 5831488, 5891740,
+	5952396, 6013463, 6074947, 6136854, 6199191, 6261965, 6325182, 6388850,
+	6452975, 6517566, 6582630, 6648175, 6714208, 6780739, 6847774, 6915324,
+	6983397, 7052001, 7121147, 7190845, 7261103, 7331932, 7403343, 7475347,
+	7547954
+};
+
 /**
  * Initialize BMP280 sensor.
- * - Set BMP280 SPI handler
+ * - Set BMP280 SPI handler, add the BMP280 to the SPI bus (SPIBUS_Init must be done)
  * - Reset
  * - Validate SPI2 communication with device ID
  * - Read calibration data
@@ -38,16 +69,14 @@ uint8_t BMP_RX_Buffer[26];
  * @retval -1 ERROR
  */
 int8_t BMP280_Init(BMP280 *BMP_data, SPI_HandleTypeDef *hspi) {
-	// SPI Bug Fix
-	/* Note page 704/1136 RM0008 Rev 21 :
-	* The idle state of SCK must correspond to the polarity selected in the
-	* SPI_CR1 register (by pulling up SCK if CPOL=1 or pulling down SCK if CPOL=0).
-	*/
-	uint8_t dummy = 0x00;
-	HAL_SPI_Transmit(hspi, &dummy, 1, 1000);
+	// SCK idle level is set by SPIBUS_Init (SPI Bug Fix)
 
 	// Set BMP280 SPI handler
 	BMP_hspi = hspi;
+	BMP_device = SPIBUS_AddDevice(BMP_CS_GPIO_Port, BMP_CS_Pin, BMP280_SPI_PRESCALER, 0);
+	if (BMP_device < 0) {
+		return -1; // Error, bus full
+	}
 
     // Reset
     if (BMP280_SoftReset() != 0) {
@@ -79,6 +108,7 @@ int8_t BMP280_Init(BMP280 *BMP_data, SPI_HandleTypeDef *hspi) {
     if (BMP280_MeasureReference(BMP_data, 40, 50) != 0 || BMP_data->press_ref_Pa < 90000.0 || BMP_data->press_ref_Pa > 110000.0) {
     	BMP_data->press_ref_Pa = 101325.0; // Default value if error or extreme values
     }
+    BMP280_SetReference(BMP_data, BMP_data->press_ref_Pa);
 
     return 0; // OK
 }
@@ -179,6 +209,17 @@ int8_t BMP280_MeasureReference(BMP280 *BMP_data, uint16_t samples, uint8_t delay
 	return 0; // OK
 }
 
+/**
+ * Set the reference (ground) pressure of the altitude calculations.
+ *
+ * @param BMP_data: pointer to a BMP280 structure.
+ * @param press_ref_Pa: reference pressure in Pascal (90 to 110 kPa, see BMP280_Init).
+ */
+void BMP280_SetReference(BMP280 *BMP_data, float press_ref_Pa) {
+	BMP_data->press_ref_Pa = press_ref_Pa;
+	BMP_data->press_ref_inv = (uint32_t)((1ULL << 56) / (uint32_t)(press_ref_Pa * 256.0f));
+}
+
 /**
  * Reads temperature registers, then calculate temperature in Celsius from calibration data.
  *
@@ -249,11 +290,36 @@ int8_t BMP280_ReadPressure(BMP280 *BMP_data) {
     p = ((p + var1 + var2) >> 8) + (((int64_t)BMP_data->calib_data.dig_P7) << 4);
     p = (uint32_t)p;
 
+    BMP_data->press_Pa_Q8 = (uint32_t)p;
     BMP_data->press_Pa = (float)p / (float)(1 << 8);
 
     return 0; // OK
 }
 
+/**
+ * Reads temperature and pressure values from the BMP280, without calculating the altitude.
+ * Use this on the hot path with the THRESHOLD module, and calculate the altitude only
+ * when needed (logging, telemetry) with BMP280_PressureToAltitude.
+ *
+ * Execution time in PROFILER_ZONE_BMP280_READ (TASK_Baro, PROFILER_Dump).
+ *
+ * @param BMP_data: pointer to a BMP280 structure.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t BMP280_ReadMeasurement(BMP280 *BMP_data) {
+	// Temperature first, pressure compensation needs t_fine
+	if (BMP280_ReadTemperature(BMP_data) != 0) {
+		return -1; // Error
+	}
+	if (BMP280_ReadPressure(BMP_data) != 0) {
+		return -1; // Error
+	}
+
+	return 0; // OK
+}
+
 /**
  * Reads temperature and pressure values from the BMP280,
  * then calculate the altitude from them.
@@ -267,10 +333,7 @@ int8_t BMP280_ReadPressure(BMP280 *BMP_data) {
  */
 int8_t BMP280_ReadAltitude(BMP280 *BMP_data) {
 	// Update values
-	if (BMP280_ReadTemperature(BMP_data) != 0) {
-		return -1; // Error
-	}
-	if (BMP280_ReadPressure(BMP_data) != 0) {
+	if (BMP280_ReadMeasurement(BMP_data) != 0) {
 		return -1; // Error
 	}
 
@@ -294,6 +357,31 @@ float BMP280_PressureToAltitude(float pressure, float pressure_ref) {
     return 44330 * (1.0 - pow(pressure / pressure_ref, 0.1903));
 }
 
+/**
+ * Altitude of the last measurement (press_Pa_Q8), BMP280_PressureToAltitude interpolated in a
+ * table, for every barometer sample in flight. Two 32x32 bit multiplications and no float,
+ * error below 0.1 m to 7.5 km, extrapolated above (and below the reference pressure).
+ *
+ * @param BMP_data: pointer to a BMP280 structure (reference set by BMP280_SetReference).
+ *
+ * @return Altitude in millimeters
+ */
+int32_t BMP280_LinearAltitudeMm(const BMP280 *BMP_data) {
+	// Pressure ratio in Q24 (1 - ratio, 0 at the reference pressure)
+	int32_t ratio = (int32_t)(((uint64_t)BMP_data->press_Pa_Q8 * BMP_data->press_ref_inv) >> 32);
+	int32_t x = (1 << 24) - ratio;
+
+	int32_t i = x >> (24 - BMP280_ALT_TABLE_SHIFT);
+	if (i < 0) {
+		i = 0;
+	} else if (i > BMP280_ALT_TABLE_SIZE - 2) {
+		i = BMP280_ALT_TABLE_SIZE - 2;
+	}
+	int32_t fraction = x - (i << (24 - BMP280_ALT_TABLE_SHIFT));
+	int32_t step = BMP280_ALT_TABLE_MM[i + 1] - BMP280_ALT_TABLE_MM[i];
+	return BMP280_ALT_TABLE_MM[i] + (int32_t)(((int64_t)step * fraction) >> (24 - BMP280_ALT_TABLE_SHIFT));
+}
+
 /**
  * Soft reset BMP280
  * "The device is reset using the complete power-on-reset procedure"
@@ -312,60 +400,56 @@ int8_t BMP280_SoftReset() {
 }
 
 /**
- * Read BMP280 register using GPIO and SPI2 HAL functions
+ * Read BMP280 register in a session on the SPI2 bus (waits for the transfer in progress)
  *
  * @param reg: u8bit register address to read.
  * @param RX_Buffer: u8bit array to store X bytes of data.
  * @param size: Number of bytes to read.
  *
  * @retval 0 OK
- * @retval -1 SPI ERROR
+ * @retval -1 SPI ERROR (bus busy or not initialized)
  */
 int8_t BMP280_Read(uint8_t reg, uint8_t RX_Buffer[], uint8_t size) {
-    // Enable SPI communication with BMP280 by setting BMP280's Chip Select (CS) pin to LOW.
-    HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_RESET);
+    // Select the BMP280 (Chip Select LOW) at its clock
+    if (BMP_device < 0 || SPIBUS_Select(BMP_device) != 0) {
+    	return -1; // SPI ERROR
+    }
 
     // Transmit Control byte (Read mode + Register address)
     reg |= 0x80; // Read mode
-    if (HAL_SPI_Transmit(BMP_hspi, &reg, 1, BMP280_SPI_TIMEOUT) != HAL_OK) {
-    	return -1; // SPI ERROR
-    }
+    SPIBUS_Transmit(&reg, 1);
 
     // Receive Data byte
-    if (HAL_SPI_Receive(BMP_hspi, RX_Buffer, size, BMP280_SPI_TIMEOUT) != HAL_OK) {
-    	return -1; // SPI ERROR
-    }
+    SPIBUS_Receive(RX_Buffer, size);
 
-    // Disable SPI communication with BMP280 by setting BMP280's Chip Select (CS) pin to HIGH.
-    HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_SET);
+    // Chip Select HIGH, the bus goes to the next transaction
+    SPIBUS_Deselect(BMP_device);
 
     return 0; // OK
 }
 
 /**
- * Write to a BMP280 register using GPIO and SPI2 HAL functions
+ * Write to a BMP280 register in a session on the SPI2 bus
  *
  * @param reg: u8bit register address to write.
  * @param data: u8bit data to write.
  *
  * @retval 0 OK
- * @retval -1 SPI ERROR
+ * @retval -1 SPI ERROR (bus busy or not initialized)
  */
 int8_t BMP280_Write(uint8_t reg, uint8_t data) {
-    // BMP_CS LOW
-    HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_RESET);
+    if (BMP_device < 0 || SPIBUS_Select(BMP_device) != 0) {
+    	return -1; // SPI ERROR
+    }
 
     // Control byte (Write mode + Register address)
     reg &= ~0x80; // Write mode
 
     // Transmit Control byte and Data byte
     uint8_t TX_Buffer[2] = { reg, data };
-    if (HAL_SPI_Transmit(BMP_hspi, TX_Buffer, 2, BMP280_SPI_TIMEOUT) != HAL_OK) {
-    	return -1; // SPI ERROR
-    }
+    SPIBUS_Transmit(TX_Buffer, 2);
 
-    // BMP_CS HIGH
-    HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_SET);
+    SPIBUS_Deselect(BMP_device);
 
     return 0; // OK
 }
@@ -0,0 +1,148 @@
+/*
+ * DMASHARE.c
+ *
+ * Each user keeps its own DMA handle (direction, increment, priority) on the same channel.
+ * The channel registers are only valid for the handle initialized last: the channel is
+ * reinitialized (HAL_DMA_Init, the channel is disabled between transfers) when the other
+ * user acquires it, and the channel interrupt is given to the handle of the owner only
+ * (the transfer complete flag is common to both handles).
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/DMASHARE.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static DMA_HandleTypeDef *DMASHARE_handles[DMASHARE_USERS];
+static DMASHARE_Resume DMASHARE_resumes[DMASHARE_USERS];
+static uint8_t DMASHARE_waiting[DMASHARE_USERS]; // Refused, resume at the release
+static volatile uint8_t DMASHARE_owner = DMASHARE_NONE;
+static uint8_t DMASHARE_configured = DMASHARE_NONE; // Handle the channel is initialized for
+static DMASHARE_Stats DMASHARE_stats;
+
+/**
+ * Forget the users and free the channel.
+ */
+void DMASHARE_Init() {
+	memset(DMASHARE_handles, 0, sizeof(DMASHARE_handles));
+	memset(DMASHARE_resumes, 0, sizeof(DMASHARE_resumes));
+	memset(DMASHARE_waiting, 0, sizeof(DMASHARE_waiting));
+	DMASHARE_owner = DMASHARE_NONE;
+	DMASHARE_configured = DMASHARE_NONE;
+	memset(&DMASHARE_stats, 0, sizeof(DMASHARE_stats));
+}
+
+/**
+ * Share the channel with a user. The handle must be filled (Instance and Init) and linked
+ * to its peripheral, HAL_DMA_Init is called by DMASHARE_Acquire.
+ *
+ * @param user: DMASHARE_USER_x.
+ * @param hdma: DMA handle of the user.
+ * @param resume: called when the channel is free again after a refusal, NULL: none.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, invalid parameter
+ */
+int8_t DMASHARE_Register(uint8_t user, DMA_HandleTypeDef *hdma, DMASHARE_Resume resume) {
+	if (user >= DMASHARE_USERS || hdma == NULL) {
+		return -1; // Error
+	}
+	DMASHARE_handles[user] = hdma;
+	DMASHARE_resumes[user] = resume;
+	return 0; // OK
+}
+
+/**
+ * Take the channel before starting a transfer.
+ *
+ * @param user: DMASHARE_USER_x.
+ *
+ * @retval 0 OK, the channel is initialized for the user (or the user is not registered)
+ * @retval -1 ERROR, HAL_DMA_Init
+ * @retval -2 BUSY, the other user has the channel, resumed at its release
+ */
+int8_t DMASHARE_Acquire(uint8_t user) {
+	if (user >= DMASHARE_USERS || DMASHARE_handles[user] == NULL) {
+		return 0; // Channel not shared
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (DMASHARE_owner != DMASHARE_NONE && DMASHARE_owner != user) {
+		DMASHARE_waiting[user] = 1;
+		DMASHARE_stats.refused[user]++;
+		__set_PRIMASK(primask);
+		return -2; // Busy
+	}
+	if (DMASHARE_configured != user) {
+		if (HAL_DMA_Init(DMASHARE_handles[user]) != HAL_OK) {
+			DMASHARE_configured = DMASHARE_NONE;
+			__set_PRIMASK(primask);
+			return -1; // Error
+		}
+		DMASHARE_configured = user;
+		DMASHARE_stats.switches++;
+	}
+	DMASHARE_owner = user;
+	DMASHARE_waiting[user] = 0;
+	DMASHARE_stats.acquired[user]++;
+
+	__set_PRIMASK(primask);
+	return 0; // OK
+}
+
+/**
+ * Free the channel at the end of a transfer (or when the transfer could not start), and
+ * resume the other user if it was refused.
+ *
+ * @param user: DMASHARE_USER_x, ignored if it does not have the channel.
+ */
+void DMASHARE_Release(uint8_t user) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (user >= DMASHARE_USERS || DMASHARE_owner != user) {
+		__set_PRIMASK(primask);
+		return;
+	}
+	DMASHARE_owner = DMASHARE_NONE;
+
+	DMASHARE_Resume resume = NULL;
+	for (uint8_t other = 0; other < DMASHARE_USERS && resume == NULL; other++) {
+		if (other != user && DMASHARE_waiting[other]) {
+			DMASHARE_waiting[other] = 0;
+			resume = DMASHARE_resumes[other];
+		}
+	}
+
+	__set_PRIMASK(primask);
+
+	// The other user takes the channel before the releasing user can start a new transfer
+	if (resume != NULL) {
+		resume();
+	}
+}
+
+/**
+ * Channel interrupt, call from DMA1_Channel4_IRQHandler instead of HAL_DMA_IRQHandler.
+ */
+void DMASHARE_IRQHandler() {
+	if (DMASHARE_configured != DMASHARE_NONE) {
+		HAL_DMA_IRQHandler(DMASHARE_handles[DMASHARE_configured]);
+	}
+}
+
+/**
+ * @return DMASHARE_USER_x having the channel, DMASHARE_NONE if free
+ */
+uint8_t DMASHARE_Owner() {
+	return DMASHARE_owner;
+}
+
+const DMASHARE_Stats *DMASHARE_GetStats() {
+	return &DMASHARE_stats;
+}
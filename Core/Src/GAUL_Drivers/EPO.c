@@ -0,0 +1,421 @@
+/*
+ * EPO.c
+ *
+ * Upload of an EPO file to the L76, paced by its acknowledges.
+ *
+ * PMTK127 clears the EPO stored in the module, then every record of the file is sent in its
+ * own "$PMTK721" sentence and the next one is formatted and queued (L76LM33_Transfer) by the
+ * acknowledge of the previous one, in the USART2 interrupt: one record in flight, the
+ * module writes it to its flash before acknowledging. "$PMTK721,00" ends the upload. A record
+ * not acknowledged after the retries of the command engine pauses the upload for
+ * EPO_RESUME_MS, EPO_Poll sends it again (the EPO stored so far is kept).
+ *
+ * From the ground link, the bytes received by the RFD900 interrupt (EPO_Receive) go to a
+ * ring buffer. EPO_Poll finds the chunks in it (sync "EP", CRC) and keeps the next record
+ * needed, the others are skipped: the ground tool sends the whole file again until every
+ * record went through. The record after the one in flight is taken while the module writes.
+ *
+ * LG76 Series GNSS Protocol Specification (EPO):
+ * "$PMTK127*36" clear the EPO data stored in the module
+ * "$PMTK721,SV,W0,...,W17*CS" one EPO record (72 bytes: 18 words, hexadecimal, little
+ * endian words of the file), SV 1 to 32. Acknowledged by "$PMTK001,721,3".
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/EPO.h"
+
+#include "GAUL_System/PACKET.h"
+
+#include <string.h>
+
+#define EPO_CMD_CLEAR  "PMTK127"
+#define EPO_CMD_END    "PMTK721,00"
+#define EPO_WORDS      (EPO_RECORD_SIZE / 4)
+#define EPO_NONE       0xFFFF
+
+// Step in progress (sent again after a failure)
+#define EPO_STEP_CLEAR  0
+#define EPO_STEP_RECORD 1
+#define EPO_STEP_END    2
+
+static EPO_Port EPO_port;
+static EPO_Stats EPO_stats;
+static volatile uint8_t EPO_state = EPO_IDLE;
+static uint8_t EPO_step = EPO_STEP_CLEAR;
+static volatile uint8_t EPO_in_flight = 0;  // Command queued, "done" not called yet
+static uint8_t EPO_failures = 0;            // Failed in a row
+static uint32_t EPO_paused_ms;
+
+// File
+static const uint8_t *EPO_file = NULL;      // Memory source, NULL: ground link
+static uint16_t EPO_records = 0;
+static volatile uint16_t EPO_sent = 0;      // Records acknowledged, next record to send
+
+// Sentence of the record being sent (kept until acknowledged, sent again after a failure)
+static char EPO_sentence[EPO_SENTENCE_SIZE];
+static uint16_t EPO_sentence_size = 0;
+static uint16_t EPO_sentence_record = EPO_NONE;
+
+// Ground link: receive ring (RFD900 interrupt to EPO_Poll) and next record needed
+static uint8_t EPO_ring[EPO_LINK_BUFFER];
+static volatile uint16_t EPO_ring_head = 0;  // Free running, written by EPO_Receive
+static volatile uint16_t EPO_ring_tail = 0;  // Free running, written by EPO_Poll
+static uint8_t EPO_record[EPO_RECORD_SIZE];
+static uint16_t EPO_record_index = EPO_NONE; // Record in EPO_record, EPO_NONE: free
+
+static const char EPO_HEX[] = "0123456789ABCDEF";
+
+static void EPO_Next();
+
+static uint32_t EPO_TickHAL() {
+	return HAL_GetTick();
+}
+
+/**
+ * Format "$PMTK721,SV,W0,...,W17*CS\r\n" without printf (called from the interrupt).
+ */
+static void EPO_Format(uint16_t index, const uint8_t *data) {
+	char *p = EPO_sentence;
+	uint8_t sv = (uint8_t)(index % EPO_SET_RECORDS + 1);
+
+	memcpy(p, "$PMTK721,", 9);
+	p += 9;
+	*p++ = EPO_HEX[sv >> 4];
+	*p++ = EPO_HEX[sv & 0x0F];
+	for (uint8_t i = 0; i < EPO_WORDS; i++) {
+		uint32_t word = (uint32_t)data[4 * i] | (uint32_t)data[4 * i + 1] << 8
+				| (uint32_t)data[4 * i + 2] << 16 | (uint32_t)data[4 * i + 3] << 24;
+		*p++ = ',';
+		for (int8_t shift = 28; shift >= 0; shift -= 4) {
+			*p++ = EPO_HEX[(word >> shift) & 0x0F];
+		}
+	}
+
+	uint8_t checksum = 0;
+	for (const char *c = EPO_sentence + 1; c < p; c++) {
+		checksum ^= (uint8_t)*c;
+	}
+	*p++ = '*';
+	*p++ = EPO_HEX[checksum >> 4];
+	*p++ = EPO_HEX[checksum & 0x0F];
+	*p++ = '\r';
+	*p++ = '\n';
+
+	EPO_sentence_size = (uint16_t)(p - EPO_sentence);
+	EPO_sentence_record = index;
+}
+
+/**
+ * Acknowledge (or failure) of the step in progress, called by the command engine (USART2
+ * interrupt, or L76LM33_Poll for a timeout). Queues the next step.
+ */
+static void EPO_Done(uint16_t command, int8_t result) {
+	(void)command;
+	EPO_in_flight = 0;
+	if (EPO_state == EPO_IDLE) {
+		return; // Aborted
+	}
+
+	if (result != 0) {
+		EPO_stats.failures++;
+		if (++EPO_failures >= EPO_MAX_FAILURES) {
+			EPO_state = EPO_FAILED;
+		} else {
+			EPO_paused_ms = EPO_port.tick();
+			EPO_state = EPO_PAUSED;
+		}
+		return;
+	}
+	EPO_failures = 0;
+
+	if (EPO_step == EPO_STEP_CLEAR) {
+		EPO_step = EPO_STEP_RECORD;
+	} else if (EPO_step == EPO_STEP_RECORD) {
+		EPO_sent++;
+		EPO_stats.sent = EPO_sent;
+	} else {
+		EPO_stats.end_ms = EPO_port.tick();
+		EPO_state = EPO_DONE;
+		return;
+	}
+	EPO_Next();
+}
+
+/**
+ * Record of the file, NULL when not received yet (ground link).
+ */
+static const uint8_t *EPO_Data(uint16_t index) {
+	if (EPO_file != NULL) {
+		return EPO_file + (uint32_t)index * EPO_RECORD_SIZE;
+	}
+	if (EPO_record_index == index) {
+		EPO_record_index = EPO_NONE; // Free once formatted, the next record can be taken
+		return EPO_record;
+	}
+	return NULL;
+}
+
+/**
+ * Queue the step in progress. Interrupts disabled, or from EPO_Done.
+ */
+static void EPO_Next() {
+	int8_t status;
+
+	// In flight before queueing: "done" may be called before the queueing returns
+	EPO_in_flight = 1;
+	if (EPO_step == EPO_STEP_CLEAR) {
+		EPO_state = EPO_CLEARING;
+		status = EPO_port.command(EPO_CMD_CLEAR, EPO_CLEAR_TIMEOUT_MS, L76LM33_RETRIES, EPO_Done);
+	} else if (EPO_sent < EPO_records) {
+		EPO_step = EPO_STEP_RECORD;
+		if (EPO_sentence_record != EPO_sent) {
+			const uint8_t *data = EPO_Data(EPO_sent);
+			if (data == NULL) {
+				EPO_in_flight = 0;
+				EPO_state = EPO_WAITING; // Not received yet
+				return;
+			}
+			EPO_Format(EPO_sent, data);
+		}
+		EPO_state = EPO_SENDING;
+		status = EPO_port.transfer(EPO_sentence, EPO_sentence_size, EPO_ACK_TIMEOUT_MS, L76LM33_RETRIES, EPO_Done);
+	} else {
+		EPO_step = EPO_STEP_END;
+		EPO_state = EPO_ENDING;
+		status = EPO_port.command(EPO_CMD_END, EPO_ACK_TIMEOUT_MS, L76LM33_RETRIES, EPO_Done);
+	}
+
+	if (status != 0) {
+		EPO_in_flight = 0;
+		EPO_state = status == -2 ? EPO_WAITING : EPO_FAILED; // Queue full: EPO_Poll queues it again
+	}
+}
+
+/**
+ * Start of an upload. Interrupts disabled.
+ */
+static void EPO_Begin(uint16_t records) {
+	uint32_t chunks = EPO_stats.chunks;
+	uint32_t crc_errors = EPO_stats.crc_errors;
+	uint32_t skipped = EPO_stats.skipped;
+	uint32_t overflows = EPO_stats.overflows;
+	memset(&EPO_stats, 0, sizeof(EPO_stats));
+	EPO_stats.chunks = chunks; // Kept from the listening
+	EPO_stats.crc_errors = crc_errors;
+	EPO_stats.skipped = skipped;
+	EPO_stats.overflows = overflows;
+
+	EPO_records = records;
+	EPO_stats.records = records;
+	EPO_sent = 0;
+	EPO_step = EPO_STEP_CLEAR;
+	EPO_failures = 0;
+	EPO_sentence_record = EPO_NONE;
+	EPO_stats.start_ms = EPO_port.tick();
+	EPO_Next();
+}
+
+/**
+ * @return 1 if the number of records is a whole file
+ */
+static uint8_t EPO_ValidCount(uint32_t records) {
+	return records != 0 && records <= EPO_MAX_RECORDS && records % EPO_SET_RECORDS == 0;
+}
+
+/**
+ * Chunks of the ground link in the receive ring: the first one (index 0) starts the upload,
+ * then only the record needed next is kept.
+ */
+static void EPO_Parse() {
+	uint8_t chunk[EPO_LINK_CHUNK];
+
+	while (1) {
+		uint16_t tail = EPO_ring_tail;
+		uint16_t available = (uint16_t)(EPO_ring_head - tail);
+
+		// Sync
+		if (available < 2) {
+			return;
+		}
+		if (EPO_ring[tail % EPO_LINK_BUFFER] != EPO_LINK_SYNC0 || EPO_ring[(tail + 1) % EPO_LINK_BUFFER] != EPO_LINK_SYNC1) {
+			EPO_ring_tail = tail + 1;
+			continue;
+		}
+		if (available < EPO_LINK_CHUNK) {
+			return;
+		}
+
+		for (uint16_t i = 0; i < EPO_LINK_CHUNK; i++) {
+			chunk[i] = EPO_ring[(uint16_t)(tail + i) % EPO_LINK_BUFFER];
+		}
+		uint16_t crc = (uint16_t)chunk[EPO_LINK_CHUNK - 2] | (uint16_t)chunk[EPO_LINK_CHUNK - 1] << 8;
+		if (PACKET_CRC16(chunk + 2, EPO_LINK_CHUNK - 4) != crc) {
+			EPO_stats.crc_errors++;
+			EPO_ring_tail = tail + 1; // Sync again after the false "EP"
+			continue;
+		}
+		EPO_ring_tail = tail + EPO_LINK_CHUNK;
+		EPO_stats.chunks++;
+
+		uint16_t index = (uint16_t)chunk[2] | (uint16_t)chunk[3] << 8;
+		uint16_t count = (uint16_t)chunk[4] | (uint16_t)chunk[5] << 8;
+		const uint8_t *data = chunk + EPO_LINK_HEADER;
+
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		if (EPO_state == EPO_LISTENING) {
+			if (index == 0 && EPO_ValidCount(count)) {
+				memcpy(EPO_record, data, EPO_RECORD_SIZE);
+				EPO_record_index = 0;
+				EPO_Begin(count);
+			} else {
+				EPO_stats.skipped++;
+			}
+		} else if (EPO_state != EPO_IDLE && EPO_state != EPO_DONE && EPO_state != EPO_FAILED
+				&& EPO_file == NULL && count == EPO_records && EPO_record_index == EPO_NONE
+				&& index == (EPO_sentence_record == EPO_sent ? EPO_sent + 1 : EPO_sent)) {
+			memcpy(EPO_record, data, EPO_RECORD_SIZE);
+			EPO_record_index = index;
+			if (EPO_state == EPO_WAITING) {
+				EPO_Next();
+			}
+		} else {
+			EPO_stats.skipped++;
+		}
+		__set_PRIMASK(primask);
+	}
+}
+
+/**
+ * Initialize the uploader.
+ *
+ * @param port: module access, NULL: L76LM33 (initialized with its command engine).
+ */
+void EPO_Init(const EPO_Port *port) {
+	if (port != NULL) {
+		EPO_port = *port;
+	} else {
+		EPO_port.command = L76LM33_Command;
+		EPO_port.transfer = L76LM33_Transfer;
+		EPO_port.tick = EPO_TickHAL;
+	}
+	EPO_state = EPO_IDLE;
+	EPO_in_flight = 0;
+	EPO_file = NULL;
+	EPO_records = 0;
+	EPO_sent = 0;
+	EPO_sentence_record = EPO_NONE;
+	EPO_record_index = EPO_NONE;
+	EPO_ring_head = 0;
+	EPO_ring_tail = 0;
+	memset(&EPO_stats, 0, sizeof(EPO_stats));
+}
+
+/**
+ * Upload an EPO file in memory (kept until the end), returns immediately.
+ *
+ * @param file: EPO file (sets of EPO_SET_RECORDS records of EPO_RECORD_SIZE bytes).
+ * @param size: bytes.
+ *
+ * @retval 0 OK, started
+ * @retval -1 ERROR, not a whole file
+ * @retval -2 BUSY, upload in progress or aborted command not done yet
+ */
+int8_t EPO_StartMemory(const uint8_t *file, uint32_t size) {
+	if (file == NULL || size % EPO_RECORD_SIZE != 0 || !EPO_ValidCount(size / EPO_RECORD_SIZE)) {
+		return -1; // Error
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (EPO_in_flight || (EPO_state != EPO_IDLE && EPO_state != EPO_DONE && EPO_state != EPO_FAILED)) {
+		__set_PRIMASK(primask);
+		return -2; // Busy
+	}
+	EPO_file = file;
+	EPO_Begin((uint16_t)(size / EPO_RECORD_SIZE));
+	__set_PRIMASK(primask);
+
+	return 0; // OK
+}
+
+/**
+ * Wait for an EPO file from the ground link (EPO_Receive), the upload starts with its first
+ * chunk.
+ *
+ * @retval 0 OK, listening
+ * @retval -2 BUSY, upload in progress or aborted command not done yet
+ */
+int8_t EPO_StartLink() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (EPO_in_flight || (EPO_state != EPO_IDLE && EPO_state != EPO_DONE && EPO_state != EPO_FAILED)) {
+		__set_PRIMASK(primask);
+		return -2; // Busy
+	}
+	EPO_file = NULL;
+	EPO_record_index = EPO_NONE;
+	EPO_ring_tail = EPO_ring_head;
+	EPO_state = EPO_LISTENING;
+	__set_PRIMASK(primask);
+
+	return 0; // OK
+}
+
+/**
+ * Byte from the ground link, call from the receive interrupt (RFD900_StartReceive). Ignored
+ * when no upload from the link is in progress.
+ */
+void EPO_Receive(uint8_t byte) {
+	uint8_t state = EPO_state;
+	if (state == EPO_IDLE || state == EPO_DONE || state == EPO_FAILED || EPO_file != NULL) {
+		return;
+	}
+	uint16_t head = EPO_ring_head;
+	if ((uint16_t)(head - EPO_ring_tail) >= EPO_LINK_BUFFER) {
+		EPO_stats.overflows++; // The ground sends it again
+		return;
+	}
+	EPO_ring[head % EPO_LINK_BUFFER] = byte;
+	EPO_ring_head = head + 1;
+}
+
+/**
+ * Chunks received from the ground link, and upload resumed after a pause (failed record)
+ * or a full command queue. Call from the main loop.
+ */
+void EPO_Poll() {
+	EPO_Parse();
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (EPO_state == EPO_PAUSED && EPO_port.tick() - EPO_paused_ms >= EPO_RESUME_MS) {
+		EPO_stats.resumes++;
+		EPO_Next();
+	} else if (EPO_state == EPO_WAITING && !EPO_in_flight) {
+		EPO_Next();
+	}
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Stop the upload (leaving the pad): the step in progress ends, nothing is queued after it.
+ * The EPO sent so far stays in the module, without its end (see PMTK607).
+ */
+void EPO_Abort() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	EPO_state = EPO_IDLE;
+	EPO_record_index = EPO_NONE;
+	__set_PRIMASK(primask);
+}
+
+uint8_t EPO_GetState() {
+	return EPO_state;
+}
+
+const EPO_Stats *EPO_GetStats() {
+	return &EPO_stats;
+}
@@ -0,0 +1,523 @@
+/*
+ * GNSSAID.c
+ *
+ * Warm start of the L76 from the last fix kept in flash.
+ *
+ * GNSSAID_Init finds the last valid record of the page (records are appended, a record with
+ * a wrong CRC is skipped) and compacts a full page: erased, the last record written back
+ * first, before the flight is armed. GNSSAID_Start, after
+ * L76LM33_Init, queues PMTK740 with the UTC time of the RTC and PMTK741 with the position
+ * of the record, then PMTK607: the "$PMTK707" reply (GNSSAID_Reply) gives the EPO window
+ * stored in the module. GNSSAID_Update takes every fix: first fix (TTFF), RTC set from the
+ * fix, record saved when allowed: erasing the page stalls the CPU 20 to 40 ms, only after
+ * the landing; on the pad a record is only programmed (~1 ms), while the launch detector is
+ * idle, and a full page waits for the next boot.
+ *
+ * LG76 Series GNSS Protocol Specification:
+ * "$PMTK740,YYYY,MM,DD,hh,mm,ss*CS" UTC time
+ * "$PMTK741,Lat,Long,Alt,YYYY,MM,DD,hh,mm,ss*CS" Position (degrees, m) at this UTC time
+ * "$PMTK607*33" EPO query, reply "$PMTK707,Set,FWN,FTOW,LWN,LTOW,FCWN,FCTOW,LCWN,LCTOW*CS":
+ * sets stored, GPS week and time of week of the first and of the last set.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/GNSSAID.h"
+
+#include "GAUL_System/PACKET.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GNSSAID_CRC_OFFSET  (GNSSAID_RECORD_SIZE - 2)
+#define GNSSAID_BKP_MAGIC   0x6A1D // BKP->DR1: RTC counter is the UTC time (set from a fix)
+#define GNSSAID_RTC_WAIT_MS 2      // RTC register synchronisation (3 LSE cycles)
+
+#define GNSSAID_CMD_TIME     "PMTK740,%u,%02u,%02u,%02lu,%02lu,%02lu"
+#define GNSSAID_CMD_POSITION "PMTK741,%s,%s,%d,%u,%02u,%02u,%02lu,%02lu,%02lu"
+#define GNSSAID_CMD_EPO      "PMTK607"
+
+static GNSSAID_Port GNSSAID_port;
+static GNSSAID_Stats GNSSAID_stats;
+static GNSSAID_Record GNSSAID_last;     // Last record in the page (magic 0: none)
+static uint8_t GNSSAID_next = 0;        // Next free record, GNSSAID_RECORDS: page full
+static uint32_t GNSSAID_start_ms;       // PMTK607 sent
+static uint32_t GNSSAID_saved_s;        // UTC of the last record saved since boot, 0: none
+static uint32_t GNSSAID_fix_s;          // UTC of the last fix
+static uint8_t GNSSAID_fixed = 0;       // 1: first fix seen
+
+static const uint16_t GNSSAID_DAYS_BEFORE[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+
+/**
+ * Flash page erase (HAL), the CPU stalls 20 to 40 ms (code runs from the same flash).
+ */
+static int8_t GNSSAID_EraseHAL(const uint8_t *page) {
+	FLASH_EraseInitTypeDef erase = {
+		.TypeErase = FLASH_TYPEERASE_PAGES,
+		.PageAddress = (uint32_t)(uintptr_t)page,
+		.NbPages = 1,
+	};
+	uint32_t error = 0;
+	HAL_FLASH_Unlock();
+	HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &error);
+	HAL_FLASH_Lock();
+	return status == HAL_OK ? 0 : -1;
+}
+
+/**
+ * Flash programming (HAL), ~50 us per half-word.
+ */
+static int8_t GNSSAID_ProgramHAL(const uint8_t *address, const uint16_t *data, uint16_t count) {
+	HAL_StatusTypeDef status = HAL_OK;
+	HAL_FLASH_Unlock();
+	for (uint16_t i = 0; i < count && status == HAL_OK; i++) {
+		status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, (uint32_t)(uintptr_t)address + 2 * i, data[i]);
+	}
+	HAL_FLASH_Lock();
+	return status == HAL_OK ? 0 : -1;
+}
+
+/**
+ * Wait for the end of a write in the RTC registers (RTOFF).
+ *
+ * @retval 0 OK
+ * @retval -3 TIMEOUT
+ */
+static int8_t GNSSAID_WaitRTC() {
+	uint32_t start_ms = HAL_GetTick();
+	while ((RTC->CRL & RTC_CRL_RTOFF) == 0) {
+		if (HAL_GetTick() - start_ms > GNSSAID_RTC_WAIT_MS) {
+			return -3;
+		}
+	}
+	return 0;
+}
+
+/**
+ * UTC time of the RTC counter, kept by the backup domain when the RTC runs on the LSE and
+ * was set from a fix. Starts the LSE otherwise (ready ~1 s later, at the first fix).
+ */
+static int8_t GNSSAID_GetTimeHAL(uint32_t *utc_s) {
+	__HAL_RCC_PWR_CLK_ENABLE();
+	__HAL_RCC_BKP_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+
+	uint32_t bdcr = RCC->BDCR;
+	if ((bdcr & RCC_BDCR_RTCEN) == 0 || (bdcr & RCC_BDCR_LSERDY) == 0
+			|| (bdcr & RCC_BDCR_RTCSEL) != RCC_BDCR_RTCSEL_LSE || (BKP->DR1 & 0xFFFF) != GNSSAID_BKP_MAGIC) {
+		RCC->BDCR |= RCC_BDCR_LSEON; // No effect without a 32.768 kHz crystal
+		return -1; // Time lost (no VBAT, or never set)
+	}
+
+	// Registers synchronised with the RTC clock after the reset
+	RTC->CRL &= ~RTC_CRL_RSF;
+	uint32_t start_ms = HAL_GetTick();
+	while ((RTC->CRL & RTC_CRL_RSF) == 0) {
+		if (HAL_GetTick() - start_ms > GNSSAID_RTC_WAIT_MS) {
+			return -1; // LSE stopped
+		}
+	}
+	uint16_t high = RTC->CNTH;
+	uint16_t low = RTC->CNTL;
+	if (RTC->CNTH != high) { // Carry between the reads
+		high = RTC->CNTH;
+		low = RTC->CNTL;
+	}
+	*utc_s = (uint32_t)high << 16 | low;
+	return 0;
+}
+
+/**
+ * Set the RTC counter (1 Hz from the LSE) to the UTC time. Nothing when the LSE does not
+ * run (no crystal): the time is lost at the power cycle.
+ */
+static void GNSSAID_SetTimeHAL(uint32_t utc_s) {
+	__HAL_RCC_PWR_CLK_ENABLE();
+	__HAL_RCC_BKP_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+
+	uint32_t bdcr = RCC->BDCR;
+	if ((bdcr & RCC_BDCR_LSERDY) == 0) {
+		RCC->BDCR |= RCC_BDCR_LSEON;
+		return; // Not started yet, or no crystal
+	}
+	if ((bdcr & RCC_BDCR_RTCSEL) == 0) {
+		RCC->BDCR |= RCC_BDCR_RTCSEL_LSE; // Once until the backup domain is lost
+	} else if ((bdcr & RCC_BDCR_RTCSEL) != RCC_BDCR_RTCSEL_LSE) {
+		return; // Another clock, kept
+	}
+	RCC->BDCR |= RCC_BDCR_RTCEN;
+
+	if (GNSSAID_WaitRTC() != 0) {
+		return;
+	}
+	RTC->CRL |= RTC_CRL_CNF;
+	RTC->PRLH = 0;
+	RTC->PRLL = 32767; // 1 Hz
+	RTC->CNTH = utc_s >> 16;
+	RTC->CNTL = utc_s & 0xFFFF;
+	RTC->CRL &= ~RTC_CRL_CNF;
+	if (GNSSAID_WaitRTC() == 0) {
+		BKP->DR1 = GNSSAID_BKP_MAGIC;
+	}
+}
+
+/**
+ * @retval 1 every byte of the record erased (0xFF)
+ */
+static uint8_t GNSSAID_IsErased(const uint8_t *record) {
+	for (uint8_t i = 0; i < GNSSAID_RECORD_SIZE; i++) {
+		if (record[i] != 0xFF) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Find the last valid record and the next free one. A record is never written after an
+ * erased one: the first erased record ends the page.
+ */
+static void GNSSAID_Load() {
+	memset(&GNSSAID_last, 0, sizeof(GNSSAID_last));
+	GNSSAID_next = GNSSAID_RECORDS;
+	for (uint8_t i = 0; i < GNSSAID_RECORDS; i++) {
+		const uint8_t *record = GNSSAID_port.page + i * GNSSAID_RECORD_SIZE;
+		if (GNSSAID_IsErased(record)) {
+			GNSSAID_next = i;
+			break;
+		}
+		GNSSAID_Record candidate;
+		memcpy(&candidate, record, sizeof(candidate));
+		if (candidate.magic == GNSSAID_MAGIC && PACKET_CRC16(record, GNSSAID_CRC_OFFSET) == candidate.crc) {
+			GNSSAID_last = candidate;
+		}
+	}
+}
+
+/**
+ * Erase the page, the CPU stalls 20 to 40 ms.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, flash erase failed
+ */
+static int8_t GNSSAID_Erase() {
+	GNSSAID_stats.erases++;
+	if (GNSSAID_port.erase(GNSSAID_port.page) != 0) {
+		GNSSAID_stats.errors++;
+		return -1;
+	}
+	GNSSAID_next = 0;
+	return 0;
+}
+
+/**
+ * Append a record, erasing the page when it is full.
+ *
+ * @param record: record to append.
+ * @param erase: 1: the page may be erased (CPU stalled 20 to 40 ms).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, flash erase or program failed (or read back wrong)
+ * @retval -2 OK, page full and not erased
+ */
+static int8_t GNSSAID_Save(const GNSSAID_Record *record, uint8_t erase) {
+	if (GNSSAID_next >= GNSSAID_RECORDS) {
+		if (!erase) {
+			return -2;
+		}
+		if (GNSSAID_Erase() != 0) {
+			return -1;
+		}
+	}
+
+	const uint8_t *address = GNSSAID_port.page + GNSSAID_next * GNSSAID_RECORD_SIZE;
+	uint16_t data[GNSSAID_RECORD_SIZE / 2];
+	memcpy(data, record, sizeof(data));
+	GNSSAID_next++; // Used even if not programmed completely
+	if (GNSSAID_port.program(address, data, GNSSAID_RECORD_SIZE / 2) != 0
+			|| memcmp(address, data, GNSSAID_RECORD_SIZE) != 0) {
+		GNSSAID_stats.errors++;
+		return -1;
+	}
+
+	GNSSAID_last = *record;
+	GNSSAID_stats.saves++;
+	return 0;
+}
+
+/**
+ * Initialize the module and read the last record. Call before L76LM33_Init (not needed by
+ * it) or after, GNSSAID_Start gives it to the module.
+ *
+ * @param port: flash, RTC and module access, NULL: HAL.
+ *
+ * @retval 0 OK, record found
+ * @retval -2 OK, no record (first boot, or page erased)
+ */
+int8_t GNSSAID_Init(const GNSSAID_Port *port) {
+	if (port != NULL) {
+		GNSSAID_port = *port;
+	} else {
+		GNSSAID_port = (GNSSAID_Port) {
+			.page = (const uint8_t *)GNSSAID_PAGE_ADDRESS,
+			.erase = GNSSAID_EraseHAL,
+			.program = GNSSAID_ProgramHAL,
+			.get_time = GNSSAID_GetTimeHAL,
+			.set_time = GNSSAID_SetTimeHAL,
+			.command = L76LM33_Command,
+			.tick = HAL_GetTick,
+		};
+	}
+	memset(&GNSSAID_stats, 0, sizeof(GNSSAID_stats));
+	GNSSAID_saved_s = 0;
+	GNSSAID_fix_s = 0;
+	GNSSAID_fixed = 0;
+
+	GNSSAID_Load();
+	GNSSAID_stats.loaded = GNSSAID_last.magic == GNSSAID_MAGIC;
+	GNSSAID_stats.previous = GNSSAID_last;
+
+	// Full page: erased now, before the flight is armed (the pad only programs), last record kept
+	if (GNSSAID_next >= GNSSAID_RECORDS && GNSSAID_Erase() == 0 && GNSSAID_stats.loaded) {
+		GNSSAID_Save(&GNSSAID_stats.previous, 0);
+	}
+	return GNSSAID_stats.loaded ? 0 : -2;
+}
+
+/**
+ * End of PMTK740 and PMTK741 (USART2 interrupt).
+ */
+static void GNSSAID_Done(uint16_t command, int8_t result) {
+	(void)command;
+	if (result == 0) {
+		GNSSAID_stats.acknowledged++;
+	} else {
+		GNSSAID_stats.rejected++;
+	}
+}
+
+/**
+ * Degrees in 1e-7 to "-dd.dddddd" (6 decimals, 11 cm), without float.
+ */
+static void GNSSAID_FormatDegrees(char *text, size_t size, int32_t value_e7) {
+	uint32_t magnitude = value_e7 < 0 ? -(uint32_t)value_e7 : (uint32_t)value_e7;
+	uint32_t value_e6 = (magnitude + 5) / 10;
+	snprintf(text, size, "%s%lu.%06lu", value_e7 < 0 ? "-" : "", (unsigned long)(value_e6 / 1000000),
+			(unsigned long)(value_e6 % 1000000));
+}
+
+/**
+ * Check the EPO window against the UTC time.
+ */
+static void GNSSAID_CheckEPO(uint32_t utc_s) {
+	if (GNSSAID_stats.epo == GNSSAID_EPO_STORED || GNSSAID_stats.epo == GNSSAID_EPO_VALID
+			|| GNSSAID_stats.epo == GNSSAID_EPO_EXPIRED) {
+		uint8_t valid = utc_s >= GNSSAID_stats.epo_start_s && utc_s < GNSSAID_stats.epo_end_s;
+		GNSSAID_stats.epo = valid ? GNSSAID_EPO_VALID : GNSSAID_EPO_EXPIRED;
+	}
+}
+
+/**
+ * Give the UTC time and the last position to the module, and ask for its EPO window.
+ * Queued commands (4 places in L76LM33_Command), returns immediately.
+ *
+ * @retval 0 OK, aiding queued
+ * @retval -1 ERROR, command not queued
+ * @retval -2 OK, UTC time unknown: nothing given (EPO window asked)
+ */
+int8_t GNSSAID_Start() {
+	int8_t status = -2;
+	uint32_t utc_s;
+	GNSSAID_stats.aiding = GNSSAID_AIDING_NONE;
+
+	if (GNSSAID_port.get_time(&utc_s) == 0) {
+		uint16_t year;
+		uint8_t month, day;
+		uint32_t seconds;
+		GNSSAID_FromUtc(utc_s, &year, &month, &day, &seconds);
+		unsigned long hours = seconds / 3600, minutes = seconds / 60 % 60;
+		seconds %= 60;
+
+		char body[L76LM33_COMMAND_SIZE];
+		snprintf(body, sizeof(body), GNSSAID_CMD_TIME, year, month, day, hours, minutes, (unsigned long)seconds);
+		status = GNSSAID_port.command(body, L76LM33_ACK_TIMEOUT_MS, L76LM33_RETRIES, GNSSAID_Done);
+		GNSSAID_stats.aiding = GNSSAID_AIDING_TIME;
+
+		// Position at the same time, unless the record is from the future (RTC wrong) or too old
+		if (status == 0 && GNSSAID_stats.loaded && utc_s >= GNSSAID_last.utc_s
+				&& utc_s - GNSSAID_last.utc_s <= GNSSAID_MAX_AGE_S) {
+			char latitude[16], longitude[16];
+			GNSSAID_FormatDegrees(latitude, sizeof(latitude), GNSSAID_last.latitude_e7);
+			GNSSAID_FormatDegrees(longitude, sizeof(longitude), GNSSAID_last.longitude_e7);
+			int altitude_m = GNSSAID_last.altitude_m < -9999 ? -9999 : GNSSAID_last.altitude_m;
+			snprintf(body, sizeof(body), GNSSAID_CMD_POSITION, latitude, longitude, altitude_m, year, month, day,
+					hours, minutes, (unsigned long)seconds);
+			status = GNSSAID_port.command(body, L76LM33_ACK_TIMEOUT_MS, L76LM33_RETRIES, GNSSAID_Done);
+			GNSSAID_stats.aiding = GNSSAID_AIDING_POSITION;
+		}
+		if (status != 0) {
+			GNSSAID_stats.rejected++;
+			status = -1;
+		}
+	}
+
+	// EPO window, "$PMTK707" reply (no $PMTK001)
+	GNSSAID_stats.epo = GNSSAID_EPO_PENDING;
+	GNSSAID_start_ms = GNSSAID_port.tick();
+	if (GNSSAID_port.command(GNSSAID_CMD_EPO, 0, 0, NULL) != 0) {
+		GNSSAID_stats.epo = GNSSAID_EPO_UNKNOWN;
+		status = -1;
+	}
+	return status;
+}
+
+/**
+ * Reply of the module to a query (L76LM33_SetReplyHandler): "$PMTK707" EPO window.
+ *
+ * @param sentence: "$PMTK..." line, checksum verified.
+ */
+void GNSSAID_Reply(const char *sentence) {
+	if (sentence == NULL || strncmp(sentence, "$PMTK707,", 9) != 0) {
+		return;
+	}
+
+	// Set, FWN, FTOW, LWN, LTOW
+	uint32_t fields[5];
+	const char *c = sentence + 9;
+	for (uint8_t i = 0; i < 5; i++) {
+		char *end;
+		fields[i] = strtoul(c, &end, 10);
+		if (end == c || (*end != ',' && *end != '*')) {
+			return; // Malformed, still pending
+		}
+		c = end + 1;
+	}
+
+	GNSSAID_stats.epo_sets = fields[0] < UINT8_MAX ? fields[0] : UINT8_MAX;
+	if (fields[0] == 0) {
+		GNSSAID_stats.epo = GNSSAID_EPO_NONE;
+		return;
+	}
+	// GPS time to UTC, the last set is valid for GNSSAID_EPO_SET_S
+	uint32_t first_s = fields[1] * GNSSAID_WEEK_S + fields[2];
+	uint32_t last_s = fields[3] * GNSSAID_WEEK_S + fields[4];
+	GNSSAID_stats.epo_start_s = first_s - GNSSAID_GPS_EPOCH_S - GNSSAID_GPS_UTC_S;
+	GNSSAID_stats.epo_end_s = last_s + GNSSAID_EPO_SET_S - GNSSAID_GPS_EPOCH_S - GNSSAID_GPS_UTC_S;
+	GNSSAID_stats.epo = GNSSAID_EPO_STORED;
+
+	uint32_t utc_s;
+	if (GNSSAID_fixed) {
+		GNSSAID_CheckEPO(GNSSAID_fix_s);
+	} else if (GNSSAID_port.get_time(&utc_s) == 0) {
+		GNSSAID_CheckEPO(utc_s);
+	}
+}
+
+/**
+ * Take the last read of the module: time to first fix, RTC, record. Call after each
+ * L76LM33_Read.
+ *
+ * @param L76_data: last fix (L76LM33_Read), with its date.
+ * @param save: GNSSAID_SAVE_ANY after the landing, GNSSAID_SAVE_NO_ERASE on the pad while
+ *              the launch detector is idle, GNSSAID_SAVE_NONE in flight.
+ *
+ * @retval 0 OK, record saved
+ * @retval -1 ERROR, record not saved (flash)
+ * @retval -2 OK, nothing saved (no fix, no date, not allowed, saved recently or page full)
+ */
+int8_t GNSSAID_Update(const L76LM33 *L76_data, uint8_t save) {
+	uint32_t now_ms = GNSSAID_port.tick();
+	if (GNSSAID_stats.epo == GNSSAID_EPO_PENDING && now_ms - GNSSAID_start_ms > GNSSAID_EPO_TIMEOUT_MS) {
+		GNSSAID_stats.epo = GNSSAID_EPO_UNKNOWN; // No reply
+	}
+
+	if (L76_data == NULL || !L76_data->fix || L76_data->day == 0) {
+		return -2;
+	}
+	uint32_t utc_s = GNSSAID_ToUtc(L76_data->year, L76_data->month, L76_data->day, L76_data->utc_ms / 1000);
+	GNSSAID_fix_s = utc_s;
+
+	uint8_t first = !GNSSAID_fixed;
+	if (first) {
+		GNSSAID_fixed = 1;
+		GNSSAID_stats.ttff_ms = L76_data->fix_ms != 0 ? L76_data->fix_ms : 1;
+	}
+
+	// RTC on the fix at the first fix, then at each save (drift of the LSE)
+	uint32_t rtc_s;
+	uint8_t due = GNSSAID_saved_s == 0 || utc_s - GNSSAID_saved_s >= GNSSAID_SAVE_PERIOD_S;
+	if (first || (save && due)) {
+		uint32_t now_s = utc_s + (L76_data->utc_ms % 1000 + (now_ms - L76_data->fix_ms) + 500) / 1000;
+		if (GNSSAID_port.get_time(&rtc_s) != 0 || rtc_s + GNSSAID_RTC_TOLERANCE_S < now_s
+				|| rtc_s > now_s + GNSSAID_RTC_TOLERANCE_S) {
+			GNSSAID_port.set_time(now_s);
+			GNSSAID_stats.time_sets++;
+		}
+	}
+	if (first) {
+		GNSSAID_CheckEPO(utc_s);
+	}
+
+	if (!save || !due) {
+		return -2;
+	}
+	GNSSAID_saved_s = utc_s; // Not again before GNSSAID_SAVE_PERIOD_S, even after an error
+
+	GNSSAID_Record record = {
+		.magic = GNSSAID_MAGIC,
+		.sequence = GNSSAID_last.magic == GNSSAID_MAGIC ? GNSSAID_last.sequence + 1 : 0,
+		.utc_s = utc_s,
+		.latitude_e7 = L76_data->latitude_e7,
+		.longitude_e7 = L76_data->longitude_e7,
+		.altitude_m = L76_data->altitude_fix ? (int16_t)L76_data->altitude_m : 0,
+		.aiding = GNSSAID_stats.aiding,
+		.epo = GNSSAID_stats.epo,
+		.ttff_ms = GNSSAID_stats.ttff_ms,
+		.epo_end_s = GNSSAID_stats.epo_sets > 0 ? GNSSAID_stats.epo_end_s : 0,
+		.reserved = 0xFFFF,
+	};
+	record.crc = PACKET_CRC16((const uint8_t *)&record, GNSSAID_CRC_OFFSET);
+	return GNSSAID_Save(&record, save == GNSSAID_SAVE_ANY);
+}
+
+/**
+ * @return aiding, EPO window, TTFF and flash counters
+ */
+const GNSSAID_Stats *GNSSAID_GetStats() {
+	return &GNSSAID_stats;
+}
+
+/**
+ * UTC date and time to seconds since 2000-01-01 (years 2000 to 2099).
+ */
+uint32_t GNSSAID_ToUtc(uint16_t year, uint8_t month, uint8_t day, uint32_t seconds) {
+	uint32_t years = year - 2000;
+	uint32_t days = 365 * years + (years + 3) / 4 + GNSSAID_DAYS_BEFORE[(month - 1) % 12] + day - 1;
+	if (years % 4 == 0 && month > 2) {
+		days++; // 29 February of this year
+	}
+	return days * GNSSAID_DAY_S + seconds;
+}
+
+/**
+ * Seconds since 2000-01-01 to the UTC date, and seconds of the day.
+ */
+void GNSSAID_FromUtc(uint32_t utc_s, uint16_t *year, uint8_t *month, uint8_t *day, uint32_t *seconds) {
+	uint32_t days = utc_s / GNSSAID_DAY_S;
+	*seconds = utc_s % GNSSAID_DAY_S;
+
+	*year = 2000;
+	while (days >= (*year % 4 == 0 ? 366u : 365u)) {
+		days -= *year % 4 == 0 ? 366 : 365;
+		(*year)++;
+	}
+	uint32_t leap = *year % 4 == 0;
+	*month = 12;
+	while (*month > 1 && days < (uint32_t)GNSSAID_DAYS_BEFORE[*month - 1] + (leap && *month > 2)) {
+		(*month)--;
+	}
+	*day = days - GNSSAID_DAYS_BEFORE[*month - 1] - (leap && *month > 2) + 1;
+}
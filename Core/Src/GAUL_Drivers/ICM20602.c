@@ -0,0 +1,409 @@
+/*
+ * ICM20602.c
+ *
+ * ICM-20602 IMU, FIFO drained by burst reads.
+ *
+ * A drain is: FIFO count (one 3-byte transaction), then the FIFO_R_W address and up to
+ * ICM20602_MAX_BURST packets in one transaction with DMA. Reading a packet per sample
+ * (or a register per axis) would need 1000 transactions per second, the burst needs one
+ * per task run whatever the number of samples. The burst is queued at high priority on
+ * the SPI bus (SPIBUS.h), before an SD block waiting for the bus.
+ *
+ * Timeline: "ICM_next_us" (+ "ICM_next_ns") is the time of the oldest sample in the FIFO.
+ * At each drain, the newest sample of the FIFO was written in the last period before the
+ * FIFO count was read: the timeline is moved by the smallest amount that satisfies this.
+ * The corrections are accumulated over ICM20602_DRIFT_SAMPLES samples to estimate the
+ * period of the IMU clock (+/-1% from the nominal 1 kHz), so the timeline stays within one
+ * period of the true sample times and the corrections become small.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/ICM20602.h"
+#include "GAUL_Drivers/SPIBUS.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define ICM20602_MAX_DRIFT_NS (ICM20602_PERIOD_NS / 50) // Period estimation within +/-2%
+
+static SPI_HandleTypeDef *ICM_hspi = NULL;
+static ICM20602_Port ICM_port;
+
+// SPI bus
+static int8_t ICM_device = -1;
+static uint8_t ICM_selected = 0;
+static SPIBUS_Transaction ICM_transaction;
+
+static volatile uint8_t ICM_state = ICM20602_STATE_IDLE;
+static uint8_t ICM_buffer[ICM20602_MAX_BURST * ICM20602_PACKET_SIZE];
+static uint16_t ICM_burst;        // Samples of the burst read
+static uint16_t ICM_pending;      // Samples left in the FIFO after the burst
+static uint8_t ICM_overflow;      // Reset the FIFO after the burst
+
+// Timeline
+static uint8_t ICM_synced;
+static uint32_t ICM_next_us;      // Time of the next sample read
+static uint16_t ICM_next_ns;      // Fraction of ICM_next_us (0 to 999 ns)
+static uint8_t ICM_has_last;
+static uint32_t ICM_last_us;      // Time of the last sample collected
+static int32_t ICM_drift_ns;      // Corrections since the last period estimation
+static uint32_t ICM_drift_samples;
+static ICM20602_Stats ICM_stats;
+
+static void ICM20602_BusSelect(uint8_t selected) {
+	if (selected) {
+		ICM_selected = SPIBUS_Select(ICM_device) == 0; // Timeout: bytes read as 0xFF
+	} else if (ICM_selected) {
+		ICM_selected = 0;
+		SPIBUS_Deselect(ICM_device);
+	}
+}
+
+static uint8_t ICM20602_BusExchange(uint8_t byte) {
+	return SPIBUS_Exchange(byte);
+}
+
+static void ICM20602_BusRead(uint8_t data[], uint16_t size) {
+	SPIBUS_Receive(data, size);
+}
+
+static void ICM20602_BusReadDone(SPIBUS_Transaction *transaction) {
+	(void)transaction;
+	ICM20602_RxCallback(ICM_hspi);
+}
+
+static int8_t ICM20602_BusReadDMA(uint8_t reg, uint8_t data[], uint16_t size) {
+	ICM_transaction = (SPIBUS_Transaction) {
+		.device = ICM_device,
+		.priority = SPIBUS_PRIORITY_HIGH,
+		.header = { reg | ICM20602_READ },
+		.header_size = 1,
+		.rx = data,
+		.size = size,
+		.callback = ICM20602_BusReadDone,
+	};
+	return SPIBUS_Submit(&ICM_transaction) == 0 ? 0 : -1;
+}
+
+/**
+ * Move the timeline by "delta_ns" (positive: later).
+ */
+static void ICM20602_Shift(int32_t delta_ns) {
+	int32_t ns = ICM_next_ns + delta_ns;
+	int32_t us = ns / 1000;
+	ns %= 1000;
+	if (ns < 0) {
+		ns += 1000;
+		us--;
+	}
+	ICM_next_us += us;
+	ICM_next_ns = ns;
+}
+
+/**
+ * Start the timeline at a drain: the newest of the "count" samples is placed half a period
+ * before the drain time.
+ */
+static void ICM20602_Sync(uint32_t time_us, uint16_t count) {
+	ICM_next_us = time_us;
+	ICM_next_ns = 0;
+	ICM20602_Shift(-(int32_t)((count - 1) * ICM_stats.period_ns + ICM_stats.period_ns / 2));
+
+	if (ICM_has_last) {
+		// Samples missing between the last sample collected and the new timeline
+		uint32_t period_us = ICM_stats.period_ns / 1000;
+		int32_t gap_us = (int32_t)(ICM_next_us - ICM_last_us);
+		if (gap_us > (int32_t)(period_us + period_us / 2)) {
+			ICM_stats.lost += (gap_us + period_us / 2) / period_us - 1;
+		}
+		ICM_stats.resyncs++;
+	}
+	ICM_drift_ns = 0;
+	ICM_drift_samples = 0;
+	ICM_synced = 1;
+}
+
+/**
+ * Check the timeline against a drain: the newest of the "count" samples was written in
+ * the period before "time_us" (count 0: the next sample was not written yet).
+ */
+static void ICM20602_Track(uint32_t time_us, uint16_t count) {
+	int64_t newest_ns = (int64_t)(int32_t)(ICM_next_us - time_us) * 1000 + ICM_next_ns
+			+ ((int64_t)count - 1) * ICM_stats.period_ns;
+	int32_t correction_ns = 0;
+	if (newest_ns > 0) {
+		correction_ns = -(int32_t)newest_ns;
+	} else if (newest_ns <= -(int64_t)ICM_stats.period_ns) {
+		correction_ns = (int32_t)(-(int64_t)ICM_stats.period_ns - newest_ns) + 1000;
+	}
+	if (correction_ns == 0) {
+		return;
+	}
+
+	ICM20602_Shift(correction_ns);
+	ICM_drift_ns += correction_ns;
+	int32_t correction_us = (correction_ns < 0 ? -correction_ns : correction_ns) / 1000;
+	if (correction_us > ICM_stats.max_correction_us) {
+		ICM_stats.max_correction_us = correction_us;
+	}
+}
+
+/**
+ * Period of the IMU clock from the corrections of the last ICM20602_DRIFT_SAMPLES samples.
+ */
+static void ICM20602_EstimatePeriod(uint16_t samples) {
+	ICM_drift_samples += samples;
+	if (ICM_drift_samples < ICM20602_DRIFT_SAMPLES) {
+		return;
+	}
+	int32_t period_ns = ICM_stats.period_ns + ICM_drift_ns / (int32_t)ICM_drift_samples;
+	if (period_ns < ICM20602_PERIOD_NS - ICM20602_MAX_DRIFT_NS) {
+		period_ns = ICM20602_PERIOD_NS - ICM20602_MAX_DRIFT_NS;
+	} else if (period_ns > ICM20602_PERIOD_NS + ICM20602_MAX_DRIFT_NS) {
+		period_ns = ICM20602_PERIOD_NS + ICM20602_MAX_DRIFT_NS;
+	}
+	ICM_stats.period_ns = period_ns;
+	ICM_drift_ns = 0;
+	ICM_drift_samples = 0;
+}
+
+static void ICM20602_ResetFIFO() {
+	ICM20602_Write(ICM20602_REG_USER_CTRL, ICM20602_USER_FIFO_EN | ICM20602_USER_FIFO_RST);
+	ICM_synced = 0;
+	ICM_pending = 0;
+}
+
+/**
+ * Initialize the IMU (blocking, ICM20602_RESET_DELAY_MS): reset, check the device ID,
+ * +/-16 g, +/-2000 dps, 1 kHz into the FIFO (accelerometer, temperature, gyroscope). The
+ * IMU is added to the SPI bus (SPIBUS_Init must be done).
+ *
+ * @param hspi: SPI connected to the IMU (&hspi2).
+ * @param port: SPI access functions, NULL (or NULL members) to use the SPI bus.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, device not found or configuration not written
+ */
+int8_t ICM20602_Init(SPI_HandleTypeDef *hspi, const ICM20602_Port *port) {
+	if (hspi == NULL) {
+		return -1; // Error
+	}
+
+	ICM_device = SPIBUS_AddDevice(ICM_CS_GPIO_Port, ICM_CS_Pin, ICM20602_SPI_PRESCALER, 0);
+	if (ICM_device < 0) {
+		return -1; // Error, no room on the bus
+	}
+
+	ICM_hspi = hspi;
+	ICM_selected = 0;
+	ICM_port.select = port != NULL && port->select != NULL ? port->select : ICM20602_BusSelect;
+	ICM_port.exchange = port != NULL && port->exchange != NULL ? port->exchange : ICM20602_BusExchange;
+	ICM_port.read = port != NULL && port->read != NULL ? port->read : ICM20602_BusRead;
+	ICM_port.read_dma = port != NULL && port->read_dma != NULL ? port->read_dma : ICM20602_BusReadDMA;
+	ICM_state = ICM20602_STATE_IDLE;
+	ICM_synced = 0;
+	ICM_has_last = 0;
+	ICM_pending = 0;
+	memset(&ICM_stats, 0, sizeof(ICM_stats));
+	ICM_stats.period_ns = ICM20602_PERIOD_NS;
+
+	ICM20602_Write(ICM20602_REG_PWR_MGMT_1, ICM20602_SETTING_RESET);
+	HAL_Delay(ICM20602_RESET_DELAY_MS);
+	ICM20602_Write(ICM20602_REG_I2C_IF, ICM20602_SETTING_I2C_DIS);
+	ICM20602_Write(ICM20602_REG_PWR_MGMT_1, ICM20602_SETTING_CLOCK);
+
+	uint8_t id = 0;
+	ICM20602_Read(ICM20602_REG_WHO_AM_I, &id, 1);
+	if (id != ICM20602_DEVICE_ID) {
+		return -1; // Error, can't communicate or device not found
+	}
+
+	ICM20602_Write(ICM20602_REG_PWR_MGMT_2, 0x00); // Accelerometer and gyroscope on
+	ICM20602_Write(ICM20602_REG_CONFIG, ICM20602_SETTING_CONFIG);
+	ICM20602_Write(ICM20602_REG_SMPLRT_DIV, ICM20602_SETTING_SMPLRT_DIV);
+	ICM20602_Write(ICM20602_REG_GYRO_CONFIG, ICM20602_SETTING_GYRO);
+	ICM20602_Write(ICM20602_REG_ACCEL_CONFIG, ICM20602_SETTING_ACCEL);
+	ICM20602_Write(ICM20602_REG_ACCEL_CFG2, ICM20602_SETTING_ACCEL2);
+	ICM20602_Write(ICM20602_REG_USER_CTRL, ICM20602_USER_FIFO_RST);
+	ICM20602_Write(ICM20602_REG_FIFO_EN, ICM20602_SETTING_FIFO_EN);
+	ICM20602_Write(ICM20602_REG_USER_CTRL, ICM20602_USER_FIFO_EN);
+
+	uint8_t config[2] = { 0 };
+	ICM20602_Read(ICM20602_REG_CONFIG, config, 1);
+	ICM20602_Read(ICM20602_REG_FIFO_EN, &config[1], 1);
+	if (config[0] != ICM20602_SETTING_CONFIG || config[1] != ICM20602_SETTING_FIFO_EN) {
+		return -1; // Error, configuration not written
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Drain the FIFO: read the FIFO count at "time_us", then queue the burst read of the
+ * samples (ICM20602_MAX_BURST at most) on the bus and return. The IMU is deselected at the
+ * end of the transfer (ICM20602_RxCallback), ICM20602_Collect then returns the samples.
+ *
+ * @param time_us: current time (us), time base of the samples.
+ *
+ * @retval 0 OK, burst read started (or done without DMA if the DMA could not start)
+ * @retval 1 FIFO empty
+ * @retval -1 ERROR, not initialized or FIFO count invalid (FIFO reset)
+ * @retval -2 BUSY, samples of the previous burst not collected
+ */
+int8_t ICM20602_StartRead(uint32_t time_us) {
+	if (ICM_hspi == NULL) {
+		return -1; // Error, not initialized
+	}
+	if (ICM_state != ICM20602_STATE_IDLE) {
+		return -2; // Busy
+	}
+
+	uint8_t count_bytes[2];
+	ICM20602_Read(ICM20602_REG_FIFO_COUNTH, count_bytes, 2);
+	uint16_t count = count_bytes[0] << 8 | count_bytes[1];
+	if (count % ICM20602_PACKET_SIZE != 0 || count > ICM20602_FIFO_SIZE) {
+		ICM_stats.errors++;
+		ICM20602_ResetFIFO();
+		return -1; // Error, misaligned FIFO
+	}
+	uint16_t samples = count / ICM20602_PACKET_SIZE;
+
+	// FIFO full: the samples kept are the oldest ones, the drain time says nothing about them
+	ICM_overflow = 0;
+	if (count == ICM20602_FIFO_SIZE) {
+		uint8_t status = 0;
+		ICM20602_Read(ICM20602_REG_INT_STATUS, &status, 1);
+		ICM_overflow = (status & ICM20602_INT_FIFO_OFLOW) != 0;
+	}
+	if (!ICM_synced) {
+		if (samples > 0) {
+			ICM20602_Sync(time_us, samples);
+		}
+	} else if (!ICM_overflow) {
+		ICM20602_Track(time_us, samples);
+	}
+
+	ICM_burst = samples < ICM20602_MAX_BURST ? samples : ICM20602_MAX_BURST;
+	ICM_pending = samples - ICM_burst;
+	if (ICM_burst == 0) {
+		return 1; // Nothing to read
+	}
+
+	uint16_t size = ICM_burst * ICM20602_PACKET_SIZE;
+	ICM_state = ICM20602_STATE_DMA;
+	if (ICM_port.read_dma(ICM20602_REG_FIFO_R_W, ICM_buffer, size) != 0) {
+		ICM20602_Read(ICM20602_REG_FIFO_R_W, ICM_buffer, size);
+		ICM_state = ICM20602_STATE_DONE;
+		ICM_stats.dma_fallbacks++;
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Samples of the burst read started by ICM20602_StartRead, oldest first. Call
+ * ICM20602_StartRead again if ICM20602_Pending is not 0.
+ *
+ * @param samples: ICM20602_MAX_BURST samples.
+ *
+ * @return samples read, 0 if no burst read, -2 if the transfer is in progress
+ */
+int16_t ICM20602_Collect(ICM20602_Sample samples[]) {
+	if (ICM_state == ICM20602_STATE_DMA) {
+		return -2; // Busy
+	}
+	if (ICM_state != ICM20602_STATE_DONE) {
+		return 0;
+	}
+
+	const uint8_t *packet = ICM_buffer;
+	for (uint16_t i = 0; i < ICM_burst; i++) {
+		for (uint8_t axis = 0; axis < 3; axis++) {
+			samples[i].accel[axis] = (int16_t)(packet[2 * axis] << 8 | packet[2 * axis + 1]);
+			samples[i].gyro[axis] = (int16_t)(packet[8 + 2 * axis] << 8 | packet[9 + 2 * axis]);
+		}
+		samples[i].temp = (int16_t)(packet[6] << 8 | packet[7]);
+		samples[i].time_us = ICM_next_us;
+		ICM_last_us = ICM_next_us;
+		ICM20602_Shift(ICM_stats.period_ns);
+		packet += ICM20602_PACKET_SIZE;
+	}
+	ICM_has_last = 1;
+	ICM_stats.samples += ICM_burst;
+	ICM_stats.reads++;
+	ICM20602_EstimatePeriod(ICM_burst);
+	ICM_state = ICM20602_STATE_IDLE;
+
+	if (ICM_overflow) {
+		// Samples written after the FIFO was full are lost, counted at the next sync
+		ICM_stats.overflows++;
+		ICM20602_ResetFIFO();
+	}
+
+	return ICM_burst;
+}
+
+/**
+ * Burst read complete, IMU deselected. Called at the end of the bus transaction.
+ *
+ * @param hspi: SPI of the transfer, ignored if it is not the IMU SPI.
+ */
+void ICM20602_RxCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == ICM_hspi && ICM_state == ICM20602_STATE_DMA) {
+		ICM_state = ICM20602_STATE_DONE;
+	}
+}
+
+/**
+ * @return ICM20602_STATE_x
+ */
+uint8_t ICM20602_GetState() {
+	return ICM_state;
+}
+
+/**
+ * @return samples left in the FIFO after the last burst read (more than ICM20602_MAX_BURST)
+ */
+uint16_t ICM20602_Pending() {
+	return ICM_pending;
+}
+
+const ICM20602_Stats *ICM20602_GetStats() {
+	return &ICM_stats;
+}
+
+/**
+ * Read consecutive registers (blocking).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, not initialized
+ */
+int8_t ICM20602_Read(uint8_t reg, uint8_t data[], uint16_t size) {
+	if (ICM_hspi == NULL) {
+		return -1; // Error
+	}
+	ICM_port.select(1);
+	ICM_port.exchange(reg | ICM20602_READ);
+	ICM_port.read(data, size);
+	ICM_port.select(0);
+	return 0; // OK
+}
+
+/**
+ * Write a register (blocking).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, not initialized
+ */
+int8_t ICM20602_Write(uint8_t reg, uint8_t value) {
+	if (ICM_hspi == NULL) {
+		return -1; // Error
+	}
+	ICM_port.select(1);
+	ICM_port.exchange(reg & ~ICM20602_READ);
+	ICM_port.exchange(value);
+	ICM_port.select(0);
+	return 0; // OK
+}
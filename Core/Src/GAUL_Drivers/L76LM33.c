@@ -9,6 +9,25 @@
  * Store UART received byte via interrupts into circular buffer using L76LM33_RxCallback()
  * Read circular buffer to find NMEA sentence and parse it using L76LM33_Read()
  *
+ * L76LM33_Init negotiates the link: it finds the baud rate of the module (valid sentence
+ * received), switches it to L76LM33_BAUD_FAST (PMTK251) and USART2 with it, then sets the
+ * fix interval (PMTK220) and verifies it by timing the RMC sentences. When the module does
+ * not follow, USART2 goes back to the baud rate found and the fix interval is relaxed.
+ *
+ * PMTK commands go through a queue (L76LM33_Command): the checksum is added, the command
+ * is sent with interrupts and the $PMTK001 acknowledge is matched in the receive interrupt,
+ * with a timeout and retries per command. The end of the transmission starts the next
+ * command, a timeout is checked at each received line and by L76LM33_Poll, so commands
+ * progress while the main loop is blocked (barometer calibration at boot). One command
+ * is in progress at a time, $PMTK001 only gives the command number. Sentences longer than a
+ * command (EPO data) are framed by the caller and queued with L76LM33_Transfer.
+ *
+ * The receive interrupt notes the HAL tick of the first byte of every sentence. The UTC
+ * time of each fix is mapped to the HAL tick by the earliest arrival seen (L76LM33_Clock),
+ * so a fix carries the tick it was valid at (fix_ms) whatever the baud rate and the delay
+ * before L76LM33_Read. L76LM33_GetPosition extrapolates it to another tick with the speed
+ * and course over ground.
+ *
  *  Created on: May 12, 2024
  *      Author: gagnon
  *
@@ -21,9 +40,53 @@
 #include "GAUL_Drivers/NMEA.h"
 #include "ringbuffer.h"
 
+#include "GAUL_System/PROFILER.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 // Pointer to UART handler
 UART_HandleTypeDef *L76_huart;
 
+// UART access (HAL or test model) and result of the negotiation
+static L76LM33_Port L76_port;
+static L76LM33_Link L76_link;
+
+// Baud rates probed after the current one, most likely first
+static const uint32_t L76_BAUDS[] = { L76LM33_BAUD_DEFAULT, L76LM33_BAUD_FAST, 57600, 38400 };
+
+// Command queue, the head is in progress
+#define L76LM33_COMMAND_QUEUED  0
+#define L76LM33_COMMAND_SENDING 1 // Transmit started
+#define L76LM33_COMMAND_WAITING 2 // Waiting for $PMTK001
+
+typedef struct {
+	char text[L76LM33_COMMAND_SIZE];
+	const char *data;      // Sentence sent: text, or the buffer of the caller (L76LM33_Transfer)
+	uint16_t size;
+	uint8_t state;
+	uint16_t command;      // PMTK number, 0: no acknowledge expected
+	uint16_t timeout_ms;   // 0: done at the end of the transmission
+	uint8_t retries;       // Left
+	uint32_t time_ms;      // Transmit start (SENDING) or end (WAITING)
+	L76LM33_Done done;
+} L76LM33_Command_t;
+
+static L76LM33_Command_t L76_commands[L76LM33_COMMAND_QUEUE];
+static uint8_t L76_command_head = 0;
+static uint8_t L76_command_count = 0;
+static L76LM33_CommandStats L76_command_stats;
+static L76LM33_Reply L76_reply = NULL;
+
+// $PMTK line being received (acknowledges parsed in the receive interrupt)
+static char L76_ack[L76LM33_ACK_SIZE + 1];
+static uint8_t L76_ack_length = 0;
+
+// Result of the command run by L76LM33_Execute, 1: in progress
+static volatile int8_t L76_executed;
+
 // Received char/byte from UART
 uint8_t L76_receivedByte;
 
@@ -31,12 +94,22 @@ uint8_t L76_receivedByte;
 ring_buffer_t L76_UART_Buffer;
 char L76_UART_Buffer_arr[L76LM33_BUFFER_SIZES];
 
-// 1: line is available in UART buffer, 0: line is not available in UART buffer
-uint8_t L76_new_line = 0;
+// Lines ('\n') available in UART buffer
+volatile uint8_t L76_new_line = 0;
 
 // Buffer to store NMEA sentence
 uint8_t L76_NMEA_Buffer[L76LM33_BUFFER_SIZES];
 
+// HAL tick at the first byte ('$') of the last lines received, of the sentence read
+static uint32_t L76_line_start_ms;
+static uint32_t L76_line_ms[L76LM33_LINE_TICKS];
+static uint8_t L76_line_write = 0;
+static uint32_t L76_sentence_ms;
+static uint8_t L76_sentence_stamped = 0; // 0: arrival unknown (lines lost)
+
+// UTC to HAL tick
+static L76LM33_Clock L76_clock;
+
 // Struct to store parsed NMEA data
 GPS_Data L76_gps_data;
 
@@ -45,48 +118,499 @@ GPS_Data L76_gps_data;
  * Source:
  * LG76 Series GNSS Protocol Specification - Section 2.3. PMTK Messages
  *
- * Only output RMC (Recommended Minimum Specific GNSS Sentence) once every one position fix
- * NMEA_RMC[] = "$PMTK314,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*35<CR><LF>"
+ * Only output RMC (Recommended Minimum Specific GNSS Sentence) and GGA (altitude) once every
+ * one position fix (fields: GLL, RMC, VTG, GGA, GSA, GSV, ...)
+ * NMEA_RMC_GGA[] = "$PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*34<CR><LF>"
  *
  * Set the navigation mode to "Aviation Mode" (for large acceleration movement, altitude of 10'000m max)
- * NMEA_NAVMODE = "PMTK886,2*2A<CR><LF>"
+ * NMEA_NAVMODE = "$PMTK886,2*28<CR><LF>"
+ *
+ * Set the baud rate (not kept when the module is powered off, no acknowledge)
+ * NMEA_BAUD = "$PMTK251,115200*1F<CR><LF>"
+ *
+ * Set the fix interval in ms (100 ms = 10 Hz)
+ * NMEA_FIX_10HZ = "$PMTK220,100*2F<CR><LF>"
+ * NMEA_FIX_5HZ = "$PMTK220,200*2C<CR><LF>"
+ *
+ * Acknowledge of a command, flag 0: invalid, 1: unsupported, 2: failed, 3: succeeded
+ * "$PMTK001,<cmd>,<flag>*CS<CR><LF>"
+ *
+ * The commands are written without '$' and checksum (L76LM33_Command adds them).
+ */
+#define L76LM33_CMD_RMC_GGA  "PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0"
+#define L76LM33_CMD_BAUD     "PMTK251,%lu"
+#define L76LM33_CMD_FIX      "PMTK220,%u"
+#define L76LM33_CMD_NAVMODE  "PMTK886,%u"
+
+static int8_t L76LM33_TransmitHAL(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+	if (HAL_UART_Transmit_IT(huart, (uint8_t *)data, size) != HAL_OK) {
+		return -1; // Error with UART
+	}
+	return 0; // OK
+}
+
+/**
+ * Re-initialize the UART at a new baud rate and restart the reception.
+ */
+static int8_t L76LM33_SetBaudHAL(UART_HandleTypeDef *huart, uint32_t baud) {
+	HAL_UART_AbortReceive(huart);
+	HAL_UART_AbortTransmit(huart);
+	huart->Init.BaudRate = baud;
+	if (HAL_UART_Init(huart) != HAL_OK) {
+		return -1; // Error with UART
+	}
+	if (HAL_UART_Receive_IT(huart, &L76_receivedByte, 1) != HAL_OK) {
+		return -1; // Error with UART
+	}
+	return 0; // OK
+}
+
+/**
+ * Drop the received data (sent at another baud rate, or before a command).
+ */
+static void L76LM33_Flush() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	ring_buffer_init(&L76_UART_Buffer, L76_UART_Buffer_arr, sizeof(L76_UART_Buffer_arr));
+	L76_new_line = 0;
+	L76_ack_length = 0;
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Start the transmission of the command at the head of the queue (interrupts disabled).
+ */
+static void L76LM33_Start() {
+	while (L76_command_count > 0) {
+		L76LM33_Command_t *command = &L76_commands[L76_command_head];
+		if (command->state != L76LM33_COMMAND_QUEUED) {
+			return; // In progress
+		}
+		command->state = L76LM33_COMMAND_SENDING;
+		command->time_ms = L76_port.tick();
+		L76_command_stats.sent++;
+		if (L76_port.transmit(L76_huart, (const uint8_t *)command->data, command->size) == 0) {
+			return; // Sending
+		}
+
+		// Error with UART, next command
+		L76_command_stats.rejected++;
+		L76LM33_Done done = command->done;
+		uint16_t number = command->command;
+		L76_command_head = (L76_command_head + 1) % L76LM33_COMMAND_QUEUE;
+		L76_command_count--;
+		if (done != NULL) {
+			done(number, -1);
+		}
+	}
+}
+
+/**
+ * End the command at the head of the queue and start the next one (interrupts disabled).
+ */
+static void L76LM33_Complete(int8_t result) {
+	L76LM33_Command_t *command = &L76_commands[L76_command_head];
+	L76LM33_Done done = command->done;
+	uint16_t number = command->command;
+
+	if (result == 0) {
+		L76_command_stats.acknowledged += number != 0 && command->timeout_ms != 0;
+	} else if (result == -3) {
+		L76_command_stats.timeouts++;
+	} else {
+		L76_command_stats.rejected++;
+	}
+	L76_command_head = (L76_command_head + 1) % L76LM33_COMMAND_QUEUE;
+	L76_command_count--;
+	if (done != NULL) {
+		done(number, result);
+	}
+	L76LM33_Start();
+}
+
+/**
+ * Send the command at the head of the queue again, or end it with "result" when no retry
+ * is left (interrupts disabled).
+ */
+static void L76LM33_Retry(int8_t result) {
+	L76LM33_Command_t *command = &L76_commands[L76_command_head];
+	if (command->retries == 0) {
+		L76LM33_Complete(result);
+		return;
+	}
+	command->retries--;
+	command->state = L76LM33_COMMAND_QUEUED;
+	L76_command_stats.retries++;
+	L76LM33_Start();
+}
+
+/**
+ * Timeout of the command in progress (interrupts disabled).
+ */
+static void L76LM33_Service() {
+	if (L76_command_count == 0) {
+		return;
+	}
+	L76LM33_Command_t *command = &L76_commands[L76_command_head];
+	uint32_t elapsed = L76_port.tick() - command->time_ms;
+	if (command->state == L76LM33_COMMAND_SENDING && elapsed >= L76LM33_ACK_TIMEOUT_MS) {
+		L76LM33_Complete(-3); // Transmission never ended
+	} else if (command->state == L76LM33_COMMAND_WAITING && elapsed >= command->timeout_ms) {
+		L76LM33_Retry(-3);
+	}
+}
+
+/**
+ * Match a "$PMTK001,<cmd>,<flag>*CS" line with the command in progress (interrupts disabled).
+ */
+static void L76LM33_Acknowledge() {
+	if (strncmp(L76_ack, "$PMTK001,", 9) != 0 || NMEA_ValidateChecksum(L76_ack) != 0 || L76_command_count == 0) {
+		return; // Other sentence, corrupted, or nothing in progress
+	}
+	L76LM33_Command_t *command = &L76_commands[L76_command_head];
+	char *end;
+	uint32_t number = strtoul(L76_ack + 9, &end, 10);
+	if (command->state != L76LM33_COMMAND_WAITING || number != command->command || *end != ',') {
+		return; // Late acknowledge of a command already ended
+	}
+
+	uint8_t flag = end[1] - '0';
+	if (flag == L76LM33_ACK_SUCCESS) {
+		L76LM33_Complete(0);
+	} else if (flag == L76LM33_ACK_FAILED) {
+		L76LM33_Retry(-1);
+	} else {
+		L76LM33_Complete(-1); // Invalid or unsupported, same answer on a retry
+	}
+}
+
+static void L76LM33_Executed(uint16_t command, int8_t result) {
+	(void)command;
+	L76_executed = result;
+}
+
+/**
+ * Queue a command and wait for its end (used by L76LM33_Init, the queue is empty).
+ *
+ * @return result of the command (see L76LM33_Done)
+ */
+static int8_t L76LM33_Execute(const char *body, uint16_t timeout_ms, uint8_t retries) {
+	L76_executed = 1;
+	if (L76LM33_Command(body, timeout_ms, retries, L76LM33_Executed) != 0) {
+		return -1; // Error
+	}
+	while (L76_executed == 1) {
+		L76_port.wait(1);
+		L76LM33_Poll();
+	}
+	return L76_executed;
+}
+
+/**
+ * Listen until "wanted" RMC sentences with a valid checksum are received, or timeout_ms.
+ *
+ * @param period_ms: set to the mean period between the RMC sentences (0 if less than 2).
+ *
+ * @return number of valid RMC sentences received
  */
+static uint8_t L76LM33_Listen(uint8_t wanted, uint32_t timeout_ms, uint16_t *period_ms) {
+	uint32_t start = L76_port.tick();
+	uint32_t first = 0;
+	uint32_t last = 0;
+	uint8_t count = 0;
+
+	*period_ms = 0;
+	while (count < wanted && L76_port.tick() - start < timeout_ms) {
+		L76_port.wait(1);
+		while (L76_new_line > 0 && count < wanted) {
+			if (L76LM33_ReadSentence() != 0 || NMEA_ValidateChecksum((char *)L76_NMEA_Buffer) != 0
+					|| NMEA_ValidateRMC((char *)L76_NMEA_Buffer) != 0) {
+				continue; // Garbage (other baud rate) or other sentence
+			}
+			last = L76_port.tick();
+			if (count++ == 0) {
+				first = last;
+			}
+		}
+	}
+	if (count >= 2) {
+		*period_ms = (uint16_t)((last - first) / (count - 1));
+	}
+	return count;
+}
 
 /**
- * Initialize L76LM33 sensor.
+ * Find the baud rate of the module: current USART2 baud rate first, then L76_BAUDS.
+ *
+ * @return baud rate found, 0 if the module does not answer
+ */
+static uint32_t L76LM33_Probe() {
+	uint32_t current = L76_huart->Init.BaudRate;
+	uint16_t period_ms;
+
+	for (int8_t i = -1; i < (int8_t)(sizeof(L76_BAUDS) / sizeof(L76_BAUDS[0])); i++) {
+		uint32_t baud = i < 0 ? current : L76_BAUDS[i];
+		if (i >= 0 && baud == current) {
+			continue; // Already tried
+		}
+		L76_link.probes++;
+		if (L76_port.set_baud(L76_huart, baud) != 0) {
+			return 0; // Error with UART
+		}
+		L76LM33_Flush();
+		if (L76LM33_Listen(1, L76LM33_PROBE_MS, &period_ms) > 0) {
+			return baud;
+		}
+	}
+	return 0; // No answer
+}
+
+/**
+ * Set the fix interval and verify it from the RMC sentences timing.
+ *
+ * @retval 1 Measured period matches
+ * @retval 0 Module did not follow
+ */
+static uint8_t L76LM33_SetFixInterval(uint16_t period_ms) {
+	char body[16];
+	snprintf(body, sizeof(body), L76LM33_CMD_FIX, period_ms);
+	L76LM33_Execute(body, L76LM33_ACK_TIMEOUT_MS, 1); // The period tells if it worked
+	L76_link.asked_ms = period_ms;
+
+	// First sentence may come from the previous interval
+	L76LM33_Listen(1, L76LM33_PROBE_MS, &L76_link.period_ms);
+	L76LM33_Listen(L76LM33_VERIFY_SENTENCES, L76LM33_PROBE_MS + L76LM33_VERIFY_SENTENCES * period_ms,
+			&L76_link.period_ms);
+
+	int32_t error = (int32_t)L76_link.period_ms - period_ms;
+	return L76_link.period_ms != 0 && error <= period_ms / L76LM33_PERIOD_TOLERANCE
+			&& error >= -period_ms / L76LM33_PERIOD_TOLERANCE;
+}
+
+/**
+ * Initialize L76LM33 sensor and negotiate the link (see L76LM33_GetLink). Blocks up to
+ * ~5 s when the module is not found, ~3 s usually, ~7 s when it ignores the commands.
  *
- * @param L76_data: pointer to a L76LM33 structure.
  * @param huart: pointer to a HAL UART handler.
+ * @param port: UART access, NULL to use the HAL.
  *
- * @retval 0 OK
- * @retval -1 ERROR
+ * @retval 0 OK (possibly at a slower baud rate or fix interval, see L76LM33_GetLink)
+ * @retval -1 ERROR, module not found or UART error
  */
-int8_t L76LM33_Init(UART_HandleTypeDef *huart) {
+int8_t L76LM33_Init(UART_HandleTypeDef *huart, const L76LM33_Port *port) {
 	// Set UART handler
 	L76_huart = huart;
+	if (port == NULL) {
+		L76_port.transmit = L76LM33_TransmitHAL;
+		L76_port.set_baud = L76LM33_SetBaudHAL;
+		L76_port.tick = HAL_GetTick;
+		L76_port.wait = HAL_Delay;
+	} else {
+		L76_port = *port;
+	}
+	L76_link = (L76LM33_Link) { 0 };
+	L76_command_head = 0;
+	L76_command_count = 0;
+	L76_command_stats = (L76LM33_CommandStats) { 0 };
+	L76_clock = (L76LM33_Clock) { 0 };
+	uint32_t start = L76_port.tick();
 
 	// Initialize circular buffer
-	ring_buffer_init(&L76_UART_Buffer, L76_UART_Buffer_arr, sizeof(L76_UART_Buffer_arr));
-
-	// Receive UART data with interrupts
-	if (HAL_UART_Receive_IT(L76_huart, &L76_receivedByte, 1) != HAL_OK) {
-		return -1; // Error with UART
+	L76LM33_Flush();
+
+	// Receive UART data with interrupts (restarted by set_baud)
+	uint32_t baud = L76LM33_Probe();
+	if (baud == 0) {
+		L76_port.set_baud(L76_huart, L76LM33_BAUD_DEFAULT);
+		L76_link.init_ms = L76_port.tick() - start;
+		return -1; // Error, no answer from the module
 	}
 
-	// Only output GPRMC sentence
-    char NMEA_RMC[] = "$PMTK314,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*35\r\n";
-    if (L76LM33_SendCommand(NMEA_RMC, sizeof(NMEA_RMC)) != 0) {
-    	return -1; // Error with UART
+	// Only output RMC and GGA sentences (before 10 Hz, all the sentences would fill the buffer)
+    // (result not needed, the sentences received tell if the link works)
+    L76LM33_Execute(L76LM33_CMD_RMC_GGA, L76LM33_ACK_TIMEOUT_MS, L76LM33_RETRIES);
+
+    // Switch to the fast baud rate, back to the baud rate found if the module does not follow
+    uint16_t period_ms;
+    if (baud != L76LM33_BAUD_FAST) {
+    	char body[20];
+    	snprintf(body, sizeof(body), L76LM33_CMD_BAUD, (uint32_t)L76LM33_BAUD_FAST);
+    	if (L76LM33_Execute(body, 0, 0) != 0) {
+    		return -1; // Error with UART
+    	}
+    	L76_port.wait(L76LM33_SWITCH_MS);
+    	if (L76_port.set_baud(L76_huart, L76LM33_BAUD_FAST) != 0) {
+    		return -1; // Error with UART
+    	}
+    	L76LM33_Flush();
+    	if (L76LM33_Listen(1, L76LM33_PROBE_MS, &period_ms) > 0) {
+    		baud = L76LM33_BAUD_FAST;
+    	} else if (L76_port.set_baud(L76_huart, baud) != 0) {
+    		return -1; // Error with UART
+    	}
     }
-    // Set navigation mode
-    char NMEA_NAVMODE[] = "PMTK886,2*2A\r\n";
-    if (L76LM33_SendCommand(NMEA_NAVMODE, sizeof(NMEA_NAVMODE)) != 0) {
-    	return -1; // Error with UART
+    L76_link.baud = baud;
+    L76_link.fast = baud == L76LM33_BAUD_FAST;
+
+    // Fix interval, relaxed when the line is slow or the module did not follow
+    L76_link.rate_ok = L76LM33_SetFixInterval(L76_link.fast ? L76LM33_FIX_PERIOD_MS : L76LM33_SLOW_PERIOD_MS);
+    if (!L76_link.rate_ok && L76_link.fast) {
+    	L76_link.rate_ok = L76LM33_SetFixInterval(L76LM33_SLOW_PERIOD_MS);
     }
 
+    L76_link.init_ms = L76_port.tick() - start;
     return 0; // OK
 }
 
+/**
+ * @return result of the link negotiation done by L76LM33_Init
+ */
+const L76LM33_Link *L76LM33_GetLink() {
+	return &L76_link;
+}
+
+/**
+ * Queue a PMTK command, returns immediately. '$', the checksum and <CR><LF> are added.
+ * The command is sent when the previous ones are done, then "done" is called with the
+ * result: acknowledged with $PMTK001 (sent again after timeout_ms without acknowledge or
+ * with the "failed" flag, up to "retries" times), or sent when timeout_ms is 0.
+ *
+ * @param body: command without '$' and checksum, "PMTK886,2".
+ * @param timeout_ms: time to wait for $PMTK001 after the transmission, 0: no acknowledge.
+ * @param retries: transmissions after the first one.
+ * @param done: called at the end of the command (NULL: none).
+ *
+ * @retval 0 OK, queued
+ * @retval -1 ERROR, command too long or with '$' or '*'
+ * @retval -2 BUSY, queue full
+ */
+int8_t L76LM33_Command(const char *body, uint16_t timeout_ms, uint8_t retries, L76LM33_Done done) {
+	if (body == NULL) {
+		return -1; // Error
+	}
+	size_t length = strlen(body);
+	if (length == 0 || length + 6 > L76LM33_COMMAND_SIZE || strpbrk(body, "$*\r\n") != NULL) {
+		return -1; // Error, does not fit or already framed
+	}
+
+	uint8_t checksum = 0;
+	for (size_t i = 0; i < length; i++) {
+		checksum ^= (uint8_t)body[i];
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (L76_command_count >= L76LM33_COMMAND_QUEUE) {
+		L76_command_stats.full++;
+		__set_PRIMASK(primask);
+		return -2; // Busy, queue full
+	}
+	L76LM33_Command_t *command = &L76_commands[(L76_command_head + L76_command_count) % L76LM33_COMMAND_QUEUE];
+	command->size = (uint16_t)snprintf(command->text, sizeof(command->text), "$%s*%02X\r\n", body, checksum);
+	command->data = command->text;
+	command->state = L76LM33_COMMAND_QUEUED;
+	command->command = strncmp(body, "PMTK", 4) == 0 ? (uint16_t)strtoul(body + 4, NULL, 10) : 0;
+	command->timeout_ms = command->command != 0 ? timeout_ms : 0;
+	command->retries = retries;
+	command->done = done;
+	L76_command_count++;
+	L76LM33_Start();
+	__set_PRIMASK(primask);
+
+	return 0; // OK
+}
+
+/**
+ * Queue a sentence already framed ("$PMTK721,...*CS\r\n") and longer than a command,
+ * returns immediately. The buffer is sent as is and must stay unchanged until "done".
+ * Same acknowledge, timeout and retries as L76LM33_Command.
+ *
+ * @param sentence: framed sentence, "$PMTK<number>,..." to wait for its acknowledge.
+ * @param size: bytes to send.
+ *
+ * @retval 0 OK, queued
+ * @retval -1 ERROR, not a sentence
+ * @retval -2 BUSY, queue full
+ */
+int8_t L76LM33_Transfer(const char *sentence, uint16_t size, uint16_t timeout_ms, uint8_t retries, L76LM33_Done done) {
+	if (sentence == NULL || size < 5 || sentence[0] != '$' || sentence[size - 1] != '\n') {
+		return -1; // Error, not framed
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if (L76_command_count >= L76LM33_COMMAND_QUEUE) {
+		L76_command_stats.full++;
+		__set_PRIMASK(primask);
+		return -2; // Busy, queue full
+	}
+	L76LM33_Command_t *command = &L76_commands[(L76_command_head + L76_command_count) % L76LM33_COMMAND_QUEUE];
+	command->data = sentence;
+	command->size = size;
+	command->state = L76LM33_COMMAND_QUEUED;
+	command->command = strncmp(sentence, "$PMTK", 5) == 0 ? (uint16_t)strtoul(sentence + 5, NULL, 10) : 0;
+	command->timeout_ms = command->command != 0 ? timeout_ms : 0;
+	command->retries = retries;
+	command->done = done;
+	L76_command_count++;
+	L76LM33_Start();
+	__set_PRIMASK(primask);
+
+	return 0; // OK
+}
+
+/**
+ * Set the navigation mode (PMTK886), acknowledged without blocking.
+ *
+ * @param mode: L76LM33_NAVMODE_x.
+ * @param done: called with the result (NULL: none).
+ *
+ * @retval 0 OK, queued
+ * @retval -1 ERROR
+ * @retval -2 BUSY, queue full
+ */
+int8_t L76LM33_SetNavMode(uint8_t mode, L76LM33_Done done) {
+	char body[16];
+	if (mode > L76LM33_NAVMODE_BALLOON) {
+		return -1; // Error, unknown mode
+	}
+	snprintf(body, sizeof(body), L76LM33_CMD_NAVMODE, mode);
+	return L76LM33_Command(body, L76LM33_ACK_TIMEOUT_MS, L76LM33_RETRIES, done);
+}
+
+/**
+ * Set the function receiving the replies to the queries ("$PMTK707,..." after PMTK607),
+ * NULL: replies dropped.
+ */
+void L76LM33_SetReplyHandler(L76LM33_Reply handler) {
+	L76_reply = handler;
+}
+
+/**
+ * Check the timeout of the command in progress. Called by L76LM33_Read, the receive
+ * interrupt also checks it at each line.
+ */
+void L76LM33_Poll() {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	L76LM33_Service();
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @return commands queued or in progress
+ */
+uint8_t L76LM33_CommandsPending() {
+	return L76_command_count;
+}
+
+/**
+ * @return command engine counters
+ */
+const L76LM33_CommandStats *L76LM33_GetCommandStats() {
+	return &L76_command_stats;
+}
+
 /**
  * Callback called on incoming UART data. It is called when HAL_UART_RxCpltCallback is called in main.c.
  * Add received byte to UART circular buffer.
@@ -97,19 +621,130 @@ void L76LM33_RxCallback(UART_HandleTypeDef *huart) {
 	if (huart->Instance == L76_huart->Instance) {
 		// Add data to circular buffer
 		ring_buffer_queue(&L76_UART_Buffer, L76_receivedByte);
-		if (L76_receivedByte == '\n') {
-			L76_new_line = 1;
+
+		// Keep "$PMTK..." lines for the acknowledges
+		char c = (char)L76_receivedByte;
+		if (c == '$') {
+			L76_line_start_ms = L76_port.tick();
+			L76_ack_length = 0;
+		}
+		if (L76_ack_length < L76LM33_ACK_SIZE && (L76_ack_length >= 5 || c == "$PMTK"[L76_ack_length])) {
+			L76_ack[L76_ack_length++] = c;
+		} else if (c != '\r' && c != '\n') {
+			L76_ack_length = L76LM33_ACK_SIZE; // Other sentence or too long
+		}
+
+		if (c == '\n') {
+			L76_line_ms[L76_line_write++ & (L76LM33_LINE_TICKS - 1)] = L76_line_start_ms;
+			if (L76_new_line < UINT8_MAX) {
+				L76_new_line++;
+			}
+			if (L76_ack_length < L76LM33_ACK_SIZE) {
+				L76_ack[L76_ack_length] = '\0';
+				L76LM33_Acknowledge();
+			}
+			L76_ack_length = L76LM33_ACK_SIZE;
+			L76LM33_Service();
 		}
 		// Receive UART data with interrupts
 		HAL_UART_Receive_IT(L76_huart, &L76_receivedByte, 1);
 	}
 }
 
+/**
+ * Restart the reception stopped by the HAL after an overrun (UARTERR restart, called from
+ * the USART2 interrupt). The acknowledge line in progress lost a byte, it is dropped.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, UART error
+ * @retval -2 not initialized
+ */
+int8_t L76LM33_RestartReceive() {
+	if (L76_huart == NULL) {
+		return -2; // Not initialized
+	}
+	L76_ack_length = L76LM33_ACK_SIZE;
+	return HAL_UART_Receive_IT(L76_huart, &L76_receivedByte, 1) == HAL_OK ? 0 : -1;
+}
+
+/**
+ * Callback called at the end of a transmission. It is called when HAL_UART_TxCpltCallback
+ * is called in main.c. Starts waiting for the acknowledge, or the next command.
+ *
+ * @param huart: pointer to a HAL UART handler triggering the callback
+ */
+void L76LM33_TxCallback(UART_HandleTypeDef *huart) {
+	if (L76_huart == NULL || huart->Instance != L76_huart->Instance || L76_command_count == 0) {
+		return;
+	}
+	L76LM33_Command_t *command = &L76_commands[L76_command_head];
+	if (command->state != L76LM33_COMMAND_SENDING) {
+		return;
+	}
+	if (command->timeout_ms == 0) {
+		L76LM33_Complete(0); // No acknowledge expected
+		return;
+	}
+	command->state = L76LM33_COMMAND_WAITING;
+	command->time_ms = L76_port.tick();
+}
+
+/**
+ * Map the UTC time of a sentence to the HAL tick, refined with its arrival when "refine".
+ * The offset follows the earliest arrival at once, and is raised by 1 ms after
+ * L76LM33_CLOCK_LEAK later arrivals to follow the drift of the MCU clock.
+ *
+ * @return HAL tick of the fix
+ */
+static uint32_t L76LM33_UpdateClock(uint32_t utc_ms, uint32_t rx_ms, uint8_t refine) {
+	if (!L76_clock.synced && !refine) {
+		return rx_ms - L76LM33_OUTPUT_DELAY_MS; // No model yet (no fix)
+	}
+
+	uint32_t elapsed = (utc_ms + L76LM33_DAY_MS - L76_clock.utc_last_ms) % L76LM33_DAY_MS;
+	if (!L76_clock.synced || (refine && elapsed > L76LM33_CLOCK_RESYNC_MS)) {
+		L76_clock.resyncs += L76_clock.synced;
+		L76_clock.synced = 1;
+		L76_clock.utc_ms = utc_ms;
+		L76_clock.offset_ms = rx_ms - utc_ms;
+		L76_clock.leak = 0;
+	} else {
+		L76_clock.utc_ms += elapsed; // Across midnight
+	}
+	L76_clock.utc_last_ms = utc_ms;
+
+	if (refine) {
+		int32_t delay_ms = (int32_t)(rx_ms - L76_clock.utc_ms - L76_clock.offset_ms);
+		if (delay_ms < 0) {
+			L76_clock.offset_ms += delay_ms; // Earliest arrival
+			L76_clock.leak = 0;
+			delay_ms = 0;
+		} else if (delay_ms > 0 && ++L76_clock.leak >= L76LM33_CLOCK_LEAK) {
+			L76_clock.offset_ms++;
+			L76_clock.leak = 0;
+		}
+		L76_clock.delay_ms = delay_ms < UINT16_MAX ? delay_ms : UINT16_MAX;
+		if (L76_clock.delay_ms > L76_clock.max_delay_ms) {
+			L76_clock.max_delay_ms = L76_clock.delay_ms;
+		}
+		L76_clock.fixes++;
+	}
+	return L76_clock.utc_ms + L76_clock.offset_ms - L76LM33_OUTPUT_DELAY_MS;
+}
+
+/**
+ * UTC time of a sentence in ms of the day.
+ */
+static uint32_t L76LM33_UtcMs(const time_t *time) {
+	return ((uint32_t)time->hours * 60 + time->minutes) * 60000 + (uint32_t)(time->seconds * 1000.0f + 0.5f);
+}
+
 /**
  * Read and parse a NMEA GPRMC sentence into data structure. Call this function
- * frequently to have the latest GPS data available.
+ * frequently to have the latest GPS data available. GGA sentences update the altitude
+ * fields only (altitude_ms tells which fix it belongs to).
  *
- * Takes 0.3ms to complete when buffer is full
+ * Takes 0.3ms per sentence to complete when buffer is full
  *
  * @param L76_data: pointer to a L76LM33 structure to update.
  *
@@ -119,35 +754,126 @@ void L76LM33_RxCallback(UART_HandleTypeDef *huart) {
  *
  */
 int8_t L76LM33_Read(L76LM33 *L76_data) {
-	// Read sentence
-	int8_t valid = L76LM33_ReadSentence();
-	if (valid == -2) {
-		// Empty buffer, don't change structure
-		return -2;
-	} else if (valid != 0) {
-		L76_data->status = 0; // Bad status
-		return -1; // Error
+	int8_t status = -2;
+
+	L76LM33_Poll();
+
+	// Several sentences arrive between two reads at 10 Hz, the last one is kept
+	while (L76_new_line > 0) {
+		// Read sentence
+		int8_t valid = L76LM33_ReadSentence();
+		if (valid == -2) {
+			break; // Empty buffer
+		} else if (valid != 0) {
+			status = -1; // Error
+			continue;
+		}
+
+		// Acknowledges are handled in the receive interrupt, replies to the queries here
+		if (strncmp((char *)L76_NMEA_Buffer, "$PMTK", 5) == 0) {
+			if (L76_reply != NULL && strncmp((char *)L76_NMEA_Buffer, "$PMTK001,", 9) != 0
+					&& NMEA_ValidateChecksum((char *)L76_NMEA_Buffer) == 0) {
+				L76_reply((char *)L76_NMEA_Buffer);
+			}
+			continue;
+		}
+
+		// Altitude of the fix, after the RMC of the same fix (not a new position)
+		if (NMEA_ValidateGGA((char *)L76_NMEA_Buffer) == 0) {
+			if (NMEA_ParseGGA((char *)L76_NMEA_Buffer, &L76_gps_data) != 0) {
+				status = -1;
+				continue;
+			}
+			L76_data->altitude_fix = L76_gps_data.fix;
+			L76_data->satellites = L76_gps_data.satellites;
+			L76_data->altitude_m = L76_gps_data.altitude_m;
+			L76_data->altitude_ms = L76LM33_UpdateClock(L76LM33_UtcMs(&L76_gps_data.time),
+					L76_sentence_stamped ? L76_sentence_ms : L76_port.tick(), 0);
+			continue;
+		}
+
+		// Validate sentence ID is RMC
+		if (NMEA_ValidateRMC((char *)L76_NMEA_Buffer) != 0) {
+			status = -1; // Error, sentence ID is not RMC
+			continue;
+		}
+
+		// Parse NMEA RMC sentence to local structure
+		PROFILER_BEGIN(PROFILER_ZONE_NMEA_PARSERMC);
+		int8_t parsed = NMEA_ParseRMC((char *)L76_NMEA_Buffer, &L76_gps_data);
+		PROFILER_END(PROFILER_ZONE_NMEA_PARSERMC);
+		if (parsed != 0) {
+			status = -1;
+			continue;
+		}
+
+		// Fill L76LM33 structure
+		L76_data->fix = L76_gps_data.fix;
+		L76_data->longitude = L76_gps_data.longitude;
+		L76_data->latitude = L76_gps_data.latitude;
+		L76_data->latitude_e7 = L76_gps_data.latitude_e7;
+		L76_data->longitude_e7 = L76_gps_data.longitude_e7;
+		L76_data->speed_mps = L76_gps_data.speed_knots * L76LM33_KNOTS_TO_MPS;
+		L76_data->course_deg = L76_gps_data.course_deg;
+		L76_data->utc_ms = L76LM33_UtcMs(&L76_gps_data.time);
+		L76_data->year = L76_gps_data.date.year;
+		L76_data->month = L76_gps_data.date.month;
+		L76_data->day = L76_gps_data.date.day;
+		L76_data->rx_ms = L76_sentence_stamped ? L76_sentence_ms : L76_port.tick();
+		L76_data->fix_ms = L76LM33_UpdateClock(L76_data->utc_ms, L76_data->rx_ms,
+				L76_data->fix && L76_sentence_stamped);
+		status = 0;
 	}
 
-	// Validate sentence ID is RMC
-	if (NMEA_ValidateRMC((char *)L76_NMEA_Buffer) != 0) {
+	if (status == -1) {
 		L76_data->status = 0; // Bad status
-		return -1; // Error, sentence ID is not RMC
+	} else if (status == 0) {
+		L76_data->status = 1; // Good status (no error)
 	}
+	return status; // -2: empty buffer, struct unchanged
+}
 
-	// Parse NMEA RMC sentence to local structure
-	if (NMEA_ParseRMC((char *)L76_NMEA_Buffer, &L76_gps_data) != 0) {
-		L76_data->status = 0; // Bad status
-		return -1;
+/**
+ * Position of the last fix extrapolated to "now_ms" with its speed and course over ground
+ * (straight line), at most L76LM33_MAX_EXTRAPOLATION_MS ahead. Takes ~0.1 ms (soft float).
+ *
+ * @param L76_data: last fix (L76LM33_Read).
+ * @param now_ms: HAL tick to extrapolate to, not before the fix.
+ * @param position: extrapolated position and age of the fix.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, no fix
+ * @retval -3 Fix older than L76LM33_MAX_EXTRAPOLATION_MS, extrapolated this far only
+ */
+int8_t L76LM33_GetPosition(const L76LM33 *L76_data, uint32_t now_ms, L76LM33_Position *position) {
+	if (L76_data == NULL || position == NULL || !L76_data->fix) {
+		return -1; // Error, no fix
 	}
 
-	// Fill L76LM33 structure
-	L76_data->fix = L76_gps_data.fix;
-	L76_data->longitude = L76_gps_data.longitude;
-	L76_data->latitude = L76_gps_data.latitude;
+	int32_t age_ms = (int32_t)(now_ms - L76_data->fix_ms);
+	if (age_ms < 0) {
+		age_ms = 0; // Asked before the fix
+	}
+	uint32_t span_ms = age_ms < L76LM33_MAX_EXTRAPOLATION_MS ? age_ms : L76LM33_MAX_EXTRAPOLATION_MS;
+
+	float distance_m = L76_data->speed_mps * (float)span_ms / 1000.0f;
+	float course_rad = L76_data->course_deg * (float)M_PI / 180.0f;
+	float latitude_rad = L76_data->latitude * (float)M_PI / 180.0f;
+	float north_m = distance_m * cosf(course_rad);
+	float east_m = distance_m * sinf(course_rad);
+	position->latitude = L76_data->latitude + north_m / L76LM33_EARTH_RADIUS_M * 180.0f / (float)M_PI;
+	position->longitude = L76_data->longitude
+			+ east_m / (L76LM33_EARTH_RADIUS_M * cosf(latitude_rad)) * 180.0f / (float)M_PI;
+	position->age_ms = age_ms;
+
+	return age_ms > L76LM33_MAX_EXTRAPOLATION_MS ? -3 : 0;
+}
 
-	L76_data->status = 1; // Good status (no error)
-	return 0; // OK
+/**
+ * @return UTC to HAL tick mapping, refined by L76LM33_Read at each fix
+ */
+const L76LM33_Clock *L76LM33_GetClock() {
+	return &L76_clock;
 }
 
 /**
@@ -165,8 +891,13 @@ int8_t L76LM33_ReadSentence() {
 		return -2; // Error, empty UART circular buffer
 	}
 
-	// Reset flag
-	L76_new_line = 0;
+	// One line less (the interrupt may add one meanwhile), arrival of the oldest line
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	L76_sentence_stamped = L76_new_line <= L76LM33_LINE_TICKS;
+	L76_sentence_ms = L76_line_ms[(uint8_t)(L76_line_write - L76_new_line) & (L76LM33_LINE_TICKS - 1)];
+	L76_new_line--;
+	__set_PRIMASK(primask);
 
 	// Clear NMEA buffer
 	for (int16_t i = 0; i < sizeof(L76_NMEA_Buffer); i++) {
@@ -182,6 +913,7 @@ int8_t L76LM33_ReadSentence() {
 	for (uint16_t i = 0; i < 100; i++) {
 		// Read character from UART buffer
 		if (ring_buffer_dequeue(&L76_UART_Buffer, &c) != 1) {
+			L76_new_line = 0; // Lines overwritten (buffer full)
 			return -2; // Error, empty buffer
 		}
 
@@ -219,24 +951,3 @@ int8_t L76LM33_ReadSentence() {
 
 	return 0;
 }
-
-/**
- * Send array of character to L76LM33 using UART HAL functions.
- *
- * @param command[]: array of character to send.
- * @param size: size of the data to send.
- *
- * @retval 0 OK
- * @retval -1 ERROR
- */
-int8_t L76LM33_SendCommand(char command[], uint8_t size) {
-    if (command == NULL) {
-        return -1; // Error
-    }
-
-    if (HAL_UART_Transmit(L76_huart, (uint8_t *)command, size, L76LM33_UART_TIMEOUT) != HAL_OK) {
-    	return -1; // Error with UART
-    }
-
-    return 0; // OK
-}
@@ -1,7 +1,9 @@
 /*
  * NMEA.c
  *
- * Module to parse the time and the latitude/longitude from a RMC NMEA sentence.
+ * Module to parse the time, the latitude/longitude, the speed/course over ground and the date
+ * from a RMC NMEA sentence, and the altitude from a GGA sentence. Latitude and longitude are also
+ * given in 1e-7 degrees parsed without float (a float keeps ~0.5 m at these angles).
  *
  *  Created on: May 12, 2024
  *      Author: gagnon
@@ -32,6 +34,222 @@ int8_t NMEA_ValidateRMC(const char *nmea_sentence) {
 	return strncmp(nmea_sentence+3, "RMC", 3) == 0 ? 0 : -1;
 }
 
+/**
+ * Validate the NMEA sentence ID is GGA ($xxGGA).
+ * $GNGGA,080608.000,3029.461489,N,11430.072002,E,1,12,0.87,23.6,M,-14.2,M,,*6B
+ *
+ * @param nmea_sentence: pointer to sentence array.
+ *
+ * @retval 0 GGA sentence
+ * @retval -1 Not a GGA sentence
+ */
+int8_t NMEA_ValidateGGA(const char *nmea_sentence) {
+	return strncmp(nmea_sentence+3, "GGA", 3) == 0 ? 0 : -1;
+}
+
+/**
+ * Validate the checksum of a NMEA sentence: XOR of the characters between '$' and '*',
+ * as two hexadecimal digits after '*'.
+ * $GNRMC,080608.000,A,3029.461489,N,11430.072002,E,0.00,148.41,210423,,,D,V*09
+ *
+ * @param nmea_sentence: pointer to sentence array (NULL terminated).
+ *
+ * @retval 0 Valid checksum
+ * @retval -1 Bad checksum or no checksum
+ */
+int8_t NMEA_ValidateChecksum(const char *nmea_sentence) {
+	if (nmea_sentence == NULL || nmea_sentence[0] != '$') {
+		return -1; // Error, not a sentence
+	}
+
+	uint8_t checksum = 0;
+	const char *c = nmea_sentence + 1;
+	for (uint8_t i = 0; i < NMEA_MAX_RMC_LENGTH && *c != '*'; i++, c++) {
+		if (*c == '\0' || *c == '$' || *c == '\r' || *c == '\n') {
+			return -1; // Error, no checksum
+		}
+		checksum ^= (uint8_t)*c;
+	}
+	if (*c != '*') {
+		return -1; // Error, sentence too long
+	}
+
+	uint8_t value = 0;
+	for (uint8_t i = 1; i <= 2; i++) {
+		char digit = c[i];
+		value <<= 4;
+		if (digit >= '0' && digit <= '9') {
+			value |= digit - '0';
+		} else if (digit >= 'A' && digit <= 'F') {
+			value |= digit - 'A' + 10;
+		} else {
+			return -1; // Error, not an hexadecimal digit
+		}
+	}
+	return value == checksum ? 0 : -1;
+}
+
+/**
+ * Parse the time field hhmmss(.sss).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+static int8_t NMEA_ParseTime(const char *token, time_t *time) {
+	if (strnlen(token, 6) < 6) { // hhmmss.sss = 10 char, minimum is 6 char
+		return -1; // Error with sentence
+	}
+
+	if (strnlen(token, 10) > 6 && token[6] != '.') { // Ensure dot position if seconds are float
+		return -1; // Error with sentence
+	}
+
+	char hours[3] = "00"; // hh\0 = 3 char. Default value because strncpy doesn't add \0 at the end
+	strncpy(hours, token, 2);
+	time->hours = atoi(hours);
+
+	char minutes[3] = "00"; // mm\0 = 3 char
+	strncpy(minutes, token+2, 2);
+	time->minutes = atoi(minutes);
+
+	char seconds[7] = "00.000"; // ss.sss\0 = 7 char
+	strncpy(seconds, token+4, 6);
+	time->seconds = atof(seconds);
+	return 0;
+}
+
+/**
+ * Parse the date field ddmmyy, empty field: date unknown (day 0).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+static int8_t NMEA_ParseDate(const char *token, date_t *date) {
+	date->day = 0;
+	date->month = 0;
+	date->year = 0;
+	if (token[0] == '\0') {
+		return 0; // Date unknown
+	}
+
+	uint8_t digits[6];
+	for (uint8_t i = 0; i < 6; i++) {
+		if (token[i] < '0' || token[i] > '9') {
+			return -1; // Error with sentence (too short or not a number)
+		}
+		digits[i] = token[i] - '0';
+	}
+	uint8_t day = digits[0] * 10 + digits[1];
+	uint8_t month = digits[2] * 10 + digits[3];
+	if (token[6] != '\0' || day < 1 || day > 31 || month < 1 || month > 12) {
+		return -1; // Error with sentence
+	}
+
+	date->day = day;
+	date->month = month;
+	date->year = 2000 + digits[4] * 10 + digits[5];
+	return 0;
+}
+
+/**
+ * Coordinate dd(d)mm.mmmmmm (4 to 6 decimals) to 1e-7 degrees, in integers.
+ *
+ * @param degree_digits: 2 for a latitude, 3 for a longitude.
+ */
+static int32_t NMEA_ParseCoordinate(const char *token, uint8_t degree_digits) {
+	int32_t degrees = 0;
+	for (uint8_t i = 0; i < degree_digits; i++) {
+		degrees = degrees * 10 + (token[i] - '0');
+	}
+
+	const char *c = token + degree_digits;
+	int32_t minutes_e6 = ((c[0] - '0') * 10 + (c[1] - '0')) * 1000000;
+	int32_t scale = 100000;
+	for (c += 3; *c >= '0' && *c <= '9' && scale > 0; c++, scale /= 10) {
+		minutes_e6 += (*c - '0') * scale;
+	}
+
+	return degrees * 10000000 + (minutes_e6 + 3) / 6; // 1e7 / 60 / 1e6, rounded
+}
+
+/**
+ * Parse the latitude field ddmm.mmmmmm (4 to 6 decimals).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+static int8_t NMEA_ParseLatitude(const char *token, GPS_Data *gps_data) {
+	if (strnlen(token, 9) < 9 || token[4] != '.') {
+		return -1; // Error with sentence
+	}
+
+	char degrees[3] = "00"; // dd\0 = 3 char. Default value because strncpy doesn't add \0 at the end
+	strncpy(degrees, token, 2);
+
+	char minutes[10] = "00.000000"; // mm.mmmmmm\0 = 10 char max
+	strncpy(minutes, token+2, 9);
+
+	gps_data->latitude = atoi(degrees) + atof(minutes) / 60; // Degrees Minutes to Degrees Decimal conversion
+	gps_data->latitude_e7 = NMEA_ParseCoordinate(token, 2);
+	return 0;
+}
+
+/**
+ * Parse the longitude field dddmm.mmmmmm (4 to 6 decimals).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+static int8_t NMEA_ParseLongitude(const char *token, GPS_Data *gps_data) {
+	if (strnlen(token, 10) < 10 || token[5] != '.') {
+		return -1; // Error with sentence
+	}
+
+	char degrees[4] = "000"; // ddd\0 = 4 char. Default value because strncpy doesn't add \0 at the end
+	strncpy(degrees, token, 3);
+
+	char minutes[10] = "00.000000"; // mm.mmmmmm\0 = 10 char max
+	strncpy(minutes, token+3, 9);
+
+	gps_data->longitude = atoi(degrees) + atof(minutes) / 60; // Degrees Minutes to Degrees Decimal conversion
+	gps_data->longitude_e7 = NMEA_ParseCoordinate(token, 3);
+	return 0;
+}
+
+/**
+ * Apply a hemisphere indicator (N/S or E/W) to a coordinate.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, not "positive" or "negative"
+ */
+static int8_t NMEA_ParseIndicator(const char *token, char positive, char negative, float *value, int32_t *value_e7) {
+	int8_t sign;
+
+	// Ensure token is N/S or E/W, else throw error
+	if (token[0] == positive) {
+		sign = 1;
+	} else if (token[0] == negative) {
+		sign = -1;
+	} else {
+		return -1; // Error with sentence
+	}
+
+	*value *= sign; // Change the sign depending on indicator
+	*value_e7 *= sign;
+	return 0;
+}
+
+/**
+ * No position: latitude, longitude and altitude are 0.
+ */
+static void NMEA_ClearPosition(GPS_Data *gps_data) {
+	gps_data->latitude = 0;
+	gps_data->longitude = 0;
+	gps_data->latitude_e7 = 0;
+	gps_data->longitude_e7 = 0;
+	gps_data->altitude_m = 0;
+}
+
 /**
  * Parse NMEA RMC sentence ($xxRMC).
  * $GNRMC,080608.000,A,3029.461489,N,11430.072002,E,0.00,148.41,210423,,,D,V*09
@@ -52,42 +270,34 @@ int8_t NMEA_ParseRMC(const char *nmea_sentence, GPS_Data *gps_data) {
         return -1; // Error, NULL sentence or structure
     }
 
-    // Copy because strtok messes the string by replacing delimiter with \0
+    // Copy because strsep messes the string by replacing delimiter with \0
     // and causes HardFault when called on literal string nmea_sentence
-    char *copy = strndup(nmea_sentence, NMEA_MAX_RMC_LENGTH);
-    if (!copy) {
-        return -1; // Error while duplicating string
-    }
+    // (on the stack, nothing to free on the error returns)
+    char copy[NMEA_MAX_RMC_LENGTH + 1];
+    strncpy(copy, nmea_sentence, NMEA_MAX_RMC_LENGTH);
+    copy[NMEA_MAX_RMC_LENGTH] = '\0';
 
     int8_t tok_idx = 0; // Current field index
+    char *cursor = copy;
     char *token;
 
-    // Read first field
-    token = strtok(copy, ",");
+    // Not moving when the fields are missing
+    gps_data->speed_knots = 0;
+    gps_data->course_deg = 0;
+    gps_data->date.day = 0;
+    gps_data->date.month = 0;
+    gps_data->date.year = 0;
+
+    // Read first field (strsep keeps the empty fields, speed and course can be empty)
+    token = strsep(&cursor, ",");
 
-    // Only read lat/lon and avoid infinite loop
+    // Only read up to the date and avoid infinite loop
     while (token != NULL && tok_idx < NMEA_MAX_TOKEN_TO_READ) {
     	if (tok_idx == 1) { // TIME
-    		if (strnlen(token, 6) < 6) { // hhmmss.sss = 10 char, minimum is 6 char
+    		if (NMEA_ParseTime(token, &gps_data->time) != 0) {
     			return -1; // Error with sentence
     		}
 
-    		if (strnlen(token, 10) > 6 && token[6] != '.') { // Ensure dot position if seconds are float
-    			return -1; // Error with sentence
-    		}
-
-    		char hours[3] = "00"; // hh\0 = 3 char. Default value because strncpy doesn't add \0 at the end
-    		strncpy(hours, token, 2);
-    		gps_data->time.hours = atoi(hours);
-
-    		char minutes[3] = "00"; // mm\0 = 3 char
-    		strncpy(minutes, token+2, 2);
-    		gps_data->time.minutes = atoi(minutes);
-
-    		char seconds[7] = "00.000"; // ss.sss\0 = 7 char
-    		strncpy(seconds, token+4, 6);
-    		gps_data->time.seconds = atof(seconds);
-
     	} else if (tok_idx == 2) { // GPS FIX
     		// Ensure validity is A or V, else throw error
     		if (token[0] == 'A') {
@@ -99,73 +309,133 @@ int8_t NMEA_ParseRMC(const char *nmea_sentence, GPS_Data *gps_data) {
     		}
 
     		if (gps_data->fix == 0) {
-    			gps_data->latitude = 0;
-    			gps_data->longitude = 0;
+    			NMEA_ClearPosition(gps_data);
     			break; // No fix, so lat/lon are empty
     		}
 
     	} else if (tok_idx == 3) { // LATITUDE
-    		// token = ddmm.mmmmmm (4 to 6 decimals)
-    		if (strnlen(token, 9) < 9 || token[4] != '.') { //strlen au lieu de strnlen puisqu'on utilise déjà strtok, donc il y a assurément un \0 à la fin?
+    		if (NMEA_ParseLatitude(token, gps_data) != 0) {
+    			return -1; // Error with sentence
+    		}
+
+    	} else if (tok_idx == 4) { // LATITUDE INDICATOR
+    		if (NMEA_ParseIndicator(token, 'N', 'S', &gps_data->latitude, &gps_data->latitude_e7) != 0) {
     			return -1; // Error with sentence
     		}
 
-    		char degrees[3] = "00"; // dd\0 = 3 char. Default value because strncpy doesn't add \0 at the end
-    		strncpy(degrees, token, 2);
+    	} else if (tok_idx == 5) { // LONGITUDE
+    		if (NMEA_ParseLongitude(token, gps_data) != 0) {
+    			return -1; // Error with sentence
+    		}
 
-    		char minutes[10] = "00.000000"; // mm.mmmmmm\0 = 10 char max
-    		strncpy(minutes, token+2, 9);
+    	} else if (tok_idx == 6) { // LONGITUDE INDICATOR
+    		if (NMEA_ParseIndicator(token, 'E', 'W', &gps_data->longitude, &gps_data->longitude_e7) != 0) {
+    			return -1; // Error with sentence
+    		}
 
-    		gps_data->latitude = atoi(degrees) + atof(minutes) / 60; // Degrees Minutes to Degrees Decimal conversion
+    	} else if (tok_idx == 7) { // SPEED OVER GROUND (knots)
+    		gps_data->speed_knots = atof(token); // 0 if empty
 
-    	} else if (tok_idx == 4) { // LATITUDE INDICATOR
-    		int8_t sign;
+    	} else if (tok_idx == 8) { // COURSE OVER GROUND (degrees from true north)
+    		gps_data->course_deg = atof(token); // 0 if empty
 
-    		// Ensure token is N or S, else throw error
-    		if (token[0] == 'N') {
-    			sign = 1;
-    		} else if (token[0] == 'S') {
-    			sign = -1;
-    		} else {
+    	} else if (tok_idx == 9) { // DATE (ddmmyy)
+    		if (NMEA_ParseDate(token, &gps_data->date) != 0) {
     			return -1; // Error with sentence
     		}
+    	}
+
+        token = strsep(&cursor, ",");
+        tok_idx++;
+    }
 
-    		gps_data->latitude *= sign; // Change the sign of latitude depending on indicator
+    return 0;
+}
 
-    	} else if (tok_idx == 5) { // LONGITUDE
-    		// token = dddmm.mmmmmm (4 to 6 decimals)
-    		if (strnlen(token, 10) < 10 || token[5] != '.') { //strlen au lieu de strnlen puisqu'on utilise déjà strtok, donc il y a assurément un \0 à la fin?
+/**
+ * Parse NMEA GGA sentence ($xxGGA): time, position, fix quality, satellites used and
+ * altitude above mean sea level.
+ * $GNGGA,080608.000,3029.461489,N,11430.072002,E,1,12,0.87,23.6,M,-14.2,M,,*6B
+ *
+ * Latitude, longitude and altitude are 0.0 if there's no GPS fix (quality 0).
+ * Speed and course are not changed (RMC only).
+ *
+ * @param nmea_sentence: pointer to sentence array.
+ * @param gps_data: pointer to structure to fill with parsed data.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t NMEA_ParseGGA(const char *nmea_sentence, GPS_Data *gps_data) {
+    if (!nmea_sentence || !gps_data) {
+        return -1; // Error, NULL sentence or structure
+    }
+
+    char copy[NMEA_MAX_RMC_LENGTH + 1];
+    strncpy(copy, nmea_sentence, NMEA_MAX_RMC_LENGTH);
+    copy[NMEA_MAX_RMC_LENGTH] = '\0';
+
+    int8_t tok_idx = 0; // Current field index
+    char *cursor = copy;
+    char *token = strsep(&cursor, ",");
+
+    gps_data->satellites = 0;
+
+    // Only read up to the altitude and avoid infinite loop
+    while (token != NULL && tok_idx < NMEA_MAX_GGA_TOKEN_TO_READ) {
+    	if (tok_idx == 1) { // TIME
+    		if (NMEA_ParseTime(token, &gps_data->time) != 0) {
     			return -1; // Error with sentence
     		}
 
-    		char degrees[4] = "000"; // ddd\0 = 4 char. Default value because strncpy doesn't add \0 at the end
-    		strncpy(degrees, token, 3);
+    	} else if (tok_idx == 2) { // LATITUDE, empty without fix (quality comes later)
+    		if (token[0] == '\0') {
+    			gps_data->fix = 0;
+    			NMEA_ClearPosition(gps_data);
+    			break;
+    		}
+    		if (NMEA_ParseLatitude(token, gps_data) != 0) {
+    			return -1; // Error with sentence
+    		}
 
-    		char minutes[10] = "00.000000"; // mm.mmmmmm\0 = 10 char max
-    		strncpy(minutes, token+3, 9);
+    	} else if (tok_idx == 3) { // LATITUDE INDICATOR
+    		if (NMEA_ParseIndicator(token, 'N', 'S', &gps_data->latitude, &gps_data->latitude_e7) != 0) {
+    			return -1; // Error with sentence
+    		}
 
-    		gps_data->longitude = atoi(degrees) + atof(minutes) / 60; // Degrees Minutes to Degrees Decimal conversion
+    	} else if (tok_idx == 4) { // LONGITUDE
+    		if (NMEA_ParseLongitude(token, gps_data) != 0) {
+    			return -1; // Error with sentence
+    		}
 
-    	} else if (tok_idx == 6) { // LONGITUDE INDICATOR
-    		int8_t sign;
+    	} else if (tok_idx == 5) { // LONGITUDE INDICATOR
+    		if (NMEA_ParseIndicator(token, 'E', 'W', &gps_data->longitude, &gps_data->longitude_e7) != 0) {
+    			return -1; // Error with sentence
+    		}
 
-    		// Ensure token is E or W, else throw error
-    		if (token[0] == 'E') {
-    			sign = 1;
-    		} else if (token[0] == 'W') {
-    			sign = -1;
-    		} else {
+    	} else if (tok_idx == 6) { // FIX QUALITY, 0: invalid, 1: GPS, 2: DGPS, 6: estimated
+    		if (token[0] < '0' || token[0] > '9') {
     			return -1; // Error with sentence
     		}
+    		gps_data->fix = token[0] != '0';
+    		if (gps_data->fix == 0) {
+    			NMEA_ClearPosition(gps_data);
+    			break;
+    		}
+
+    	} else if (tok_idx == 7) { // SATELLITES USED
+    		gps_data->satellites = atoi(token);
 
-    		gps_data->longitude *= sign;
+    	} else if (tok_idx == 9) { // ALTITUDE above mean sea level (m)
+    		if (token[0] == '\0') {
+    			return -1; // Error, fix without altitude
+    		}
+    		gps_data->altitude_m = atof(token);
     	}
 
-        token = strtok(NULL, ",");
+        token = strsep(&cursor, ",");
         tok_idx++;
     }
 
-    free(copy);
     return 0;
 }
-
@@ -0,0 +1,273 @@
+/*
+ * RFD900.c
+ *
+ * Frame queue for the RFD900 radio (USART1 TX with DMA).
+ *
+ * Frames are copied in fixed slots of a ring: "head" is the next free slot and "tail" the
+ * next frame to send. When a transmission starts, the frame is copied in the DMA buffer and
+ * its slot is freed (double buffering), so the queue never holds the frame being sent and
+ * dropping the oldest waiting frame is only "tail++". Copying RFD900_FRAME_SIZE bytes takes
+ * much less than the 50 ms to send them at 9600 baud.
+ *
+ * The queue is shared between the tasks (RFD900_Send) and the TX complete interrupt
+ * (RFD900_TxCallback), indexes are updated with interrupts disabled.
+ *
+ * DMA1 Channel4 is shared with SPI2_RX (DMASHARE.h): while an IMU burst read has the
+ * channel, the next frame stays in the queue and RFD900_Resume starts it at the release.
+ * The channel is released at the end of each frame, so a burst read waits one frame at
+ * most: 50 ms for RFD900_FRAME_SIZE bytes (26 ms for PACKET_MAX_FRAME_SIZE), within the
+ * 72 ms the ICM20602 FIFO holds at 1 kHz.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/RFD900.h"
+#include "GAUL_Drivers/DMASHARE.h"
+#include "GAUL_System/PACKET.h"
+
+#include <string.h>
+
+#if PACKET_MAX_FRAME_SIZE > RFD900_FRAME_SIZE
+#error "RFD900_FRAME_SIZE smaller than a PACKET frame"
+#endif
+
+#define RFD900_MASK (RFD900_QUEUE_SIZE - 1)
+
+static UART_HandleTypeDef *RFD_huart = NULL;
+static RFD900_Transmit RFD_transmit = NULL;
+static uint8_t RFD_policy = RFD900_DROP_NEWEST;
+
+static uint8_t RFD_frames[RFD900_QUEUE_SIZE][RFD900_FRAME_SIZE];
+static uint8_t RFD_dma_buffer[RFD900_FRAME_SIZE]; // Frame being sent
+static uint16_t RFD_sizes[RFD900_QUEUE_SIZE];
+static volatile uint8_t RFD_head = 0; // Next free slot (free running)
+static volatile uint8_t RFD_tail = 0; // Next frame to send (free running)
+static volatile uint8_t RFD_busy = 0; // 1: DMA transmission in progress
+static uint16_t RFD_active_size = 0;  // Size of the frame being sent
+static RFD900_Stats RFD_stats;
+static RFD900_Receive RFD_receive = NULL;
+static uint8_t RFD_received_byte;
+
+/**
+ * Start a DMA transmission with the HAL, on the shared DMA channel.
+ *
+ * @retval 0 OK
+ * @retval -1 UART ERROR or BUSY
+ * @retval -2 BUSY, DMA channel used by SPI2_RX
+ */
+static int8_t RFD900_TransmitDMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+	int8_t status = DMASHARE_Acquire(DMASHARE_USER_USART1_TX);
+	if (status != 0) {
+		return status; // -2: RFD900_Resume at the release
+	}
+	if (HAL_UART_Transmit_DMA(huart, (uint8_t *)data, size) != HAL_OK) {
+		DMASHARE_Release(DMASHARE_USER_USART1_TX);
+		return -1; // UART ERROR
+	}
+	return 0; // OK
+}
+
+/**
+ * Start the next waiting frame if the UART is free. Must be called with interrupts disabled.
+ * A frame that cannot be started is lost (counted in errors), so a broken UART does not
+ * block the queue. A frame refused because the DMA channel is busy stays first in the
+ * queue until RFD900_Resume.
+ */
+static void RFD900_StartNext() {
+	while (!RFD_busy && RFD_tail != RFD_head) {
+		uint8_t slot = RFD_tail & RFD900_MASK;
+		RFD_active_size = RFD_sizes[slot];
+		memcpy(RFD_dma_buffer, RFD_frames[slot], RFD_active_size);
+		RFD_tail++;
+		RFD_busy = 1;
+		int8_t status = RFD_transmit(RFD_huart, RFD_dma_buffer, RFD_active_size);
+		if (status == -2) {
+			RFD_tail--; // Put the frame back
+			RFD_busy = 0;
+			RFD_stats.channel_waits++;
+			return;
+		}
+		if (status != 0) {
+			RFD_busy = 0;
+			RFD_stats.errors++;
+		}
+	}
+}
+
+/**
+ * Empty the queue and reset statistics. USART1 and its TX DMA channel must be initialized,
+ * RFD900_Resume must be the DMASHARE resume function of USART1_TX.
+ *
+ * @param huart: UART connected to the RFD900 (&huart1).
+ * @param policy: RFD900_DROP_NEWEST or RFD900_DROP_OLDEST.
+ * @param transmit: function starting a transmission, NULL to use the DMA.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, invalid parameter
+ */
+int8_t RFD900_Init(UART_HandleTypeDef *huart, uint8_t policy, RFD900_Transmit transmit) {
+	if (huart == NULL || policy > RFD900_DROP_OLDEST) {
+		return -1; // Error
+	}
+
+	RFD_huart = huart;
+	RFD_policy = policy;
+	RFD_transmit = transmit == NULL ? RFD900_TransmitDMA : transmit;
+	RFD_head = 0;
+	RFD_tail = 0;
+	RFD_busy = 0;
+	RFD_active_size = 0;
+	RFD_receive = NULL;
+	memset(&RFD_stats, 0, sizeof(RFD_stats));
+
+	return 0; // OK
+}
+
+/**
+ * Queue a frame and return without waiting for the transmission.
+ *
+ * @param data: frame to send, copied in the queue.
+ * @param size: number of bytes (RFD900_FRAME_SIZE at most).
+ *
+ * @retval 0 OK, queued (with RFD900_DROP_OLDEST, the oldest waiting frame may be dropped)
+ * @retval -1 ERROR, not initialized or invalid size
+ * @retval -2 DROPPED, queue full (RFD900_DROP_NEWEST)
+ */
+int8_t RFD900_Send(const uint8_t data[], uint16_t size) {
+	if (RFD_huart == NULL || data == NULL || size == 0 || size > RFD900_FRAME_SIZE) {
+		return -1; // Error
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if ((uint8_t)(RFD_head - RFD_tail) >= RFD900_QUEUE_SIZE) {
+		if (RFD_policy == RFD900_DROP_NEWEST) {
+			RFD_stats.dropped_newest++;
+			__set_PRIMASK(primask);
+			return -2; // Dropped
+		}
+		RFD_tail++; // Drop the oldest waiting frame (the frame being sent is not in the queue)
+		RFD_stats.dropped_oldest++;
+	}
+
+	uint8_t slot = RFD_head & RFD900_MASK;
+	memcpy(RFD_frames[slot], data, size);
+	RFD_sizes[slot] = size;
+	RFD_head++;
+	RFD_stats.queued++;
+
+	uint8_t pending = RFD_head - RFD_tail;
+	if (pending > RFD_stats.max_pending) {
+		RFD_stats.max_pending = pending;
+	}
+
+	RFD900_StartNext();
+
+	__set_PRIMASK(primask);
+	return 0; // OK
+}
+
+/**
+ * Frame sent, start the next one. Call from HAL_UART_TxCpltCallback.
+ *
+ * @param huart: UART of the interrupt, ignored if it is not the RFD900 UART.
+ */
+void RFD900_TxCallback(UART_HandleTypeDef *huart) {
+	if (huart != RFD_huart || !RFD_busy) {
+		return;
+	}
+	if (RFD_transmit == RFD900_TransmitDMA) {
+		DMASHARE_Release(DMASHARE_USER_USART1_TX); // A waiting burst read goes before the next frame
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	RFD_stats.sent++;
+	RFD_stats.sent_bytes += RFD_active_size;
+	RFD_busy = 0;
+	RFD900_StartNext();
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * The DMA channel is free again (DMASHARE resume), start the waiting frame.
+ */
+void RFD900_Resume() {
+	if (RFD_huart == NULL) {
+		return;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	RFD900_StartNext();
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Receive the bytes of the ground station with interrupts (one byte at a time, no DMA: the
+ * channel of USART1_RX is not shared).
+ *
+ * @param receive: called with each byte from the receive interrupt.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, not initialized or UART error
+ */
+int8_t RFD900_StartReceive(RFD900_Receive receive) {
+	if (RFD_huart == NULL || receive == NULL) {
+		return -1; // Error
+	}
+	RFD_receive = receive;
+	return HAL_UART_Receive_IT(RFD_huart, &RFD_received_byte, 1) == HAL_OK ? 0 : -1;
+}
+
+/**
+ * Byte received, given to the receive function and the next one started. Call from
+ * HAL_UART_RxCpltCallback.
+ *
+ * @param huart: UART of the interrupt, ignored if it is not the RFD900 UART.
+ */
+void RFD900_RxCallback(UART_HandleTypeDef *huart) {
+	if (huart != RFD_huart || RFD_receive == NULL) {
+		return;
+	}
+	RFD_stats.received++;
+	RFD_receive(RFD_received_byte);
+	HAL_UART_Receive_IT(RFD_huart, &RFD_received_byte, 1);
+}
+
+/**
+ * Restart the reception stopped by the HAL after an overrun (UARTERR restart, called from
+ * the USART1 interrupt).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, UART error
+ * @retval -2 not receiving (RFD900_StartReceive not called)
+ */
+int8_t RFD900_RestartReceive() {
+	if (RFD_huart == NULL || RFD_receive == NULL) {
+		return -2; // Not receiving
+	}
+	return HAL_UART_Receive_IT(RFD_huart, &RFD_received_byte, 1) == HAL_OK ? 0 : -1;
+}
+
+/**
+ * @return number of frames waiting (not including the frame being sent)
+ */
+uint8_t RFD900_Pending() {
+	return RFD_head - RFD_tail;
+}
+
+/**
+ * @retval 1 a frame is being sent
+ */
+uint8_t RFD900_Busy() {
+	return RFD_busy;
+}
+
+const RFD900_Stats *RFD900_GetStats() {
+	return &RFD_stats;
+}
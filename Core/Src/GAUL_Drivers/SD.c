@@ -0,0 +1,542 @@
+/*
+ * SD.c
+ *
+ * SD card in SPI mode.
+ *
+ * A multi-block write (CMD25) stays open for the whole flight, so each block costs only
+ * its transfer and the programming time, without a command. A block goes through:
+ * SD_WriteNext (one SPI bus transaction: start token, DMA of 512 bytes, then CRC and data
+ * response, card deselected) -> SD_TxCallback (transaction complete) -> SD_Poll (data
+ * response) -> SD_Poll (one byte per call until the card releases MISO at 0xFF) -> ready
+ * for the next block. The block is queued at low priority on the bus, the IMU and the
+ * barometer go first. Each SD_Poll call exchanges one byte at most, it never waits for
+ * the card.
+ *
+ * A card keeps driving MISO until it sees a clock with its CS high: every deselection is
+ * followed by one dummy byte (SPIBUS_DEVICE_RELEASE_MISO), so the other devices can use
+ * the bus right after.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/SD.h"
+#include "GAUL_Drivers/SPIBUS.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define SD_RESPONSE_TRIES 10 // Bytes before R1 (NCR is 8 bytes at most)
+#define SD_TRAILER_SIZE   (2 + SD_RESPONSE_TRIES) // CRC and data response of a block
+
+static SPI_HandleTypeDef *SD_hspi = NULL;
+static SD_Port SD_port;
+
+// SPI bus
+static int8_t SD_device = -1;
+static uint8_t SD_selected = 0;
+static SPIBUS_Transaction SD_transaction;
+static uint8_t *SD_bus_trailer;
+static uint8_t SD_trailer[SD_TRAILER_SIZE];
+
+static uint8_t SD_type = SD_TYPE_NONE;
+static volatile uint8_t SD_state = SD_STATE_IDLE;
+static uint32_t SD_busy_start_ms;
+static uint8_t SD_timed_out;      // Timeout of the current busy time already counted
+static SD_Stats SD_stats;
+
+static void SD_BusSelect(uint8_t selected) {
+	if (selected) {
+		SD_selected = SPIBUS_Select(SD_device) == 0; // Timeout: bytes read as 0xFF
+	} else if (SD_selected) {
+		SD_selected = 0;
+		SPIBUS_Deselect(SD_device); // With the byte releasing MISO
+	}
+}
+
+static uint8_t SD_BusExchange(uint8_t byte) {
+	if (!SD_selected) {
+		SPIBUS_Clock(SD_device, 1); // CS high (initialization clocks)
+		return 0xFF;
+	}
+	return SPIBUS_Exchange(byte);
+}
+
+static void SD_BusWriteDone(SPIBUS_Transaction *transaction) {
+	memcpy(SD_bus_trailer, transaction->trailer, transaction->trailer_size);
+	SD_TxCallback(SD_hspi);
+}
+
+static int8_t SD_BusWriteDMA(uint8_t token, const uint8_t data[], uint16_t size, uint8_t trailer[],
+		uint8_t trailer_size) {
+	SD_transaction = (SPIBUS_Transaction) {
+		.device = SD_device,
+		.priority = SPIBUS_PRIORITY_LOW,
+		.header = { 0xFF, token },
+		.header_size = 2,
+		.tx = data,
+		.size = size,
+		.trailer_size = trailer_size,
+		.callback = SD_BusWriteDone,
+	};
+	SD_bus_trailer = trailer;
+	return SPIBUS_Submit(&SD_transaction) == 0 ? 0 : -1;
+}
+
+static void SD_BusSetFast(uint8_t fast) {
+	SPIBUS_SetPrescaler(SD_device, fast ? SD_FAST_PRESCALER : SD_SLOW_PRESCALER);
+}
+
+static void SD_Select() {
+	SD_port.select(1);
+}
+
+static void SD_Deselect() {
+	SD_port.select(0); // Releases MISO
+}
+
+/**
+ * Send a command and read its R1 response. CS must be low.
+ *
+ * @return R1, 0xFF if no response
+ */
+static uint8_t SD_Command(uint8_t command, uint32_t argument) {
+	uint8_t crc = 0x01; // CRC is only checked for CMD0 and CMD8 in SPI mode
+	if (command == SD_CMD0) {
+		crc = 0x95;
+	} else if (command == SD_CMD8) {
+		crc = 0x87;
+	}
+
+	SD_port.exchange(0xFF);
+	SD_port.exchange(0x40 | command);
+	SD_port.exchange(argument >> 24);
+	SD_port.exchange(argument >> 16);
+	SD_port.exchange(argument >> 8);
+	SD_port.exchange(argument);
+	SD_port.exchange(crc);
+	if (command == SD_CMD12) {
+		SD_port.exchange(0xFF); // Stuff byte
+	}
+
+	uint8_t r1 = 0xFF;
+	for (uint8_t i = 0; i < SD_RESPONSE_TRIES && (r1 & 0x80); i++) {
+		r1 = SD_port.exchange(0xFF);
+	}
+	return r1;
+}
+
+static uint8_t SD_AppCommand(uint8_t command, uint32_t argument) {
+	uint8_t r1 = SD_Command(SD_CMD55, 0);
+	if (r1 > SD_R1_IDLE) {
+		return r1;
+	}
+	return SD_Command(command, argument);
+}
+
+/**
+ * Wait until the card releases MISO (end of a busy time). CS must be low.
+ *
+ * @retval 0 OK
+ * @retval -3 TIMEOUT
+ */
+static int8_t SD_WaitReady(uint32_t timeout_ms) {
+	uint32_t start_ms = HAL_GetTick();
+	while (SD_port.exchange(0xFF) != 0xFF) {
+		if (HAL_GetTick() - start_ms > timeout_ms) {
+			return -3; // Timeout
+		}
+	}
+	return 0; // OK
+}
+
+static uint32_t SD_Address(uint32_t block) {
+	return SD_type == SD_TYPE_SDHC ? block : block * SD_BLOCK_SIZE;
+}
+
+/**
+ * Initialize the card (blocking, up to SD_INIT_TIMEOUT_MS). The card is added to the SPI
+ * bus (SPIBUS_Init must be done), SD_FAST_PRESCALER is used after the initialization.
+ *
+ * @param hspi: SPI connected to the card (&hspi2).
+ * @param port: SPI access functions, NULL (or NULL members) to use the SPI bus.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, no card (no response to CMD0)
+ * @retval -2 ERROR, unsupported card (MMC, voltage or block size)
+ * @retval -3 ERROR, timeout during initialization
+ */
+int8_t SD_Init(SPI_HandleTypeDef *hspi, const SD_Port *port) {
+	if (hspi == NULL) {
+		return -1; // Error
+	}
+
+	SD_hspi = hspi;
+	SD_device = SPIBUS_AddDevice(SD_CS_GPIO_Port, SD_CS_Pin, SD_SLOW_PRESCALER, SPIBUS_DEVICE_RELEASE_MISO);
+	SD_selected = 0;
+	SD_port.select = port != NULL && port->select != NULL ? port->select : SD_BusSelect;
+	SD_port.exchange = port != NULL && port->exchange != NULL ? port->exchange : SD_BusExchange;
+	SD_port.write_dma = port != NULL && port->write_dma != NULL ? port->write_dma : SD_BusWriteDMA;
+	SD_port.set_fast = port != NULL && port->set_fast != NULL ? port->set_fast : SD_BusSetFast;
+	SD_type = SD_TYPE_NONE;
+	SD_state = SD_STATE_IDLE;
+	memset(&SD_stats, 0, sizeof(SD_stats));
+
+	// At least 74 clocks with CS high to enter native mode
+	SD_port.set_fast(0);
+	SD_port.select(0);
+	for (uint8_t i = 0; i < 10; i++) {
+		SD_port.exchange(0xFF);
+	}
+
+	SD_Select();
+	uint8_t r1 = 0xFF;
+	for (uint8_t i = 0; i < 10 && r1 != SD_R1_IDLE; i++) {
+		r1 = SD_Command(SD_CMD0, 0);
+	}
+	if (r1 != SD_R1_IDLE) {
+		SD_Deselect();
+		return -1; // Error, no card
+	}
+
+	// CMD8 is illegal on version 1 cards (SDSC only)
+	uint8_t version2 = 0;
+	r1 = SD_Command(SD_CMD8, 0x1AA);
+	if (r1 == SD_R1_IDLE) {
+		uint8_t r7[4];
+		for (uint8_t i = 0; i < 4; i++) {
+			r7[i] = SD_port.exchange(0xFF);
+		}
+		if (r7[2] != 0x01 || r7[3] != 0xAA) {
+			SD_Deselect();
+			return -2; // Error, voltage not accepted
+		}
+		version2 = 1;
+	} else if (!(r1 & SD_R1_ILLEGAL_COMMAND)) {
+		SD_Deselect();
+		return -2; // Error, unknown response
+	}
+
+	uint32_t start_ms = HAL_GetTick();
+	do {
+		r1 = SD_AppCommand(SD_ACMD41, version2 ? 0x40000000 : 0); // HCS with version 2
+		if (r1 > SD_R1_IDLE) {
+			SD_Deselect();
+			return -2; // Error, MMC card
+		}
+		if (HAL_GetTick() - start_ms > SD_INIT_TIMEOUT_MS) {
+			SD_Deselect();
+			return -3; // Timeout
+		}
+	} while (r1 != 0);
+
+	SD_type = SD_TYPE_SDSC;
+	if (version2) {
+		if (SD_Command(SD_CMD58, 0) != 0) {
+			SD_Deselect();
+			return -2; // Error
+		}
+		uint8_t ocr = SD_port.exchange(0xFF);
+		for (uint8_t i = 0; i < 3; i++) {
+			SD_port.exchange(0xFF);
+		}
+		if (ocr & 0x40) {
+			SD_type = SD_TYPE_SDHC; // CCS
+		}
+	}
+	if (SD_type == SD_TYPE_SDSC && SD_Command(SD_CMD16, SD_BLOCK_SIZE) != 0) {
+		SD_Deselect();
+		return -2; // Error, block size
+	}
+
+	SD_Deselect();
+	SD_port.set_fast(1);
+	return 0; // OK
+}
+
+/**
+ * Read a block (blocking), not allowed during a multi-block write.
+ *
+ * @param block: block number.
+ * @param data: SD_BLOCK_SIZE bytes.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, no card or command refused
+ * @retval -2 BUSY, multi-block write in progress
+ * @retval -3 TIMEOUT
+ */
+int8_t SD_ReadBlock(uint32_t block, uint8_t data[]) {
+	if (SD_type == SD_TYPE_NONE) {
+		return -1; // Error, not initialized
+	}
+	if (SD_state != SD_STATE_IDLE) {
+		return -2; // Busy
+	}
+
+	SD_Select();
+	if (SD_Command(SD_CMD17, SD_Address(block)) != 0) {
+		SD_Deselect();
+		return -1; // Error
+	}
+	uint32_t start_ms = HAL_GetTick();
+	uint8_t token;
+	while ((token = SD_port.exchange(0xFF)) == 0xFF) {
+		if (HAL_GetTick() - start_ms > SD_READ_TIMEOUT_MS) {
+			SD_Deselect();
+			return -3; // Timeout
+		}
+	}
+	if (token != SD_TOKEN_START_BLOCK) {
+		SD_Deselect();
+		return -1; // Error token
+	}
+	for (uint16_t i = 0; i < SD_BLOCK_SIZE; i++) {
+		data[i] = SD_port.exchange(0xFF);
+	}
+	SD_port.exchange(0xFF); // CRC
+	SD_port.exchange(0xFF);
+	SD_Deselect();
+
+	return 0; // OK
+}
+
+/**
+ * Write a block and wait for the end of its programming (blocking), not allowed during a
+ * multi-block write.
+ *
+ * @param block: block number.
+ * @param data: SD_BLOCK_SIZE bytes.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, no card, command refused or data rejected
+ * @retval -2 BUSY, multi-block write in progress
+ * @retval -3 TIMEOUT
+ */
+int8_t SD_WriteBlock(uint32_t block, const uint8_t data[]) {
+	if (SD_type == SD_TYPE_NONE) {
+		return -1; // Error, not initialized
+	}
+	if (SD_state != SD_STATE_IDLE) {
+		return -2; // Busy
+	}
+
+	SD_Select();
+	if (SD_Command(SD_CMD24, SD_Address(block)) != 0) {
+		SD_Deselect();
+		return -1; // Error
+	}
+	SD_port.exchange(0xFF);
+	SD_port.exchange(SD_TOKEN_START_BLOCK);
+	for (uint16_t i = 0; i < SD_BLOCK_SIZE; i++) {
+		SD_port.exchange(data[i]);
+	}
+	SD_port.exchange(0xFF); // CRC
+	SD_port.exchange(0xFF);
+	uint8_t response = SD_port.exchange(0xFF);
+	if ((response & 0x1F) != SD_DATA_ACCEPTED) {
+		SD_Deselect();
+		return -1; // Error, data rejected
+	}
+	int8_t status = SD_WaitReady(SD_BUSY_TIMEOUT_MS);
+	SD_Deselect();
+
+	return status;
+}
+
+/**
+ * Open a multi-block write. The card erases "pre_erase_blocks" blocks before the first
+ * write (ACMD23), so it does not erase them one by one during the flight.
+ *
+ * @param block: first block.
+ * @param pre_erase_blocks: expected number of blocks, 0 for no pre-erase.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, no card or command refused
+ * @retval -2 BUSY, multi-block write already open
+ */
+int8_t SD_WriteStart(uint32_t block, uint32_t pre_erase_blocks) {
+	if (SD_type == SD_TYPE_NONE) {
+		return -1; // Error, not initialized
+	}
+	if (SD_state != SD_STATE_IDLE) {
+		return -2; // Busy
+	}
+
+	SD_Select();
+	if (pre_erase_blocks > 0) {
+		SD_AppCommand(SD_ACMD23, pre_erase_blocks & 0x7FFFFF); // Only a hint, ignore errors
+	}
+	if (SD_Command(SD_CMD25, SD_Address(block)) != 0) {
+		SD_Deselect();
+		return -1; // Error
+	}
+	SD_Deselect();
+
+	SD_state = SD_STATE_READY;
+	return 0; // OK
+}
+
+/**
+ * Queue the next block of the multi-block write (DMA) and return. The data must not
+ * change until SD_DMABusy returns 0.
+ *
+ * @param data: SD_BLOCK_SIZE bytes.
+ *
+ * @retval 0 OK, transfer started (or done without DMA if the DMA could not start)
+ * @retval -1 ERROR, no multi-block write
+ * @retval -2 BUSY, previous block not finished
+ */
+int8_t SD_WriteNext(const uint8_t data[]) {
+	if (SD_state == SD_STATE_IDLE) {
+		return -1; // Error
+	}
+	if (SD_state != SD_STATE_READY) {
+		return -2; // Busy
+	}
+
+	SD_state = SD_STATE_DMA;
+	if (SD_port.write_dma(SD_TOKEN_START_MULTI, data, SD_BLOCK_SIZE, SD_trailer, SD_TRAILER_SIZE) != 0) {
+		// Send the block without DMA (about 0.3 ms)
+		SD_Select();
+		SD_port.exchange(0xFF);
+		SD_port.exchange(SD_TOKEN_START_MULTI);
+		for (uint16_t i = 0; i < SD_BLOCK_SIZE; i++) {
+			SD_port.exchange(data[i]);
+		}
+		for (uint8_t i = 0; i < SD_TRAILER_SIZE; i++) {
+			SD_trailer[i] = SD_port.exchange(0xFF);
+		}
+		SD_Deselect();
+		SD_state = SD_STATE_DMA_DONE;
+		SD_stats.dma_errors++;
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Close the multi-block write. The card is busy after the stop token, SD_Poll returns 1
+ * when it is finished.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, no multi-block write
+ * @retval -2 BUSY, block not finished
+ */
+int8_t SD_WriteStop() {
+	if (SD_state == SD_STATE_IDLE) {
+		return -1; // Error
+	}
+	if (SD_state != SD_STATE_READY) {
+		return -2; // Busy
+	}
+
+	SD_Select();
+	SD_port.exchange(0xFF);
+	SD_port.exchange(SD_TOKEN_STOP_TRAN);
+	SD_port.exchange(0xFF); // Busy starts one byte after the token
+	SD_Deselect();
+	SD_busy_start_ms = HAL_GetTick();
+	SD_timed_out = 0;
+	SD_state = SD_STATE_STOPPING;
+
+	return 0; // OK
+}
+
+/**
+ * Advance the block in progress without waiting: check the data response received after
+ * the DMA, then check once if the card is still busy. Call periodically (logging task).
+ *
+ * @retval 1 ready (next block or no multi-block write)
+ * @retval 0 block in progress
+ * @retval -1 ERROR, block rejected by the card (counted in errors)
+ * @retval -3 TIMEOUT, card busy for more than SD_BUSY_TIMEOUT_MS (counted once)
+ */
+int8_t SD_Poll() {
+	switch (SD_state) {
+	case SD_STATE_DMA_DONE: {
+		uint8_t response = 0xFF;
+		for (uint8_t i = 2; i < SD_TRAILER_SIZE && response == 0xFF; i++) { // After the CRC
+			response = SD_trailer[i];
+		}
+		SD_busy_start_ms = HAL_GetTick();
+		SD_timed_out = 0;
+		SD_state = SD_STATE_BUSY;
+		if ((response & 0x1F) != SD_DATA_ACCEPTED) {
+			SD_stats.errors++;
+			return -1; // Error, the busy time is still polled
+		}
+		return 0;
+	}
+
+	case SD_STATE_BUSY:
+	case SD_STATE_STOPPING: {
+		SD_Select();
+		uint8_t byte = SD_port.exchange(0xFF);
+		SD_Deselect();
+
+		uint32_t busy_ms = HAL_GetTick() - SD_busy_start_ms;
+		if (byte != 0xFF) {
+			SD_stats.busy_polls++;
+			if (busy_ms > SD_BUSY_TIMEOUT_MS && !SD_timed_out) {
+				SD_timed_out = 1;
+				SD_stats.timeouts++;
+				return -3; // Timeout
+			}
+			return 0;
+		}
+
+		if (busy_ms > SD_stats.max_busy_ms) {
+			SD_stats.max_busy_ms = busy_ms;
+		}
+		if (SD_state == SD_STATE_BUSY) {
+			SD_stats.blocks_written++;
+			SD_state = SD_STATE_READY;
+		} else {
+			SD_state = SD_STATE_IDLE;
+		}
+		return 1;
+	}
+
+	case SD_STATE_DMA:
+		return 0;
+
+	default:
+		return 1;
+	}
+}
+
+/**
+ * Block transfer complete, card deselected. Called at the end of the bus transaction.
+ *
+ * @param hspi: SPI of the interrupt, ignored if it is not the card SPI.
+ */
+void SD_TxCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == SD_hspi && SD_state == SD_STATE_DMA) {
+		SD_state = SD_STATE_DMA_DONE;
+	}
+}
+
+/**
+ * @return SD_TYPE_x, SD_TYPE_NONE before a successful initialization
+ */
+uint8_t SD_GetType() {
+	return SD_type;
+}
+
+/**
+ * @return SD_STATE_x
+ */
+uint8_t SD_GetState() {
+	return SD_state;
+}
+
+/**
+ * @retval 1 block transfer in progress, the SPI bus and the block buffer are in use
+ */
+uint8_t SD_DMABusy() {
+	return SD_state == SD_STATE_DMA;
+}
+
+const SD_Stats *SD_GetStats() {
+	return &SD_stats;
+}
@@ -0,0 +1,509 @@
+/*
+ * SPIBUS.c
+ *
+ * SPI2 bus manager.
+ *
+ * A transaction goes through: SPIBUS_Submit (sorted in the queue by priority, FIFO for
+ * the same priority) -> SPIBUS_Run (prescaler of the device, CS low, header) -> data by
+ * DMA -> SPIBUS_TxRxCallback (trailer, CS high, callback) -> SPIBUS_Run for the next
+ * one. The header and the trailer are a few bytes, they are exchanged without DMA (a DMA
+ * start costs more than the bytes). Short data are also exchanged without DMA, the next
+ * transaction then starts right away in the same call.
+ *
+ * Only one transaction or one session has the bus at a time ("SPIBUS_current" or
+ * "SPIBUS_session"), so two chip selects are never low together. Sessions are for the
+ * tasks (they wait for the bus), never call SPIBUS_Select from an interrupt.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/SPIBUS.h"
+#include "GAUL_Drivers/DMASHARE.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static SPI_HandleTypeDef *SPIBUS_hspi = NULL;
+static SPIBUS_Port SPIBUS_port;
+static SPIBUS_Device SPIBUS_devices[SPIBUS_MAX_DEVICES];
+static uint8_t SPIBUS_device_count = 0;
+static uint32_t SPIBUS_prescaler;        // Prescaler of the SPI
+
+static SPIBUS_Transaction *SPIBUS_queue[SPIBUS_QUEUE_SIZE]; // Highest priority first
+static uint8_t SPIBUS_queued = 0;
+static SPIBUS_Transaction *volatile SPIBUS_current = NULL;  // Transaction having the bus
+static volatile uint8_t SPIBUS_session = SPIBUS_NONE;       // Device of the open session
+static uint8_t SPIBUS_rx_dma;            // RX DMA channel taken by SPIBUS_current
+static SPIBUS_Stats SPIBUS_stats;
+
+static void SPIBUS_HALSelect(const SPIBUS_Device *device, uint8_t selected) {
+	HAL_GPIO_WritePin(device->cs_port, device->cs_pin, selected ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+static void SPIBUS_HALSetPrescaler(uint32_t prescaler) {
+	// The HAL transfer functions enable the SPI again
+	__HAL_SPI_DISABLE(SPIBUS_hspi);
+	MODIFY_REG(SPIBUS_hspi->Instance->CR1, SPI_CR1_BR, prescaler);
+	SPIBUS_hspi->Init.BaudRatePrescaler = prescaler;
+}
+
+static void SPIBUS_HALTransfer(const uint8_t tx[], uint8_t rx[], uint16_t size) {
+	if (rx != NULL) {
+		if (tx == NULL) {
+			memset(rx, 0xFF, size); // Sent in place
+			tx = rx;
+		}
+		HAL_SPI_TransmitReceive(SPIBUS_hspi, (uint8_t *)tx, rx, size, SPIBUS_SPI_TIMEOUT);
+	} else if (tx != NULL) {
+		HAL_SPI_Transmit(SPIBUS_hspi, (uint8_t *)tx, size, SPIBUS_SPI_TIMEOUT);
+	} else {
+		uint8_t byte = 0xFF;
+		uint8_t discard;
+		for (uint16_t i = 0; i < size; i++) {
+			HAL_SPI_TransmitReceive(SPIBUS_hspi, &byte, &discard, 1, SPIBUS_SPI_TIMEOUT);
+		}
+	}
+}
+
+static int8_t SPIBUS_HALTransferDMA(const uint8_t tx[], uint8_t rx[], uint16_t size) {
+	HAL_StatusTypeDef status;
+	if (rx != NULL) {
+		if (SPIBUS_hspi->hdmarx == NULL) {
+			return -1; // No RX DMA channel
+		}
+		if (tx == NULL) {
+			memset(rx, 0xFF, size);
+			tx = rx;
+		}
+		status = HAL_SPI_TransmitReceive_DMA(SPIBUS_hspi, (uint8_t *)tx, rx, size);
+	} else {
+		status = HAL_SPI_Transmit_DMA(SPIBUS_hspi, (uint8_t *)tx, size);
+	}
+	return status == HAL_OK ? 0 : -1; // SPI ERROR or BUSY
+}
+
+static int8_t SPIBUS_HALAcquireRxDMA() {
+	return DMASHARE_Acquire(DMASHARE_USER_SPI2_RX) == -2 ? -2 : 0;
+}
+
+static void SPIBUS_HALReleaseRxDMA() {
+	DMASHARE_Release(DMASHARE_USER_SPI2_RX);
+}
+
+static void SPIBUS_Apply(const SPIBUS_Device *device) {
+	if (device->prescaler != SPIBUS_prescaler) {
+		SPIBUS_port.set_prescaler(device->prescaler);
+		SPIBUS_prescaler = device->prescaler;
+		SPIBUS_stats.prescaler_switches++;
+	}
+}
+
+static void SPIBUS_Release(const SPIBUS_Device *device) {
+	SPIBUS_port.select(device, 0);
+	if (device->flags & SPIBUS_DEVICE_RELEASE_MISO) {
+		SPIBUS_port.transfer(NULL, NULL, 1);
+	}
+}
+
+/**
+ * Select the device and send the header, then start the data by DMA.
+ *
+ * @retval 1 DMA in progress, SPIBUS_TxRxCallback finishes the transaction
+ * @retval 0 data exchanged, finish the transaction
+ */
+static uint8_t SPIBUS_Start(SPIBUS_Transaction *transaction) {
+	const SPIBUS_Device *device = &SPIBUS_devices[transaction->device];
+
+	SPIBUS_Apply(device);
+	SPIBUS_port.select(device, 1);
+	if (transaction->header_size > 0) {
+		SPIBUS_port.transfer(transaction->header, NULL, transaction->header_size);
+	}
+	if (transaction->size >= SPIBUS_DMA_MIN_SIZE && (transaction->tx != NULL || transaction->rx != NULL)) {
+		if (SPIBUS_port.transfer_dma(transaction->tx, transaction->rx, transaction->size) == 0) {
+			SPIBUS_stats.dma++;
+			return 1;
+		}
+		SPIBUS_stats.dma_errors++;
+	}
+	if (transaction->size > 0) {
+		SPIBUS_port.transfer(transaction->tx, transaction->rx, transaction->size);
+	}
+	return 0;
+}
+
+/**
+ * Receive the trailer, deselect the device and free the bus, then call the callback (it can
+ * submit the next transaction of the device).
+ */
+static void SPIBUS_Finish(SPIBUS_Transaction *transaction) {
+	const SPIBUS_Device *device = &SPIBUS_devices[transaction->device];
+
+	if (transaction->trailer_size > 0) {
+		SPIBUS_port.transfer(NULL, transaction->trailer, transaction->trailer_size);
+	}
+	SPIBUS_Release(device);
+	SPIBUS_stats.transactions++;
+	transaction->status = SPIBUS_STATUS_DONE;
+	SPIBUS_current = NULL;
+	if (SPIBUS_rx_dma) {
+		SPIBUS_rx_dma = 0;
+		SPIBUS_port.release_rx_dma(); // Can resume the radio
+	}
+	if (transaction->callback != NULL) {
+		transaction->callback(transaction);
+	}
+}
+
+/**
+ * Start the queued transactions while the bus is free. A transaction receiving by DMA
+ * waits if the RX channel is used by the radio, the next transactions can go before it.
+ */
+static void SPIBUS_Run() {
+	for (;;) {
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+
+		if (SPIBUS_current != NULL || SPIBUS_session != SPIBUS_NONE) {
+			__set_PRIMASK(primask);
+			return; // Continued at the end of the transfer or session
+		}
+
+		SPIBUS_Transaction *transaction = NULL;
+		uint8_t rx_dma = 0;
+		for (uint8_t i = 0; i < SPIBUS_queued && transaction == NULL; i++) {
+			SPIBUS_Transaction *candidate = SPIBUS_queue[i];
+			rx_dma = candidate->rx != NULL && candidate->size >= SPIBUS_DMA_MIN_SIZE;
+			if (rx_dma && SPIBUS_port.acquire_rx_dma() != 0) {
+				SPIBUS_stats.rx_dma_waits++; // SPIBUS_Resume at the release
+				continue;
+			}
+			transaction = candidate;
+			SPIBUS_queued--;
+			memmove(&SPIBUS_queue[i], &SPIBUS_queue[i + 1], (SPIBUS_queued - i) * sizeof(SPIBUS_queue[0]));
+		}
+		if (transaction == NULL) {
+			__set_PRIMASK(primask);
+			return;
+		}
+		SPIBUS_current = transaction;
+		SPIBUS_rx_dma = rx_dma;
+		transaction->status = SPIBUS_STATUS_RUNNING;
+
+		__set_PRIMASK(primask);
+
+		if (SPIBUS_Start(transaction)) {
+			return; // DMA in progress
+		}
+		SPIBUS_Finish(transaction);
+	}
+}
+
+/**
+ * Reset the bus: no device, empty queue. Sends one byte without chip select so SCK is at
+ * its idle level before the first transaction.
+ *
+ * @param hspi: SPI of the bus (&hspi2), with its TX DMA (and RX DMA) linked.
+ * @param port: SPI access functions, NULL (or NULL members) to use the HAL.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, invalid parameter
+ */
+int8_t SPIBUS_Init(SPI_HandleTypeDef *hspi, const SPIBUS_Port *port) {
+	if (hspi == NULL) {
+		return -1; // Error
+	}
+
+	SPIBUS_hspi = hspi;
+	SPIBUS_port.select = port != NULL && port->select != NULL ? port->select : SPIBUS_HALSelect;
+	SPIBUS_port.set_prescaler = port != NULL && port->set_prescaler != NULL ? port->set_prescaler
+			: SPIBUS_HALSetPrescaler;
+	SPIBUS_port.transfer = port != NULL && port->transfer != NULL ? port->transfer : SPIBUS_HALTransfer;
+	SPIBUS_port.transfer_dma = port != NULL && port->transfer_dma != NULL ? port->transfer_dma
+			: SPIBUS_HALTransferDMA;
+	SPIBUS_port.acquire_rx_dma = port != NULL && port->acquire_rx_dma != NULL ? port->acquire_rx_dma
+			: SPIBUS_HALAcquireRxDMA;
+	SPIBUS_port.release_rx_dma = port != NULL && port->release_rx_dma != NULL ? port->release_rx_dma
+			: SPIBUS_HALReleaseRxDMA;
+	SPIBUS_prescaler = hspi->Init.BaudRatePrescaler;
+	SPIBUS_device_count = 0;
+	SPIBUS_queued = 0;
+	SPIBUS_current = NULL;
+	SPIBUS_session = SPIBUS_NONE;
+	SPIBUS_rx_dma = 0;
+	memset(&SPIBUS_stats, 0, sizeof(SPIBUS_stats));
+
+	/* Note page 704/1136 RM0008 Rev 21 :
+	 * The idle state of SCK must correspond to the polarity selected in the
+	 * SPI_CR1 register (by pulling up SCK if CPOL=1 or pulling down SCK if CPOL=0).
+	 */
+	SPIBUS_port.transfer(NULL, NULL, 1);
+
+	return 0; // OK
+}
+
+/**
+ * Add a device to the bus, or update it if its chip select is already on the bus. The
+ * chip select pin must be configured as an output, high.
+ *
+ * @param cs_port: GPIO port of the chip select.
+ * @param cs_pin: GPIO pin of the chip select.
+ * @param prescaler: SPI_BAUDRATEPRESCALER_x of the device (SPI2 clock is 36 MHz).
+ * @param flags: SPIBUS_DEVICE_x.
+ *
+ * @return device number (0 or more)
+ * @retval -1 ERROR, SPIBUS_MAX_DEVICES devices already
+ */
+int8_t SPIBUS_AddDevice(GPIO_TypeDef *cs_port, uint16_t cs_pin, uint32_t prescaler, uint8_t flags) {
+	uint8_t device = 0;
+	while (device < SPIBUS_device_count
+			&& (SPIBUS_devices[device].cs_port != cs_port || SPIBUS_devices[device].cs_pin != cs_pin)) {
+		device++;
+	}
+	if (device >= SPIBUS_MAX_DEVICES) {
+		return -1; // Error, full
+	}
+	if (device == SPIBUS_device_count) {
+		SPIBUS_device_count++;
+	}
+
+	SPIBUS_devices[device] = (SPIBUS_Device) {
+		.cs_port = cs_port,
+		.cs_pin = cs_pin,
+		.prescaler = prescaler,
+		.flags = flags,
+	};
+	return device;
+}
+
+/**
+ * Change the clock of a device (SD card initialization clock), applied at its next
+ * transaction or right away if its session is open.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, unknown device
+ */
+int8_t SPIBUS_SetPrescaler(uint8_t device, uint32_t prescaler) {
+	if (device >= SPIBUS_device_count) {
+		return -1; // Error
+	}
+	SPIBUS_devices[device].prescaler = prescaler;
+	if (SPIBUS_session == device) {
+		SPIBUS_Apply(&SPIBUS_devices[device]);
+	}
+	return 0; // OK
+}
+
+/**
+ * Queue a transaction and return. The transaction (and its buffers) must not change until
+ * its status is SPIBUS_STATUS_DONE, the callback is called at the end.
+ *
+ * @param transaction: descriptor, its status is set by the bus.
+ *
+ * @retval 0 OK, queued (started if the bus was free)
+ * @retval -1 ERROR, invalid transaction
+ * @retval -2 BUSY, queue full or transaction already queued
+ */
+int8_t SPIBUS_Submit(SPIBUS_Transaction *transaction) {
+	if (SPIBUS_hspi == NULL || transaction == NULL || transaction->device >= SPIBUS_device_count
+			|| transaction->header_size > SPIBUS_HEADER_SIZE || transaction->trailer_size > SPIBUS_TRAILER_SIZE) {
+		return -1; // Error
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (transaction->status == SPIBUS_STATUS_QUEUED || transaction->status == SPIBUS_STATUS_RUNNING
+			|| SPIBUS_queued >= SPIBUS_QUEUE_SIZE) {
+		__set_PRIMASK(primask);
+		return -2; // Busy
+	}
+
+	// After the transactions of the same or a higher priority
+	uint8_t i = SPIBUS_queued;
+	while (i > 0 && SPIBUS_queue[i - 1]->priority < transaction->priority) {
+		SPIBUS_queue[i] = SPIBUS_queue[i - 1];
+		i--;
+	}
+	if (i < SPIBUS_queued) {
+		SPIBUS_stats.reordered++;
+	}
+	SPIBUS_queue[i] = transaction;
+	SPIBUS_queued++;
+	transaction->status = SPIBUS_STATUS_QUEUED;
+	if (SPIBUS_queued > SPIBUS_stats.max_queued) {
+		SPIBUS_stats.max_queued = SPIBUS_queued;
+	}
+
+	__set_PRIMASK(primask);
+
+	SPIBUS_Run();
+	return 0; // OK
+}
+
+/**
+ * Data transfer complete, finish the transaction and start the next one. Call from
+ * HAL_SPI_TxCpltCallback and HAL_SPI_TxRxCpltCallback.
+ *
+ * @param hspi: SPI of the interrupt, ignored if it is not the bus SPI.
+ */
+void SPIBUS_TxRxCallback(SPI_HandleTypeDef *hspi) {
+	SPIBUS_Transaction *transaction = SPIBUS_current;
+	if (hspi != SPIBUS_hspi || transaction == NULL || transaction->status != SPIBUS_STATUS_RUNNING) {
+		return;
+	}
+	SPIBUS_Finish(transaction);
+	SPIBUS_Run();
+}
+
+/**
+ * The RX DMA channel is free again (DMASHARE resume), start the waiting transactions.
+ */
+void SPIBUS_Resume() {
+	SPIBUS_Run();
+}
+
+/**
+ * Wait for the transaction in progress (SPIBUS_SELECT_TIMEOUT_MS at most) and take the bus
+ * for a session of the device, with its clock.
+ */
+static int8_t SPIBUS_Take(uint8_t device) {
+	if (SPIBUS_hspi == NULL || device >= SPIBUS_device_count) {
+		return -1; // Error
+	}
+
+	uint32_t start_ms = HAL_GetTick();
+	uint8_t waited = 0;
+	for (;;) {
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		if (SPIBUS_current == NULL && SPIBUS_session == SPIBUS_NONE) {
+			SPIBUS_session = device;
+			__set_PRIMASK(primask);
+			break;
+		}
+		__set_PRIMASK(primask);
+
+		waited = 1;
+		if (HAL_GetTick() - start_ms > SPIBUS_SELECT_TIMEOUT_MS) {
+			SPIBUS_stats.session_timeouts++;
+			return -3; // Timeout
+		}
+	}
+
+	SPIBUS_stats.sessions++;
+	if (waited) {
+		SPIBUS_stats.session_waits++;
+	}
+	SPIBUS_Apply(&SPIBUS_devices[device]);
+	return 0; // OK
+}
+
+/**
+ * Open a session: wait for the transaction in progress (SPIBUS_SELECT_TIMEOUT_MS at most),
+ * then select the device. The queued transactions wait until SPIBUS_Deselect.
+ *
+ * @param device: from SPIBUS_AddDevice.
+ *
+ * @retval 0 OK, device selected
+ * @retval -1 ERROR, unknown device
+ * @retval -3 TIMEOUT, the bus stayed busy
+ */
+int8_t SPIBUS_Select(uint8_t device) {
+	int8_t status = SPIBUS_Take(device);
+	if (status != 0) {
+		return status;
+	}
+	SPIBUS_port.select(&SPIBUS_devices[device], 1);
+	return 0; // OK
+}
+
+/**
+ * Clock 0xFF bytes at the clock of the device with all the chip selects high (SD card
+ * initialization). Waits for the bus like SPIBUS_Select.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, unknown device
+ * @retval -3 TIMEOUT, the bus stayed busy
+ */
+int8_t SPIBUS_Clock(uint8_t device, uint16_t count) {
+	int8_t status = SPIBUS_Take(device);
+	if (status != 0) {
+		return status;
+	}
+	SPIBUS_port.transfer(NULL, NULL, count);
+	SPIBUS_session = SPIBUS_NONE;
+	SPIBUS_Run();
+	return 0; // OK
+}
+
+/**
+ * Full duplex byte in the open session.
+ *
+ * @return byte received, 0xFF without a session (nothing is sent)
+ */
+uint8_t SPIBUS_Exchange(uint8_t byte) {
+	uint8_t rx = 0xFF;
+	if (SPIBUS_session != SPIBUS_NONE) {
+		SPIBUS_port.transfer(&byte, &rx, 1);
+	}
+	return rx;
+}
+
+/**
+ * Send bytes in the open session (received bytes discarded).
+ */
+void SPIBUS_Transmit(const uint8_t data[], uint16_t size) {
+	if (SPIBUS_session != SPIBUS_NONE) {
+		SPIBUS_port.transfer(data, NULL, size);
+	}
+}
+
+/**
+ * Receive bytes in the open session (0xFF sent).
+ */
+void SPIBUS_Receive(uint8_t data[], uint16_t size) {
+	if (SPIBUS_session != SPIBUS_NONE) {
+		SPIBUS_port.transfer(NULL, data, size);
+	}
+}
+
+/**
+ * Close the session of the device and start the queued transactions.
+ *
+ * @param device: device of the session, ignored if its session is not open.
+ */
+void SPIBUS_Deselect(uint8_t device) {
+	if (device >= SPIBUS_device_count || SPIBUS_session != device) {
+		return;
+	}
+	SPIBUS_Release(&SPIBUS_devices[device]);
+	SPIBUS_session = SPIBUS_NONE;
+	SPIBUS_Run();
+}
+
+/**
+ * @retval 1 a transaction or a session has the bus
+ */
+uint8_t SPIBUS_Busy() {
+	return SPIBUS_current != NULL || SPIBUS_session != SPIBUS_NONE;
+}
+
+/**
+ * @return number of transactions waiting (not including the transaction in progress)
+ */
+uint8_t SPIBUS_Queued() {
+	return SPIBUS_queued;
+}
+
+/**
+ * @return device, NULL if unknown
+ */
+const SPIBUS_Device *SPIBUS_GetDevice(uint8_t device) {
+	return device < SPIBUS_device_count ? &SPIBUS_devices[device] : NULL;
+}
+
+const SPIBUS_Stats *SPIBUS_GetStats() {
+	return &SPIBUS_stats;
+}
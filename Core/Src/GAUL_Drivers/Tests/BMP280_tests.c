@@ -8,44 +8,78 @@
 #include "GAUL_Drivers/Tests/BMP280_tests.h"
 
 #include "GAUL_Drivers/BMP280.h"
+#include "GAUL_Drivers/RFD900.h"
+#include "GAUL_System/PROFILER.h"
 #include "stdio.h"
 
 extern BMP280 bmp_data;
 
-int8_t BMP280_TESTS_LogUART(UART_HandleTypeDef *huart) {
-    // Debug timer High (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+int8_t BMP280_TESTS_LogUART() {
+    // Execution time measured with the cycle counter (see PROFILER_Dump)
+    PROFILER_BEGIN(PROFILER_ZONE_BMP280_READ);
+    int8_t status = BMP280_ReadAltitude(&bmp_data);
+    PROFILER_END(PROFILER_ZONE_BMP280_READ);
 
-    if (BMP280_ReadAltitude(&bmp_data) != 0) {
+    if (status != 0) {
     	printf("Error BMP280_ReadAltitude\r\n");
     	return -1; // Error
     }
 
-    // Debug timer Low (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
-
-    // UART log
-    char Data[36];
+    // UART log, queued for the RFD900 (DMA), does not wait for the 37 ms transmission
+    char Data[37];
     sprintf(Data, "%9.4f kPa %6.2f C %8.2f m\r\n", bmp_data.press_Pa / 1000, bmp_data.temp_C, bmp_data.alt_m);
-    HAL_UART_Transmit(huart, (uint8_t *)Data, 36, 1000);
+    RFD900_Send((uint8_t *)Data, 36);
 
     return 0; // OK
 }
 
 int8_t BMP280_TESTS_LogSTLINK() {
-    // Debug timer High (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+    // Execution time measured with the cycle counter (see PROFILER_Dump)
+    PROFILER_BEGIN(PROFILER_ZONE_BMP280_READ);
+    int8_t status = BMP280_ReadAltitude(&bmp_data);
+    PROFILER_END(PROFILER_ZONE_BMP280_READ);
 
-    if (BMP280_ReadAltitude(&bmp_data) != 0) {
+    if (status != 0) {
     	printf("Error BMP280_ReadAltitude\r\n");
     	return -1; // Error
     }
 
-    // Debug timer Low (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
-
     // STLINK log
 	printf("%9.4f kPa %6.2f C %8.2f m\r\n", bmp_data.press_Pa / 1000, bmp_data.temp_C, bmp_data.alt_m);
 
     return 0; // OK
 }
+
+/**
+ * Compare BMP280_LinearAltitudeMm to BMP280_PressureToAltitude from 25 m below the reference (extrapolated)
+ * to the end of the table, for sea level and high ground references. No sensor needed.
+ */
+int8_t BMP280_TESTS_LinearAltitude_LogSTLINK() {
+	static const float references[] = { 101325.0f, 90000.0f, 110000.0f };
+	BMP280 data;
+	float max_error_m = 0;
+
+	for (uint8_t r = 0; r < sizeof(references) / sizeof(references[0]); r++) {
+		BMP280_SetReference(&data, references[r]);
+		float min_Pa = references[r] * (1.0f - (float)(BMP280_ALT_TABLE_SIZE - 1) / (1 << BMP280_ALT_TABLE_SHIFT));
+		for (float press_Pa = references[r] * 1.003f; press_Pa > min_Pa; press_Pa -= 7.3f) {
+			data.press_Pa_Q8 = (uint32_t)(press_Pa * 256.0f);
+			float expected_m = BMP280_PressureToAltitude((float)data.press_Pa_Q8 / 256.0f, references[r]);
+			float error_m = (float)BMP280_LinearAltitudeMm(&data) / 1000.0f - expected_m;
+			if (error_m < 0) {
+				error_m = -error_m;
+			}
+			if (error_m > max_error_m) {
+				max_error_m = error_m;
+			}
+		}
+	}
+
+	printf("Linear altitude: max error %.3f m\r\n", max_error_m);
+	if (max_error_m < 0.1f) {
+		printf("Test 1 passed\r\n");
+		return 0; // OK
+	}
+	printf("Test 1 failed\r\n");
+	return -1; // Error
+}
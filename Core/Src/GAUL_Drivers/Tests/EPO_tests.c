@@ -0,0 +1,515 @@
+/*
+ * EPO_tests.c
+ *
+ * EPO_TESTS_Model_LogSTLINK uploads EPO files to a model of the L76 behind the real command
+ * engine (L76LM33_Init on a model of USART2): the module sends a RMC sentence every second
+ * at its baud rate (it ignores PMTK251, the link stays at the baud rate of the test),
+ * clears its EPO on PMTK127 and writes each PMTK721 record before acknowledging it. It
+ * checks the order and the content of the records. Commands can be lost or answered
+ * "failed". The ground link sends chunks at the RFD900 baud rate, some corrupted. Time is
+ * simulated, the main loop (reads, polls) runs at a chosen period.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/Tests/EPO_tests.h"
+
+#include "GAUL_System/PACKET.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EPO_TESTS_CLEAR_MS  300    // PMTK127, EPO flash of the module erased
+#define EPO_TESTS_WRITE_MS  10     // PMTK721, record written
+#define EPO_TESTS_RADIO_BAUD 9600  // RFD900 serial link
+#define EPO_TESTS_SETS_3DAYS 12    // EPO file of 3 days (6 hours per set)
+
+extern uint8_t L76_receivedByte;
+
+// L76 model
+typedef struct {
+	uint32_t baud;
+	uint32_t next_ms;         // Next RMC
+	uint8_t drops;            // Next commands lost on the line
+	uint8_t fails;            // Next records answered "failed"
+	uint8_t cleared;          // PMTK127 received
+	uint8_t ended;            // "$PMTK721,00" received after the last record
+	uint16_t stored;          // Records written, in order
+	uint16_t wrong;           // Records out of order or with a wrong content
+	uint16_t records;         // PMTK721 received (retries included)
+	char ack[L76LM33_ACK_SIZE + 4]; // Acknowledge sent...
+	uint32_t ack_ms;          // ...at this time, 0: none
+	char out[256];            // Bytes leaving the module at its baud rate
+	uint16_t out_length;
+	uint16_t out_sent;
+	uint32_t out_credit;
+} EPO_TESTS_Module;
+
+// Ground station sending the file in passes
+typedef struct {
+	uint16_t records;
+	uint8_t passes;           // Passes left
+	uint16_t index;           // Chunk being sent
+	uint8_t offset;           // Next byte of the chunk
+	uint8_t chunk[EPO_LINK_CHUNK];
+	int16_t corrupt[2];       // Chunks corrupted in the first pass, -1: none
+	uint8_t first_pass;
+	uint32_t credit;
+} EPO_TESTS_Ground;
+
+static UART_HandleTypeDef model_huart;
+static EPO_TESTS_Module module;
+static EPO_TESTS_Ground ground;
+static uint32_t model_ms;
+static uint32_t mcu_baud;
+static L76LM33 L76_data;
+
+// USART2 transmission in progress
+static uint8_t tx_data[EPO_SENTENCE_SIZE];
+static uint16_t tx_size;
+static uint32_t tx_end_ms;
+static uint8_t tx_busy;
+
+// One set in memory (the flight software would point to the file in flash)
+static uint8_t file[EPO_SET_RECORDS * EPO_RECORD_SIZE];
+
+/**
+ * Byte "i" of record "record" of the test file.
+ */
+static uint8_t EPO_TESTS_Byte(uint16_t record, uint8_t i) {
+	return (uint8_t)(record * 37 + i * 11 + (record >> 3) + 0x5A);
+}
+
+static void EPO_TESTS_Frame(char *sentence, size_t size, const char *body) {
+	uint8_t checksum = 0;
+	for (const char *c = body; *c != '\0'; c++) {
+		checksum ^= (uint8_t)*c;
+	}
+	snprintf(sentence, size, "$%s*%02X\r\n", body, checksum);
+}
+
+/**
+ * Checksum of a sentence received by the module (longer than NMEA_ValidateChecksum takes).
+ *
+ * @return 1 if valid
+ */
+static uint8_t EPO_TESTS_Valid(const char *sentence) {
+	uint8_t checksum = 0;
+	const char *c = sentence + 1;
+	for (; *c != '*' && *c != '\0'; c++) {
+		checksum ^= (uint8_t)*c;
+	}
+	return sentence[0] == '$' && *c == '*' && strtoul(c + 1, NULL, 16) == checksum;
+}
+
+/**
+ * Module sends "sentence" after the bytes already queued.
+ */
+static void EPO_TESTS_Emit(const char *sentence) {
+	uint16_t length = strlen(sentence);
+	if (module.out_sent > 0) {
+		memmove(module.out, module.out + module.out_sent, module.out_length - module.out_sent);
+		module.out_length -= module.out_sent;
+		module.out_sent = 0;
+	}
+	if (module.out_length + length <= sizeof(module.out)) {
+		memcpy(module.out + module.out_length, sentence, length);
+		module.out_length += length;
+	}
+}
+
+/**
+ * Bytes sent by the module in 1 ms at its baud rate, nothing received by USART2 at another
+ * baud rate (framing errors).
+ */
+static void EPO_TESTS_Send() {
+	if (module.out_sent == module.out_length) {
+		module.out_credit = 0;
+		return;
+	}
+	module.out_credit += module.baud;
+	while (module.out_credit >= 10000 && module.out_sent < module.out_length) {
+		module.out_credit -= 10000;
+		char c = module.out[module.out_sent++];
+		if (mcu_baud == module.baud) {
+			L76_receivedByte = (uint8_t)c;
+			L76LM33_RxCallback(&model_huart);
+		}
+	}
+}
+
+/**
+ * PMTK721 record checked against the test file: next satellite of the set, same 72 bytes.
+ *
+ * @return 1 if it is the next record
+ */
+static uint8_t EPO_TESTS_Record(const char *command) {
+	char *end;
+	uint16_t sv = strtoul(command + 9, &end, 16);
+	if (sv != module.stored % EPO_SET_RECORDS + 1) {
+		return 0;
+	}
+	for (uint8_t i = 0; i < EPO_RECORD_SIZE / 4; i++) {
+		if (*end != ',') {
+			return 0;
+		}
+		uint32_t word = strtoul(end + 1, &end, 16);
+		for (uint8_t j = 0; j < 4; j++) {
+			if ((uint8_t)(word >> 8 * j) != EPO_TESTS_Byte(module.stored, 4 * i + j)) {
+				return 0;
+			}
+		}
+	}
+	return *end == '*';
+}
+
+/**
+ * Command received by the module at the end of the transmission.
+ */
+static void EPO_TESTS_Receive() {
+	char command[EPO_SENTENCE_SIZE + 1];
+	char body[L76LM33_ACK_SIZE];
+
+	if (mcu_baud != module.baud) {
+		return; // Garbled
+	}
+	if (module.drops > 0) {
+		module.drops--;
+		return; // Lost on the line
+	}
+	memcpy(command, tx_data, tx_size);
+	command[tx_size] = '\0';
+	if (!EPO_TESTS_Valid(command) || strncmp(command, "$PMTK", 5) != 0) {
+		return;
+	}
+
+	uint16_t number = strtoul(command + 5, NULL, 10);
+	uint8_t flag = L76LM33_ACK_SUCCESS;
+	uint16_t delay_ms = 5;
+	if (number == 251) {
+		return; // Stays at its baud rate
+	} else if (number == 127) {
+		module.cleared = 1;
+		module.stored = 0;
+		module.ended = 0;
+		delay_ms = EPO_TESTS_CLEAR_MS;
+	} else if (number == 721 && strncmp(command, "$PMTK721,00*", 12) == 0) {
+		module.ended = module.cleared && module.stored > 0;
+	} else if (number == 721) {
+		module.records++;
+		delay_ms = EPO_TESTS_WRITE_MS;
+		if (module.fails > 0) {
+			module.fails--;
+			flag = L76LM33_ACK_FAILED;
+		} else if (module.cleared && EPO_TESTS_Record(command)) {
+			module.stored++;
+		} else {
+			module.wrong++;
+			flag = L76LM33_ACK_INVALID;
+		}
+	}
+
+	snprintf(body, sizeof(body), "PMTK001,%u,%u", number, flag);
+	EPO_TESTS_Frame(module.ack, sizeof(module.ack), body);
+	module.ack_ms = model_ms + delay_ms;
+}
+
+static int8_t EPO_TESTS_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+	(void)huart;
+	if (tx_busy || size > sizeof(tx_data)) {
+		return -1;
+	}
+	memcpy(tx_data, data, size);
+	tx_size = size;
+	tx_end_ms = model_ms + (uint32_t)size * 10 * 1000 / mcu_baud + 1;
+	tx_busy = 1;
+	return 0;
+}
+
+static int8_t EPO_TESTS_SetBaud(UART_HandleTypeDef *huart, uint32_t baud) {
+	huart->Init.BaudRate = baud;
+	mcu_baud = baud;
+	tx_busy = 0;
+	return 0;
+}
+
+static uint32_t EPO_TESTS_Tick() {
+	return model_ms;
+}
+
+/**
+ * Next byte of the ground station, chunks of the file in passes.
+ */
+static void EPO_TESTS_Uplink() {
+	if (ground.passes == 0) {
+		return;
+	}
+	if (ground.offset == 0) {
+		uint8_t *chunk = ground.chunk;
+		chunk[0] = EPO_LINK_SYNC0;
+		chunk[1] = EPO_LINK_SYNC1;
+		chunk[2] = ground.index & 0xFF;
+		chunk[3] = ground.index >> 8;
+		chunk[4] = ground.records & 0xFF;
+		chunk[5] = ground.records >> 8;
+		for (uint8_t i = 0; i < EPO_RECORD_SIZE; i++) {
+			chunk[EPO_LINK_HEADER + i] = EPO_TESTS_Byte(ground.index, i);
+		}
+		uint16_t crc = PACKET_CRC16(chunk + 2, EPO_LINK_CHUNK - 4);
+		chunk[EPO_LINK_CHUNK - 2] = crc & 0xFF;
+		chunk[EPO_LINK_CHUNK - 1] = crc >> 8;
+		if (ground.first_pass && (ground.index == ground.corrupt[0] || ground.index == ground.corrupt[1])) {
+			chunk[EPO_LINK_HEADER + 20] ^= 0x10; // Bit error on the radio
+		}
+	}
+	EPO_Receive(ground.chunk[ground.offset++]);
+	if (ground.offset == EPO_LINK_CHUNK) {
+		ground.offset = 0;
+		if (++ground.index == ground.records) {
+			ground.index = 0;
+			ground.first_pass = 0;
+			ground.passes--;
+		}
+	}
+}
+
+/**
+ * Advance the simulated time: end of transmission, acknowledges and RMC of the module,
+ * bytes of the ground station.
+ */
+static void EPO_TESTS_Wait(uint32_t ms) {
+	for (uint32_t i = 0; i < ms; i++) {
+		model_ms++;
+		if (tx_busy && model_ms >= tx_end_ms) {
+			tx_busy = 0;
+			EPO_TESTS_Receive();
+			L76LM33_TxCallback(&model_huart);
+		}
+		if (module.ack_ms != 0 && model_ms >= module.ack_ms) {
+			module.ack_ms = 0;
+			EPO_TESTS_Emit(module.ack);
+		}
+		if (model_ms >= module.next_ms) {
+			char rmc[80];
+			uint32_t time = model_ms / 1000;
+			char body[64];
+			snprintf(body, sizeof(body), "GNRMC,%02lu%02lu%02lu.000,V,,,,,,,191026,,,N,V", time / 3600 % 24,
+					time / 60 % 60, time % 60);
+			EPO_TESTS_Frame(rmc, sizeof(rmc), body);
+			EPO_TESTS_Emit(rmc);
+			module.next_ms += 1000;
+		}
+		EPO_TESTS_Send();
+
+		ground.credit += EPO_TESTS_RADIO_BAUD;
+		while (ground.credit >= 10000) {
+			ground.credit -= 10000;
+			EPO_TESTS_Uplink();
+		}
+	}
+}
+
+static const L76LM33_Port model_port = {
+	.transmit = EPO_TESTS_Transmit,
+	.set_baud = EPO_TESTS_SetBaud,
+	.tick = EPO_TESTS_Tick,
+	.wait = EPO_TESTS_Wait,
+};
+
+static const EPO_Port epo_port = {
+	.command = L76LM33_Command,
+	.transfer = L76LM33_Transfer,
+	.tick = EPO_TESTS_Tick,
+};
+
+/**
+ * Power on the module model at "baud", L76LM33_Init finds it, EPO_Init.
+ */
+static int8_t EPO_TESTS_Boot(uint32_t baud) {
+	module = (EPO_TESTS_Module) { 0 };
+	module.baud = baud;
+	module.next_ms = 300;
+	ground = (EPO_TESTS_Ground) { 0 };
+	model_ms = 0;
+	tx_busy = 0;
+	model_huart.Init.BaudRate = L76LM33_BAUD_DEFAULT;
+	mcu_baud = L76LM33_BAUD_DEFAULT;
+
+	int8_t status = L76LM33_Init(&model_huart, &model_port);
+	EPO_Init(&epo_port);
+	return status;
+}
+
+/**
+ * Run the main loop every "loop_ms" (L76LM33_Poll, sentences read, EPO_Poll) until the
+ * upload is over, "sent" records are acknowledged or "run_ms" elapsed.
+ *
+ * @return time elapsed
+ */
+static uint32_t EPO_TESTS_Run(uint32_t run_ms, uint16_t loop_ms, uint16_t sent) {
+	uint32_t start_ms = model_ms;
+	while (model_ms - start_ms < run_ms) {
+		EPO_TESTS_Wait(1);
+		if (model_ms % loop_ms == 0) {
+			L76LM33_Poll();
+			while (L76LM33_Read(&L76_data) != -2) {
+			}
+			EPO_Poll();
+		}
+		uint8_t state = EPO_GetState();
+		if (state == EPO_DONE || state == EPO_FAILED || EPO_GetStats()->sent >= sent) {
+			break;
+		}
+	}
+	return model_ms - start_ms;
+}
+
+/**
+ * Ground station starts sending "passes" of a file of "records", "corrupt0" and "corrupt1"
+ * damaged in the first pass.
+ */
+static void EPO_TESTS_StartGround(uint16_t records, uint8_t passes, int16_t corrupt0, int16_t corrupt1) {
+	ground = (EPO_TESTS_Ground) { 0 };
+	ground.records = records;
+	ground.passes = passes;
+	ground.corrupt[0] = corrupt0;
+	ground.corrupt[1] = corrupt1;
+	ground.first_pass = 1;
+}
+
+void EPO_TESTS_Model_LogSTLINK() {
+	const EPO_Stats *stats = EPO_GetStats();
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	for (uint16_t record = 0; record < EPO_SET_RECORDS; record++) {
+		for (uint8_t i = 0; i < EPO_RECORD_SIZE; i++) {
+			file[record * EPO_RECORD_SIZE + i] = EPO_TESTS_Byte(record, i);
+		}
+	}
+
+	// Test 1: one set from memory at 115200 baud, main loop every 100 ms: each record is
+	// queued by the acknowledge of the previous one, not by the loop
+	int8_t boot = EPO_TESTS_Boot(115200);
+	int8_t start = EPO_StartMemory(file, sizeof(file));
+	uint32_t elapsed_ms = EPO_TESTS_Run(20000, 100, UINT16_MAX);
+	printf("Memory: %u records in %lu ms (main loop every 100 ms)\n", stats->sent, elapsed_ms);
+	if (boot == 0 && start == 0 && EPO_GetState() == EPO_DONE && module.cleared && module.ended
+			&& module.stored == EPO_SET_RECORDS && module.wrong == 0 && module.records == EPO_SET_RECORDS
+			&& stats->sent == EPO_SET_RECORDS && stats->failures == 0 && elapsed_ms < EPO_SET_RECORDS * 100
+			&& stats->end_ms - stats->start_ms == elapsed_ms) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: whole file only, busy while uploading, again once done
+	start = EPO_StartMemory(file, sizeof(file) - EPO_RECORD_SIZE);
+	int8_t again = EPO_StartMemory(file, sizeof(file));
+	int8_t busy = EPO_StartMemory(file, sizeof(file));
+	EPO_TESTS_Run(20000, 10, UINT16_MAX);
+	if (start == -1 && EPO_StartMemory(NULL, sizeof(file)) == -1 && again == 0 && busy == -2
+			&& EPO_GetState() == EPO_DONE && module.stored == EPO_SET_RECORDS && module.wrong == 0) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: a record answered "failed" (sent again by the command engine), then a record
+	// lost three times (no acknowledge after the retries): paused, resumed at that record
+	EPO_TESTS_Boot(115200);
+	EPO_StartMemory(file, sizeof(file));
+	EPO_TESTS_Run(20000, 10, 5);
+	module.fails = 1;
+	EPO_TESTS_Run(20000, 10, 10);
+	module.drops = 1 + L76LM33_RETRIES;
+	elapsed_ms = EPO_TESTS_Run(20000, 10, UINT16_MAX);
+	printf("Faults: %lu failures, %lu resumes, %u PMTK721 for %u records\n", stats->failures, stats->resumes,
+			module.records, module.stored);
+	if (EPO_GetState() == EPO_DONE && module.stored == EPO_SET_RECORDS && module.wrong == 0 && module.ended
+			&& stats->failures == 1 && stats->resumes == 1 && module.records == EPO_SET_RECORDS + 1) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: module stops answering, the upload gives up after EPO_MAX_FAILURES records
+	// in a row, then starts again from PMTK127
+	EPO_TESTS_Boot(115200);
+	EPO_StartMemory(file, sizeof(file));
+	EPO_TESTS_Run(20000, 10, 5);
+	module.drops = UINT8_MAX;
+	elapsed_ms = EPO_TESTS_Run(60000, 10, UINT16_MAX);
+	uint8_t failed = EPO_GetState() == EPO_FAILED && stats->failures == EPO_MAX_FAILURES && module.stored == 5;
+	module.drops = 0;
+	start = EPO_StartMemory(file, sizeof(file));
+	EPO_TESTS_Run(20000, 10, UINT16_MAX);
+	printf("Module lost: failed after %lu ms\n", elapsed_ms);
+	if (failed && start == 0 && EPO_GetState() == EPO_DONE && module.stored == EPO_SET_RECORDS && module.wrong == 0) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: from the ground link (RFD900 at 9600 baud), two chunks corrupted in the first
+	// pass: CRC errors, the records after them skipped until the second pass
+	EPO_TESTS_Boot(115200);
+	int8_t listen = EPO_StartLink();
+	EPO_TESTS_StartGround(EPO_SET_RECORDS, 3, 7, 20);
+	elapsed_ms = EPO_TESTS_Run(60000, 10, UINT16_MAX);
+	uint8_t passes = ground.passes;
+	EPO_TESTS_Run(10000, 10, UINT16_MAX);
+	printf("Link: %u records in %lu ms, %lu chunks, %lu CRC errors, %lu skipped, %lu overflows\n", stats->sent,
+			elapsed_ms, stats->chunks, stats->crc_errors, stats->skipped, stats->overflows);
+	if (listen == 0 && EPO_GetState() == EPO_DONE && module.stored == EPO_SET_RECORDS && module.wrong == 0
+			&& module.ended && stats->crc_errors >= 2 && stats->skipped > 0 && stats->overflows == 0 && passes == 1
+			&& module.records == EPO_SET_RECORDS) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: aborted (leaving the pad): the record in flight ends, nothing more is sent and
+	// the ground link is ignored
+	EPO_TESTS_Boot(115200);
+	EPO_StartLink();
+	EPO_TESTS_StartGround(EPO_SET_RECORDS, 2, -1, -1);
+	EPO_TESTS_Run(60000, 10, 5);
+	EPO_Abort();
+	uint16_t records = module.records;
+	uint32_t chunks = stats->chunks;
+	EPO_TESTS_Run(10000, 10, UINT16_MAX);
+	if (EPO_GetState() == EPO_IDLE && module.records <= records + 1 && !module.ended && stats->chunks == chunks
+			&& L76LM33_CommandsPending() == 0) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Test 7: upload time of one set and of a 3 days file at the baud rates of the L76
+	static const uint32_t bauds[] = { 9600, 38400, 57600, 115200 };
+	uint8_t uploads = 1;
+	uint32_t previous_ms = UINT32_MAX;
+	for (uint8_t i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++) {
+		EPO_TESTS_Boot(bauds[i]);
+		EPO_StartMemory(file, sizeof(file));
+		EPO_TESTS_Run(60000, 10, UINT16_MAX);
+		uint32_t set_ms = stats->end_ms - stats->start_ms;
+		printf("%6lu baud: %5lu ms per set, 3 days (%u sets) ~%lu s\n", bauds[i], set_ms, EPO_TESTS_SETS_3DAYS,
+				(set_ms - EPO_TESTS_CLEAR_MS) * EPO_TESTS_SETS_3DAYS / 1000);
+		uploads = uploads && EPO_GetState() == EPO_DONE && module.stored == EPO_SET_RECORDS && module.wrong == 0
+				&& set_ms < previous_ms;
+		previous_ms = set_ms;
+	}
+	if (uploads) {
+		printf("Test 7 passed\n");
+	} else {
+		printf("Test 7 failed\n");
+	}
+
+	// Debug timer Low
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
@@ -0,0 +1,434 @@
+/*
+ * GNSSAID_tests.c
+ *
+ * Power cycles of a model of the L76 with the flash page in RAM (erase to 0xFF, programs
+ * only erased half-words) and an RTC that keeps the time only with VBAT.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/Tests/GNSSAID_tests.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Time to first fix of the model, by aiding received (orders of the L76 datasheet)
+#define GNSSAID_TESTS_COLD_MS     35000  // Nothing
+#define GNSSAID_TESTS_TIME_MS     32000  // Time only
+#define GNSSAID_TESTS_WARM_MS     15000  // Time and position
+#define GNSSAID_TESTS_EPO_MS      5000   // Time, position and a valid EPO window
+
+#define GNSSAID_TESTS_UTC_S       845726400 // 2026-10-19 12:00:00 UTC
+#define GNSSAID_TESTS_LATITUDE_E7  484634000 // Pad
+#define GNSSAID_TESTS_LONGITUDE_E7 -710562000
+#define GNSSAID_TESTS_ALTITUDE_M  160
+#define GNSSAID_TESTS_TIME_S      2      // Time given within this of the truth
+#define GNSSAID_TESTS_POSITION_M  30.0   // Position given within this of the pad
+
+// EPO sets (GPS week and time of week of the first and last set) around the test time
+#define GNSSAID_TESTS_EPO_VALID   "PMTK707,28,2441,86400,2442,64800,2441,86400,2441,108000"
+#define GNSSAID_TESTS_EPO_OLD     "PMTK707,28,2430,86400,2431,64800,2430,86400,2430,108000"
+#define GNSSAID_TESTS_EPO_EMPTY   "PMTK707,0,0,0,0,0,0,0,0,0"
+
+// L76 model
+typedef struct {
+	const char *epo;          // "$PMTK707" reply body, NULL: no reply
+	uint8_t rejects;          // Aiding commands answered "failed" (result -1)
+	uint8_t time;             // 1: PMTK740 received within GNSSAID_TESTS_TIME_S
+	uint8_t position;         // 1: PMTK741 received within GNSSAID_TESTS_POSITION_M, right time
+	uint8_t queries;          // PMTK607 received
+	uint8_t bad;              // Commands malformed or with a wrong time
+	char last[L76LM33_COMMAND_SIZE]; // Last aiding command
+	uint32_t ttff_ms;         // First fix of this boot
+} GNSSAID_TESTS_Module;
+
+static GNSSAID_TESTS_Module module;
+static uint32_t model_ms;     // HAL tick, 0 at power-up
+static uint32_t boot_utc_s;   // UTC at power-up
+
+// Flash page in RAM
+static uint16_t flash[GNSSAID_PAGE_SIZE / 2];
+static uint32_t flash_erases;
+static uint32_t flash_programs; // Half-words programmed
+static int16_t flash_tear = -1; // Power lost after this many half-words of the next program
+
+// RTC of the backup domain
+static uint8_t rtc_running = 0; // 1: set and kept (VBAT)
+static int32_t rtc_error_s;     // RTC - UTC
+
+static uint32_t GNSSAID_TESTS_Utc() {
+	return boot_utc_s + model_ms / 1000;
+}
+
+static int8_t GNSSAID_TESTS_Erase(const uint8_t *page) {
+	if (page != (const uint8_t *)flash) {
+		return -1;
+	}
+	memset(flash, 0xFF, sizeof(flash));
+	flash_erases++;
+	return 0;
+}
+
+static int8_t GNSSAID_TESTS_Program(const uint8_t *address, const uint16_t *data, uint16_t count) {
+	uint16_t *target = (uint16_t *)address;
+	if (target < flash || target + count > flash + GNSSAID_PAGE_SIZE / 2) {
+		return -1;
+	}
+	for (uint16_t i = 0; i < count; i++) {
+		if (flash_tear == 0) {
+			flash_tear = -1;
+			return -1; // Power lost
+		}
+		if (target[i] != 0xFFFF) {
+			return -1; // Not erased (PGERR)
+		}
+		target[i] = data[i];
+		flash_programs++;
+		if (flash_tear > 0) {
+			flash_tear--;
+		}
+	}
+	return 0;
+}
+
+static int8_t GNSSAID_TESTS_GetTime(uint32_t *utc_s) {
+	if (!rtc_running) {
+		return -1;
+	}
+	*utc_s = GNSSAID_TESTS_Utc() + rtc_error_s;
+	return 0;
+}
+
+static void GNSSAID_TESTS_SetTime(uint32_t utc_s) {
+	rtc_running = 1;
+	rtc_error_s = (int32_t)(utc_s - GNSSAID_TESTS_Utc());
+}
+
+/**
+ * Distance between two positions (equirectangular, short distances).
+ */
+static double GNSSAID_TESTS_Distance(double latitude1, double longitude1, double latitude2, double longitude2) {
+	double x = (longitude2 - longitude1) * M_PI / 180.0 * cos((latitude1 + latitude2) * M_PI / 360.0);
+	double y = (latitude2 - latitude1) * M_PI / 180.0;
+	return sqrt(x * x + y * y) * 6371000.0;
+}
+
+/**
+ * Module receiving a command: PMTK740 and PMTK741 checked against the truth and
+ * acknowledged, PMTK607 answered with its EPO window.
+ */
+static int8_t GNSSAID_TESTS_Command(const char *body, uint16_t timeout_ms, uint8_t retries, L76LM33_Done done) {
+	(void)retries;
+	if (strlen(body) + 6 > L76LM33_COMMAND_SIZE) {
+		module.bad++;
+		return -1; // Too long for L76LM33_Command
+	}
+
+	unsigned year, month, day, hours, minutes, seconds;
+	double latitude, longitude;
+	int altitude;
+	int8_t result = 0;
+	uint16_t number = strtoul(body + 4, NULL, 10);
+	if (number == 607) {
+		module.queries++;
+		if (module.epo != NULL) {
+			uint8_t checksum = 0;
+			for (const char *c = module.epo; *c != '\0'; c++) {
+				checksum ^= (uint8_t)*c;
+			}
+			char reply[100];
+			snprintf(reply, sizeof(reply), "$%s*%02X\r\n", module.epo, checksum);
+			GNSSAID_Reply(reply);
+		}
+		return timeout_ms == 0 ? 0 : -1; // No $PMTK001 expected
+	} else if (number == 740 && sscanf(body, "PMTK740,%u,%u,%u,%u,%u,%u", &year, &month, &day, &hours, &minutes,
+			&seconds) == 6) {
+		uint32_t utc_s = GNSSAID_ToUtc(year, month, day, (hours * 60 + minutes) * 60 + seconds);
+		module.time = labs((long)(utc_s - GNSSAID_TESTS_Utc())) <= GNSSAID_TESTS_TIME_S;
+	} else if (number == 741 && sscanf(body, "PMTK741,%lf,%lf,%d,%u,%u,%u,%u,%u,%u", &latitude, &longitude, &altitude,
+			&year, &month, &day, &hours, &minutes, &seconds) == 9) {
+		uint32_t utc_s = GNSSAID_ToUtc(year, month, day, (hours * 60 + minutes) * 60 + seconds);
+		double error_m = GNSSAID_TESTS_Distance(latitude, longitude, GNSSAID_TESTS_LATITUDE_E7 / 1e7,
+				GNSSAID_TESTS_LONGITUDE_E7 / 1e7);
+		module.position = module.time && labs((long)(utc_s - GNSSAID_TESTS_Utc())) <= GNSSAID_TESTS_TIME_S
+				&& error_m < GNSSAID_TESTS_POSITION_M && abs(altitude - GNSSAID_TESTS_ALTITUDE_M) < 30;
+	} else {
+		module.bad++;
+		result = -1;
+	}
+	if (module.rejects > 0) {
+		module.rejects--;
+		module.time = module.position = 0;
+		result = -1; // "failed", not applied
+	}
+	strncpy(module.last, body, sizeof(module.last) - 1);
+	if (done != NULL) {
+		done(number, result);
+	}
+	return 0;
+}
+
+static uint32_t GNSSAID_TESTS_Tick() {
+	return model_ms;
+}
+
+static const GNSSAID_Port model_port = {
+	.page = (const uint8_t *)flash,
+	.erase = GNSSAID_TESTS_Erase,
+	.program = GNSSAID_TESTS_Program,
+	.get_time = GNSSAID_TESTS_GetTime,
+	.set_time = GNSSAID_TESTS_SetTime,
+	.command = GNSSAID_TESTS_Command,
+	.tick = GNSSAID_TESTS_Tick,
+};
+
+/**
+ * Power cycle "off_s" long (the RTC keeps the time when "vbat"), GNSSAID_Init and
+ * GNSSAID_Start. The module works out its time to first fix from the aiding received.
+ *
+ * @return GNSSAID_Start result
+ */
+static int8_t GNSSAID_TESTS_Boot(uint32_t off_s, uint8_t vbat, const char *epo) {
+	boot_utc_s = GNSSAID_TESTS_Utc() + off_s;
+	model_ms = 0;
+	rtc_running = rtc_running && vbat;
+	memset(&module, 0, sizeof(module));
+	module.epo = epo;
+
+	GNSSAID_Init(&model_port);
+	int8_t status = GNSSAID_Start();
+
+	uint8_t epo_valid = epo != NULL && strcmp(epo, GNSSAID_TESTS_EPO_VALID) == 0;
+	if (module.time && module.position && epo_valid) {
+		module.ttff_ms = GNSSAID_TESTS_EPO_MS;
+	} else if (module.time && module.position) {
+		module.ttff_ms = GNSSAID_TESTS_WARM_MS;
+	} else if (module.time) {
+		module.ttff_ms = GNSSAID_TESTS_TIME_MS;
+	} else {
+		module.ttff_ms = GNSSAID_TESTS_COLD_MS;
+	}
+	return status;
+}
+
+/**
+ * Run "run_ms" with a read every 100 ms: fixes at the pad after the time to first fix of
+ * the model, GNSSAID_Update after each read.
+ *
+ * @return saves (GNSSAID_Update returned 0)
+ */
+static uint32_t GNSSAID_TESTS_Run(uint32_t run_ms, uint8_t save) {
+	uint32_t saves = 0;
+	for (uint32_t end_ms = model_ms + run_ms; model_ms < end_ms;) {
+		model_ms += 100;
+		L76LM33 data = { 0 };
+		if (model_ms >= module.ttff_ms) {
+			uint32_t fix_ms = model_ms - 40; // Epoch before the read
+			uint32_t utc_s = boot_utc_s + fix_ms / 1000;
+			uint32_t seconds;
+			GNSSAID_FromUtc(utc_s, &data.year, &data.month, &data.day, &seconds);
+			data = (L76LM33) {
+				.status = 1, .fix = 1,
+				.latitude_e7 = GNSSAID_TESTS_LATITUDE_E7, .longitude_e7 = GNSSAID_TESTS_LONGITUDE_E7,
+				.utc_ms = seconds * 1000 + fix_ms % 1000, .fix_ms = fix_ms,
+				.year = data.year, .month = data.month, .day = data.day,
+				.altitude_fix = 1, .altitude_m = GNSSAID_TESTS_ALTITUDE_M,
+			};
+		}
+		saves += GNSSAID_Update(&data, save) == 0;
+	}
+	return saves;
+}
+
+/**
+ * Number of records in the page that are not erased.
+ */
+static uint8_t GNSSAID_TESTS_Used() {
+	uint8_t used = 0;
+	for (uint8_t i = 0; i < GNSSAID_RECORDS; i++) {
+		for (uint8_t j = 0; j < GNSSAID_RECORD_SIZE / 2; j++) {
+			if (flash[i * GNSSAID_RECORD_SIZE / 2 + j] != 0xFFFF) {
+				used++;
+				break;
+			}
+		}
+	}
+	return used;
+}
+
+void GNSSAID_TESTS_Model_LogSTLINK() {
+	const GNSSAID_Stats *stats = GNSSAID_GetStats();
+
+	// Debug timer High
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: dates to UTC seconds and back, every day from 2000 to 2099
+	uint8_t dates = GNSSAID_ToUtc(2000, 1, 1, 0) == 0 && GNSSAID_ToUtc(2026, 10, 19, 12 * 3600) == GNSSAID_TESTS_UTC_S
+			&& GNSSAID_ToUtc(2024, 2, 29, 86399) == 762566399 && GNSSAID_ToUtc(2099, 12, 31, 86399) == 3155759999u;
+	for (uint32_t days = 0; days < 36525 && dates; days++) {
+		uint16_t year;
+		uint8_t month, day;
+		uint32_t seconds;
+		GNSSAID_FromUtc(days * GNSSAID_DAY_S + 43210, &year, &month, &day, &seconds);
+		dates = seconds == 43210 && GNSSAID_ToUtc(year, month, day, seconds) == days * GNSSAID_DAY_S + 43210
+				&& month >= 1 && month <= 12 && day >= 1 && day <= 31;
+	}
+	if (dates) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: first boot, empty page and RTC never set: nothing given, no EPO in the module,
+	// cold start, record saved and RTC set at the first fix
+	memset(flash, 0xFF, sizeof(flash));
+	boot_utc_s = GNSSAID_TESTS_UTC_S;
+	model_ms = 0;
+	rtc_running = 0;
+	int8_t init = GNSSAID_Init(&model_port);
+	GNSSAID_TESTS_Boot(0, 1, GNSSAID_TESTS_EPO_EMPTY);
+	uint32_t saves = GNSSAID_TESTS_Run(40000, GNSSAID_SAVE_ANY);
+	GNSSAID_Record record;
+	memcpy(&record, flash, sizeof(record));
+	printf("Cold: TTFF %lu ms, aiding %u, EPO %u\n", stats->ttff_ms, stats->aiding, stats->epo);
+	if (init == -2 && !stats->loaded && stats->aiding == GNSSAID_AIDING_NONE && module.queries == 1
+			&& module.last[0] == '\0' && stats->epo == GNSSAID_EPO_NONE && stats->ttff_ms == GNSSAID_TESTS_COLD_MS - 40
+			&& saves == 1 && stats->time_sets == 1 && rtc_running && rtc_error_s == 0 && record.magic == GNSSAID_MAGIC
+			&& record.latitude_e7 == GNSSAID_TESTS_LATITUDE_E7 && record.longitude_e7 == GNSSAID_TESTS_LONGITUDE_E7
+			&& record.altitude_m == GNSSAID_TESTS_ALTITUDE_M && record.ttff_ms == stats->ttff_ms
+			&& record.utc_s == GNSSAID_TESTS_UTC_S + (GNSSAID_TESTS_COLD_MS - 40) / 1000) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: power cycle of an hour with VBAT: PMTK740 and PMTK741 from the RTC and the
+	// record, acknowledged, warm start
+	uint32_t cold_ms = stats->ttff_ms;
+	int8_t start = GNSSAID_TESTS_Boot(3600, 1, GNSSAID_TESTS_EPO_OLD);
+	uint32_t acknowledged = stats->acknowledged;
+	printf("%s\n", module.last);
+	GNSSAID_TESTS_Run(20000, GNSSAID_SAVE_ANY);
+	printf("Warm: TTFF %lu ms (previous boot %lu ms), aiding %u, EPO %u\n", stats->ttff_ms, stats->previous.ttff_ms,
+			stats->aiding, stats->epo);
+	if (start == 0 && stats->loaded && stats->previous.ttff_ms == cold_ms
+			&& stats->previous.aiding == GNSSAID_AIDING_NONE && stats->aiding == GNSSAID_AIDING_POSITION
+			&& module.time && module.position && acknowledged == 2 && stats->rejected == 0 && module.bad == 0
+			&& strcmp(module.last, "PMTK741,48.463400,-71.056200,160,2026,10,19,13,00,40") == 0
+			&& stats->epo == GNSSAID_EPO_EXPIRED && stats->ttff_ms == GNSSAID_TESTS_WARM_MS - 40) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: valid EPO window in the module, hot start. Then a boot without VBAT: record
+	// loaded but the time is unknown, nothing given (EPO window known, checked at the fix)
+	GNSSAID_TESTS_Boot(600, 1, GNSSAID_TESTS_EPO_VALID);
+	GNSSAID_TESTS_Run(10000, GNSSAID_SAVE_ANY);
+	uint32_t hot_ms = stats->ttff_ms;
+	uint8_t hot_epo = stats->epo;
+	uint32_t epo_end_s = stats->epo_end_s;
+	start = GNSSAID_TESTS_Boot(600, 0, GNSSAID_TESTS_EPO_VALID);
+	uint8_t stored = stats->epo;
+	GNSSAID_TESTS_Run(40000, GNSSAID_SAVE_ANY);
+	printf("Hot: TTFF %lu ms, no VBAT: TTFF %lu ms, aiding %u, EPO %u then %u\n", hot_ms, stats->ttff_ms,
+			stats->aiding, stored, stats->epo);
+	if (hot_ms == GNSSAID_TESTS_EPO_MS - 40 && hot_epo == GNSSAID_EPO_VALID
+			&& epo_end_s == 2442 * GNSSAID_WEEK_S + 64800 + GNSSAID_EPO_SET_S - GNSSAID_GPS_EPOCH_S - GNSSAID_GPS_UTC_S
+			&& start == -2 && stats->loaded && stats->aiding == GNSSAID_AIDING_NONE && module.last[0] == '\0'
+			&& stored == GNSSAID_EPO_STORED && stats->epo == GNSSAID_EPO_VALID
+			&& stats->ttff_ms == GNSSAID_TESTS_COLD_MS - 40 && rtc_running && stats->previous.epo == GNSSAID_EPO_VALID) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: no reply to PMTK607 (unknown after the timeout), position older than
+	// GNSSAID_MAX_AGE_S: time only. Aiding rejected by the module: counted, cold start
+	GNSSAID_TESTS_Boot(GNSSAID_MAX_AGE_S + 1, 1, NULL);
+	uint8_t pending = stats->epo;
+	uint8_t aiding = stats->aiding;
+	GNSSAID_TESTS_Run(40000, GNSSAID_SAVE_NONE);
+	uint8_t unknown = stats->epo;
+	uint32_t time_ms = stats->ttff_ms;
+	uint32_t used = GNSSAID_TESTS_Used();
+	memset(&module, 0, sizeof(module));
+	module.rejects = 2;
+	GNSSAID_Init(&model_port);
+	GNSSAID_Start();
+	if (pending == GNSSAID_EPO_PENDING && unknown == GNSSAID_EPO_UNKNOWN && aiding == GNSSAID_AIDING_TIME
+			&& time_ms == GNSSAID_TESTS_TIME_MS - 40 && used == 4 && stats->rejected == 1 && stats->acknowledged == 0
+			&& !module.time) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: saves every GNSSAID_SAVE_PERIOD_S after the landing, page erased when full,
+	// last record loaded at the next boot
+	GNSSAID_TESTS_Boot(60, 1, GNSSAID_TESTS_EPO_VALID);
+	uint32_t erases = flash_erases;
+	saves = GNSSAID_TESTS_Run((uint32_t)GNSSAID_RECORDS * 2 * GNSSAID_SAVE_PERIOD_S * 1000, GNSSAID_SAVE_ANY);
+	uint16_t sequence = stats->previous.sequence;
+	GNSSAID_TESTS_Boot(60, 1, GNSSAID_TESTS_EPO_VALID);
+	printf("%lu saves, %lu erases, %u records in the page, sequence %u\n", saves, flash_erases - erases,
+			GNSSAID_TESTS_Used(), stats->previous.sequence);
+	if (saves == 2 * GNSSAID_RECORDS && flash_erases - erases == 2 && GNSSAID_TESTS_Used() == used + saves - 2 * GNSSAID_RECORDS
+			&& stats->previous.sequence == sequence + saves && stats->errors == 0
+			&& stats->previous.utc_s + GNSSAID_SAVE_PERIOD_S + 60 > boot_utc_s) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Test 7: power lost while programming, the torn record is skipped (previous one loaded)
+	// and the next one written after it. Never written when not allowed (flight)
+	GNSSAID_Record previous = stats->previous;
+	used = GNSSAID_TESTS_Used();
+	uint32_t programs = flash_programs;
+	flash_tear = 5;
+	saves = GNSSAID_TESTS_Run(10000, GNSSAID_SAVE_ANY);
+	uint32_t errors = stats->errors;
+	GNSSAID_TESTS_Boot(60, 1, GNSSAID_TESTS_EPO_VALID);
+	uint8_t skipped = memcmp(&stats->previous, &previous, sizeof(previous)) == 0;
+	saves += GNSSAID_TESTS_Run(10000, GNSSAID_SAVE_ANY);
+	uint32_t saved_s = boot_utc_s + (GNSSAID_TESTS_EPO_MS - 40) / 1000;
+	uint32_t flight_programs = flash_programs;
+	GNSSAID_TESTS_Run(2 * GNSSAID_SAVE_PERIOD_S * 1000, GNSSAID_SAVE_NONE);
+	flight_programs = flash_programs - flight_programs;
+	GNSSAID_TESTS_Boot(60, 1, GNSSAID_TESTS_EPO_VALID);
+	if (errors == 1 && skipped && saves == 1 && flash_programs - programs == 5 + GNSSAID_RECORD_SIZE / 2
+			&& flight_programs == 0 && GNSSAID_TESTS_Used() == used + 2 && stats->previous.utc_s == saved_s
+			&& stats->previous.sequence == previous.sequence + 1) {
+		printf("Test 7 passed\n");
+	} else {
+		printf("Test 7 failed\n");
+	}
+
+	// Test 8: on the pad the page is never erased, saves stop when it is full. The next boot
+	// erases it and writes the last record back first
+	GNSSAID_TESTS_Boot(60, 1, GNSSAID_TESTS_EPO_VALID);
+	used = GNSSAID_TESTS_Used();
+	erases = flash_erases;
+	saves = GNSSAID_TESTS_Run((uint32_t)GNSSAID_RECORDS * GNSSAID_SAVE_PERIOD_S * 1000, GNSSAID_SAVE_NO_ERASE);
+	uint32_t pad_erases = flash_erases - erases;
+	sequence = stats->previous.sequence + saves;
+	GNSSAID_TESTS_Boot(60, 1, GNSSAID_TESTS_EPO_VALID);
+	uint8_t compacted = GNSSAID_TESTS_Used();
+	saves += GNSSAID_TESTS_Run(10000, GNSSAID_SAVE_NO_ERASE);
+	printf("%lu saves, %lu erases on the pad, %lu at the boot, %u records in the page\n", saves, pad_erases,
+			flash_erases - erases - pad_erases, compacted);
+	if (saves == GNSSAID_RECORDS - used + 1 && pad_erases == 0 && flash_erases - erases == 1 && compacted == 1
+			&& stats->loaded && stats->previous.sequence == sequence && stats->errors == 0
+			&& GNSSAID_TESTS_Used() == 2) {
+		printf("Test 8 passed\n");
+	} else {
+		printf("Test 8 failed\n");
+	}
+
+	// Debug timer Low
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
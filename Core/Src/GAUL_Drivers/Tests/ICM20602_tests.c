@@ -0,0 +1,588 @@
+/*
+ * ICM20602_tests.c
+ *
+ * ICM20602_TESTS_Model_LogSTLINK replaces the SPI bus by a register-level model of the
+ * ICM-20602: the model decodes the transactions (address byte, then auto-incremented
+ * registers), resets on PWR_MGMT_1, and writes a 14-byte packet in its FIFO every sample
+ * period of its own clock (with an error, to test the timeline). The FIFO stops when it is
+ * full (CONFIG FIFO_MODE) and sets FIFO_OFLOW_INT. Every exchanged byte takes 8 clocks of
+ * simulated time, a DMA burst completes when the simulated time reaches its end
+ * (ICM20602_TESTS_ModelAdvance deselects the IMU and calls ICM20602_RxCallback like the
+ * SPI bus).
+ *
+ * The packet of sample number k holds k (accel X and Y), so the tests check that no sample
+ * is lost, duplicated or reordered, and compare the reconstructed times with the times the
+ * model wrote the samples.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/Tests/ICM20602_tests.h"
+
+#include "GAUL_System/Tests/TESTS.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define ICM20602_TESTS_DRAIN_MS 10 // Task period
+
+static SPI_HandleTypeDef model_hspi;
+static ICM20602_TESTS_Device device;
+static ICM20602_TESTS_ModelStats model;
+
+// Bus
+static uint64_t sim_ns;
+static uint8_t selected;
+static uint8_t address_next;     // Next byte of the transaction is the address
+static uint8_t address;
+static uint8_t writing;
+static uint8_t dma_busy;
+static uint64_t dma_done_ns;
+
+// IMU
+static uint8_t registers[128];
+static uint8_t fifo[ICM20602_FIFO_SIZE];
+static uint16_t fifo_head;       // Oldest byte
+static uint16_t fifo_count;
+static uint16_t count_latched;   // FIFO_COUNTL after FIFO_COUNTH
+static uint64_t wake_ns;         // Sampling started (clock source selected)
+static uint32_t sample_index;    // Next sample of the IMU
+static uint8_t awake;
+
+static ICM20602_Sample samples[ICM20602_MAX_BURST];
+
+static uint32_t random_state = 12345;
+
+static uint32_t ICM20602_TESTS_Random() {
+	return TESTS_Random(&random_state);
+}
+
+static uint64_t ICM20602_TESTS_SampleNs(uint32_t index) {
+	return wake_ns + device.phase_ns + (uint64_t)index * (ICM20602_PERIOD_NS + device.clock_error_ns);
+}
+
+static void ICM20602_TESTS_Packet(uint32_t k, uint8_t packet[ICM20602_PACKET_SIZE]) {
+	uint16_t values[7] = { k, k >> 16, k * 3, 2500, k * 7, 0x1234, (uint16_t)-k };
+	for (uint8_t i = 0; i < 7; i++) {
+		packet[2 * i] = values[i] >> 8;
+		packet[2 * i + 1] = values[i];
+	}
+}
+
+/**
+ * Samples of the IMU clock up to the simulated time.
+ */
+static void ICM20602_TESTS_Sample() {
+	while (awake && ICM20602_TESTS_SampleNs(sample_index) <= sim_ns) {
+		uint8_t packet[ICM20602_PACKET_SIZE];
+		ICM20602_TESTS_Packet(sample_index, packet);
+		memcpy(&registers[ICM20602_REG_ACCEL_XOUT_H], packet, ICM20602_PACKET_SIZE);
+		sample_index++;
+
+		if (!(registers[ICM20602_REG_USER_CTRL] & ICM20602_USER_FIFO_EN)
+				|| registers[ICM20602_REG_FIFO_EN] != ICM20602_SETTING_FIFO_EN) {
+			continue;
+		}
+		if (fifo_count + ICM20602_PACKET_SIZE > ICM20602_FIFO_SIZE) {
+			registers[ICM20602_REG_INT_STATUS] |= ICM20602_INT_FIFO_OFLOW;
+			model.overflows++;
+			if (registers[ICM20602_REG_CONFIG] & 0x40) {
+				continue; // FIFO_MODE: stop when full
+			}
+			fifo_head = (fifo_head + ICM20602_PACKET_SIZE) % ICM20602_FIFO_SIZE;
+			fifo_count -= ICM20602_PACKET_SIZE;
+		}
+		for (uint8_t i = 0; i < ICM20602_PACKET_SIZE; i++) {
+			fifo[(fifo_head + fifo_count++) % ICM20602_FIFO_SIZE] = packet[i];
+		}
+	}
+}
+
+static void ICM20602_TESTS_PowerOn() {
+	memset(registers, 0, sizeof(registers));
+	registers[ICM20602_REG_PWR_MGMT_1] = 0x41; // Sleep
+	registers[ICM20602_REG_CONFIG] = 0x80;
+	registers[ICM20602_REG_WHO_AM_I] = ICM20602_DEVICE_ID;
+	fifo_head = 0;
+	fifo_count = 0;
+	awake = 0;
+}
+
+static void ICM20602_TESTS_WriteRegister(uint8_t reg, uint8_t value) {
+	switch (reg) {
+	case ICM20602_REG_PWR_MGMT_1:
+		if (value & ICM20602_SETTING_RESET) {
+			ICM20602_TESTS_PowerOn();
+			return;
+		}
+		if (!awake && !(value & 0x40)) {
+			awake = 1;
+			wake_ns = sim_ns;
+			sample_index = 0;
+		}
+		awake = !(value & 0x40);
+		break;
+	case ICM20602_REG_USER_CTRL:
+		if (value & ICM20602_USER_FIFO_RST) {
+			fifo_head = 0;
+			fifo_count = 0;
+			value &= ~ICM20602_USER_FIFO_RST; // Self-clearing
+		}
+		break;
+	case ICM20602_REG_WHO_AM_I:
+	case ICM20602_REG_INT_STATUS:
+	case ICM20602_REG_FIFO_COUNTH:
+	case ICM20602_REG_FIFO_COUNTH + 1:
+		return; // Read only
+	}
+	registers[reg] = value;
+}
+
+static uint8_t ICM20602_TESTS_ReadRegister(uint8_t reg) {
+	uint8_t value;
+	switch (reg) {
+	case ICM20602_REG_FIFO_COUNTH:
+		count_latched = fifo_count;
+		return count_latched >> 8;
+	case ICM20602_REG_FIFO_COUNTH + 1:
+		return count_latched;
+	case ICM20602_REG_INT_STATUS:
+		value = registers[reg];
+		registers[reg] = 0; // Cleared on read
+		return value;
+	case ICM20602_REG_FIFO_R_W:
+		if (fifo_count == 0) {
+			return 0xFF;
+		}
+		value = fifo[fifo_head];
+		fifo_head = (fifo_head + 1) % ICM20602_FIFO_SIZE;
+		fifo_count--;
+		return value;
+	default:
+		return registers[reg];
+	}
+}
+
+static uint8_t ICM20602_TESTS_Exchange(uint8_t byte) {
+	sim_ns += ICM20602_TESTS_BYTE_NS;
+	ICM20602_TESTS_Sample();
+	if (dma_busy) {
+		model.conflicts++;
+	}
+	if (!selected || !device.present) {
+		return 0xFF;
+	}
+	model.bytes++;
+	model.bus_ns += ICM20602_TESTS_BYTE_NS;
+	model.cpu_ns += ICM20602_TESTS_BYTE_NS;
+
+	if (address_next) {
+		address_next = 0;
+		writing = !(byte & ICM20602_READ);
+		address = byte & ~ICM20602_READ;
+		return 0x00;
+	}
+	uint8_t reg = address;
+	if (reg != ICM20602_REG_FIFO_R_W) {
+		address = (address + 1) & 0x7F; // Auto-increment, except the FIFO
+	}
+	if (writing) {
+		ICM20602_TESTS_WriteRegister(reg, byte);
+		return 0x00;
+	}
+	return ICM20602_TESTS_ReadRegister(reg);
+}
+
+static void ICM20602_TESTS_Select(uint8_t select) {
+	if (select && !selected) {
+		model.transactions++;
+		sim_ns += ICM20602_TESTS_SELECT_NS;
+		model.bus_ns += ICM20602_TESTS_SELECT_NS;
+		model.cpu_ns += ICM20602_TESTS_SELECT_NS;
+		address_next = 1;
+	}
+	selected = select;
+}
+
+static void ICM20602_TESTS_Read(uint8_t data[], uint16_t size) {
+	for (uint16_t i = 0; i < size; i++) {
+		data[i] = ICM20602_TESTS_Exchange(0xFF);
+	}
+}
+
+static int8_t ICM20602_TESTS_ReadDMA(uint8_t reg, uint8_t data[], uint16_t size) {
+	if (!device.dma) {
+		return -1;
+	}
+	if (selected || dma_busy) {
+		model.conflicts++;
+		return -1;
+	}
+	ICM20602_TESTS_Select(1);
+	ICM20602_TESTS_Exchange(reg | ICM20602_READ);
+	// The model reads the FIFO at once, the samples written during the transfer come after
+	for (uint16_t i = 0; i < size; i++) {
+		data[i] = device.present ? ICM20602_TESTS_ReadRegister(address) : 0xFF;
+	}
+	dma_busy = 1;
+	dma_done_ns = sim_ns + (uint64_t)size * ICM20602_TESTS_BYTE_NS;
+	model.bytes += size;
+	model.bus_ns += (uint64_t)size * ICM20602_TESTS_BYTE_NS;
+	return 0;
+}
+
+static const ICM20602_Port model_port = { ICM20602_TESTS_Select, ICM20602_TESTS_Exchange, ICM20602_TESTS_Read,
+		ICM20602_TESTS_ReadDMA };
+
+/**
+ * New IMU (powered off, FIFO empty), statistics cleared.
+ */
+void ICM20602_TESTS_ModelReset(const ICM20602_TESTS_Device *new_device) {
+	device = *new_device;
+	memset(&model, 0, sizeof(model));
+	selected = 0;
+	dma_busy = 0;
+	wake_ns = 0;
+	sample_index = 0;
+	ICM20602_TESTS_PowerOn();
+}
+
+/**
+ * Advance the simulated time, completing the DMA transfer in progress (IMU deselected).
+ */
+void ICM20602_TESTS_ModelAdvance(uint32_t time_us) {
+	uint64_t end_ns = sim_ns + (uint64_t)time_us * 1000;
+	if (dma_busy && dma_done_ns <= end_ns) {
+		if (dma_done_ns > sim_ns) {
+			sim_ns = dma_done_ns;
+		}
+		dma_busy = 0;
+		ICM20602_TESTS_Select(0);
+		ICM20602_RxCallback(&model_hspi);
+	}
+	if (end_ns > sim_ns) {
+		sim_ns = end_ns;
+	}
+	ICM20602_TESTS_Sample();
+}
+
+uint32_t ICM20602_TESTS_ModelTimeUs() {
+	return sim_ns / 1000;
+}
+
+/**
+ * @return time the IMU wrote sample number "index" (us)
+ */
+uint32_t ICM20602_TESTS_ModelSampleTimeUs(uint32_t index) {
+	return ICM20602_TESTS_SampleNs(index) / 1000;
+}
+
+const ICM20602_TESTS_ModelStats *ICM20602_TESTS_ModelGetStats() {
+	return &model;
+}
+
+/**
+ * ICM20602_Init with the model.
+ */
+int8_t ICM20602_TESTS_ModelInit() {
+	return ICM20602_Init(&model_hspi, &model_port);
+}
+
+typedef struct {
+	uint32_t samples;
+	uint32_t gaps;             // Samples missing
+	uint32_t disorder;         // Sample numbers going back
+	uint32_t wrong;            // Values other than those of the sample number
+	int32_t max_error_us;      // Largest |reconstructed - true| time, after "settle_us"
+	uint64_t sum_error_us;
+	uint32_t errors_counted;
+	int32_t last;              // Last sample number, -1 before the first
+	uint32_t settle_us;        // Timeline errors counted after this time
+} ICM20602_TESTS_Check;
+
+static void ICM20602_TESTS_CheckReset(ICM20602_TESTS_Check *check, uint32_t settle_us) {
+	memset(check, 0, sizeof(ICM20602_TESTS_Check));
+	check->last = -1;
+	check->settle_us = settle_us;
+}
+
+static void ICM20602_TESTS_CheckSamples(ICM20602_TESTS_Check *check, int16_t count) {
+	for (int16_t i = 0; i < count; i++) {
+		uint32_t k = (uint16_t)samples[i].accel[0] | (uint32_t)(uint16_t)samples[i].accel[1] << 16;
+		uint8_t packet[ICM20602_PACKET_SIZE];
+		ICM20602_TESTS_Packet(k, packet);
+		if (samples[i].accel[2] != (int16_t)(packet[4] << 8 | packet[5]) || samples[i].temp != 2500
+				|| samples[i].gyro[0] != (int16_t)(packet[8] << 8 | packet[9])
+				|| samples[i].gyro[2] != (int16_t)(packet[12] << 8 | packet[13])) {
+			check->wrong++;
+		}
+		if (check->last >= 0 && (int32_t)k <= check->last) {
+			check->disorder++;
+		} else if (check->last >= 0) {
+			check->gaps += k - check->last - 1;
+		}
+		check->last = k;
+		check->samples++;
+
+		int32_t error_us = (int32_t)(samples[i].time_us - ICM20602_TESTS_ModelSampleTimeUs(k));
+		if (error_us < 0) {
+			error_us = -error_us;
+		}
+		if (samples[i].time_us >= check->settle_us) {
+			if (error_us > check->max_error_us) {
+				check->max_error_us = error_us;
+			}
+			check->sum_error_us += error_us;
+			check->errors_counted++;
+		}
+	}
+}
+
+/**
+ * Drain every ICM20602_TESTS_DRAIN_MS (+ 0 to "jitter_us") until "end_us".
+ */
+static void ICM20602_TESTS_Run(ICM20602_TESTS_Check *check, uint32_t end_us, uint32_t jitter_us) {
+	while (ICM20602_TESTS_ModelTimeUs() < end_us) {
+		do {
+			if (ICM20602_StartRead(ICM20602_TESTS_ModelTimeUs()) != 0) {
+				break;
+			}
+			int16_t count;
+			while ((count = ICM20602_Collect(samples)) == -2) {
+				ICM20602_TESTS_ModelAdvance(10);
+			}
+			ICM20602_TESTS_CheckSamples(check, count);
+		} while (ICM20602_Pending() > 0);
+		ICM20602_TESTS_ModelAdvance(ICM20602_TESTS_DRAIN_MS * 1000 + (jitter_us ? ICM20602_TESTS_Random() % jitter_us : 0));
+	}
+}
+
+static void ICM20602_TESTS_LogCheck(const ICM20602_TESTS_Check *check) {
+	printf("%lu samples, %lu missing, %lu out of order, %lu wrong, time error max %ld us mean %lu us\n",
+			check->samples, check->gaps, check->disorder, check->wrong, check->max_error_us,
+			check->errors_counted ? (uint32_t)(check->sum_error_us / check->errors_counted) : 0);
+}
+
+void ICM20602_TESTS_Model_LogSTLINK() {
+	ICM20602_TESTS_Device test_device = { 1, 0, 300000, 1 };
+	ICM20602_TESTS_Check check;
+	uint8_t ok;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: initialization (1 kHz into the FIFO, stop when full, SPI only), then no IMU
+	ICM20602_TESTS_ModelReset(&test_device);
+	int8_t status = ICM20602_TESTS_ModelInit();
+	ok = status == 0 && registers[ICM20602_REG_CONFIG] == ICM20602_SETTING_CONFIG
+			&& registers[ICM20602_REG_SMPLRT_DIV] == 0 && registers[ICM20602_REG_FIFO_EN] == 0x18
+			&& registers[ICM20602_REG_USER_CTRL] == ICM20602_USER_FIFO_EN
+			&& registers[ICM20602_REG_I2C_IF] == ICM20602_SETTING_I2C_DIS && awake && !selected;
+	test_device.present = 0;
+	ICM20602_TESTS_ModelReset(&test_device);
+	if (ok && ICM20602_TESTS_ModelInit() == -1) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: 20 s drained every 10-12 ms, IMU clock 0.8% fast then 0.8% slow: every sample
+	// once and in order, times within one period after the period is estimated (2 s)
+	ok = 1;
+	for (int8_t sign = -1; sign <= 1; sign += 2) {
+		test_device.present = 1;
+		test_device.clock_error_ns = sign * 8000;
+		ICM20602_TESTS_ModelReset(&test_device);
+		status = ICM20602_TESTS_ModelInit();
+		uint32_t start_us = ICM20602_TESTS_ModelTimeUs();
+		ICM20602_TESTS_CheckReset(&check, start_us + 2000000);
+		ICM20602_TESTS_Run(&check, start_us + 20000000, 2000);
+		ICM20602_TESTS_LogCheck(&check);
+		printf("Period %lu ns (true %ld ns), correction max %ld us\n", ICM20602_GetStats()->period_ns,
+				ICM20602_PERIOD_NS + test_device.clock_error_ns, ICM20602_GetStats()->max_correction_us);
+		ok &= status == 0 && check.samples > 19800 && check.gaps == 0 && check.disorder == 0 && check.wrong == 0
+				&& check.max_error_us < 1000 && model.overflows == 0 && model.conflicts == 0
+				&& ICM20602_GetStats()->overflows == 0;
+	}
+	if (ok) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: the burst returns during the DMA (IMU selected, no other byte on the bus),
+	// the DMA interrupt releases the bus, then the samples are collected
+	test_device.clock_error_ns = 0;
+	ICM20602_TESTS_ModelReset(&test_device);
+	status = ICM20602_TESTS_ModelInit();
+	ICM20602_TESTS_ModelAdvance(20000);
+	uint32_t bytes = model.bytes;
+	status |= ICM20602_StartRead(ICM20602_TESTS_ModelTimeUs());
+	ok = ICM20602_GetState() == ICM20602_STATE_DMA && ICM20602_Collect(samples) == -2 && selected
+			&& ICM20602_StartRead(ICM20602_TESTS_ModelTimeUs()) == -2;
+	ICM20602_TESTS_ModelAdvance(2000);
+	ok &= !selected;
+	int16_t count = ICM20602_Collect(samples);
+	printf("%d samples in %lu bytes\n", count, model.bytes - bytes);
+	if (status == 0 && ok && count == 20 && !selected && model.bytes - bytes == 3 + 1 + 20 * ICM20602_PACKET_SIZE
+			&& model.conflicts == 0 && ICM20602_GetStats()->dma_fallbacks == 0) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: no drain for 150 ms: overflow detected, the 72 samples of the full FIFO are
+	// returned in order with their times, the samples lost are counted, the timeline restarts
+	ICM20602_TESTS_ModelReset(&test_device);
+	status = ICM20602_TESTS_ModelInit();
+	uint32_t start_us = ICM20602_TESTS_ModelTimeUs();
+	ICM20602_TESTS_CheckReset(&check, 0);
+	ICM20602_TESTS_Run(&check, start_us + 1000000, 0);
+	ICM20602_TESTS_ModelAdvance(150000);
+	ICM20602_TESTS_Run(&check, start_us + 2000000, 0);
+	const ICM20602_Stats *stats = ICM20602_GetStats();
+	ICM20602_TESTS_LogCheck(&check);
+	ICM20602_TESTS_LogStats();
+	if (status == 0 && stats->overflows == 1 && model.overflows > 0 && check.disorder == 0 && check.wrong == 0
+			&& check.max_error_us < 1000 && check.gaps >= stats->lost - 1 && check.gaps <= stats->lost + 1
+			&& check.gaps > 60 && stats->resyncs == 1) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: no RX DMA, the burst is read in the same transaction without DMA
+	test_device.dma = 0;
+	ICM20602_TESTS_ModelReset(&test_device);
+	status = ICM20602_TESTS_ModelInit();
+	ICM20602_TESTS_CheckReset(&check, 0);
+	start_us = ICM20602_TESTS_ModelTimeUs();
+	uint32_t transactions = model.transactions;
+	ICM20602_TESTS_Run(&check, start_us + 1000000, 0);
+	printf("%lu transactions\n", model.transactions - transactions);
+	if (status == 0 && check.samples > 990 && check.gaps == 0 && check.wrong == 0
+			&& ICM20602_GetStats()->dma_fallbacks == ICM20602_GetStats()->reads
+			&& model.transactions - transactions <= 2 * 101) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+/**
+ * SPI2 and CPU time used by the IMU for one second of samples at 1 kHz: data registers
+ * read one axis at a time, all registers of a sample in one transaction (both every 1 ms,
+ * blocking), FIFO burst with DMA every 10 ms. The bytes of the samples take the same bus
+ * time whatever the method, the burst saves the transactions and the CPU waiting for them.
+ */
+void ICM20602_TESTS_Benchmark_LogSTLINK() {
+	ICM20602_TESTS_Device test_device = { 1, 0, 300000, 1 };
+	uint8_t data[ICM20602_PACKET_SIZE];
+	ICM20602_TESTS_Check check;
+	uint64_t bus_ns[3];
+	uint64_t cpu_ns[3];
+	uint32_t transactions[3];
+	const char *names[3] = { "register per axis", "registers per sample", "FIFO burst" };
+
+	// Per axis: 7 reads of 2 bytes (accel X Y Z, temperature, gyro X Y Z) every 1 ms
+	ICM20602_TESTS_ModelReset(&test_device);
+	ICM20602_TESTS_ModelInit();
+	uint64_t bus_start = model.bus_ns;
+	uint64_t cpu_start = model.cpu_ns;
+	uint32_t start = model.transactions;
+	for (uint16_t i = 0; i < 1000; i++) {
+		for (uint8_t axis = 0; axis < 7; axis++) {
+			ICM20602_Read(ICM20602_REG_ACCEL_XOUT_H + 2 * axis, &data[2 * axis], 2);
+		}
+		ICM20602_TESTS_ModelAdvance(1000);
+	}
+	bus_ns[0] = model.bus_ns - bus_start;
+	cpu_ns[0] = model.cpu_ns - cpu_start;
+	transactions[0] = model.transactions - start;
+
+	// Per sample: the 14 data registers in one read every 1 ms
+	bus_start = model.bus_ns;
+	cpu_start = model.cpu_ns;
+	start = model.transactions;
+	for (uint16_t i = 0; i < 1000; i++) {
+		ICM20602_Read(ICM20602_REG_ACCEL_XOUT_H, data, ICM20602_PACKET_SIZE);
+		ICM20602_TESTS_ModelAdvance(1000);
+	}
+	bus_ns[1] = model.bus_ns - bus_start;
+	cpu_ns[1] = model.cpu_ns - cpu_start;
+	transactions[1] = model.transactions - start;
+
+	// FIFO: count and burst every 10 ms
+	ICM20602_TESTS_ModelReset(&test_device);
+	ICM20602_TESTS_ModelInit();
+	ICM20602_TESTS_CheckReset(&check, 0);
+	bus_start = model.bus_ns;
+	cpu_start = model.cpu_ns;
+	start = model.transactions;
+	ICM20602_TESTS_Run(&check, ICM20602_TESTS_ModelTimeUs() + 1000000, 0);
+	bus_ns[2] = model.bus_ns - bus_start;
+	cpu_ns[2] = model.cpu_ns - cpu_start;
+	transactions[2] = model.transactions - start;
+
+	for (uint8_t i = 0; i < 3; i++) {
+		printf("%-20s %5lu transactions, bus %6lu us/s, CPU %6lu us/s (%lu.%lu%%)\n", names[i], transactions[i],
+				(uint32_t)(bus_ns[i] / 1000), (uint32_t)(cpu_ns[i] / 1000), (uint32_t)(cpu_ns[i] / 10000000),
+				(uint32_t)(cpu_ns[i] / 1000000 % 10));
+	}
+	printf("FIFO: %lu samples\n", check.samples);
+	if (bus_ns[2] < bus_ns[1] && cpu_ns[2] * 10 < cpu_ns[1] && transactions[2] <= 2 * 101) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+}
+
+/**
+ * Initialize the real IMU and drain its FIFO every 10 ms for 1 s.
+ *
+ * @param hspi: SPI connected to the IMU (&hspi2).
+ */
+void ICM20602_TESTS_Read_LogSTLINK(SPI_HandleTypeDef *hspi) {
+	int32_t sum[3] = { 0 };
+	uint32_t count = 0;
+
+	int8_t status = ICM20602_Init(hspi, NULL);
+	printf("ICM20602 init %d\n", status);
+	if (status != 0) {
+		return;
+	}
+
+	uint32_t start_ms = HAL_GetTick();
+	while (HAL_GetTick() - start_ms < 1000) {
+		HAL_Delay(ICM20602_TESTS_DRAIN_MS);
+		if (ICM20602_StartRead(HAL_GetTick() * 1000) != 0) {
+			continue;
+		}
+		int16_t read;
+		while ((read = ICM20602_Collect(samples)) == -2) {
+		}
+		for (int16_t i = 0; i < read; i++) {
+			for (uint8_t axis = 0; axis < 3; axis++) {
+				sum[axis] += samples[i].accel[axis];
+			}
+		}
+		count += read;
+	}
+
+	for (uint8_t axis = 0; axis < 3 && count > 0; axis++) {
+		sum[axis] = sum[axis] / (int32_t)count * 1000 / ICM20602_ACCEL_LSB_PER_G; // Mean (mg)
+	}
+	printf("%lu samples, mean accel %ld %ld %ld mg\n", count, sum[0], sum[1], sum[2]);
+	ICM20602_TESTS_LogStats();
+}
+
+void ICM20602_TESTS_LogStats() {
+	const ICM20602_Stats *stats = ICM20602_GetStats();
+	printf("ICM20602 %lu samples in %lu reads, %lu overflows (%lu lost), %lu without DMA, %lu errors, "
+			"%lu resyncs, period %lu ns\n", stats->samples, stats->reads, stats->overflows, stats->lost,
+			stats->dma_fallbacks, stats->errors, stats->resyncs, stats->period_ns);
+}
@@ -1,26 +1,717 @@
 /*
  * L76LM33_tests.c
  *
+ * L76LM33_TESTS_Model_LogSTLINK replaces USART2 by a model of the module: it sends a RMC
+ * sentence (and a GGA once asked by PMTK314) every fix interval at its own baud rate (bytes
+ * are garbage when USART2 is at another baud rate) and understands PMTK314 (sentences),
+ * PMTK251 (baud rate), PMTK220 (fix interval) and PMTK886 (navigation mode) sent at its
+ * baud rate with a valid checksum, acknowledged with $PMTK001. Commands can be lost, answered "failed" or "unsupported", or acknowledged with
+ * a bad checksum. The bytes leave the module at its baud rate, a sentence starts after an
+ * output delay with jitter. With "moving", the module has a fix on a straight track (speed
+ * and course over ground) to measure the time of the fixes and the extrapolated position.
+ * Time is simulated, L76LM33_Init waits on it.
+ *
  *  Created on: Jul 30, 2024
  *      Author: mathi
  */
 
 #include "GAUL_Drivers/Tests/L76LM33_tests.h"
 
+#include "GAUL_Drivers/RFD900.h"
+#include "GAUL_System/PROFILER.h"
+
+#include "GAUL_Drivers/NMEA.h"
+#include "GAUL_System/Tests/TESTS.h"
+
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static L76LM33 L76_data;
 
+// Clock model converging on the earliest arrival (uniform jitter), not measured before
+#define L76LM33_TESTS_SETTLE_MS 2000
+
 extern uint8_t L76_NMEA_Buffer[];
+extern uint8_t L76_receivedByte;
+
+// Module model
+typedef struct {
+	uint8_t present;
+	uint32_t baud;            // Module UART
+	uint16_t period_ms;       // Fix interval
+	uint8_t accepts_baud;     // 0: ignores PMTK251
+	uint8_t accepts_rate;     // 0: PMTK220 unsupported
+	uint8_t drops;            // Next commands lost on the line (no acknowledge)
+	uint8_t fails;            // Next commands answered "failed"
+	uint16_t unsupported;     // Command answered "unsupported"
+	uint8_t corrupt_acks;     // Next acknowledges with a bad checksum
+	uint32_t next_ms;         // Next sentence
+	char ack[L76LM33_ACK_SIZE + 4]; // Acknowledge sent...
+	uint32_t ack_ms;          // ...at this time, 0: none
+	uint8_t navmode;          // PMTK886 applied
+	uint8_t gga;              // 1: GGA after the RMC (PMTK314)
+	uint8_t moving;           // 1: fix on a straight track, 0: no fix
+	double latitude;          // Track at model time 0
+	double longitude;
+	double altitude_m;
+	double speed_mps;
+	double course_deg;
+	double climb_mps;
+	uint32_t utc_start_ms;    // UTC at model time 0
+	uint16_t output_delay_ms; // Fix epoch to the first byte of the sentence...
+	uint16_t output_jitter_ms; // ...plus up to this
+	char sentence[224];       // Sentences sent...
+	uint32_t sentence_ms;     // ...at this time, 0: none
+	char out[256];            // Bytes leaving the module at its baud rate
+	uint16_t out_length;
+	uint16_t out_sent;
+	uint32_t out_credit;
+	uint16_t commands;        // Commands received with a valid checksum
+	uint16_t bad_commands;    // Commands garbled or with a bad checksum
+	uint16_t baud_commands;   // PMTK251 received
+} L76LM33_TESTS_Module;
+
+static UART_HandleTypeDef model_huart;
+static L76LM33_TESTS_Module module;
+static uint32_t model_ms;
+static uint32_t mcu_baud;     // USART2 baud rate
+static uint32_t model_rng = 1;
+
+// USART2 transmission in progress
+static uint8_t tx_data[L76LM33_COMMAND_SIZE];
+static uint16_t tx_size;
+static uint32_t tx_end_ms;
+static uint8_t tx_busy;
+
+// Commands ended (L76LM33_Done)
+static uint16_t done_commands[8];
+static int8_t done_results[8];
+static uint32_t done_ms[8];
+static uint8_t done_count;
+
+// Replies to the queries (L76LM33_SetReplyHandler)
+static char reply_last[100];
+static uint8_t reply_count;
+
+/**
+ * Frame "body" as a NMEA sentence: "$body*CS\r\n".
+ */
+static void L76LM33_TESTS_Frame(char *sentence, size_t size, const char *body, uint8_t corrupt) {
+	uint8_t checksum = 0;
+	for (const char *c = body; *c != '\0'; c++) {
+		checksum ^= (uint8_t)*c;
+	}
+	snprintf(sentence, size, "$%s*%02X\r\n", body, checksum ^ corrupt);
+}
+
+static uint32_t L76LM33_TESTS_Random() {
+	return TESTS_Random(&model_rng);
+}
+
+/**
+ * Module sends "sentence" after the bytes already queued.
+ */
+static void L76LM33_TESTS_Emit(const char *sentence) {
+	uint16_t length = strlen(sentence);
+	if (module.out_sent > 0) {
+		memmove(module.out, module.out + module.out_sent, module.out_length - module.out_sent);
+		module.out_length -= module.out_sent;
+		module.out_sent = 0;
+	}
+	if (module.out_length + length <= sizeof(module.out)) {
+		memcpy(module.out + module.out_length, sentence, length);
+		module.out_length += length;
+	}
+}
+
+/**
+ * Bytes sent by the module in 1 ms at its baud rate, received by USART2 (garbage at
+ * another baud rate).
+ */
+static void L76LM33_TESTS_Send() {
+	if (module.out_sent == module.out_length) {
+		module.out_credit = 0; // Line idle
+		return;
+	}
+	module.out_credit += module.baud; // 10 bits per byte, credit in bits/1000
+	while (module.out_credit >= 10000 && module.out_sent < module.out_length) {
+		module.out_credit -= 10000;
+		char c = module.out[module.out_sent++];
+		if (mcu_baud == module.baud) {
+			L76_receivedByte = (uint8_t)c;
+		} else {
+			L76_receivedByte = (uint8_t)L76LM33_TESTS_Random(); // Framing at the wrong baud rate
+		}
+		L76LM33_RxCallback(&model_huart);
+	}
+}
+
+/**
+ * True position of the module track at model time "time_ms".
+ */
+static void L76LM33_TESTS_Track(uint32_t time_ms, double *latitude, double *longitude) {
+	double distance_m = module.speed_mps * time_ms / 1000.0;
+	double course_rad = module.course_deg * M_PI / 180.0;
+	*latitude = module.latitude + distance_m * cos(course_rad) / L76LM33_EARTH_RADIUS_M * 180.0 / M_PI;
+	*longitude = module.longitude
+			+ distance_m * sin(course_rad) / (L76LM33_EARTH_RADIUS_M * cos(module.latitude * M_PI / 180.0)) * 180.0 / M_PI;
+}
+
+/**
+ * Distance between two positions (m), flat earth.
+ */
+static double L76LM33_TESTS_Distance(double latitude1, double longitude1, double latitude2, double longitude2) {
+	double north_m = (latitude2 - latitude1) * M_PI / 180.0 * L76LM33_EARTH_RADIUS_M;
+	double east_m = (longitude2 - longitude1) * M_PI / 180.0 * L76LM33_EARTH_RADIUS_M * cos(latitude1 * M_PI / 180.0);
+	return sqrt(north_m * north_m + east_m * east_m);
+}
+
+/**
+ * True altitude of the module track at model time "time_ms".
+ */
+static double L76LM33_TESTS_Altitude(uint32_t time_ms) {
+	return module.altitude_m + module.climb_mps * time_ms / 1000.0;
+}
+
+/**
+ * RMC (and GGA) of the fix epoch "epoch_ms", position of the track when moving.
+ */
+static void L76LM33_TESTS_Sentence(uint32_t epoch_ms) {
+	char body[100];
+	char gga[112] = "";
+	uint32_t time = (module.utc_start_ms + epoch_ms) % L76LM33_DAY_MS;
+	int length = snprintf(body, sizeof(body), "GNRMC,%02lu%02lu%02lu.%03lu,", time / 3600000, time / 60000 % 60,
+			time / 1000 % 60, time % 1000);
+
+	if (module.moving) {
+		double latitude, longitude;
+		L76LM33_TESTS_Track(epoch_ms, &latitude, &longitude);
+		double lat = fabs(latitude);
+		double lon = fabs(longitude);
+		char position[40];
+		snprintf(position, sizeof(position), "%02d%09.6f,%c,%03d%09.6f,%c", (int)lat, (lat - (int)lat) * 60.0,
+				latitude >= 0 ? 'N' : 'S', (int)lon, (lon - (int)lon) * 60.0, longitude >= 0 ? 'E' : 'W');
+		snprintf(body + length, sizeof(body) - length, "A,%s,%.3f,%.2f,181026,,,A,V", position,
+				module.speed_mps / L76LM33_KNOTS_TO_MPS, module.course_deg);
+		if (module.gga) {
+			char gga_body[100];
+			snprintf(gga_body, sizeof(gga_body), "GNGGA,%.10s,%s,1,10,0.80,%.1f,M,-32.0,M,,", body + 6, position,
+					L76LM33_TESTS_Altitude(epoch_ms));
+			L76LM33_TESTS_Frame(gga, sizeof(gga), gga_body, 0);
+		}
+	} else {
+		snprintf(body + length, sizeof(body) - length, "V,,,,,,,181026,,,N,V"); // No fix, still sent at the fix interval
+		if (module.gga) {
+			char gga_body[40];
+			snprintf(gga_body, sizeof(gga_body), "GNGGA,%.10s,,,,,0,0,,,M,,M,,", body + 6);
+			L76LM33_TESTS_Frame(gga, sizeof(gga), gga_body, 0);
+		}
+	}
+	L76LM33_TESTS_Frame(module.sentence, sizeof(module.sentence), body, 0);
+	strncat(module.sentence, gga, sizeof(module.sentence) - strlen(module.sentence) - 1);
+	module.sentence_ms = epoch_ms + module.output_delay_ms + L76LM33_TESTS_Random() % (module.output_jitter_ms + 1);
+}
+
+/**
+ * Command received by the module at the end of the transmission.
+ */
+static void L76LM33_TESTS_Receive() {
+	char command[L76LM33_COMMAND_SIZE + 1];
+	char body[L76LM33_ACK_SIZE];
+
+	if (!module.present) {
+		return;
+	}
+	if (mcu_baud != module.baud) {
+		module.bad_commands++; // Garbled at the module
+		return;
+	}
+	if (module.drops > 0) {
+		module.drops--; // Lost on the line
+		return;
+	}
+	memcpy(command, tx_data, tx_size);
+	command[tx_size] = '\0';
+	if (NMEA_ValidateChecksum(command) != 0 || strncmp(command, "$PMTK", 5) != 0) {
+		module.bad_commands++;
+		return;
+	}
+	module.commands++;
+
+	uint16_t number = strtoul(command + 5, NULL, 10);
+	uint32_t value = strtoul(command + 9, NULL, 10);
+	uint8_t flag = L76LM33_ACK_SUCCESS;
+	if (number == 251) {
+		module.baud_commands++;
+		if (module.accepts_baud) {
+			module.baud = value;
+		}
+		return; // No acknowledge, new baud rate
+	} else if (number == module.unsupported || (number == 220 && !module.accepts_rate)) {
+		flag = L76LM33_ACK_UNSUPPORTED;
+	} else if (module.fails > 0) {
+		module.fails--;
+		flag = L76LM33_ACK_FAILED;
+	} else if (number == 314) {
+		module.gga = command[15] == '1'; // GLL, RMC, VTG, GGA
+	} else if (number == 220) {
+		module.period_ms = value;
+	} else if (number == 886) {
+		module.navmode = value;
+	}
+
+	snprintf(body, sizeof(body), "PMTK001,%u,%u", number, flag);
+	L76LM33_TESTS_Frame(module.ack, sizeof(module.ack), body, module.corrupt_acks > 0);
+	if (module.corrupt_acks > 0) {
+		module.corrupt_acks--;
+	}
+	module.ack_ms = model_ms + 5;
+}
+
+static int8_t L76LM33_TESTS_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+	(void)huart;
+	if (tx_busy || size > sizeof(tx_data)) {
+		return -1; // Busy
+	}
+	memcpy(tx_data, data, size);
+	tx_size = size;
+	tx_end_ms = model_ms + (uint32_t)size * 10 * 1000 / mcu_baud + 1;
+	tx_busy = 1;
+	return 0;
+}
+
+static int8_t L76LM33_TESTS_SetBaud(UART_HandleTypeDef *huart, uint32_t baud) {
+	huart->Init.BaudRate = baud;
+	mcu_baud = baud;
+	tx_busy = 0; // Transmission aborted
+	return 0;
+}
+
+static uint32_t L76LM33_TESTS_Tick() {
+	return model_ms;
+}
+
+/**
+ * Advance the simulated time: end of transmission, acknowledges and sentences of the module.
+ */
+static void L76LM33_TESTS_Wait(uint32_t ms) {
+	for (uint32_t i = 0; i < ms; i++) {
+		model_ms++;
+		if (tx_busy && model_ms >= tx_end_ms) {
+			tx_busy = 0;
+			L76LM33_TESTS_Receive();
+			L76LM33_TxCallback(&model_huart);
+		}
+		if (module.ack_ms != 0 && model_ms >= module.ack_ms) {
+			module.ack_ms = 0;
+			L76LM33_TESTS_Emit(module.ack);
+		}
+		if (module.present && model_ms >= module.next_ms) {
+			L76LM33_TESTS_Sentence(module.next_ms);
+			module.next_ms += module.period_ms;
+		}
+		if (module.sentence_ms != 0 && model_ms >= module.sentence_ms) {
+			module.sentence_ms = 0;
+			L76LM33_TESTS_Emit(module.sentence);
+		}
+		L76LM33_TESTS_Send();
+	}
+}
+
+static void L76LM33_TESTS_Done(uint16_t command, int8_t result) {
+	if (done_count < sizeof(done_results)) {
+		done_commands[done_count] = command;
+		done_results[done_count] = result;
+		done_ms[done_count] = model_ms;
+		done_count++;
+	}
+}
+
+static void L76LM33_TESTS_Reply(const char *sentence) {
+	strncpy(reply_last, sentence, sizeof(reply_last) - 1);
+	reply_count++;
+}
+
+static const L76LM33_Port model_port = {
+	.transmit = L76LM33_TESTS_Transmit,
+	.set_baud = L76LM33_TESTS_SetBaud,
+	.tick = L76LM33_TESTS_Tick,
+	.wait = L76LM33_TESTS_Wait,
+};
 
-void L76LM33_TESTS_ReadSentence_LogUART(UART_HandleTypeDef *huart) {
+/**
+ * Power on the module model at "baud", USART2 at its reset baud rate, then run L76LM33_Init.
+ */
+static int8_t L76LM33_TESTS_Negotiate(uint8_t present, uint32_t baud, uint8_t accepts_baud, uint8_t accepts_rate,
+		uint8_t drops) {
+	module = (L76LM33_TESTS_Module) { 0 };
+	module.present = present;
+	module.baud = baud;
+	module.period_ms = 1000;
+	module.accepts_baud = accepts_baud;
+	module.accepts_rate = accepts_rate;
+	module.drops = drops;
+	module.next_ms = 300;
+	model_ms = 0;
+	tx_busy = 0;
+	model_huart.Init.BaudRate = L76LM33_BAUD_DEFAULT;
+	mcu_baud = L76LM33_BAUD_DEFAULT;
+
+	int8_t status = L76LM33_Init(&model_huart, &model_port);
+	const L76LM33_Link *link = L76LM33_GetLink();
+	printf("Init %d in %lu ms: %lu baud after %u probes, period %u ms (asked %u), %u commands, %u bad, %lu retries\n",
+			status, link->init_ms, link->baud, link->probes, link->period_ms, link->asked_ms, module.commands,
+			module.bad_commands, L76LM33_GetCommandStats()->retries);
+	return status;
+}
+
+/**
+ * Queue a PMTK886 and let the time run without L76LM33_Poll nor L76LM33_Read (main loop
+ * blocked, barometer calibration): the command progresses with the interrupts only, a
+ * timeout is seen at the next sentence (up to L76LM33_FIX_PERIOD_MS late).
+ *
+ * @return time from the command to its end, UINT32_MAX if not ended
+ */
+static uint32_t L76LM33_TESTS_NavMode(uint8_t mode, uint32_t run_ms) {
+	uint32_t start = model_ms;
+	done_count = 0;
+	if (L76LM33_SetNavMode(mode, L76LM33_TESTS_Done) != 0) {
+		return UINT32_MAX;
+	}
+	L76LM33_TESTS_Wait(run_ms);
+	uint32_t elapsed = done_count > 0 ? done_ms[0] - start : UINT32_MAX;
+	printf("PMTK886 result %d in %lu ms, %lu sent, %lu retries\n", done_count > 0 ? done_results[0] : 1, elapsed,
+			L76LM33_GetCommandStats()->sent, L76LM33_GetCommandStats()->retries);
+	return elapsed;
+}
+
+typedef struct {
+	uint32_t fixes;
+	int32_t clock_error_ms;    // Largest |fix_ms - epoch - output delay| after L76LM33_TESTS_SETTLE_MS
+	double extrapolated_m;     // Largest error of L76LM33_GetPosition at the query times
+	double extrapolated_mean_m;
+	double raw_m;              // Largest error of the last fix at the query times
+	double raw_mean_m;
+	int32_t step_error_ms;     // Largest |fix_ms step - period| (continuity, midnight)
+	uint32_t altitudes;        // GGA altitudes read
+	double altitude_m;         // Largest error of the GGA altitude at its time (altitude_ms)
+} L76LM33_TESTS_Flight;
+
+/**
+ * Module moving for "run_ms": L76LM33_Read every "read_ms" (GNSS task), the position asked
+ * every 10 ms (log and telemetry tasks) and compared to the track. The clock model maps
+ * the fix to its first byte, so the truth is taken output_delay_ms (constant, to measure
+ * once, L76LM33_OUTPUT_DELAY_MS) before.
+ */
+static void L76LM33_TESTS_Fly(uint32_t run_ms, uint16_t read_ms, L76LM33_TESTS_Flight *flight) {
+	L76LM33 data = { 0 };
+	L76LM33_Position position;
+	uint32_t queries = 0;
+	uint32_t last_fix_ms = 0;
+	uint32_t last_altitude_ms = 0;
+	uint32_t start = model_ms;
+
+	*flight = (L76LM33_TESTS_Flight) { 0 };
+	module.moving = 1;
+	for (uint32_t t = 0; t < run_ms; t += 10) {
+		L76LM33_TESTS_Wait(10);
+		if (t % read_ms == 0 && L76LM33_Read(&data) == 0 && data.fix) {
+			uint32_t epoch_ms = (data.utc_ms + L76LM33_DAY_MS - module.utc_start_ms % L76LM33_DAY_MS) % L76LM33_DAY_MS;
+			int32_t error_ms = (int32_t)(data.fix_ms - epoch_ms - module.output_delay_ms + L76LM33_OUTPUT_DELAY_MS);
+			if (model_ms - start > L76LM33_TESTS_SETTLE_MS && abs(error_ms) > flight->clock_error_ms) {
+				flight->clock_error_ms = abs(error_ms);
+			}
+			if (model_ms - start > L76LM33_TESTS_SETTLE_MS && last_fix_ms != 0 && data.fix_ms != last_fix_ms) {
+				int32_t step_ms = (int32_t)(data.fix_ms - last_fix_ms) % module.period_ms; // Fixes skipped between reads
+				step_ms = step_ms > module.period_ms / 2 ? step_ms - module.period_ms : step_ms;
+				if (abs(step_ms) > flight->step_error_ms) {
+					flight->step_error_ms = abs(step_ms);
+				}
+			}
+			last_fix_ms = data.fix_ms;
+			flight->fixes++;
+		}
+		if (model_ms - start > L76LM33_TESTS_SETTLE_MS && data.altitude_fix && data.altitude_ms != last_altitude_ms) {
+			last_altitude_ms = data.altitude_ms;
+			double truth = L76LM33_TESTS_Altitude(data.altitude_ms - module.output_delay_ms + L76LM33_OUTPUT_DELAY_MS);
+			flight->altitude_m = fmax(flight->altitude_m, fabs(data.altitude_m - truth));
+			flight->altitudes++;
+		}
+		if (flight->fixes == 0 || model_ms - start < L76LM33_TESTS_SETTLE_MS) {
+			continue;
+		}
+
+		double latitude, longitude;
+		L76LM33_TESTS_Track(model_ms - module.output_delay_ms + L76LM33_OUTPUT_DELAY_MS, &latitude, &longitude);
+		L76LM33_GetPosition(&data, model_ms, &position);
+		double extrapolated = L76LM33_TESTS_Distance(latitude, longitude, position.latitude, position.longitude);
+		double raw = L76LM33_TESTS_Distance(latitude, longitude, data.latitude, data.longitude);
+		flight->extrapolated_m = fmax(flight->extrapolated_m, extrapolated);
+		flight->raw_m = fmax(flight->raw_m, raw);
+		flight->extrapolated_mean_m += extrapolated;
+		flight->raw_mean_m += raw;
+		queries++;
+	}
+	if (queries > 0) {
+		flight->extrapolated_mean_m /= queries;
+		flight->raw_mean_m /= queries;
+	}
+	printf("%lu fixes, clock error %ld ms (delay max %u ms), position error %.2f m mean %.2f m max (last fix %.2f m"
+			" mean %.2f m max), step error %ld ms, %lu altitudes (error %.2f m max)\n", flight->fixes, flight->clock_error_ms,
+			L76LM33_GetClock()->max_delay_ms, flight->extrapolated_mean_m, flight->extrapolated_m, flight->raw_mean_m,
+			flight->raw_m, flight->step_error_ms, flight->altitudes, flight->altitude_m);
+}
+
+/**
+ * Module on a straight track at 60 m/s climbing at 25 m/s, sentences 40 ms after the epoch
+ * plus up to 25 ms.
+ */
+static void L76LM33_TESTS_Launch(uint32_t utc_start_ms) {
+	module.latitude = 48.4634;
+	module.longitude = -71.0562;
+	module.altitude_m = 160.0;
+	module.speed_mps = 60.0;
+	module.course_deg = 30.0;
+	module.climb_mps = 25.0;
+	module.output_delay_ms = 40;
+	module.output_jitter_ms = 25;
+	module.utc_start_ms = utc_start_ms;
+	model_rng = 1; // Same jitter whatever the bytes of the previous tests
+}
+
+void L76LM33_TESTS_Model_LogSTLINK() {
+	L76LM33_TESTS_Flight flight;
+	const L76LM33_Link *link = L76LM33_GetLink();
+	const L76LM33_CommandStats *stats = L76LM33_GetCommandStats();
+	L76LM33_CommandStats before;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: factory module at 9600 baud, 1 Hz, switched to 115200 baud and 10 Hz
+	if (L76LM33_TESTS_Negotiate(1, 9600, 1, 1, 0) == 0 && link->baud == L76LM33_BAUD_FAST && link->fast
+			&& link->rate_ok && module.baud == L76LM33_BAUD_FAST && module.period_ms == L76LM33_FIX_PERIOD_MS
+			&& link->probes == 1 && module.baud_commands == 1 && module.bad_commands == 0) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: module already at 115200 baud (MCU reset, module still powered), no PMTK251
+	if (L76LM33_TESTS_Negotiate(1, 115200, 1, 1, 0) == 0 && link->fast && link->rate_ok && link->probes == 2
+			&& module.baud_commands == 0 && mcu_baud == L76LM33_BAUD_FAST) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: module ignores PMTK251, USART2 back at 9600 baud, 5 Hz
+	if (L76LM33_TESTS_Negotiate(1, 9600, 0, 1, 0) == 0 && link->baud == 9600 && !link->fast && link->rate_ok
+			&& link->asked_ms == L76LM33_SLOW_PERIOD_MS && mcu_baud == 9600 && module.period_ms == L76LM33_SLOW_PERIOD_MS) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: PMTK220 unsupported, module still working at 1 Hz, reported by the measured period
+	if (L76LM33_TESTS_Negotiate(1, 9600, 1, 0, 0) == 0 && link->fast && !link->rate_ok && link->period_ms >= 900
+			&& link->period_ms <= 1100 && stats->rejected == 2) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: no module, error after probing every baud rate, USART2 back at 9600 baud
+	if (L76LM33_TESTS_Negotiate(0, 9600, 1, 1, 0) == -1 && link->baud == 0 && link->probes == 4
+			&& mcu_baud == L76LM33_BAUD_DEFAULT && link->init_ms <= 4 * L76LM33_PROBE_MS + 100) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: module left at another baud rate, found by probing, switched to 115200 baud
+	if (L76LM33_TESTS_Negotiate(1, 38400, 1, 1, 0) == 0 && link->fast && link->rate_ok && link->probes == 4) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Test 7: first command lost on the line (PMTK314), sent again after the timeout
+	if (L76LM33_TESTS_Negotiate(1, 9600, 1, 1, 1) == 0 && link->fast && link->rate_ok && stats->retries == 1
+			&& stats->timeouts == 0) {
+		printf("Test 7 passed\n");
+	} else {
+		printf("Test 7 failed\n");
+	}
+
+	// Test 8: aviation mode acknowledged, checksum added ('$' was missing in the old command)
+	before = *stats;
+	uint32_t elapsed = L76LM33_TESTS_NavMode(L76LM33_NAVMODE_AVIATION, 100);
+	if (elapsed < 20 && done_results[0] == 0 && done_commands[0] == 886 && module.navmode == L76LM33_NAVMODE_AVIATION
+			&& module.bad_commands == 0 && stats->sent == before.sent + 1 && stats->acknowledged == before.acknowledged + 1) {
+		printf("Test 8 passed\n");
+	} else {
+		printf("Test 8 failed\n");
+	}
+
+	// Test 9: two commands lost, acknowledged on the third transmission
+	before = *stats;
+	module.drops = 2;
+	elapsed = L76LM33_TESTS_NavMode(L76LM33_NAVMODE_NORMAL, 3000);
+	if (done_count == 1 && done_results[0] == 0 && module.navmode == L76LM33_NAVMODE_NORMAL
+			&& stats->retries == before.retries + 2 && elapsed >= 2 * L76LM33_ACK_TIMEOUT_MS
+			&& elapsed < 2 * (L76LM33_ACK_TIMEOUT_MS + L76LM33_FIX_PERIOD_MS) + 50) {
+		printf("Test 9 passed\n");
+	} else {
+		printf("Test 9 failed\n");
+	}
+
+	// Test 10: every command lost, timeout after the retries
+	before = *stats;
+	module.drops = UINT8_MAX;
+	elapsed = L76LM33_TESTS_NavMode(L76LM33_NAVMODE_AVIATION, 4000);
+	if (done_count == 1 && done_results[0] == -3 && stats->sent == before.sent + 1 + L76LM33_RETRIES
+			&& stats->timeouts == before.timeouts + 1 && elapsed < (1 + L76LM33_RETRIES) * (L76LM33_ACK_TIMEOUT_MS + L76LM33_FIX_PERIOD_MS) + 50) {
+		printf("Test 10 passed\n");
+	} else {
+		printf("Test 10 failed\n");
+	}
+	module.drops = 0;
+
+	// Test 11: "failed" acknowledge, sent again at once
+	before = *stats;
+	module.fails = 1;
+	elapsed = L76LM33_TESTS_NavMode(L76LM33_NAVMODE_AVIATION, 200);
+	if (done_count == 1 && done_results[0] == 0 && stats->retries == before.retries + 1 && elapsed < 50
+			&& module.navmode == L76LM33_NAVMODE_AVIATION) {
+		printf("Test 11 passed\n");
+	} else {
+		printf("Test 11 failed\n");
+	}
+
+	// Test 12: "unsupported" acknowledge, rejected without retry
+	before = *stats;
+	module.unsupported = 886;
+	elapsed = L76LM33_TESTS_NavMode(L76LM33_NAVMODE_BALLOON, 200);
+	if (done_count == 1 && done_results[0] == -1 && stats->sent == before.sent + 1 && stats->retries == before.retries
+			&& module.navmode == L76LM33_NAVMODE_AVIATION) {
+		printf("Test 12 passed\n");
+	} else {
+		printf("Test 12 failed\n");
+	}
+	module.unsupported = 0;
+
+	// Test 13: acknowledge with a bad checksum ignored, command sent again after the timeout
+	before = *stats;
+	module.corrupt_acks = 1;
+	elapsed = L76LM33_TESTS_NavMode(L76LM33_NAVMODE_NORMAL, 2000);
+	if (done_count == 1 && done_results[0] == 0 && stats->retries == before.retries + 1
+			&& elapsed >= L76LM33_ACK_TIMEOUT_MS) {
+		printf("Test 13 passed\n");
+	} else {
+		printf("Test 13 failed\n");
+	}
+
+	// Test 14: queue full, commands ended in order, framed command refused
+	before = *stats;
+	done_count = 0;
+	uint8_t queued = 0;
+	for (uint8_t mode = 0; mode <= L76LM33_NAVMODE_BALLOON; mode++) {
+		queued += L76LM33_SetNavMode(mode, L76LM33_TESTS_Done) == 0;
+	}
+	int8_t full = L76LM33_SetNavMode(L76LM33_NAVMODE_AVIATION, L76LM33_TESTS_Done);
+	int8_t framed = L76LM33_Command("$PMTK886,2*28", L76LM33_ACK_TIMEOUT_MS, 0, NULL);
+	L76LM33_TESTS_Wait(500);
+	if (queued == L76LM33_COMMAND_QUEUE && full == -2 && framed == -1 && done_count == L76LM33_COMMAND_QUEUE
+			&& done_results[0] == 0 && done_results[3] == 0 && done_ms[0] < done_ms[3]
+			&& module.navmode == L76LM33_NAVMODE_BALLOON && stats->full == before.full + 1
+			&& L76LM33_CommandsPending() == 0) {
+		printf("Test 14 passed\n");
+	} else {
+		printf("Test 14 failed\n");
+	}
+
+	// Test 15: 10 Hz at 115200 baud, read every 100 ms: fix time within 3 ms, position
+	// extrapolated to the query time within 1.5 m (float resolution ~0.4 m)
+	L76LM33_TESTS_Launch(12 * 3600000);
+	L76LM33_TESTS_Fly(10000, 100, &flight);
+	if (flight.fixes >= 90 && flight.clock_error_ms <= 3 && flight.extrapolated_m < 1.5
+			&& flight.raw_mean_m > 3 * flight.extrapolated_mean_m) {
+		printf("Test 15 passed\n");
+	} else {
+		printf("Test 15 failed\n");
+	}
+
+	// Test 16: across midnight, fix times continue without a jump
+	L76LM33_TESTS_Negotiate(1, 9600, 1, 1, 0);
+	L76LM33_TESTS_Launch(L76LM33_DAY_MS - 3000 - model_ms);
+	L76LM33_TESTS_Fly(6000, 100, &flight);
+	if (flight.fixes >= 50 && flight.step_error_ms <= 3 && flight.clock_error_ms <= 3
+			&& L76LM33_GetClock()->resyncs == 0) {
+		printf("Test 16 passed\n");
+	} else {
+		printf("Test 16 failed\n");
+	}
+
+	// Test 17: 9600 baud, 5 Hz, read every 200 ms: the sentence takes ~80 ms on the line,
+	// the fix time still comes from its first byte (~1 ms at 9600 baud, fewer arrivals to
+	// find the earliest)
+	L76LM33_TESTS_Negotiate(1, 9600, 0, 1, 0);
+	L76LM33_TESTS_Launch(15 * 3600000);
+	L76LM33_TESTS_Fly(10000, 200, &flight);
+	if (flight.fixes >= 45 && flight.clock_error_ms <= 5 && flight.extrapolated_m < 1.5
+			&& flight.raw_mean_m > 3 * flight.extrapolated_mean_m) {
+		printf("Test 17 passed\n");
+	} else {
+		printf("Test 17 failed\n");
+	}
+
+	// Test 18: GGA asked by L76LM33_Init, altitude of every fix read with the time of its
+	// fix (0.1 m resolution, 25 m/s climb: 3 ms clock error = 0.08 m)
+	if (module.gga && flight.altitudes >= 35 && flight.altitude_m <= 0.15) {
+		printf("Test 18 passed\n");
+	} else {
+		printf("Test 18 failed\n");
+	}
+
+	// Test 19: date of the fix (RMC), reply to a query given to the handler, not when its
+	// checksum is wrong
+	char reply[100];
+	L76LM33_SetReplyHandler(L76LM33_TESTS_Reply);
+	reply_count = 0;
+	L76LM33_TESTS_Frame(reply, sizeof(reply), "PMTK707,4,2389,172800,2389,259200,2389,172800,2389,194400", 0);
+	L76LM33_TESTS_Emit(reply);
+	L76LM33_TESTS_Wait(200);
+	L76LM33_Read(&L76_data);
+	L76LM33_TESTS_Frame(reply, sizeof(reply), "PMTK707,0,0,0,0,0,0,0,0,0", 1);
+	L76LM33_TESTS_Emit(reply);
+	L76LM33_TESTS_Wait(200);
+	L76LM33_Read(&L76_data);
+	L76LM33_SetReplyHandler(NULL);
+	if (reply_count == 1 && strncmp(reply_last, "$PMTK707,4,2389,172800,", 23) == 0 && L76_data.fix
+			&& L76_data.day == 18 && L76_data.month == 10 && L76_data.year == 2026) {
+		printf("Test 19 passed\n");
+	} else {
+		printf("Test 19 failed\n");
+	}
+
+	// Debug timer Low
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void L76LM33_TESTS_ReadSentence_LogUART() {
     // Debug timer High (to measure execution time with a digital analyzer)
     HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
 
 	if (L76LM33_ReadSentence() == 0) {
-		HAL_UART_Transmit(huart, L76_NMEA_Buffer, strnlen((char *)L76_NMEA_Buffer, 128), 100);
-		HAL_UART_Transmit(huart, (uint8_t *)"\n", 1, 100);
+		// Queued for the RFD900 (DMA), does not wait for the 50 ms transmission (line cut to a frame)
+		uint8_t frame[RFD900_FRAME_SIZE];
+		uint16_t size = strnlen((char *)L76_NMEA_Buffer, RFD900_FRAME_SIZE - 1);
+		memcpy(frame, L76_NMEA_Buffer, size);
+		frame[size] = '\n';
+		RFD900_Send(frame, size + 1);
 	}
 
     // Debug timer Low (to measure execution time with a digital analyzer)
@@ -40,16 +731,15 @@ void L76LM33_TESTS_ReadSentence_LogSTLINK() {
 }
 
 void L76LM33_TESTS_Read_LogSTLINK() {
-    // Debug timer High (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+    // Execution time measured with the cycle counter (see PROFILER_Dump)
+    PROFILER_BEGIN(PROFILER_ZONE_L76LM33_READ);
+    int8_t status = L76LM33_Read(&L76_data);
+    PROFILER_END(PROFILER_ZONE_L76LM33_READ);
 
-	if (L76LM33_Read(&L76_data) == 0) {
+	if (status == 0) {
 		printf("%s\n", L76_NMEA_Buffer);
 	    L76LM33_TESTS_LogStructure(&L76_data);
 	}
-
-    // Debug timer Low (to measure execution time with a digital analyzer)
-    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
 }
 
 void L76LM33_TESTS_LogStructure(L76LM33 *L76_data) {
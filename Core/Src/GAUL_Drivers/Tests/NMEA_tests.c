@@ -205,13 +205,161 @@ void NMEA_TESTS_ParseRMC_LogSTLINK() {
     	printf("Test 8 failed\n");
     }
 
+    printf("\n");
+
+    // Test 9
+    strncpy(sentence, "$GNRMC,080608.000,A,3029.461489,N,11430.072002,E,97.20,,210423,,,D,V*09", 120); // Empty course
+    printf("%s\n", sentence);
+    if (NMEA_ParseRMC(sentence, &gps_data) == 0
+    		&& fabs(gps_data.speed_knots - 97.2) < 0.001
+			&& gps_data.course_deg == 0
+			&& fabs(gps_data.longitude - 114.501200) < 0.00001) { // Float resolution ~8e-6 deg at 114 deg
+    	strncpy(sentence, "$GNRMC,080608.000,A,3029.461489,N,11430.072002,E,1.50,148.41,210423,,,D,V*09", 120);
+    	if (NMEA_ParseRMC(sentence, &gps_data) == 0
+    			&& fabs(gps_data.speed_knots - 1.5) < 0.001
+				&& fabs(gps_data.course_deg - 148.41) < 0.001) {
+    		printf("Test 9 passed\n");
+    	} else {
+    		printf("Test 9 failed\n");
+    	}
+    } else {
+    	printf("Test 9 failed\n");
+    }
+
+    printf("\n");
+
+    // Test 10: latitude and longitude in 1e-7 degrees, exact (no float rounding)
+    strncpy(sentence, "$GNRMC,124631,A,3159.99994,S,07100.000000,W,0.00,34.91,210423,,,D,V*09", 120);
+    printf("%s\n", sentence);
+    int8_t parsed = NMEA_ParseRMC(sentence, &gps_data);
+    printf("Lat: %ld, Lon: %ld (1e-7 deg)\n", (long)gps_data.latitude_e7, (long)gps_data.longitude_e7);
+    if (parsed == 0 && gps_data.latitude_e7 == -319999990 && gps_data.longitude_e7 == -710000000) {
+    	strncpy(sentence, "$GNRMC,080608.000,A,3029.461489,N,11430.072002,E,0.00,148.41,210423,,,D,V*09", 120);
+    	parsed = NMEA_ParseRMC(sentence, &gps_data);
+    	printf("Lat: %ld, Lon: %ld (1e-7 deg)\n", (long)gps_data.latitude_e7, (long)gps_data.longitude_e7);
+    	if (parsed == 0 && gps_data.latitude_e7 == 304910248 && gps_data.longitude_e7 == 1145012000) {
+    		printf("Test 10 passed\n");
+    	} else {
+    		printf("Test 10 failed\n");
+    	}
+    } else {
+    	printf("Test 10 failed\n");
+    }
+
+    printf("\n");
+
+    // Test 11: date, empty when there's no fix or no field, error when malformed
+    strncpy(sentence, "$GNRMC,235959.900,A,3029.461489,N,11430.072002,E,0.00,148.41,290224,,,D,V*09", 120);
+    printf("%s\n", sentence);
+    parsed = NMEA_ParseRMC(sentence, &gps_data);
+    printf("Date: %02u/%02u/%u\n", gps_data.date.day, gps_data.date.month, gps_data.date.year);
+    if (parsed == 0 && gps_data.date.day == 29 && gps_data.date.month == 2 && gps_data.date.year == 2024
+    		&& NMEA_ParseRMC("$GNRMC,185609.020,V,,,,,,,,,,,V*09", &gps_data) == 0 && gps_data.date.day == 0
+			&& NMEA_ParseRMC("$GNRMC,124631,A,3159.99994,N,07100.0000,W,0.00,34.91,,,,D,V*09", &gps_data) == 0
+			&& gps_data.date.day == 0
+			&& NMEA_ParseRMC("$GNRMC,124631,A,3159.99994,N,07100.0000,W,0.00,34.91,2104,,,D,V*09", &gps_data) != 0
+			&& NMEA_ParseRMC("$GNRMC,124631,A,3159.99994,N,07100.0000,W,0.00,34.91,211323,,,D,V*09", &gps_data) != 0) {
+    	printf("Test 11 passed\n");
+    } else {
+    	printf("Test 11 failed\n");
+    }
+
+    // Debug timer Low (to measure execution time with a digital analyzer)
+    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void NMEA_TESTS_ParseGGA_LogSTLINK() {
+    // Debug timer High (to measure execution time with a digital analyzer)
+    HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+    char sentence[120];
+
+    // Test 1
+    strncpy(sentence, "$GNGGA,080608.000,3029.461489,N,11430.072002,E,1,12,0.87,23.6,M,-14.2,M,,*6B", 120);
+    printf("%s\n", sentence);
+    gps_data.speed_knots = 97.2f;
+    int8_t parsed = NMEA_ParseGGA(sentence, &gps_data);
+
+    NMEA_TESTS_LogStructure(&gps_data);
+
+    if (parsed == 0
+    		&& NMEA_ValidateGGA(sentence) == 0
+			&& NMEA_ValidateRMC(sentence) == -1
+			&& gps_data.time.hours == 8
+    		&& gps_data.time.minutes == 6
+			&& fabs(gps_data.time.seconds - 8.0) < 0.001
+			&& gps_data.fix == 1
+			&& gps_data.latitude_e7 == 304910248
+			&& gps_data.longitude_e7 == 1145012000
+			&& gps_data.satellites == 12
+			&& fabs(gps_data.altitude_m - 23.6) < 0.001
+			&& fabs(gps_data.speed_knots - 97.2) < 0.001) { // Speed from the RMC kept
+    	printf("Test 1 passed\n");
+    } else {
+    	printf("Test 1 failed\n");
+    }
+
+    printf("\n");
+
+    // Test 2: no fix, empty position
+    strncpy(sentence, "$GNGGA,185609.020,,,,,0,0,,,M,,M,,*57", 120);
+    printf("%s\n", sentence);
+    parsed = NMEA_ParseGGA(sentence, &gps_data);
+
+    NMEA_TESTS_LogStructure(&gps_data);
+
+    if (parsed == 0
+    		&& gps_data.time.hours == 18
+			&& gps_data.fix == 0
+			&& gps_data.latitude_e7 == 0
+			&& gps_data.altitude_m == 0) {
+    	printf("Test 2 passed\n");
+    } else {
+    	printf("Test 2 failed\n");
+    }
+
+    printf("\n");
+
+    // Test 3: southern and western hemisphere, negative altitude
+    strncpy(sentence, "$GNGGA,124631,3159.9994,S,07100.0000,W,2,7,1.5,-12.3,M,,M,,*00", 120);
+    printf("%s\n", sentence);
+    parsed = NMEA_ParseGGA(sentence, &gps_data);
+
+    NMEA_TESTS_LogStructure(&gps_data);
+
+    if (parsed == 0
+    		&& gps_data.fix == 1
+			&& gps_data.latitude_e7 == -319999900
+			&& gps_data.longitude_e7 == -710000000
+			&& gps_data.satellites == 7
+			&& fabs(gps_data.altitude_m - -12.3) < 0.001) {
+    	printf("Test 3 passed\n");
+    } else {
+    	printf("Test 3 failed\n");
+    }
+
+    printf("\n");
+
+    // Test 4: errors in the indicator, the quality and a fix without altitude
+    if (NMEA_ParseGGA("$GNGGA,124631,3159.9994,T,07100.0000,W,1,7,1.5,10.0,M,,M,,*00", &gps_data) != 0
+    		&& NMEA_ParseGGA("$GNGGA,124631,3159.9994,N,07100.0000,W,X,7,1.5,10.0,M,,M,,*00", &gps_data) != 0
+			&& NMEA_ParseGGA("$GNGGA,124631,3159.9994,N,07100.0000,W,1,7,1.5,,M,,M,,*00", &gps_data) != 0
+			&& NMEA_ParseGGA("$GNGGA,12463,3159.9994,N,07100.0000,W,1,7,1.5,10.0,M,,M,,*00", &gps_data) != 0) {
+    	printf("Test 4 passed\n");
+    } else {
+    	printf("Test 4 failed\n");
+    }
+
     // Debug timer Low (to measure execution time with a digital analyzer)
     HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
 }
 
 void NMEA_TESTS_LogStructure(GPS_Data *gps_data) {
 	printf("Time: %02d:%02d:%06.3f\n", gps_data->time.hours, gps_data->time.minutes, gps_data->time.seconds);
+	printf("Date: %02u/%02u/%u\n", gps_data->date.day, gps_data->date.month, gps_data->date.year);
 	printf("Fix:  %s\n", gps_data->fix == 1 ? "Yes" : "No");
 	printf("Lat:  %f\n", gps_data->latitude);
 	printf("Lon:  %f\n", gps_data->longitude);
+	printf("SOG:  %.2f kn, COG: %.2f deg\n", gps_data->speed_knots, gps_data->course_deg);
+	printf("Alt:  %.1f m, %u satellites\n", gps_data->altitude_m, gps_data->satellites);
 }
@@ -0,0 +1,251 @@
+/*
+ * RFD900_tests.c
+ *
+ * RFD900_TESTS_Model_LogSTLINK replaces the UART and DMA by a model: a transmission takes
+ * 10 bits per byte at RFD900_TESTS_BAUD of simulated time, then the model calls
+ * RFD900_TxCallback like the DMA interrupt. Received bytes are checked for order and
+ * content, and the line usage gives the throughput. The DMA channel can be taken by the
+ * SPI bus ("channel_busy"), the model then refuses to start a frame.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/Tests/RFD900_tests.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define RFD900_TESTS_MAX_FRAMES 512
+
+static UART_HandleTypeDef model_huart;
+
+// UART + DMA model
+static uint32_t sim_us;
+static uint8_t line_busy;
+static uint32_t line_done_us;
+static uint32_t line_busy_us;    // Total time spent sending
+static uint8_t received[RFD900_TESTS_MAX_FRAMES]; // First byte (sequence number) of each frame
+static uint16_t received_count;
+static uint8_t received_corrupt; // 1: a frame did not match its sequence pattern
+static uint8_t channel_busy;     // 1: DMA channel used by SPI2_RX
+
+static uint32_t RFD900_TESTS_FrameTime(uint16_t size) {
+	return (uint32_t)size * 10 * 1000000 / RFD900_TESTS_BAUD;
+}
+
+static const uint8_t *model_data; // Buffer being sent
+static uint16_t model_size;
+
+static int8_t RFD900_TESTS_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+	if (line_busy) {
+		return -1; // Busy, the driver must not start a frame before the previous one is done
+	}
+	if (channel_busy) {
+		return -2; // DMA channel busy, RFD900_Resume at its release
+	}
+	// The buffer is read when the transmission ends, so a buffer overwritten while it is sent is detected
+	model_data = data;
+	model_size = size;
+	line_busy = 1;
+	line_done_us = sim_us + RFD900_TESTS_FrameTime(size);
+	line_busy_us += RFD900_TESTS_FrameTime(size);
+	return 0;
+}
+
+/**
+ * Advance the simulated time, completing the transmission in progress.
+ */
+static void RFD900_TESTS_Advance(uint32_t time_us) {
+	uint32_t end_us = sim_us + time_us;
+	while (line_busy && line_done_us <= end_us) {
+		sim_us = line_done_us;
+		line_busy = 0;
+		// Check the frame when the last byte leaves the DMA
+		if (received_count < RFD900_TESTS_MAX_FRAMES) {
+			received[received_count++] = model_data[0];
+		}
+		for (uint16_t i = 1; i < model_size; i++) {
+			if (model_data[i] != (uint8_t)(model_data[0] + i)) {
+				received_corrupt = 1;
+			}
+		}
+		RFD900_TxCallback(&model_huart);
+	}
+	sim_us = end_us;
+}
+
+static void RFD900_TESTS_Setup(uint8_t policy) {
+	sim_us = 0;
+	line_busy = 0;
+	line_busy_us = 0;
+	received_count = 0;
+	received_corrupt = 0;
+	channel_busy = 0;
+	RFD900_Init(&model_huart, policy, RFD900_TESTS_Transmit);
+}
+
+/**
+ * Queue a frame of "size" bytes: sequence number then sequence + i.
+ */
+static int8_t RFD900_TESTS_SendFrame(uint8_t sequence, uint16_t size) {
+	uint8_t frame[RFD900_FRAME_SIZE];
+	for (uint16_t i = 0; i < size; i++) {
+		frame[i] = sequence + i;
+	}
+	return RFD900_Send(frame, size);
+}
+
+void RFD900_TESTS_Model_LogSTLINK() {
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: frames of different sizes queued at once are received in order and intact,
+	// RFD900_Send returns before the frame is sent
+	RFD900_TESTS_Setup(RFD900_DROP_NEWEST);
+	uint8_t status = 0;
+	for (uint8_t i = 0; i < 5; i++) {
+		status |= RFD900_TESTS_SendFrame(i, 8 + 8 * i);
+	}
+	uint8_t immediate = RFD900_Busy() && RFD900_Pending() == 4;
+	RFD900_TESTS_Advance(1000000);
+	uint8_t ordered = received_count == 5;
+	for (uint8_t i = 0; i < received_count; i++) {
+		ordered &= received[i] == i;
+	}
+	if (status == 0 && immediate && ordered && !received_corrupt && RFD900_GetStats()->sent_bytes == 120
+			&& !RFD900_Busy()) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: drop newest, 1 frame sent + 8 waiting, the next 2 are refused
+	RFD900_TESTS_Setup(RFD900_DROP_NEWEST);
+	int8_t refused = 0;
+	for (uint8_t i = 0; i < 11; i++) {
+		if (RFD900_TESTS_SendFrame(i, 36) == -2) {
+			refused++;
+		}
+	}
+	RFD900_TESTS_Advance(1000000);
+	ordered = received_count == 9;
+	for (uint8_t i = 0; i < received_count; i++) {
+		ordered &= received[i] == i;
+	}
+	if (refused == 2 && ordered && !received_corrupt && RFD900_GetStats()->dropped_newest == 2
+			&& RFD900_GetStats()->max_pending == RFD900_QUEUE_SIZE) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: drop oldest, frame 0 is being sent and is kept, 1 and 2 are replaced
+	RFD900_TESTS_Setup(RFD900_DROP_OLDEST);
+	status = 0;
+	for (uint8_t i = 0; i < 11; i++) {
+		status |= RFD900_TESTS_SendFrame(i, 36);
+	}
+	RFD900_TESTS_Advance(1000000);
+	ordered = received_count == 9 && received[0] == 0;
+	for (uint8_t i = 1; i < received_count; i++) {
+		ordered &= received[i] == i + 2;
+	}
+	if (status == 0 && ordered && !received_corrupt && RFD900_GetStats()->dropped_oldest == 2) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: 36 bytes every 40 ms for 10 s (37.5 ms per frame at 9600 baud), nothing dropped
+	RFD900_TESTS_Setup(RFD900_DROP_OLDEST);
+	for (uint16_t i = 0; i < 250; i++) {
+		RFD900_TESTS_SendFrame(i, 36);
+		RFD900_TESTS_Advance(40000);
+	}
+	uint32_t usage = line_busy_us / (sim_us / 1000); // permille
+	printf("Line usage %lu permille, %lu frames sent, max %u waiting\n", usage, RFD900_GetStats()->sent,
+			RFD900_GetStats()->max_pending);
+	if (RFD900_GetStats()->sent == 250 && RFD900_GetStats()->dropped_oldest == 0 && RFD900_GetStats()->max_pending == 1
+			&& usage >= 930 && usage <= 940 && !received_corrupt) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: 36 bytes every 20 ms (twice the line capacity), frames are sent back to back,
+	// the line never waits and the latest frames are kept
+	RFD900_TESTS_Setup(RFD900_DROP_OLDEST);
+	for (uint16_t i = 0; i < 500; i++) {
+		RFD900_TESTS_SendFrame(i, 36);
+		RFD900_TESTS_Advance(20000);
+	}
+	usage = line_busy_us / (sim_us / 1000);
+	const RFD900_Stats *stats = RFD900_GetStats();
+	printf("Line usage %lu permille, %lu frames sent, %lu dropped\n", usage, stats->sent, stats->dropped_oldest);
+	if (usage >= 995 && stats->sent + stats->dropped_oldest + RFD900_Pending() + RFD900_Busy() == 500
+			&& !received_corrupt) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: the DMA channel is used by the SPI bus, the frames wait in the queue (nothing
+	// lost, no error) and are sent in order once the channel is released
+	RFD900_TESTS_Setup(RFD900_DROP_NEWEST);
+	channel_busy = 1;
+	status = 0;
+	for (uint8_t i = 0; i < 3; i++) {
+		status |= RFD900_TESTS_SendFrame(i, 36);
+	}
+	RFD900_TESTS_Advance(100000);
+	uint8_t waited = received_count == 0 && !RFD900_Busy() && RFD900_Pending() == 3;
+	channel_busy = 0;
+	RFD900_Resume();
+	RFD900_TESTS_Advance(1000000);
+	ordered = received_count == 3;
+	for (uint8_t i = 0; i < received_count; i++) {
+		ordered &= received[i] == i;
+	}
+	stats = RFD900_GetStats();
+	if (status == 0 && waited && ordered && !received_corrupt && stats->errors == 0 && stats->channel_waits == 3
+			&& RFD900_Pending() == 0) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+/**
+ * Queue 4 lines on the real UART and measure the time spent in RFD900_Send.
+ *
+ * @param huart: UART connected to the RFD900 (&huart1).
+ */
+void RFD900_TESTS_Send_LogSTLINK(UART_HandleTypeDef *huart) {
+	char line[40];
+
+	RFD900_Init(huart, RFD900_DROP_NEWEST, NULL);
+
+	uint32_t start = DWT->CYCCNT;
+	for (uint8_t i = 0; i < 4; i++) {
+		int size = snprintf(line, sizeof(line), "RFD900 frame %u\r\n", i);
+		RFD900_Send((uint8_t *)line, size);
+	}
+	uint32_t cycles = DWT->CYCCNT - start;
+
+	uint32_t start_ms = HAL_GetTick();
+	while (RFD900_Busy() && HAL_GetTick() - start_ms < 1000) {
+	}
+	printf("4 frames queued in %lu cycles, sent in %lu ms\n", cycles, HAL_GetTick() - start_ms);
+	RFD900_TESTS_LogStats();
+}
+
+void RFD900_TESTS_LogStats() {
+	const RFD900_Stats *stats = RFD900_GetStats();
+	printf("Queued %lu, sent %lu (%lu bytes), dropped %lu newest %lu oldest, %lu errors, %lu channel waits, "
+			"max %u waiting\n", stats->queued, stats->sent, stats->sent_bytes, stats->dropped_newest,
+			stats->dropped_oldest, stats->errors, stats->channel_waits, stats->max_pending);
+}
@@ -0,0 +1,555 @@
+/*
+ * SD_tests.c
+ *
+ * SD_TESTS_Model_LogSTLINK replaces the SPI bus by a model of an SD card in SPI mode: the
+ * model decodes the commands byte by byte (CMD0, CMD8, ACMD41, CMD58, CMD16, CMD17, CMD24,
+ * CMD25, ACMD23), answers with the R1/R3/R7 responses, data tokens and data responses, and
+ * holds MISO low during the programming time of a block. Every exchanged byte takes
+ * 8 clocks of simulated time, a block write completes when the simulated time reaches the
+ * end of its DMA (SD_TESTS_ModelAdvance receives the trailer, deselects the card and calls
+ * SD_TxCallback like the SPI bus).
+ *
+ * The model keeps the header of SD_TESTS_MODEL_BLOCKS blocks and the whole content of the
+ * first SD_TESTS_MODEL_FULL_BLOCKS blocks. It checks the log blocks (SDLOG.h) it receives:
+ * consecutive sequence numbers and a sum of the record bytes.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/Tests/SD_tests.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MODEL_MODE_COMMAND    0
+#define MODEL_MODE_WAIT_TOKEN 1 // CMD24 or CMD25, waiting for a start token
+#define MODEL_MODE_DATA       2 // Receiving a block (512 bytes and CRC)
+#define MODEL_MODE_READ       3 // Sending a block (token, 512 bytes and CRC)
+
+#define MODEL_LOG_MAGIC 0x474F4C47 // SDLOG_MAGIC
+
+static SPI_HandleTypeDef model_hspi;
+static SD_TESTS_Card card;
+static SD_TESTS_ModelStats model;
+
+static uint8_t model_full[SD_TESTS_MODEL_FULL_BLOCKS][SD_BLOCK_SIZE];
+static uint8_t model_headers[SD_TESTS_MODEL_BLOCKS][16];
+
+// Bus
+static uint64_t sim_ns;
+static uint32_t byte_ns;
+static uint8_t selected;
+static uint8_t started;          // A command was received
+static uint32_t exchanges;
+static uint8_t dma_busy;
+static uint64_t dma_done_ns;
+static uint8_t *dma_trailer;     // Received at the end of the DMA
+static uint8_t dma_trailer_size;
+
+// Card state
+static uint8_t idle_state;
+static uint8_t app_command;
+static uint8_t init_left;
+static uint8_t mode;
+static uint8_t command[6];
+static uint8_t command_count;
+static uint8_t out[8];           // Response being sent
+static uint8_t out_count;
+static uint8_t out_position;
+static uint64_t busy_until_ns;
+static uint8_t multi;            // CMD25 open
+static uint32_t multi_first;     // First block of the CMD25
+static uint32_t block;           // Block being read or written
+static uint16_t position;        // Byte of the block being read or written
+static uint8_t header[16];       // Header of the block being written
+static uint32_t block_sum;
+static uint32_t programmed;      // Blocks programmed (long busy times)
+
+static uint32_t SD_TESTS_Get32(const uint8_t *p) {
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void SD_TESTS_Respond(uint8_t r1, const uint8_t extra[], uint8_t size) {
+	out[0] = 0xFF; // NCR
+	out[1] = r1;
+	for (uint8_t i = 0; i < size; i++) {
+		out[2 + i] = extra[i];
+	}
+	out_count = 2 + size;
+	out_position = 0;
+}
+
+static void SD_TESTS_StartBusy(uint32_t busy_us) {
+	busy_until_ns = sim_ns + (uint64_t)busy_us * 1000;
+	model.busy_us += busy_us;
+}
+
+/**
+ * @retval 1 address converted to a block number
+ */
+static uint8_t SD_TESTS_Block(uint32_t argument, uint32_t *number) {
+	if (card.sdhc) {
+		*number = argument;
+		return 1;
+	}
+	*number = argument / SD_BLOCK_SIZE;
+	return argument % SD_BLOCK_SIZE == 0;
+}
+
+static void SD_TESTS_Execute() {
+	uint8_t index = command[0] & 0x3F;
+	uint32_t argument = (uint32_t)command[1] << 24 | (uint32_t)command[2] << 16 | (uint32_t)command[3] << 8
+			| command[4];
+	uint8_t r1 = idle_state ? SD_R1_IDLE : 0;
+	uint8_t extra[4];
+	started = 1;
+	model.commands++;
+
+	if (app_command) {
+		app_command = 0;
+		if (index == SD_ACMD41) {
+			if (init_left > 0) {
+				init_left--;
+			} else {
+				idle_state = 0;
+			}
+			SD_TESTS_Respond(idle_state ? SD_R1_IDLE : 0, NULL, 0);
+		} else if (index == SD_ACMD23) {
+			model.pre_erase = argument;
+			SD_TESTS_Respond(r1, NULL, 0);
+		} else {
+			SD_TESTS_Respond(r1 | SD_R1_ILLEGAL_COMMAND, NULL, 0);
+		}
+		return;
+	}
+
+	switch (index) {
+	case SD_CMD0:
+		idle_state = 1;
+		multi = 0;
+		SD_TESTS_Respond(command[5] == 0x95 ? SD_R1_IDLE : SD_R1_IDLE | 0x08, NULL, 0);
+		break;
+	case SD_CMD8:
+		extra[0] = 0x00;
+		extra[1] = 0x00;
+		extra[2] = (argument >> 8) & 0x0F;
+		extra[3] = argument;
+		SD_TESTS_Respond(command[5] == 0x87 ? r1 : r1 | 0x08, extra, 4);
+		break;
+	case SD_CMD55:
+		app_command = 1;
+		SD_TESTS_Respond(r1, NULL, 0);
+		break;
+	case SD_CMD58:
+		extra[0] = 0x80 | (card.sdhc && !idle_state ? 0x40 : 0); // Powered up, CCS
+		extra[1] = 0xFF;
+		extra[2] = 0x80;
+		extra[3] = 0x00;
+		SD_TESTS_Respond(r1, extra, 4);
+		break;
+	case SD_CMD16:
+		SD_TESTS_Respond(argument == SD_BLOCK_SIZE ? r1 : r1 | 0x40, NULL, 0);
+		break;
+	case SD_CMD17:
+	case SD_CMD24:
+	case SD_CMD25:
+		if (idle_state) {
+			SD_TESTS_Respond(r1 | SD_R1_ILLEGAL_COMMAND, NULL, 0);
+		} else if (!SD_TESTS_Block(argument, &block)) {
+			SD_TESTS_Respond(0x20, NULL, 0); // Address error
+		} else {
+			SD_TESTS_Respond(0, NULL, 0);
+			position = 0;
+			if (index == SD_CMD17) {
+				model.reads++;
+				mode = MODEL_MODE_READ;
+			} else {
+				multi = index == SD_CMD25;
+				multi_first = block;
+				mode = MODEL_MODE_WAIT_TOKEN;
+			}
+		}
+		break;
+	default:
+		SD_TESTS_Respond(r1 | SD_R1_ILLEGAL_COMMAND, NULL, 0);
+		break;
+	}
+}
+
+/**
+ * Byte of a block written (data then CRC).
+ */
+static void SD_TESTS_DataByte(uint8_t byte) {
+	if (position < SD_BLOCK_SIZE) {
+		if (block < SD_TESTS_MODEL_FULL_BLOCKS) {
+			model_full[block][position] = byte;
+		}
+		if (position < 16) {
+			header[position] = byte;
+			if (block < SD_TESTS_MODEL_BLOCKS) {
+				model_headers[block][position] = byte;
+			}
+		} else if (SD_TESTS_Get32(header) == MODEL_LOG_MAGIC
+				&& position < 16 + (uint16_t)(header[10] | header[11] << 8)) {
+			block_sum += byte;
+		}
+	}
+	position++;
+	if (position < SD_BLOCK_SIZE + 2) {
+		return;
+	}
+
+	// Block complete: data response, then programming
+	model.blocks++;
+	if (block >= SD_TESTS_MODEL_BLOCKS) {
+		model.out_of_order++;
+	}
+	if (SD_TESTS_Get32(header) == MODEL_LOG_MAGIC) {
+		model.log_blocks++;
+		if (!multi || SD_TESTS_Get32(&header[4]) != block - multi_first) {
+			model.bad_headers++;
+		}
+		model.payload_sum += block_sum;
+	}
+	block_sum = 0;
+
+	out[0] = 0xE5; // Data accepted
+	out_count = 1;
+	out_position = 0;
+	programmed++;
+	if (card.slow_every > 0 && programmed % card.slow_every == 0) {
+		SD_TESTS_StartBusy(card.slow_busy_us);
+	} else {
+		SD_TESTS_StartBusy(card.busy_us);
+	}
+	busy_until_ns += byte_ns; // After the data response
+
+	if (multi) {
+		block++;
+		position = 0;
+		mode = MODEL_MODE_WAIT_TOKEN;
+	} else {
+		mode = MODEL_MODE_COMMAND;
+	}
+}
+
+static uint8_t SD_TESTS_ReadByte() {
+	uint16_t i = position++;
+	if (i == 0) {
+		return SD_TOKEN_START_BLOCK;
+	}
+	i--;
+	if (i >= SD_BLOCK_SIZE) {
+		if (i == SD_BLOCK_SIZE + 1) {
+			mode = MODEL_MODE_COMMAND;
+		}
+		return 0xFF; // CRC
+	}
+	if (block < SD_TESTS_MODEL_FULL_BLOCKS) {
+		return model_full[block][i];
+	}
+	if (block < SD_TESTS_MODEL_BLOCKS && i < 16) {
+		return model_headers[block][i];
+	}
+	return 0x00; // Erased
+}
+
+static uint8_t SD_TESTS_Exchange(uint8_t byte) {
+	exchanges++;
+	sim_ns += byte_ns;
+	if (dma_busy) {
+		model.conflicts++;
+	}
+	if (!card.present) {
+		return 0xFF;
+	}
+	if (!selected) {
+		if (!started) {
+			model.init_clocks += 8;
+		}
+		return 0xFF;
+	}
+	model.bus_ns += byte_ns;
+
+	if (out_position < out_count) {
+		return out[out_position++];
+	}
+	if (sim_ns < busy_until_ns) {
+		return 0x00; // Busy
+	}
+
+	switch (mode) {
+	case MODEL_MODE_READ:
+		return SD_TESTS_ReadByte();
+
+	case MODEL_MODE_DATA:
+		SD_TESTS_DataByte(byte);
+		return 0xFF;
+
+	case MODEL_MODE_WAIT_TOKEN:
+		if (byte == SD_TOKEN_START_MULTI && multi) {
+			mode = MODEL_MODE_DATA;
+		} else if (byte == SD_TOKEN_START_BLOCK && !multi) {
+			mode = MODEL_MODE_DATA;
+		} else if (byte == SD_TOKEN_STOP_TRAN && multi) {
+			multi = 0;
+			mode = MODEL_MODE_COMMAND;
+			SD_TESTS_StartBusy(card.busy_us);
+			busy_until_ns += byte_ns; // Busy starts one byte after the token
+		} else if (byte != 0xFF) {
+			model.conflicts++; // Unexpected byte
+		}
+		return 0xFF;
+
+	default:
+		if (command_count == 0 && (byte & 0xC0) != 0x40) {
+			return 0xFF;
+		}
+		command[command_count++] = byte;
+		if (command_count == 6) {
+			command_count = 0;
+			SD_TESTS_Execute();
+		}
+		return 0xFF;
+	}
+}
+
+static void SD_TESTS_Select(uint8_t select) {
+	selected = select;
+	if (!select) {
+		command_count = 0;
+		out_count = 0;
+		out_position = 0;
+	}
+}
+
+static int8_t SD_TESTS_WriteDMA(uint8_t token, const uint8_t data[], uint16_t size, uint8_t trailer[],
+		uint8_t trailer_size) {
+	if (selected || dma_busy) {
+		model.conflicts++;
+		return -1;
+	}
+	SD_TESTS_Select(1);
+	SD_TESTS_Exchange(0xFF);
+	SD_TESTS_Exchange(token);
+	if (mode != MODEL_MODE_DATA) {
+		model.conflicts++;
+	}
+	// The model reads the buffer at once, the driver must still keep it until the callback
+	for (uint16_t i = 0; i < size; i++) {
+		SD_TESTS_DataByte(data[i]);
+	}
+	dma_busy = 1;
+	dma_done_ns = sim_ns + (uint64_t)size * byte_ns;
+	dma_trailer = trailer;
+	dma_trailer_size = trailer_size;
+	model.bus_ns += (uint64_t)size * byte_ns;
+	return 0;
+}
+
+static void SD_TESTS_SetFast(uint8_t fast) {
+	byte_ns = fast ? SD_TESTS_FAST_BYTE_NS : SD_TESTS_SLOW_BYTE_NS;
+}
+
+static const SD_Port model_port = { SD_TESTS_Select, SD_TESTS_Exchange, SD_TESTS_WriteDMA, SD_TESTS_SetFast };
+
+/**
+ * New card: erased blocks, statistics cleared.
+ */
+void SD_TESTS_ModelReset(const SD_TESTS_Card *new_card) {
+	card = *new_card;
+	memset(&model, 0, sizeof(model));
+	memset(model_full, 0, sizeof(model_full));
+	memset(model_headers, 0, sizeof(model_headers));
+	programmed = 0;
+	SD_TESTS_ModelPowerLoss();
+}
+
+/**
+ * Power cycle: the blocks written stay, a write in progress is lost.
+ */
+void SD_TESTS_ModelPowerLoss() {
+	byte_ns = SD_TESTS_SLOW_BYTE_NS;
+	selected = 0;
+	started = 0;
+	dma_busy = 0;
+	idle_state = 1;
+	app_command = 0;
+	init_left = card.init_polls;
+	mode = MODEL_MODE_COMMAND;
+	command_count = 0;
+	out_count = 0;
+	out_position = 0;
+	busy_until_ns = 0;
+	multi = 0;
+	block_sum = 0;
+}
+
+/**
+ * Advance the simulated time, completing the block write in progress (trailer, card
+ * deselected).
+ */
+void SD_TESTS_ModelAdvance(uint32_t time_us) {
+	uint64_t end_ns = sim_ns + (uint64_t)time_us * 1000;
+	if (dma_busy && dma_done_ns <= end_ns) {
+		if (dma_done_ns > sim_ns) {
+			sim_ns = dma_done_ns;
+		}
+		dma_busy = 0;
+		for (uint8_t i = 0; i < dma_trailer_size; i++) {
+			dma_trailer[i] = SD_TESTS_Exchange(0xFF);
+		}
+		SD_TESTS_Select(0);
+		SD_TESTS_Exchange(0xFF); // Release MISO
+		SD_TxCallback(&model_hspi);
+	}
+	if (end_ns > sim_ns) {
+		sim_ns = end_ns;
+	}
+}
+
+uint32_t SD_TESTS_ModelTimeUs() {
+	return sim_ns / 1000;
+}
+
+uint32_t SD_TESTS_ModelExchanges() {
+	return exchanges;
+}
+
+uint8_t SD_TESTS_ModelSelected() {
+	return selected;
+}
+
+const SD_TESTS_ModelStats *SD_TESTS_ModelGetStats() {
+	return &model;
+}
+
+/**
+ * SD_Init with the model.
+ */
+int8_t SD_TESTS_ModelInit() {
+	model_hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+	return SD_Init(&model_hspi, &model_port);
+}
+
+void SD_TESTS_Model_LogSTLINK() {
+	SD_TESTS_Card test_card = { 1, 1, 20, 2000, 0, 0 };
+	uint8_t data[SD_BLOCK_SIZE];
+	uint8_t read[SD_BLOCK_SIZE];
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: SDHC initialization, 74 clocks with CS high, then fast clock and CS high
+	SD_TESTS_ModelReset(&test_card);
+	int8_t status = SD_TESTS_ModelInit();
+	if (status == 0 && SD_GetType() == SD_TYPE_SDHC && model.init_clocks >= 74 && byte_ns == SD_TESTS_FAST_BYTE_NS
+			&& !selected) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: SDSC card (byte addressing), write and read back block 1
+	test_card.sdhc = 0;
+	SD_TESTS_ModelReset(&test_card);
+	status = SD_TESTS_ModelInit();
+	for (uint16_t i = 0; i < SD_BLOCK_SIZE; i++) {
+		data[i] = i * 7;
+	}
+	status |= SD_WriteBlock(1, data);
+	status |= SD_ReadBlock(1, read);
+	if (status == 0 && SD_GetType() == SD_TYPE_SDSC && memcmp(data, read, SD_BLOCK_SIZE) == 0
+			&& memcmp(data, model_full[1], SD_BLOCK_SIZE) == 0 && model.conflicts == 0) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: no card
+	test_card.present = 0;
+	SD_TESTS_ModelReset(&test_card);
+	if (SD_TESTS_ModelInit() == -1 && SD_GetType() == SD_TYPE_NONE && SD_ReadBlock(0, read) == -1) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: multi-block write of 4 blocks with a 2 ms programming time. SD_WriteNext returns
+	// during the DMA, the card is deselected at the end of the block (trailer received with
+	// it), SD_Poll exchanges one byte per call at most
+	test_card.present = 1;
+	test_card.sdhc = 1;
+	SD_TESTS_ModelReset(&test_card);
+	status = SD_TESTS_ModelInit();
+	status |= SD_WriteStart(10, 8);
+	uint8_t ok = 1;
+	uint32_t polls = 0;
+	uint32_t max_exchanges = 0;
+	for (uint8_t n = 0; n < 4; n++) {
+		data[0] = n;
+		status |= SD_WriteNext(data);
+		ok &= SD_DMABusy() && SD_WriteNext(data) == -2 && SD_ReadBlock(0, read) == -2;
+		SD_TESTS_ModelAdvance(300); // 512 bytes at 18 MHz
+		ok &= !selected;
+		int8_t poll;
+		do {
+			uint32_t before = exchanges;
+			poll = SD_Poll();
+			if (exchanges - before > max_exchanges) {
+				max_exchanges = exchanges - before;
+			}
+			ok &= !selected;
+			polls++;
+			SD_TESTS_ModelAdvance(100);
+		} while (poll == 0 && polls < 1000);
+		ok &= poll == 1;
+	}
+	status |= SD_WriteStop();
+	while (SD_Poll() == 0 && polls < 2000) {
+		polls++;
+		SD_TESTS_ModelAdvance(100);
+	}
+	for (uint8_t n = 0; n < 4; n++) {
+		ok &= model_headers[10 + n][0] == n;
+	}
+	printf("%lu polls, %lu bytes per poll at most\n", polls, max_exchanges);
+	if (status == 0 && ok && SD_GetStats()->blocks_written == 4 && model.blocks == 4 && model.pre_erase == 8
+			&& model.conflicts == 0 && max_exchanges <= 1 && polls > 40 && SD_GetState() == SD_STATE_IDLE) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+/**
+ * Initialize the real card and read its first block (nothing is written).
+ *
+ * @param hspi: SPI connected to the card (&hspi2).
+ */
+void SD_TESTS_Card_LogSTLINK(SPI_HandleTypeDef *hspi) {
+	static uint8_t data[SD_BLOCK_SIZE];
+
+	uint32_t start_ms = HAL_GetTick();
+	int8_t status = SD_Init(hspi, NULL);
+	printf("SD init %d in %lu ms, type %u\n", status, HAL_GetTick() - start_ms, SD_GetType());
+	if (status != 0) {
+		return;
+	}
+
+	start_ms = HAL_GetTick();
+	status = SD_ReadBlock(0, data);
+	printf("Block 0 read %d in %lu ms: %02X %02X %02X %02X\n", status, HAL_GetTick() - start_ms, data[0], data[1],
+			data[2], data[3]);
+}
+
+void SD_TESTS_LogStats() {
+	const SD_Stats *stats = SD_GetStats();
+	printf("SD %lu blocks, %lu errors, %lu without DMA, %lu timeouts, busy max %lu ms (%lu polls)\n",
+			stats->blocks_written, stats->errors, stats->dma_errors, stats->timeouts, stats->max_busy_ms,
+			stats->busy_polls);
+}
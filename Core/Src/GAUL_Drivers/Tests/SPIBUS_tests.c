@@ -0,0 +1,420 @@
+/*
+ * SPIBUS_tests.c
+ *
+ * SPIBUS_TESTS_Model_LogSTLINK replaces SPI2 by a model of the bus with the three devices
+ * (BMP280, ICM-20602, SD card, found by their chip select pin): the model checks that one
+ * chip select at most is low, that no byte is exchanged during a DMA transfer and that each
+ * device is clocked at its own prescaler. Every byte takes 8 clocks of simulated time at
+ * the current prescaler, a DMA transfer completes when the simulated time reaches its end
+ * (SPIBUS_TESTS_Advance calls SPIBUS_TxRxCallback like the DMA interrupt).
+ *
+ * DMA1 Channel4 is modeled too: while the radio sends a frame, the RX DMA channel is
+ * refused to the bus, and the end of the frame resumes the bus like DMASHARE_Release.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/Tests/SPIBUS_tests.h"
+
+#include "GAUL_Drivers/BMP280.h"
+#include "GAUL_Drivers/ICM20602.h"
+#include "GAUL_Drivers/SD.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MODEL_BMP 0
+#define MODEL_ICM 1
+#define MODEL_SD  2
+
+static SPI_HandleTypeDef model_hspi;
+static SPIBUS_TESTS_ModelStats model;
+static const uint16_t model_pins[SPIBUS_TESTS_DEVICES] = { BMP_CS_Pin, ICM_CS_Pin, SD_CS_Pin };
+static uint32_t expected[SPIBUS_TESTS_DEVICES]; // Prescaler of each device
+static uint8_t devices[SPIBUS_TESTS_DEVICES];   // SPIBUS device numbers
+
+// Bus
+static uint64_t sim_ns;
+static uint32_t prescaler;
+static uint8_t selected;         // Model device with CS low, SPIBUS_NONE
+static uint8_t dma_busy;
+static uint64_t dma_done_ns;
+
+// DMA1 Channel4
+static uint8_t radio_channel;    // 1: the radio sends a frame
+static uint8_t bus_channel;      // 1: taken by the bus
+static uint8_t bus_waiting;      // Refused to the bus, resumed at the end of the frame
+
+// Order of the chip selects and of the completed transactions
+static uint8_t order[SPIBUS_TESTS_MAX_ORDER];
+static uint8_t order_count;
+static SPIBUS_Transaction *completed[SPIBUS_TESTS_MAX_ORDER];
+static uint8_t completed_count;
+static uint64_t last_done_ns;
+
+static uint8_t block[SD_BLOCK_SIZE];
+static uint8_t burst[10 * ICM20602_PACKET_SIZE];
+static uint8_t baro[6];
+
+static uint64_t SPIBUS_TESTS_ByteNs(uint32_t value) {
+	uint32_t divider = 2 << ((value & SPI_CR1_BR) >> SPI_CR1_BR_Pos);
+	return (uint64_t)8 * divider * 1000000000 / SPIBUS_TESTS_SPI_CLOCK_HZ;
+}
+
+static uint8_t SPIBUS_TESTS_Lookup(const SPIBUS_Device *device) {
+	for (uint8_t i = 0; i < SPIBUS_TESTS_DEVICES; i++) {
+		if (device->cs_pin == model_pins[i]) {
+			return i;
+		}
+	}
+	return SPIBUS_NONE;
+}
+
+static void SPIBUS_TESTS_Select(const SPIBUS_Device *device, uint8_t select) {
+	uint8_t d = SPIBUS_TESTS_Lookup(device);
+	if (d == SPIBUS_NONE) {
+		model.conflicts++;
+		return;
+	}
+	if (select) {
+		if (selected != SPIBUS_NONE || dma_busy) {
+			model.conflicts++;
+		}
+		selected = d;
+		model.selects[d]++;
+		if (order_count < SPIBUS_TESTS_MAX_ORDER) {
+			order[order_count++] = d;
+		}
+		sim_ns += SPIBUS_TESTS_SELECT_NS;
+		model.bus_ns[d] += SPIBUS_TESTS_SELECT_NS;
+	} else {
+		if (selected != d) {
+			model.conflicts++;
+		}
+		selected = SPIBUS_NONE;
+	}
+}
+
+static void SPIBUS_TESTS_SetPrescaler(uint32_t value) {
+	prescaler = value;
+}
+
+static uint8_t SPIBUS_TESTS_Byte(uint8_t byte) {
+	uint64_t ns = SPIBUS_TESTS_ByteNs(prescaler);
+	sim_ns += ns;
+	if (selected == SPIBUS_NONE) {
+		model.free_clocks++;
+		return 0xFF;
+	}
+	model.bytes[selected]++;
+	model.bus_ns[selected] += ns;
+	if (prescaler != expected[selected]) {
+		model.wrong_clock++;
+	}
+	return 0xA0 + selected;
+}
+
+static void SPIBUS_TESTS_Transfer(const uint8_t tx[], uint8_t rx[], uint16_t size) {
+	if (dma_busy) {
+		model.conflicts++;
+	}
+	for (uint16_t i = 0; i < size; i++) {
+		uint8_t byte = SPIBUS_TESTS_Byte(tx != NULL ? tx[i] : 0xFF);
+		if (rx != NULL) {
+			rx[i] = byte;
+		}
+	}
+}
+
+static int8_t SPIBUS_TESTS_TransferDMA(const uint8_t tx[], uint8_t rx[], uint16_t size) {
+	if (dma_busy || selected == SPIBUS_NONE || (rx != NULL && !bus_channel)) {
+		model.conflicts++;
+		return -1;
+	}
+	// The model exchanges the bytes at once, the DMA completes at the end of their time
+	uint64_t start_ns = sim_ns;
+	SPIBUS_TESTS_Transfer(tx, rx, size);
+	dma_done_ns = sim_ns;
+	sim_ns = start_ns;
+	dma_busy = 1;
+	return 0;
+}
+
+static int8_t SPIBUS_TESTS_AcquireRxDMA() {
+	if (radio_channel) {
+		bus_waiting = 1;
+		return -2;
+	}
+	bus_channel = 1;
+	return 0;
+}
+
+static void SPIBUS_TESTS_ReleaseRxDMA() {
+	bus_channel = 0;
+}
+
+static const SPIBUS_Port model_port = { SPIBUS_TESTS_Select, SPIBUS_TESTS_SetPrescaler, SPIBUS_TESTS_Transfer,
+		SPIBUS_TESTS_TransferDMA, SPIBUS_TESTS_AcquireRxDMA, SPIBUS_TESTS_ReleaseRxDMA };
+
+/**
+ * End of the radio frame: the channel is released, the bus is resumed if it was refused.
+ */
+static void SPIBUS_TESTS_RadioDone() {
+	radio_channel = 0;
+	if (bus_waiting) {
+		bus_waiting = 0;
+		SPIBUS_Resume();
+	}
+}
+
+/**
+ * Advance the simulated time, completing the DMA transfers in progress.
+ */
+static void SPIBUS_TESTS_Advance(uint32_t time_us) {
+	uint64_t end_ns = sim_ns + (uint64_t)time_us * 1000;
+	while (dma_busy && dma_done_ns <= end_ns) {
+		if (dma_done_ns > sim_ns) {
+			sim_ns = dma_done_ns;
+		}
+		dma_busy = 0;
+		SPIBUS_TxRxCallback(&model_hspi);
+	}
+	if (end_ns > sim_ns) {
+		sim_ns = end_ns;
+	}
+}
+
+static void SPIBUS_TESTS_Done(SPIBUS_Transaction *transaction) {
+	if (completed_count < SPIBUS_TESTS_MAX_ORDER) {
+		completed[completed_count++] = transaction;
+	}
+	last_done_ns = sim_ns;
+}
+
+/**
+ * New bus with the three devices at their flight clock.
+ */
+static void SPIBUS_TESTS_Setup() {
+	sim_ns = 0;
+	prescaler = SPI_BAUDRATEPRESCALER_16;
+	selected = SPIBUS_NONE;
+	dma_busy = 0;
+	radio_channel = 0;
+	bus_channel = 0;
+	bus_waiting = 0;
+	order_count = 0;
+	completed_count = 0;
+	last_done_ns = 0;
+
+	model_hspi.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+	SPIBUS_Init(&model_hspi, &model_port);
+	devices[MODEL_BMP] = SPIBUS_AddDevice(BMP_CS_GPIO_Port, BMP_CS_Pin, BMP280_SPI_PRESCALER, 0);
+	devices[MODEL_ICM] = SPIBUS_AddDevice(ICM_CS_GPIO_Port, ICM_CS_Pin, ICM20602_SPI_PRESCALER, 0);
+	devices[MODEL_SD] = SPIBUS_AddDevice(SD_CS_GPIO_Port, SD_CS_Pin, SD_FAST_PRESCALER, SPIBUS_DEVICE_RELEASE_MISO);
+	expected[MODEL_BMP] = BMP280_SPI_PRESCALER;
+	expected[MODEL_ICM] = ICM20602_SPI_PRESCALER;
+	expected[MODEL_SD] = SD_FAST_PRESCALER;
+	memset(&model, 0, sizeof(model)); // Without the idle level byte of SPIBUS_Init
+}
+
+static void SPIBUS_TESTS_SDBlock(SPIBUS_Transaction *transaction) {
+	*transaction = (SPIBUS_Transaction) {
+		.device = devices[MODEL_SD],
+		.priority = SPIBUS_PRIORITY_LOW,
+		.header = { 0xFF, SD_TOKEN_START_MULTI },
+		.header_size = 2,
+		.tx = block,
+		.size = SD_BLOCK_SIZE,
+		.trailer_size = 12,
+		.callback = SPIBUS_TESTS_Done,
+	};
+}
+
+static void SPIBUS_TESTS_IMUBurst(SPIBUS_Transaction *transaction) {
+	*transaction = (SPIBUS_Transaction) {
+		.device = devices[MODEL_ICM],
+		.priority = SPIBUS_PRIORITY_HIGH,
+		.header = { ICM20602_REG_FIFO_R_W | ICM20602_READ },
+		.header_size = 1,
+		.rx = burst,
+		.size = sizeof(burst),
+		.callback = SPIBUS_TESTS_Done,
+	};
+}
+
+static void SPIBUS_TESTS_BaroRead(SPIBUS_Transaction *transaction) {
+	*transaction = (SPIBUS_Transaction) {
+		.device = devices[MODEL_BMP],
+		.priority = SPIBUS_PRIORITY_NORMAL,
+		.header = { BMP280_REG_PRESS_MSB },
+		.header_size = 1,
+		.rx = baro,
+		.size = sizeof(baro),
+		.callback = SPIBUS_TESTS_Done,
+	};
+}
+
+void SPIBUS_TESTS_Model_LogSTLINK() {
+	SPIBUS_Transaction sd1, sd2, sd3, imu, bmp;
+	const SPIBUS_Stats *stats = SPIBUS_GetStats();
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: an IMU burst queued after an SD block goes first, the block in progress is
+	// not interrupted
+	SPIBUS_TESTS_Setup();
+	SPIBUS_TESTS_SDBlock(&sd1);
+	SPIBUS_TESTS_SDBlock(&sd2);
+	SPIBUS_TESTS_IMUBurst(&imu);
+	int8_t status = SPIBUS_Submit(&sd1);
+	status |= SPIBUS_Submit(&sd2);
+	status |= SPIBUS_Submit(&imu);
+	uint8_t ok = sd1.status == SPIBUS_STATUS_RUNNING && SPIBUS_Queued() == 2 && SPIBUS_Submit(&imu) == -2;
+	SPIBUS_TESTS_Advance(10000);
+	ok &= completed_count == 3 && completed[0] == &sd1 && completed[1] == &imu && completed[2] == &sd2;
+	ok &= order_count == 3 && order[0] == MODEL_SD && order[1] == MODEL_ICM && order[2] == MODEL_SD;
+	if (status == 0 && ok && stats->reordered == 1 && stats->dma == 3 && model.conflicts == 0 && !SPIBUS_Busy()) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: each device at its clock, the SD card initialization clock (CS high, then a
+	// session) and the flight clock, the prescaler only changes with the device
+	SPIBUS_TESTS_Setup();
+	SPIBUS_SetPrescaler(devices[MODEL_SD], SD_SLOW_PRESCALER);
+	expected[MODEL_SD] = SD_SLOW_PRESCALER;
+	status = SPIBUS_Clock(devices[MODEL_SD], 10);
+	ok = prescaler == SD_SLOW_PRESCALER && model.free_clocks == 10;
+	status |= SPIBUS_Select(devices[MODEL_SD]);
+	for (uint8_t i = 0; i < 6; i++) {
+		SPIBUS_Exchange(0xFF);
+	}
+	SPIBUS_Deselect(devices[MODEL_SD]);
+	SPIBUS_SetPrescaler(devices[MODEL_SD], SD_FAST_PRESCALER);
+	expected[MODEL_SD] = SD_FAST_PRESCALER;
+	SPIBUS_TESTS_BaroRead(&bmp);
+	SPIBUS_TESTS_SDBlock(&sd1);
+	SPIBUS_TESTS_IMUBurst(&imu);
+	status |= SPIBUS_Submit(&bmp);
+	ok &= bmp.status == SPIBUS_STATUS_DONE && baro[0] == 0xA0 + MODEL_BMP; // Short, without DMA
+	status |= SPIBUS_Submit(&sd1);
+	status |= SPIBUS_Submit(&imu);
+	SPIBUS_TESTS_Advance(10000);
+	printf("%lu prescaler switches, %lu free clocks\n", stats->prescaler_switches, model.free_clocks);
+	if (status == 0 && ok && model.wrong_clock == 0 && model.free_clocks == 10 + 1 + 1
+			&& stats->prescaler_switches == 4 && completed_count == 3 && model.conflicts == 0) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: a session waits for the transfer in progress (timeout while the DMA runs),
+	// a transaction submitted during a session waits for SPIBUS_Deselect
+	SPIBUS_TESTS_Setup();
+	SPIBUS_TESTS_SDBlock(&sd1);
+	SPIBUS_TESTS_IMUBurst(&imu);
+	ok = SPIBUS_Exchange(0x55) == 0xFF && model.free_clocks == 0; // No session
+	status = SPIBUS_Submit(&sd1);
+	ok &= SPIBUS_Select(devices[MODEL_BMP]) == -3 && model.selects[MODEL_BMP] == 0;
+	SPIBUS_TESTS_Advance(1000);
+	ok &= SPIBUS_Select(devices[MODEL_BMP]) == 0;
+	status |= SPIBUS_Submit(&imu);
+	ok &= imu.status == SPIBUS_STATUS_QUEUED && model.selects[MODEL_ICM] == 0
+			&& SPIBUS_Exchange(0x80) == 0xA0 + MODEL_BMP;
+	SPIBUS_Deselect(devices[MODEL_BMP]);
+	ok &= imu.status == SPIBUS_STATUS_RUNNING;
+	SPIBUS_TESTS_Advance(1000);
+	if (status == 0 && ok && imu.status == SPIBUS_STATUS_DONE && stats->sessions == 1 && stats->session_timeouts == 1
+			&& model.conflicts == 0) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: the radio sends a frame on DMA1 Channel4, the IMU burst waits for the channel,
+	// the SD block (TX only, Channel5) goes meanwhile, the end of the frame resumes the burst
+	SPIBUS_TESTS_Setup();
+	SPIBUS_TESTS_IMUBurst(&imu);
+	SPIBUS_TESTS_SDBlock(&sd1);
+	radio_channel = 1;
+	status = SPIBUS_Submit(&imu);
+	ok = imu.status == SPIBUS_STATUS_QUEUED && !SPIBUS_Busy();
+	status |= SPIBUS_Submit(&sd1);
+	ok &= sd1.status == SPIBUS_STATUS_RUNNING;
+	SPIBUS_TESTS_Advance(1000);
+	ok &= sd1.status == SPIBUS_STATUS_DONE && imu.status == SPIBUS_STATUS_QUEUED && !bus_channel;
+	SPIBUS_TESTS_RadioDone();
+	ok &= imu.status == SPIBUS_STATUS_RUNNING && bus_channel;
+	SPIBUS_TESTS_Advance(1000);
+	printf("%lu RX DMA waits\n", stats->rx_dma_waits);
+	if (status == 0 && ok && imu.status == SPIBUS_STATUS_DONE && !bus_channel && completed_count == 2
+			&& completed[0] == &sd1 && completed[1] == &imu && stats->rx_dma_waits >= 2 && model.conflicts == 0) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: back to back, the bus is never idle while transactions are queued
+	SPIBUS_TESTS_Setup();
+	SPIBUS_TESTS_SDBlock(&sd1);
+	SPIBUS_TESTS_SDBlock(&sd2);
+	SPIBUS_TESTS_SDBlock(&sd3);
+	SPIBUS_TESTS_IMUBurst(&imu);
+	uint64_t start_ns = sim_ns;
+	status = SPIBUS_Submit(&sd1);
+	status |= SPIBUS_Submit(&sd2);
+	status |= SPIBUS_Submit(&sd3);
+	status |= SPIBUS_Submit(&imu);
+	SPIBUS_TESTS_Advance(10000);
+	uint64_t used_ns = model.free_clocks * SPIBUS_TESTS_ByteNs(SD_FAST_PRESCALER);
+	for (uint8_t i = 0; i < SPIBUS_TESTS_DEVICES; i++) {
+		used_ns += model.bus_ns[i];
+	}
+	uint64_t elapsed_ns = last_done_ns - start_ns;
+	printf("4 transactions in %lu us, bus used %lu us\n", (uint32_t)(elapsed_ns / 1000), (uint32_t)(used_ns / 1000));
+	if (status == 0 && completed_count == 4 && elapsed_ns == used_ns && stats->max_queued == 3
+			&& model.conflicts == 0) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: bus time of a BMP280 measurement read (address and 26 bytes) at 9 MHz and at
+	// the previous shared clock of 2.25 MHz
+	uint64_t read_ns[2];
+	for (uint8_t i = 0; i < 2; i++) {
+		SPIBUS_TESTS_Setup();
+		if (i == 1) {
+			SPIBUS_AddDevice(BMP_CS_GPIO_Port, BMP_CS_Pin, SPI_BAUDRATEPRESCALER_16, 0);
+			expected[MODEL_BMP] = SPI_BAUDRATEPRESCALER_16;
+		}
+		uint8_t address = BMP280_REG_CALIB_00 | 0x80;
+		uint8_t data[26];
+		SPIBUS_Select(devices[MODEL_BMP]);
+		SPIBUS_Transmit(&address, 1);
+		SPIBUS_Receive(data, sizeof(data));
+		SPIBUS_Deselect(devices[MODEL_BMP]);
+		read_ns[i] = model.bus_ns[MODEL_BMP];
+	}
+	printf("BMP280 read %lu us at 9 MHz, %lu us at 2.25 MHz\n", (uint32_t)(read_ns[0] / 1000),
+			(uint32_t)(read_ns[1] / 1000));
+	if (read_ns[0] * 3 < read_ns[1] && model.wrong_clock == 0 && model.conflicts == 0) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void SPIBUS_TESTS_LogStats() {
+	const SPIBUS_Stats *stats = SPIBUS_GetStats();
+	printf("SPIBUS %lu transactions (%lu DMA, %lu without), %lu RX DMA waits, %lu reordered, max %u queued, "
+			"%lu sessions (%lu waits, %lu timeouts), %lu prescaler switches\n", stats->transactions, stats->dma,
+			stats->dma_errors, stats->rx_dma_waits, stats->reordered, stats->max_queued, stats->sessions,
+			stats->session_waits, stats->session_timeouts, stats->prescaler_switches);
+}
@@ -0,0 +1,322 @@
+/*
+ * UARTERR_tests.c
+ *
+ * UARTERR_TESTS_Inject_LogSTLINK runs HAL_UART_IRQHandler on USART registers in RAM: a
+ * received byte sets RXNE (and the error flags injected), then the interrupt is taken if
+ * the HAL enabled it, like the real USART. The status then data register read of the
+ * interrupt clears the flags. The HAL gives the bytes to L76LM33 and RFD900 through
+ * HAL_UART_RxCpltCallback (main.c), the tests check that the sentences and the bytes still
+ * arrive after each kind of error, and that a stopped reception without UARTERR is lost.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/Tests/UARTERR_tests.h"
+
+#include "GAUL_Drivers/L76LM33.h"
+#include "GAUL_Drivers/RFD900.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define UARTERR_TESTS_FLAGS (USART_SR_RXNE | USART_SR_ORE | USART_SR_FE | USART_SR_NE | USART_SR_PE)
+
+// USART registers and handles of the model (the real USART1 and USART2 are not touched)
+static USART_TypeDef gnss_usart;
+static USART_TypeDef radio_usart;
+static UART_HandleTypeDef gnss_huart;
+static UART_HandleTypeDef radio_huart;
+
+static uint32_t model_ms;
+static uint32_t lost;           // Bytes arrived with the interrupt disabled
+static uint32_t radio_count;    // Bytes given to the RFD900 receive function
+static uint8_t radio_last;
+
+static uint32_t UARTERR_TESTS_Tick() {
+	return model_ms;
+}
+
+static void UARTERR_TESTS_Wait(uint32_t ms) {
+	model_ms += ms;
+}
+
+static int8_t UARTERR_TESTS_SetBaud(UART_HandleTypeDef *huart, uint32_t baud) {
+	huart->Init.BaudRate = baud;
+	return 0;
+}
+
+static int8_t UARTERR_TESTS_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+	(void)huart;
+	(void)data;
+	(void)size;
+	return 0; // No module, never acknowledged
+}
+
+static const L76LM33_Port model_port = {
+	.transmit = UARTERR_TESTS_Transmit,
+	.set_baud = UARTERR_TESTS_SetBaud,
+	.tick = UARTERR_TESTS_Tick,
+	.wait = UARTERR_TESTS_Wait,
+};
+
+static void UARTERR_TESTS_RadioByte(uint8_t byte) {
+	radio_count++;
+	radio_last = byte;
+}
+
+/**
+ * Take the USART interrupt if the HAL enabled it for the flags set.
+ *
+ * @param direct: 1: HAL_UART_IRQHandler alone (without UARTERR).
+ */
+static void UARTERR_TESTS_Interrupt(UART_HandleTypeDef *huart, uint8_t direct) {
+	USART_TypeDef *usart = huart->Instance;
+	uint8_t enabled = ((usart->CR1 & USART_CR1_RXNEIE) && (usart->SR & (USART_SR_RXNE | USART_SR_ORE)))
+			|| ((usart->CR3 & USART_CR3_EIE) && (usart->SR & (USART_SR_ORE | USART_SR_FE | USART_SR_NE)))
+			|| ((usart->CR1 & USART_CR1_PEIE) && (usart->SR & USART_SR_PE));
+	if (!enabled) {
+		lost++;
+		return;
+	}
+	if (direct) {
+		HAL_UART_IRQHandler(huart);
+	} else {
+		UARTERR_IRQHandler(huart);
+	}
+	usart->SR &= ~UARTERR_TESTS_FLAGS; // Status then data register read
+}
+
+/**
+ * A byte arrives on the line, with the error flags of its frame.
+ *
+ * @param errors: USART_SR_x set with RXNE (ORE: the byte before this one was lost).
+ */
+static void UARTERR_TESTS_Receive(UART_HandleTypeDef *huart, uint8_t byte, uint32_t errors, uint8_t direct) {
+	USART_TypeDef *usart = huart->Instance;
+	if (usart->SR & USART_SR_RXNE) {
+		usart->SR |= USART_SR_ORE; // Previous byte not read, this one is lost
+		lost++;
+		return;
+	}
+	usart->DR = byte;
+	usart->SR |= USART_SR_RXNE | errors;
+	UARTERR_TESTS_Interrupt(huart, direct);
+}
+
+/**
+ * Overrun without RXNE: the byte was read by the previous interrupt between the status and
+ * data register reads, the HAL does not read the data register and stops the reception.
+ */
+static void UARTERR_TESTS_LateOverrun(UART_HandleTypeDef *huart, uint8_t direct) {
+	huart->Instance->SR |= USART_SR_ORE;
+	UARTERR_TESTS_Interrupt(huart, direct);
+}
+
+/**
+ * RMC sentence of the second "second" of 08:06.
+ *
+ * @return length
+ */
+static uint16_t UARTERR_TESTS_Sentence(char sentence[], uint8_t second) {
+	int length = snprintf(sentence, 96, "$GNRMC,0806%02u.000,A,3029.461489,N,11430.072002,E,0.00,148.41,210423,,,D,V",
+			second % 60);
+	uint8_t checksum = 0;
+	for (int i = 1; i < length; i++) {
+		checksum ^= sentence[i];
+	}
+	return length + snprintf(sentence + length, 96 - length, "*%02X\r\n", checksum);
+}
+
+/**
+ * Send a sentence on USART2.
+ *
+ * @param error_at: index of the byte with "errors", -1: none (with ORE, the next byte is lost).
+ *
+ * @return length
+ */
+static uint16_t UARTERR_TESTS_SendSentence(uint8_t second, int16_t error_at, uint32_t errors, uint8_t direct) {
+	char sentence[96];
+	uint16_t length = UARTERR_TESTS_Sentence(sentence, second);
+	for (int16_t i = 0; i < length; i++) {
+		if (i == error_at + 1 && (errors & USART_SR_ORE)) {
+			continue; // Lost in the shift register
+		}
+		UARTERR_TESTS_Receive(&gnss_huart, sentence[i], i == error_at ? errors : 0, direct);
+	}
+	return length;
+}
+
+/**
+ * @retval 1 the sentence of "second" was read
+ */
+static uint8_t UARTERR_TESTS_Read(uint8_t second) {
+	L76LM33 data = { 0 };
+	return L76LM33_Read(&data) == 0 && data.fix && data.utc_ms == ((8 * 60 + 6) * 60 + second % 60) * 1000u;
+}
+
+static void UARTERR_TESTS_Setup() {
+	memset(&gnss_usart, 0, sizeof(gnss_usart));
+	memset(&radio_usart, 0, sizeof(radio_usart));
+	memset(&gnss_huart, 0, sizeof(gnss_huart));
+	memset(&radio_huart, 0, sizeof(radio_huart));
+	gnss_huart.Instance = &gnss_usart;
+	gnss_huart.Init.BaudRate = L76LM33_BAUD_DEFAULT;
+	gnss_huart.gState = HAL_UART_STATE_READY;
+	gnss_huart.RxState = HAL_UART_STATE_READY;
+	radio_huart.Instance = &radio_usart;
+	radio_huart.Init.BaudRate = 9600;
+	radio_huart.gState = HAL_UART_STATE_READY;
+	radio_huart.RxState = HAL_UART_STATE_READY;
+	model_ms = 0;
+	lost = 0;
+	radio_count = 0;
+	radio_last = 0;
+
+	// No module: the negotiation fails, the reception is started alone
+	UARTERR_Init();
+	L76LM33_Init(&gnss_huart, &model_port);
+	L76LM33_RestartReceive();
+	RFD900_Init(&radio_huart, RFD900_DROP_NEWEST, UARTERR_TESTS_Transmit);
+	RFD900_StartReceive(UARTERR_TESTS_RadioByte);
+	UARTERR_Register(UARTERR_PORT_GNSS, &gnss_huart, L76LM33_RestartReceive);
+	UARTERR_Register(UARTERR_PORT_RADIO, &radio_huart, RFD900_RestartReceive);
+}
+
+void UARTERR_TESTS_Inject_LogSTLINK() {
+	const UARTERR_Stats *stats = UARTERR_GetStats();
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: sentences without error are read, nothing counted
+	UARTERR_TESTS_Setup();
+	uint8_t ok = 1;
+	for (uint8_t i = 0; i < 3; i++) {
+		UARTERR_TESTS_SendSentence(i, -1, 0, 0);
+		ok &= UARTERR_TESTS_Read(i);
+	}
+	if (ok && lost == 0 && UARTERR_Errors(UARTERR_PORT_GNSS) == 0 && gnss_huart.RxState == HAL_UART_STATE_BUSY_RX) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: overrun in a sentence, the byte in the data register is given to the driver
+	// (which starts the next byte), the sentence is dropped and the next one is read
+	UARTERR_TESTS_Setup();
+	UARTERR_TESTS_SendSentence(0, 20, USART_SR_ORE, 0);
+	uint8_t dropped = !UARTERR_TESTS_Read(0);
+	UARTERR_TESTS_SendSentence(1, -1, 0, 0);
+	if (dropped && UARTERR_TESTS_Read(1) && lost == 0 && stats->overruns[UARTERR_PORT_GNSS] == 1
+			&& stats->restarts[UARTERR_PORT_GNSS] == 0) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: overrun seen after the byte was read, the HAL stops the reception: without
+	// UARTERR every byte after it is lost, with UARTERR the reception is restarted in the
+	// same interrupt and the next sentence is read
+	UARTERR_TESTS_Setup();
+	UARTERR_TESTS_LateOverrun(&gnss_huart, 1);
+	uint16_t length = UARTERR_TESTS_SendSentence(0, -1, 0, 1);
+	uint8_t dead = !UARTERR_TESTS_Read(0) && lost == length && gnss_huart.RxState == HAL_UART_STATE_READY;
+	UARTERR_TESTS_Setup();
+	UARTERR_TESTS_LateOverrun(&gnss_huart, 0);
+	UARTERR_TESTS_SendSentence(1, -1, 0, 0);
+	if (dead && UARTERR_TESTS_Read(1) && lost == 0 && stats->overruns[UARTERR_PORT_GNSS] == 1
+			&& stats->restarts[UARTERR_PORT_GNSS] == 1 && stats->restart_errors[UARTERR_PORT_GNSS] == 0) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: framing and noise errors are counted by class, the reception goes on (the
+	// sentence with the error is dropped by its checksum). No parity error: parity is not
+	// enabled, the USART never sets PE.
+	UARTERR_TESTS_Setup();
+	const uint32_t classes[] = { USART_SR_FE, USART_SR_NE, USART_SR_FE | USART_SR_NE };
+	ok = 1;
+	for (uint8_t i = 0; i < 3; i++) {
+		UARTERR_TESTS_SendSentence(i, 30, classes[i], 0);
+		UARTERR_TESTS_SendSentence(10 + i, -1, 0, 0);
+		ok &= UARTERR_TESTS_Read(10 + i);
+	}
+	if (ok && lost == 0 && stats->framing[UARTERR_PORT_GNSS] == 2 && stats->noise[UARTERR_PORT_GNSS] == 2
+			&& stats->overruns[UARTERR_PORT_GNSS] == 0 && stats->restarts[UARTERR_PORT_GNSS] == 0
+			&& UARTERR_Errors(UARTERR_PORT_GNSS) == 4) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: errors of every class on USART1, the RFD900 receive function keeps getting the
+	// bytes and the counters of USART2 are not touched
+	UARTERR_TESTS_Setup();
+	const uint32_t radio_errors[] = { USART_SR_ORE, USART_SR_FE, USART_SR_NE, 0, 0 };
+	for (uint16_t i = 0; i < 100; i++) {
+		UARTERR_TESTS_Receive(&radio_huart, i, i % 10 == 0 ? radio_errors[(i / 10) % 5] : 0, 0);
+		if (i == 55) {
+			UARTERR_TESTS_LateOverrun(&radio_huart, 0);
+		}
+	}
+	if (radio_count == 100 && radio_last == 99 && lost == 0 && stats->overruns[UARTERR_PORT_RADIO] == 3
+			&& stats->framing[UARTERR_PORT_RADIO] == 2 && stats->noise[UARTERR_PORT_RADIO] == 2
+			&& stats->restarts[UARTERR_PORT_RADIO] == 1
+			&& UARTERR_Errors(UARTERR_PORT_GNSS) == 0) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: DMA transmit error (HAL_UART_ErrorCallback), counted, reception not touched,
+	// and a UART not registered is ignored
+	UARTERR_TESTS_Setup();
+	radio_huart.ErrorCode = HAL_UART_ERROR_DMA;
+	HAL_UART_ErrorCallback(&radio_huart);
+	UART_HandleTypeDef other = { .Instance = &gnss_usart, .ErrorCode = HAL_UART_ERROR_DMA };
+	HAL_UART_ErrorCallback(&other);
+	UARTERR_TESTS_Receive(&radio_huart, 0x42, 0, 0);
+	if (stats->dma[UARTERR_PORT_RADIO] == 1 && stats->dma[UARTERR_PORT_GNSS] == 0 && radio_count == 1
+			&& radio_last == 0x42 && UARTERR_Errors(UARTERR_PORT_RADIO) == 1) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Test 7: 200 sentences, every other one with a late overrun at a different byte: every
+	// clean sentence is read, every reception stop is restarted
+	UARTERR_TESTS_Setup();
+	ok = 1;
+	for (uint8_t i = 0; i < 200; i += 2) {
+		char sentence[96];
+		uint16_t length = UARTERR_TESTS_Sentence(sentence, i);
+		for (uint16_t j = 0; j < length; j++) {
+			UARTERR_TESTS_Receive(&gnss_huart, sentence[j], 0, 0);
+			if (j == i % length) {
+				UARTERR_TESTS_LateOverrun(&gnss_huart, 0);
+			}
+		}
+		UARTERR_TESTS_SendSentence(i + 1, -1, 0, 0);
+		ok &= UARTERR_TESTS_Read(i + 1);
+	}
+	if (ok && lost == 0 && stats->overruns[UARTERR_PORT_GNSS] == 100 && stats->restarts[UARTERR_PORT_GNSS] == 100
+			&& stats->restart_errors[UARTERR_PORT_GNSS] == 0) {
+		printf("Test 7 passed\n");
+	} else {
+		printf("Test 7 failed\n");
+	}
+
+	// Time from the overrun interrupt to the reception started again (logged)
+	UARTERR_TESTS_Setup();
+	gnss_usart.SR |= USART_SR_ORE;
+	uint32_t start = DWT->CYCCNT;
+	UARTERR_IRQHandler(&gnss_huart);
+	uint32_t cycles = DWT->CYCCNT - start;
+	gnss_usart.SR &= ~UARTERR_TESTS_FLAGS;
+	printf("Overrun interrupt and restart: %lu cycles\n", cycles);
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
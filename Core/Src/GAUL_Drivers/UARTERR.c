@@ -0,0 +1,161 @@
+/*
+ * UARTERR.c
+ *
+ * HAL_UART_IRQHandler (F1) on a receive error: the byte in the data register is given to
+ * the driver (HAL_UART_RxCpltCallback, which starts the next byte and clears the error
+ * code), then the error is blocking if the error code still holds an overrun: the
+ * reception is stopped (RxState ready, RXNE and error interrupts disabled). The error
+ * flags are read from the status register before the HAL clears them (status register
+ * then data register read), and the reception is restarted if it is not running after
+ * the HAL: blocking error, or error while the driver was not receiving. With the error
+ * interrupt disabled, the interrupt of the error is the only chance to restart it.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Drivers/UARTERR.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define UARTERR_SR_ERRORS (USART_SR_ORE | USART_SR_FE | USART_SR_NE | USART_SR_PE)
+
+static UART_HandleTypeDef *UARTERR_handles[UARTERR_PORTS];
+static UARTERR_Restart UARTERR_restarts[UARTERR_PORTS];
+static UARTERR_Stats UARTERR_stats;
+
+/**
+ * Forget the ports and clear the counters.
+ */
+void UARTERR_Init() {
+	memset(UARTERR_handles, 0, sizeof(UARTERR_handles));
+	memset(UARTERR_restarts, 0, sizeof(UARTERR_restarts));
+	memset(&UARTERR_stats, 0, sizeof(UARTERR_stats));
+}
+
+/**
+ * Watch the errors of a UART.
+ *
+ * @param port: UARTERR_PORT_x.
+ * @param huart: UART of the port.
+ * @param restart: starts the reception of the driver again, NULL: errors only counted.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, invalid parameter
+ */
+int8_t UARTERR_Register(uint8_t port, UART_HandleTypeDef *huart, UARTERR_Restart restart) {
+	if (port >= UARTERR_PORTS || huart == NULL) {
+		return -1; // Error
+	}
+	UARTERR_handles[port] = huart;
+	UARTERR_restarts[port] = restart;
+	return 0; // OK
+}
+
+/**
+ * @return UARTERR_PORT_x of the UART, UARTERR_PORTS if not registered
+ */
+static uint8_t UARTERR_Port(const UART_HandleTypeDef *huart) {
+	uint8_t port = 0;
+	while (port < UARTERR_PORTS && UARTERR_handles[port] != huart) {
+		port++;
+	}
+	return port;
+}
+
+/**
+ * UART interrupt, call from USARTx_IRQHandler instead of HAL_UART_IRQHandler.
+ *
+ * @param huart: UART of the interrupt, HAL_UART_IRQHandler only if it is not registered.
+ */
+void UARTERR_IRQHandler(UART_HandleTypeDef *huart) {
+	uint32_t errors = huart->Instance->SR & UARTERR_SR_ERRORS;
+
+	HAL_UART_IRQHandler(huart);
+
+	uint8_t port = UARTERR_Port(huart);
+	if (errors == 0 || port == UARTERR_PORTS) {
+		return;
+	}
+	if (errors & USART_SR_ORE) {
+		UARTERR_stats.overruns[port]++;
+	}
+	if (errors & USART_SR_FE) {
+		UARTERR_stats.framing[port]++;
+	}
+	if (errors & USART_SR_NE) {
+		UARTERR_stats.noise[port]++;
+	}
+	if (errors & USART_SR_PE) {
+		UARTERR_stats.parity[port]++;
+	}
+
+	// Next byte started by the driver, the flags were cleared by the data register read
+	if (huart->RxState != HAL_UART_STATE_READY) {
+		return;
+	}
+
+	// Stopped: drop the byte arrived meanwhile (the flags would be counted again), restart
+	__HAL_UART_CLEAR_PEFLAG(huart);
+	int8_t status = UARTERR_restarts[port] == NULL ? -2 : UARTERR_restarts[port]();
+	if (status == 0) {
+		UARTERR_stats.restarts[port]++;
+	} else if (status == -1) {
+		UARTERR_stats.restart_errors[port]++;
+	}
+}
+
+/**
+ * Count the DMA errors. Call from HAL_UART_ErrorCallback (the receive errors are counted
+ * by UARTERR_IRQHandler, the error code is already cleared when they reach the callback).
+ *
+ * @param huart: UART of the error, ignored if it is not registered.
+ */
+void UARTERR_ErrorCallback(UART_HandleTypeDef *huart) {
+	uint8_t port = UARTERR_Port(huart);
+	if (port == UARTERR_PORTS) {
+		return;
+	}
+	if (huart->ErrorCode & HAL_UART_ERROR_DMA) {
+		UARTERR_stats.dma[port]++;
+	}
+}
+
+/**
+ * @param port: UARTERR_PORT_x.
+ *
+ * @return errors of the port, all classes
+ */
+uint32_t UARTERR_Errors(uint8_t port) {
+	if (port >= UARTERR_PORTS) {
+		return 0;
+	}
+	return UARTERR_stats.overruns[port] + UARTERR_stats.framing[port] + UARTERR_stats.noise[port]
+			+ UARTERR_stats.parity[port] + UARTERR_stats.dma[port];
+}
+
+/**
+ * Clear the counters of a port (errors expected while the baud rate is searched).
+ *
+ * @param port: UARTERR_PORT_x.
+ */
+void UARTERR_Clear(uint8_t port) {
+	if (port >= UARTERR_PORTS) {
+		return;
+	}
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	UARTERR_stats.overruns[port] = 0;
+	UARTERR_stats.framing[port] = 0;
+	UARTERR_stats.noise[port] = 0;
+	UARTERR_stats.parity[port] = 0;
+	UARTERR_stats.dma[port] = 0;
+	UARTERR_stats.restarts[port] = 0;
+	UARTERR_stats.restart_errors[port] = 0;
+	__set_PRIMASK(primask);
+}
+
+const UARTERR_Stats *UARTERR_GetStats() {
+	return &UARTERR_stats;
+}
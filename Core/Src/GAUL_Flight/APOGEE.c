@@ -0,0 +1,265 @@
+/*
+ * APOGEE.c
+ *
+ * Apogee detection from the barometric altitude stream.
+ *
+ * Each sample goes through a small decision pipeline:
+ *  1. Median of 3 (single-sample pressure spikes near Mach 1 never reach the velocity),
+ *     the first 2 samples after APOGEE_Arm/APOGEE_Propagate only fill the median.
+ *  2. Outlier gate (sample must be close to the altitude predicted from the velocity)
+ *  3. Velocity from a finite difference over APOGEE_VELOCITY_WINDOW samples
+ *  4. Lockout timer and minimum altitude gates
+ *  5. Apogee is confirmed after "descending_samples" consecutive samples with a
+ *     negative velocity and an altitude below the highest altitude.
+ *
+ * Nominal detection latency (in samples after the true apogee) is
+ * 1 (median) + APOGEE_VELOCITY_WINDOW / 2 + descending_samples. Each rejected sample adds
+ * one sample, and barometer noise near apogee (velocity ~ 0) adds a few more. See
+ * APOGEE_tests.c for the measured distribution.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/APOGEE.h"
+
+#include <stddef.h>
+
+/**
+ * Fill a configuration structure with default values.
+ *
+ * @param config: pointer to a APOGEE_Config structure.
+ */
+void APOGEE_DefaultConfig(APOGEE_Config *config) {
+	config->gates = APOGEE_GATE_ALL;
+	config->descending_samples = APOGEE_DEFAULT_DESCENDING_SAMPLES;
+	config->min_alt_m = APOGEE_DEFAULT_MIN_ALT_M;
+	config->max_step_m = APOGEE_DEFAULT_MAX_STEP_M;
+	config->lockout_ms = APOGEE_DEFAULT_LOCKOUT_MS;
+}
+
+/**
+ * Initialize apogee detector. The detector does nothing until APOGEE_Arm() is called.
+ *
+ * @param detector: pointer to a APOGEE_Detector structure.
+ * @param config: pointer to a configuration, NULL to use default configuration.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t APOGEE_Init(APOGEE_Detector *detector, const APOGEE_Config *config) {
+	if (detector == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (config == NULL) {
+		APOGEE_DefaultConfig(&detector->config);
+	} else {
+		if (config->descending_samples == 0) {
+			return -1; // Error, would detect on the first sample
+		}
+		detector->config = *config;
+	}
+
+	detector->armed = 0;
+	detector->detected = 0;
+	detector->arm_time_ms = 0;
+
+	return 0; // OK
+}
+
+/**
+ * Start apogee detection. Clears all the detector history.
+ *
+ * @param detector: pointer to a APOGEE_Detector structure.
+ * @param launch_time_ms: time of launch (HAL tick), start of the lockout timer.
+ */
+void APOGEE_Arm(APOGEE_Detector *detector, uint32_t launch_time_ms) {
+	detector->armed = 1;
+	detector->detected = 0;
+	detector->arm_time_ms = launch_time_ms;
+
+	detector->median_count = 0;
+	detector->history_count = 0;
+	detector->history_index = 0;
+
+	detector->alt_m = 0;
+	detector->time_ms = launch_time_ms;
+	detector->velocity_mps = 0;
+
+	detector->max_alt_m = -1.0e9f;
+	detector->max_alt_time_ms = launch_time_ms;
+	detector->samples_since_max = 0;
+	detector->descending_count = 0;
+
+	detector->rejected_in_row = 0;
+	detector->rejected_samples = 0;
+}
+
+/**
+ * Median of 3 without sorting.
+ */
+static float APOGEE_Median3(float a, float b, float c) {
+	if (a > b) {
+		float tmp = a;
+		a = b;
+		b = tmp;
+	}
+	// a <= b
+	if (c <= a) {
+		return a;
+	}
+	if (c >= b) {
+		return b;
+	}
+	return c;
+}
+
+/**
+ * Add filtered sample to history, then update the velocity estimate.
+ */
+static void APOGEE_PushHistory(APOGEE_Detector *detector, float alt_m, uint32_t time_ms) {
+	detector->alt_history[detector->history_index] = alt_m;
+	detector->time_history[detector->history_index] = time_ms;
+	detector->history_index = (detector->history_index + 1) % (APOGEE_VELOCITY_WINDOW + 1);
+	if (detector->history_count < APOGEE_VELOCITY_WINDOW + 1) {
+		detector->history_count++;
+	}
+
+	if (detector->history_count >= 2) {
+		// Oldest sample is the next one to be overwritten when the history is full
+		uint8_t oldest = detector->history_count < APOGEE_VELOCITY_WINDOW + 1 ? 0 : detector->history_index;
+		uint32_t dt_ms = time_ms - detector->time_history[oldest];
+		if (dt_ms > 0) {
+			detector->velocity_mps = (alt_m - detector->alt_history[oldest]) * 1000.0f / (float)dt_ms;
+		}
+	}
+
+	detector->alt_m = alt_m;
+	detector->time_ms = time_ms;
+}
+
+/**
+ * Feed one barometric altitude sample to the detector.
+ *
+ * No pow/sqrt, a few soft-float operations. Execution time in PROFILER_ZONE_APOGEE_UPDATE
+ * (TASK_Baro, PROFILER_Dump).
+ *
+ * @param detector: pointer to a APOGEE_Detector structure.
+ * @param alt_m: altitude above ground in meters (BMP280 alt_m).
+ * @param time_ms: timestamp of the sample (HAL tick).
+ *
+ * @retval 1 Apogee detected, event available in detector->event
+ * @retval 0 OK, no apogee (or apogee already detected)
+ * @retval -1 ERROR, detector not armed
+ * @retval -2 Sample rejected by the outlier gate
+ */
+int8_t APOGEE_Update(APOGEE_Detector *detector, float alt_m, uint32_t time_ms) {
+	if (!detector->armed) {
+		return -1; // Error, not armed
+	}
+	if (detector->detected) {
+		return 0; // Event already produced
+	}
+
+	const APOGEE_Config *config = &detector->config;
+	float filtered = alt_m;
+
+	// 1. Median of 3
+	if (config->gates & APOGEE_GATE_MEDIAN) {
+		detector->median_buffer[0] = detector->median_buffer[1];
+		detector->median_buffer[1] = detector->median_buffer[2];
+		detector->median_buffer[2] = alt_m;
+		if (detector->median_count < 3) {
+			detector->median_count++;
+		}
+		if (detector->median_count < 3) {
+			return 0; // Filling the median, a single sample could be a spike
+		}
+		filtered = APOGEE_Median3(detector->median_buffer[0], detector->median_buffer[1], detector->median_buffer[2]);
+	}
+
+	// 2. Outlier gate, compare with altitude predicted from last accepted sample
+	// (velocity is only known with 2 samples in history)
+	if ((config->gates & APOGEE_GATE_OUTLIER) && detector->history_count >= 2) {
+		float dt_s = (float)(time_ms - detector->time_ms) / 1000.0f;
+		float error = filtered - (detector->alt_m + detector->velocity_mps * dt_s);
+		if (error > config->max_step_m || error < -config->max_step_m) {
+			detector->rejected_samples++;
+			detector->rejected_in_row++;
+			if (detector->rejected_in_row < APOGEE_MAX_REJECTED) {
+				return -2; // Sample rejected
+			}
+			// Signal really moved, restart history from this sample
+			detector->history_count = 0;
+			detector->history_index = 0;
+		}
+	}
+	detector->rejected_in_row = 0;
+
+	// 3. Velocity
+	APOGEE_PushHistory(detector, filtered, time_ms);
+
+	// Track highest altitude
+	if (filtered > detector->max_alt_m) {
+		detector->max_alt_m = filtered;
+		detector->max_alt_time_ms = time_ms;
+		detector->samples_since_max = 0;
+		detector->descending_count = 0;
+		return 0; // Still going up
+	}
+	detector->samples_since_max++;
+
+	// 4. Lockout and minimum altitude
+	if ((config->gates & APOGEE_GATE_LOCKOUT) && (time_ms - detector->arm_time_ms) < config->lockout_ms) {
+		return 0;
+	}
+	if ((config->gates & APOGEE_GATE_MIN_ALT) && detector->max_alt_m < config->min_alt_m) {
+		return 0;
+	}
+
+	// 5. Consecutive descending samples
+	if (detector->history_count >= 2 && detector->velocity_mps < 0) {
+		detector->descending_count++;
+	} else {
+		detector->descending_count = 0;
+	}
+
+	if (detector->descending_count < config->descending_samples) {
+		return 0;
+	}
+
+	detector->detected = 1;
+	detector->event.timestamp_ms = time_ms;
+	detector->event.apogee_timestamp_ms = detector->max_alt_time_ms;
+	detector->event.apogee_alt_m = detector->max_alt_m;
+	detector->event.latency_samples = detector->samples_since_max;
+
+	return 1; // Apogee
+}
+
+/**
+ * Propagate-only update, used instead of APOGEE_Update while the barometer is not
+ * trusted (Mach lock). The altitude is extrapolated with the given velocity, and the
+ * filter history is cleared so the next trusted sample restarts the pipeline without
+ * mixing in untrusted samples.
+ *
+ * @param detector: pointer to a APOGEE_Detector structure.
+ * @param velocity_mps: velocity from another source (e.g. MACHLOCK velocity_mps).
+ * @param time_ms: timestamp of the skipped sample (HAL tick).
+ */
+void APOGEE_Propagate(APOGEE_Detector *detector, float velocity_mps, uint32_t time_ms) {
+	if (!detector->armed || detector->detected) {
+		return;
+	}
+
+	detector->alt_m += velocity_mps * (float)(time_ms - detector->time_ms) / 1000.0f;
+	detector->time_ms = time_ms;
+	detector->velocity_mps = velocity_mps;
+
+	detector->median_count = 0;
+	detector->history_count = 0;
+	detector->history_index = 0;
+	detector->descending_count = 0;
+	detector->rejected_in_row = 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * FLIGHT.c
+ *
+ * Flight state machine.
+ *
+ *  PAD    -> BOOST   launch detector (LAUNCH.h), back-dated to lift-off
+ *  BOOST  -> COAST   specific force below burnout_accel for burnout_samples, or max_boost_ms
+ *  BOOST/COAST -> APOGEE  apogee detector (Mach lock gates the barometer)
+ *  APOGEE -> DROGUE  drogue_delay_ms elapsed
+ *  DROGUE -> MAIN    altitude below main_alt (pressure domain threshold)
+ *  DROGUE/MAIN -> LANDED  altitude stable for landed_time_ms
+ *
+ * Phases only go forward. The caller fires the pyro charges and logs transitions
+ * using flight->transition and flight->event, then reads the new rates.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/FLIGHT.h"
+#include "GAUL_System/PROFILER.h"
+
+#include <stddef.h>
+
+// Default acquisition periods (ms) of each phase: baro, GNSS, telemetry, log
+static const FLIGHT_Rates FLIGHT_DEFAULT_RATES[FLIGHT_PHASE_COUNT] = {
+	{  20,  200, 1000, 1000 }, // PAD: 50 Hz barometer, pre-trigger capture (BLACKBOX.h)
+	{  10,  200,  100,   10 }, // BOOST: 100 Hz, GNSS has no useful fix under thrust
+	{  10,  100,  100,   10 }, // COAST: 100 Hz until apogee, GNSS at the 10 Hz fix rate
+	{  10,  100,  100,   10 }, // APOGEE
+	{  50,  100,  200,   50 }, // DROGUE
+	{  50,  100,  200,   50 }, // MAIN
+	{1000,  200, 1000, 1000 }, // LANDED: position for the recovery team
+};
+
+static const char *FLIGHT_PHASE_NAMES[FLIGHT_PHASE_COUNT] = {
+	"pad", "boost", "coast", "apogee", "drogue", "main", "landed"
+};
+
+/**
+ * Fill a configuration structure with default values.
+ *
+ * @param config: pointer to a FLIGHT_Config structure.
+ */
+void FLIGHT_DefaultConfig(FLIGHT_Config *config) {
+	config->burnout_accel_mps2 = FLIGHT_DEFAULT_BURNOUT_ACCEL_MPS2;
+	config->burnout_samples = FLIGHT_DEFAULT_BURNOUT_SAMPLES;
+	config->max_boost_ms = FLIGHT_DEFAULT_MAX_BOOST_MS;
+	config->drogue_delay_ms = FLIGHT_DEFAULT_DROGUE_DELAY_MS;
+	config->main_alt_m = FLIGHT_DEFAULT_MAIN_ALT_M;
+	config->main_samples = FLIGHT_DEFAULT_MAIN_SAMPLES;
+	config->landed_window_m = FLIGHT_DEFAULT_LANDED_WINDOW_M;
+	config->landed_time_ms = FLIGHT_DEFAULT_LANDED_TIME_MS;
+
+	for (uint8_t i = 0; i < FLIGHT_PHASE_COUNT; i++) {
+		config->rates[i] = FLIGHT_DEFAULT_RATES[i];
+	}
+}
+
+/**
+ * Initialize the state machine on the pad.
+ *
+ * @param flight: pointer to a FLIGHT structure.
+ * @param config: pointer to a configuration, NULL to use default configuration.
+ * @param press_ref_Pa: ground reference pressure (BMP280 press_ref_Pa).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t FLIGHT_Init(FLIGHT *flight, const FLIGHT_Config *config, float press_ref_Pa) {
+	if (flight == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (config == NULL) {
+		FLIGHT_DefaultConfig(&flight->config);
+	} else {
+		if (config->burnout_samples == 0 || config->main_samples == 0) {
+			return -1; // Error, bad configuration
+		}
+		for (uint8_t i = 0; i < FLIGHT_PHASE_COUNT; i++) {
+			if (config->rates[i].baro_period_ms == 0) {
+				return -1; // Error, barometer must run in every phase
+			}
+		}
+		flight->config = *config;
+	}
+
+	if (LAUNCH_Init(&flight->launch, NULL) != 0 || APOGEE_Init(&flight->apogee, NULL) != 0
+			|| MACHLOCK_Init(&flight->lock, NULL) != 0) {
+		return -1; // Error
+	}
+
+	THRESHOLD_Init(&flight->thresholds);
+	flight->main_threshold = THRESHOLD_Add(&flight->thresholds, flight->config.main_alt_m, THRESHOLD_BELOW,
+			flight->config.main_samples);
+	if (flight->main_threshold < 0 || THRESHOLD_Arm(&flight->thresholds, press_ref_Pa) != 0) {
+		return -1; // Error
+	}
+	// Main deploy is only evaluated after apogee
+	THRESHOLD_SetEnabled(&flight->thresholds, flight->main_threshold, 0);
+
+	flight->phase = FLIGHT_PHASE_PAD;
+	flight->phase_time_ms = 0;
+	flight->launch_time_ms = 0;
+	flight->alt_m = 0;
+	flight->baro_trusted = 1;
+	flight->accel_stream = 0;
+	flight->burnout_count = 0;
+	flight->landed_ref_alt_m = 0;
+	flight->landed_ref_time_ms = 0;
+	flight->transition = 0;
+	flight->event_count = 0;
+
+	return 0; // OK
+}
+
+static void FLIGHT_Transition(FLIGHT *flight, uint8_t phase, uint8_t reason, uint32_t time_ms) {
+	flight->event.time_ms = time_ms;
+	flight->event.from = flight->phase;
+	flight->event.to = phase;
+	flight->event.reason = reason;
+	flight->event.alt_m = flight->alt_m;
+	if (flight->event_count < FLIGHT_PHASE_COUNT) {
+		flight->events[flight->event_count++] = flight->event;
+	}
+
+	flight->phase = phase;
+	flight->phase_time_ms = time_ms;
+	flight->transition = 1;
+}
+
+/**
+ * Enter boost. The launch detector works in microseconds, which wrap after 71.6 min on the
+ * pad: lift-off is the back-dating offset subtracted from the detection sample time (ms).
+ */
+static void FLIGHT_Launch(FLIGHT *flight, uint32_t detect_ms) {
+	uint8_t reason = FLIGHT_REASON_ACCEL;
+	if (flight->launch.reason == LAUNCH_REASON_BARO) {
+		reason = FLIGHT_REASON_ALTITUDE;
+	} else if (flight->launch.reason == LAUNCH_REASON_COMBINED) {
+		reason = FLIGHT_REASON_COMBINED;
+	}
+
+	flight->launch_time_ms = detect_ms - (flight->launch.backdate_us + 500) / 1000;
+	APOGEE_Arm(&flight->apogee, flight->launch_time_ms);
+	MACHLOCK_Launch(&flight->lock, flight->launch_time_ms);
+	FLIGHT_Transition(flight, FLIGHT_PHASE_BOOST, reason, flight->launch_time_ms);
+}
+
+static void FLIGHT_UpdatePad(FLIGHT *flight, const FLIGHT_Measurement *measurement) {
+	uint32_t time_us = measurement->time_ms * 1000; // Wraps, the launch detector only uses differences
+
+	// Without FLIGHT_UpdateAccel, the accelerometer comes at the barometer rate
+	if (!flight->accel_stream && measurement->has_accel
+			&& LAUNCH_UpdateAccel(&flight->launch, (int32_t)(measurement->accel_mps2 * 1000), time_us) == 1) {
+		FLIGHT_Launch(flight, measurement->time_ms);
+		return;
+	}
+	if (LAUNCH_UpdateBaro(&flight->launch, (int32_t)(measurement->alt_m * 1000), time_us) == 1) {
+		FLIGHT_Launch(flight, measurement->time_ms);
+	}
+}
+
+/**
+ * Barometer sample during boost and coast: Mach lock then apogee detector.
+ *
+ * @retval 1 Apogee detected
+ * @retval 0 No apogee
+ */
+static int8_t FLIGHT_UpdateApogee(FLIGHT *flight, const FLIGHT_Measurement *measurement) {
+	if (MACHLOCK_Update(&flight->lock, measurement->time_ms, flight->apogee.velocity_mps, measurement->accel_mps2,
+			measurement->has_accel) == 1) {
+		flight->baro_trusted = 0;
+		APOGEE_Propagate(&flight->apogee, flight->lock.velocity_mps, measurement->time_ms);
+		return 0;
+	}
+	flight->baro_trusted = 1;
+	PROFILER_BEGIN(PROFILER_ZONE_APOGEE_UPDATE);
+	int8_t apogee = APOGEE_Update(&flight->apogee, measurement->alt_m, measurement->time_ms);
+	PROFILER_END(PROFILER_ZONE_APOGEE_UPDATE);
+	return apogee == 1;
+}
+
+static void FLIGHT_UpdateLanded(FLIGHT *flight, const FLIGHT_Measurement *measurement) {
+	float delta = measurement->alt_m - flight->landed_ref_alt_m;
+	if (delta > flight->config.landed_window_m || delta < -flight->config.landed_window_m) {
+		// Still moving, restart the window here
+		flight->landed_ref_alt_m = measurement->alt_m;
+		flight->landed_ref_time_ms = measurement->time_ms;
+		return;
+	}
+	if (measurement->time_ms - flight->landed_ref_time_ms >= flight->config.landed_time_ms) {
+		FLIGHT_Transition(flight, FLIGHT_PHASE_LANDED, FLIGHT_REASON_STABLE, measurement->time_ms);
+	}
+}
+
+/**
+ * Update the state machine with a barometer sample (and accelerometer if available).
+ * Must be called at the barometer rate of the current phase (FLIGHT_GetRates).
+ *
+ * @param flight: pointer to a FLIGHT structure.
+ * @param measurement: pointer to the sample.
+ *
+ * @retval 1 Phase changed, see flight->event
+ * @retval 0 Same phase
+ */
+int8_t FLIGHT_Update(FLIGHT *flight, const FLIGHT_Measurement *measurement) {
+	uint32_t phase_ms = measurement->time_ms - flight->phase_time_ms;
+
+	flight->transition = 0;
+	flight->lock.transition = MACHLOCK_TRANSITION_NONE; // Mach lock transitions of this sample only
+	flight->alt_m = measurement->alt_m;
+
+	switch (flight->phase) {
+	case FLIGHT_PHASE_PAD:
+		FLIGHT_UpdatePad(flight, measurement);
+		break;
+
+	case FLIGHT_PHASE_BOOST:
+		if (FLIGHT_UpdateApogee(flight, measurement)) {
+			FLIGHT_Transition(flight, FLIGHT_PHASE_APOGEE, FLIGHT_REASON_APOGEE, measurement->time_ms);
+			break;
+		}
+		if (measurement->has_accel && measurement->accel_mps2 < flight->config.burnout_accel_mps2) {
+			flight->burnout_count++;
+		} else {
+			flight->burnout_count = 0;
+		}
+		if (flight->burnout_count >= flight->config.burnout_samples) {
+			FLIGHT_Transition(flight, FLIGHT_PHASE_COAST, FLIGHT_REASON_ACCEL, measurement->time_ms);
+		} else if (phase_ms >= flight->config.max_boost_ms) {
+			FLIGHT_Transition(flight, FLIGHT_PHASE_COAST, FLIGHT_REASON_TIMEOUT, measurement->time_ms);
+		}
+		break;
+
+	case FLIGHT_PHASE_COAST:
+		if (FLIGHT_UpdateApogee(flight, measurement)) {
+			FLIGHT_Transition(flight, FLIGHT_PHASE_APOGEE, FLIGHT_REASON_APOGEE, measurement->time_ms);
+		}
+		break;
+
+	case FLIGHT_PHASE_APOGEE:
+		if (phase_ms >= flight->config.drogue_delay_ms) {
+			FLIGHT_Transition(flight, FLIGHT_PHASE_DROGUE, FLIGHT_REASON_DELAY, measurement->time_ms);
+			THRESHOLD_SetEnabled(&flight->thresholds, flight->main_threshold, 1);
+			flight->landed_ref_alt_m = measurement->alt_m;
+			flight->landed_ref_time_ms = measurement->time_ms;
+		}
+		break;
+
+	case FLIGHT_PHASE_DROGUE:
+		if (THRESHOLD_Update(&flight->thresholds, measurement->press_Pa_Q8) & (1 << flight->main_threshold)) {
+			FLIGHT_Transition(flight, FLIGHT_PHASE_MAIN, FLIGHT_REASON_ALTITUDE, measurement->time_ms);
+			break;
+		}
+		FLIGHT_UpdateLanded(flight, measurement);
+		break;
+
+	case FLIGHT_PHASE_MAIN:
+		FLIGHT_UpdateLanded(flight, measurement);
+		break;
+
+	default:
+		break;
+	}
+
+	return flight->transition;
+}
+
+/**
+ * Give an accelerometer sample to the launch detector. Call on every sample (1 kHz), the time
+ * base must be the one of FLIGHT_Update (time_ms * 1000, wrapping at 2^32 us). Once called,
+ * FLIGHT_Update no longer gives its accelerometer sample to the launch detector.
+ *
+ * @param flight: pointer to a FLIGHT structure.
+ * @param accel_mms2: vertical specific force in mm/s^2 (+1g on the pad).
+ * @param time_us: time of the sample.
+ * @param time_ms: time of the sample in the time base of FLIGHT_Update (does not wrap in flight).
+ *
+ * @retval 1 Launch detected (phase changed to boost), see flight->event
+ * @retval 0 Same phase
+ */
+int8_t FLIGHT_UpdateAccel(FLIGHT *flight, int32_t accel_mms2, uint32_t time_us, uint32_t time_ms) {
+	flight->transition = 0;
+	flight->lock.transition = MACHLOCK_TRANSITION_NONE;
+	flight->accel_stream = 1;
+
+	if (flight->phase == FLIGHT_PHASE_PAD && LAUNCH_UpdateAccel(&flight->launch, accel_mms2, time_us) == 1) {
+		FLIGHT_Launch(flight, time_ms);
+	}
+	return flight->transition;
+}
+
+/**
+ * @return acquisition periods of the current phase
+ */
+const FLIGHT_Rates *FLIGHT_GetRates(const FLIGHT *flight) {
+	return &flight->config.rates[flight->phase];
+}
+
+/**
+ * @return name of a phase for logs, "?" if unknown
+ */
+const char *FLIGHT_PhaseName(uint8_t phase) {
+	if (phase >= FLIGHT_PHASE_COUNT) {
+		return "?";
+	}
+	return FLIGHT_PHASE_NAMES[phase];
+}
@@ -0,0 +1,393 @@
+/*
+ * FUSION.c
+ *
+ * Vertical state estimator, third order complementary filter (steady-state Kalman filter
+ * of an altitude/velocity/bias model):
+ *  - Predict: the accelerometer minus gravity minus the bias estimate is integrated into
+ *    the velocity and the altitude at every accelerometer sample.
+ *  - Update: the barometer innovation (measured - estimated altitude at the time of the
+ *    sample) corrects altitude, velocity and bias with gains 3w.T, 3w^2.T and w^3.T,
+ *    T being the time covered by the sample. The three poles stay at -w whatever the
+ *    barometer rate, so the rate can change with the flight phase.
+ *
+ * Everything runs in integers (no soft-float at 1 kHz): altitude and velocity in Q32.32,
+ * acceleration, bias and barometer altitude in Q16.16, time steps in Q0.32 seconds.
+ * The floating point configuration is only converted by FUSION_Init.
+ *
+ * Samples are ordered by their timestamp:
+ *  - a barometer sample older than the state is applied at its time on the altitude history,
+ *    then the correction is propagated to the present (the filter is linear, no replay).
+ *  - a barometer sample newer than the state waits in a queue until the accelerometer
+ *    reaches its time. Without accelerometer (queue full or FUSION_IMU_TIMEOUT_US), the
+ *    state is propagated without acceleration measurement: -bias becomes the acceleration
+ *    estimate and the filter tracks the barometer alone.
+ *  - an accelerometer sample older than the state is ignored.
+ *
+ * The accelerometer axis is taken as vertical (tilt is not estimated), the bias state absorbs
+ * slow errors. See FUSION_tests.c for the comparison with a double precision reference.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/FUSION.h"
+
+#include <stddef.h>
+
+#define FUSION_GRAVITY_Q16 ((int32_t)((int64_t)FUSION_GRAVITY_MMS2 * 65536 / 1000))
+
+static void FUSION_Advance(FUSION *fusion, int32_t accel_q16, uint32_t time_us);
+static int8_t FUSION_Apply(FUSION *fusion, const FUSION_Baro *baro);
+
+/**
+ * Milli-units (mm, mm/s, mm/s^2) to Q16.16.
+ */
+static int32_t FUSION_MilliToQ16(int32_t milli) {
+	return (int32_t)(((int64_t)milli * 4294967 + (1 << 15)) >> 16); // 2^32 / 1000
+}
+
+/**
+ * Q16.16 to milli-units.
+ */
+static int32_t FUSION_Q16ToMilli(int64_t q16) {
+	return (int32_t)((q16 * 1000 + (1 << 15)) >> 16);
+}
+
+/**
+ * Microseconds (< 1 s) to Q0.32 seconds.
+ */
+static uint32_t FUSION_UsToQ32(uint32_t us) {
+	return (uint32_t)(((uint64_t)us * 281474977 + (1 << 15)) >> 16); // 2^48 / 10^6
+}
+
+/**
+ * Fill a configuration structure with default values.
+ *
+ * @param config: pointer to a FUSION_Config structure.
+ */
+void FUSION_DefaultConfig(FUSION_Config *config) {
+	config->omega_rad_s = FUSION_DEFAULT_OMEGA_RAD_S;
+	config->locked_omega_rad_s = FUSION_DEFAULT_LOCKED_OMEGA_RAD_S;
+	config->gate_m = FUSION_DEFAULT_GATE_M;
+}
+
+/**
+ * Initialize the estimator. The state is seeded by the first barometer sample.
+ *
+ * @param fusion: pointer to a FUSION structure.
+ * @param config: pointer to a configuration, NULL to use default configuration.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t FUSION_Init(FUSION *fusion, const FUSION_Config *config) {
+	if (fusion == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (config == NULL) {
+		FUSION_DefaultConfig(&fusion->config);
+	} else {
+		if (config->omega_rad_s <= 0 || config->omega_rad_s > 10.0f || config->locked_omega_rad_s < 0
+				|| config->locked_omega_rad_s > config->omega_rad_s || config->gate_m <= 0 || config->gate_m > 1000.0f) {
+			return -1; // Error, gains out of the fixed point range
+		}
+		fusion->config = *config;
+	}
+	fusion->omega_q16 = (int32_t)(fusion->config.omega_rad_s * 65536.0f);
+	fusion->locked_omega_q16 = (int32_t)(fusion->config.locked_omega_rad_s * 65536.0f);
+	fusion->gate_q16 = (int32_t)(fusion->config.gate_m * 65536.0f);
+
+	fusion->started = 0;
+	fusion->initialized = 0;
+	fusion->time_us = 0;
+	fusion->alt_q32 = 0;
+	fusion->vel_q32 = 0;
+	fusion->bias_q16 = 0;
+	fusion->accel_q16 = 0;
+	fusion->baro_time_us = 0;
+	fusion->baro_period_us = 0;
+	fusion->rejected_in_row = 0;
+	fusion->history_index = 0;
+	fusion->history_count = 0;
+	fusion->queue_count = 0;
+	fusion->stats = (FUSION_Stats) { 0 };
+
+	return 0; // OK
+}
+
+/**
+ * Integrate one accelerometer sample.
+ *
+ * @param fusion: pointer to a FUSION structure.
+ * @param accel_mms2: specific force along the vertical axis (+1 g at rest) in mm/s^2.
+ * @param time_us: time of the sample.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR (sample older than the state, ignored)
+ */
+int8_t FUSION_Predict(FUSION *fusion, int32_t accel_mms2, uint32_t time_us) {
+	if (fusion == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (!fusion->started) {
+		fusion->started = 1;
+		fusion->time_us = time_us;
+		return 0; // OK, time origin
+	}
+	if ((int32_t)(time_us - fusion->time_us) <= 0) {
+		fusion->stats.imu_late++;
+		return -1; // Error, late sample
+	}
+
+	FUSION_Advance(fusion, FUSION_MilliToQ16(accel_mms2), time_us);
+	fusion->stats.predictions++;
+
+	return 0; // OK
+}
+
+/**
+ * Give a barometric altitude. Applied now if the accelerometer already reached its time,
+ * queued otherwise.
+ *
+ * @param fusion: pointer to a FUSION structure.
+ * @param alt_mm: barometric altitude (AGL) in mm.
+ * @param time_us: time of the measurement.
+ * @param trusted: 0 while the barometer is untrusted (Mach lock), uses the locked crossover.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR (sample older than the altitude history, ignored)
+ */
+int8_t FUSION_UpdateBaro(FUSION *fusion, int32_t alt_mm, uint32_t time_us, uint8_t trusted) {
+	if (fusion == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	FUSION_Baro baro = {
+		.time_us = time_us,
+		.alt_q16 = FUSION_MilliToQ16(alt_mm),
+		.trusted = trusted,
+	};
+
+	if (!fusion->started) {
+		fusion->started = 1;
+		fusion->time_us = time_us;
+	}
+	if ((int32_t)(time_us - fusion->time_us) <= 0) {
+		return FUSION_Apply(fusion, &baro);
+	}
+
+	// Ahead of the accelerometer
+	if (fusion->queue_count == FUSION_BARO_QUEUE) {
+		fusion->stats.baro_only++;
+		FUSION_Advance(fusion, FUSION_GRAVITY_Q16, fusion->queue[0].time_us);
+	}
+	uint8_t i = fusion->queue_count;
+	while (i > 0 && (int32_t)(fusion->queue[i - 1].time_us - time_us) > 0) {
+		fusion->queue[i] = fusion->queue[i - 1];
+		i--;
+	}
+	fusion->queue[i] = baro;
+	fusion->queue_count++;
+	fusion->stats.baro_queued++;
+
+	if ((int32_t)(time_us - fusion->time_us) > FUSION_IMU_TIMEOUT_US) {
+		fusion->stats.baro_only++;
+		FUSION_Advance(fusion, FUSION_GRAVITY_Q16, time_us);
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Latest state in integer units.
+ *
+ * @param fusion: pointer to a FUSION structure.
+ * @param state: pointer to the state to fill.
+ */
+void FUSION_GetState(const FUSION *fusion, FUSION_State *state) {
+	state->time_us = fusion->time_us;
+	state->alt_mm = FUSION_Q16ToMilli(fusion->alt_q32 >> 16);
+	state->vel_mms = FUSION_Q16ToMilli(fusion->vel_q32 >> 16);
+	state->accel_mms2 = FUSION_Q16ToMilli(fusion->accel_q16);
+	state->bias_mms2 = FUSION_Q16ToMilli(fusion->bias_q16);
+}
+
+/**
+ * Add the current altitude to the history.
+ */
+static void FUSION_PushHistory(FUSION *fusion) {
+	fusion->history[fusion->history_index].time_us = fusion->time_us;
+	fusion->history[fusion->history_index].alt_q16 = (int32_t)(fusion->alt_q32 >> 16);
+	fusion->history_index = (fusion->history_index + 1) % FUSION_HISTORY_SIZE;
+	if (fusion->history_count < FUSION_HISTORY_SIZE) {
+		fusion->history_count++;
+	}
+}
+
+/**
+ * One integration step (trapezoidal on the velocity).
+ */
+static void FUSION_Step(FUSION *fusion, int32_t accel_q16, uint32_t dt_us) {
+	fusion->time_us += dt_us;
+	if (!fusion->initialized) {
+		return;
+	}
+
+	uint32_t dt_q32 = FUSION_UsToQ32(dt_us);
+	int32_t accel = accel_q16 - FUSION_GRAVITY_Q16 - fusion->bias_q16;
+	int64_t dv_q32 = ((int64_t)accel * dt_q32) >> 16;
+	int64_t vel_mid_q32 = fusion->vel_q32 + (dv_q32 >> 1);
+
+	fusion->alt_q32 += ((vel_mid_q32 >> 16) * dt_q32) >> 16;
+	fusion->vel_q32 += dv_q32;
+	fusion->accel_q16 = accel;
+	FUSION_PushHistory(fusion);
+}
+
+/**
+ * Integrate up to time_us with a constant acceleration, applying the queued barometer
+ * samples on the way.
+ */
+static void FUSION_Advance(FUSION *fusion, int32_t accel_q16, uint32_t time_us) {
+	int32_t remaining = (int32_t)(time_us - fusion->time_us);
+
+	while (remaining > 0) {
+		uint32_t step = remaining > FUSION_MAX_STEP_US ? FUSION_MAX_STEP_US : (uint32_t)remaining;
+		FUSION_Step(fusion, accel_q16, step);
+		remaining -= step;
+
+		while (fusion->queue_count > 0 && (int32_t)(fusion->queue[0].time_us - fusion->time_us) <= 0) {
+			FUSION_Apply(fusion, &fusion->queue[0]);
+			fusion->queue_count--;
+			for (uint8_t i = 0; i < fusion->queue_count; i++) {
+				fusion->queue[i] = fusion->queue[i + 1];
+			}
+		}
+	}
+}
+
+/**
+ * Estimated altitude at a past time, interpolated in the history.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR (older than the history)
+ */
+static int8_t FUSION_AltitudeAt(const FUSION *fusion, uint32_t time_us, int32_t *alt_q16) {
+	uint8_t newer = (fusion->history_index + FUSION_HISTORY_SIZE - 1) % FUSION_HISTORY_SIZE;
+
+	for (uint8_t k = 1; k < fusion->history_count; k++) {
+		uint8_t older = (newer + FUSION_HISTORY_SIZE - 1) % FUSION_HISTORY_SIZE;
+		const FUSION_History *a = &fusion->history[older];
+		const FUSION_History *b = &fusion->history[newer];
+		int32_t from_a = (int32_t)(time_us - a->time_us);
+		if (from_a >= 0) {
+			int32_t span = (int32_t)(b->time_us - a->time_us);
+			*alt_q16 = a->alt_q16 + (int32_t)((int64_t)(b->alt_q16 - a->alt_q16) * from_a / span);
+			return 0; // OK
+		}
+		newer = older;
+	}
+
+	return -1; // Error, too old
+}
+
+/**
+ * Correction made at time_us, as seen later (elapsed_us after): a bias change is an
+ * acceleration change for the elapsed time.
+ */
+static void FUSION_Propagate(int64_t dalt_q32, int64_t dvel_q32, int32_t dbias_q16, uint32_t elapsed_us,
+		int64_t *alt_q32, int64_t *vel_q32) {
+	uint32_t dt_q32 = FUSION_UsToQ32(elapsed_us);
+	int64_t dv_q16 = ((int64_t)dbias_q16 * dt_q32) >> 32;
+
+	*alt_q32 = dalt_q32 + (((dvel_q32 >> 16) * dt_q32) >> 16) - (((dv_q16 * dt_q32) >> 16) >> 1);
+	*vel_q32 = dvel_q32 - (dv_q16 << 16);
+}
+
+/**
+ * Barometer correction at the time of the sample (not newer than the state).
+ *
+ * @retval 0 OK (applied or rejected by the gate)
+ * @retval -1 ERROR (older than the history)
+ */
+static int8_t FUSION_Apply(FUSION *fusion, const FUSION_Baro *baro) {
+	if (!fusion->initialized) {
+		// First sample, the rocket is at rest
+		fusion->initialized = 1;
+		fusion->alt_q32 = (int64_t)baro->alt_q16 << 16;
+		fusion->vel_q32 = 0;
+		fusion->bias_q16 = 0;
+		fusion->accel_q16 = 0;
+		fusion->baro_time_us = baro->time_us;
+		fusion->history_index = 0;
+		fusion->history_count = 0;
+		FUSION_PushHistory(fusion);
+		fusion->stats.baro_updates++;
+		return 0; // OK
+	}
+
+	int32_t predicted_q16;
+	if (baro->time_us == fusion->time_us) {
+		predicted_q16 = (int32_t)(fusion->alt_q32 >> 16);
+	} else if (FUSION_AltitudeAt(fusion, baro->time_us, &predicted_q16) != 0) {
+		fusion->stats.baro_late++;
+		return -1; // Error, too old
+	}
+
+	// Time covered by this sample (a sample older than the last one keeps the last period)
+	int32_t period = (int32_t)(baro->time_us - fusion->baro_time_us);
+	if (period > 0) {
+		fusion->baro_time_us = baro->time_us;
+		fusion->baro_period_us = period > FUSION_MAX_PERIOD_US ? FUSION_MAX_PERIOD_US : (uint32_t)period;
+	}
+
+	// Gate, opened again when the barometer really moved (a clipped innovation would
+	// saturate the loop and make it oscillate)
+	int32_t innovation = baro->alt_q16 - predicted_q16;
+	if (innovation > fusion->gate_q16 || innovation < -fusion->gate_q16) {
+		if (++fusion->rejected_in_row <= FUSION_MAX_REJECTED) {
+			fusion->stats.baro_rejected++;
+			return 0; // OK, rejected
+		}
+	} else {
+		fusion->rejected_in_row = 0;
+	}
+
+	// Gains of the triple pole at -omega for this period
+	int64_t omega = baro->trusted ? fusion->omega_q16 : fusion->locked_omega_q16;
+	int64_t wt_q16 = (omega * FUSION_UsToQ32(fusion->baro_period_us)) >> 32;
+	int64_t k1_q16 = 3 * wt_q16;
+	int64_t k2_q16 = (3 * omega * wt_q16) >> 16;
+	int64_t k3_q16 = (((omega * omega) >> 16) * wt_q16) >> 16;
+	if (k1_q16 > 65536) {
+		k1_q16 = 65536;
+	}
+	int64_t dalt_q32 = innovation * k1_q16;
+	int64_t dvel_q32 = innovation * k2_q16;
+	int32_t dbias_q16 = -(int32_t)((innovation * k3_q16) >> 16);
+
+	// Correct the history after the sample, then the state
+	int64_t alt_q32;
+	int64_t vel_q32;
+	for (uint8_t k = 1; k <= fusion->history_count; k++) {
+		FUSION_History *entry = &fusion->history[(fusion->history_index + FUSION_HISTORY_SIZE - k) % FUSION_HISTORY_SIZE];
+		int32_t elapsed = (int32_t)(entry->time_us - baro->time_us);
+		if (elapsed >= 0) {
+			FUSION_Propagate(dalt_q32, dvel_q32, dbias_q16, elapsed, &alt_q32, &vel_q32);
+			entry->alt_q16 += (int32_t)(alt_q32 >> 16);
+		}
+	}
+	FUSION_Propagate(dalt_q32, dvel_q32, dbias_q16, fusion->time_us - baro->time_us, &alt_q32, &vel_q32);
+	fusion->alt_q32 += alt_q32;
+	fusion->vel_q32 += vel_q32;
+	fusion->bias_q16 += dbias_q16;
+
+	fusion->stats.baro_updates++;
+	if (baro->time_us != fusion->time_us) {
+		fusion->stats.baro_retro++;
+	}
+
+	return 0; // OK
+}
@@ -0,0 +1,324 @@
+/*
+ * GEO.c
+ *
+ * Fixed-point geodesy around the pad, for the dead reckoning (TRACK), the telemetry and the
+ * recovery (range and bearing from the pad), without soft-float sin/cos/atan2:
+ *  - Angles: binary angles (2^32 per turn), sine and cosine by CORDIC in rotation mode,
+ *    range and bearing by CORDIC in vectoring mode (GEO_CORDIC_ITERATIONS shifts and
+ *    additions, the gain is removed with one multiplication).
+ *  - Pad (GEO_SetPad): meridian and prime vertical radii of WGS84 at the pad latitude
+ *    (series of e^2 sin^2, exact to 1e-9), in cm per 1e-7 degree, with their change along
+ *    the latitude and the meridian convergence. Computed once per pad fix.
+ *  - Offsets (GEO_ToLocal): the radii at the middle latitude between the pad and the point
+ *    (linear in the latitude difference), then a rotation by half the meridian convergence
+ *    so the bearing is the azimuth at the pad. This is the tangent plane of the pad to the
+ *    second order (azimuthal equidistant): the distance is the distance on the ellipsoid.
+ *  - GEO_ToGlobal inverts GEO_ToLocal with Newton iterations (64 bit divisions).
+ * Valid up to about 100 km from the pad, the error bounds are in GEO.h.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/GEO.h"
+
+#include <stddef.h>
+
+#define GEO_ONE_Q30             1073741824LL
+#define GEO_TURN                4294967296LL // 360 degrees, binary angle
+#define GEO_QUARTER_TURN        0x40000000L  // 90 degrees, binary angle
+#define GEO_HALF_TURN           0x80000000UL
+#define GEO_CORDIC_INV_GAIN_Q30 652032874LL  // 1 / prod(sqrt(1 + 2^-2i)), Q30
+#define GEO_A_Q30               1195283931LL // WGS84 semi-major axis (cm) per 1e-7 degree (rad), Q30
+#define GEO_E2_Q30              7188036LL    // WGS84 first eccentricity squared, Q30
+#define GEO_RAD_PER_E7DEG_Q54   31441057LL   // pi / 1.8e9, Q54
+#define GEO_INVERSE_ITERATIONS  3            // Newton, the error is divided by ~1000 each time
+
+// atan(2^-i) in binary angle
+static const int32_t GEO_ATAN[GEO_CORDIC_ITERATIONS] = {
+	536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+	2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+	10430, 5215, 2608, 1304, 652, 326, 163, 81,
+	41, 20, 10, 5, 3, 1,
+};
+
+/**
+ * Division rounded to the nearest (den > 0).
+ */
+static int64_t GEO_Round(int64_t num, int64_t den) {
+	return num >= 0 ? (num + den / 2) / den : (num - den / 2) / den;
+}
+
+/**
+ * Right shift rounded to the nearest.
+ */
+static int64_t GEO_Shift(int64_t value, uint8_t shift) {
+	return (value + (1LL << (shift - 1))) >> shift;
+}
+
+/**
+ * Saturated to the int32_t range.
+ */
+static int32_t GEO_Saturate(int64_t value) {
+	if (value > INT32_MAX) {
+		return INT32_MAX;
+	}
+	if (value < INT32_MIN) {
+		return INT32_MIN;
+	}
+	return (int32_t)value;
+}
+
+/**
+ * Longitude difference in -180 to 180 degrees (across the antimeridian).
+ */
+static int64_t GEO_Wrap(int64_t longitude_e7) {
+	if (longitude_e7 > 1800000000) {
+		longitude_e7 -= 3600000000LL;
+	} else if (longitude_e7 < -1800000000) {
+		longitude_e7 += 3600000000LL;
+	}
+	return longitude_e7;
+}
+
+/**
+ * Cosine and sine of a binary angle, Q30 (CORDIC rotation mode, error < 2e-8).
+ */
+static void GEO_Rotate(uint32_t angle, int32_t *cos_q30, int32_t *sin_q30) {
+	int32_t sign = 1;
+	int32_t z = (int32_t)angle; // -180 to 180 degrees
+	if (z > GEO_QUARTER_TURN || z < -GEO_QUARTER_TURN) {
+		z = (int32_t)(angle + GEO_HALF_TURN); // Opposite angle, in the convergence range
+		sign = -1;
+	}
+
+	int32_t x = GEO_CORDIC_INV_GAIN_Q30;
+	int32_t y = 0;
+	for (uint8_t i = 0; i < GEO_CORDIC_ITERATIONS; i++) {
+		int32_t dx = y >> i;
+		int32_t dy = x >> i;
+		if (z >= 0) {
+			x -= dx;
+			y += dy;
+			z -= GEO_ATAN[i];
+		} else {
+			x += dx;
+			y -= dy;
+			z += GEO_ATAN[i];
+		}
+	}
+	*cos_q30 = sign * x;
+	*sin_q30 = sign * y;
+}
+
+/**
+ * Latitude and longitude differences (1e-7 degree) to East-North (cm), not saturated.
+ */
+static void GEO_Forward(const GEO *geo, int64_t latitude_e7, int64_t longitude_e7, int64_t *east_cm,
+		int64_t *north_cm) {
+	int64_t north_scale = geo->north_q30 + ((geo->north_slope * latitude_e7) >> 24);
+	int64_t east_scale = geo->east_q30 + ((geo->east_slope * latitude_e7) >> 24);
+	int64_t north = GEO_Shift(latitude_e7 * north_scale, 30);
+	int64_t east = GEO_Shift(longitude_e7 * east_scale, 30);
+	int64_t delta_q30 = (geo->convergence * longitude_e7) >> 24; // rad
+	int64_t cos_q30 = GEO_ONE_Q30 - GEO_Shift(delta_q30 * delta_q30, 31);
+
+	*east_cm = GEO_Shift(east * cos_q30 - north * delta_q30, 30);
+	*north_cm = GEO_Shift(north * cos_q30 + east * delta_q30, 30);
+}
+
+/**
+ * Set the origin of the frame (last fix on the pad). About 200 64 bit operations.
+ *
+ * @param geo: pointer to a GEO structure.
+ * @param latitude_e7: pad latitude (1e-7 degree), within GEO_MAX_LATITUDE_E7.
+ * @param longitude_e7: pad longitude.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t GEO_SetPad(GEO *geo, int32_t latitude_e7, int32_t longitude_e7) {
+	int32_t cos_q30, sin_q30;
+
+	if (geo == NULL) {
+		return -1; // Error, NULL structure
+	}
+	if (latitude_e7 > GEO_MAX_LATITUDE_E7 || latitude_e7 < -GEO_MAX_LATITUDE_E7 || longitude_e7 > 1800000000
+			|| longitude_e7 < -1800000000) {
+		return -1; // Error, out of range
+	}
+
+	GEO_Rotate((uint32_t)GEO_Round(latitude_e7 * GEO_TURN, 3600000000LL), &cos_q30, &sin_q30);
+	int64_t s = sin_q30;
+	int64_t c = cos_q30;
+
+	// e^2 sin^2, then the radii: a / sqrt(1 - x) and a (1 - e^2) / (1 - x)^3/2
+	int64_t x = (GEO_E2_Q30 * ((s * s) >> 30)) >> 30;
+	int64_t x2 = (x * x) >> 30;
+	int64_t x3 = (x2 * x) >> 30;
+	int64_t x4 = (x3 * x) >> 30;
+	int64_t g1 = GEO_ONE_Q30 + x / 2 + 3 * x2 / 8 + 5 * x3 / 16 + 35 * x4 / 128;
+	int64_t g3 = GEO_ONE_Q30 + 3 * x / 2 + 15 * x2 / 8 + 35 * x3 / 16 + 315 * x4 / 128;
+	int64_t prime_q30 = (GEO_A_Q30 * g1) >> 30;
+	int64_t north_q30 = (((GEO_A_Q30 * (GEO_ONE_Q30 - GEO_E2_Q30)) >> 30) * g3) >> 30;
+	int64_t east_q30 = (prime_q30 * c) >> 30;
+
+	// Changes per radian of latitude: M' = M 3 e^2 sin cos / (1 - x), (N cos)' = N cos e^2 sin cos / (1 - x) - N sin
+	int64_t h = (((GEO_E2_Q30 * s) >> 30) * c) >> 30;
+	h += (h * x) >> 30;
+	int64_t north_rad = (north_q30 * 3 * h) >> 30;
+	int64_t east_rad = ((east_q30 * h) >> 30) - ((prime_q30 * s) >> 30);
+
+	geo->latitude_e7 = latitude_e7;
+	geo->longitude_e7 = longitude_e7;
+	geo->north_q30 = (int32_t)north_q30;
+	geo->east_q30 = (int32_t)east_q30;
+	geo->north_slope = (int32_t)((north_rad * GEO_RAD_PER_E7DEG_Q54) >> 31); // Half: middle latitude
+	geo->east_slope = (int32_t)((east_rad * GEO_RAD_PER_E7DEG_Q54) >> 31);
+	geo->convergence = (int32_t)((s * GEO_RAD_PER_E7DEG_Q54) >> 31);
+
+	return 0; // OK
+}
+
+/**
+ * Latitude and longitude to East-North from the pad. 9 64 bit multiplications.
+ *
+ * @param geo: pointer to a GEO structure (GEO_SetPad).
+ * @param latitude_e7: 1e-7 degree.
+ * @param longitude_e7: 1e-7 degree.
+ * @param east_cm: offset from the pad, saturated (about 21000 km).
+ * @param north_cm: offset from the pad, saturated.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t GEO_ToLocal(const GEO *geo, int32_t latitude_e7, int32_t longitude_e7, int32_t *east_cm, int32_t *north_cm) {
+	int64_t east, north;
+
+	if (geo == NULL || east_cm == NULL || north_cm == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	GEO_Forward(geo, (int64_t)latitude_e7 - geo->latitude_e7, GEO_Wrap((int64_t)longitude_e7 - geo->longitude_e7),
+			&east, &north);
+	*east_cm = GEO_Saturate(east);
+	*north_cm = GEO_Saturate(north);
+
+	return 0; // OK
+}
+
+/**
+ * East-North from the pad to latitude and longitude (inverse of GEO_ToLocal, the round trip
+ * is within 1e-7 degree).
+ *
+ * @param geo: pointer to a GEO structure (GEO_SetPad).
+ * @param east_cm: offset from the pad.
+ * @param north_cm: offset from the pad.
+ * @param latitude_e7: 1e-7 degree.
+ * @param longitude_e7: 1e-7 degree, -180 to 180 degrees.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR (NULL structure, or too far from the pad)
+ */
+int8_t GEO_ToGlobal(const GEO *geo, int32_t east_cm, int32_t north_cm, int32_t *latitude_e7, int32_t *longitude_e7) {
+	int64_t latitude = 0;
+	int64_t longitude = 0;
+
+	if (geo == NULL || latitude_e7 == NULL || longitude_e7 == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	for (uint8_t i = 0; i < GEO_INVERSE_ITERATIONS; i++) {
+		int64_t east, north;
+		GEO_Forward(geo, latitude, longitude, &east, &north);
+		int64_t north_scale = geo->north_q30 + ((geo->north_slope * latitude) >> 24);
+		int64_t east_scale = geo->east_q30 + ((geo->east_slope * latitude) >> 24);
+		if (north_scale <= 0 || east_scale <= 0) {
+			return -1; // Error, too far from the pad
+		}
+		latitude += GEO_Round((north_cm - north) * GEO_ONE_Q30, north_scale);
+		longitude += GEO_Round((east_cm - east) * GEO_ONE_Q30, east_scale);
+	}
+
+	latitude += geo->latitude_e7;
+	if (latitude > 900000000 || latitude < -900000000) {
+		return -1; // Error, beyond a pole
+	}
+	*latitude_e7 = (int32_t)latitude;
+	*longitude_e7 = (int32_t)GEO_Wrap(GEO_Wrap(geo->longitude_e7 + longitude));
+
+	return 0; // OK
+}
+
+/**
+ * Range and bearing of an East-North offset (CORDIC vectoring mode). Error of the range
+ * < 5e-8 of the range after the rounding to 1 cm, bearing rounded to 0.01 degree.
+ *
+ * @param east_cm: offset from the pad.
+ * @param north_cm: offset from the pad.
+ * @param range_cm: horizontal distance.
+ * @param bearing_cdeg: 0 to 35999 (0.01 degree), clockwise from true north, 0 at the pad.
+ */
+void GEO_RangeBearing(int32_t east_cm, int32_t north_cm, uint32_t *range_cm, uint16_t *bearing_cdeg) {
+	int64_t x = north_cm;
+	int64_t y = east_cm;
+	uint32_t z = 0;
+	int8_t shift = 0;
+
+	if (x < 0) {
+		x = -x; // Rotated by 180 degrees, in the convergence range
+		y = -y;
+		z = GEO_HALF_TURN;
+	}
+	uint64_t magnitude = (uint64_t)(x > (y >= 0 ? y : -y) ? x : (y >= 0 ? y : -y));
+	if (magnitude == 0) {
+		*range_cm = 0;
+		*bearing_cdeg = 0;
+		return;
+	}
+
+	// Normalized to 2^28 to 2^29: the gain (1.65) and the additions stay within int32_t
+	while (magnitude >= (1UL << 29)) {
+		magnitude >>= 1;
+		shift--;
+	}
+	while (magnitude < (1UL << 28)) {
+		magnitude <<= 1;
+		shift++;
+	}
+	int32_t xs = (int32_t)(shift >= 0 ? x * (1LL << shift) : GEO_Shift(x, -shift));
+	int32_t ys = (int32_t)(shift >= 0 ? y * (1LL << shift) : GEO_Shift(y, -shift));
+
+	for (uint8_t i = 0; i < GEO_CORDIC_ITERATIONS; i++) {
+		int32_t dx = ys >> i;
+		int32_t dy = xs >> i;
+		if (ys > 0) {
+			xs += dx;
+			ys -= dy;
+			z += GEO_ATAN[i];
+		} else {
+			xs -= dx;
+			ys += dy;
+			z -= GEO_ATAN[i];
+		}
+	}
+
+	*range_cm = (uint32_t)GEO_Shift(xs * GEO_CORDIC_INV_GAIN_Q30, 30 + shift);
+	uint32_t bearing = (uint32_t)(((uint64_t)z * 36000 + GEO_HALF_TURN) >> 32);
+	*bearing_cdeg = bearing >= 36000 ? 0 : bearing;
+}
+
+/**
+ * Sine and cosine (CORDIC rotation mode, error < 2e-8).
+ *
+ * @param angle_cdeg: 0.01 degree, any value.
+ * @param sin_q30: sine, Q30.
+ * @param cos_q30: cosine, Q30.
+ */
+void GEO_SinCos(int32_t angle_cdeg, int32_t *sin_q30, int32_t *cos_q30) {
+	angle_cdeg %= 36000;
+	if (angle_cdeg < 0) {
+		angle_cdeg += 36000;
+	}
+	GEO_Rotate((uint32_t)GEO_Round(angle_cdeg * GEO_TURN, 36000), cos_q30, sin_q30);
+}
@@ -0,0 +1,316 @@
+/*
+ * LAUNCH.c
+ *
+ * Launch detection, three paths:
+ *  - Accelerometer: specific force above accel_mps2 for accel_min_ms with velocity_mps
+ *    gained (integral of force - gravity). Pad handling shocks are strong but too short to
+ *    gain velocity, vibrations average to nothing. Detection in ~25 ms at 6g.
+ *  - Combined: specific force above liftoff_mps2 (thrust too low for the accelerometer
+ *    path) for combined_ms, confirmed by combined_alt_m on the barometer.
+ *  - Barometer (no accelerometer): altitude above alt_gain_m for hold_ms, climbing by
+ *    rise_m, the second half of the hold not slower than half the first. A wind gust on
+ *    the static port jumps and settles, the rocket keeps climbing.
+ *
+ * Lift-off is back-dated, the caller recovers the samples before it from the pre-trigger
+ * capture (BLACKBOX_Trigger). With the accelerometer, lift-off is the first sample of the
+ * run above liftoff_mps2 containing the detection, tracked as the samples come (O(1)).
+ * With the barometer alone, it is extrapolated from the pad band exit and the detection
+ * sample, assuming a constant acceleration (altitude grows as t^2).
+ *
+ * Accelerometer samples are integers (no soft-float at 1 kHz), the only float operations
+ * are in LAUNCH_Init and the barometer back-dating, done once.
+ * See LAUNCH_tests.c for the latency and false positive benchmark.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/LAUNCH.h"
+
+#include <math.h>
+#include <stddef.h>
+
+static int8_t LAUNCH_Detect(LAUNCH *launch, uint8_t reason, uint32_t launch_time_us, uint32_t time_us) {
+	launch->launched = 1;
+	launch->reason = reason;
+	launch->launch_time_us = launch_time_us;
+	launch->detect_time_us = time_us;
+	launch->backdate_us = time_us - launch_time_us; // Wrap-safe
+	return 1;
+}
+
+/**
+ * Fill a configuration structure with default values.
+ *
+ * @param config: pointer to a LAUNCH_Config structure.
+ */
+void LAUNCH_DefaultConfig(LAUNCH_Config *config) {
+	config->accel_mps2 = LAUNCH_DEFAULT_ACCEL_MPS2;
+	config->accel_min_ms = LAUNCH_DEFAULT_ACCEL_MIN_MS;
+	config->velocity_mps = LAUNCH_DEFAULT_VELOCITY_MPS;
+	config->liftoff_mps2 = LAUNCH_DEFAULT_LIFTOFF_MPS2;
+	config->dropout_ms = LAUNCH_DEFAULT_DROPOUT_MS;
+	config->alt_gain_m = LAUNCH_DEFAULT_ALT_GAIN_M;
+	config->hold_ms = LAUNCH_DEFAULT_HOLD_MS;
+	config->rise_m = LAUNCH_DEFAULT_RISE_M;
+	config->pad_band_m = LAUNCH_DEFAULT_PAD_BAND_M;
+	config->combined_ms = LAUNCH_DEFAULT_COMBINED_MS;
+	config->combined_alt_m = LAUNCH_DEFAULT_COMBINED_ALT_M;
+}
+
+/**
+ * Initialize the detector on the pad.
+ *
+ * @param launch: pointer to a LAUNCH structure.
+ * @param config: pointer to a configuration, NULL to use default configuration.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t LAUNCH_Init(LAUNCH *launch, const LAUNCH_Config *config) {
+	if (launch == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (config == NULL) {
+		LAUNCH_DefaultConfig(&launch->config);
+	} else {
+		if (config->liftoff_mps2 * 1000.0f <= LAUNCH_GRAVITY_MMS2 || config->accel_mps2 < config->liftoff_mps2
+				|| config->accel_mps2 > 1000.0f || config->velocity_mps <= 0 || config->velocity_mps > 100.0f
+				|| config->pad_band_m <= 0 || config->alt_gain_m <= config->pad_band_m || config->alt_gain_m > 1000.0f
+				|| config->combined_alt_m <= 0 || config->rise_m < 0 || config->hold_ms == 0) {
+			return -1; // Error, bad configuration
+		}
+		launch->config = *config;
+	}
+	launch->accel_mms2 = (int32_t)(launch->config.accel_mps2 * 1000.0f);
+	launch->accel_min_us = (uint32_t)launch->config.accel_min_ms * 1000;
+	launch->velocity_ums = (int32_t)(launch->config.velocity_mps * 1000000.0f);
+	launch->liftoff_mms2 = (int32_t)(launch->config.liftoff_mps2 * 1000.0f);
+	launch->dropout_us = (uint32_t)launch->config.dropout_ms * 1000;
+	launch->alt_gain_mm = (int32_t)(launch->config.alt_gain_m * 1000.0f);
+	launch->hold_us = (uint32_t)launch->config.hold_ms * 1000;
+	launch->rise_mm = (int32_t)(launch->config.rise_m * 1000.0f);
+	launch->pad_band_mm = (int32_t)(launch->config.pad_band_m * 1000.0f);
+	launch->combined_us = (uint32_t)launch->config.combined_ms * 1000;
+	launch->combined_alt_mm = (int32_t)(launch->config.combined_alt_m * 1000.0f);
+
+	launch->launched = 0;
+	launch->reason = LAUNCH_REASON_NONE;
+	launch->launch_time_us = 0;
+	launch->detect_time_us = 0;
+	launch->backdate_us = 0;
+
+	launch->accel_started = 0;
+	launch->accel_time_us = 0;
+	launch->rise = 0;
+	launch->rise_start_us = 0;
+	launch->rise_last_us = 0;
+	launch->candidate = 0;
+	launch->candidate_start_us = 0;
+	launch->candidate_last_us = 0;
+	launch->velocity = 0;
+
+	launch->baro_started = 0;
+	launch->baro_time_us = 0;
+	launch->ref_q8 = 0;
+	launch->gain_mm = 0;
+	launch->exit_time_us = 0;
+	launch->exit_gain_mm = 0;
+	launch->on_pad = 1;
+	launch->climb = 0;
+	launch->climb_start_us = 0;
+	launch->climb_start_mm = 0;
+	launch->climb_mid_mm = 0;
+	launch->climb_has_mid = 0;
+
+	launch->stats = (LAUNCH_Stats) { 0 };
+
+	return 0; // OK
+}
+
+/**
+ * Accelerometer sample. Samples not newer than the previous one are ignored.
+ *
+ * @param launch: pointer to a LAUNCH structure.
+ * @param accel_mms2: vertical specific force in mm/s^2 (+1g on the pad).
+ * @param time_us: time of the sample.
+ *
+ * @retval 1 Launch detected, see launch->launch_time_us
+ * @retval 0 No launch (or already detected)
+ */
+int8_t LAUNCH_UpdateAccel(LAUNCH *launch, int32_t accel_mms2, uint32_t time_us) {
+	if (launch->launched) {
+		return 0;
+	}
+
+	uint32_t dt_us = 0;
+	if (launch->accel_started) {
+		int32_t delta = (int32_t)(time_us - launch->accel_time_us);
+		if (delta <= 0) {
+			return 0; // Old sample
+		}
+		dt_us = delta > LAUNCH_MAX_GAP_US ? LAUNCH_MAX_GAP_US : (uint32_t)delta;
+	}
+	launch->accel_started = 1;
+	launch->accel_time_us = time_us;
+
+	// Run above lift-off level, its first sample is the lift-off time
+	if (accel_mms2 >= launch->liftoff_mms2) {
+		if (!launch->rise) {
+			launch->rise = 1;
+			launch->rise_start_us = time_us;
+		}
+		launch->rise_last_us = time_us;
+	} else if (launch->rise && time_us - launch->rise_last_us > launch->dropout_us) {
+		launch->rise = 0;
+	}
+
+	// Run above the launch threshold, velocity gained since its start
+	if (accel_mms2 >= launch->accel_mms2) {
+		if (!launch->candidate) {
+			launch->candidate = 1;
+			launch->candidate_start_us = time_us;
+			launch->velocity = 0;
+			launch->stats.accel_candidates++;
+		} else {
+			launch->velocity += (int32_t)((int64_t)(accel_mms2 - LAUNCH_GRAVITY_MMS2) * dt_us / 1000);
+		}
+		launch->candidate_last_us = time_us;
+	} else if (launch->candidate) {
+		if (time_us - launch->candidate_last_us > launch->dropout_us) {
+			launch->candidate = 0;
+			launch->stats.accel_rejected++; // Shock or vibration
+			return 0;
+		}
+		launch->velocity += (int32_t)((int64_t)(accel_mms2 - LAUNCH_GRAVITY_MMS2) * dt_us / 1000);
+	}
+
+	if (launch->candidate && time_us - launch->candidate_start_us >= launch->accel_min_us
+			&& launch->velocity >= launch->velocity_ums) {
+		return LAUNCH_Detect(launch, LAUNCH_REASON_ACCEL, launch->rise_start_us, time_us);
+	}
+	return 0;
+}
+
+/**
+ * Lift-off estimate from the barometer alone: constant acceleration from rest, so sqrt(altitude)
+ * is linear in time, through the pad band exit and the detection sample.
+ */
+static uint32_t LAUNCH_BaroLiftoff(const LAUNCH *launch, uint32_t time_us) {
+	float exit_root = sqrtf((float)launch->exit_gain_mm);
+	float root = sqrtf((float)launch->gain_mm);
+	uint32_t climb_us = time_us - launch->exit_time_us;
+
+	uint32_t backdate_us = LAUNCH_MAX_BACKDATE_US;
+	if (climb_us < LAUNCH_MAX_BACKDATE_US && root > exit_root) {
+		float before_us = (float)climb_us * exit_root / (root - exit_root);
+		if (before_us + climb_us < LAUNCH_MAX_BACKDATE_US) {
+			backdate_us = climb_us + (uint32_t)before_us;
+		}
+	}
+	return time_us - backdate_us;
+}
+
+/**
+ * Barometer sample. Samples not newer than the previous one are ignored.
+ *
+ * @param launch: pointer to a LAUNCH structure.
+ * @param alt_mm: barometric altitude in mm (AGL, |alt| < 8 km).
+ * @param time_us: time of the sample.
+ *
+ * @retval 1 Launch detected, see launch->launch_time_us
+ * @retval 0 No launch (or already detected)
+ */
+int8_t LAUNCH_UpdateBaro(LAUNCH *launch, int32_t alt_mm, uint32_t time_us) {
+	if (launch->launched) {
+		return 0;
+	}
+	if (launch->baro_started && (int32_t)(time_us - launch->baro_time_us) <= 0) {
+		return 0; // Old sample
+	}
+	if (!launch->baro_started) {
+		launch->baro_started = 1;
+		launch->ref_q8 = alt_mm * 256;
+	}
+	launch->baro_time_us = time_us;
+
+	int32_t gain = alt_mm - (launch->ref_q8 >> 8);
+	launch->gain_mm = gain;
+
+	// Pad reference follows the weather in the pad band, taken again after a long time out of
+	// the band without launch (rocket moved)
+	if (gain <= launch->pad_band_mm && gain >= -launch->pad_band_mm) {
+		launch->ref_q8 += (alt_mm * 256 - launch->ref_q8) >> LAUNCH_REF_SHIFT;
+	} else if (!launch->on_pad && !launch->climb && time_us - launch->exit_time_us >= LAUNCH_REBASE_US) {
+		launch->ref_q8 = alt_mm * 256;
+		gain = 0;
+		launch->gain_mm = 0;
+	}
+
+	if (gain <= launch->pad_band_mm) {
+		launch->on_pad = 1;
+	} else if (launch->on_pad) {
+		launch->on_pad = 0;
+		launch->exit_time_us = time_us;
+		launch->exit_gain_mm = gain;
+	}
+
+	// Low thrust: accelerometer run above lift-off level, confirmed by the altitude
+	if (launch->rise && (int32_t)(time_us - launch->rise_last_us) < LAUNCH_ACCEL_TIMEOUT_US
+			&& launch->rise_last_us - launch->rise_start_us >= launch->combined_us && gain >= launch->combined_alt_mm) {
+		return LAUNCH_Detect(launch, LAUNCH_REASON_COMBINED, launch->rise_start_us, time_us);
+	}
+
+	if (gain < launch->alt_gain_mm) {
+		if (launch->climb) {
+			launch->climb = 0;
+			launch->stats.baro_rejected++; // Fell back, gust
+		}
+		return 0;
+	}
+
+	if (!launch->climb) {
+		launch->climb = 1;
+		launch->climb_start_us = time_us;
+		launch->climb_start_mm = gain;
+		launch->climb_has_mid = 0;
+		launch->stats.baro_candidates++;
+		return 0;
+	}
+
+	uint32_t elapsed_us = time_us - launch->climb_start_us;
+	if (!launch->climb_has_mid && elapsed_us >= launch->hold_us / 2) {
+		launch->climb_mid_mm = gain;
+		launch->climb_has_mid = 1;
+	}
+	if (elapsed_us < launch->hold_us) {
+		return 0;
+	}
+
+	int32_t first = launch->climb_mid_mm - launch->climb_start_mm;
+	int32_t second = gain - launch->climb_mid_mm;
+	if (gain - launch->climb_start_mm >= launch->rise_mm && 2 * second >= first) {
+		return LAUNCH_Detect(launch, LAUNCH_REASON_BARO, LAUNCH_BaroLiftoff(launch, time_us), time_us);
+	}
+
+	// Stopped climbing (gust settled on the static port), start a new hold here
+	launch->stats.baro_rejected++;
+	launch->stats.baro_candidates++;
+	launch->climb_start_us = time_us;
+	launch->climb_start_mm = gain;
+	launch->climb_has_mid = 0;
+	return 0;
+}
+
+/**
+ * Tell if no detection path is in progress, e.g. before stalling the CPU on the pad.
+ *
+ * @param launch: pointer to a LAUNCH structure.
+ *
+ * @retval 1 No thrust run, altitude in the pad band, not launched
+ * @retval 0 Launched or a detection may be in progress
+ */
+uint8_t LAUNCH_IsIdle(const LAUNCH *launch) {
+	return !launch->launched && !launch->rise && !launch->candidate && launch->on_pad && !launch->climb;
+}
@@ -0,0 +1,171 @@
+/*
+ * MACHLOCK.c
+ *
+ * Mach lock, decides if the barometer can be trusted.
+ *
+ * The lock is entered at launch (or if the trusted velocity reaches the enter threshold
+ * before launch was detected) and left when:
+ *  - with accelerometer: velocity propagated from the accelerometer is below the exit
+ *    threshold and min_lock_ms elapsed. A missing sample is replaced by the last one, a
+ *    single dropout while supersonic must not unlock.
+ *  - without accelerometer for accel_timeout_ms: min_lock_ms elapsed (timer lock).
+ *  - in any case: max_lock_ms elapsed, so the barometer is always trusted near apogee.
+ *
+ * There is only one lock window per flight: once unlocked, the rocket only slows down,
+ * and a noisy velocity right after unlock must not lock again.
+ * Transitions only depend on the inputs, so replaying the same samples always gives the
+ * same lock window. The caller logs transitions using lock->transition and lock->reason.
+ *
+ * While locked, the caller gives the altitude estimators a propagate-only update
+ * (e.g. APOGEE_Propagate) instead of the barometer measurement.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/MACHLOCK.h"
+
+#include <stddef.h>
+
+/**
+ * Fill a configuration structure with default values.
+ *
+ * @param config: pointer to a MACHLOCK_Config structure.
+ */
+void MACHLOCK_DefaultConfig(MACHLOCK_Config *config) {
+	config->min_lock_ms = MACHLOCK_DEFAULT_MIN_LOCK_MS;
+	config->max_lock_ms = MACHLOCK_DEFAULT_MAX_LOCK_MS;
+	config->enter_velocity_mps = MACHLOCK_DEFAULT_ENTER_VELOCITY_MPS;
+	config->exit_velocity_mps = MACHLOCK_DEFAULT_EXIT_VELOCITY_MPS;
+	config->accel_timeout_ms = MACHLOCK_DEFAULT_ACCEL_TIMEOUT_MS;
+}
+
+/**
+ * Initialize Mach lock in idle state (barometer trusted).
+ *
+ * @param lock: pointer to a MACHLOCK structure.
+ * @param config: pointer to a configuration, NULL to use default configuration.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t MACHLOCK_Init(MACHLOCK *lock, const MACHLOCK_Config *config) {
+	if (lock == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (config == NULL) {
+		MACHLOCK_DefaultConfig(&lock->config);
+	} else {
+		if (config->min_lock_ms > config->max_lock_ms || config->exit_velocity_mps > config->enter_velocity_mps) {
+			return -1; // Error, inconsistent configuration
+		}
+		lock->config = *config;
+	}
+
+	lock->state = MACHLOCK_STATE_IDLE;
+	lock->time_ms = 0;
+	lock->velocity_mps = 0;
+	lock->has_accel = 0;
+	lock->accel_mps2 = 0;
+	lock->accel_time_ms = 0;
+	lock->transition = MACHLOCK_TRANSITION_NONE;
+	lock->reason = MACHLOCK_REASON_NONE;
+	lock->enter_time_ms = 0;
+	lock->exit_time_ms = 0;
+	lock->untrusted_samples = 0;
+
+	return 0; // OK
+}
+
+static void MACHLOCK_Enter(MACHLOCK *lock, uint32_t time_ms, float velocity_mps, uint8_t reason) {
+	lock->state = MACHLOCK_STATE_LOCKED;
+	lock->velocity_mps = velocity_mps;
+	lock->enter_time_ms = time_ms;
+	lock->transition = MACHLOCK_TRANSITION_ENTER;
+	lock->reason = reason;
+}
+
+static void MACHLOCK_Exit(MACHLOCK *lock, uint32_t time_ms, uint8_t reason) {
+	lock->state = MACHLOCK_STATE_UNLOCKED;
+	lock->exit_time_ms = time_ms;
+	lock->transition = MACHLOCK_TRANSITION_EXIT;
+	lock->reason = reason;
+}
+
+/**
+ * Enter the lock at lift-off. Velocity is 0 at this time.
+ *
+ * @param lock: pointer to a MACHLOCK structure.
+ * @param launch_time_ms: time of launch (HAL tick).
+ */
+void MACHLOCK_Launch(MACHLOCK *lock, uint32_t launch_time_ms) {
+	if (lock->state != MACHLOCK_STATE_IDLE) {
+		return; // Already launched
+	}
+	lock->time_ms = launch_time_ms;
+	MACHLOCK_Enter(lock, launch_time_ms, 0, MACHLOCK_REASON_LAUNCH);
+}
+
+/**
+ * Update Mach lock on a barometer sample, tells if the sample can be trusted.
+ *
+ * @param lock: pointer to a MACHLOCK structure.
+ * @param time_ms: timestamp of the barometer sample (HAL tick).
+ * @param velocity_mps: trusted vertical velocity estimate (only used while unlocked).
+ * @param accel_mps2: vertical specific force from the accelerometer (1g on the pad).
+ * @param has_accel: 1 if accel_mps2 is valid, 0 otherwise.
+ *
+ * @retval 0 Barometer trusted
+ * @retval 1 Barometer untrusted (locked)
+ */
+int8_t MACHLOCK_Update(MACHLOCK *lock, uint32_t time_ms, float velocity_mps, float accel_mps2, uint8_t has_accel) {
+	uint32_t dt_ms = time_ms - lock->time_ms;
+	lock->time_ms = time_ms;
+	lock->transition = MACHLOCK_TRANSITION_NONE;
+
+	if (lock->state == MACHLOCK_STATE_UNLOCKED) {
+		return 0; // Trusted
+	}
+
+	if (lock->state == MACHLOCK_STATE_IDLE) {
+		// Launch missed, lock if the barometer velocity says we are getting close to Mach 1
+		if (velocity_mps > lock->config.enter_velocity_mps) {
+			MACHLOCK_Enter(lock, time_ms, velocity_mps, MACHLOCK_REASON_VELOCITY);
+			lock->untrusted_samples++;
+			return 1; // Untrusted
+		}
+		return 0; // Trusted
+	}
+
+	if (has_accel) {
+		lock->has_accel = 1;
+		lock->accel_mps2 = accel_mps2;
+		lock->accel_time_ms = time_ms;
+	}
+	uint8_t accel_mode = lock->has_accel && time_ms - lock->accel_time_ms < lock->config.accel_timeout_ms;
+
+	// Propagate velocity, accelerometer measures specific force (gravity not included)
+	if (accel_mode) {
+		lock->velocity_mps += (lock->accel_mps2 - MACHLOCK_GRAVITY) * (float)dt_ms / 1000.0f;
+	}
+
+	uint32_t locked_ms = time_ms - lock->enter_time_ms;
+	if (locked_ms >= lock->config.max_lock_ms) {
+		MACHLOCK_Exit(lock, time_ms, MACHLOCK_REASON_TIMEOUT);
+		return 0; // Trusted
+	}
+	if (locked_ms >= lock->config.min_lock_ms) {
+		if (!accel_mode) {
+			MACHLOCK_Exit(lock, time_ms, MACHLOCK_REASON_TIMER);
+			return 0; // Trusted
+		}
+		if (lock->velocity_mps < lock->config.exit_velocity_mps) {
+			MACHLOCK_Exit(lock, time_ms, MACHLOCK_REASON_VELOCITY);
+			return 0; // Trusted
+		}
+	}
+
+	lock->untrusted_samples++;
+	return 1; // Untrusted
+}
@@ -0,0 +1,201 @@
+/*
+ * THRESHOLD.c
+ *
+ * Altitude event thresholds evaluated in the pressure domain.
+ *
+ * BMP280_PressureToAltitude() is monotonic (altitude goes down when pressure goes up),
+ * so "altitude > h" is the same as "pressure < p(h)". Instead of calling pow() on every
+ * sample (0.2ms), the bound p(h) is found once at arm time by a binary search on the
+ * Q24.8 pressure, using BMP280_PressureToAltitude itself. The decision on every possible
+ * BMP280 pressure value is then exactly the same as the altitude-domain comparison.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/THRESHOLD.h"
+
+#include "GAUL_Drivers/BMP280.h"
+
+#include <stddef.h>
+
+/**
+ * Initialize an empty threshold engine.
+ *
+ * @param engine: pointer to a THRESHOLD_Engine structure.
+ */
+void THRESHOLD_Init(THRESHOLD_Engine *engine) {
+	engine->size = 0;
+	engine->armed = 0;
+	engine->press_ref_Pa = 0;
+}
+
+/**
+ * Add an altitude threshold. Must be called before THRESHOLD_Arm.
+ *
+ * @param engine: pointer to a THRESHOLD_Engine structure.
+ * @param alt_m: altitude threshold above ground (meters).
+ * @param direction: THRESHOLD_ABOVE or THRESHOLD_BELOW.
+ * @param samples: consecutive samples beyond the threshold needed to trigger (1 or more).
+ *
+ * @return id of the threshold (0 to THRESHOLD_MAX - 1), bit "1 << id" in THRESHOLD_Update
+ * @retval -1 ERROR, engine full, already armed or bad parameter
+ */
+int8_t THRESHOLD_Add(THRESHOLD_Engine *engine, float alt_m, uint8_t direction, uint8_t samples) {
+	if (engine->armed || engine->size >= THRESHOLD_MAX) {
+		return -1; // Error
+	}
+	if ((direction != THRESHOLD_ABOVE && direction != THRESHOLD_BELOW) || samples == 0) {
+		return -1; // Error, bad parameter
+	}
+
+	THRESHOLD *threshold = &engine->thresholds[engine->size];
+	threshold->alt_m = alt_m;
+	threshold->direction = direction;
+	threshold->samples = samples;
+	threshold->enabled = 1;
+	threshold->count = 0;
+	threshold->triggered = 0;
+	threshold->press_Pa_Q8 = 0;
+
+	return engine->size++;
+}
+
+/**
+ * Altitude of a Q24.8 pressure, exactly like BMP280_ReadAltitude calculates it.
+ */
+static float THRESHOLD_Altitude(uint32_t press_Pa_Q8, float press_ref_Pa) {
+	return BMP280_PressureToAltitude((float)press_Pa_Q8 / (float)(1 << 8), press_ref_Pa);
+}
+
+/**
+ * Convert all thresholds to pressure bounds. Calls BMP280_PressureToAltitude ~30 times
+ * per threshold (binary search), takes ~6ms per threshold.
+ *
+ * @param engine: pointer to a THRESHOLD_Engine structure.
+ * @param press_ref_Pa: ground reference pressure (BMP280 press_ref_Pa).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, bad reference pressure
+ */
+int8_t THRESHOLD_Arm(THRESHOLD_Engine *engine, float press_ref_Pa) {
+	if (!(press_ref_Pa > 0)) {
+		return -1; // Error, bad reference
+	}
+
+	for (uint8_t i = 0; i < engine->size; i++) {
+		THRESHOLD *threshold = &engine->thresholds[i];
+		uint32_t low = THRESHOLD_PRESS_MIN_Q8;
+		uint32_t high = THRESHOLD_PRESS_MAX_Q8;
+
+		if (threshold->direction == THRESHOLD_ABOVE) {
+			// Smallest pressure with altitude <= threshold, "above" is pressure < bound
+			while (low < high) {
+				uint32_t mid = low + (high - low) / 2;
+				if (THRESHOLD_Altitude(mid, press_ref_Pa) <= threshold->alt_m) {
+					high = mid;
+				} else {
+					low = mid + 1;
+				}
+			}
+		} else {
+			// Largest pressure with altitude >= threshold, "below" is pressure > bound
+			while (low < high) {
+				uint32_t mid = low + (high - low + 1) / 2;
+				if (THRESHOLD_Altitude(mid, press_ref_Pa) >= threshold->alt_m) {
+					low = mid;
+				} else {
+					high = mid - 1;
+				}
+			}
+		}
+
+		threshold->press_Pa_Q8 = low;
+		threshold->count = 0;
+		threshold->triggered = 0;
+	}
+
+	engine->press_ref_Pa = press_ref_Pa;
+	engine->armed = 1;
+
+	return 0; // OK
+}
+
+/**
+ * Enable or disable a threshold. A "below" threshold is true on the pad, so it is only
+ * enabled once the rocket is above it (e.g. main deploy after apogee).
+ *
+ * @param engine: pointer to a THRESHOLD_Engine structure.
+ * @param id: threshold id returned by THRESHOLD_Add.
+ * @param enabled: 1 to evaluate the threshold, 0 to ignore it.
+ */
+void THRESHOLD_SetEnabled(THRESHOLD_Engine *engine, int8_t id, uint8_t enabled) {
+	if (id < 0 || id >= engine->size) {
+		return;
+	}
+	engine->thresholds[id].enabled = enabled;
+	engine->thresholds[id].count = 0;
+}
+
+/**
+ * Compare a pressure with one threshold, same result as comparing
+ * BMP280_PressureToAltitude(pressure) with the altitude threshold.
+ *
+ * @retval 1 Beyond threshold
+ * @retval 0 Not beyond threshold
+ */
+uint8_t THRESHOLD_Compare(const THRESHOLD *threshold, uint32_t press_Pa_Q8) {
+	if (threshold->direction == THRESHOLD_ABOVE) {
+		return press_Pa_Q8 < threshold->press_Pa_Q8;
+	}
+	return press_Pa_Q8 > threshold->press_Pa_Q8;
+}
+
+/**
+ * Evaluate all thresholds on a pressure sample.
+ *
+ * Takes less than 0.01ms to complete (integer comparisons only)
+ *
+ * @param engine: pointer to a THRESHOLD_Engine structure.
+ * @param press_Pa_Q8: compensated pressure (BMP280 press_Pa_Q8).
+ *
+ * @return bit mask of the thresholds triggered by this sample (bit "1 << id"), 0 if none
+ */
+uint8_t THRESHOLD_Update(THRESHOLD_Engine *engine, uint32_t press_Pa_Q8) {
+	uint8_t events = 0;
+
+	if (!engine->armed) {
+		return 0;
+	}
+
+	for (uint8_t i = 0; i < engine->size; i++) {
+		THRESHOLD *threshold = &engine->thresholds[i];
+		if (threshold->triggered || !threshold->enabled) {
+			continue;
+		}
+
+		if (THRESHOLD_Compare(threshold, press_Pa_Q8)) {
+			threshold->count++;
+		} else {
+			threshold->count = 0;
+		}
+
+		if (threshold->count >= threshold->samples) {
+			threshold->triggered = 1;
+			events |= 1 << i;
+		}
+	}
+
+	return events;
+}
+
+/**
+ * @retval 1 Threshold already triggered
+ * @retval 0 Not triggered or bad id
+ */
+uint8_t THRESHOLD_IsTriggered(THRESHOLD_Engine *engine, int8_t id) {
+	if (id < 0 || id >= engine->size) {
+		return 0;
+	}
+	return engine->thresholds[id].triggered;
+}
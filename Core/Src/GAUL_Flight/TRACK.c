@@ -0,0 +1,357 @@
+/*
+ * TRACK.c
+ *
+ * GNSS dead reckoning between the fixes, for the telemetry and the log (10 to 50 Hz) while
+ * the fixes come at 1 to 10 Hz:
+ *  - Frame: East-North-Up in cm from the pad (TRACK_SetPad, or the first fix), tangent plane
+ *    of the pad on WGS84 (GEO), with the range and bearing from the pad.
+ *  - Horizontal: the last fix is moved with the velocity of its speed and course over ground,
+ *    plus the acceleration between the oldest and the newest velocity of the history for
+ *    at most accel_ms (boost), then at constant velocity.
+ *  - Vertical: the last altitude (GGA) is moved with the velocity between the oldest and
+ *    the newest altitude of the history, the NMEA sentences have no vertical speed.
+ *  - Blending: when a fix arrives, the difference between the previous estimate and the
+ *    new one (at the time of the update) is kept and decreases to 0 over blend_ms, so the
+ *    estimate is continuous. A difference larger than snap_m is not blended (reacquisition).
+ *  - Extrapolation is held after max_age_ms, the estimate gives the age of the fix.
+ *
+ * Everything runs in integers (no soft-float at the telemetry rate): positions in cm,
+ * velocities in cm/s, angles in 0.01 degree with the CORDIC of GEO. The floating
+ * point configuration is only converted by TRACK_Init. See TRACK_tests.c for the error
+ * against the fix rate on synthetic trajectories.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/TRACK.h"
+
+#include <stddef.h>
+
+/**
+ * Division rounded to the nearest (den > 0).
+ */
+static int32_t TRACK_Round(int64_t num, int32_t den) {
+	return (int32_t)(num >= 0 ? (num + den / 2) / den : (num - den / 2) / den);
+}
+
+/**
+ * Position "dt_ms" after the fix: velocity, plus the acceleration for at most accel_ms.
+ */
+static int32_t TRACK_Extrapolate(int32_t position_cm, int32_t velocity_cms, int32_t accel_cms2, int32_t dt_ms,
+		int32_t accel_ms) {
+	int32_t accel_dt_ms = dt_ms < accel_ms ? dt_ms : accel_ms;
+	int64_t moved = (int64_t)velocity_cms * dt_ms * 1000 // 1e-6 cm
+			+ (int64_t)accel_cms2 * accel_dt_ms * (2 * dt_ms - accel_dt_ms) / 2;
+	return position_cm + TRACK_Round(moved, 1000000);
+}
+
+/**
+ * Part of a blend offset left at "now_ms".
+ */
+static int32_t TRACK_Blend(int32_t offset_cm, uint32_t start_ms, uint32_t now_ms, uint16_t blend_ms) {
+	int32_t elapsed = (int32_t)(now_ms - start_ms);
+	if (offset_cm == 0 || elapsed >= blend_ms) {
+		return 0;
+	}
+	if (elapsed < 0) {
+		elapsed = 0; // Asked before the update
+	}
+	return TRACK_Round((int64_t)offset_cm * (blend_ms - elapsed), blend_ms);
+}
+
+/**
+ * Time since "time_ms", 0 if before.
+ */
+static uint32_t TRACK_Age(uint32_t time_ms, uint32_t now_ms) {
+	int32_t age = (int32_t)(now_ms - time_ms);
+	return age > 0 ? (uint32_t)age : 0;
+}
+
+/**
+ * Fill a configuration structure with default values.
+ *
+ * @param config: pointer to a TRACK_Config structure.
+ */
+void TRACK_DefaultConfig(TRACK_Config *config) {
+	config->blend_ms = TRACK_DEFAULT_BLEND_MS;
+	config->snap_m = TRACK_DEFAULT_SNAP_M;
+	config->accel_ms = TRACK_DEFAULT_ACCEL_MS;
+	config->max_age_ms = TRACK_DEFAULT_MAX_AGE_MS;
+}
+
+/**
+ * Initialize the dead reckoning. The pad is the first fix unless set by TRACK_SetPad.
+ *
+ * @param track: pointer to a TRACK structure.
+ * @param config: pointer to a configuration, NULL to use default configuration.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t TRACK_Init(TRACK *track, const TRACK_Config *config) {
+	if (track == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (config == NULL) {
+		TRACK_DefaultConfig(&track->config);
+	} else {
+		if (config->snap_m <= 0 || config->snap_m > 100000.0f || config->max_age_ms == 0) {
+			return -1; // Error, out of the integer range
+		}
+		track->config = *config;
+	}
+	track->snap_cm = (int32_t)(track->config.snap_m * 100.0f);
+
+	track->padded = 0;
+	track->pad_altitude = 0;
+	track->started = 0;
+	track->altitude_started = 0;
+	track->blend_east_cm = 0;
+	track->blend_north_cm = 0;
+	track->blend_up_cm = 0;
+	track->velocity_index = 0;
+	track->velocity_count = 0;
+	track->altitude_index = 0;
+	track->altitude_count = 0;
+	track->stats = (TRACK_Stats) { 0 };
+
+	return 0; // OK
+}
+
+/**
+ * Move the origin of the frame to a fix (last fix on the pad). The state is moved with it,
+ * the estimated latitude and longitude do not change.
+ *
+ * @param track: pointer to a TRACK structure.
+ * @param fix: new origin, its altitude when valid.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t TRACK_SetPad(TRACK *track, const TRACK_Fix *fix) {
+	if (track == NULL || fix == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	GEO previous = track->geo;
+	if (GEO_SetPad(&track->geo, fix->latitude_e7, fix->longitude_e7) != 0) {
+		return -1; // Error, pad out of range
+	}
+	if (track->padded && track->started) {
+		int32_t latitude_e7, longitude_e7;
+		GEO_ToGlobal(&previous, track->east_cm, track->north_cm, &latitude_e7, &longitude_e7);
+		GEO_ToLocal(&track->geo, latitude_e7, longitude_e7, &track->east_cm, &track->north_cm);
+	}
+	track->padded = 1;
+
+	if (fix->altitude) {
+		if (track->pad_altitude) {
+			int32_t shift_cm = fix->altitude_cm - track->pad_altitude_cm;
+			track->up_cm -= shift_cm;
+			for (uint8_t i = 0; i < TRACK_HISTORY; i++) {
+				track->altitudes[i].up_cm -= shift_cm;
+			}
+		}
+		track->pad_altitude_cm = fix->altitude_cm;
+		track->pad_altitude = 1;
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Give a fix. The horizontal part is applied when newer than the last one, the altitude
+ * when altitude_ms is newer than the last altitude (the GGA may be read after the RMC).
+ *
+ * @param track: pointer to a TRACK structure.
+ * @param fix: fix in integer units (see TRACK_Fix).
+ * @param now_ms: HAL tick of the update, the blend starts at this time.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR (nothing newer, ignored)
+ */
+int8_t TRACK_Update(TRACK *track, const TRACK_Fix *fix, uint32_t now_ms) {
+	TRACK_Estimate before;
+	uint8_t applied = 0;
+
+	if (track == NULL || fix == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (!track->padded && TRACK_SetPad(track, fix) != 0) {
+		return -1; // Error, no pad
+	}
+	int8_t estimated = TRACK_Predict(track, now_ms, &before);
+
+	if (!track->started || (int32_t)(fix->time_ms - track->time_ms) > 0) {
+		int32_t east_cm, north_cm;
+		GEO_ToLocal(&track->geo, fix->latitude_e7, fix->longitude_e7, &east_cm, &north_cm);
+
+		// Prediction error of the previous fix
+		if (track->started) {
+			TRACK_Estimate predicted;
+			TRACK_Predict(track, fix->time_ms, &predicted);
+			int32_t error_east = predicted.east_cm - east_cm;
+			int32_t error_north = predicted.north_cm - north_cm;
+			track->stats.last_correction_cm = (error_east >= 0 ? error_east : -error_east)
+					+ (error_north >= 0 ? error_north : -error_north);
+			if (track->stats.last_correction_cm > track->stats.max_correction_cm) {
+				track->stats.max_correction_cm = track->stats.last_correction_cm;
+			}
+		}
+
+		// Velocity, acceleration over the history
+		TRACK_Velocity *velocity = &track->velocities[track->velocity_index];
+		velocity->time_ms = fix->time_ms;
+		int32_t sin_q30, cos_q30;
+		GEO_SinCos(fix->course_cdeg, &sin_q30, &cos_q30);
+		velocity->ve_cms = TRACK_Round((int64_t)fix->speed_cms * sin_q30, 1073741824);
+		velocity->vn_cms = TRACK_Round((int64_t)fix->speed_cms * cos_q30, 1073741824);
+		track->velocity_index = (track->velocity_index + 1) & (TRACK_HISTORY - 1);
+		if (track->velocity_count < TRACK_HISTORY) {
+			track->velocity_count++;
+		}
+		const TRACK_Velocity *oldest = &track->velocities[(track->velocity_index - track->velocity_count) & (TRACK_HISTORY - 1)];
+		int32_t span_ms = (int32_t)(fix->time_ms - oldest->time_ms);
+		if (span_ms >= TRACK_MIN_SPAN_MS && span_ms <= track->config.max_age_ms) {
+			track->ae_cms2 = TRACK_Round((int64_t)(velocity->ve_cms - oldest->ve_cms) * 1000, span_ms);
+			track->an_cms2 = TRACK_Round((int64_t)(velocity->vn_cms - oldest->vn_cms) * 1000, span_ms);
+		} else {
+			track->ae_cms2 = 0;
+			track->an_cms2 = 0;
+		}
+
+		track->time_ms = fix->time_ms;
+		track->east_cm = east_cm;
+		track->north_cm = north_cm;
+		track->ve_cms = velocity->ve_cms;
+		track->vn_cms = velocity->vn_cms;
+
+		// Blend from the previous estimate
+		track->blend_east_cm = 0;
+		track->blend_north_cm = 0;
+		if (track->started && estimated != -1) {
+			uint32_t dt_ms = TRACK_Age(track->time_ms, now_ms);
+			if (dt_ms > track->config.max_age_ms) {
+				dt_ms = track->config.max_age_ms;
+			}
+			int32_t offset_east = before.east_cm - TRACK_Extrapolate(east_cm, track->ve_cms, track->ae_cms2, dt_ms,
+					track->config.accel_ms);
+			int32_t offset_north = before.north_cm - TRACK_Extrapolate(north_cm, track->vn_cms, track->an_cms2, dt_ms,
+					track->config.accel_ms);
+			if (offset_east > track->snap_cm || offset_east < -track->snap_cm || offset_north > track->snap_cm
+					|| offset_north < -track->snap_cm) {
+				track->stats.snaps++;
+			} else if (track->config.blend_ms > 0) {
+				track->blend_ms = now_ms;
+				track->blend_east_cm = offset_east;
+				track->blend_north_cm = offset_north;
+			}
+		}
+		track->started = 1;
+		track->stats.fixes++;
+		applied = 1;
+	} else if (fix->time_ms != track->time_ms) {
+		track->stats.late++;
+	}
+
+	if (fix->altitude && (!track->altitude_started || (int32_t)(fix->altitude_ms - track->altitude_ms) > 0)) {
+		if (!track->pad_altitude) {
+			track->pad_altitude_cm = fix->altitude_cm;
+			track->pad_altitude = 1;
+		}
+		int32_t up_cm = fix->altitude_cm - track->pad_altitude_cm;
+
+		// Vertical velocity over the history
+		TRACK_Altitude *altitude = &track->altitudes[track->altitude_index];
+		altitude->time_ms = fix->altitude_ms;
+		altitude->up_cm = up_cm;
+		track->altitude_index = (track->altitude_index + 1) & (TRACK_HISTORY - 1);
+		if (track->altitude_count < TRACK_HISTORY) {
+			track->altitude_count++;
+		}
+		const TRACK_Altitude *oldest = &track->altitudes[(track->altitude_index - track->altitude_count) & (TRACK_HISTORY - 1)];
+		int32_t span_ms = (int32_t)(fix->altitude_ms - oldest->time_ms);
+		if (span_ms >= TRACK_MIN_SPAN_MS && span_ms <= track->config.max_age_ms) {
+			track->vu_cms = TRACK_Round((int64_t)(up_cm - oldest->up_cm) * 1000, span_ms);
+		} else {
+			track->vu_cms = 0;
+		}
+
+		track->altitude_ms = fix->altitude_ms;
+		track->up_cm = up_cm;
+
+		// Blend from the previous estimate
+		track->blend_up_cm = 0;
+		if (track->altitude_started && estimated != -1 && before.altitude) {
+			uint32_t dt_ms = TRACK_Age(track->altitude_ms, now_ms);
+			if (dt_ms > track->config.max_age_ms) {
+				dt_ms = track->config.max_age_ms;
+			}
+			int32_t offset_up = before.up_cm - TRACK_Extrapolate(up_cm, track->vu_cms, 0, dt_ms, 0);
+			if (offset_up > track->snap_cm || offset_up < -track->snap_cm) {
+				track->stats.snaps++;
+			} else if (track->config.blend_ms > 0) {
+				track->blend_up_ms = now_ms;
+				track->blend_up_cm = offset_up;
+			}
+		}
+		track->altitude_started = 1;
+		track->stats.altitudes++;
+		applied = 1;
+	}
+
+	return applied ? 0 : -1;
+}
+
+/**
+ * Position and velocity at "now_ms", extrapolated from the last fix. Takes a few us (64 bit
+ * multiplications and divisions).
+ *
+ * @param track: pointer to a TRACK structure.
+ * @param now_ms: HAL tick to extrapolate to, not before the fix.
+ * @param estimate: position from the pad, latitude and longitude, age of the fix.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, no fix
+ * @retval -3 Fix older than max_age_ms, extrapolated this far only
+ */
+int8_t TRACK_Predict(const TRACK *track, uint32_t now_ms, TRACK_Estimate *estimate) {
+	if (track == NULL || estimate == NULL || !track->started) {
+		return -1; // Error, no fix
+	}
+
+	uint32_t age_ms = TRACK_Age(track->time_ms, now_ms);
+	int32_t dt_ms = age_ms < track->config.max_age_ms ? age_ms : track->config.max_age_ms;
+	int32_t accel_dt_ms = dt_ms < track->config.accel_ms ? dt_ms : track->config.accel_ms;
+	estimate->east_cm = TRACK_Extrapolate(track->east_cm, track->ve_cms, track->ae_cms2, dt_ms, track->config.accel_ms)
+			+ TRACK_Blend(track->blend_east_cm, track->blend_ms, now_ms, track->config.blend_ms);
+	estimate->north_cm = TRACK_Extrapolate(track->north_cm, track->vn_cms, track->an_cms2, dt_ms, track->config.accel_ms)
+			+ TRACK_Blend(track->blend_north_cm, track->blend_ms, now_ms, track->config.blend_ms);
+	estimate->ve_cms = track->ve_cms + TRACK_Round((int64_t)track->ae_cms2 * accel_dt_ms, 1000);
+	estimate->vn_cms = track->vn_cms + TRACK_Round((int64_t)track->an_cms2 * accel_dt_ms, 1000);
+	estimate->age_ms = age_ms;
+	GEO_ToGlobal(&track->geo, estimate->east_cm, estimate->north_cm, &estimate->latitude_e7, &estimate->longitude_e7);
+	GEO_RangeBearing(estimate->east_cm, estimate->north_cm, &estimate->range_cm, &estimate->bearing_cdeg);
+
+	if (track->altitude_started) {
+		uint32_t altitude_age_ms = TRACK_Age(track->altitude_ms, now_ms);
+		int32_t up_dt_ms = altitude_age_ms < track->config.max_age_ms ? altitude_age_ms : track->config.max_age_ms;
+		estimate->up_cm = TRACK_Extrapolate(track->up_cm, track->vu_cms, 0, up_dt_ms, 0)
+				+ TRACK_Blend(track->blend_up_cm, track->blend_up_ms, now_ms, track->config.blend_ms);
+		estimate->vu_cms = track->vu_cms;
+		estimate->altitude_cm = track->pad_altitude_cm + estimate->up_cm;
+		estimate->altitude = 1;
+		estimate->altitude_age_ms = altitude_age_ms;
+	} else {
+		estimate->up_cm = 0;
+		estimate->vu_cms = 0;
+		estimate->altitude_cm = 0;
+		estimate->altitude = 0;
+		estimate->altitude_age_ms = 0;
+	}
+
+	return age_ms > track->config.max_age_ms ? -3 : 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * APOGEE_tests.c
+ *
+ * Replay synthetic flights through the apogee detector and log the distribution
+ * of the detection latency (in samples after the true apogee).
+ * No recorded flight is available yet, every case here is synthetic (FLIGHTSIM or
+ * hand-written). A recorded flight goes through APOGEE_TESTS_ReplayRecording as a const
+ * table, e.g. the altitude column of flight.csv from Tools/log_decoder.py.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/APOGEE_tests.h"
+
+#include "GAUL_Flight/Tests/FLIGHTSIM.h"
+
+#include <stdio.h>
+
+static APOGEE_Detector detector;
+static FLIGHTSIM sim;
+
+/**
+ * Replay one flight, return the latency in samples (negative if detected a few samples
+ * before the true apogee), APOGEE_TESTS_FALSE if apogee was detected while the rocket
+ * was still clearly going up, or APOGEE_TESTS_MISSED if apogee was never detected.
+ */
+static int32_t APOGEE_TESTS_ReplayFlight(const FLIGHTSIM_Profile *profile, const APOGEE_Config *config) {
+	FLIGHTSIM_Sample sample;
+
+	FLIGHTSIM_Init(&sim, profile);
+	APOGEE_Init(&detector, config);
+
+	while (FLIGHTSIM_Step(&sim, &sample) == 0) {
+		if (sample.phase == FLIGHTSIM_PHASE_PAD) {
+			continue;
+		}
+		if (!detector.armed) {
+			APOGEE_Arm(&detector, sample.time_ms);
+		}
+
+		if (APOGEE_Update(&detector, sample.baro_alt_m, sample.time_ms) == 1) {
+			if (sample.true_vel_mps > APOGEE_TESTS_FALSE_VELOCITY) {
+				return APOGEE_TESTS_FALSE; // Rocket still going up
+			}
+			return ((int32_t)sample.time_ms - (int32_t)sim.apogee_time_ms) / (int32_t)profile->sample_period_ms;
+		}
+
+		// Stop 10 s after apogee, detection is considered missed
+		if (sample.phase >= FLIGHTSIM_PHASE_DROGUE && sample.time_ms - sim.apogee_time_ms > 10000) {
+			break;
+		}
+	}
+
+	return APOGEE_TESTS_MISSED;
+}
+
+/**
+ * Replay a recorded altitude stream (e.g. extracted from a flight log).
+ *
+ * @param alt_m[]: altitude samples.
+ * @param time_ms[]: timestamp of each sample, first sample is used as launch time.
+ * @param count: number of samples.
+ * @param apogee_time_ms: time of the true apogee (from post-flight analysis).
+ * @param period_ms: sample period, to convert latency to samples.
+ * @param config: detector configuration, NULL to use default configuration.
+ *
+ * @return latency in samples, APOGEE_TESTS_FALSE or APOGEE_TESTS_MISSED
+ */
+int32_t APOGEE_TESTS_ReplayRecording(const float alt_m[], const uint32_t time_ms[], uint16_t count, uint32_t apogee_time_ms, uint32_t period_ms, const APOGEE_Config *config) {
+	if (count == 0 || period_ms == 0) {
+		return APOGEE_TESTS_MISSED;
+	}
+
+	APOGEE_Init(&detector, config);
+	APOGEE_Arm(&detector, time_ms[0]);
+
+	for (uint16_t i = 0; i < count; i++) {
+		if (APOGEE_Update(&detector, alt_m[i], time_ms[i]) == 1) {
+			if (time_ms[i] < apogee_time_ms) {
+				return APOGEE_TESTS_FALSE;
+			}
+			return (int32_t)((time_ms[i] - apogee_time_ms) / period_ms);
+		}
+	}
+
+	return APOGEE_TESTS_MISSED;
+}
+
+/**
+ * Run one configuration over APOGEE_TESTS_FLIGHTS flights and log the latency histogram.
+ */
+static void APOGEE_TESTS_Distribution(const char *name, const APOGEE_Config *config, uint8_t *passed) {
+	FLIGHTSIM_Profile profile;
+	uint16_t histogram[APOGEE_TESTS_HISTOGRAM_SIZE] = { 0 };
+	uint16_t false_apogee = 0;
+	uint16_t missed = 0;
+	uint16_t early = 0;
+	int32_t max_latency = 0;
+	int32_t sum_latency = 0;
+	uint16_t detected = 0;
+
+	for (uint16_t i = 0; i < APOGEE_TESTS_FLIGHTS; i++) {
+		FLIGHTSIM_DefaultProfile(&profile, 1 + i * 7919);
+		int32_t latency = APOGEE_TESTS_ReplayFlight(&profile, config);
+
+		if (latency == APOGEE_TESTS_FALSE) {
+			false_apogee++;
+		} else if (latency == APOGEE_TESTS_MISSED) {
+			missed++;
+		} else if (latency < 0) {
+			early++; // Near apogee, below APOGEE_TESTS_FALSE_VELOCITY
+			sum_latency += latency;
+			detected++;
+		} else {
+			histogram[latency < APOGEE_TESTS_HISTOGRAM_SIZE ? latency : APOGEE_TESTS_HISTOGRAM_SIZE - 1]++;
+			sum_latency += latency;
+			if (latency > max_latency) {
+				max_latency = latency;
+			}
+			detected++;
+		}
+	}
+
+	printf("%s: %u flights, %u false, %u missed\n", name, APOGEE_TESTS_FLIGHTS, false_apogee, missed);
+	if (detected > 0) {
+		printf("Latency (samples): mean %.2f max %ld\n", (float)sum_latency / detected, max_latency);
+	}
+	printf("<0 : %u\n", early);
+	for (uint8_t i = 0; i < APOGEE_TESTS_HISTOGRAM_SIZE; i++) {
+		printf("%2u%s: %u\n", i, i == APOGEE_TESTS_HISTOGRAM_SIZE - 1 ? "+" : " ", histogram[i]);
+	}
+
+	*passed = false_apogee == 0 && missed == 0 && max_latency < APOGEE_TESTS_MAX_LATENCY;
+}
+
+void APOGEE_TESTS_Replay_LogSTLINK() {
+	APOGEE_Config config;
+	uint8_t passed;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: full pipeline, no false apogee with transonic spikes
+	APOGEE_DefaultConfig(&config);
+	APOGEE_TESTS_Distribution("Full pipeline", &config, &passed);
+	printf("Test 1 %s\n\n", passed ? "passed" : "failed");
+
+	// Test 2: naive detector (no median, no outlier gate), only logged for comparison
+	config.gates = APOGEE_GATE_MIN_ALT | APOGEE_GATE_LOCKOUT;
+	config.descending_samples = 1;
+	APOGEE_TESTS_Distribution("Naive", &config, &passed);
+	printf("Test 2 logged\n\n");
+
+	// Test 3: hand-written stream at 1 Hz (not a recorded flight), flat top and single spike after apogee
+	APOGEE_DefaultConfig(&config);
+	config.max_step_m = 200.0f; // 1 Hz
+	config.lockout_ms = 0;
+	static const float alt[] = { 0, 50, 120, 200, 260, 300, 320, 326, 320, 900, 300, 270, 230, 200, 175, 150, 125, 100, 75, 50, 25, 0 };
+	uint32_t time[sizeof(alt) / sizeof(alt[0])];
+	for (uint8_t i = 0; i < sizeof(alt) / sizeof(alt[0]); i++) {
+		time[i] = i * 1000;
+	}
+	int32_t latency = APOGEE_TESTS_ReplayRecording(alt, time, sizeof(alt) / sizeof(alt[0]), 7000, 1000, &config);
+	printf("Hand-written stream latency: %ld samples\n", latency);
+	printf("Test 3 %s\n", latency >= 0 && latency <= 1 + APOGEE_VELOCITY_WINDOW / 2 + APOGEE_DEFAULT_DESCENDING_SAMPLES + 2 ? "passed" : "failed");
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
@@ -0,0 +1,180 @@
+/*
+ * FLIGHTSIM.c
+ *
+ * Synthetic flight generator used by the flight module tests.
+ *
+ * The flight is deterministic for a given profile (xorshift pseudo random generator),
+ * so a failing test can be replayed with the same seed.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/FLIGHTSIM.h"
+
+#include "GAUL_System/Tests/TESTS.h"
+
+#include <math.h>
+
+/**
+ * Fill a profile with a typical flight, randomized by the seed:
+ * boost between 60 and 150 m/s^2 for 2.5 s (burnout between Mach 0.45 and Mach 1.1).
+ */
+void FLIGHTSIM_DefaultProfile(FLIGHTSIM_Profile *profile, uint32_t seed) {
+	profile->seed = seed == 0 ? 1 : seed;
+	profile->sample_period_ms = 20; // 50 Hz
+	profile->pad_time_ms = 2000;
+	profile->boost_accel_mps2 = 60.0f + (float)(profile->seed % 91);
+	profile->boost_time_ms = 2500;
+	profile->noise_m = 0.5f;
+	profile->accel_noise_mps2 = 2.0f;
+	profile->spike_m = 80.0f;
+	profile->spike_percent = 20;
+	profile->disturbance_m = 0;
+}
+
+void FLIGHTSIM_Init(FLIGHTSIM *sim, const FLIGHTSIM_Profile *profile) {
+	sim->profile = *profile;
+	sim->rng = profile->seed == 0 ? 1 : profile->seed;
+	sim->time_ms = 0;
+	sim->phase = FLIGHTSIM_PHASE_PAD;
+	sim->alt_m = 0;
+	sim->vel_mps = 0;
+	sim->max_alt_m = 0;
+	sim->apogee_time_ms = 0;
+	sim->launch_time_ms = profile->pad_time_ms;
+}
+
+/**
+ * Pseudo random generator of the flight (TESTS_Random).
+ */
+uint32_t FLIGHTSIM_Random(FLIGHTSIM *sim) {
+	return TESTS_Random(&sim->rng);
+}
+
+/**
+ * Approximately gaussian noise (sum of 4 uniforms), standard deviation ~ amplitude / 2.
+ */
+float FLIGHTSIM_Noise(FLIGHTSIM *sim, float amplitude) {
+	float sum = 0;
+	for (uint8_t i = 0; i < 4; i++) {
+		sum += (float)(FLIGHTSIM_Random(sim) & 0xFFFF) / 65535.0f - 0.5f;
+	}
+	return sum * amplitude;
+}
+
+/**
+ * Inverse of BMP280_PressureToAltitude.
+ */
+float FLIGHTSIM_AltitudeToPressure(float alt_m, float pressure_ref) {
+	return pressure_ref * powf(1.0f - alt_m / 44330.0f, 1.0f / 0.1903f);
+}
+
+/**
+ * Advance the simulation by one sample period.
+ *
+ * @param sim: pointer to a FLIGHTSIM structure.
+ * @param sample: pointer to the sample to fill.
+ *
+ * @retval 0 OK
+ * @retval -1 Flight is over (landed), sample is not updated
+ */
+int8_t FLIGHTSIM_Step(FLIGHTSIM *sim, FLIGHTSIM_Sample *sample) {
+	if (sim->phase == FLIGHTSIM_PHASE_LANDED) {
+		return -1;
+	}
+
+	const FLIGHTSIM_Profile *profile = &sim->profile;
+	float dt = (float)profile->sample_period_ms / 1000.0f;
+	float accel = 0;
+
+	sim->time_ms += profile->sample_period_ms;
+
+	switch (sim->phase) {
+	case FLIGHTSIM_PHASE_PAD:
+		if (sim->time_ms >= sim->launch_time_ms) {
+			sim->phase = FLIGHTSIM_PHASE_BOOST;
+		}
+		break;
+	case FLIGHTSIM_PHASE_BOOST:
+		accel = profile->boost_accel_mps2;
+		if (sim->time_ms >= sim->launch_time_ms + profile->boost_time_ms) {
+			sim->phase = FLIGHTSIM_PHASE_COAST;
+		}
+		break;
+	case FLIGHTSIM_PHASE_COAST:
+		accel = -FLIGHTSIM_GRAVITY;
+		break;
+	default:
+		break;
+	}
+
+	if (sim->phase == FLIGHTSIM_PHASE_BOOST || sim->phase == FLIGHTSIM_PHASE_COAST) {
+		sim->alt_m += sim->vel_mps * dt + 0.5f * accel * dt * dt;
+		sim->vel_mps += accel * dt;
+		if (sim->phase == FLIGHTSIM_PHASE_COAST && sim->vel_mps <= 0) {
+			sim->phase = FLIGHTSIM_PHASE_DROGUE;
+		}
+	} else if (sim->phase == FLIGHTSIM_PHASE_DROGUE || sim->phase == FLIGHTSIM_PHASE_MAIN) {
+		// Parachute descent, velocity converges to terminal velocity
+		float terminal = sim->phase == FLIGHTSIM_PHASE_DROGUE ? FLIGHTSIM_DROGUE_MPS : FLIGHTSIM_MAIN_MPS;
+		if (sim->vel_mps > terminal) {
+			accel = -FLIGHTSIM_GRAVITY;
+			sim->vel_mps += accel * dt;
+			if (sim->vel_mps < terminal) {
+				sim->vel_mps = terminal;
+			}
+		} else {
+			accel = FLIGHTSIM_GRAVITY;
+			sim->vel_mps += accel * dt;
+			if (sim->vel_mps > terminal) {
+				sim->vel_mps = terminal;
+			}
+		}
+		sim->alt_m += sim->vel_mps * dt;
+		if (sim->phase == FLIGHTSIM_PHASE_DROGUE && sim->alt_m < FLIGHTSIM_MAIN_ALT_M) {
+			sim->phase = FLIGHTSIM_PHASE_MAIN;
+		}
+		if (sim->alt_m <= 0) {
+			sim->alt_m = 0;
+			sim->vel_mps = 0;
+			sim->phase = FLIGHTSIM_PHASE_LANDED;
+		}
+	}
+
+	if (sim->alt_m > sim->max_alt_m) {
+		sim->max_alt_m = sim->alt_m;
+		sim->apogee_time_ms = sim->time_ms;
+	}
+
+	sample->time_ms = sim->time_ms;
+	sample->phase = sim->phase;
+	sample->true_alt_m = sim->alt_m;
+	sample->true_vel_mps = sim->vel_mps;
+	sample->baro_alt_m = sim->alt_m + FLIGHTSIM_Noise(sim, profile->noise_m);
+	sample->accel_mps2 = accel + FLIGHTSIM_GRAVITY + FLIGHTSIM_Noise(sim, profile->accel_noise_mps2);
+	sample->spike = 0;
+
+	// Shock wave around the static port: pressure jumps, so does the altitude
+	float mach = fabsf(sim->vel_mps) / FLIGHTSIM_SPEED_OF_SOUND;
+	if (profile->spike_m > 0 && mach > 0.8f && (FLIGHTSIM_Random(sim) % 100) < profile->spike_percent) {
+		float spike = profile->spike_m * (0.5f + (float)(FLIGHTSIM_Random(sim) & 0xFF) / 255.0f);
+		sample->baro_alt_m += (FLIGHTSIM_Random(sim) & 1) ? spike : -spike;
+		sample->spike = 1;
+	}
+
+	// Expansion around the static port while crossing Mach 1: sustained pressure drop,
+	// the altitude reads high for a few seconds. Error ramps over 0.01 Mach (~0.3 s in
+	// coast), slow enough to pass a simple outlier gate.
+	if (profile->disturbance_m > 0 && mach > 0.9f && mach < 1.1f) {
+		float ramp = (1.1f - mach) / 0.01f;
+		if ((mach - 0.9f) / 0.01f < ramp) {
+			ramp = (mach - 0.9f) / 0.01f;
+		}
+		sample->baro_alt_m += profile->disturbance_m * (ramp < 1.0f ? ramp : 1.0f);
+	}
+
+	sample->press_Pa = FLIGHTSIM_AltitudeToPressure(sample->baro_alt_m, FLIGHTSIM_PRESS_REF_PA);
+
+	return 0; // OK
+}
@@ -0,0 +1,243 @@
+/*
+ * FLIGHT_tests.c
+ *
+ * Replay full synthetic flights through the flight state machine. Samples are given
+ * to the state machine at the barometer rate of its current phase, like the main loop.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/FLIGHT_tests.h"
+
+#include "GAUL_Flight/Tests/FLIGHTSIM.h"
+
+#include <stdio.h>
+
+typedef struct {
+	uint32_t launch_ms;  // True event times
+	uint32_t burnout_ms;
+	uint32_t apogee_ms;
+	uint32_t main_ms;
+	uint32_t landed_ms;
+	uint32_t samples[FLIGHT_PHASE_COUNT];     // Barometer samples given in each phase
+	uint32_t max_period[FLIGHT_PHASE_COUNT];  // Longest time between two samples
+	float apogee_velocity_mps; // True velocity when apogee was detected
+} FLIGHT_TESTS_Truth;
+
+static FLIGHT flight;
+static FLIGHTSIM sim;
+
+/**
+ * Replay one flight until FLIGHT_TESTS_GROUND_MS after landing, the HAL tick at the start of the
+ * simulation being start_ms. If log is 1, transitions are logged.
+ */
+static void FLIGHT_TESTS_ReplayFlight(const FLIGHTSIM_Profile *profile, uint8_t has_accel, uint8_t log, uint32_t start_ms,
+		FLIGHT_TESTS_Truth *truth) {
+	FLIGHTSIM_Sample sample;
+	FLIGHT_Measurement measurement;
+	uint32_t last_ms = 0;
+	uint32_t ground_ms = 0;
+
+	FLIGHTSIM_Init(&sim, profile);
+	FLIGHT_Init(&flight, NULL, FLIGHTSIM_PRESS_REF_PA);
+
+	truth->launch_ms = start_ms + sim.launch_time_ms;
+	truth->burnout_ms = truth->launch_ms + profile->boost_time_ms;
+	truth->main_ms = 0;
+	truth->landed_ms = 0;
+	truth->apogee_velocity_mps = 0;
+	for (uint8_t i = 0; i < FLIGHT_PHASE_COUNT; i++) {
+		truth->samples[i] = 0;
+		truth->max_period[i] = 0;
+	}
+
+	while (ground_ms < FLIGHT_TESTS_GROUND_MS) {
+		if (FLIGHTSIM_Step(&sim, &sample) != 0) {
+			// Landed, the rocket lies on the ground
+			sample.time_ms += profile->sample_period_ms;
+			sample.true_alt_m = 0;
+			sample.true_vel_mps = 0;
+			sample.baro_alt_m = FLIGHTSIM_Noise(&sim, profile->noise_m);
+			sample.press_Pa = FLIGHTSIM_AltitudeToPressure(sample.baro_alt_m, FLIGHTSIM_PRESS_REF_PA);
+			sample.accel_mps2 = FLIGHTSIM_GRAVITY + FLIGHTSIM_Noise(&sim, profile->accel_noise_mps2);
+			ground_ms += profile->sample_period_ms;
+		}
+		if (sample.phase == FLIGHTSIM_PHASE_MAIN && truth->main_ms == 0) {
+			truth->main_ms = start_ms + sample.time_ms;
+		}
+		if (sample.phase == FLIGHTSIM_PHASE_LANDED && truth->landed_ms == 0) {
+			truth->landed_ms = start_ms + sample.time_ms;
+		}
+
+		// Barometer sampled at the rate of the current phase
+		uint32_t period = sample.time_ms - last_ms;
+		if (period < FLIGHT_GetRates(&flight)->baro_period_ms) {
+			continue;
+		}
+		last_ms = sample.time_ms;
+		if (truth->samples[flight.phase] > 0 && period > truth->max_period[flight.phase]) {
+			truth->max_period[flight.phase] = period;
+		}
+		truth->samples[flight.phase]++;
+
+		measurement.time_ms = start_ms + sample.time_ms;
+		measurement.alt_m = sample.baro_alt_m;
+		measurement.press_Pa_Q8 = (uint32_t)(sample.press_Pa * 256.0f);
+		measurement.accel_mps2 = sample.accel_mps2;
+		measurement.has_accel = has_accel;
+
+		if (FLIGHT_Update(&flight, &measurement) == 1) {
+			if (flight.phase == FLIGHT_PHASE_APOGEE) {
+				truth->apogee_velocity_mps = sample.true_vel_mps;
+			}
+			if (log) {
+				FLIGHT_TESTS_LogEvent(&flight.event);
+			}
+		}
+	}
+	truth->apogee_ms = start_ms + sim.apogee_time_ms;
+}
+
+/**
+ * Time of the transition to a phase, 0 if never entered.
+ */
+static uint32_t FLIGHT_TESTS_EventTime(uint8_t phase) {
+	for (uint8_t i = 0; i < flight.event_count; i++) {
+		if (flight.events[i].to == phase) {
+			return flight.events[i].time_ms;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @retval 1 Transition within [truth, truth + max_delay_ms]
+ * @retval 0 Missed, early or late
+ */
+static uint8_t FLIGHT_TESTS_CheckTime(uint8_t phase, uint32_t truth_ms, uint32_t max_delay_ms) {
+	uint32_t time_ms = FLIGHT_TESTS_EventTime(phase);
+	return time_ms != 0 && time_ms >= truth_ms && time_ms - truth_ms <= max_delay_ms;
+}
+
+/**
+ * @retval 1 All phases entered once, in order
+ */
+static uint8_t FLIGHT_TESTS_CheckOrder() {
+	if (flight.event_count != FLIGHT_PHASE_COUNT - 1) {
+		return 0;
+	}
+	for (uint8_t i = 0; i < flight.event_count; i++) {
+		if (flight.events[i].from != i || flight.events[i].to != i + 1) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void FLIGHT_TESTS_Replay_LogSTLINK() {
+	FLIGHTSIM_Profile profile;
+	FLIGHT_TESTS_Truth truth;
+	uint16_t failures[FLIGHT_PHASE_COUNT];
+	uint16_t order_failures;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: all phases, with accelerometer, transitions close to the true events
+	order_failures = 0;
+	for (uint8_t i = 0; i < FLIGHT_PHASE_COUNT; i++) {
+		failures[i] = 0;
+	}
+	for (uint16_t i = 0; i < FLIGHT_TESTS_FLIGHTS; i++) {
+		FLIGHTSIM_DefaultProfile(&profile, 1 + i * 7919);
+		profile.sample_period_ms = FLIGHT_TESTS_SIM_PERIOD_MS;
+		FLIGHT_TESTS_ReplayFlight(&profile, 1, 0, 0, &truth);
+
+		order_failures += !FLIGHT_TESTS_CheckOrder();
+		failures[FLIGHT_PHASE_BOOST] += !FLIGHT_TESTS_CheckTime(FLIGHT_PHASE_BOOST, truth.launch_ms, FLIGHT_TESTS_LAUNCH_MS);
+		failures[FLIGHT_PHASE_COAST] += !FLIGHT_TESTS_CheckTime(FLIGHT_PHASE_COAST, truth.burnout_ms, FLIGHT_TESTS_BURNOUT_MS);
+		failures[FLIGHT_PHASE_APOGEE] += truth.apogee_velocity_mps > 5.0f
+				|| FLIGHT_TESTS_EventTime(FLIGHT_PHASE_APOGEE) > truth.apogee_ms + FLIGHT_TESTS_APOGEE_MS;
+		failures[FLIGHT_PHASE_MAIN] += !FLIGHT_TESTS_CheckTime(FLIGHT_PHASE_MAIN, truth.main_ms, FLIGHT_TESTS_MAIN_MS);
+		failures[FLIGHT_PHASE_LANDED] += !FLIGHT_TESTS_CheckTime(FLIGHT_PHASE_LANDED, truth.landed_ms, FLIGHT_TESTS_LANDED_MS);
+	}
+	printf("Order %u, launch %u, burnout %u, apogee %u, main %u, landed %u failures\n", order_failures,
+			failures[FLIGHT_PHASE_BOOST], failures[FLIGHT_PHASE_COAST], failures[FLIGHT_PHASE_APOGEE],
+			failures[FLIGHT_PHASE_MAIN], failures[FLIGHT_PHASE_LANDED]);
+	if (order_failures == 0 && failures[FLIGHT_PHASE_BOOST] == 0 && failures[FLIGHT_PHASE_COAST] == 0
+			&& failures[FLIGHT_PHASE_APOGEE] == 0 && failures[FLIGHT_PHASE_MAIN] == 0 && failures[FLIGHT_PHASE_LANDED] == 0) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: without accelerometer (launch on altitude, burnout on timeout)
+	order_failures = 0;
+	failures[FLIGHT_PHASE_APOGEE] = 0;
+	for (uint16_t i = 0; i < FLIGHT_TESTS_FLIGHTS; i++) {
+		FLIGHTSIM_DefaultProfile(&profile, 1 + i * 7919);
+		profile.sample_period_ms = FLIGHT_TESTS_SIM_PERIOD_MS;
+		FLIGHT_TESTS_ReplayFlight(&profile, 0, 0, 0, &truth);
+
+		order_failures += !FLIGHT_TESTS_CheckOrder();
+		failures[FLIGHT_PHASE_APOGEE] += truth.apogee_velocity_mps > 5.0f;
+	}
+	printf("Order %u, apogee %u failures\n", order_failures, failures[FLIGHT_PHASE_APOGEE]);
+	if (order_failures == 0 && failures[FLIGHT_PHASE_APOGEE] == 0) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: one flight logged, barometer sampled at the rate of each phase
+	FLIGHTSIM_DefaultProfile(&profile, 150);
+	profile.sample_period_ms = FLIGHT_TESTS_SIM_PERIOD_MS;
+	FLIGHT_TESTS_ReplayFlight(&profile, 1, 1, 0, &truth);
+	uint8_t rates_ok = 1;
+	for (uint8_t i = 0; i < FLIGHT_PHASE_COUNT; i++) {
+		uint16_t period = flight.config.rates[i].baro_period_ms;
+		printf("%s: %lu samples, period %lu ms (expected %u ms)\n", FLIGHT_PhaseName(i), truth.samples[i],
+				truth.max_period[i], period);
+		if (truth.samples[i] > 1 && truth.max_period[i] != period) {
+			rates_ok = 0;
+		}
+	}
+	if (rates_ok && FLIGHT_TESTS_CheckOrder()) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: launch while the microsecond time base wraps (time_ms * 1000 crosses 2^32), with
+	// and without accelerometer. The wrap falls just before and just after lift-off.
+	uint16_t wrap_failures = 0;
+	for (uint8_t i = 0; i < 4; i++) {
+		FLIGHTSIM_DefaultProfile(&profile, 1 + i * 7919);
+		profile.sample_period_ms = FLIGHT_TESTS_SIM_PERIOD_MS;
+		uint32_t start_ms = FLIGHT_TESTS_WRAP_MS - profile.pad_time_ms + (i % 2 == 0 ? 20 : -20);
+		FLIGHT_TESTS_ReplayFlight(&profile, i < 2, 0, start_ms, &truth);
+
+		wrap_failures += !FLIGHT_TESTS_CheckOrder();
+		wrap_failures += truth.apogee_velocity_mps > 5.0f;
+		// Lift-off back-dated near the true launch, burnout not on an immediate timeout
+		wrap_failures += flight.launch_time_ms + FLIGHT_TESTS_LAUNCH_MS < truth.launch_ms
+				|| flight.launch_time_ms > truth.launch_ms + FLIGHT_TESTS_LAUNCH_MS;
+		wrap_failures += FLIGHT_TESTS_EventTime(FLIGHT_PHASE_COAST) < truth.burnout_ms;
+	}
+	printf("Wrap %u failures\n", wrap_failures);
+	if (wrap_failures == 0) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void FLIGHT_TESTS_LogEvent(const FLIGHT_Event *event) {
+	static const char *reasons[] = { "none", "accel", "altitude", "timeout", "apogee", "delay", "stable" };
+	printf("%lu ms: %s -> %s (%s, %.1f m)\n", event->time_ms, FLIGHT_PhaseName(event->from),
+			FLIGHT_PhaseName(event->to), reasons[event->reason], event->alt_m);
+}
@@ -0,0 +1,379 @@
+/*
+ * FUSION_tests.c
+ *
+ * Replay synthetic flights through the fixed point estimator, with the accelerometer at
+ * 1 kHz and the barometer at the rate of each phase. The same filter written in double
+ * precision is fed the same samples, in order, to measure the fixed point error.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/FUSION_tests.h"
+
+#include "GAUL_Flight/Tests/FLIGHTSIM.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define FUSION_TESTS_MODE_IN_ORDER 0 // Every sample given at its time
+#define FUSION_TESTS_MODE_BURSTS   1 // Accelerometer in bursts, barometer late or early
+#define FUSION_TESTS_MODE_NO_IMU   2 // Barometer only
+
+#define FUSION_TESTS_TRUTH_SIZE 64   // True and reference states kept, by ms (power of 2)
+#define FUSION_TESTS_PENDING    4
+
+// Barometer period by FLIGHTSIM phase, like the flight state machine rates
+static const uint16_t FUSION_TESTS_BARO_PERIOD_MS[] = { 100, 10, 20, 50, 100, 100 };
+
+// Same filter as FUSION.c in double precision, samples given in order
+typedef struct {
+	uint8_t started;
+	uint8_t initialized;
+	uint32_t time_us;
+	double alt_m;
+	double vel_mps;
+	double bias_mps2;
+	uint32_t baro_time_us;
+	uint32_t baro_period_us;
+	uint8_t rejected_in_row;
+} FUSION_TESTS_Reference;
+
+typedef struct {
+	float ref_alt_m;      // Largest fixed point - reference difference
+	float ref_vel_mps;
+	float alt_m;          // Largest estimate - truth difference, pad to apogee
+	float vel_mps;
+	float apogee_vel_mps; // Largest velocity error in coast below FUSION_TESTS_APOGEE_MPS
+	float bias_mps2;      // Bias estimate error at launch
+	FUSION_Stats stats;
+} FUSION_TESTS_Result;
+
+typedef struct {
+	uint32_t time_us;
+	int32_t alt_mm;
+	uint32_t deliver_ms;
+} FUSION_TESTS_Pending;
+
+static FUSION fusion;
+static FLIGHTSIM sim;
+static FUSION_TESTS_Reference reference;
+static uint32_t FUSION_TESTS_rng = 1;
+
+static void FUSION_TESTS_ReferencePredict(FUSION_TESTS_Reference *ref, int32_t accel_mms2, uint32_t time_us) {
+	if (!ref->started) {
+		ref->started = 1;
+		ref->time_us = time_us;
+		return;
+	}
+	double dt = (double)(time_us - ref->time_us) / 1e6;
+	ref->time_us = time_us;
+	if (!ref->initialized) {
+		return;
+	}
+
+	double accel = (double)(accel_mms2 - FUSION_GRAVITY_MMS2) / 1000.0 - ref->bias_mps2;
+	ref->alt_m += (ref->vel_mps + accel * dt / 2.0) * dt;
+	ref->vel_mps += accel * dt;
+}
+
+static void FUSION_TESTS_ReferenceBaro(FUSION_TESTS_Reference *ref, int32_t alt_mm, uint32_t time_us) {
+	double alt_m = (double)alt_mm / 1000.0;
+
+	if (!ref->initialized) {
+		ref->initialized = 1;
+		ref->alt_m = alt_m;
+		ref->vel_mps = 0;
+		ref->bias_mps2 = 0;
+		ref->baro_time_us = time_us;
+		return;
+	}
+
+	uint32_t period = time_us - ref->baro_time_us;
+	ref->baro_time_us = time_us;
+	ref->baro_period_us = period > FUSION_MAX_PERIOD_US ? FUSION_MAX_PERIOD_US : period;
+
+	double gate = FUSION_DEFAULT_GATE_M;
+	double innovation = alt_m - ref->alt_m;
+	if (fabs(innovation) > gate) {
+		if (++ref->rejected_in_row <= FUSION_MAX_REJECTED) {
+			return;
+		}
+	} else {
+		ref->rejected_in_row = 0;
+	}
+
+	double omega = FUSION_DEFAULT_OMEGA_RAD_S;
+	double wt = omega * (double)ref->baro_period_us / 1e6;
+	double k1 = 3.0 * wt > 1.0 ? 1.0 : 3.0 * wt;
+	ref->alt_m += k1 * innovation;
+	ref->vel_mps += 3.0 * omega * wt * innovation;
+	ref->bias_mps2 -= omega * omega * wt * innovation;
+}
+
+/**
+ * Accelerometer output in mm/s^2, quantized like the ICM-20602.
+ */
+static int32_t FUSION_TESTS_Accelerometer(float accel_mps2) {
+	int32_t lsb = (int32_t)floorf(accel_mps2 / 9.80665f * FUSION_TESTS_ACCEL_LSB_PER_G + 0.5f);
+	return lsb * FUSION_GRAVITY_MMS2 / FUSION_TESTS_ACCEL_LSB_PER_G;
+}
+
+/**
+ * Replay one flight from the pad to FUSION_TESTS_DESCENT_MS after apogee.
+ */
+static void FUSION_TESTS_ReplayFlight(const FLIGHTSIM_Profile *profile, uint8_t mode, float offset_mps2,
+		FUSION_TESTS_Result *result) {
+	FLIGHTSIM_Sample sample;
+	float true_alt[FUSION_TESTS_TRUTH_SIZE];
+	float true_vel[FUSION_TESTS_TRUTH_SIZE];
+	uint8_t phase[FUSION_TESTS_TRUTH_SIZE];
+	double ref_alt[FUSION_TESTS_TRUTH_SIZE];
+	double ref_vel[FUSION_TESTS_TRUTH_SIZE];
+	int32_t burst[FUSION_TESTS_BURST_MS];
+	uint32_t burst_time_us = 0;
+	uint8_t burst_count = 0;
+	FUSION_TESTS_Pending pending[FUSION_TESTS_PENDING];
+	uint8_t pending_count = 0;
+	uint32_t last_baro_ms = 0;
+	uint32_t checked_us = 0;
+	uint8_t launched = 0;
+	FUSION_State state;
+
+	FLIGHTSIM_Init(&sim, profile);
+	FUSION_Init(&fusion, NULL);
+	reference = (FUSION_TESTS_Reference) { 0 };
+	*result = (FUSION_TESTS_Result) { 0 };
+
+	while (FLIGHTSIM_Step(&sim, &sample) == 0) {
+		uint32_t time_ms = sample.time_ms;
+		uint32_t time_us = time_ms * 1000;
+		uint8_t slot = time_ms % FUSION_TESTS_TRUTH_SIZE;
+		if (sample.phase >= FLIGHTSIM_PHASE_DROGUE && time_ms > sim.apogee_time_ms + FUSION_TESTS_DESCENT_MS) {
+			break;
+		}
+
+		int32_t accel_mms2 = FUSION_TESTS_Accelerometer(sample.accel_mps2 + offset_mps2);
+		int32_t alt_mm = (int32_t)floorf(sample.baro_alt_m * 1000.0f + 0.5f);
+		uint8_t baro = time_ms - last_baro_ms >= FUSION_TESTS_BARO_PERIOD_MS[sample.phase];
+		if (baro) {
+			last_baro_ms = time_ms;
+		}
+
+		// Reference, in order
+		FUSION_TESTS_ReferencePredict(&reference, accel_mms2, time_us);
+		if (baro) {
+			FUSION_TESTS_ReferenceBaro(&reference, alt_mm, time_us);
+		}
+		true_alt[slot] = sample.true_alt_m;
+		true_vel[slot] = sample.true_vel_mps;
+		phase[slot] = sample.phase;
+		ref_alt[slot] = reference.alt_m;
+		ref_vel[slot] = reference.vel_mps;
+
+		// Fixed point
+		if (mode == FUSION_TESTS_MODE_IN_ORDER) {
+			FUSION_Predict(&fusion, accel_mms2, time_us);
+			if (baro) {
+				FUSION_UpdateBaro(&fusion, alt_mm, time_us, 1);
+			}
+		} else if (mode == FUSION_TESTS_MODE_BURSTS) {
+			// Burst read every FUSION_TESTS_BURST_MS, barometer read by a task running before or after it
+			burst[burst_count++] = accel_mms2;
+			burst_time_us = time_us;
+			if (baro && pending_count < FUSION_TESTS_PENDING) {
+				FUSION_TESTS_rng ^= FUSION_TESTS_rng << 13;
+				FUSION_TESTS_rng ^= FUSION_TESTS_rng >> 17;
+				FUSION_TESTS_rng ^= FUSION_TESTS_rng << 5;
+				pending[pending_count].time_us = time_us;
+				pending[pending_count].alt_mm = alt_mm;
+				pending[pending_count].deliver_ms = time_ms + FUSION_TESTS_rng % (FUSION_TESTS_MAX_LATENCY + 1);
+				if (pending_count > 0 && pending[pending_count].deliver_ms < pending[pending_count - 1].deliver_ms) {
+					pending[pending_count].deliver_ms = pending[pending_count - 1].deliver_ms; // Read in order
+				}
+				pending_count++;
+			}
+			while (pending_count > 0 && pending[0].deliver_ms <= time_ms) {
+				FUSION_UpdateBaro(&fusion, pending[0].alt_mm, pending[0].time_us, 1);
+				pending_count--;
+				for (uint8_t i = 0; i < pending_count; i++) {
+					pending[i] = pending[i + 1];
+				}
+			}
+			if (burst_count == FUSION_TESTS_BURST_MS) {
+				for (uint8_t i = 0; i < burst_count; i++) {
+					FUSION_Predict(&fusion, burst[i], burst_time_us - (burst_count - 1 - i) * 1000);
+				}
+				burst_count = 0;
+			}
+		} else if (baro) {
+			FUSION_UpdateBaro(&fusion, alt_mm, time_us, 1);
+		}
+
+		if (!launched && sample.phase == FLIGHTSIM_PHASE_BOOST) {
+			launched = 1;
+			FUSION_GetState(&fusion, &state);
+			result->bias_mps2 = fabsf((float)state.bias_mms2 / 1000.0f - offset_mps2);
+		}
+
+		// Compare the new state with the truth and the reference at the same time, once the
+		// barometer samples up to that time were given
+		uint8_t complete = 1;
+		for (uint8_t i = 0; i < pending_count; i++) {
+			complete &= (int32_t)(pending[i].time_us - fusion.time_us) > 0;
+		}
+		if (!complete || !fusion.initialized || fusion.time_us == checked_us
+				|| time_us - fusion.time_us >= FUSION_TESTS_TRUTH_SIZE * 1000 || fusion.time_us % 1000 != 0) {
+			continue;
+		}
+		checked_us = fusion.time_us;
+		slot = (fusion.time_us / 1000) % FUSION_TESTS_TRUTH_SIZE;
+		FUSION_GetState(&fusion, &state);
+		float alt_m = (float)state.alt_mm / 1000.0f;
+		float vel_mps = (float)state.vel_mms / 1000.0f;
+		if (mode != FUSION_TESTS_MODE_NO_IMU) {
+			float ref_alt_error = fabsf(alt_m - (float)ref_alt[slot]);
+			float ref_vel_error = fabsf(vel_mps - (float)ref_vel[slot]);
+			if (ref_alt_error > result->ref_alt_m) {
+				result->ref_alt_m = ref_alt_error;
+			}
+			if (ref_vel_error > result->ref_vel_mps) {
+				result->ref_vel_mps = ref_vel_error;
+			}
+		}
+		if (phase[slot] <= FLIGHTSIM_PHASE_COAST) {
+			float alt_error = fabsf(alt_m - true_alt[slot]);
+			float vel_error = fabsf(vel_mps - true_vel[slot]);
+			if (alt_error > result->alt_m) {
+				result->alt_m = alt_error;
+			}
+			if (vel_error > result->vel_mps) {
+				result->vel_mps = vel_error;
+			}
+			if (phase[slot] == FLIGHTSIM_PHASE_COAST && true_vel[slot] < FUSION_TESTS_APOGEE_MPS
+					&& vel_error > result->apogee_vel_mps) {
+				result->apogee_vel_mps = vel_error;
+			}
+		}
+	}
+	result->stats = fusion.stats;
+}
+
+/**
+ * Worst result over FUSION_TESTS_FLIGHTS flights.
+ */
+static void FUSION_TESTS_ReplayFlights(uint8_t mode, uint32_t pad_time_ms, float offset_mps2, FUSION_TESTS_Result *worst) {
+	FLIGHTSIM_Profile profile;
+	FUSION_TESTS_Result result;
+
+	*worst = (FUSION_TESTS_Result) { 0 };
+	for (uint16_t i = 0; i < FUSION_TESTS_FLIGHTS; i++) {
+		FLIGHTSIM_DefaultProfile(&profile, 1 + i * 4547); // Boost spread over 60 to 150 m/s^2
+		profile.sample_period_ms = 1;
+		if (pad_time_ms != 0) {
+			profile.pad_time_ms = pad_time_ms;
+		}
+		FUSION_TESTS_ReplayFlight(&profile, mode, offset_mps2, &result);
+
+		worst->ref_alt_m = fmaxf(worst->ref_alt_m, result.ref_alt_m);
+		worst->ref_vel_mps = fmaxf(worst->ref_vel_mps, result.ref_vel_mps);
+		worst->alt_m = fmaxf(worst->alt_m, result.alt_m);
+		worst->vel_mps = fmaxf(worst->vel_mps, result.vel_mps);
+		worst->apogee_vel_mps = fmaxf(worst->apogee_vel_mps, result.apogee_vel_mps);
+		worst->bias_mps2 = fmaxf(worst->bias_mps2, result.bias_mps2);
+		worst->stats.predictions += result.stats.predictions;
+		worst->stats.imu_late += result.stats.imu_late;
+		worst->stats.baro_updates += result.stats.baro_updates;
+		worst->stats.baro_retro += result.stats.baro_retro;
+		worst->stats.baro_queued += result.stats.baro_queued;
+		worst->stats.baro_late += result.stats.baro_late;
+		worst->stats.baro_rejected += result.stats.baro_rejected;
+		worst->stats.baro_only += result.stats.baro_only;
+	}
+}
+
+static void FUSION_TESTS_LogResult(const FUSION_TESTS_Result *result) {
+	printf("Reference: alt %.4f m, vel %.4f m/s; truth: alt %.2f m, vel %.2f m/s (%.2f m/s near apogee); bias %.3f m/s^2\n",
+			result->ref_alt_m, result->ref_vel_mps, result->alt_m, result->vel_mps, result->apogee_vel_mps,
+			result->bias_mps2);
+	printf("Baro: %lu updates, %lu retro, %lu queued, %lu late, %lu rejected, %lu without IMU\n",
+			result->stats.baro_updates, result->stats.baro_retro, result->stats.baro_queued, result->stats.baro_late,
+			result->stats.baro_rejected, result->stats.baro_only);
+}
+
+void FUSION_TESTS_Replay_LogSTLINK() {
+	FUSION_TESTS_Result result;
+	FUSION_Config config;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: samples in order, fixed point close to the double precision reference
+	FUSION_TESTS_ReplayFlights(FUSION_TESTS_MODE_IN_ORDER, 0, 0, &result);
+	FUSION_TESTS_LogResult(&result);
+	if (result.ref_alt_m <= FUSION_TESTS_REF_ALT_M && result.ref_vel_mps <= FUSION_TESTS_REF_VEL_MPS) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: same flights, estimate close to the true flight through boost and transonic spikes
+	if (result.alt_m <= FUSION_TESTS_ALT_M && result.vel_mps <= FUSION_TESTS_VEL_MPS && result.stats.baro_rejected > 0) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: accelerometer in bursts, barometer given before or after the accelerometer reached
+	// its time, same result as in order
+	FUSION_TESTS_ReplayFlights(FUSION_TESTS_MODE_BURSTS, 0, 0, &result);
+	FUSION_TESTS_LogResult(&result);
+	if (result.ref_alt_m <= FUSION_TESTS_REF_ALT_M && result.ref_vel_mps <= FUSION_TESTS_REF_VEL_MPS
+			&& result.stats.baro_retro > 0 && result.stats.baro_queued > 0 && result.stats.baro_late == 0
+			&& result.stats.baro_only == 0) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: accelerometer offset, bias learned on the pad
+	FUSION_TESTS_ReplayFlights(FUSION_TESTS_MODE_IN_ORDER, 20000, 0.5f, &result);
+	FUSION_TESTS_LogResult(&result);
+	if (result.bias_mps2 <= FUSION_TESTS_BIAS_MPS2 && result.alt_m <= FUSION_TESTS_ALT_M
+			&& result.vel_mps <= FUSION_TESTS_VEL_MPS) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: no accelerometer, the barometer alone keeps the estimate (late through boost,
+	// converged before apogee)
+	FUSION_TESTS_ReplayFlights(FUSION_TESTS_MODE_NO_IMU, 0, 0, &result);
+	FUSION_TESTS_LogResult(&result);
+	if (result.apogee_vel_mps <= FUSION_TESTS_BARO_VEL_MPS && result.stats.baro_only > 0 && result.stats.predictions == 0) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: samples too old, invalid configuration
+	FUSION_Init(&fusion, NULL);
+	FUSION_Predict(&fusion, FUSION_GRAVITY_MMS2, 1000);
+	FUSION_UpdateBaro(&fusion, 0, 1000, 1);
+	for (uint32_t time_us = 2000; time_us <= 100000; time_us += 1000) {
+		FUSION_Predict(&fusion, FUSION_GRAVITY_MMS2, time_us);
+	}
+	FUSION_DefaultConfig(&config);
+	config.omega_rad_s = 0;
+	if (FUSION_Predict(&fusion, FUSION_GRAVITY_MMS2, 50000) == -1 && fusion.stats.imu_late == 1
+			&& FUSION_UpdateBaro(&fusion, 0, 50000, 1) == -1 && fusion.stats.baro_late == 1
+			&& FUSION_UpdateBaro(&fusion, 0, 90000, 1) == 0 && fusion.stats.baro_retro == 1
+			&& FUSION_Init(&fusion, &config) == -1 && FUSION_Init(NULL, NULL) == -1) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Debug timer Low
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
@@ -0,0 +1,276 @@
+/*
+ * GEO_tests.c
+ *
+ * Fixed-point geodesy against double precision: CORDIC against sin, cos, hypot and atan2,
+ * then East-North offsets, range and bearing from pads at several latitudes against the
+ * inverse problem of Vincenty on WGS84 (distance and azimuth at the pad), up to 20 km.
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/GEO_tests.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GEO_TESTS_A 6378137.0           // WGS84
+#define GEO_TESTS_F (1.0 / 298.257223563)
+
+typedef struct {
+	const char *name;
+	double latitude;
+	double longitude;
+} GEO_TESTS_Pad;
+
+typedef struct {
+	double near_enu_m;        // Largest errors up to GEO_TESTS_NEAR_M...
+	double near_range_m;
+	double far_enu_m;         // ...and up to GEO_TESTS_FAR_M
+	double far_range_m;
+	double bearing_cdeg;      // Beyond 100 m
+	int32_t point_cm;         // GEO_ToLocal(GEO_ToGlobal(GEO_ToLocal(point))) - GEO_ToLocal(point)
+	int32_t offset_cm;        // GEO_ToLocal(GEO_ToGlobal(offset)) - offset
+} GEO_TESTS_Result;
+
+static const GEO_TESTS_Pad GEO_TESTS_PADS[] = {
+	{ "Saint-Honore", 48.4634, -71.0562 },
+	{ "equator", 0.0003, 10.0 },
+	{ "south", -33.9, 18.4 },
+	{ "north", 70.0, 25.0 },
+	{ "dateline", 52.0, 179.99 },
+};
+
+static GEO geo;
+static uint32_t GEO_TESTS_rng = 1;
+
+static double GEO_TESTS_Uniform() {
+	GEO_TESTS_rng ^= GEO_TESTS_rng << 13;
+	GEO_TESTS_rng ^= GEO_TESTS_rng >> 17;
+	GEO_TESTS_rng ^= GEO_TESTS_rng << 5;
+	return (GEO_TESTS_rng + 0.5) / 4294967296.0;
+}
+
+/**
+ * Inverse problem on WGS84 (Vincenty, 1975): distance (m) and azimuth at the first point
+ * (degrees from north, clockwise).
+ */
+static void GEO_TESTS_Vincenty(double latitude1, double longitude1, double latitude2, double longitude2,
+		double *distance_m, double *azimuth_deg) {
+	double b = (1.0 - GEO_TESTS_F) * GEO_TESTS_A;
+	double L = remainder(longitude2 - longitude1, 360.0) * M_PI / 180.0;
+	double U1 = atan((1.0 - GEO_TESTS_F) * tan(latitude1 * M_PI / 180.0));
+	double U2 = atan((1.0 - GEO_TESTS_F) * tan(latitude2 * M_PI / 180.0));
+	double sinU1 = sin(U1), cosU1 = cos(U1), sinU2 = sin(U2), cosU2 = cos(U2);
+	double lambda = L, previous;
+	double sin_sigma, cos_sigma, sigma, cos2_alpha, cos_2sigma_m;
+
+	for (uint16_t i = 0; i < 200; i++) {
+		double sin_lambda = sin(lambda), cos_lambda = cos(lambda);
+		sin_sigma = hypot(cosU2 * sin_lambda, cosU1 * sinU2 - sinU1 * cosU2 * cos_lambda);
+		if (sin_sigma == 0) {
+			*distance_m = 0; // Same point
+			*azimuth_deg = 0;
+			return;
+		}
+		cos_sigma = sinU1 * sinU2 + cosU1 * cosU2 * cos_lambda;
+		sigma = atan2(sin_sigma, cos_sigma);
+		double sin_alpha = cosU1 * cosU2 * sin_lambda / sin_sigma;
+		cos2_alpha = 1.0 - sin_alpha * sin_alpha;
+		cos_2sigma_m = cos2_alpha != 0 ? cos_sigma - 2.0 * sinU1 * sinU2 / cos2_alpha : 0;
+		double C = GEO_TESTS_F / 16.0 * cos2_alpha * (4.0 + GEO_TESTS_F * (4.0 - 3.0 * cos2_alpha));
+		previous = lambda;
+		lambda = L + (1.0 - C) * GEO_TESTS_F * sin_alpha
+				* (sigma + C * sin_sigma * (cos_2sigma_m + C * cos_sigma * (-1.0 + 2.0 * cos_2sigma_m * cos_2sigma_m)));
+		if (fabs(lambda - previous) < 1e-13) {
+			break;
+		}
+	}
+
+	double u2 = cos2_alpha * (GEO_TESTS_A * GEO_TESTS_A - b * b) / (b * b);
+	double A = 1.0 + u2 / 16384.0 * (4096.0 + u2 * (-768.0 + u2 * (320.0 - 175.0 * u2)));
+	double B = u2 / 1024.0 * (256.0 + u2 * (-128.0 + u2 * (74.0 - 47.0 * u2)));
+	double delta_sigma = B * sin_sigma * (cos_2sigma_m + B / 4.0 * (cos_sigma * (-1.0 + 2.0 * cos_2sigma_m * cos_2sigma_m)
+			- B / 6.0 * cos_2sigma_m * (-3.0 + 4.0 * sin_sigma * sin_sigma) * (-3.0 + 4.0 * cos_2sigma_m * cos_2sigma_m)));
+	*distance_m = b * A * (sigma - delta_sigma);
+	*azimuth_deg = atan2(cosU2 * sin(lambda), cosU1 * sinU2 - sinU1 * cosU2 * cos(lambda)) * 180.0 / M_PI;
+	if (*azimuth_deg < 0) {
+		*azimuth_deg += 360.0;
+	}
+}
+
+/**
+ * Difference of two bearings in 0.01 degree, -18000 to 18000.
+ */
+static double GEO_TESTS_BearingError(double bearing_cdeg, double reference_cdeg) {
+	return remainder(bearing_cdeg - reference_cdeg, 36000.0);
+}
+
+/**
+ * Largest error of the two axes, kept in "worst".
+ */
+static void GEO_TESTS_Max(int32_t *worst, int32_t east_cm, int32_t north_cm) {
+	if (abs(east_cm) > *worst) {
+		*worst = abs(east_cm);
+	}
+	if (abs(north_cm) > *worst) {
+		*worst = abs(north_cm);
+	}
+}
+
+/**
+ * Random points around "pad" up to GEO_TESTS_FAR_M, against Vincenty.
+ */
+static void GEO_TESTS_Around(const GEO_TESTS_Pad *pad, GEO_TESTS_Result *result) {
+	int32_t pad_latitude_e7 = (int32_t)lround(pad->latitude * 1e7);
+	int32_t pad_longitude_e7 = (int32_t)lround(pad->longitude * 1e7);
+	double span_deg = GEO_TESTS_FAR_M / 111000.0;
+
+	*result = (GEO_TESTS_Result) { 0 };
+	GEO_SetPad(&geo, pad_latitude_e7, pad_longitude_e7);
+
+	for (uint16_t i = 0; i < GEO_TESTS_POINTS; i++) {
+		// Uniform in the disk, closer points first
+		double scale = i < GEO_TESTS_POINTS / 4 ? GEO_TESTS_NEAR_M / GEO_TESTS_FAR_M : 1.0;
+		double latitude = pad_latitude_e7 / 1e7 + (2.0 * GEO_TESTS_Uniform() - 1.0) * span_deg * scale;
+		double longitude = pad_longitude_e7 / 1e7
+				+ (2.0 * GEO_TESTS_Uniform() - 1.0) * span_deg * scale / cos(pad->latitude * M_PI / 180.0);
+		longitude = remainder(longitude, 360.0);
+		int32_t latitude_e7 = (int32_t)lround(latitude * 1e7);
+		int32_t longitude_e7 = (int32_t)lround(longitude * 1e7);
+
+		double distance_m, azimuth_deg;
+		GEO_TESTS_Vincenty(pad_latitude_e7 / 1e7, pad_longitude_e7 / 1e7, latitude_e7 / 1e7, longitude_e7 / 1e7,
+				&distance_m, &azimuth_deg);
+		if (distance_m > GEO_TESTS_FAR_M) {
+			continue;
+		}
+
+		int32_t east_cm, north_cm, back_latitude_e7, back_longitude_e7;
+		uint32_t range_cm;
+		uint16_t bearing_cdeg;
+		GEO_ToLocal(&geo, latitude_e7, longitude_e7, &east_cm, &north_cm);
+		GEO_RangeBearing(east_cm, north_cm, &range_cm, &bearing_cdeg);
+		GEO_ToGlobal(&geo, east_cm, north_cm, &back_latitude_e7, &back_longitude_e7);
+
+		double enu_m = hypot(east_cm / 100.0 - distance_m * sin(azimuth_deg * M_PI / 180.0),
+				north_cm / 100.0 - distance_m * cos(azimuth_deg * M_PI / 180.0));
+		double range_m = fabs(range_cm / 100.0 - distance_m);
+		if (distance_m <= GEO_TESTS_NEAR_M) {
+			result->near_enu_m = fmax(result->near_enu_m, enu_m);
+			result->near_range_m = fmax(result->near_range_m, range_m);
+		}
+		result->far_enu_m = fmax(result->far_enu_m, enu_m);
+		result->far_range_m = fmax(result->far_range_m, range_m);
+		if (distance_m > 100.0) {
+			result->bearing_cdeg = fmax(result->bearing_cdeg,
+					fabs(GEO_TESTS_BearingError(bearing_cdeg, azimuth_deg * 100.0)));
+		}
+		int32_t back_east_cm, back_north_cm;
+		GEO_ToLocal(&geo, back_latitude_e7, back_longitude_e7, &back_east_cm, &back_north_cm);
+		GEO_TESTS_Max(&result->point_cm, back_east_cm - east_cm, back_north_cm - north_cm);
+
+		// Offset first
+		int32_t offset_east = (int32_t)lround((2.0 * GEO_TESTS_Uniform() - 1.0) * GEO_TESTS_FAR_M * 70.0);
+		int32_t offset_north = (int32_t)lround((2.0 * GEO_TESTS_Uniform() - 1.0) * GEO_TESTS_FAR_M * 70.0);
+		GEO_ToGlobal(&geo, offset_east, offset_north, &latitude_e7, &longitude_e7);
+		GEO_ToLocal(&geo, latitude_e7, longitude_e7, &east_cm, &north_cm);
+		GEO_TESTS_Max(&result->offset_cm, east_cm - offset_east, north_cm - offset_north);
+	}
+}
+
+/**
+ * Run every test and print the results.
+ */
+void GEO_TESTS_Vincenty_LogSTLINK() {
+	// Debug timer High
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: CORDIC sine and cosine, every 0.07 degree
+	double sincos = 0;
+	for (int32_t angle_cdeg = -36000; angle_cdeg <= 36000; angle_cdeg += 7) {
+		int32_t sin_q30, cos_q30;
+		double angle_rad = angle_cdeg / 100.0 * M_PI / 180.0;
+		GEO_SinCos(angle_cdeg, &sin_q30, &cos_q30);
+		sincos = fmax(sincos, fabs(sin_q30 / 1073741824.0 - sin(angle_rad)));
+		sincos = fmax(sincos, fabs(cos_q30 / 1073741824.0 - cos(angle_rad)));
+	}
+	printf("Sine and cosine error: %.2e\n", sincos);
+	if (sincos < GEO_TESTS_SINCOS) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: CORDIC range and bearing, 1 cm to 20000 km in every direction
+	double range_cm = 0, bearing_cdeg = 0;
+	for (uint16_t i = 0; i < 10000; i++) {
+		double magnitude = pow(10.0, 9.3 * GEO_TESTS_Uniform());
+		double direction = 2.0 * M_PI * GEO_TESTS_Uniform();
+		int32_t east = (int32_t)lround(magnitude * sin(direction));
+		int32_t north = (int32_t)lround(magnitude * cos(direction));
+		uint32_t range;
+		uint16_t bearing;
+		GEO_RangeBearing(east, north, &range, &bearing);
+		double reference = hypot(east, north);
+		range_cm = fmax(range_cm, fabs(range - reference) - reference * GEO_TESTS_RANGE_RELATIVE);
+		if (east != 0 || north != 0) {
+			double reference_cdeg = atan2(east, north) * 18000.0 / M_PI;
+			bearing_cdeg = fmax(bearing_cdeg, fabs(GEO_TESTS_BearingError(bearing, reference_cdeg)));
+		}
+	}
+	uint32_t cardinal_range[5];
+	uint16_t cardinal[5];
+	GEO_RangeBearing(0, 0, &cardinal_range[0], &cardinal[0]);
+	GEO_RangeBearing(0, 100, &cardinal_range[1], &cardinal[1]);
+	GEO_RangeBearing(100, 0, &cardinal_range[2], &cardinal[2]);
+	GEO_RangeBearing(0, -100, &cardinal_range[3], &cardinal[3]);
+	GEO_RangeBearing(INT32_MIN, INT32_MIN, &cardinal_range[4], &cardinal[4]);
+	printf("Range error: %.2f cm, bearing error: %.3f cdeg\n", range_cm, bearing_cdeg);
+	if (range_cm <= GEO_TESTS_RANGE_CM && bearing_cdeg <= GEO_TESTS_BEARING_CDEG && cardinal_range[0] == 0
+			&& cardinal[0] == 0 && cardinal_range[1] == 100 && cardinal[1] == 0 && cardinal[2] == 9000
+			&& cardinal[3] == 18000 && cardinal[4] == 22500
+			&& fabs(cardinal_range[4] - 3037000499.98) < GEO_TESTS_RANGE_CM + 3037000499.98 * GEO_TESTS_RANGE_RELATIVE) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: East-North, range and bearing against Vincenty, every pad
+	uint8_t passed = 1;
+	for (uint8_t i = 0; i < sizeof(GEO_TESTS_PADS) / sizeof(GEO_TESTS_PADS[0]); i++) {
+		GEO_TESTS_Result result;
+		GEO_TESTS_Around(&GEO_TESTS_PADS[i], &result);
+		printf("%-12s ENU %.3f m (5 km) %.3f m (20 km), range %.3f m %.3f m, bearing %.3f cdeg,"
+				" round trip %ld cm %ld cm\n", GEO_TESTS_PADS[i].name, result.near_enu_m, result.far_enu_m,
+				result.near_range_m, result.far_range_m, result.bearing_cdeg, (long)result.point_cm,
+				(long)result.offset_cm);
+		passed = passed && result.near_enu_m < GEO_TESTS_NEAR_ENU_M && result.far_enu_m < GEO_TESTS_FAR_ENU_M
+				&& result.near_range_m < GEO_TESTS_NEAR_RANGE_M && result.far_range_m < GEO_TESTS_FAR_RANGE_M
+				&& result.bearing_cdeg < GEO_TESTS_VINCENTY_CDEG && result.point_cm <= GEO_TESTS_ROUND_TRIP_CM
+				&& result.offset_cm <= GEO_TESTS_ROUND_TRIP_CM;
+	}
+	if (passed) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: pad out of range, antimeridian, NULL
+	int32_t east_cm, north_cm, latitude_e7, longitude_e7;
+	GEO_SetPad(&geo, 520000000, 1799990000);
+	GEO_ToLocal(&geo, 520000000, -1799990000, &east_cm, &north_cm); // 0.002 degree east
+	GEO_ToGlobal(&geo, east_cm, north_cm, &latitude_e7, &longitude_e7);
+	if (east_cm > 13700 && east_cm < 13740 && abs(north_cm) <= 1 && abs(longitude_e7 + 1799990000) <= 1
+			&& GEO_SetPad(&geo, 860000000, 0) == -1 && GEO_SetPad(&geo, 0, 1800000001) == -1
+			&& GEO_SetPad(NULL, 0, 0) == -1 && GEO_ToLocal(&geo, 0, 0, NULL, &north_cm) == -1
+			&& GEO_ToGlobal(NULL, 0, 0, &latitude_e7, &longitude_e7) == -1) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Debug timer Low
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
@@ -0,0 +1,329 @@
+/*
+ * LAUNCH_tests.c
+ *
+ * Replay benchmark of the launch detector: accelerometer at 1 kHz, barometer at the pad
+ * rate, pad handling (shocks, pick up, vibrations) and wind gusts added to the synthetic
+ * flights. Launch profiles report the detection latency and the lift-off error, noise-only
+ * profiles (pad without launch) the false positive rate.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/LAUNCH_tests.h"
+
+#include "GAUL_Flight/Tests/FLIGHTSIM.h"
+#include "GAUL_System/Tests/TESTS.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#define LAUNCH_TESTS_MODE_ACCEL  0 // Accelerometer and barometer
+#define LAUNCH_TESTS_MODE_NO_IMU 1 // Barometer only
+
+#define LAUNCH_TESTS_EVENT_NONE      0
+#define LAUNCH_TESTS_EVENT_SHOCK     1
+#define LAUNCH_TESTS_EVENT_LIFT      2
+#define LAUNCH_TESTS_EVENT_VIBRATION 3
+#define LAUNCH_TESTS_EVENT_GUST      4
+
+typedef struct {
+	uint8_t type;             // LAUNCH_TESTS_EVENT_x
+	uint32_t start_ms;
+	uint32_t length_ms;
+	float amplitude;
+	uint32_t period_ms;       // Vibration period, gust ramps
+} LAUNCH_TESTS_Event;
+
+typedef struct {
+	uint16_t flights;
+	uint16_t detected;
+	uint16_t early;           // Detected on the pad: false positive
+	uint16_t reasons[4];      // By LAUNCH_REASON_x
+	float latency_mean_ms;    // Detection - lift-off
+	float latency_max_ms;
+	float error_mean_ms;      // Back-dated - true lift-off
+	float error_max_ms;       // Largest |error|
+	uint32_t pad_ms;          // Time on the pad
+	uint16_t events[5];       // By LAUNCH_TESTS_EVENT_x
+	LAUNCH_Stats stats;
+} LAUNCH_TESTS_Result;
+
+static LAUNCH launch;
+static FLIGHTSIM sim;
+static uint32_t LAUNCH_TESTS_rng = 1;
+
+static uint32_t LAUNCH_TESTS_Random() {
+	return TESTS_Random(&LAUNCH_TESTS_rng);
+}
+
+static float LAUNCH_TESTS_Uniform(float min, float max) {
+	return min + (max - min) * (float)(LAUNCH_TESTS_Random() & 0xFFFF) / 65535.0f;
+}
+
+/**
+ * Accelerometer output in mm/s^2, quantized like the ICM-20602.
+ */
+static int32_t LAUNCH_TESTS_Accelerometer(float accel_mps2) {
+	int32_t lsb = (int32_t)floorf(accel_mps2 / 9.80665f * LAUNCH_TESTS_ACCEL_LSB_PER_G + 0.5f);
+	return lsb * LAUNCH_GRAVITY_MMS2 / LAUNCH_TESTS_ACCEL_LSB_PER_G;
+}
+
+static void LAUNCH_TESTS_NextEvent(LAUNCH_TESTS_Event *event, uint32_t time_ms) {
+	event->type = 1 + LAUNCH_TESTS_Random() % 4;
+	event->start_ms = time_ms + 500 + LAUNCH_TESTS_Random() % LAUNCH_TESTS_EVENT_GAP_MS;
+
+	switch (event->type) {
+	case LAUNCH_TESTS_EVENT_SHOCK:
+		event->length_ms = 1 + LAUNCH_TESTS_Random() % 8;
+		event->amplitude = LAUNCH_TESTS_Uniform(3.0f, LAUNCH_TESTS_SHOCK_G) * FLIGHTSIM_GRAVITY;
+		break;
+	case LAUNCH_TESTS_EVENT_LIFT:
+		event->length_ms = 1500 + LAUNCH_TESTS_Random() % 1500;
+		event->amplitude = LAUNCH_TESTS_Uniform(0.2f, LAUNCH_TESTS_LIFT_M);
+		break;
+	case LAUNCH_TESTS_EVENT_VIBRATION:
+		event->length_ms = 500 + LAUNCH_TESTS_Random() % 1500;
+		event->amplitude = LAUNCH_TESTS_Uniform(10.0f, LAUNCH_TESTS_VIBRATION_MPS2);
+		event->period_ms = 10 + LAUNCH_TESTS_Random() % 11;
+		break;
+	case LAUNCH_TESTS_EVENT_GUST:
+		event->period_ms = 100 + LAUNCH_TESTS_Random() % 400; // Ramp
+		event->length_ms = 2 * event->period_ms + LAUNCH_TESTS_Random() % 1000;
+		event->amplitude = LAUNCH_TESTS_Uniform(5.0f, LAUNCH_TESTS_GUST_M);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Disturbance of the event at time_ms: specific force added to the accelerometer and
+ * altitude added to the barometer.
+ */
+static void LAUNCH_TESTS_Disturbance(const LAUNCH_TESTS_Event *event, uint32_t time_ms, float *accel_mps2,
+		float *alt_m) {
+	*accel_mps2 = 0;
+	*alt_m = 0;
+	if (time_ms < event->start_ms || time_ms >= event->start_ms + event->length_ms) {
+		return;
+	}
+
+	float t = (float)(time_ms - event->start_ms);
+	float length = (float)event->length_ms;
+	float w = 2.0f * (float)M_PI / length;
+	switch (event->type) {
+	case LAUNCH_TESTS_EVENT_SHOCK:
+		*accel_mps2 = event->amplitude;
+		break;
+	case LAUNCH_TESTS_EVENT_LIFT:
+		// Up and down: h/2.(1 - cos(wt)), w in rad/ms
+		*alt_m = event->amplitude / 2.0f * (1.0f - cosf(w * t));
+		*accel_mps2 = event->amplitude / 2.0f * w * w * 1e6f * cosf(w * t);
+		break;
+	case LAUNCH_TESTS_EVENT_VIBRATION:
+		*accel_mps2 = event->amplitude * sinf(2.0f * (float)M_PI * t / (float)event->period_ms);
+		break;
+	case LAUNCH_TESTS_EVENT_GUST: {
+		float ramp = (float)event->period_ms;
+		if (t < ramp) {
+			*alt_m = event->amplitude * t / ramp;
+		} else if (t > length - ramp) {
+			*alt_m = event->amplitude * (length - t) / ramp;
+		} else {
+			*alt_m = event->amplitude;
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+/**
+ * Replay one profile until detection (plus 5 s), or the end of the pad time when there is no launch.
+ */
+static void LAUNCH_TESTS_ReplayFlight(const FLIGHTSIM_Profile *profile, uint8_t mode, uint8_t launches,
+		LAUNCH_TESTS_Result *result) {
+	FLIGHTSIM_Sample sample;
+	LAUNCH_TESTS_Event event;
+	float accel_mps2;
+	float alt_m;
+
+	FLIGHTSIM_Init(&sim, profile);
+	LAUNCH_Init(&launch, NULL);
+	LAUNCH_TESTS_NextEvent(&event, 0);
+	result->flights++;
+
+	uint32_t launch_ms = profile->pad_time_ms;
+	uint32_t end_ms = launches ? launch_ms + 5000 : launch_ms - 1;
+	while (FLIGHTSIM_Step(&sim, &sample) == 0 && sample.time_ms < end_ms) {
+		uint32_t time_ms = sample.time_ms;
+		uint32_t time_us = time_ms * 1000;
+
+		if (time_ms >= event.start_ms + event.length_ms) {
+			result->events[event.type]++;
+			LAUNCH_TESTS_NextEvent(&event, time_ms);
+		}
+		if (launches && event.start_ms + event.length_ms + LAUNCH_TESTS_QUIET_MS > launch_ms) {
+			event.type = LAUNCH_TESTS_EVENT_NONE; // Quiet before lift-off
+		}
+		LAUNCH_TESTS_Disturbance(&event, time_ms, &accel_mps2, &alt_m);
+
+		int8_t detected = 0;
+		if (mode == LAUNCH_TESTS_MODE_ACCEL) {
+			detected = LAUNCH_UpdateAccel(&launch, LAUNCH_TESTS_Accelerometer(sample.accel_mps2 + accel_mps2), time_us);
+		}
+		if (time_ms % LAUNCH_TESTS_BARO_MS == 0) {
+			detected |= LAUNCH_UpdateBaro(&launch, (int32_t)floorf((sample.baro_alt_m + alt_m) * 1000.0f + 0.5f), time_us);
+		}
+		if (detected != 1) {
+			continue;
+		}
+
+		if (sample.phase == FLIGHTSIM_PHASE_PAD) {
+			result->early++; // False positive
+			break;
+		}
+		float latency_ms = (float)(launch.detect_time_us - launch_ms * 1000) / 1000.0f;
+		float error_ms = (float)(int32_t)(launch.launch_time_us - launch_ms * 1000) / 1000.0f;
+		result->detected++;
+		result->reasons[launch.reason]++;
+		result->latency_mean_ms += latency_ms;
+		result->latency_max_ms = fmaxf(result->latency_max_ms, latency_ms);
+		result->error_mean_ms += error_ms;
+		result->error_max_ms = fmaxf(result->error_max_ms, fabsf(error_ms));
+		break;
+	}
+	result->pad_ms += launch_ms < sample.time_ms ? launch_ms : sample.time_ms;
+
+	result->stats.accel_candidates += launch.stats.accel_candidates;
+	result->stats.accel_rejected += launch.stats.accel_rejected;
+	result->stats.baro_candidates += launch.stats.baro_candidates;
+	result->stats.baro_rejected += launch.stats.baro_rejected;
+}
+
+/**
+ * Launch profiles: LAUNCH_TESTS_FLIGHTS flights with pad handling before lift-off.
+ */
+static void LAUNCH_TESTS_ReplayLaunches(uint8_t mode, float boost_mps2, LAUNCH_TESTS_Result *result) {
+	FLIGHTSIM_Profile profile;
+
+	*result = (LAUNCH_TESTS_Result) { 0 };
+	for (uint16_t i = 0; i < LAUNCH_TESTS_FLIGHTS; i++) {
+		FLIGHTSIM_DefaultProfile(&profile, 1 + i * 4547); // Boost spread over 60 to 150 m/s^2
+		profile.sample_period_ms = 1;
+		profile.pad_time_ms = LAUNCH_TESTS_PAD_MS + (i * 37) % LAUNCH_TESTS_BARO_MS; // Lift-off between barometer samples
+		if (boost_mps2 > 0) {
+			profile.boost_accel_mps2 = boost_mps2;
+		}
+		LAUNCH_TESTS_ReplayFlight(&profile, mode, 1, result);
+	}
+	if (result->detected > 0) {
+		result->latency_mean_ms /= result->detected;
+		result->error_mean_ms /= result->detected;
+	}
+}
+
+/**
+ * Noise-only profiles: pad handling and gusts, no launch.
+ */
+static void LAUNCH_TESTS_ReplayNoise(uint8_t mode, LAUNCH_TESTS_Result *result) {
+	FLIGHTSIM_Profile profile;
+
+	*result = (LAUNCH_TESTS_Result) { 0 };
+	for (uint16_t i = 0; i < LAUNCH_TESTS_NOISE_RUNS; i++) {
+		FLIGHTSIM_DefaultProfile(&profile, 7 + i * 7919);
+		profile.sample_period_ms = 1;
+		profile.pad_time_ms = LAUNCH_TESTS_NOISE_MS;
+		LAUNCH_TESTS_ReplayFlight(&profile, mode, 0, result);
+	}
+}
+
+static void LAUNCH_TESTS_LogResult(const LAUNCH_TESTS_Result *result) {
+	float hours = (float)result->pad_ms / 3600000.0f;
+	printf("%u/%u detected (accel %u, baro %u, combined %u): latency mean %.1f ms, max %.1f ms; lift-off error mean %.1f ms, max %.1f ms\n",
+			result->detected, result->flights, result->reasons[LAUNCH_REASON_ACCEL], result->reasons[LAUNCH_REASON_BARO],
+			result->reasons[LAUNCH_REASON_COMBINED], result->latency_mean_ms, result->latency_max_ms,
+			result->error_mean_ms, result->error_max_ms);
+	printf("Pad %.2f h: %u shocks, %u lifts, %u vibrations, %u gusts; %u false launches (%.2f per hour)\n", hours,
+			result->events[LAUNCH_TESTS_EVENT_SHOCK], result->events[LAUNCH_TESTS_EVENT_LIFT],
+			result->events[LAUNCH_TESTS_EVENT_VIBRATION], result->events[LAUNCH_TESTS_EVENT_GUST], result->early,
+			hours > 0 ? result->early / hours : 0);
+	printf("Accel %lu candidates, %lu rejected; baro %lu candidates, %lu rejected\n", result->stats.accel_candidates,
+			result->stats.accel_rejected, result->stats.baro_candidates, result->stats.baro_rejected);
+}
+
+void LAUNCH_TESTS_Replay_LogSTLINK() {
+	LAUNCH_TESTS_Result result;
+	LAUNCH_Config config;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: launch profiles, accelerometer detection in less than 100 ms, lift-off back-dated
+	LAUNCH_TESTS_ReplayLaunches(LAUNCH_TESTS_MODE_ACCEL, 0, &result);
+	LAUNCH_TESTS_LogResult(&result);
+	if (result.reasons[LAUNCH_REASON_ACCEL] == LAUNCH_TESTS_FLIGHTS && result.early == 0
+			&& result.latency_max_ms < LAUNCH_TESTS_ACCEL_LATENCY_MS && result.error_max_ms <= LAUNCH_TESTS_ACCEL_ERROR_MS) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: low thrust, below the accelerometer threshold, confirmed by the barometer
+	LAUNCH_TESTS_ReplayLaunches(LAUNCH_TESTS_MODE_ACCEL, LAUNCH_TESTS_LOW_THRUST_MPS2, &result);
+	LAUNCH_TESTS_LogResult(&result);
+	if (result.reasons[LAUNCH_REASON_COMBINED] == LAUNCH_TESTS_FLIGHTS && result.early == 0
+			&& result.latency_max_ms < LAUNCH_TESTS_COMBINED_LATENCY_MS
+			&& result.error_max_ms <= LAUNCH_TESTS_ACCEL_ERROR_MS) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: no accelerometer, barometer alone
+	LAUNCH_TESTS_ReplayLaunches(LAUNCH_TESTS_MODE_NO_IMU, 0, &result);
+	LAUNCH_TESTS_LogResult(&result);
+	if (result.reasons[LAUNCH_REASON_BARO] == LAUNCH_TESTS_FLIGHTS && result.early == 0
+			&& result.latency_max_ms < LAUNCH_TESTS_BARO_LATENCY_MS && result.error_max_ms <= LAUNCH_TESTS_BARO_ERROR_MS) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: noise-only, pad handling and gusts rejected
+	LAUNCH_TESTS_ReplayNoise(LAUNCH_TESTS_MODE_ACCEL, &result);
+	LAUNCH_TESTS_LogResult(&result);
+	if (result.early == 0 && result.stats.accel_rejected > 0 && result.stats.baro_rejected > 0) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: noise-only without accelerometer
+	LAUNCH_TESTS_ReplayNoise(LAUNCH_TESTS_MODE_NO_IMU, &result);
+	LAUNCH_TESTS_LogResult(&result);
+	if (result.early == 0 && result.stats.baro_rejected > 0) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: old samples ignored, invalid configuration
+	LAUNCH_Init(&launch, NULL);
+	LAUNCH_UpdateAccel(&launch, LAUNCH_GRAVITY_MMS2, 2000);
+	LAUNCH_UpdateBaro(&launch, 0, 2000);
+	LAUNCH_DefaultConfig(&config);
+	config.liftoff_mps2 = 5.0f;
+	if (LAUNCH_UpdateAccel(&launch, 100000, 1000) == 0 && launch.stats.accel_candidates == 0
+			&& LAUNCH_UpdateBaro(&launch, 100000, 1000) == 0 && launch.gain_mm == 0
+			&& LAUNCH_Init(&launch, &config) == -1 && LAUNCH_Init(NULL, NULL) == -1) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Debug timer Low
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
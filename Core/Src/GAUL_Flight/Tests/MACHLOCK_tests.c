@@ -0,0 +1,207 @@
+/*
+ * MACHLOCK_tests.c
+ *
+ * Replay synthetic flights with a transonic pressure disturbance through the apogee
+ * detector, with and without Mach lock.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/MACHLOCK_tests.h"
+
+#include "GAUL_Flight/APOGEE.h"
+#include "GAUL_Flight/Tests/FLIGHTSIM.h"
+
+#include <stdio.h>
+
+#define MACHLOCK_TESTS_MODE_NONE  0 // No Mach lock
+#define MACHLOCK_TESTS_MODE_ACCEL 1 // Mach lock with accelerometer
+#define MACHLOCK_TESTS_MODE_TIMER 2 // Mach lock with timer only
+
+typedef struct {
+	uint16_t false_apogee;
+	uint16_t missed;
+	int32_t sum_latency;
+	int32_t max_latency;
+	uint16_t detected;
+} MACHLOCK_TESTS_Result;
+
+static APOGEE_Detector detector;
+static MACHLOCK lock;
+static FLIGHTSIM sim;
+
+/**
+ * Replay one flight, return the apogee latency in samples, -1000 false apogee, -1001 missed.
+ * If log is 1, lock transitions are logged.
+ */
+static int32_t MACHLOCK_TESTS_ReplayFlight(const FLIGHTSIM_Profile *profile, uint8_t mode, uint8_t log) {
+	FLIGHTSIM_Sample sample;
+	MACHLOCK_Config config;
+
+	MACHLOCK_DefaultConfig(&config);
+	if (mode == MACHLOCK_TESTS_MODE_TIMER) {
+		config.min_lock_ms = MACHLOCK_TESTS_TIMER_LOCK_MS;
+	}
+
+	FLIGHTSIM_Init(&sim, profile);
+	APOGEE_Init(&detector, NULL);
+	MACHLOCK_Init(&lock, &config);
+
+	while (FLIGHTSIM_Step(&sim, &sample) == 0) {
+		if (sample.phase == FLIGHTSIM_PHASE_PAD) {
+			continue;
+		}
+		if (!detector.armed) {
+			APOGEE_Arm(&detector, sample.time_ms);
+			if (mode != MACHLOCK_TESTS_MODE_NONE) {
+				MACHLOCK_Launch(&lock, sample.time_ms);
+				if (log) {
+					MACHLOCK_TESTS_LogTransition(&lock);
+				}
+			}
+		}
+
+		int8_t result;
+		if (mode != MACHLOCK_TESTS_MODE_NONE
+				&& MACHLOCK_Update(&lock, sample.time_ms, detector.velocity_mps, sample.accel_mps2, mode == MACHLOCK_TESTS_MODE_ACCEL) == 1) {
+			APOGEE_Propagate(&detector, lock.velocity_mps, sample.time_ms);
+			result = 0;
+		} else {
+			result = APOGEE_Update(&detector, sample.baro_alt_m, sample.time_ms);
+		}
+		if (log && lock.transition != MACHLOCK_TRANSITION_NONE) {
+			MACHLOCK_TESTS_LogTransition(&lock);
+		}
+
+		if (result == 1) {
+			if (sample.true_vel_mps > 5.0f) {
+				return -1000; // False apogee
+			}
+			return ((int32_t)sample.time_ms - (int32_t)sim.apogee_time_ms) / (int32_t)profile->sample_period_ms;
+		}
+
+		if (sample.phase >= FLIGHTSIM_PHASE_DROGUE && sample.time_ms - sim.apogee_time_ms > 10000) {
+			break;
+		}
+	}
+
+	return -1001; // Missed
+}
+
+static void MACHLOCK_TESTS_Run(const char *name, float disturbance_m, uint8_t mode, MACHLOCK_TESTS_Result *result) {
+	FLIGHTSIM_Profile profile;
+
+	result->false_apogee = 0;
+	result->missed = 0;
+	result->sum_latency = 0;
+	result->max_latency = 0;
+	result->detected = 0;
+
+	for (uint16_t i = 0; i < MACHLOCK_TESTS_FLIGHTS; i++) {
+		FLIGHTSIM_DefaultProfile(&profile, 1 + i * 7919);
+		profile.disturbance_m = disturbance_m;
+
+		int32_t latency = MACHLOCK_TESTS_ReplayFlight(&profile, mode, 0);
+		if (latency == -1000) {
+			result->false_apogee++;
+		} else if (latency == -1001) {
+			result->missed++;
+		} else {
+			result->sum_latency += latency;
+			if (latency > result->max_latency) {
+				result->max_latency = latency;
+			}
+			result->detected++;
+		}
+	}
+
+	printf("%s: %u false, %u missed, latency mean %.2f max %ld samples\n", name, result->false_apogee, result->missed,
+			result->detected > 0 ? (float)result->sum_latency / result->detected : 0.0f, result->max_latency);
+}
+
+void MACHLOCK_TESTS_Replay_LogSTLINK() {
+	MACHLOCK_TESTS_Result baseline;
+	MACHLOCK_TESTS_Result result;
+	FLIGHTSIM_Profile profile;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Reference latency, no disturbance, no lock
+	MACHLOCK_TESTS_Run("Baseline", 0, MACHLOCK_TESTS_MODE_NONE, &baseline);
+
+	// Test 1: disturbance fools the detector without Mach lock (only logged)
+	MACHLOCK_TESTS_Run("No lock", MACHLOCK_TESTS_DISTURBANCE_M, MACHLOCK_TESTS_MODE_NONE, &result);
+	printf("Test 1 logged\n");
+
+	// Test 2: Mach lock with accelerometer, no false apogee, same latency as baseline
+	MACHLOCK_TESTS_Run("Accel lock", MACHLOCK_TESTS_DISTURBANCE_M, MACHLOCK_TESTS_MODE_ACCEL, &result);
+	if (result.false_apogee == 0 && result.missed == 0 && result.max_latency <= baseline.max_latency
+			&& result.sum_latency <= baseline.sum_latency + baseline.detected) { // Mean within 1 sample
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: Mach lock with timer only
+	MACHLOCK_TESTS_Run("Timer lock", MACHLOCK_TESTS_DISTURBANCE_M, MACHLOCK_TESTS_MODE_TIMER, &result);
+	if (result.false_apogee == 0 && result.missed == 0 && result.max_latency <= baseline.max_latency) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: same flight gives the same lock window
+	FLIGHTSIM_DefaultProfile(&profile, 150);
+	profile.disturbance_m = MACHLOCK_TESTS_DISTURBANCE_M;
+	MACHLOCK_TESTS_ReplayFlight(&profile, MACHLOCK_TESTS_MODE_ACCEL, 1);
+	uint32_t enter_time_ms = lock.enter_time_ms;
+	uint32_t exit_time_ms = lock.exit_time_ms;
+	MACHLOCK_TESTS_ReplayFlight(&profile, MACHLOCK_TESTS_MODE_ACCEL, 0);
+	if (lock.enter_time_ms == enter_time_ms && lock.exit_time_ms == exit_time_ms && exit_time_ms > enter_time_ms) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: one accelerometer dropout at Mach 1.2 after min_lock_ms keeps the lock and the
+	// velocity, the timer lock only takes over after accel_timeout_ms without accelerometer
+	MACHLOCK_Init(&lock, NULL);
+	MACHLOCK_Launch(&lock, 0);
+	uint32_t time_ms = 0;
+	uint8_t dropout_ok = 1;
+	while (time_ms < lock.config.min_lock_ms + 1000) {
+		time_ms += MACHLOCK_TESTS_PERIOD_MS;
+		// Boost to Mach 1.2 in 4 s, then constant velocity (specific force = 1g)
+		float accel_mps2 = MACHLOCK_GRAVITY + (time_ms <= 4000 ? MACHLOCK_TESTS_MACH12_MPS / 4.0f : 0);
+		dropout_ok &= MACHLOCK_Update(&lock, time_ms, 0, accel_mps2, 1) == 1;
+	}
+	float velocity_mps = lock.velocity_mps;
+	time_ms += MACHLOCK_TESTS_PERIOD_MS;
+	dropout_ok &= MACHLOCK_Update(&lock, time_ms, 0, 0, 0) == 1;
+	dropout_ok &= lock.state == MACHLOCK_STATE_LOCKED && lock.velocity_mps == velocity_mps;
+	while (lock.state == MACHLOCK_STATE_LOCKED && time_ms < lock.config.max_lock_ms) {
+		time_ms += MACHLOCK_TESTS_PERIOD_MS;
+		MACHLOCK_Update(&lock, time_ms, 0, 0, 0);
+	}
+	printf("Dropout at %.1f m/s: exit after %lu ms without accelerometer\n", velocity_mps,
+			lock.exit_time_ms - (lock.config.min_lock_ms + 1000));
+	if (dropout_ok && velocity_mps > MACHLOCK_TESTS_MACH12_MPS - 1.0f && lock.reason == MACHLOCK_REASON_TIMER
+			&& lock.exit_time_ms - (lock.config.min_lock_ms + 1000) >= lock.config.accel_timeout_ms) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void MACHLOCK_TESTS_LogTransition(MACHLOCK *lock) {
+	static const char *reasons[] = { "none", "launch", "velocity", "timer", "timeout" };
+	printf("%lu ms: Mach lock %s (%s, %.1f m/s)\n",
+			lock->transition == MACHLOCK_TRANSITION_ENTER ? lock->enter_time_ms : lock->exit_time_ms,
+			lock->transition == MACHLOCK_TRANSITION_ENTER ? "enter" : "exit",
+			reasons[lock->reason], lock->velocity_mps);
+}
@@ -0,0 +1,138 @@
+/*
+ * THRESHOLD_tests.c
+ *
+ * Check that pressure-domain decisions are the same as altitude-domain decisions
+ * (BMP280_PressureToAltitude then compare).
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/THRESHOLD_tests.h"
+
+#include "GAUL_Drivers/BMP280.h"
+#include "GAUL_Flight/Tests/FLIGHTSIM.h"
+
+#include <stdio.h>
+
+static THRESHOLD_Engine engine;
+static FLIGHTSIM sim;
+
+/**
+ * Altitude-domain decision, what the code did before the THRESHOLD module.
+ */
+static uint8_t THRESHOLD_TESTS_AltitudeCompare(const THRESHOLD *threshold, uint32_t press_Pa_Q8, float press_ref_Pa) {
+	float alt_m = BMP280_PressureToAltitude((float)press_Pa_Q8 / (float)(1 << 8), press_ref_Pa);
+	if (threshold->direction == THRESHOLD_ABOVE) {
+		return alt_m > threshold->alt_m;
+	}
+	return alt_m < threshold->alt_m;
+}
+
+static void THRESHOLD_TESTS_Setup(float press_ref_Pa) {
+	THRESHOLD_Init(&engine);
+	THRESHOLD_Add(&engine, 300.0f, THRESHOLD_ABOVE, 1);  // e.g. boost confirmed
+	THRESHOLD_Add(&engine, 450.0f, THRESHOLD_BELOW, 1);  // e.g. main deploy
+	THRESHOLD_Add(&engine, 3000.0f, THRESHOLD_ABOVE, 3); // debounced
+	THRESHOLD_Add(&engine, 20.0f, THRESHOLD_BELOW, 1);   // e.g. landing
+	THRESHOLD_Add(&engine, -15.5f, THRESHOLD_ABOVE, 1);  // below ground reference
+	THRESHOLD_Arm(&engine, press_ref_Pa);
+}
+
+void THRESHOLD_TESTS_Equivalence_LogSTLINK() {
+	static const float references[] = { 101325.0f, 98765.4f, 93000.0f };
+	uint32_t mismatches;
+	FLIGHTSIM_Profile profile;
+	FLIGHTSIM_Sample sample;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: every Q24.8 pressure around each bound
+	mismatches = 0;
+	for (uint8_t r = 0; r < sizeof(references) / sizeof(references[0]); r++) {
+		THRESHOLD_TESTS_Setup(references[r]);
+		for (uint8_t i = 0; i < engine.size; i++) {
+			THRESHOLD *threshold = &engine.thresholds[i];
+			for (uint32_t q = threshold->press_Pa_Q8 - THRESHOLD_TESTS_SWEEP_Q8; q <= threshold->press_Pa_Q8 + THRESHOLD_TESTS_SWEEP_Q8; q++) {
+				if (THRESHOLD_Compare(threshold, q) != THRESHOLD_TESTS_AltitudeCompare(threshold, q, references[r])) {
+					mismatches++;
+				}
+			}
+		}
+	}
+	printf("Sweep mismatches: %lu\n", mismatches);
+	printf("Test 1 %s\n", mismatches == 0 ? "passed" : "failed");
+
+	// Test 2: random pressures between 300 and 1100 hPa
+	mismatches = 0;
+	FLIGHTSIM_DefaultProfile(&profile, 12345);
+	FLIGHTSIM_Init(&sim, &profile);
+	THRESHOLD_TESTS_Setup(references[0]);
+	for (uint16_t n = 0; n < THRESHOLD_TESTS_RANDOM_SAMPLES; n++) {
+		uint32_t q = (30000u << 8) + FLIGHTSIM_Random(&sim) % (80000u << 8);
+		for (uint8_t i = 0; i < engine.size; i++) {
+			if (THRESHOLD_Compare(&engine.thresholds[i], q) != THRESHOLD_TESTS_AltitudeCompare(&engine.thresholds[i], q, references[0])) {
+				mismatches++;
+			}
+		}
+	}
+	printf("Random mismatches: %lu\n", mismatches);
+	printf("Test 2 %s\n", mismatches == 0 ? "passed" : "failed");
+
+	// Test 3: events of a full flight happen on the same sample in both domains
+	uint32_t event_time_pressure[THRESHOLD_MAX] = { 0 };
+	uint32_t event_time_altitude[THRESHOLD_MAX] = { 0 };
+	uint8_t counts[THRESHOLD_MAX] = { 0 };
+	FLIGHTSIM_DefaultProfile(&profile, 777);
+	FLIGHTSIM_Init(&sim, &profile);
+	THRESHOLD_TESTS_Setup(FLIGHTSIM_PRESS_REF_PA);
+	THRESHOLD_SetEnabled(&engine, 1, 0);
+	THRESHOLD_SetEnabled(&engine, 3, 0);
+	uint32_t ticks_pressure = 0;
+	uint32_t ticks_altitude = 0;
+	while (FLIGHTSIM_Step(&sim, &sample) == 0) {
+		uint32_t q = (uint32_t)(sample.press_Pa * 256.0f);
+
+		// "Below" thresholds only after apogee
+		if (sample.phase >= FLIGHTSIM_PHASE_DROGUE && !engine.thresholds[1].enabled) {
+			THRESHOLD_SetEnabled(&engine, 1, 1);
+			THRESHOLD_SetEnabled(&engine, 3, 1);
+		}
+
+		uint32_t start = HAL_GetTick();
+		uint8_t events = THRESHOLD_Update(&engine, q);
+		ticks_pressure += HAL_GetTick() - start;
+
+		for (uint8_t i = 0; i < engine.size; i++) {
+			if (events & (1 << i)) {
+				event_time_pressure[i] = sample.time_ms;
+			}
+		}
+
+		start = HAL_GetTick();
+		for (uint8_t i = 0; i < engine.size; i++) {
+			THRESHOLD *threshold = &engine.thresholds[i];
+			if (event_time_altitude[i] != 0 || !threshold->enabled) {
+				continue;
+			}
+			counts[i] = THRESHOLD_TESTS_AltitudeCompare(threshold, q, FLIGHTSIM_PRESS_REF_PA) ? counts[i] + 1 : 0;
+			if (counts[i] >= threshold->samples) {
+				event_time_altitude[i] = sample.time_ms;
+			}
+		}
+		ticks_altitude += HAL_GetTick() - start;
+	}
+	mismatches = 0;
+	for (uint8_t i = 0; i < engine.size; i++) {
+		printf("Threshold %u: %lu ms (pressure) %lu ms (altitude)\n", i, event_time_pressure[i], event_time_altitude[i]);
+		if (event_time_pressure[i] != event_time_altitude[i]) {
+			mismatches++;
+		}
+	}
+	printf("Flight time: %lu ms (pressure) %lu ms (altitude)\n", ticks_pressure, ticks_altitude);
+	printf("Test 3 %s\n", mismatches == 0 ? "passed" : "failed");
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
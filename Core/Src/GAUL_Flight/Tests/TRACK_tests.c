@@ -0,0 +1,366 @@
+/*
+ * TRACK_tests.c
+ *
+ * Synthetic trajectories (straight, accelerating, turning, descending) sampled by a GNSS
+ * at 1 to 10 Hz with noise, the fixes given TRACK_TESTS_LATENCY_MS after their epoch. The
+ * estimate is asked every TRACK_TESTS_QUERY_MS and compared to the true position at the
+ * same time, and to the last fix as is (no extrapolation).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_Flight/Tests/TRACK_tests.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TRACK_TESTS_PAD_LATITUDE_E7  484634000
+#define TRACK_TESTS_PAD_LONGITUDE_E7 -710562000
+#define TRACK_TESTS_PAD_ALTITUDE_M 160.0
+#define TRACK_TESTS_START_MS       1000     // HAL tick of the first epoch
+#define TRACK_TESTS_SETTLE_MS      1000     // History filled, not measured before
+
+typedef struct {
+	const char *name;
+	double speed_mps;         // Horizontal speed at the start...
+	double course_deg;
+	double accel_mps2;        // ...changed by this along the course...
+	uint32_t accel_end_ms;    // ...until this time...
+	double coast_mps2;        // ...then this
+	double turn_dps;          // Course rate
+	double climb_mps;         // Vertical speed at the start...
+	double climb_accel_mps2;  // ...changed by this until accel_end_ms...
+	double climb_coast_mps2;  // ...then this
+} TRACK_TESTS_Profile;
+
+typedef struct {
+	double east_m;
+	double north_m;
+	double up_m;
+	double speed_mps;
+	double course_deg;
+	double climb_mps;
+} TRACK_TESTS_Truth;
+
+typedef struct {
+	double mean_m;            // Horizontal error of the estimate
+	double max_m;
+	double raw_mean_m;        // Horizontal error of the last fix, not extrapolated
+	double up_mean_m;         // Vertical error of the estimate
+	double up_max_m;
+	double jump_m;            // Largest change of the horizontal error between two queries
+	uint32_t queries;
+	TRACK_Stats stats;
+} TRACK_TESTS_Result;
+
+static const TRACK_TESTS_Profile TRACK_TESTS_CRUISE = { "cruise", 60, 30, 0, 0, 0, 0, 0, 0, 0 };
+static const TRACK_TESTS_Profile TRACK_TESTS_BOOST = { "boost", 0, 45, 20, 4000, -3, 0, 0, 80, -10 };
+static const TRACK_TESTS_Profile TRACK_TESTS_TURN = { "turn", 40, 0, 0, 0, 0, 15, -5, 0, 0 };
+static const TRACK_TESTS_Profile TRACK_TESTS_DESCENT = { "descent", 6, 250, 0, 0, 0, 0, -6, 0, 0 };
+
+static const uint16_t TRACK_TESTS_PERIODS_MS[] = { 100, 200, 1000 };
+
+static TRACK track;
+static GEO frame; // True trajectory from the pad, see GEO_tests.c for its error
+static uint32_t TRACK_TESTS_rng = 1;
+
+static double TRACK_TESTS_Uniform() {
+	TRACK_TESTS_rng ^= TRACK_TESTS_rng << 13;
+	TRACK_TESTS_rng ^= TRACK_TESTS_rng >> 17;
+	TRACK_TESTS_rng ^= TRACK_TESTS_rng << 5;
+	return (TRACK_TESTS_rng + 0.5) / 4294967296.0;
+}
+
+/**
+ * Normal noise, standard deviation "sigma" (Box-Muller).
+ */
+static double TRACK_TESTS_Noise(double sigma) {
+	return sigma * sqrt(-2.0 * log(TRACK_TESTS_Uniform())) * cos(2.0 * M_PI * TRACK_TESTS_Uniform());
+}
+
+/**
+ * Advance the true trajectory by 1 ms (velocity at the middle of the step).
+ */
+static void TRACK_TESTS_Step(const TRACK_TESTS_Profile *profile, uint32_t t_ms, TRACK_TESTS_Truth *truth) {
+	double accel = t_ms < profile->accel_end_ms ? profile->accel_mps2 : profile->coast_mps2;
+	double climb_accel = t_ms < profile->accel_end_ms ? profile->climb_accel_mps2 : profile->climb_coast_mps2;
+	double speed = truth->speed_mps + accel * 0.0005;
+	double course = (truth->course_deg + profile->turn_dps * 0.0005) * M_PI / 180.0;
+
+	truth->east_m += speed * sin(course) * 0.001;
+	truth->north_m += speed * cos(course) * 0.001;
+	truth->up_m += (truth->climb_mps + climb_accel * 0.0005) * 0.001;
+	truth->speed_mps = fmax(truth->speed_mps + accel * 0.001, 0);
+	truth->course_deg = fmod(truth->course_deg + profile->turn_dps * 0.001 + 360.0, 360.0);
+	truth->climb_mps += climb_accel * 0.001;
+}
+
+/**
+ * Latitude and longitude (1e-7 degree) to east/north from the pad (m).
+ */
+static void TRACK_TESTS_ToLocal(int32_t latitude_e7, int32_t longitude_e7, double *east_m, double *north_m) {
+	int32_t east_cm, north_cm;
+	GEO_ToLocal(&frame, latitude_e7, longitude_e7, &east_cm, &north_cm);
+	*east_m = east_cm / 100.0;
+	*north_m = north_cm / 100.0;
+}
+
+/**
+ * GNSS fix of the true state, with noise.
+ */
+static void TRACK_TESTS_Fix(const TRACK_TESTS_Truth *truth, uint32_t time_ms, TRACK_Fix *fix) {
+	double north_m = truth->north_m + TRACK_TESTS_Noise(TRACK_TESTS_NOISE_M);
+	double east_m = truth->east_m + TRACK_TESTS_Noise(TRACK_TESTS_NOISE_M);
+	int32_t latitude_e7, longitude_e7;
+	GEO_ToGlobal(&frame, (int32_t)lround(east_m * 100.0), (int32_t)lround(north_m * 100.0), &latitude_e7, &longitude_e7);
+	double speed = fmax(truth->speed_mps + TRACK_TESTS_Noise(TRACK_TESTS_SPEED_NOISE_MPS), 0);
+	double course = fmod(truth->course_deg + TRACK_TESTS_Noise(TRACK_TESTS_COURSE_NOISE_DEG) + 360.0, 360.0);
+	double altitude = TRACK_TESTS_PAD_ALTITUDE_M + truth->up_m + TRACK_TESTS_Noise(TRACK_TESTS_ALT_NOISE_M);
+
+	*fix = (TRACK_Fix) {
+		.time_ms = time_ms,
+		.latitude_e7 = latitude_e7,
+		.longitude_e7 = longitude_e7,
+		.speed_cms = (int32_t)lround(speed * 100.0),
+		.course_cdeg = (int32_t)lround(course * 100.0) % 36000,
+		.altitude = 1,
+		.altitude_ms = time_ms,
+		.altitude_cm = (int32_t)lround(altitude * 10.0) * 10, // 0.1 m in the GGA
+	};
+}
+
+/**
+ * Fly "profile" with a fix every "period_ms", the estimate asked every TRACK_TESTS_QUERY_MS.
+ */
+static void TRACK_TESTS_Run(const TRACK_TESTS_Profile *profile, uint16_t period_ms, const TRACK_Config *config,
+		TRACK_TESTS_Result *result) {
+	TRACK_TESTS_Truth truth = {
+		.speed_mps = profile->speed_mps,
+		.course_deg = profile->course_deg,
+		.climb_mps = profile->climb_mps,
+	};
+	TRACK_Fix fix;
+	TRACK_Fix last = { 0 };
+	TRACK_Estimate estimate;
+	uint8_t pending = 0;
+	uint8_t delivered = 0;
+	double previous_east = 0, previous_north = 0;
+	uint8_t has_previous = 0;
+
+	*result = (TRACK_TESTS_Result) { 0 };
+	TRACK_TESTS_rng = 1;
+	TRACK_Init(&track, config);
+
+	for (uint32_t t = 0; t <= TRACK_TESTS_DURATION_MS; t++) {
+		uint32_t now_ms = TRACK_TESTS_START_MS + t;
+		if (t % period_ms == 0) {
+			TRACK_TESTS_Fix(&truth, now_ms, &fix);
+			pending = 1;
+		}
+		if (pending && now_ms - fix.time_ms >= TRACK_TESTS_LATENCY_MS) {
+			if (!delivered) {
+				TRACK_SetPad(&track, &fix); // Pad at the first fix
+			}
+			TRACK_Update(&track, &fix, now_ms);
+			last = fix;
+			pending = 0;
+			delivered = 1;
+		}
+
+		if (delivered && t >= TRACK_TESTS_SETTLE_MS && t % TRACK_TESTS_QUERY_MS == 0) {
+			double east_m, north_m, raw_east_m, raw_north_m;
+			TRACK_Predict(&track, now_ms, &estimate);
+			TRACK_TESTS_ToLocal(estimate.latitude_e7, estimate.longitude_e7, &east_m, &north_m);
+			TRACK_TESTS_ToLocal(last.latitude_e7, last.longitude_e7, &raw_east_m, &raw_north_m);
+
+			double error_east = east_m - truth.east_m;
+			double error_north = north_m - truth.north_m;
+			double error = sqrt(error_east * error_east + error_north * error_north);
+			double up_error = fabs(estimate.altitude_cm / 100.0 - TRACK_TESTS_PAD_ALTITUDE_M - truth.up_m);
+			result->mean_m += error;
+			result->max_m = fmax(result->max_m, error);
+			result->raw_mean_m += sqrt((raw_east_m - truth.east_m) * (raw_east_m - truth.east_m)
+					+ (raw_north_m - truth.north_m) * (raw_north_m - truth.north_m));
+			result->up_mean_m += up_error;
+			result->up_max_m = fmax(result->up_max_m, up_error);
+			if (has_previous) {
+				double jump_east = error_east - previous_east;
+				double jump_north = error_north - previous_north;
+				result->jump_m = fmax(result->jump_m, sqrt(jump_east * jump_east + jump_north * jump_north));
+			}
+			previous_east = error_east;
+			previous_north = error_north;
+			has_previous = 1;
+			result->queries++;
+		}
+
+		TRACK_TESTS_Step(profile, t, &truth);
+	}
+
+	if (result->queries > 0) {
+		result->mean_m /= result->queries;
+		result->raw_mean_m /= result->queries;
+		result->up_mean_m /= result->queries;
+	}
+	result->stats = track.stats;
+	printf("%-8s %4u ms: %.2f m mean %.2f m max (last fix %.2f m mean), up %.2f m mean %.2f m max, jump %.3f m,"
+			" correction %.2f m max\n", profile->name, period_ms, result->mean_m, result->max_m, result->raw_mean_m,
+			result->up_mean_m, result->up_max_m, result->jump_m, result->stats.max_correction_cm / 100.0);
+}
+
+void TRACK_TESTS_Trajectories_LogSTLINK() {
+	TRACK_TESTS_Result result;
+	TRACK_TESTS_Result reference;
+	TRACK_Config config;
+	uint8_t passed;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	GEO_SetPad(&frame, TRACK_TESTS_PAD_LATITUDE_E7, TRACK_TESTS_PAD_LONGITUDE_E7);
+
+	// Test 1: straight track at 60 m/s, 1 to 10 Hz: the extrapolation follows, the last fix
+	// is late by the speed times its age
+	passed = 1;
+	for (uint8_t i = 0; i < sizeof(TRACK_TESTS_PERIODS_MS) / sizeof(TRACK_TESTS_PERIODS_MS[0]); i++) {
+		TRACK_TESTS_Run(&TRACK_TESTS_CRUISE, TRACK_TESTS_PERIODS_MS[i], NULL, &result);
+		passed &= result.mean_m < TRACK_TESTS_CRUISE_M && result.raw_mean_m > 10 * result.mean_m;
+	}
+	if (passed) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: accelerating (boost then coast), the acceleration of the history against a
+	// constant velocity
+	TRACK_DefaultConfig(&config);
+	config.accel_ms = 0;
+	TRACK_TESTS_Run(&TRACK_TESTS_BOOST, 100, &config, &reference);
+	for (uint8_t i = 0; i < sizeof(TRACK_TESTS_PERIODS_MS) / sizeof(TRACK_TESTS_PERIODS_MS[0]); i++) {
+		TRACK_TESTS_Run(&TRACK_TESTS_BOOST, TRACK_TESTS_PERIODS_MS[i], NULL, &result);
+		if (i == 0) {
+			passed = result.mean_m < TRACK_TESTS_BOOST_M && result.mean_m < reference.mean_m;
+		}
+	}
+	if (passed) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: turning at 15 deg/s, error against the fix rate
+	for (uint8_t i = 0; i < sizeof(TRACK_TESTS_PERIODS_MS) / sizeof(TRACK_TESTS_PERIODS_MS[0]); i++) {
+		TRACK_TESTS_Run(&TRACK_TESTS_TURN, TRACK_TESTS_PERIODS_MS[i], NULL, &result);
+		if (i == 0) {
+			passed = result.mean_m < TRACK_TESTS_TURN_M;
+		}
+	}
+	if (passed) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: continuity, the estimate does not jump at each fix (blended) while it jumps by
+	// the prediction error without blending
+	TRACK_DefaultConfig(&config);
+	config.blend_ms = 0;
+	TRACK_TESTS_Run(&TRACK_TESTS_TURN, 200, &config, &reference);
+	TRACK_TESTS_Run(&TRACK_TESTS_TURN, 200, NULL, &result);
+	if (result.jump_m < reference.jump_m / 3 && result.mean_m < 2 * reference.mean_m) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: descent under parachute, altitude extrapolated with the velocity of the history
+	passed = 1;
+	for (uint8_t i = 0; i < sizeof(TRACK_TESTS_PERIODS_MS) / sizeof(TRACK_TESTS_PERIODS_MS[0]); i++) {
+		TRACK_TESTS_Run(&TRACK_TESTS_DESCENT, TRACK_TESTS_PERIODS_MS[i], NULL, &result);
+		if (i == 0) {
+			passed = result.up_mean_m < TRACK_TESTS_DESCENT_M && result.mean_m < TRACK_TESTS_CRUISE_M;
+		}
+	}
+	if (passed) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Test 6: pad origin moved, no fix, late fix, stale fix, reacquisition
+	TRACK_Estimate estimate;
+	TRACK_Estimate moved;
+	TRACK_Fix fix = {
+		.time_ms = 1000,
+		.latitude_e7 = TRACK_TESTS_PAD_LATITUDE_E7,
+		.longitude_e7 = TRACK_TESTS_PAD_LONGITUDE_E7,
+		.speed_cms = 1000,
+		.course_cdeg = 9000,
+		.altitude = 1,
+		.altitude_ms = 1000,
+		.altitude_cm = 16000,
+	};
+	TRACK_Init(&track, NULL);
+	int8_t none = TRACK_Predict(&track, 1000, &estimate);
+	TRACK_Update(&track, &fix, 1000);
+	TRACK_Predict(&track, 1500, &estimate);
+	uint8_t origin = estimate.east_cm == 500 && estimate.north_cm == 0 && estimate.up_cm == 0
+			&& estimate.altitude_cm == 16000 && estimate.age_ms == 500;
+	fix.latitude_e7 += 1000; // 11 m north
+	fix.altitude_cm += 300;
+	TRACK_SetPad(&track, &fix);
+	TRACK_Predict(&track, 1500, &moved);
+	uint8_t kept = abs(moved.latitude_e7 - estimate.latitude_e7) <= 1 && abs(moved.longitude_e7 - estimate.longitude_e7) <= 1
+			&& moved.north_cm == -1112 && moved.altitude_cm == estimate.altitude_cm;
+	fix.time_ms = 900;
+	fix.altitude_ms = 900;
+	int8_t late = TRACK_Update(&track, &fix, 1600);
+	int8_t stale = TRACK_Predict(&track, 1000 + TRACK_DEFAULT_MAX_AGE_MS + 500, &estimate);
+	uint32_t stale_age = estimate.age_ms;
+	int32_t stale_east = estimate.east_cm;
+	fix.time_ms = 5000;
+	fix.altitude_ms = 5000;
+	fix.latitude_e7 += 10000; // 111 m north: reacquisition, not blended
+	TRACK_Update(&track, &fix, 5000);
+	TRACK_Predict(&track, 5000, &estimate);
+	if (none == -1 && origin && kept && late == -1 && track.stats.late == 1 && stale == -3
+			&& stale_age == TRACK_DEFAULT_MAX_AGE_MS + 500 && stale_east == 2000 && track.stats.snaps == 1
+			&& abs(estimate.latitude_e7 - fix.latitude_e7) <= 1 && TRACK_Init(&track, &(TRACK_Config) { 0 }) == -1
+			&& TRACK_Init(NULL, NULL) == -1) {
+		printf("Test 6 passed\n");
+	} else {
+		printf("Test 6 failed\n");
+	}
+
+	// Test 7: range and bearing from the pad, 5 km in every direction
+	TRACK_Init(&track, NULL);
+	fix = (TRACK_Fix) { .time_ms = 1000, .latitude_e7 = TRACK_TESTS_PAD_LATITUDE_E7,
+			.longitude_e7 = TRACK_TESTS_PAD_LONGITUDE_E7 };
+	TRACK_SetPad(&track, &fix);
+	int32_t range_cm = 0, bearing_cdeg = 0, round_trip = 0;
+	for (int32_t course = 0; course < 36000; course += 1500) {
+		int32_t east_cm = (int32_t)lround(500000.0 * sin(course / 100.0 * M_PI / 180.0));
+		int32_t north_cm = (int32_t)lround(500000.0 * cos(course / 100.0 * M_PI / 180.0));
+		fix.time_ms += 3000; // New fix, not blended (snap)
+		GEO_ToGlobal(&frame, east_cm, north_cm, &fix.latitude_e7, &fix.longitude_e7);
+		TRACK_Update(&track, &fix, fix.time_ms);
+		TRACK_Predict(&track, fix.time_ms, &estimate);
+		range_cm = fmax(range_cm, abs((int32_t)estimate.range_cm - 500000));
+		bearing_cdeg = fmax(bearing_cdeg, abs((estimate.bearing_cdeg - course + 18000) % 36000 - 18000));
+		round_trip = fmax(round_trip, abs(estimate.latitude_e7 - fix.latitude_e7));
+		round_trip = fmax(round_trip, abs(estimate.longitude_e7 - fix.longitude_e7));
+	}
+	printf("At 5 km: range error %ld cm, bearing error %ld cdeg, round trip %ld e-7 deg\n", range_cm, bearing_cdeg,
+			round_trip);
+	if (range_cm <= 1 && bearing_cdeg <= 1 && round_trip <= 1) {
+		printf("Test 7 passed\n");
+	} else {
+		printf("Test 7 failed\n");
+	}
+
+	// Debug timer Low
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
@@ -0,0 +1,410 @@
+/*
+ * BLACKBOX.c
+ *
+ * Pre-trigger capture of the full-rate samples.
+ *
+ * Pages between "tail" and "head" are kept in the ring, pages between "flush" and
+ * "flush_end" wait for the log (tail <= flush <= flush_end <= head, free running). A new
+ * page overwrites the page at "tail" unless it waits for the log: then the sample is
+ * dropped and counted, the pages already captured are never damaged. The samples and the
+ * flush run from the tasks (main loop), not from interrupts.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/BLACKBOX.h"
+
+#include <string.h>
+
+#define BLACKBOX_MASK (BLACKBOX_PAGES - 1)
+
+static uint8_t *BLACKBOX_Put32(uint8_t *p, uint32_t value) {
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+	return p + 4;
+}
+
+static uint32_t BLACKBOX_Get32(const uint8_t *p) {
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint8_t *BLACKBOX_PutVarint(uint8_t *p, uint32_t value) {
+	while (value >= 0x80) {
+		*p++ = value | 0x80;
+		value >>= 7;
+	}
+	*p++ = value;
+	return p;
+}
+
+static uint8_t *BLACKBOX_PutSigned(uint8_t *p, int32_t value) {
+	return BLACKBOX_PutVarint(p, (uint32_t)value << 1 ^ (uint32_t)(value >> 31)); // Zigzag
+}
+
+/**
+ * @return pointer after the varint, NULL if it goes past "end"
+ */
+static const uint8_t *BLACKBOX_GetVarint(const uint8_t *p, const uint8_t *end, uint32_t *value) {
+	*value = 0;
+	for (uint8_t shift = 0; p < end && shift < 35; shift += 7) {
+		uint8_t byte = *p++;
+		*value |= (uint32_t)(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return p;
+		}
+	}
+	return NULL;
+}
+
+static const uint8_t *BLACKBOX_GetSigned(const uint8_t *p, const uint8_t *end, int32_t *value) {
+	uint32_t zigzag;
+	p = BLACKBOX_GetVarint(p, end, &zigzag);
+	*value = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+	return p;
+}
+
+/**
+ * Start the page at head, overwriting the oldest page if it does not wait for the log.
+ *
+ * @retval 1 OK
+ * @retval 0 every page waits for the log
+ */
+static uint8_t BLACKBOX_StartPage(BLACKBOX *blackbox) {
+	if ((uint16_t)(blackbox->head - blackbox->tail) >= BLACKBOX_PAGES) {
+		if (blackbox->flush == blackbox->tail) {
+			if (blackbox->flush != blackbox->flush_end) {
+				return 0; // Oldest page waits for the log
+			}
+			blackbox->flush++;
+			blackbox->flush_end++;
+		}
+		blackbox->tail++;
+		blackbox->stats.overwritten++;
+	}
+
+	uint8_t *page = blackbox->pages[blackbox->head & BLACKBOX_MASK];
+	memset(page, BLACKBOX_TAG_END, BLACKBOX_PAGE_SIZE);
+	page[0] = blackbox->head;
+	page[1] = blackbox->head >> 8;
+	blackbox->used = BLACKBOX_PAGE_HEADER;
+	blackbox->filling = 1;
+	blackbox->has_baro = 0;
+	blackbox->has_gnss = 0;
+	return 1;
+}
+
+static void BLACKBOX_Seal(BLACKBOX *blackbox) {
+	if (!blackbox->filling || blackbox->used == BLACKBOX_PAGE_HEADER) {
+		return;
+	}
+	blackbox->head++;
+	blackbox->filling = 0;
+	if (blackbox->state == BLACKBOX_STATE_STREAMING) {
+		blackbox->flush_end = blackbox->head;
+	}
+}
+
+/**
+ * End of the post-trigger samples: the last page is sealed (written to the log) and the
+ * ring overwrites its oldest page again.
+ */
+static void BLACKBOX_Update(BLACKBOX *blackbox, uint32_t time_ms) {
+	if (blackbox->state == BLACKBOX_STATE_STREAMING && (int32_t)(time_ms - blackbox->stream_end_ms) >= 0) {
+		BLACKBOX_Seal(blackbox);
+		blackbox->state = BLACKBOX_STATE_ARMED;
+	}
+}
+
+/**
+ * @return where to write a sample of BLACKBOX_MAX_SAMPLE bytes at most, NULL if dropped
+ */
+static uint8_t *BLACKBOX_Reserve(BLACKBOX *blackbox) {
+	if (blackbox->filling && blackbox->used + BLACKBOX_MAX_SAMPLE > BLACKBOX_PAGE_SIZE) {
+		BLACKBOX_Seal(blackbox);
+	}
+	if (!blackbox->filling && !BLACKBOX_StartPage(blackbox)) {
+		blackbox->stats.dropped++;
+		return NULL;
+	}
+	return blackbox->pages[blackbox->head & BLACKBOX_MASK] + blackbox->used;
+}
+
+static void BLACKBOX_Commit(BLACKBOX *blackbox, const uint8_t *start, const uint8_t *end) {
+	blackbox->used += end - start;
+	blackbox->stats.samples++;
+	blackbox->stats.bytes += end - start;
+}
+
+/**
+ * @param post_ms: samples written after a trigger, 0 for BLACKBOX_DEFAULT_POST_MS.
+ */
+void BLACKBOX_Init(BLACKBOX *blackbox, uint32_t post_ms) {
+	memset(blackbox, 0, sizeof(BLACKBOX));
+	blackbox->post_ms = post_ms == 0 ? BLACKBOX_DEFAULT_POST_MS : post_ms;
+	blackbox->state = BLACKBOX_STATE_ARMED;
+}
+
+/**
+ * Capture a barometer sample (BMP280 compensated values).
+ */
+void BLACKBOX_AddBaro(BLACKBOX *blackbox, uint32_t time_ms, uint32_t press_Pa_Q8, int16_t temp_cC) {
+	BLACKBOX_Update(blackbox, time_ms);
+	uint8_t *start = BLACKBOX_Reserve(blackbox);
+	if (start == NULL) {
+		return;
+	}
+
+	uint8_t *p = start;
+	if (blackbox->has_baro && (int32_t)(time_ms - blackbox->baro_time_ms) >= 0) {
+		*p++ = BLACKBOX_TAG_BARO;
+		p = BLACKBOX_PutVarint(p, time_ms - blackbox->baro_time_ms);
+		p = BLACKBOX_PutSigned(p, (int32_t)(press_Pa_Q8 - blackbox->press_Pa_Q8));
+		p = BLACKBOX_PutSigned(p, temp_cC - blackbox->temp_cC);
+	} else {
+		*p++ = BLACKBOX_TAG_BARO | BLACKBOX_TAG_KEY;
+		p = BLACKBOX_Put32(p, time_ms);
+		p = BLACKBOX_Put32(p, press_Pa_Q8);
+		*p++ = temp_cC;
+		*p++ = (uint16_t)temp_cC >> 8;
+	}
+	BLACKBOX_Commit(blackbox, start, p);
+
+	blackbox->last_time_ms = time_ms;
+	blackbox->has_baro = 1;
+	blackbox->baro_time_ms = time_ms;
+	blackbox->press_Pa_Q8 = press_Pa_Q8;
+	blackbox->temp_cC = temp_cC;
+}
+
+/**
+ * Capture a GNSS position.
+ */
+void BLACKBOX_AddGNSS(BLACKBOX *blackbox, uint32_t time_ms, int32_t latitude_e7, int32_t longitude_e7,
+		uint8_t fix) {
+	BLACKBOX_Update(blackbox, time_ms);
+	uint8_t *start = BLACKBOX_Reserve(blackbox);
+	if (start == NULL) {
+		return;
+	}
+
+	uint8_t *p = start;
+	if (blackbox->has_gnss && (int32_t)(time_ms - blackbox->gnss_time_ms) >= 0) {
+		*p++ = BLACKBOX_TAG_GNSS;
+		p = BLACKBOX_PutVarint(p, time_ms - blackbox->gnss_time_ms);
+		p = BLACKBOX_PutSigned(p, latitude_e7 - blackbox->latitude_e7);
+		p = BLACKBOX_PutSigned(p, longitude_e7 - blackbox->longitude_e7);
+	} else {
+		*p++ = BLACKBOX_TAG_GNSS | BLACKBOX_TAG_KEY;
+		p = BLACKBOX_Put32(p, time_ms);
+		p = BLACKBOX_Put32(p, latitude_e7);
+		p = BLACKBOX_Put32(p, longitude_e7);
+	}
+	*p++ = fix;
+	BLACKBOX_Commit(blackbox, start, p);
+
+	blackbox->last_time_ms = time_ms;
+	blackbox->has_gnss = 1;
+	blackbox->gnss_time_ms = time_ms;
+	blackbox->latitude_e7 = latitude_e7;
+	blackbox->longitude_e7 = longitude_e7;
+}
+
+/**
+ * Freeze the samples captured so far and write them to the log, with the samples of the
+ * next "post_ms". A trigger while the post-trigger samples are written extends them.
+ *
+ * @param time_ms: time of the event (a TRIGGER sample marks it in the captured samples).
+ * @param reason: FLIGHT_PHASE_x reached.
+ */
+void BLACKBOX_Trigger(BLACKBOX *blackbox, uint32_t time_ms, uint8_t reason) {
+	uint8_t *start = BLACKBOX_Reserve(blackbox);
+	if (start != NULL) {
+		uint8_t *p = start;
+		*p++ = BLACKBOX_TAG_TRIGGER | BLACKBOX_TAG_KEY;
+		p = BLACKBOX_Put32(p, time_ms);
+		*p++ = reason;
+		BLACKBOX_Commit(blackbox, start, p);
+	}
+
+	// Pages not written yet: from the oldest page kept, or after the pages written for an
+	// earlier trigger ("flush" never goes before "tail")
+	blackbox->flush_end = blackbox->head;
+	blackbox->state = BLACKBOX_STATE_STREAMING;
+	blackbox->stream_end_ms = time_ms + blackbox->post_ms;
+	blackbox->stats.triggers++;
+}
+
+/**
+ * @return pages waiting for the log
+ */
+uint16_t BLACKBOX_Pending(const BLACKBOX *blackbox) {
+	return blackbox->flush_end - blackbox->flush;
+}
+
+/**
+ * Next chunk of the pages waiting for the log, without removing it.
+ *
+ * @param chunk: payload of a CAPTURE record, chunk index in the page then
+ *               BLACKBOX_CHUNK_SIZE bytes of the page.
+ *
+ * @retval 1 chunk available
+ * @retval 0 nothing waiting
+ */
+uint8_t BLACKBOX_PeekChunk(const BLACKBOX *blackbox, uint8_t chunk[LOGREC_PAYLOAD_SIZE]) {
+	if (blackbox->flush == blackbox->flush_end) {
+		return 0;
+	}
+	const uint8_t *page = blackbox->pages[blackbox->flush & BLACKBOX_MASK];
+	chunk[0] = blackbox->flush_chunk;
+	memcpy(chunk + 1, page + blackbox->flush_chunk * BLACKBOX_CHUNK_SIZE, BLACKBOX_CHUNK_SIZE);
+	return 1;
+}
+
+/**
+ * Remove the chunk returned by BLACKBOX_PeekChunk (written to the log).
+ */
+void BLACKBOX_PopChunk(BLACKBOX *blackbox) {
+	if (blackbox->flush == blackbox->flush_end) {
+		return;
+	}
+	blackbox->stats.chunks++;
+	if (++blackbox->flush_chunk == BLACKBOX_PAGE_CHUNKS) {
+		blackbox->flush_chunk = 0;
+		blackbox->flush++;
+	}
+}
+
+/**
+ * Write the pages waiting as CAPTURE records in the flight log (LOGREC_Write, never
+ * waits for the card). Stops at the first record dropped, it is written again at the next
+ * call.
+ *
+ * @param log: flight log encoder.
+ * @param time_ms: current time (time of the records).
+ * @param max_chunks: records to write at most (SD card bandwidth of the logging task).
+ *
+ * @return records written
+ */
+uint16_t BLACKBOX_Flush(BLACKBOX *blackbox, LOGREC *log, uint32_t time_ms, uint16_t max_chunks) {
+	LOGREC_Data data = { .time_ms = time_ms };
+	uint16_t written = 0;
+
+	while (written < max_chunks && BLACKBOX_PeekChunk(blackbox, data.capture)) {
+		if (LOGREC_Write(log, LOGREC_TYPE_CAPTURE, &data) != 0) {
+			break;
+		}
+		BLACKBOX_PopChunk(blackbox);
+		written++;
+	}
+	return written;
+}
+
+/**
+ * @return time covered by the ring, from the oldest page to the last sample (ms)
+ */
+uint32_t BLACKBOX_WindowMs(const BLACKBOX *blackbox) {
+	if (blackbox->head == blackbox->tail && (!blackbox->filling || blackbox->used == BLACKBOX_PAGE_HEADER)) {
+		return 0;
+	}
+	// First sample of a page is a key sample: tag then absolute time
+	const uint8_t *oldest = blackbox->pages[blackbox->tail & BLACKBOX_MASK] + BLACKBOX_PAGE_HEADER;
+	return blackbox->last_time_ms - BLACKBOX_Get32(oldest + 1);
+}
+
+/**
+ * Decode the samples of a page (written by the ring or read back from the log).
+ *
+ * @param page: BLACKBOX_PAGE_SIZE bytes.
+ * @param samples: decoded samples.
+ * @param max: size of "samples".
+ *
+ * @return number of samples, -1 if the page is malformed
+ */
+int16_t BLACKBOX_DecodePage(const uint8_t page[], BLACKBOX_Sample samples[], uint16_t max) {
+	const uint8_t *p = page + BLACKBOX_PAGE_HEADER;
+	const uint8_t *end = page + BLACKBOX_PAGE_SIZE;
+	BLACKBOX_Sample baro = { 0 };
+	BLACKBOX_Sample gnss = { 0 };
+	uint8_t has_baro = 0;
+	uint8_t has_gnss = 0;
+	int16_t count = 0;
+
+	while (p < end && *p != BLACKBOX_TAG_END) {
+		uint8_t tag = *p++;
+		uint32_t delta;
+		int32_t a;
+		int32_t b;
+		BLACKBOX_Sample *sample;
+
+		if (count >= max) {
+			return -1; // Too many samples
+		}
+		switch (tag) {
+		case BLACKBOX_TAG_BARO | BLACKBOX_TAG_KEY:
+			if (end - p < 10) {
+				return -1;
+			}
+			baro.time_ms = BLACKBOX_Get32(p);
+			baro.press_Pa_Q8 = BLACKBOX_Get32(p + 4);
+			baro.temp_cC = (int16_t)(p[8] | p[9] << 8);
+			p += 10;
+			has_baro = 1;
+			sample = &baro;
+			break;
+		case BLACKBOX_TAG_BARO:
+			if (!has_baro || (p = BLACKBOX_GetVarint(p, end, &delta)) == NULL
+					|| (p = BLACKBOX_GetSigned(p, end, &a)) == NULL || (p = BLACKBOX_GetSigned(p, end, &b)) == NULL) {
+				return -1;
+			}
+			baro.time_ms += delta;
+			baro.press_Pa_Q8 += a;
+			baro.temp_cC += b;
+			sample = &baro;
+			break;
+		case BLACKBOX_TAG_GNSS | BLACKBOX_TAG_KEY:
+			if (end - p < 13) {
+				return -1;
+			}
+			gnss.time_ms = BLACKBOX_Get32(p);
+			gnss.latitude_e7 = (int32_t)BLACKBOX_Get32(p + 4);
+			gnss.longitude_e7 = (int32_t)BLACKBOX_Get32(p + 8);
+			gnss.fix = p[12];
+			p += 13;
+			has_gnss = 1;
+			sample = &gnss;
+			break;
+		case BLACKBOX_TAG_GNSS:
+			if (!has_gnss || (p = BLACKBOX_GetVarint(p, end, &delta)) == NULL
+					|| (p = BLACKBOX_GetSigned(p, end, &a)) == NULL || (p = BLACKBOX_GetSigned(p, end, &b)) == NULL
+					|| p >= end) {
+				return -1;
+			}
+			gnss.time_ms += delta;
+			gnss.latitude_e7 += a;
+			gnss.longitude_e7 += b;
+			gnss.fix = *p++;
+			sample = &gnss;
+			break;
+		case BLACKBOX_TAG_TRIGGER | BLACKBOX_TAG_KEY:
+			if (end - p < 5) {
+				return -1;
+			}
+			memset(&samples[count], 0, sizeof(BLACKBOX_Sample));
+			samples[count].type = BLACKBOX_TAG_TRIGGER;
+			samples[count].time_ms = BLACKBOX_Get32(p);
+			samples[count].reason = p[4];
+			p += 5;
+			count++;
+			continue;
+		default:
+			return -1; // Unknown tag
+		}
+		sample->type = tag & ~BLACKBOX_TAG_KEY;
+		samples[count++] = *sample;
+	}
+
+	return count;
+}
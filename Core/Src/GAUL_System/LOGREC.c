@@ -0,0 +1,343 @@
+/*
+ * LOGREC.c
+ *
+ * Flight log records. Encoding is a few byte stores and a table CRC-16 over 14 bytes, no
+ * division and no float: the caller converts its measurements to the integer fields.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/LOGREC.h"
+
+#include "GAUL_System/PACKET.h"
+
+#include <string.h>
+
+#define LOGREC_CRC_OFFSET (LOGREC_SIZE - 2)
+
+static void LOGREC_Put16(uint8_t *p, uint16_t value) {
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static void LOGREC_Put32(uint8_t *p, uint32_t value) {
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+static uint16_t LOGREC_Get16(const uint8_t *p) {
+	return (uint16_t)p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t LOGREC_Get32(const uint8_t *p) {
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/**
+ * @retval 1 record erased or padding (every byte 0xFF, or 0x00)
+ */
+static uint8_t LOGREC_IsEmpty(const uint8_t record[]) {
+	uint8_t fill = record[0];
+	if (fill != 0xFF && fill != 0x00) {
+		return 0;
+	}
+	for (uint8_t i = 1; i < LOGREC_SIZE; i++) {
+		if (record[i] != fill) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void LOGREC_Init(LOGREC *log) {
+	memset(log, 0, sizeof(LOGREC));
+}
+
+/**
+ * Encode a record, without writing it. The time of a record other than TIME must be at
+ * most LOGREC_MAX_DELTA_MS after the last TIME record encoded.
+ *
+ * @param log: encoder state (sequence number, time of the last TIME record).
+ * @param type: LOGREC_TYPE_x.
+ * @param data: fields of the record type.
+ * @param record: LOGREC_SIZE bytes.
+ *
+ * @return LOGREC_SIZE, 0 if the type is invalid or the time out of range
+ */
+uint8_t LOGREC_Encode(LOGREC *log, uint8_t type, const LOGREC_Data *data, uint8_t record[]) {
+	uint32_t delta_ms = data->time_ms - log->base_time_ms;
+
+	if (type == 0 || type >= LOGREC_TYPE_COUNT) {
+		return 0; // Invalid type
+	}
+	if (type == LOGREC_TYPE_TIME) {
+		delta_ms = 0;
+	} else if (delta_ms > LOGREC_MAX_DELTA_MS) {
+		return 0; // TIME record needed
+	}
+
+	uint8_t *payload = record + 4;
+	memset(payload, 0, LOGREC_PAYLOAD_SIZE);
+	record[0] = type;
+	record[1] = log->sequence++;
+	LOGREC_Put16(record + 2, delta_ms);
+
+	switch (type) {
+	case LOGREC_TYPE_TIME:
+		LOGREC_Put32(payload, data->time_ms);
+		LOGREC_Put16(payload + 4, data->session);
+		LOGREC_Put32(payload + 6, data->block);
+		log->base_time_ms = data->time_ms;
+		break;
+	case LOGREC_TYPE_BARO:
+		LOGREC_Put32(payload, data->press_Pa_Q8);
+		LOGREC_Put16(payload + 4, data->temp_cC);
+		LOGREC_Put32(payload + 6, data->alt_cm);
+		break;
+	case LOGREC_TYPE_FLIGHT:
+		LOGREC_Put32(payload, data->alt_cm);
+		LOGREC_Put16(payload + 4, data->vel_dms);
+		LOGREC_Put16(payload + 6, data->accel_cms2);
+		payload[8] = data->phase;
+		payload[9] = data->flags;
+		break;
+	case LOGREC_TYPE_GNSS:
+		LOGREC_Put32(payload, data->latitude_e7);
+		LOGREC_Put32(payload + 4, data->longitude_e7);
+		payload[8] = data->fix;
+		payload[9] = data->satellites;
+		break;
+	case LOGREC_TYPE_EVENT:
+		payload[0] = data->from;
+		payload[1] = data->to;
+		payload[2] = data->reason;
+		LOGREC_Put32(payload + 3, data->alt_cm);
+		break;
+	case LOGREC_TYPE_HEALTH:
+		for (uint8_t i = 0; i < LOGREC_COUNTER_COUNT; i++) {
+			LOGREC_Put16(payload + 2 * i, data->counters[i]);
+		}
+		break;
+	case LOGREC_TYPE_CAPTURE:
+		memcpy(payload, data->capture, LOGREC_PAYLOAD_SIZE);
+		break;
+	case LOGREC_TYPE_UART:
+		payload[0] = data->uart;
+		LOGREC_Put16(payload + 1, data->overruns);
+		LOGREC_Put16(payload + 3, data->framing);
+		LOGREC_Put16(payload + 5, data->noise);
+		LOGREC_Put16(payload + 7, data->dma);
+		payload[9] = data->parity;
+		break;
+	case LOGREC_TYPE_MACHLOCK:
+		payload[0] = data->lock;
+		payload[1] = data->reason;
+		LOGREC_Put16(payload + 2, data->vel_dms);
+		LOGREC_Put32(payload + 4, data->alt_cm);
+		break;
+	}
+
+	uint16_t crc = PACKET_CRC16(record, LOGREC_CRC_OFFSET);
+	record[LOGREC_CRC_OFFSET] = crc >> 8;
+	record[LOGREC_CRC_OFFSET + 1] = crc & 0xFF;
+
+	return LOGREC_SIZE;
+}
+
+/**
+ * Encode a record and copy it in the flight log (SDLOG_Write, never waits for the card).
+ * Every block starts with a TIME record: after the previous block is full, after a gap
+ * longer than LOGREC_MAX_DELTA_MS (the block is sealed early) and after a dropped record.
+ * A TIME record is never in the middle of a block, so a corrupted TIME record can not
+ * give a wrong time to the records after it.
+ *
+ * @param log: encoder state.
+ * @param type: LOGREC_TYPE_x, except LOGREC_TYPE_TIME.
+ * @param data: fields of the record type.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, invalid type
+ * @retval -2 DROPPED, log full or not open (the sequence number is lost)
+ */
+int8_t LOGREC_Write(LOGREC *log, uint8_t type, const LOGREC_Data *data) {
+	uint8_t record[LOGREC_SIZE];
+
+	if (type == LOGREC_TYPE_TIME || type == 0 || type >= LOGREC_TYPE_COUNT) {
+		return -1; // Error
+	}
+
+	if (SDLOG_Free() < LOGREC_SIZE || !log->synced || data->time_ms - log->base_time_ms > LOGREC_MAX_DELTA_MS) {
+		SDLOG_Flush();
+		LOGREC_Data time = {
+			.time_ms = data->time_ms,
+			.session = SDLOG_GetSession(),
+			.block = SDLOG_GetStats()->blocks_sealed, // Next block
+		};
+		LOGREC_Encode(log, LOGREC_TYPE_TIME, &time, record);
+		if (SDLOG_Write(record, LOGREC_SIZE) != 0) {
+			log->synced = 0;
+			log->dropped++;
+			return -2; // Dropped
+		}
+		log->synced = 1;
+		log->syncs++;
+	}
+
+	LOGREC_Encode(log, type, data, record);
+	if (SDLOG_Write(record, LOGREC_SIZE) != 0) {
+		log->synced = 0;
+		log->dropped++;
+		return -2; // Dropped
+	}
+	log->records++;
+
+	return 0; // OK
+}
+
+void LOGREC_DecoderInit(LOGREC_Decoder *decoder) {
+	memset(decoder, 0, sizeof(LOGREC_Decoder));
+}
+
+/**
+ * Check and unpack a record. Records must be given in the order of the log, an invalid
+ * record is skipped and decoding continues with the next one. Clear "synced" before the
+ * first record of every block, its records are relative to its own TIME record.
+ *
+ * @param decoder: decoder state (time of the last TIME record, sequence number).
+ * @param record: LOGREC_SIZE bytes.
+ * @param type: LOGREC_TYPE_x of the record.
+ * @param data: fields of the record type, time_ms and sequence.
+ *
+ * @retval 1 OK
+ * @retval 0 EMPTY, erased or padding
+ * @retval -1 ERROR, CRC error or unknown type
+ * @retval -3 ERROR, no TIME record before
+ */
+int8_t LOGREC_Decode(LOGREC_Decoder *decoder, const uint8_t record[], uint8_t *type, LOGREC_Data *data) {
+	if (LOGREC_IsEmpty(record)) {
+		return 0; // Empty
+	}
+
+	uint16_t crc = (uint16_t)record[LOGREC_CRC_OFFSET] << 8 | record[LOGREC_CRC_OFFSET + 1];
+	if (PACKET_CRC16(record, LOGREC_CRC_OFFSET) != crc || record[0] == 0 || record[0] >= LOGREC_TYPE_COUNT) {
+		decoder->invalid++;
+		return -1; // CRC error or unknown type
+	}
+	if (record[0] != LOGREC_TYPE_TIME && !decoder->synced) {
+		decoder->invalid++;
+		return -3; // No time
+	}
+
+	const uint8_t *payload = record + 4;
+	memset(data, 0, sizeof(LOGREC_Data));
+	*type = record[0];
+	data->sequence = record[1];
+	if (decoder->started) {
+		decoder->lost += (uint8_t)(data->sequence - decoder->sequence - 1);
+	}
+	decoder->sequence = data->sequence;
+	decoder->started = 1;
+	decoder->records++;
+
+	switch (*type) {
+	case LOGREC_TYPE_TIME:
+		data->session = LOGREC_Get16(payload + 4);
+		data->block = LOGREC_Get32(payload + 6);
+		decoder->base_time_ms = LOGREC_Get32(payload);
+		decoder->synced = 1;
+		break;
+	case LOGREC_TYPE_BARO:
+		data->press_Pa_Q8 = LOGREC_Get32(payload);
+		data->temp_cC = (int16_t)LOGREC_Get16(payload + 4);
+		data->alt_cm = (int32_t)LOGREC_Get32(payload + 6);
+		break;
+	case LOGREC_TYPE_FLIGHT:
+		data->alt_cm = (int32_t)LOGREC_Get32(payload);
+		data->vel_dms = (int16_t)LOGREC_Get16(payload + 4);
+		data->accel_cms2 = (int16_t)LOGREC_Get16(payload + 6);
+		data->phase = payload[8];
+		data->flags = payload[9];
+		break;
+	case LOGREC_TYPE_GNSS:
+		data->latitude_e7 = (int32_t)LOGREC_Get32(payload);
+		data->longitude_e7 = (int32_t)LOGREC_Get32(payload + 4);
+		data->fix = payload[8];
+		data->satellites = payload[9];
+		break;
+	case LOGREC_TYPE_EVENT:
+		data->from = payload[0];
+		data->to = payload[1];
+		data->reason = payload[2];
+		data->alt_cm = (int32_t)LOGREC_Get32(payload + 3);
+		break;
+	case LOGREC_TYPE_HEALTH:
+		for (uint8_t i = 0; i < LOGREC_COUNTER_COUNT; i++) {
+			data->counters[i] = LOGREC_Get16(payload + 2 * i);
+		}
+		break;
+	case LOGREC_TYPE_CAPTURE:
+		memcpy(data->capture, payload, LOGREC_PAYLOAD_SIZE);
+		break;
+	case LOGREC_TYPE_UART:
+		data->uart = payload[0];
+		data->overruns = LOGREC_Get16(payload + 1);
+		data->framing = LOGREC_Get16(payload + 3);
+		data->noise = LOGREC_Get16(payload + 5);
+		data->dma = LOGREC_Get16(payload + 7);
+		data->parity = payload[9];
+		break;
+	case LOGREC_TYPE_MACHLOCK:
+		data->lock = payload[0];
+		data->reason = payload[1];
+		data->vel_dms = (int16_t)LOGREC_Get16(payload + 2);
+		data->alt_cm = (int32_t)LOGREC_Get32(payload + 4);
+		break;
+	}
+	data->time_ms = decoder->base_time_ms + LOGREC_Get16(record + 2);
+
+	return 1; // OK
+}
+
+/**
+ * Decode a block of the flight log on its own (recovery of the last block after a power
+ * loss). A block of an other session or with an other sequence (not written yet, stale
+ * data of an older session) has no valid record.
+ *
+ * @param block: SD_BLOCK_SIZE bytes.
+ * @param session: session number of the log.
+ * @param sequence: expected block sequence in the session.
+ * @param last: last valid record of the block, unchanged if none (can be NULL).
+ *
+ * @return number of valid records, -1 if the header does not match
+ */
+int16_t LOGREC_ScanBlock(const uint8_t block[], uint16_t session, uint32_t sequence, LOGREC_Data *last) {
+	LOGREC_Decoder decoder;
+	LOGREC_Data data;
+	uint8_t type;
+	int16_t count = 0;
+
+	if (LOGREC_Get32(block) != SDLOG_MAGIC || LOGREC_Get32(block + 4) != sequence
+			|| LOGREC_Get16(block + 8) != session) {
+		return -1; // Not a block of this session
+	}
+
+	LOGREC_DecoderInit(&decoder);
+	for (uint8_t i = 0; i < LOGREC_PER_BLOCK; i++) {
+		if (LOGREC_Decode(&decoder, block + SDLOG_HEADER_SIZE + i * LOGREC_SIZE, &type, &data) != 1) {
+			continue;
+		}
+		if (type == LOGREC_TYPE_TIME && (data.session != session || data.block != sequence)) {
+			decoder.synced = 0; // Record copied from an other block
+			continue;
+		}
+		count++;
+		if (last != NULL) {
+			*last = data;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,349 @@
+/*
+ * PACKET.c
+ *
+ * Binary telemetry packets: bit packing, CRC-16 and COBS framing.
+ *
+ * Payloads (bits, s: signed two's complement, u: unsigned, MSB first):
+ *   FLIGHT  alt_dm s20, vel_dms s14, phase u3, fix u1, padding 2        ->  5 bytes
+ *   BARO    press_Pa u17, temp_dC s11, padding 4                        ->  4 bytes
+ *   GNSS    north_m s20, east_m s20, fix u1, padding 7                  ->  6 bytes
+ *   HEALTH  counters 7 x u16, load_permille u10, padding 6              -> 16 bytes
+ * Values out of range are saturated, not wrapped, so a wrong value is still obvious on the
+ * ground. New fields must go in a new type or a new PACKET_VERSION.
+ *
+ * COBS replaces every 0x00 so the only 0x00 on the link is the frame delimiter: after a
+ * corrupted or lost byte, the receiver is synchronized again at the next frame.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/PACKET.h"
+
+#include <string.h>
+
+static const uint8_t PACKET_PAYLOAD_SIZES[PACKET_TYPE_COUNT] = { 0, 5, 4, 6, 16 };
+
+// CRC-16/CCITT-FALSE, one nibble at a time (32 bytes of table instead of 512)
+static const uint16_t PACKET_CRC_TABLE[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+/**
+ * @param data: header and payload.
+ * @param size: number of bytes.
+ *
+ * @return CRC-16/CCITT-FALSE ("123456789" gives 0x29B1)
+ */
+uint16_t PACKET_CRC16(const uint8_t data[], uint16_t size) {
+	uint16_t crc = 0xFFFF;
+	for (uint16_t i = 0; i < size; i++) {
+		crc = (crc << 4) ^ PACKET_CRC_TABLE[(crc >> 12) ^ (data[i] >> 4)];
+		crc = (crc << 4) ^ PACKET_CRC_TABLE[(crc >> 12) ^ (data[i] & 0x0F)];
+	}
+	return crc;
+}
+
+/**
+ * COBS encoding (without the 0x00 delimiter).
+ *
+ * @param input: bytes to encode (253 bytes at most).
+ * @param size: number of bytes.
+ * @param output: size + 1 bytes.
+ *
+ * @return number of bytes written in output
+ */
+uint16_t PACKET_COBSEncode(const uint8_t input[], uint16_t size, uint8_t output[]) {
+	uint16_t code_index = 0; // Position of the byte giving the distance to the next 0x00
+	uint16_t out = 1;
+	uint8_t code = 1;
+
+	for (uint16_t i = 0; i < size; i++) {
+		if (input[i] == 0) {
+			output[code_index] = code;
+			code_index = out++;
+			code = 1;
+		} else {
+			output[out++] = input[i];
+			code++;
+			if (code == 0xFF) {
+				output[code_index] = code;
+				code_index = out++;
+				code = 1;
+			}
+		}
+	}
+	output[code_index] = code;
+
+	return out;
+}
+
+/**
+ * COBS decoding (frame without the 0x00 delimiter).
+ *
+ * @param input: encoded bytes.
+ * @param size: number of encoded bytes.
+ * @param output: size - 1 bytes at most.
+ *
+ * @return number of decoded bytes
+ * @retval -1 ERROR, invalid encoding (0x00 in the frame or code past the end)
+ */
+int16_t PACKET_COBSDecode(const uint8_t input[], uint16_t size, uint8_t output[]) {
+	uint16_t in = 0;
+	uint16_t out = 0;
+
+	while (in < size) {
+		uint8_t code = input[in++];
+		if (code == 0 || in + code - 1 > size) {
+			return -1; // Error
+		}
+		for (uint8_t i = 1; i < code; i++) {
+			if (input[in] == 0) {
+				return -1; // Error
+			}
+			output[out++] = input[in++];
+		}
+		if (code != 0xFF && in < size) {
+			output[out++] = 0;
+		}
+	}
+
+	return out;
+}
+
+static void PACKET_PutBits(uint8_t buffer[], uint16_t *bit, uint32_t value, uint8_t bits) {
+	for (int8_t i = bits - 1; i >= 0; i--) {
+		if ((value >> i) & 1) {
+			buffer[*bit >> 3] |= 0x80 >> (*bit & 7);
+		}
+		(*bit)++;
+	}
+}
+
+static uint32_t PACKET_GetBits(const uint8_t buffer[], uint16_t *bit, uint8_t bits) {
+	uint32_t value = 0;
+	for (uint8_t i = 0; i < bits; i++) {
+		value = (value << 1) | ((buffer[*bit >> 3] >> (7 - (*bit & 7))) & 1);
+		(*bit)++;
+	}
+	return value;
+}
+
+static void PACKET_PutSigned(uint8_t buffer[], uint16_t *bit, int32_t value, uint8_t bits) {
+	int32_t max = (1L << (bits - 1)) - 1;
+	if (value > max) {
+		value = max;
+	} else if (value < -max - 1) {
+		value = -max - 1;
+	}
+	PACKET_PutBits(buffer, bit, (uint32_t)value & ((1UL << bits) - 1), bits);
+}
+
+static void PACKET_PutUnsigned(uint8_t buffer[], uint16_t *bit, uint32_t value, uint8_t bits) {
+	uint32_t max = (1UL << bits) - 1;
+	PACKET_PutBits(buffer, bit, value > max ? max : value, bits);
+}
+
+static int32_t PACKET_GetSigned(const uint8_t buffer[], uint16_t *bit, uint8_t bits) {
+	uint32_t value = PACKET_GetBits(buffer, bit, bits);
+	if (value & (1UL << (bits - 1))) {
+		value |= ~((1UL << bits) - 1); // Sign extension
+	}
+	return (int32_t)value;
+}
+
+/**
+ * @return payload size of a packet type, 0 if the type does not exist
+ */
+uint8_t PACKET_PayloadSize(uint8_t type) {
+	if (type == 0 || type >= PACKET_TYPE_COUNT) {
+		return 0;
+	}
+	return PACKET_PAYLOAD_SIZES[type];
+}
+
+/**
+ * @return bytes sent on the link for a packet type (with COBS and delimiter), 0 if the type does not exist
+ */
+uint8_t PACKET_FrameSize(uint8_t type) {
+	uint8_t payload = PACKET_PayloadSize(type);
+	if (payload == 0) {
+		return 0;
+	}
+	return PACKET_HEADER_SIZE + payload + PACKET_CRC_SIZE + 2;
+}
+
+/**
+ * Build a frame ready to send.
+ *
+ * @param type: PACKET_TYPE_x
+ * @param data: values, only the fields of the type are used.
+ * @param frame: PACKET_MAX_FRAME_SIZE bytes.
+ *
+ * @return frame size (PACKET_FrameSize(type)), 0 if the type does not exist
+ */
+uint16_t PACKET_Encode(uint8_t type, const PACKET_Data *data, uint8_t frame[]) {
+	uint8_t payload_size = PACKET_PayloadSize(type);
+	if (payload_size == 0) {
+		return 0;
+	}
+
+	uint8_t packet[PACKET_HEADER_SIZE + PACKET_MAX_PAYLOAD_SIZE + PACKET_CRC_SIZE];
+	memset(packet, 0, sizeof(packet));
+
+	uint16_t bit = 0;
+	PACKET_PutBits(packet, &bit, PACKET_VERSION, 3);
+	PACKET_PutBits(packet, &bit, type, 5);
+	PACKET_PutBits(packet, &bit, data->sequence, 8);
+	PACKET_PutBits(packet, &bit, data->time_ms & 0xFFFFFF, 24);
+
+	switch (type) {
+	case PACKET_TYPE_FLIGHT:
+		PACKET_PutSigned(packet, &bit, data->alt_dm, 20);
+		PACKET_PutSigned(packet, &bit, data->vel_dms, 14);
+		PACKET_PutUnsigned(packet, &bit, data->phase, 3);
+		PACKET_PutUnsigned(packet, &bit, data->fix, 1);
+		break;
+	case PACKET_TYPE_BARO:
+		PACKET_PutUnsigned(packet, &bit, data->press_Pa, 17);
+		PACKET_PutSigned(packet, &bit, data->temp_dC, 11);
+		break;
+	case PACKET_TYPE_GNSS:
+		PACKET_PutSigned(packet, &bit, data->north_m, 20);
+		PACKET_PutSigned(packet, &bit, data->east_m, 20);
+		PACKET_PutUnsigned(packet, &bit, data->fix, 1);
+		break;
+	case PACKET_TYPE_HEALTH:
+		for (uint8_t i = 0; i < PACKET_COUNTER_COUNT; i++) {
+			PACKET_PutUnsigned(packet, &bit, data->counters[i], 16);
+		}
+		PACKET_PutUnsigned(packet, &bit, data->load_permille, 10);
+		break;
+	}
+
+	uint16_t size = PACKET_HEADER_SIZE + payload_size;
+	uint16_t crc = PACKET_CRC16(packet, size);
+	packet[size++] = crc >> 8;
+	packet[size++] = crc & 0xFF;
+
+	size = PACKET_COBSEncode(packet, size, frame);
+	frame[size++] = 0x00; // Delimiter
+
+	return size;
+}
+
+/**
+ * Check and unpack a frame.
+ *
+ * @param frame: COBS encoded frame, with or without the 0x00 delimiter.
+ * @param size: number of bytes.
+ * @param type: PACKET_TYPE_x of the frame.
+ * @param data: header and fields of the type are written, other fields are not changed.
+ *
+ * @retval 0 OK
+ * @retval -1 COBS ERROR
+ * @retval -2 CRC ERROR
+ * @retval -3 ERROR, unknown version or type, or wrong size
+ */
+int8_t PACKET_Decode(const uint8_t frame[], uint16_t size, uint8_t *type, PACKET_Data *data) {
+	uint8_t packet[PACKET_HEADER_SIZE + PACKET_MAX_PAYLOAD_SIZE + PACKET_CRC_SIZE];
+
+	if (size > 0 && frame[size - 1] == 0x00) {
+		size--; // Delimiter
+	}
+	if (size == 0 || size > sizeof(packet) + 1) {
+		return -3; // Error, wrong size
+	}
+	int16_t packet_size = PACKET_COBSDecode(frame, size, packet);
+	if (packet_size < 0) {
+		return -1; // COBS error
+	}
+	if (packet_size < PACKET_HEADER_SIZE + PACKET_CRC_SIZE) {
+		return -3; // Error, wrong size
+	}
+
+	uint16_t crc = ((uint16_t)packet[packet_size - 2] << 8) | packet[packet_size - 1];
+	if (PACKET_CRC16(packet, packet_size - PACKET_CRC_SIZE) != crc) {
+		return -2; // CRC error
+	}
+
+	uint16_t bit = 0;
+	uint8_t version = PACKET_GetBits(packet, &bit, 3);
+	*type = PACKET_GetBits(packet, &bit, 5);
+	if (version != PACKET_VERSION || PACKET_PayloadSize(*type) == 0
+			|| packet_size != PACKET_HEADER_SIZE + PACKET_PayloadSize(*type) + PACKET_CRC_SIZE) {
+		return -3; // Error, unknown version or type
+	}
+	data->sequence = PACKET_GetBits(packet, &bit, 8);
+	data->time_ms = PACKET_GetBits(packet, &bit, 24);
+
+	switch (*type) {
+	case PACKET_TYPE_FLIGHT:
+		data->alt_dm = PACKET_GetSigned(packet, &bit, 20);
+		data->vel_dms = PACKET_GetSigned(packet, &bit, 14);
+		data->phase = PACKET_GetBits(packet, &bit, 3);
+		data->fix = PACKET_GetBits(packet, &bit, 1);
+		break;
+	case PACKET_TYPE_BARO:
+		data->press_Pa = PACKET_GetBits(packet, &bit, 17);
+		data->temp_dC = PACKET_GetSigned(packet, &bit, 11);
+		break;
+	case PACKET_TYPE_GNSS:
+		data->north_m = PACKET_GetSigned(packet, &bit, 20);
+		data->east_m = PACKET_GetSigned(packet, &bit, 20);
+		data->fix = PACKET_GetBits(packet, &bit, 1);
+		break;
+	case PACKET_TYPE_HEALTH:
+		for (uint8_t i = 0; i < PACKET_COUNTER_COUNT; i++) {
+			data->counters[i] = PACKET_GetBits(packet, &bit, 16);
+		}
+		data->load_permille = PACKET_GetBits(packet, &bit, 10);
+		break;
+	}
+
+	return 0; // OK
+}
+
+void PACKET_ReceiverInit(PACKET_Receiver *receiver) {
+	receiver->size = 0;
+	receiver->overflow = 0;
+	receiver->complete = 0;
+}
+
+/**
+ * Add a received byte to the current frame.
+ *
+ * @param receiver: stream state.
+ * @param byte: received byte.
+ *
+ * @retval 1 frame complete in receiver->frame (receiver->size bytes, without delimiter), call PACKET_Decode
+ * @retval 0 frame not complete
+ * @retval -1 ERROR, frame longer than PACKET_MAX_FRAME_SIZE ignored
+ */
+int8_t PACKET_Receive(PACKET_Receiver *receiver, uint8_t byte) {
+	if (receiver->complete) {
+		receiver->size = 0; // Previous frame was returned
+		receiver->complete = 0;
+	}
+
+	if (byte == 0x00) {
+		if (receiver->overflow) {
+			receiver->overflow = 0;
+			receiver->size = 0;
+			return -1; // Error
+		}
+		if (receiver->size == 0) {
+			return 0; // Empty frame (delimiters in a row)
+		}
+		receiver->complete = 1;
+		return 1; // Frame complete
+	}
+
+	if (receiver->size >= PACKET_MAX_FRAME_SIZE) {
+		receiver->overflow = 1;
+		return 0;
+	}
+	receiver->frame[receiver->size++] = byte;
+	return 0;
+}
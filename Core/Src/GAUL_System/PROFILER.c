@@ -0,0 +1,183 @@
+/*
+ * PROFILER.c
+ *
+ * Execution time profiler using the Cortex-M3 DWT cycle counter.
+ *
+ * A probe costs two reads of DWT->CYCCNT and one PROFILER_Record call (~40 cycles, 0.6 us).
+ * The cost of an empty probe is measured by PROFILER_Init and removed from every sample.
+ * Probes must not be used in interrupts (statistics are not updated atomically).
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/PROFILER.h"
+
+#include <stdio.h>
+
+static const char *PROFILER_ZONE_NAMES[PROFILER_ZONE_COUNT] = {
+	"BMP280_Read",
+	"L76LM33_Read",
+	"NMEA_ParseRMC",
+	"FLIGHT_Update",
+	"ICM20602_StartRead",
+	"FUSION_Predict",
+	"APOGEE_Update",
+};
+
+static PROFILER_Zone PROFILER_zones[PROFILER_ZONE_COUNT];
+static uint32_t PROFILER_overhead_cycles = 0;
+
+/**
+ * Enable the DWT cycle counter and reset statistics.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, cycle counter not running
+ */
+int8_t PROFILER_Init() {
+	// Enable trace (DWT) and the cycle counter
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	uint32_t start = DWT->CYCCNT;
+	__NOP();
+	__NOP();
+	if (DWT->CYCCNT == start) {
+		return -1; // Error, counter does not count
+	}
+
+	// Measure the cost of an empty probe
+	PROFILER_overhead_cycles = 0;
+	PROFILER_Reset();
+	PROFILER_BEGIN(PROFILER_ZONE_BMP280_READ);
+	PROFILER_END(PROFILER_ZONE_BMP280_READ);
+	PROFILER_overhead_cycles = PROFILER_zones[PROFILER_ZONE_BMP280_READ].min_cycles;
+	PROFILER_Reset();
+
+	return 0; // OK
+}
+
+/**
+ * log2 histogram bucket of a duration.
+ *
+ * @return 0 for 0 cycles, i for [2^(i-1), 2^i) cycles, PROFILER_HISTOGRAM_SIZE - 1 at most
+ */
+uint8_t PROFILER_Bucket(uint32_t cycles) {
+	if (cycles == 0) {
+		return 0;
+	}
+	uint8_t bucket = 32 - __CLZ(cycles);
+	return bucket < PROFILER_HISTOGRAM_SIZE ? bucket : PROFILER_HISTOGRAM_SIZE - 1;
+}
+
+/**
+ * Add a duration to a zone. Called by PROFILER_END.
+ *
+ * @param zone: PROFILER_ZONE_x
+ * @param cycles: measured duration, including the probe overhead.
+ */
+void PROFILER_Record(uint8_t zone, uint32_t cycles) {
+	if (zone >= PROFILER_ZONE_COUNT) {
+		return;
+	}
+
+	cycles = cycles > PROFILER_overhead_cycles ? cycles - PROFILER_overhead_cycles : 0;
+
+	PROFILER_Zone *stats = &PROFILER_zones[zone];
+	if (stats->count == 0 || cycles < stats->min_cycles) {
+		stats->min_cycles = cycles;
+	}
+	if (cycles > stats->max_cycles) {
+		stats->max_cycles = cycles;
+	}
+	stats->count++;
+	stats->sum_cycles += cycles;
+	stats->histogram[PROFILER_Bucket(cycles)]++;
+}
+
+/**
+ * Clear the statistics of all zones.
+ */
+void PROFILER_Reset() {
+	for (uint8_t i = 0; i < PROFILER_ZONE_COUNT; i++) {
+		PROFILER_Zone *stats = &PROFILER_zones[i];
+		stats->count = 0;
+		stats->min_cycles = 0;
+		stats->max_cycles = 0;
+		stats->sum_cycles = 0;
+		for (uint8_t j = 0; j < PROFILER_HISTOGRAM_SIZE; j++) {
+			stats->histogram[j] = 0;
+		}
+	}
+}
+
+/**
+ * @return statistics of a zone, NULL if the zone does not exist
+ */
+const PROFILER_Zone *PROFILER_GetZone(uint8_t zone) {
+	if (zone >= PROFILER_ZONE_COUNT) {
+		return NULL;
+	}
+	return &PROFILER_zones[zone];
+}
+
+/**
+ * @return mean duration of a zone in cycles, 0 if no sample
+ */
+uint32_t PROFILER_Mean(uint8_t zone) {
+	if (zone >= PROFILER_ZONE_COUNT || PROFILER_zones[zone].count == 0) {
+		return 0;
+	}
+	return (uint32_t)(PROFILER_zones[zone].sum_cycles / PROFILER_zones[zone].count);
+}
+
+static void PROFILER_Write(UART_HandleTypeDef *huart, char *data, int size) {
+	if (size <= 0) {
+		return;
+	}
+	if (huart == NULL) {
+		for (int i = 0; i < size; i++) {
+			ITM_SendChar(data[i]);
+		}
+	} else {
+		HAL_UART_Transmit(huart, (uint8_t *)data, size, PROFILER_UART_TIMEOUT);
+	}
+}
+
+/**
+ * Send the statistics of every zone with samples, one line of min/max/mean and one line
+ * of non-empty histogram buckets ("bucket:count", bucket i is [2^(i-1), 2^i) cycles).
+ * Blocking, do not call during flight.
+ *
+ * @param huart: UART to use (e.g. &huart1 for the RFD900), NULL for ITM (STLINK).
+ */
+void PROFILER_Dump(UART_HandleTypeDef *huart) {
+	char line[160];
+	uint32_t cycles_per_us = SystemCoreClock / 1000000;
+
+	for (uint8_t i = 0; i < PROFILER_ZONE_COUNT; i++) {
+		const PROFILER_Zone *stats = &PROFILER_zones[i];
+		if (stats->count == 0) {
+			continue;
+		}
+
+		uint32_t mean = PROFILER_Mean(i);
+		int size = snprintf(line, sizeof(line), "%s: n=%lu min=%lu max=%lu mean=%lu cycles (%lu/%lu/%lu us)\r\n",
+				PROFILER_ZONE_NAMES[i], stats->count, stats->min_cycles, stats->max_cycles, mean,
+				stats->min_cycles / cycles_per_us, stats->max_cycles / cycles_per_us, mean / cycles_per_us);
+		if (size >= (int)sizeof(line)) {
+			size = sizeof(line) - 1; // Truncated
+		}
+		PROFILER_Write(huart, line, size);
+
+		size = snprintf(line, sizeof(line), "  log2:");
+		for (uint8_t j = 0; j < PROFILER_HISTOGRAM_SIZE; j++) {
+			if (stats->histogram[j] != 0 && size < (int)sizeof(line) - 16) {
+				size += snprintf(line + size, sizeof(line) - size, " %u:%lu", j, stats->histogram[j]);
+			}
+		}
+		size += snprintf(line + size, sizeof(line) - size, "\r\n");
+		PROFILER_Write(huart, line, size);
+	}
+}
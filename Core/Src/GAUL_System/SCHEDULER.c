@@ -0,0 +1,271 @@
+/*
+ * SCHEDULER.c
+ *
+ * Cooperative time-triggered scheduler.
+ *
+ * Each task is released every period, starting at its offset. A release is not queued
+ * twice: if a task starts so late that the next release already passed, the missed
+ * releases are counted in "skipped" and the task keeps its original phase.
+ * Execution time is measured with the clock around each run, the worst case is kept in
+ * "wcet_us" and a run finishing after its deadline is counted in "overruns".
+ *
+ * On target, the clock is SysTick (HAL tick + SysTick counter, 1 us resolution) and the
+ * CPU sleeps with __WFI between slots, woken up by the 1 ms SysTick or any interrupt.
+ * Tests give a simulated clock and idle function instead.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/SCHEDULER.h"
+
+#include <stddef.h>
+
+/**
+ * Initialize the scheduler with a static task table.
+ *
+ * @param scheduler: pointer to a SCHEDULER structure.
+ * @param tasks: task table, the first task has the highest priority.
+ * @param size: number of tasks.
+ * @param clock: microsecond time source, NULL to use SysTick (SCHEDULER_TimeUs).
+ * @param idle: called when no task is due, NULL to use __WFI (SCHEDULER_Sleep).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR
+ */
+int8_t SCHEDULER_Init(SCHEDULER *scheduler, SCHEDULER_Task tasks[], uint8_t size, SCHEDULER_Clock clock, SCHEDULER_Idle idle) {
+	if (scheduler == NULL || tasks == NULL || size == 0 || size > SCHEDULER_MAX_TASKS) {
+		return -1; // Error
+	}
+
+	scheduler->tasks = tasks;
+	scheduler->size = size;
+	scheduler->clock = clock == NULL ? SCHEDULER_TimeUs : clock;
+	scheduler->idle = idle == NULL ? SCHEDULER_Sleep : idle;
+
+	uint32_t now = scheduler->clock();
+	for (uint8_t i = 0; i < size; i++) {
+		SCHEDULER_Task *task = &tasks[i];
+		if (task->function == NULL || task->period_ms == 0 || task->deadline_ms > task->period_ms) {
+			return -1; // Error, bad task
+		}
+		if (task->deadline_ms == 0) {
+			task->deadline_ms = task->period_ms;
+		}
+		task->release_us = now + task->offset_ms * 1000;
+		task->last_us = 0;
+		task->wcet_us = 0;
+		task->max_latency_us = 0;
+		task->runs = 0;
+		task->overruns = 0;
+		task->skipped = 0;
+		task->rephased = 0;
+	}
+
+	scheduler->stats_start_us = now;
+	scheduler->busy_us = 0;
+	scheduler->last_window_us = 0;
+	scheduler->last_busy_us = 0;
+	scheduler->idle_calls = 0;
+
+	return 0; // OK
+}
+
+static void SCHEDULER_Run(SCHEDULER *scheduler, SCHEDULER_Task *task, uint32_t start) {
+	uint32_t period_us = task->period_ms * 1000;
+	uint32_t release = task->release_us;
+	uint8_t counted = !task->rephased; // First run after a period change, late by design
+	task->rephased = 0;
+
+	task->function();
+
+	uint32_t end = scheduler->clock();
+	uint32_t duration = end - start;
+
+	task->last_us = duration;
+	if (duration > task->wcet_us) {
+		task->wcet_us = duration;
+	}
+	if (counted && start - release > task->max_latency_us) {
+		task->max_latency_us = start - release;
+	}
+	if (counted && end - release > task->deadline_ms * 1000) {
+		task->overruns++;
+	}
+	task->runs++;
+	scheduler->busy_us += duration;
+
+	// Next release, skip the ones already missed
+	uint32_t late = end - release;
+	uint32_t missed = late / period_us;
+	if (counted) {
+		task->skipped += missed;
+	}
+	task->release_us = release + (missed + 1) * period_us;
+}
+
+/**
+ * Run the highest priority task that is due, or sleep until the next release.
+ * Call in the main loop.
+ *
+ * @param scheduler: pointer to a SCHEDULER structure.
+ *
+ * @retval 1 A task was run
+ * @retval 0 Nothing due, idle function was called
+ */
+int8_t SCHEDULER_Dispatch(SCHEDULER *scheduler) {
+	uint32_t now = scheduler->clock();
+	uint32_t sleep_us = UINT32_MAX;
+
+	// Load window restarted long before the clock wraps
+	uint32_t window_us = now - scheduler->stats_start_us;
+	if (window_us >= SCHEDULER_LOAD_WINDOW_MS * 1000) {
+		scheduler->last_window_us = window_us;
+		scheduler->last_busy_us = scheduler->busy_us;
+		scheduler->stats_start_us = now;
+		scheduler->busy_us = 0;
+	}
+
+	for (uint8_t i = 0; i < scheduler->size; i++) {
+		SCHEDULER_Task *task = &scheduler->tasks[i];
+		int32_t wait = (int32_t)(task->release_us - now);
+		if (wait <= 0) {
+			SCHEDULER_Run(scheduler, task, now);
+			return 1;
+		}
+		if ((uint32_t)wait < sleep_us) {
+			sleep_us = wait;
+		}
+	}
+
+	scheduler->idle_calls++;
+	scheduler->idle(sleep_us);
+	return 0;
+}
+
+/**
+ * Change the period of a task (e.g. on a flight phase change). The next release is
+ * the last release plus the new period, so a faster rate applies immediately, or now if
+ * that is already past (not counted as latency, overrun or skipped releases).
+ *
+ * @param scheduler: pointer to a SCHEDULER structure.
+ * @param id: index of the task in the table.
+ * @param period_ms: new period.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, bad id or period
+ */
+int8_t SCHEDULER_SetPeriod(SCHEDULER *scheduler, uint8_t id, uint32_t period_ms) {
+	if (id >= scheduler->size || period_ms == 0) {
+		return -1; // Error
+	}
+
+	SCHEDULER_Task *task = &scheduler->tasks[id];
+	if (task->period_ms == period_ms) {
+		return 0; // OK, nothing to change
+	}
+
+	// Deadline follows the period when it was the period
+	if (task->deadline_ms == task->period_ms || task->deadline_ms > period_ms) {
+		task->deadline_ms = period_ms;
+	}
+
+	uint32_t now = scheduler->clock();
+	uint32_t last_release = task->release_us - task->period_ms * 1000;
+	uint32_t release = last_release + period_ms * 1000;
+	if ((int32_t)(release - now) < 0) {
+		release = now;
+	}
+	task->release_us = release;
+	task->period_ms = period_ms;
+	task->rephased = 1;
+
+	return 0; // OK
+}
+
+/**
+ * Planned utilisation from the measured worst-case execution times: sum of wcet / period.
+ *
+ * @return utilisation in per mille (1000 = CPU always busy in the worst case)
+ */
+uint16_t SCHEDULER_Utilisation(SCHEDULER *scheduler) {
+	uint32_t permille = 0;
+	for (uint8_t i = 0; i < scheduler->size; i++) {
+		permille += scheduler->tasks[i].wcet_us / scheduler->tasks[i].period_ms;
+	}
+	return permille > UINT16_MAX ? UINT16_MAX : permille;
+}
+
+/**
+ * Measured load: time spent in tasks over the previous and the current window
+ * (SCHEDULER_LOAD_WINDOW_MS each), since SCHEDULER_ResetStats at the start.
+ *
+ * @return load in per mille
+ */
+uint16_t SCHEDULER_Load(SCHEDULER *scheduler) {
+	uint32_t elapsed = scheduler->last_window_us + (scheduler->clock() - scheduler->stats_start_us);
+	if (elapsed == 0) {
+		return 0;
+	}
+	uint32_t busy = scheduler->last_busy_us + scheduler->busy_us;
+	return (uint16_t)(((uint64_t)busy * 1000) / elapsed);
+}
+
+/**
+ * Reset measured statistics (worst-case execution times, counters and load).
+ */
+void SCHEDULER_ResetStats(SCHEDULER *scheduler) {
+	for (uint8_t i = 0; i < scheduler->size; i++) {
+		SCHEDULER_Task *task = &scheduler->tasks[i];
+		task->wcet_us = 0;
+		task->max_latency_us = 0;
+		task->runs = 0;
+		task->overruns = 0;
+		task->skipped = 0;
+	}
+	scheduler->stats_start_us = scheduler->clock();
+	scheduler->busy_us = 0;
+	scheduler->last_window_us = 0;
+	scheduler->last_busy_us = 0;
+	scheduler->idle_calls = 0;
+}
+
+/**
+ * Microseconds from the HAL tick and the SysTick counter (counts down from LOAD each ms).
+ * Wraps after 71.6 min, only differences are meaningful: absolute times are taken in ms.
+ *
+ * @param time_ms: HAL tick of the same read, NULL if not needed.
+ *
+ * Takes less than 0.005ms to complete
+ */
+uint32_t SCHEDULER_Time(uint32_t *time_ms) {
+	uint32_t tick;
+	uint32_t counter;
+
+	// Read again if the tick changed during the read
+	do {
+		tick = HAL_GetTick();
+		counter = SysTick->VAL;
+	} while (tick != HAL_GetTick());
+
+	if (time_ms != NULL) {
+		*time_ms = tick;
+	}
+	uint32_t load = SysTick->LOAD + 1;
+	return tick * 1000 + ((load - 1 - counter) * 1000) / load;
+}
+
+/**
+ * Microseconds (SCHEDULER_Time), default clock of the scheduler.
+ */
+uint32_t SCHEDULER_TimeUs(void) {
+	return SCHEDULER_Time(NULL);
+}
+
+/**
+ * Sleep until the next interrupt (SysTick every 1 ms, UART, ...).
+ */
+void SCHEDULER_Sleep(uint32_t sleep_us) {
+	(void)sleep_us;
+	__WFI();
+}
@@ -0,0 +1,435 @@
+/*
+ * SDLOG.c
+ *
+ * Append-only flight log on the SD card.
+ *
+ * The buffers form a ring of SDLOG_BUFFER_BLOCKS blocks: "head" counts the sealed blocks,
+ * "sent" the blocks given to the card and "tail" the blocks whose DMA is finished (their
+ * buffer is free again, even if the card is still programming them). The block at "head"
+ * fills while "head - tail" < SDLOG_BUFFER_BLOCKS. A record never crosses two blocks, the
+ * end of a block is padded with 0xFF.
+ *
+ * With ping-pong buffers, the card can stay busy for the time to fill two blocks without
+ * losing a record: 130 ms at 300 records/s of 12 bytes. Cards usually program a block in
+ * about 1 ms, with occasional longer busy times (internal erase, wear leveling) that
+ * ACMD23 makes less frequent.
+ *
+ * The index and the session search are blocking and use the block buffers, they only run
+ * before SDLOG_Init returns or after SDLOG_Close (on the pad).
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/SDLOG.h"
+
+#include <string.h>
+
+#define SDLOG_MASK (SDLOG_BUFFER_BLOCKS - 1)
+
+static uint8_t SDLOG_blocks[SDLOG_BUFFER_BLOCKS][SD_BLOCK_SIZE];
+static uint8_t SDLOG_head = 0;      // Sealed blocks (free running)
+static uint8_t SDLOG_sent = 0;      // Blocks given to the card (free running)
+static uint8_t SDLOG_tail = 0;      // Blocks whose buffer is free again (free running)
+static uint8_t SDLOG_filling = 0;   // 1: block at head has a header
+static uint16_t SDLOG_used = 0;     // Record bytes in the block at head
+
+static uint8_t SDLOG_open = 0;
+static uint32_t SDLOG_index_block;
+static uint16_t SDLOG_session;
+static uint32_t SDLOG_start_block;
+static uint32_t SDLOG_limit_block;  // First block after the log region
+static SDLOG_Stats SDLOG_stats;
+
+static void SDLOG_Put16(uint8_t *p, uint16_t value) {
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static void SDLOG_Put32(uint8_t *p, uint32_t value) {
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+static uint16_t SDLOG_Get16(const uint8_t *p) {
+	return (uint16_t)p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t SDLOG_Get32(const uint8_t *p) {
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void SDLOG_GetEntry(const uint8_t index[], uint16_t session, SDLOG_Session *entry) {
+	const uint8_t *p = &index[SDLOG_INDEX_HEADER_SIZE + session * SDLOG_SESSION_SIZE];
+	entry->start_block = SDLOG_Get32(p);
+	entry->end_block = SDLOG_Get32(p + 4);
+	entry->start_time_ms = SDLOG_Get32(p + 8);
+	entry->reserved_blocks = SDLOG_Get32(p + 12);
+}
+
+static void SDLOG_PutEntry(uint8_t index[], uint16_t session, const SDLOG_Session *entry) {
+	uint8_t *p = &index[SDLOG_INDEX_HEADER_SIZE + session * SDLOG_SESSION_SIZE];
+	SDLOG_Put32(p, entry->start_block);
+	SDLOG_Put32(p + 4, entry->end_block);
+	SDLOG_Put32(p + 8, entry->start_time_ms);
+	SDLOG_Put32(p + 12, entry->reserved_blocks);
+}
+
+/**
+ * @return number of sessions in an index block, 0 if it is not an index
+ */
+static uint16_t SDLOG_IndexCount(const uint8_t index[]) {
+	if (SDLOG_Get32(index) != SDLOG_INDEX_MAGIC || SDLOG_Get16(&index[4]) != SDLOG_INDEX_VERSION) {
+		return 0;
+	}
+	uint16_t count = SDLOG_Get16(&index[6]);
+	return count > SDLOG_MAX_SESSIONS ? 0 : count;
+}
+
+/**
+ * Start filling the block at head.
+ *
+ * @retval 1 OK
+ * @retval 0 no free buffer or end of the log region
+ */
+static uint8_t SDLOG_StartBlock() {
+	if ((uint8_t)(SDLOG_head - SDLOG_tail) >= SDLOG_BUFFER_BLOCKS
+			|| SDLOG_start_block + SDLOG_stats.blocks_sealed >= SDLOG_limit_block) {
+		return 0;
+	}
+	uint8_t *block = SDLOG_blocks[SDLOG_head & SDLOG_MASK];
+	SDLOG_Put32(block, SDLOG_MAGIC);
+	SDLOG_Put32(block + 4, SDLOG_stats.blocks_sealed);
+	SDLOG_Put16(block + 8, SDLOG_session);
+	SDLOG_Put16(block + 10, 0);
+	SDLOG_Put32(block + 12, 0xFFFFFFFF);
+	SDLOG_used = 0;
+	SDLOG_filling = 1;
+	return 1;
+}
+
+static void SDLOG_Seal() {
+	if (!SDLOG_filling) {
+		return;
+	}
+	uint8_t *block = SDLOG_blocks[SDLOG_head & SDLOG_MASK];
+	SDLOG_Put16(block + 10, SDLOG_used);
+	memset(block + SDLOG_HEADER_SIZE + SDLOG_used, 0xFF, SDLOG_PAYLOAD_SIZE - SDLOG_used);
+	SDLOG_filling = 0;
+	SDLOG_head++;
+	SDLOG_stats.blocks_sealed++;
+
+	uint8_t waiting = SDLOG_head - SDLOG_tail;
+	if (waiting > SDLOG_stats.max_waiting) {
+		SDLOG_stats.max_waiting = waiting;
+	}
+}
+
+/**
+ * Find the end of a session by a binary search on the data block headers: blocks of the
+ * session have its number and consecutive sequence numbers from its start block. Uses the
+ * last block buffer, no multi-block write must be open.
+ *
+ * @param session: session number in the index.
+ * @param entry: session from the index (SDLOG_ReadSession).
+ * @param limit_block: first block after the log region.
+ * @param end_block: first block after the last valid block of the session.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, read error
+ * @retval -2 BUSY, log open
+ */
+int8_t SDLOG_FindEnd(uint16_t session, const SDLOG_Session *entry, uint32_t limit_block, uint32_t *end_block) {
+	if (SD_GetState() != SD_STATE_IDLE) {
+		return -2; // Busy
+	}
+
+	uint8_t *block = SDLOG_blocks[SDLOG_BUFFER_BLOCKS - 1];
+	uint32_t low = entry->start_block; // Every block before "low" is valid
+	uint32_t high = limit_block;       // Block "high" is invalid or outside the region
+	if (entry->reserved_blocks > 0 && entry->start_block + entry->reserved_blocks < high) {
+		// Usually inside the pre-erased blocks, check the first block after them
+		uint32_t reserved_end = entry->start_block + entry->reserved_blocks;
+		if (SD_ReadBlock(reserved_end, block) != 0) {
+			return -1; // Read error
+		}
+		if (SDLOG_Get32(block) != SDLOG_MAGIC || SDLOG_Get16(block + 8) != session
+				|| SDLOG_Get32(block + 4) != reserved_end - entry->start_block) {
+			high = reserved_end;
+		}
+	}
+
+	while (low < high) {
+		uint32_t middle = low + (high - low) / 2;
+		if (SD_ReadBlock(middle, block) != 0) {
+			return -1; // Read error
+		}
+		if (SDLOG_Get32(block) == SDLOG_MAGIC && SDLOG_Get16(block + 8) == session
+				&& SDLOG_Get32(block + 4) == middle - entry->start_block) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	*end_block = low;
+	return 0; // OK
+}
+
+/**
+ * Open a new logging session after the last one (blocking, on the pad): read the index,
+ * find the end of the last session if it was not closed, add the new session to the index
+ * and open the multi-block write. SD_Init must be successful (after a reset, it closes the
+ * multi-block write of the previous session).
+ *
+ * @param first_block: index block, the log uses the following blocks.
+ * @param blocks: size of the log region, index included.
+ * @param reserve_blocks: blocks pre-erased for the session (expected flight length).
+ * @param time_ms: current time, saved in the index.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, card error or multi-block write open
+ * @retval -3 ERROR, log region or index full
+ */
+int8_t SDLOG_Init(uint32_t first_block, uint32_t blocks, uint32_t reserve_blocks, uint32_t time_ms) {
+	SDLOG_open = 0;
+	if (SD_GetType() == SD_TYPE_NONE || SD_GetState() != SD_STATE_IDLE || blocks < 2) {
+		return -1; // Error
+	}
+
+	SDLOG_index_block = first_block;
+	SDLOG_limit_block = first_block + blocks;
+	uint8_t *index = SDLOG_blocks[0];
+	if (SD_ReadBlock(first_block, index) != 0) {
+		return -1; // Read error
+	}
+
+	uint16_t count = SDLOG_IndexCount(index);
+	if (count == 0) {
+		memset(index, 0xFF, SD_BLOCK_SIZE);
+		SDLOG_Put32(index, SDLOG_INDEX_MAGIC);
+		SDLOG_Put16(index + 4, SDLOG_INDEX_VERSION);
+	}
+	if (count >= SDLOG_MAX_SESSIONS) {
+		return -3; // Index full
+	}
+
+	SDLOG_Session entry;
+	entry.start_block = first_block + 1;
+	if (count > 0) {
+		SDLOG_Session last;
+		SDLOG_GetEntry(index, count - 1, &last);
+		if (last.end_block == SDLOG_OPEN) {
+			// Power lost during the last session
+			if (SDLOG_FindEnd(count - 1, &last, SDLOG_limit_block, &last.end_block) != 0) {
+				return -1; // Read error
+			}
+			SDLOG_PutEntry(index, count - 1, &last);
+		}
+		entry.start_block = last.end_block;
+	}
+	if (entry.start_block >= SDLOG_limit_block) {
+		return -3; // Log region full
+	}
+	entry.end_block = SDLOG_OPEN;
+	entry.start_time_ms = time_ms;
+	entry.reserved_blocks = reserve_blocks;
+	if (entry.reserved_blocks > SDLOG_limit_block - entry.start_block) {
+		entry.reserved_blocks = SDLOG_limit_block - entry.start_block;
+	}
+
+	SDLOG_PutEntry(index, count, &entry);
+	SDLOG_Put16(index + 6, count + 1);
+	if (SD_WriteBlock(first_block, index) != 0) {
+		return -1; // Write error
+	}
+	if (SD_WriteStart(entry.start_block, entry.reserved_blocks) != 0) {
+		return -1; // Card error
+	}
+
+	SDLOG_session = count;
+	SDLOG_start_block = entry.start_block;
+	SDLOG_head = 0;
+	SDLOG_sent = 0;
+	SDLOG_tail = 0;
+	SDLOG_filling = 0;
+	SDLOG_used = 0;
+	memset(&SDLOG_stats, 0, sizeof(SDLOG_stats));
+	SDLOG_open = 1;
+
+	return 0; // OK
+}
+
+/**
+ * Copy a record in the current block and return, never waits for the card.
+ *
+ * @param data: record.
+ * @param size: bytes, SDLOG_PAYLOAD_SIZE at most.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, log not open or invalid size
+ * @retval -2 DROPPED, every buffer is waiting for the card (or end of the log region)
+ */
+int8_t SDLOG_Write(const uint8_t data[], uint16_t size) {
+	if (!SDLOG_open || data == NULL || size == 0 || size > SDLOG_PAYLOAD_SIZE) {
+		return -1; // Error
+	}
+
+	if (SDLOG_filling && SDLOG_used + size > SDLOG_PAYLOAD_SIZE) {
+		SDLOG_Seal();
+	}
+	if (!SDLOG_filling && !SDLOG_StartBlock()) {
+		SDLOG_stats.dropped++;
+		return -2; // Dropped
+	}
+
+	memcpy(SDLOG_blocks[SDLOG_head & SDLOG_MASK] + SDLOG_HEADER_SIZE + SDLOG_used, data, size);
+	SDLOG_used += size;
+	SDLOG_stats.records++;
+	SDLOG_stats.bytes += size;
+
+	return 0; // OK
+}
+
+/**
+ * Seal the current block even if it is not full, it is written at the next SDLOG_Process
+ * calls (end of a flight phase, before a risky event).
+ */
+void SDLOG_Flush() {
+	if (SDLOG_open && SDLOG_used > 0) {
+		SDLOG_Seal();
+	}
+}
+
+/**
+ * Follow the block in progress and start the next sealed block when the card is ready.
+ * Never waits, call periodically (logging task).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, block rejected by the card
+ * @retval -3 TIMEOUT, card busy for too long
+ */
+int8_t SDLOG_Process() {
+	if (!SDLOG_open) {
+		return 0;
+	}
+
+	int8_t status = SD_Poll();
+	if (status > 0) {
+		status = 0;
+	}
+
+	// DMA finished, the buffer can be filled again
+	if (SDLOG_sent != SDLOG_tail && !SD_DMABusy()) {
+		SDLOG_tail = SDLOG_sent;
+		SDLOG_stats.blocks_written++;
+	}
+
+	if (SDLOG_sent != SDLOG_head && SD_GetState() == SD_STATE_READY) {
+		if (SD_WriteNext(SDLOG_blocks[SDLOG_sent & SDLOG_MASK]) == 0) {
+			SDLOG_sent++;
+		}
+	}
+
+	return status;
+}
+
+/**
+ * Write the last blocks, close the multi-block write and save the end of the session in
+ * the index (blocking, up to SDLOG_CLOSE_TIMEOUT_MS, after landing).
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, log not open or card error
+ * @retval -3 TIMEOUT
+ */
+int8_t SDLOG_Close() {
+	if (!SDLOG_open) {
+		return -1; // Error
+	}
+
+	SDLOG_Flush();
+	uint32_t start_ms = HAL_GetTick();
+	while (SDLOG_tail != SDLOG_head || SD_GetState() != SD_STATE_READY) {
+		SDLOG_Process();
+		if (HAL_GetTick() - start_ms > SDLOG_CLOSE_TIMEOUT_MS) {
+			return -3; // Timeout
+		}
+	}
+	if (SD_WriteStop() != 0) {
+		return -1; // Card error
+	}
+	while (SD_Poll() == 0) {
+		if (HAL_GetTick() - start_ms > SDLOG_CLOSE_TIMEOUT_MS) {
+			return -3; // Timeout
+		}
+	}
+	SDLOG_open = 0;
+
+	uint8_t *index = SDLOG_blocks[0];
+	if (SD_ReadBlock(SDLOG_index_block, index) != 0 || SDLOG_IndexCount(index) != SDLOG_session + 1) {
+		return -1; // Read error or index changed
+	}
+	SDLOG_Session entry;
+	SDLOG_GetEntry(index, SDLOG_session, &entry);
+	entry.end_block = SDLOG_start_block + SDLOG_stats.blocks_sealed;
+	SDLOG_PutEntry(index, SDLOG_session, &entry);
+	if (SD_WriteBlock(SDLOG_index_block, index) != 0) {
+		return -1; // Write error
+	}
+
+	return 0; // OK
+}
+
+/**
+ * Read a session from the index. Uses the first block buffer, no multi-block write must be
+ * open.
+ *
+ * @param first_block: index block.
+ * @param session: session number.
+ * @param entry: session read.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, read error or no such session
+ * @retval -2 BUSY, log open
+ */
+int8_t SDLOG_ReadSession(uint32_t first_block, uint16_t session, SDLOG_Session *entry) {
+	if (SD_GetState() != SD_STATE_IDLE) {
+		return -2; // Busy
+	}
+
+	uint8_t *index = SDLOG_blocks[0];
+	if (SD_ReadBlock(first_block, index) != 0 || session >= SDLOG_IndexCount(index)) {
+		return -1; // Error
+	}
+	SDLOG_GetEntry(index, session, entry);
+
+	return 0; // OK
+}
+
+/**
+ * @return record bytes left in the block filling, 0 if no block is filling (the next
+ * record starts a block)
+ */
+uint16_t SDLOG_Free() {
+	return SDLOG_open && SDLOG_filling ? SDLOG_PAYLOAD_SIZE - SDLOG_used : 0;
+}
+
+/**
+ * @retval 1 session open, records can be written
+ */
+uint8_t SDLOG_IsOpen() {
+	return SDLOG_open;
+}
+
+/**
+ * @return number of the current (or last) session in the index
+ */
+uint16_t SDLOG_GetSession() {
+	return SDLOG_session;
+}
+
+const SDLOG_Stats *SDLOG_GetStats() {
+	return &SDLOG_stats;
+}
@@ -0,0 +1,226 @@
+/*
+ * TELEMETRY.c
+ *
+ * Telemetry packet selection.
+ *
+ * The budget is a token bucket: it fills at max_bytes_per_s up to burst_bytes, and a packet
+ * costs its frame size (PACKET_FrameSize). TELEMETRY_Next takes the packet types in the
+ * priority order of the phase and returns the first one that is due. If the budget is too
+ * low for it, nothing is returned: lower priority packets do not use the budget saved for
+ * a higher priority one. The radio queue occupancy is the second limit, it catches what the
+ * budget does not see (slower link than configured, frames from other producers).
+ *
+ * A packet type that is late by more than one period is released again one period later,
+ * missed packets are not sent in a burst.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/TELEMETRY.h"
+
+#include <stddef.h>
+
+// Default periods (ms) of each phase: -, FLIGHT, BARO, GNSS, HEALTH
+static const uint16_t TELEMETRY_DEFAULT_PERIODS[FLIGHT_PHASE_COUNT][PACKET_TYPE_COUNT] = {
+	{ 0,  1000,  5000,  1000,  5000 }, // PAD: position at 1 Hz
+	{ 0,     0,  1000,  1000, 10000 }, // BOOST: altitude and velocity at every run
+	{ 0,     0,  1000,  1000, 10000 }, // COAST
+	{ 0,     0,  1000,     0, 10000 }, // APOGEE
+	{ 0,     0,  2000,     0, 10000 }, // DROGUE: position at every run
+	{ 0,     0,  2000,     0, 10000 }, // MAIN
+	{ 0,  5000, 10000,  1000,  5000 }, // LANDED: position for the recovery team
+};
+
+// Default priority order of each phase
+static const uint8_t TELEMETRY_DEFAULT_ORDER[FLIGHT_PHASE_COUNT][TELEMETRY_TYPE_COUNT] = {
+	{ PACKET_TYPE_FLIGHT, PACKET_TYPE_GNSS, PACKET_TYPE_HEALTH, PACKET_TYPE_BARO }, // PAD
+	{ PACKET_TYPE_FLIGHT, PACKET_TYPE_GNSS, PACKET_TYPE_BARO, PACKET_TYPE_HEALTH }, // BOOST
+	{ PACKET_TYPE_FLIGHT, PACKET_TYPE_GNSS, PACKET_TYPE_BARO, PACKET_TYPE_HEALTH }, // COAST
+	{ PACKET_TYPE_FLIGHT, PACKET_TYPE_GNSS, PACKET_TYPE_BARO, PACKET_TYPE_HEALTH }, // APOGEE
+	{ PACKET_TYPE_GNSS, PACKET_TYPE_FLIGHT, PACKET_TYPE_BARO, PACKET_TYPE_HEALTH }, // DROGUE
+	{ PACKET_TYPE_GNSS, PACKET_TYPE_FLIGHT, PACKET_TYPE_BARO, PACKET_TYPE_HEALTH }, // MAIN
+	{ PACKET_TYPE_GNSS, PACKET_TYPE_FLIGHT, PACKET_TYPE_HEALTH, PACKET_TYPE_BARO }, // LANDED
+};
+
+/**
+ * Fill a configuration structure with default values.
+ *
+ * @param config: pointer to a TELEMETRY_Config structure.
+ */
+void TELEMETRY_DefaultConfig(TELEMETRY_Config *config) {
+	for (uint8_t phase = 0; phase < FLIGHT_PHASE_COUNT; phase++) {
+		for (uint8_t type = 0; type < PACKET_TYPE_COUNT; type++) {
+			config->period_ms[phase][type] = TELEMETRY_DEFAULT_PERIODS[phase][type];
+		}
+		for (uint8_t i = 0; i < TELEMETRY_TYPE_COUNT; i++) {
+			config->order[phase][i] = TELEMETRY_DEFAULT_ORDER[phase][i];
+		}
+	}
+	config->max_bytes_per_s = TELEMETRY_DEFAULT_MAX_BYTES_PER_S;
+	config->burst_bytes = TELEMETRY_DEFAULT_BURST_BYTES;
+	config->queue_high = TELEMETRY_DEFAULT_QUEUE_HIGH;
+	config->queue_full = TELEMETRY_DEFAULT_QUEUE_FULL;
+}
+
+/**
+ * Initialize on the pad with a full budget.
+ *
+ * @param telemetry: pointer to a TELEMETRY structure.
+ * @param config: pointer to a configuration, NULL to use default configuration.
+ * @param time_ms: current time.
+ *
+ * @retval 0 OK
+ * @retval -1 ERROR, bad configuration
+ */
+int8_t TELEMETRY_Init(TELEMETRY *telemetry, const TELEMETRY_Config *config, uint32_t time_ms) {
+	if (telemetry == NULL) {
+		return -1; // Error, NULL structure
+	}
+
+	if (config == NULL) {
+		TELEMETRY_DefaultConfig(&telemetry->config);
+	} else {
+		if (config->max_bytes_per_s == 0 || config->burst_bytes < PACKET_MAX_FRAME_SIZE
+				|| config->queue_high == 0 || config->queue_full < config->queue_high) {
+			return -1; // Error, a packet could never be sent
+		}
+		for (uint8_t phase = 0; phase < FLIGHT_PHASE_COUNT; phase++) {
+			for (uint8_t i = 0; i < TELEMETRY_TYPE_COUNT; i++) {
+				if (PACKET_PayloadSize(config->order[phase][i]) == 0) {
+					return -1; // Error, unknown packet type
+				}
+			}
+		}
+		telemetry->config = *config;
+	}
+
+	telemetry->budget_mbytes = (uint32_t)telemetry->config.burst_bytes * 1000;
+	telemetry->budget_time_ms = time_ms;
+	TELEMETRY_SetPhase(telemetry, FLIGHT_PHASE_PAD, time_ms);
+
+	return 0; // OK
+}
+
+/**
+ * Use the periods and priorities of a phase. Every packet type is due immediately and the
+ * statistics restart, so the rates are measured per phase.
+ *
+ * @param telemetry: pointer to a TELEMETRY structure.
+ * @param phase: FLIGHT_PHASE_x
+ * @param time_ms: current time.
+ */
+void TELEMETRY_SetPhase(TELEMETRY *telemetry, uint8_t phase, uint32_t time_ms) {
+	if (phase >= FLIGHT_PHASE_COUNT) {
+		return;
+	}
+	telemetry->phase = phase;
+	telemetry->phase_time_ms = time_ms;
+	for (uint8_t type = 0; type < PACKET_TYPE_COUNT; type++) {
+		TELEMETRY_Type *stats = &telemetry->types[type];
+		stats->next_ms = time_ms;
+		stats->last_ms = time_ms - 1; // Not sent in this run
+		stats->sent = 0;
+		stats->bytes = 0;
+		stats->deferred = 0;
+	}
+}
+
+static void TELEMETRY_Refill(TELEMETRY *telemetry, uint32_t time_ms) {
+	uint32_t elapsed_ms = time_ms - telemetry->budget_time_ms;
+	uint32_t max_mbytes = (uint32_t)telemetry->config.burst_bytes * 1000;
+	telemetry->budget_time_ms = time_ms;
+
+	// bytes/s * ms = 1/1000 byte, limit elapsed time to avoid overflow after a long pause
+	if (elapsed_ms > 60000) {
+		elapsed_ms = 60000;
+	}
+	telemetry->budget_mbytes += elapsed_ms * telemetry->config.max_bytes_per_s;
+	if (telemetry->budget_mbytes > max_mbytes) {
+		telemetry->budget_mbytes = max_mbytes;
+	}
+}
+
+/**
+ * @retval 1 packet type due at time_ms
+ */
+static uint8_t TELEMETRY_Due(const TELEMETRY *telemetry, uint8_t type, uint32_t time_ms) {
+	uint16_t period_ms = telemetry->config.period_ms[telemetry->phase][type];
+	const TELEMETRY_Type *stats = &telemetry->types[type];
+
+	if (period_ms == TELEMETRY_NEVER) {
+		return 0;
+	}
+	if (period_ms == TELEMETRY_EVERY_RUN) {
+		return stats->last_ms != time_ms; // Once per run
+	}
+	return (int32_t)(time_ms - stats->next_ms) >= 0;
+}
+
+/**
+ * Choose the next packet to send. Call in a loop at each telemetry run until it returns 0,
+ * and send the returned packet type each time (the budget is already charged).
+ *
+ * @param telemetry: pointer to a TELEMETRY structure.
+ * @param time_ms: time of the run (same value for every call of the run).
+ * @param queue_pending: frames waiting in the radio queue (RFD900_Pending).
+ *
+ * @return PACKET_TYPE_x to send, 0 if nothing to send now
+ */
+uint8_t TELEMETRY_Next(TELEMETRY *telemetry, uint32_t time_ms, uint8_t queue_pending) {
+	TELEMETRY_Refill(telemetry, time_ms);
+
+	for (uint8_t i = 0; i < TELEMETRY_TYPE_COUNT; i++) {
+		uint8_t type = telemetry->config.order[telemetry->phase][i];
+		if (!TELEMETRY_Due(telemetry, type, time_ms)) {
+			continue;
+		}
+
+		TELEMETRY_Type *stats = &telemetry->types[type];
+		uint32_t cost_mbytes = (uint32_t)PACKET_FrameSize(type) * 1000;
+		if (queue_pending >= telemetry->config.queue_full || (queue_pending >= telemetry->config.queue_high && i > 0)
+				|| telemetry->budget_mbytes < cost_mbytes) {
+			stats->deferred++; // Once per run, the caller stops at 0
+			return 0; // Keep the budget for the highest priority packet due
+		}
+
+		telemetry->budget_mbytes -= cost_mbytes;
+		uint16_t period_ms = telemetry->config.period_ms[telemetry->phase][type];
+		stats->next_ms += period_ms;
+		if ((int32_t)(time_ms - stats->next_ms) >= 0) {
+			stats->next_ms = time_ms + period_ms; // Late by more than one period
+		}
+		stats->last_ms = time_ms;
+		stats->sent++;
+		stats->bytes += PACKET_FrameSize(type);
+		return type;
+	}
+
+	return 0;
+}
+
+/**
+ * @return packets per second of a type since the phase started (1/1000 Hz)
+ */
+uint32_t TELEMETRY_RatemHz(const TELEMETRY *telemetry, uint8_t type, uint32_t time_ms) {
+	uint32_t elapsed_ms = time_ms - telemetry->phase_time_ms;
+	if (type == 0 || type >= PACKET_TYPE_COUNT || elapsed_ms == 0) {
+		return 0;
+	}
+	return (uint32_t)((uint64_t)telemetry->types[type].sent * 1000000 / elapsed_ms);
+}
+
+/**
+ * @return bytes per second of all packet types since the phase started
+ */
+uint32_t TELEMETRY_BytesPerSecond(const TELEMETRY *telemetry, uint32_t time_ms) {
+	uint32_t elapsed_ms = time_ms - telemetry->phase_time_ms;
+	uint32_t bytes = 0;
+	if (elapsed_ms == 0) {
+		return 0;
+	}
+	for (uint8_t type = 1; type < PACKET_TYPE_COUNT; type++) {
+		bytes += telemetry->types[type].bytes;
+	}
+	return (uint32_t)((uint64_t)bytes * 1000 / elapsed_ms);
+}
@@ -0,0 +1,151 @@
+/*
+ * TRACE.c
+ *
+ * Binary trace over ITM (SWO) with deferred formatting.
+ *
+ * TRACE_Write only copies words in the ring with interrupts disabled (can be called from
+ * interrupts), no formatting and no waiting on the SWO. When the ring is full the record is
+ * dropped, and a TRACE_ID_DROPPED record with the number of dropped records is inserted
+ * before the next record that fits, so the decoder knows something is missing.
+ *
+ * TRACE_Flush sends the ring one 32-bit word at a time and stops as soon as the ITM FIFO
+ * is full, so it never blocks. When no debugger listens on the port, the ring is emptied.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/TRACE.h"
+
+#define TRACE_MASK (TRACE_BUFFER_WORDS - 1)
+
+static uint32_t TRACE_buffer[TRACE_BUFFER_WORDS];
+static volatile uint16_t TRACE_head = 0; // Next word to write (free running)
+static volatile uint16_t TRACE_tail = 0; // Next word to send (free running)
+static uint32_t TRACE_pending_dropped = 0;
+static TRACE_Output TRACE_output = NULL;
+static TRACE_Stats TRACE_stats;
+
+/**
+ * Send one word on the ITM stimulus port.
+ *
+ * @retval 0 OK
+ * @retval -1 FIFO full
+ */
+static int8_t TRACE_OutputITM(uint32_t word) {
+	if (ITM->PORT[TRACE_PORT].u32 == 0) {
+		return -1; // FIFO full
+	}
+	ITM->PORT[TRACE_PORT].u32 = word;
+	return 0;
+}
+
+/**
+ * @retval 1 Debugger enabled ITM and the trace port
+ */
+static uint8_t TRACE_ITMEnabled() {
+	return (ITM->TCR & ITM_TCR_ITMENA_Msk) != 0 && (ITM->TER & (1UL << TRACE_PORT)) != 0;
+}
+
+/**
+ * Empty the ring and reset statistics.
+ *
+ * @param output: word output, NULL to use ITM stimulus port TRACE_PORT.
+ */
+void TRACE_Init(TRACE_Output output) {
+	TRACE_output = output;
+	TRACE_head = 0;
+	TRACE_tail = 0;
+	TRACE_pending_dropped = 0;
+	TRACE_stats.records = 0;
+	TRACE_stats.dropped = 0;
+	TRACE_stats.max_used = 0;
+}
+
+static inline void TRACE_Put(uint32_t word) {
+	TRACE_buffer[TRACE_head & TRACE_MASK] = word;
+	TRACE_head++;
+}
+
+static inline uint32_t TRACE_Header(uint16_t id, uint8_t argc) {
+	return ((uint32_t)TRACE_SYNC << 24) | ((uint32_t)(argc & 0x0F) << 16) | id;
+}
+
+/**
+ * Add a record to the ring. Use the TRACE and TRACE0 macros.
+ *
+ * Takes about 40 cycles + 5 cycles per argument
+ *
+ * @param id: TRACE_ID_x
+ * @param argc: number of arguments (TRACE_MAX_ARGS at most, extra arguments are ignored).
+ * @param args: arguments.
+ */
+void TRACE_Write(uint16_t id, uint8_t argc, const uint32_t args[]) {
+	if (argc > TRACE_MAX_ARGS) {
+		argc = TRACE_MAX_ARGS;
+	}
+	uint32_t time_ms = HAL_GetTick();
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	uint16_t used = TRACE_head - TRACE_tail;
+	uint16_t needed = 2 + argc + (TRACE_pending_dropped > 0 ? 3 : 0);
+	if (TRACE_BUFFER_WORDS - used < needed) {
+		TRACE_pending_dropped++;
+		TRACE_stats.dropped++;
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	if (TRACE_pending_dropped > 0) {
+		TRACE_Put(TRACE_Header(TRACE_ID_DROPPED, 1));
+		TRACE_Put(time_ms);
+		TRACE_Put(TRACE_pending_dropped);
+		TRACE_pending_dropped = 0;
+	}
+
+	TRACE_Put(TRACE_Header(id, argc));
+	TRACE_Put(time_ms);
+	for (uint8_t i = 0; i < argc; i++) {
+		TRACE_Put(args[i]);
+	}
+
+	TRACE_stats.records++;
+	if (used + needed > TRACE_stats.max_used) {
+		TRACE_stats.max_used = used + needed;
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * Send words from the ring, without waiting. Call from a low priority task.
+ *
+ * @param max_words: maximum number of words to send.
+ *
+ * @return number of words sent
+ */
+uint16_t TRACE_Flush(uint16_t max_words) {
+	TRACE_Output output = TRACE_output == NULL ? TRACE_OutputITM : TRACE_output;
+	uint16_t sent = 0;
+
+	if (TRACE_output == NULL && !TRACE_ITMEnabled()) {
+		TRACE_tail = TRACE_head; // Nobody listens, drop everything
+		return 0;
+	}
+
+	while (sent < max_words && TRACE_tail != TRACE_head) {
+		if (output(TRACE_buffer[TRACE_tail & TRACE_MASK]) != 0) {
+			break; // Busy, continue at next flush
+		}
+		TRACE_tail++;
+		sent++;
+	}
+
+	return sent;
+}
+
+const TRACE_Stats *TRACE_GetStats() {
+	return &TRACE_stats;
+}
@@ -0,0 +1,231 @@
+/*
+ * BLACKBOX_tests.c
+ *
+ * Barometer samples at 50 Hz (GNSS at 1 Hz) with values computed from the sample number,
+ * captured on the pad then triggered. The chunks written to the log are collected like
+ * the host decoder does (pages rebuilt from the chunk index, then decoded) and every
+ * sample is checked against the value it was given: the samples around the trigger must
+ * follow each other without a gap and without a duplicate.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/BLACKBOX_tests.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BLACKBOX_TESTS_MAX_SAMPLES 64 // In a page, 4 bytes per sample at least
+
+static BLACKBOX blackbox;
+
+// Collected from the log
+static uint8_t page[BLACKBOX_PAGE_SIZE];
+static uint8_t page_chunks;          // Chunks of "page" received, 0xFF: waiting for chunk 0
+static BLACKBOX_Sample samples[BLACKBOX_TESTS_MAX_SAMPLES];
+
+typedef struct {
+	int32_t last_baro;               // Sample number of the last barometer sample, -1: none
+	int32_t first_baro;              // Of the current window
+	uint16_t windows;                // Runs of consecutive samples
+	uint32_t baro;
+	uint32_t gnss;
+	uint32_t wrong;                  // Values different from the samples given
+	uint32_t duplicates;             // Sample written twice or out of order
+	uint32_t malformed;              // Pages that do not decode, chunks out of order
+	uint8_t triggers;
+	int32_t trigger_first[2];        // First sample of the window of each trigger
+	int32_t trigger_last[2];         // Last sample before each trigger
+} BLACKBOX_TESTS_Collected;
+
+static BLACKBOX_TESTS_Collected collected;
+
+static uint32_t BLACKBOX_TESTS_Press(uint32_t i) {
+	return 101325 * 256 - i * 3 + (i * 2654435761UL >> 22) % 1024; // Noise of +/- 2 Pa
+}
+
+static int16_t BLACKBOX_TESTS_Temp(uint32_t i) {
+	return 2000 + i / 500;
+}
+
+static int32_t BLACKBOX_TESTS_Latitude(uint32_t i) {
+	return 467800000 + (int32_t)((i * 40503UL) % 64) - 32;
+}
+
+static void BLACKBOX_TESTS_Reset(uint32_t post_ms) {
+	BLACKBOX_Init(&blackbox, post_ms);
+	memset(&collected, 0, sizeof(collected));
+	collected.last_baro = -1;
+	page_chunks = 0xFF;
+}
+
+static void BLACKBOX_TESTS_CheckSample(const BLACKBOX_Sample *sample) {
+	int32_t i = sample->time_ms / BLACKBOX_TESTS_PERIOD_MS;
+
+	switch (sample->type) {
+	case BLACKBOX_TAG_BARO:
+		collected.baro++;
+		if (sample->time_ms % BLACKBOX_TESTS_PERIOD_MS != 0 || sample->press_Pa_Q8 != BLACKBOX_TESTS_Press(i)
+				|| sample->temp_cC != BLACKBOX_TESTS_Temp(i)) {
+			collected.wrong++;
+		}
+		if (collected.last_baro >= 0 && i <= collected.last_baro) {
+			collected.duplicates++;
+		} else if (collected.last_baro < 0 || i != collected.last_baro + 1) {
+			collected.windows++;
+			collected.first_baro = i;
+		}
+		collected.last_baro = i;
+		break;
+	case BLACKBOX_TAG_GNSS:
+		collected.gnss++;
+		if (i % BLACKBOX_TESTS_GNSS_EVERY != 0 || sample->latitude_e7 != BLACKBOX_TESTS_Latitude(i)
+				|| sample->longitude_e7 != -712000000 || sample->fix != 1) {
+			collected.wrong++;
+		}
+		break;
+	case BLACKBOX_TAG_TRIGGER:
+		if (collected.triggers < 2) {
+			collected.trigger_first[collected.triggers] = collected.first_baro;
+			collected.trigger_last[collected.triggers] = collected.last_baro;
+		}
+		collected.triggers++;
+		break;
+	}
+}
+
+/**
+ * Chunk of a CAPTURE record, as the host decoder rebuilds the pages.
+ */
+static void BLACKBOX_TESTS_Collect(const uint8_t chunk[LOGREC_PAYLOAD_SIZE]) {
+	if (chunk[0] == 0) {
+		page_chunks = 0;
+	}
+	if (chunk[0] != page_chunks) {
+		collected.malformed++;
+		page_chunks = 0xFF;
+		return;
+	}
+	memcpy(page + chunk[0] * BLACKBOX_CHUNK_SIZE, chunk + 1, BLACKBOX_CHUNK_SIZE);
+	if (++page_chunks < BLACKBOX_PAGE_CHUNKS) {
+		return;
+	}
+
+	page_chunks = 0xFF;
+	int16_t count = BLACKBOX_DecodePage(page, samples, BLACKBOX_TESTS_MAX_SAMPLES);
+	if (count < 0) {
+		collected.malformed++;
+		return;
+	}
+	for (int16_t j = 0; j < count; j++) {
+		BLACKBOX_TESTS_CheckSample(&samples[j]);
+	}
+}
+
+/**
+ * Samples "from" to "to" (excluded), "chunks" CAPTURE records taken every "flush_every"
+ * samples (logging task).
+ */
+static void BLACKBOX_TESTS_Run(uint32_t from, uint32_t to, uint8_t chunks, uint8_t flush_every) {
+	uint8_t chunk[LOGREC_PAYLOAD_SIZE];
+
+	for (uint32_t i = from; i < to; i++) {
+		uint32_t time_ms = i * BLACKBOX_TESTS_PERIOD_MS;
+		BLACKBOX_AddBaro(&blackbox, time_ms, BLACKBOX_TESTS_Press(i), BLACKBOX_TESTS_Temp(i));
+		if (i % BLACKBOX_TESTS_GNSS_EVERY == 0) {
+			BLACKBOX_AddGNSS(&blackbox, time_ms, BLACKBOX_TESTS_Latitude(i), -712000000, 1);
+		}
+		for (uint8_t c = 0; i % flush_every == 0 && c < chunks && BLACKBOX_PeekChunk(&blackbox, chunk); c++) {
+			BLACKBOX_TESTS_Collect(chunk);
+			BLACKBOX_PopChunk(&blackbox);
+		}
+	}
+}
+
+/**
+ * Take every chunk waiting.
+ */
+static void BLACKBOX_TESTS_Drain() {
+	uint8_t chunk[LOGREC_PAYLOAD_SIZE];
+	while (BLACKBOX_PeekChunk(&blackbox, chunk)) {
+		BLACKBOX_TESTS_Collect(chunk);
+		BLACKBOX_PopChunk(&blackbox);
+	}
+}
+
+void BLACKBOX_TESTS_Capture_LogSTLINK() {
+	const uint32_t per_s = 1000 / BLACKBOX_TESTS_PERIOD_MS;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: 2 minutes on the pad, launch, 10 s after: the samples of the ring (more than
+	// 12 s before launch) and after launch are written once, without a gap at the trigger,
+	// and nothing is written before the trigger or after the post-trigger time
+	BLACKBOX_TESTS_Reset(10000);
+	uint32_t launch = 120 * per_s;
+	BLACKBOX_TESTS_Run(0, launch, 4, 1);
+	uint8_t nothing_before = collected.baro == 0 && BLACKBOX_Pending(&blackbox) == 0;
+	uint32_t window_ms = BLACKBOX_WindowMs(&blackbox);
+	BLACKBOX_Trigger(&blackbox, launch * BLACKBOX_TESTS_PERIOD_MS, 1);
+	BLACKBOX_TESTS_Run(launch, launch + 20 * per_s, 4, 1);
+	BLACKBOX_TESTS_Drain();
+	int32_t before = collected.trigger_last[0] - collected.trigger_first[0] + 1;
+	printf("Window %lu ms, %ld samples before launch, %lu after, %lu GNSS\n", window_ms, before,
+			collected.baro - before, collected.gnss);
+	BLACKBOX_TESTS_LogStats(&blackbox);
+	if (nothing_before && collected.windows == 1 && collected.triggers == 1 && collected.wrong == 0
+			&& collected.duplicates == 0 && collected.malformed == 0 && blackbox.stats.dropped == 0
+			&& collected.trigger_last[0] == (int32_t)launch - 1 && before * BLACKBOX_TESTS_PERIOD_MS > 12000
+			&& collected.last_baro >= (int32_t)(launch + 10 * per_s - 1)
+			&& collected.last_baro < (int32_t)(launch + 11 * per_s)) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: launch, then apogee 25 s later: two windows, the second one starts after the
+	// samples already written for launch (no duplicate) and has no gap at apogee
+	BLACKBOX_TESTS_Reset(10000);
+	uint32_t apogee = launch + 25 * per_s;
+	BLACKBOX_TESTS_Run(0, launch, 4, 1);
+	BLACKBOX_Trigger(&blackbox, launch * BLACKBOX_TESTS_PERIOD_MS, 1);
+	BLACKBOX_TESTS_Run(launch, apogee, 4, 1);
+	BLACKBOX_Trigger(&blackbox, apogee * BLACKBOX_TESTS_PERIOD_MS, 3);
+	BLACKBOX_TESTS_Run(apogee, apogee + 20 * per_s, 4, 1);
+	BLACKBOX_TESTS_Drain();
+	printf("Apogee window from %ld ms\n", collected.trigger_first[1] * BLACKBOX_TESTS_PERIOD_MS);
+	if (collected.windows == 2 && collected.triggers == 2 && collected.wrong == 0 && collected.duplicates == 0
+			&& collected.malformed == 0 && collected.trigger_last[1] == (int32_t)apogee - 1
+			&& (apogee - collected.trigger_first[1]) * BLACKBOX_TESTS_PERIOD_MS > 12000) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: the log takes one record every 200 ms only: the ring fills, the newest
+	// samples are dropped and counted, every page written is still complete and correct
+	BLACKBOX_TESTS_Reset(10000);
+	BLACKBOX_TESTS_Run(0, launch, 1, 10);
+	BLACKBOX_Trigger(&blackbox, launch * BLACKBOX_TESTS_PERIOD_MS, 1);
+	BLACKBOX_TESTS_Run(launch, launch + 20 * per_s, 1, 10);
+	BLACKBOX_TESTS_Drain();
+	BLACKBOX_TESTS_LogStats(&blackbox);
+	if (blackbox.stats.dropped > 0 && collected.wrong == 0 && collected.duplicates == 0 && collected.malformed == 0
+			&& collected.trigger_last[0] == (int32_t)launch - 1) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void BLACKBOX_TESTS_LogStats(const BLACKBOX *blackbox) {
+	const BLACKBOX_Stats *stats = &blackbox->stats;
+	printf("%lu samples (%lu.%02lu bytes each), %lu dropped, %lu pages overwritten, %lu triggers, %lu chunks\n",
+			stats->samples, stats->bytes / stats->samples, stats->bytes * 100 / stats->samples % 100, stats->dropped,
+			stats->overwritten, stats->triggers, stats->chunks);
+}
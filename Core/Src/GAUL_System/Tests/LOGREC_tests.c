@@ -0,0 +1,432 @@
+/*
+ * LOGREC_tests.c
+ *
+ * LOGREC_TESTS_Fuzz_LogSTLINK builds a log block in RAM and damages it the way a power
+ * loss or the card can: cut at every byte (rest erased, zeroed or random), 1 to 3 bits
+ * flipped in a record, random blocks. The decoder must never return a record different
+ * from the one written. LOGREC_TESTS_Model_LogSTLINK writes records through SDLOG on the
+ * SD card model (SD_tests.c) and decodes the blocks read back.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/LOGREC_tests.h"
+
+#include "GAUL_Drivers/Tests/SD_tests.h"
+#include "GAUL_System/Tests/TESTS.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define LOGREC_TESTS_SESSION  3
+#define LOGREC_TESTS_SEQUENCE 7
+
+static const char *LOGREC_TESTS_TYPE_NAMES[LOGREC_TYPE_COUNT] = { "", "TIME", "BARO", "FLIGHT", "GNSS", "EVENT",
+		"HEALTH", "CAPTURE", "UART", "MACHLOCK" };
+
+static uint32_t random_state;
+
+// Block written by LOGREC_TESTS_BuildBlock and its records
+static uint8_t original[SD_BLOCK_SIZE];
+static LOGREC_Data records[LOGREC_PER_BLOCK];
+static uint8_t types[LOGREC_PER_BLOCK];
+
+// Fields written by each type
+static const TESTS_Field LOGREC_TESTS_TIME[] = {
+	TESTS_FIELD(LOGREC_Data, session), TESTS_FIELD(LOGREC_Data, block),
+};
+static const TESTS_Field LOGREC_TESTS_BARO[] = {
+	TESTS_FIELD(LOGREC_Data, press_Pa_Q8), TESTS_FIELD(LOGREC_Data, temp_cC), TESTS_FIELD(LOGREC_Data, alt_cm),
+};
+static const TESTS_Field LOGREC_TESTS_FLIGHT[] = {
+	TESTS_FIELD(LOGREC_Data, alt_cm), TESTS_FIELD(LOGREC_Data, vel_dms), TESTS_FIELD(LOGREC_Data, accel_cms2),
+	TESTS_FIELD(LOGREC_Data, phase), TESTS_FIELD(LOGREC_Data, flags),
+};
+static const TESTS_Field LOGREC_TESTS_GNSS[] = {
+	TESTS_FIELD(LOGREC_Data, latitude_e7), TESTS_FIELD(LOGREC_Data, longitude_e7), TESTS_FIELD(LOGREC_Data, fix),
+	TESTS_FIELD(LOGREC_Data, satellites),
+};
+static const TESTS_Field LOGREC_TESTS_EVENT[] = {
+	TESTS_FIELD(LOGREC_Data, from), TESTS_FIELD(LOGREC_Data, to), TESTS_FIELD(LOGREC_Data, reason),
+	TESTS_FIELD(LOGREC_Data, alt_cm),
+};
+static const TESTS_Field LOGREC_TESTS_HEALTH[] = {
+	TESTS_FIELD(LOGREC_Data, counters),
+};
+static const TESTS_Field LOGREC_TESTS_CAPTURE[] = {
+	TESTS_FIELD(LOGREC_Data, capture),
+};
+static const TESTS_Field LOGREC_TESTS_UART[] = {
+	TESTS_FIELD(LOGREC_Data, uart), TESTS_FIELD(LOGREC_Data, overruns), TESTS_FIELD(LOGREC_Data, framing),
+	TESTS_FIELD(LOGREC_Data, noise), TESTS_FIELD(LOGREC_Data, dma), TESTS_FIELD(LOGREC_Data, parity),
+};
+static const TESTS_Field LOGREC_TESTS_MACHLOCK[] = {
+	TESTS_FIELD(LOGREC_Data, lock), TESTS_FIELD(LOGREC_Data, reason), TESTS_FIELD(LOGREC_Data, vel_dms),
+	TESTS_FIELD(LOGREC_Data, alt_cm),
+};
+static const TESTS_Fields LOGREC_TESTS_FIELDS[LOGREC_TYPE_COUNT] = {
+	[LOGREC_TYPE_TIME] = TESTS_FIELDS(LOGREC_TESTS_TIME),
+	[LOGREC_TYPE_BARO] = TESTS_FIELDS(LOGREC_TESTS_BARO),
+	[LOGREC_TYPE_FLIGHT] = TESTS_FIELDS(LOGREC_TESTS_FLIGHT),
+	[LOGREC_TYPE_GNSS] = TESTS_FIELDS(LOGREC_TESTS_GNSS),
+	[LOGREC_TYPE_EVENT] = TESTS_FIELDS(LOGREC_TESTS_EVENT),
+	[LOGREC_TYPE_HEALTH] = TESTS_FIELDS(LOGREC_TESTS_HEALTH),
+	[LOGREC_TYPE_CAPTURE] = TESTS_FIELDS(LOGREC_TESTS_CAPTURE),
+	[LOGREC_TYPE_UART] = TESTS_FIELDS(LOGREC_TESTS_UART),
+	[LOGREC_TYPE_MACHLOCK] = TESTS_FIELDS(LOGREC_TESTS_MACHLOCK),
+};
+
+static uint32_t LOGREC_TESTS_Random() {
+	return TESTS_Random(&random_state);
+}
+
+/**
+ * @retval 1 the header and the fields of the type are equal
+ */
+static uint8_t LOGREC_TESTS_Equal(uint8_t type, const LOGREC_Data *a, const LOGREC_Data *b) {
+	if (type >= LOGREC_TYPE_COUNT || a->sequence != b->sequence || a->time_ms != b->time_ms) {
+		return 0;
+	}
+	return TESTS_FieldsEqual(a, b, &LOGREC_TESTS_FIELDS[type]);
+}
+
+/**
+ * Random values in the range of every field.
+ */
+static void LOGREC_TESTS_RandomData(LOGREC_Data *data) {
+	memset(data, 0, sizeof(LOGREC_Data));
+	data->press_Pa_Q8 = LOGREC_TESTS_Random();
+	data->temp_cC = LOGREC_TESTS_Random();
+	data->alt_cm = LOGREC_TESTS_Random() << 8;
+	data->vel_dms = LOGREC_TESTS_Random();
+	data->accel_cms2 = LOGREC_TESTS_Random();
+	data->phase = LOGREC_TESTS_Random();
+	data->flags = LOGREC_TESTS_Random();
+	data->latitude_e7 = LOGREC_TESTS_Random() << 8;
+	data->longitude_e7 = LOGREC_TESTS_Random() << 8;
+	data->fix = LOGREC_TESTS_Random();
+	data->satellites = LOGREC_TESTS_Random();
+	data->from = LOGREC_TESTS_Random();
+	data->to = LOGREC_TESTS_Random();
+	data->reason = LOGREC_TESTS_Random();
+	for (uint8_t i = 0; i < LOGREC_COUNTER_COUNT; i++) {
+		data->counters[i] = LOGREC_TESTS_Random();
+	}
+	for (uint8_t i = 0; i < LOGREC_PAYLOAD_SIZE; i++) {
+		data->capture[i] = LOGREC_TESTS_Random();
+	}
+	data->uart = LOGREC_TESTS_Random();
+	data->overruns = LOGREC_TESTS_Random();
+	data->framing = LOGREC_TESTS_Random();
+	data->noise = LOGREC_TESTS_Random();
+	data->dma = LOGREC_TESTS_Random();
+	data->parity = LOGREC_TESTS_Random();
+	data->lock = LOGREC_TESTS_Random();
+}
+
+/**
+ * Block of the log as LOGREC_Write and SDLOG fill it: TIME record, then random records
+ * of every type, every 1 to 256 ms.
+ */
+static void LOGREC_TESTS_BuildBlock() {
+	LOGREC log;
+	uint32_t time_ms = LOGREC_TESTS_Random();
+
+	LOGREC_Init(&log);
+	log.sequence = LOGREC_TESTS_Random();
+	memset(original, 0xFF, SD_BLOCK_SIZE);
+	const uint8_t header[12] = { 0x47, 0x4C, 0x4F, 0x47, LOGREC_TESTS_SEQUENCE, 0, 0, 0, LOGREC_TESTS_SESSION, 0,
+			(LOGREC_PER_BLOCK * LOGREC_SIZE) & 0xFF, (LOGREC_PER_BLOCK * LOGREC_SIZE) >> 8 }; // SDLOG_MAGIC, sequence, session, used
+	memcpy(original, header, sizeof(header));
+
+	for (uint8_t i = 0; i < LOGREC_PER_BLOCK; i++) {
+		LOGREC_TESTS_RandomData(&records[i]);
+		types[i] = i == 0 ? LOGREC_TYPE_TIME : LOGREC_TYPE_BARO + LOGREC_TESTS_Random() % (LOGREC_TYPE_COUNT - 2);
+		if (i == 0) {
+			records[i].session = LOGREC_TESTS_SESSION;
+			records[i].block = LOGREC_TESTS_SEQUENCE;
+		} else {
+			time_ms += 1 + LOGREC_TESTS_Random() % 256;
+		}
+		records[i].time_ms = time_ms;
+		records[i].sequence = log.sequence;
+		LOGREC_Encode(&log, types[i], &records[i], original + SDLOG_HEADER_SIZE + i * LOGREC_SIZE);
+	}
+}
+
+/**
+ * Decode a block record by record and compare with the records of LOGREC_TESTS_BuildBlock.
+ *
+ * @param valid: bit i set if record i was decoded.
+ *
+ * @return number of decoded records different from the record written at their place
+ */
+static uint16_t LOGREC_TESTS_Check(const uint8_t block[], uint32_t *valid) {
+	LOGREC_Decoder decoder;
+	LOGREC_Data data;
+	uint8_t type;
+	uint16_t wrong = 0;
+
+	LOGREC_DecoderInit(&decoder);
+	*valid = 0;
+	for (uint8_t i = 0; i < LOGREC_PER_BLOCK; i++) {
+		if (LOGREC_Decode(&decoder, block + SDLOG_HEADER_SIZE + i * LOGREC_SIZE, &type, &data) != 1) {
+			continue;
+		}
+		if (type == types[i] && LOGREC_TESTS_Equal(type, &records[i], &data)) {
+			*valid |= 1UL << i;
+		} else {
+			wrong++;
+		}
+	}
+	return wrong;
+}
+
+void LOGREC_TESTS_Fuzz_LogSTLINK() {
+	uint8_t block[SD_BLOCK_SIZE];
+	uint8_t record[LOGREC_SIZE];
+	uint8_t type;
+	LOGREC log;
+	LOGREC_Decoder decoder;
+	LOGREC_Data data;
+	LOGREC_Data decoded;
+	uint32_t valid;
+	uint16_t wrong = 0;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: 1000 random records of every type decoded equal, invalid type or time
+	// rejected by the encoder, record before a TIME record rejected by the decoder
+	random_state = 1;
+	uint8_t ok = 1;
+	LOGREC_Init(&log);
+	LOGREC_DecoderInit(&decoder);
+	for (uint16_t i = 0; i < 1000; i++) {
+		for (uint8_t t = LOGREC_TYPE_TIME; t < LOGREC_TYPE_COUNT; t++) {
+			LOGREC_TESTS_RandomData(&data);
+			data.time_ms = log.base_time_ms + (t == LOGREC_TYPE_TIME ? LOGREC_TESTS_Random() : i * 65);
+			data.sequence = log.sequence;
+			ok &= LOGREC_Encode(&log, t, &data, record) == LOGREC_SIZE;
+			ok &= LOGREC_Decode(&decoder, record, &type, &decoded) == 1 && type == t;
+			ok &= LOGREC_TESTS_Equal(t, &data, &decoded);
+		}
+	}
+	data.time_ms = log.base_time_ms + LOGREC_MAX_DELTA_MS + 1;
+	ok &= LOGREC_Encode(&log, LOGREC_TYPE_BARO, &data, record) == 0;
+	ok &= LOGREC_Encode(&log, 0, &data, record) == 0 && LOGREC_Encode(&log, LOGREC_TYPE_COUNT, &data, record) == 0;
+	data.time_ms = log.base_time_ms;
+	LOGREC_Encode(&log, LOGREC_TYPE_FLIGHT, &data, record);
+	LOGREC_DecoderInit(&decoder);
+	ok &= LOGREC_Decode(&decoder, record, &type, &decoded) == -3;
+	ok &= decoder.lost == 0 && decoder.invalid == 1;
+	if (ok) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: block cut at every byte (power loss while the card programs it), the rest
+	// erased (0xFF), zeroed or random: every record before the cut is decoded, nothing
+	// after it (a record cut on its last bytes is complete if they were equal to the fill)
+	random_state = 2;
+	ok = 1;
+	LOGREC_TESTS_BuildBlock();
+	for (uint16_t cut = SDLOG_HEADER_SIZE; cut <= SD_BLOCK_SIZE; cut++) {
+		for (uint8_t fill = 0; fill < 3; fill++) {
+			memcpy(block, original, cut);
+			for (uint16_t i = cut; i < SD_BLOCK_SIZE; i++) {
+				block[i] = fill == 0 ? 0xFF : fill == 1 ? 0x00 : LOGREC_TESTS_Random();
+			}
+			uint8_t complete = 0;
+			while (complete < LOGREC_PER_BLOCK
+					&& memcmp(block + SDLOG_HEADER_SIZE + complete * LOGREC_SIZE,
+							original + SDLOG_HEADER_SIZE + complete * LOGREC_SIZE, LOGREC_SIZE) == 0) {
+				complete++;
+			}
+			wrong += LOGREC_TESTS_Check(block, &valid);
+			LOGREC_Data last = { 0 };
+			int16_t count = LOGREC_ScanBlock(block, LOGREC_TESTS_SESSION, LOGREC_TESTS_SEQUENCE, &last);
+			ok &= valid == (1UL << complete) - 1 && count == complete;
+			ok &= complete == 0 || last.time_ms == records[complete - 1].time_ms;
+		}
+	}
+	ok &= LOGREC_ScanBlock(original, LOGREC_TESTS_SESSION, LOGREC_TESTS_SEQUENCE + 1, NULL) == -1;
+	ok &= LOGREC_ScanBlock(original, LOGREC_TESTS_SESSION + 1, LOGREC_TESTS_SEQUENCE, NULL) == -1;
+	if (ok && wrong == 0) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed (%u wrong records)\n", wrong);
+	}
+
+	// Test 3: 1 to 3 bits flipped in a record: only this record is lost (the whole block
+	// if it is the TIME record), no wrong record is decoded
+	random_state = 3;
+	ok = 1;
+	wrong = 0;
+	for (uint16_t n = 0; n < LOGREC_TESTS_FUZZ_ITERATIONS; n++) {
+		LOGREC_TESTS_BuildBlock();
+		memcpy(block, original, SD_BLOCK_SIZE);
+		uint8_t damaged = LOGREC_TESTS_Random() % LOGREC_PER_BLOCK;
+		uint8_t flips = 1 + LOGREC_TESTS_Random() % 3;
+		uint8_t bits[3];
+		for (uint8_t f = 0; f < flips; f++) {
+			// Different bits, flipping one twice would cancel
+			uint8_t again;
+			do {
+				bits[f] = LOGREC_TESTS_Random() % (LOGREC_SIZE * 8);
+				again = 0;
+				for (uint8_t g = 0; g < f; g++) {
+					again |= bits[g] == bits[f];
+				}
+			} while (again);
+			block[SDLOG_HEADER_SIZE + damaged * LOGREC_SIZE + bits[f] / 8] ^= 1 << (bits[f] % 8);
+		}
+		wrong += LOGREC_TESTS_Check(block, &valid);
+		ok &= valid == (damaged == 0 ? 0 : 0x7FFFFFFF & ~(1UL << damaged));
+	}
+	if (ok && wrong == 0) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed (%u wrong records)\n", wrong);
+	}
+
+	// Test 4: random blocks with a valid header (stale data of an older card content):
+	// no record accepted
+	random_state = 4;
+	uint32_t accepted = 0;
+	for (uint16_t n = 0; n < LOGREC_TESTS_FUZZ_ITERATIONS; n++) {
+		for (uint16_t i = SDLOG_HEADER_SIZE; i < SD_BLOCK_SIZE; i++) {
+			block[i] = LOGREC_TESTS_Random();
+		}
+		int16_t count = LOGREC_ScanBlock(block, LOGREC_TESTS_SESSION, LOGREC_TESTS_SEQUENCE, NULL);
+		accepted += count > 0 ? count : 0;
+	}
+	printf("%lu records accepted in %u random blocks\n", accepted, LOGREC_TESTS_FUZZ_ITERATIONS);
+	if (accepted == 0) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+/**
+ * Advance the model for "duration_ms" from "time_ms", SDLOG_Process runs every 10 ms.
+ */
+static uint32_t LOGREC_TESTS_Run(uint32_t time_ms, uint16_t duration_ms) {
+	for (uint16_t ms = 0; ms < duration_ms; ms++) {
+		if (time_ms % 10 == 0) {
+			SDLOG_Process();
+		}
+		SD_TESTS_ModelAdvance(1000);
+		time_ms++;
+	}
+	return time_ms;
+}
+
+/**
+ * Write "count" FLIGHT and BARO records every "period_ms" from "time_ms" through SDLOG on
+ * the model.
+ */
+static uint32_t LOGREC_TESTS_Log(LOGREC *log, uint32_t time_ms, uint16_t count, uint16_t period_ms) {
+	LOGREC_Data data = { 0 };
+
+	for (uint16_t i = 0; i < count; i++) {
+		data.time_ms = time_ms;
+		data.alt_cm = i;
+		LOGREC_Write(log, i % 2 ? LOGREC_TYPE_BARO : LOGREC_TYPE_FLIGHT, &data);
+		time_ms = LOGREC_TESTS_Run(time_ms, period_ms);
+	}
+	return time_ms;
+}
+
+void LOGREC_TESTS_Model_LogSTLINK() {
+	SD_TESTS_Card card = { 1, 1, 20, 1000, 0, 0 };
+	uint8_t block[SD_BLOCK_SIZE];
+	LOGREC log;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: 40 records every 10 ms, 70 s without record, 20 records: the first block is
+	// full (TIME and 30 records), the gap seals the second block early, every record is
+	// decoded at its time
+	SD_TESTS_ModelReset(&card);
+	LOGREC_Init(&log);
+	int8_t status = SD_TESTS_ModelInit();
+	status |= SDLOG_Init(0, SD_TESTS_MODEL_BLOCKS, 16, 0);
+	uint32_t time_ms = LOGREC_TESTS_Log(&log, 1000, 40, 10);
+	time_ms = LOGREC_TESTS_Log(&log, time_ms + 70000, 20, 10);
+	SDLOG_Flush();
+	LOGREC_TESTS_Run(time_ms, 100); // Last block written
+	status |= SDLOG_Close();
+
+	const int16_t expected[] = { LOGREC_PER_BLOCK, 11, 21 };
+	const uint32_t first_ms[] = { 1000, 1300, 71400 };
+	uint8_t ok = status == 0 && log.records == 60 && log.syncs == 3 && log.dropped == 0;
+	for (uint8_t i = 0; i < 3; i++) {
+		LOGREC_Data last;
+		ok &= SD_ReadBlock(1 + i, block) == 0;
+		int16_t count = LOGREC_ScanBlock(block, 0, i, &last);
+		ok &= count == expected[i] && last.time_ms == first_ms[i] + (count - 2) * 10;
+		printf("Block %u: %d records, last at %lu ms\n", i, count, last.time_ms);
+	}
+	if (ok) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void LOGREC_TESTS_LogData(uint8_t type, const LOGREC_Data *data) {
+	if (type == 0 || type >= LOGREC_TYPE_COUNT) {
+		printf("Unknown record type %u\n", type);
+		return;
+	}
+	printf("%s #%u %lu ms:", LOGREC_TESTS_TYPE_NAMES[type], data->sequence, data->time_ms);
+	switch (type) {
+	case LOGREC_TYPE_TIME:
+		printf(" session %u, block %lu\n", data->session, data->block);
+		break;
+	case LOGREC_TYPE_BARO:
+		printf(" %lu Pa/256, %d cC, %ld cm\n", data->press_Pa_Q8, data->temp_cC, data->alt_cm);
+		break;
+	case LOGREC_TYPE_FLIGHT:
+		printf(" %ld cm, %d dm/s, %d cm/s2, phase %u, flags 0x%02X\n", data->alt_cm, data->vel_dms,
+				data->accel_cms2, data->phase, data->flags);
+		break;
+	case LOGREC_TYPE_GNSS:
+		printf(" %ld, %ld (1e-7 deg), fix %u, %u satellites\n", data->latitude_e7, data->longitude_e7, data->fix,
+				data->satellites);
+		break;
+	case LOGREC_TYPE_EVENT:
+		printf(" phase %u -> %u, reason %u, %ld cm\n", data->from, data->to, data->reason, data->alt_cm);
+		break;
+	case LOGREC_TYPE_HEALTH:
+		for (uint8_t i = 0; i < LOGREC_COUNTER_COUNT; i++) {
+			printf(" %u", data->counters[i]);
+		}
+		printf("\n");
+		break;
+	case LOGREC_TYPE_CAPTURE:
+		for (uint8_t i = 0; i < LOGREC_PAYLOAD_SIZE; i++) {
+			printf(" %02X", data->capture[i]);
+		}
+		printf("\n");
+		break;
+	case LOGREC_TYPE_UART:
+		printf(" port %u, %u overruns, %u framing, %u noise, %u dma, %u parity\n", data->uart, data->overruns,
+				data->framing, data->noise, data->dma, data->parity);
+		break;
+	case LOGREC_TYPE_MACHLOCK:
+		printf(" lock %u (reason %u), %d dm/s, %ld cm\n", data->lock, data->reason, data->vel_dms, data->alt_cm);
+		break;
+	}
+}
@@ -0,0 +1,254 @@
+/*
+ * PACKET_tests.c
+ *
+ * Round trip of every packet type, saturation, COBS/CRC reference values and
+ * resynchronization of the receiver after corrupted or lost bytes.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/PACKET_tests.h"
+
+#include "GAUL_Flight/FLIGHT.h"
+#include "GAUL_System/Tests/TESTS.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *PACKET_TESTS_TYPE_NAMES[PACKET_TYPE_COUNT] = { "", "FLIGHT", "BARO", "GNSS", "HEALTH" };
+
+static uint32_t random_state;
+
+// Fields sent by each type
+static const TESTS_Field PACKET_TESTS_FLIGHT[] = {
+	TESTS_FIELD(PACKET_Data, alt_dm), TESTS_FIELD(PACKET_Data, vel_dms), TESTS_FIELD(PACKET_Data, phase),
+	TESTS_FIELD(PACKET_Data, fix),
+};
+static const TESTS_Field PACKET_TESTS_BARO[] = {
+	TESTS_FIELD(PACKET_Data, press_Pa), TESTS_FIELD(PACKET_Data, temp_dC),
+};
+static const TESTS_Field PACKET_TESTS_GNSS[] = {
+	TESTS_FIELD(PACKET_Data, north_m), TESTS_FIELD(PACKET_Data, east_m), TESTS_FIELD(PACKET_Data, fix),
+};
+static const TESTS_Field PACKET_TESTS_HEALTH[] = {
+	TESTS_FIELD(PACKET_Data, counters), TESTS_FIELD(PACKET_Data, load_permille),
+};
+static const TESTS_Fields PACKET_TESTS_FIELDS[PACKET_TYPE_COUNT] = {
+	[PACKET_TYPE_FLIGHT] = TESTS_FIELDS(PACKET_TESTS_FLIGHT),
+	[PACKET_TYPE_BARO] = TESTS_FIELDS(PACKET_TESTS_BARO),
+	[PACKET_TYPE_GNSS] = TESTS_FIELDS(PACKET_TESTS_GNSS),
+	[PACKET_TYPE_HEALTH] = TESTS_FIELDS(PACKET_TESTS_HEALTH),
+};
+
+static uint32_t PACKET_TESTS_Random() {
+	return TESTS_Random(&random_state);
+}
+
+/**
+ * @retval 1 the header and the fields of the type are equal (24 bits of time are sent)
+ */
+static uint8_t PACKET_TESTS_Equal(uint8_t type, const PACKET_Data *a, const PACKET_Data *b) {
+	if (type >= PACKET_TYPE_COUNT || a->sequence != b->sequence || (a->time_ms & 0xFFFFFF) != b->time_ms) {
+		return 0;
+	}
+	return TESTS_FieldsEqual(a, b, &PACKET_TESTS_FIELDS[type]);
+}
+
+/**
+ * Random values in the range of every field.
+ */
+static void PACKET_TESTS_RandomData(PACKET_Data *data) {
+	data->sequence = PACKET_TESTS_Random();
+	data->time_ms = PACKET_TESTS_Random();
+	data->alt_dm = (int32_t)(PACKET_TESTS_Random() % 1048576) - 524288;
+	data->vel_dms = (int16_t)(PACKET_TESTS_Random() % 16384) - 8192;
+	data->phase = PACKET_TESTS_Random() % FLIGHT_PHASE_COUNT;
+	data->fix = PACKET_TESTS_Random() & 1;
+	data->press_Pa = PACKET_TESTS_Random() % 131072;
+	data->temp_dC = (int16_t)(PACKET_TESTS_Random() % 2048) - 1024;
+	data->north_m = (int32_t)(PACKET_TESTS_Random() % 1048576) - 524288;
+	data->east_m = (int32_t)(PACKET_TESTS_Random() % 1048576) - 524288;
+	for (uint8_t i = 0; i < PACKET_COUNTER_COUNT; i++) {
+		data->counters[i] = PACKET_TESTS_Random();
+	}
+	data->load_permille = PACKET_TESTS_Random() % 1001;
+}
+
+void PACKET_TESTS_RoundTrip_LogSTLINK() {
+	uint8_t frame[PACKET_MAX_FRAME_SIZE];
+	uint8_t type;
+	PACKET_Data data;
+	PACKET_Data decoded;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: CRC-16/CCITT-FALSE check value and COBS reference encodings
+	const uint8_t crc_input[] = "123456789";
+	const uint8_t cobs_input[] = { 0x11, 0x22, 0x00, 0x33 };
+	const uint8_t cobs_expected[] = { 0x03, 0x11, 0x22, 0x02, 0x33 };
+	const uint8_t zeros[] = { 0x00, 0x00 };
+	const uint8_t zeros_expected[] = { 0x01, 0x01, 0x01 };
+	uint8_t cobs[8];
+	uint8_t decoded_bytes[8];
+	uint8_t ok = PACKET_CRC16(crc_input, 9) == 0x29B1;
+	ok &= PACKET_COBSEncode(cobs_input, 4, cobs) == 5 && memcmp(cobs, cobs_expected, 5) == 0;
+	ok &= PACKET_COBSDecode(cobs, 5, decoded_bytes) == 4 && memcmp(decoded_bytes, cobs_input, 4) == 0;
+	ok &= PACKET_COBSEncode(zeros, 2, cobs) == 3 && memcmp(cobs, zeros_expected, 3) == 0;
+	ok &= PACKET_COBSDecode(cobs, 3, decoded_bytes) == 2 && decoded_bytes[0] == 0 && decoded_bytes[1] == 0;
+	if (ok) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: 1000 random packets of every type, decoded values are equal and the frame
+	// contains no 0x00 before the delimiter
+	random_state = 1;
+	ok = 1;
+	for (uint16_t i = 0; i < 1000; i++) {
+		for (uint8_t t = PACKET_TYPE_FLIGHT; t < PACKET_TYPE_COUNT; t++) {
+			PACKET_TESTS_RandomData(&data);
+			uint16_t size = PACKET_Encode(t, &data, frame);
+			ok &= size == PACKET_FrameSize(t) && memchr(frame, 0x00, size - 1) == NULL && frame[size - 1] == 0x00;
+			ok &= PACKET_Decode(frame, size, &type, &decoded) == 0 && type == t;
+			ok &= PACKET_TESTS_Equal(t, &data, &decoded);
+		}
+	}
+	if (ok) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: values out of range are saturated
+	memset(&data, 0, sizeof(data));
+	data.alt_dm = 1000000;   // 100 km
+	data.vel_dms = -10000;   // -1000 m/s
+	data.phase = 9;
+	PACKET_Decode(frame, PACKET_Encode(PACKET_TYPE_FLIGHT, &data, frame), &type, &decoded);
+	ok = decoded.alt_dm == 524287 && decoded.vel_dms == -8192 && decoded.phase == 7;
+	data.press_Pa = 200000;
+	data.temp_dC = -2000;
+	PACKET_Decode(frame, PACKET_Encode(PACKET_TYPE_BARO, &data, frame), &type, &decoded);
+	ok &= decoded.press_Pa == 131071 && decoded.temp_dC == -1024;
+	if (ok) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: stream of 40 frames, one byte changed in frame 10 and one byte lost in
+	// frame 25, every other frame is received
+	uint8_t stream[40 * PACKET_MAX_FRAME_SIZE];
+	uint16_t stream_size = 0;
+	random_state = 2;
+	for (uint8_t i = 0; i < 40; i++) {
+		PACKET_TESTS_RandomData(&data);
+		data.sequence = i;
+		uint16_t size = PACKET_Encode(PACKET_TYPE_FLIGHT + i % 4, &data, stream + stream_size);
+		if (i == 10) {
+			stream[stream_size + 4] ^= 0x10;
+		}
+		if (i == 25) {
+			memmove(stream + stream_size + 3, stream + stream_size + 4, size - 4);
+			size--;
+		}
+		stream_size += size;
+	}
+	PACKET_Receiver receiver;
+	PACKET_ReceiverInit(&receiver);
+	uint8_t received = 0;
+	uint8_t errors = 0;
+	uint8_t sequence_ok = 1;
+	uint8_t expected_sequence = 0;
+	for (uint16_t i = 0; i < stream_size; i++) {
+		if (PACKET_Receive(&receiver, stream[i]) == 1) {
+			if (PACKET_Decode(receiver.frame, receiver.size, &type, &decoded) == 0) {
+				if (expected_sequence == 10 || expected_sequence == 25) {
+					expected_sequence++;
+				}
+				sequence_ok &= decoded.sequence == expected_sequence;
+				expected_sequence++;
+				received++;
+			} else {
+				errors++;
+			}
+		}
+	}
+	printf("%u frames received, %u rejected\n", received, errors);
+	if (received == 38 && errors == 2 && sequence_ok) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: unknown type, wrong version and truncated frames are rejected
+	ok = PACKET_Encode(0, &data, frame) == 0 && PACKET_Encode(PACKET_TYPE_COUNT, &data, frame) == 0;
+	uint8_t raw[PACKET_HEADER_SIZE + 4 + PACKET_CRC_SIZE] = { (PACKET_VERSION + 1) << 5 | PACKET_TYPE_BARO };
+	uint16_t crc = PACKET_CRC16(raw, sizeof(raw) - 2);
+	raw[sizeof(raw) - 2] = crc >> 8;
+	raw[sizeof(raw) - 1] = crc & 0xFF;
+	uint16_t size = PACKET_COBSEncode(raw, sizeof(raw), frame);
+	ok &= PACKET_Decode(frame, size, &type, &decoded) == -3;
+	size = PACKET_Encode(PACKET_TYPE_HEALTH, &data, frame);
+	ok &= PACKET_Decode(frame, size - 3, &type, &decoded) != 0;
+	if (ok) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+/**
+ * Size of every packet type and link usage at the telemetry rates of the flight phases.
+ */
+void PACKET_TESTS_Report_LogSTLINK() {
+	FLIGHT_Config config;
+	FLIGHT_DefaultConfig(&config);
+
+	printf("Type     payload  frame   bytes/s at 1 Hz / 10 Hz (link %u bytes/s)\n", PACKET_TESTS_LINK_BYTES_PER_S);
+	for (uint8_t t = PACKET_TYPE_FLIGHT; t < PACKET_TYPE_COUNT; t++) {
+		uint8_t size = PACKET_FrameSize(t);
+		printf("%-8s %7u %6u   %4u (%2u.%u%%) / %4u (%2u.%u%%)\n", PACKET_TESTS_TYPE_NAMES[t], PACKET_PayloadSize(t), size,
+				size, size * 100 / PACKET_TESTS_LINK_BYTES_PER_S, size * 1000 / PACKET_TESTS_LINK_BYTES_PER_S % 10,
+				size * 10, size * 1000 / PACKET_TESTS_LINK_BYTES_PER_S, size * 10000 / PACKET_TESTS_LINK_BYTES_PER_S % 10);
+	}
+
+	// FLIGHT packet at the telemetry rate of each phase
+	for (uint8_t phase = 0; phase < FLIGHT_PHASE_COUNT; phase++) {
+		uint16_t period_ms = config.rates[phase].telemetry_period_ms;
+		uint32_t bytes_per_s = (uint32_t)PACKET_FrameSize(PACKET_TYPE_FLIGHT) * 1000 / period_ms;
+		printf("%-8s FLIGHT every %4u ms: %4lu bytes/s, %3lu%% of the link\n", FLIGHT_PhaseName(phase), period_ms,
+				bytes_per_s, bytes_per_s * 100 / PACKET_TESTS_LINK_BYTES_PER_S);
+	}
+}
+
+void PACKET_TESTS_LogData(uint8_t type, const PACKET_Data *data) {
+	if (type == 0 || type >= PACKET_TYPE_COUNT) {
+		printf("Unknown packet type %u\n", type);
+		return;
+	}
+	printf("%s #%u %lu ms:", PACKET_TESTS_TYPE_NAMES[type], data->sequence, data->time_ms);
+	switch (type) {
+	case PACKET_TYPE_FLIGHT:
+		printf(" %ld dm, %d dm/s, phase %u, fix %u\n", data->alt_dm, data->vel_dms, data->phase, data->fix);
+		break;
+	case PACKET_TYPE_BARO:
+		printf(" %lu Pa, %d dC\n", data->press_Pa, data->temp_dC);
+		break;
+	case PACKET_TYPE_GNSS:
+		printf(" north %ld, east %ld m, fix %u\n", data->north_m, data->east_m, data->fix);
+		break;
+	case PACKET_TYPE_HEALTH:
+		for (uint8_t i = 0; i < PACKET_COUNTER_COUNT; i++) {
+			printf(" %u", data->counters[i]);
+		}
+		printf(", load %u permille\n", data->load_permille);
+		break;
+	}
+}
@@ -0,0 +1,58 @@
+/*
+ * PROFILER_tests.c
+ *
+ * Check the profiler statistics with known durations, then measure HAL_Delay
+ * with the cycle counter and dump the statistics over ITM.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/PROFILER_tests.h"
+
+#include <stdio.h>
+
+void PROFILER_TESTS_LogSTLINK() {
+	PROFILER_Init();
+
+	// Test 1: log2 buckets
+	if (PROFILER_Bucket(0) == 0 && PROFILER_Bucket(1) == 1 && PROFILER_Bucket(2) == 2 && PROFILER_Bucket(3) == 2
+			&& PROFILER_Bucket(4) == 3 && PROFILER_Bucket(72000) == 17 && PROFILER_Bucket((uint32_t)1 << 22) == 23
+			&& PROFILER_Bucket(UINT32_MAX) == PROFILER_HISTOGRAM_SIZE - 1) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: min/max/mean/histogram of known durations (probe overhead removed from all)
+	PROFILER_Reset();
+	PROFILER_Record(PROFILER_ZONE_FLIGHT_UPDATE, 1100);
+	PROFILER_Record(PROFILER_ZONE_FLIGHT_UPDATE, 1200);
+	PROFILER_Record(PROFILER_ZONE_FLIGHT_UPDATE, 1300);
+	const PROFILER_Zone *zone = PROFILER_GetZone(PROFILER_ZONE_FLIGHT_UPDATE);
+	uint32_t mean = PROFILER_Mean(PROFILER_ZONE_FLIGHT_UPDATE);
+	if (zone->count == 3 && zone->max_cycles - zone->min_cycles == 200 && mean - zone->min_cycles == 100
+			&& zone->histogram[PROFILER_Bucket(zone->min_cycles)] + zone->histogram[PROFILER_Bucket(zone->max_cycles)] >= 3) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: HAL_Delay(2) waits between 1 and 3 ms
+	PROFILER_Reset();
+	uint32_t cycles_per_ms = SystemCoreClock / 1000;
+	for (uint8_t i = 0; i < 10; i++) {
+		PROFILER_BEGIN(PROFILER_ZONE_FLIGHT_UPDATE);
+		HAL_Delay(2);
+		PROFILER_END(PROFILER_ZONE_FLIGHT_UPDATE);
+	}
+	printf("HAL_Delay(2): min %lu max %lu cycles\n", zone->min_cycles, zone->max_cycles);
+	if (zone->count == 10 && zone->min_cycles >= cycles_per_ms && zone->max_cycles <= 3 * cycles_per_ms + 1000) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	PROFILER_Dump(NULL);
+	PROFILER_Reset();
+}
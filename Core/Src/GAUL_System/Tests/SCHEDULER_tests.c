@@ -0,0 +1,173 @@
+/*
+ * SCHEDULER_tests.c
+ *
+ * Run the scheduler with a simulated clock: tasks advance the clock by their execution
+ * time and the idle function jumps to the next release. The schedule is deterministic,
+ * so run counts, overruns and utilisation can be checked exactly.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/SCHEDULER_tests.h"
+
+#include <stdio.h>
+
+#define SCHEDULER_TESTS_TASK_BARO      0
+#define SCHEDULER_TESTS_TASK_GNSS      1
+#define SCHEDULER_TESTS_TASK_TELEMETRY 2
+#define SCHEDULER_TESTS_TASK_LOG       3
+
+static uint32_t sim_us;
+static uint32_t telemetry_cost_us;
+
+static uint32_t SCHEDULER_TESTS_Clock(void) {
+	return sim_us;
+}
+
+static void SCHEDULER_TESTS_Idle(uint32_t sleep_us) {
+	sim_us += sleep_us;
+}
+
+// Execution times measured on target
+static void SCHEDULER_TESTS_Baro(void) {
+	sim_us += 300;
+}
+
+static void SCHEDULER_TESTS_GNSS(void) {
+	sim_us += 240;
+}
+
+static void SCHEDULER_TESTS_Telemetry(void) {
+	sim_us += telemetry_cost_us;
+}
+
+static void SCHEDULER_TESTS_Log(void) {
+	sim_us += 500;
+}
+
+static SCHEDULER_Task tasks[] = {
+	{ .name = "baro", .function = SCHEDULER_TESTS_Baro, .period_ms = 10, .offset_ms = 0, .deadline_ms = 5 },
+	{ .name = "gnss", .function = SCHEDULER_TESTS_GNSS, .period_ms = 200, .offset_ms = 3 },
+	{ .name = "telemetry", .function = SCHEDULER_TESTS_Telemetry, .period_ms = 100, .offset_ms = 7 },
+	{ .name = "log", .function = SCHEDULER_TESTS_Log, .period_ms = 10, .offset_ms = 5 },
+};
+
+static SCHEDULER scheduler;
+
+static void SCHEDULER_TESTS_Setup() {
+	sim_us = 0;
+	telemetry_cost_us = 1000;
+	tasks[SCHEDULER_TESTS_TASK_BARO].period_ms = 10;
+	tasks[SCHEDULER_TESTS_TASK_BARO].deadline_ms = 5;
+	tasks[SCHEDULER_TESTS_TASK_GNSS].period_ms = 200;
+	tasks[SCHEDULER_TESTS_TASK_GNSS].deadline_ms = 0;
+	SCHEDULER_Init(&scheduler, tasks, sizeof(tasks) / sizeof(tasks[0]), SCHEDULER_TESTS_Clock, SCHEDULER_TESTS_Idle);
+}
+
+static void SCHEDULER_TESTS_RunUntil(uint32_t time_us) {
+	while ((int32_t)(sim_us - time_us) < 0) { // Past the wrap of the clock
+		SCHEDULER_Dispatch(&scheduler);
+	}
+}
+
+void SCHEDULER_TESTS_Simulation_LogSTLINK() {
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: nominal schedule, exact run counts, no overrun
+	SCHEDULER_TESTS_Setup();
+	SCHEDULER_TESTS_RunUntil(SCHEDULER_TESTS_DURATION_US);
+	SCHEDULER_TESTS_LogStats(&scheduler);
+	uint16_t load = SCHEDULER_Load(&scheduler);
+	if (tasks[SCHEDULER_TESTS_TASK_BARO].runs == 1000 && tasks[SCHEDULER_TESTS_TASK_GNSS].runs == 50
+			&& tasks[SCHEDULER_TESTS_TASK_TELEMETRY].runs == 100 && tasks[SCHEDULER_TESTS_TASK_LOG].runs == 1000
+			&& tasks[SCHEDULER_TESTS_TASK_BARO].overruns == 0 && tasks[SCHEDULER_TESTS_TASK_LOG].overruns == 0
+			&& SCHEDULER_Utilisation(&scheduler) == 91 && load >= 85 && load <= 95) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: one 25 ms telemetry run, barometer overrun and missed releases are counted,
+	// and the barometer keeps its phase afterwards
+	SCHEDULER_TESTS_Setup();
+	SCHEDULER_TESTS_RunUntil(SCHEDULER_TESTS_DURATION_US / 2);
+	telemetry_cost_us = 25000;
+	SCHEDULER_TESTS_RunUntil(SCHEDULER_TESTS_DURATION_US / 2 + 100000);
+	telemetry_cost_us = 1000;
+	SCHEDULER_TESTS_RunUntil(SCHEDULER_TESTS_DURATION_US);
+	SCHEDULER_TESTS_LogStats(&scheduler);
+	if (tasks[SCHEDULER_TESTS_TASK_BARO].overruns == 1 && tasks[SCHEDULER_TESTS_TASK_BARO].skipped == 2
+			&& tasks[SCHEDULER_TESTS_TASK_BARO].release_us % 10000 == 0 && tasks[SCHEDULER_TESTS_TASK_TELEMETRY].wcet_us == 25000) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: period change from 100 ms (pad) to 10 ms (boost) applies immediately
+	SCHEDULER_TESTS_Setup();
+	SCHEDULER_SetPeriod(&scheduler, SCHEDULER_TESTS_TASK_BARO, 100);
+	SCHEDULER_TESTS_RunUntil(1000000);
+	uint32_t pad_runs = tasks[SCHEDULER_TESTS_TASK_BARO].runs;
+	SCHEDULER_SetPeriod(&scheduler, SCHEDULER_TESTS_TASK_BARO, 10);
+	int32_t next_us = (int32_t)(tasks[SCHEDULER_TESTS_TASK_BARO].release_us - sim_us); // <= 0: due now
+	SCHEDULER_TESTS_RunUntil(2000000);
+	uint32_t boost_runs = tasks[SCHEDULER_TESTS_TASK_BARO].runs - pad_runs;
+	printf("Pad %lu runs, boost %lu runs, next release %ld us after change\n", pad_runs, boost_runs, next_us);
+	if (pad_runs == 10 && boost_runs >= 99 && boost_runs <= 100 && next_us <= 10000
+			&& tasks[SCHEDULER_TESTS_TASK_BARO].overruns == 0) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: GNSS from 1000 ms (pad) to 100 ms (boost) just before its next release: the
+	// new release is already past, the task runs now and nothing is counted late
+	SCHEDULER_TESTS_Setup();
+	SCHEDULER_SetPeriod(&scheduler, SCHEDULER_TESTS_TASK_GNSS, 1000);
+	SCHEDULER_TESTS_RunUntil(1950000);
+	SCHEDULER_SetPeriod(&scheduler, SCHEDULER_TESTS_TASK_GNSS, 100);
+	uint32_t change_us = sim_us;
+	uint32_t gnss_runs = tasks[SCHEDULER_TESTS_TASK_GNSS].runs;
+	SCHEDULER_TESTS_RunUntil(2950000);
+	SCHEDULER_Task *gnss = &tasks[SCHEDULER_TESTS_TASK_GNSS];
+	printf("GNSS %lu runs after change, latency %lu us, %lu overruns, %lu skipped\n", gnss->runs - gnss_runs,
+			gnss->max_latency_us, gnss->overruns, gnss->skipped);
+	if (gnss->runs - gnss_runs == 10 && gnss->overruns == 0 && gnss->skipped == 0 && gnss->max_latency_us < 1000
+			&& (int32_t)(gnss->release_us - change_us) > 900000) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Test 5: 75 min on the pad (every task at 1000 ms), past the wrap of the microsecond
+	// clock (71.6 min): the load is still measured (2040 us of tasks per second)
+	SCHEDULER_TESTS_Setup();
+	for (uint8_t i = 0; i < scheduler.size; i++) {
+		SCHEDULER_SetPeriod(&scheduler, i, 1000);
+	}
+	for (uint8_t minute = 0; minute < 75; minute++) {
+		SCHEDULER_TESTS_RunUntil(sim_us + 60000000);
+	}
+	load = SCHEDULER_Load(&scheduler);
+	printf("Load %u permille after 75 min\n", load);
+	if (load == 2) {
+		printf("Test 5 passed\n");
+	} else {
+		printf("Test 5 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void SCHEDULER_TESTS_LogStats(SCHEDULER *scheduler) {
+	for (uint8_t i = 0; i < scheduler->size; i++) {
+		SCHEDULER_Task *task = &scheduler->tasks[i];
+		printf("%-10s %4lu ms: %6lu runs, wcet %5lu us, latency %5lu us, %lu overruns, %lu skipped\n", task->name,
+				task->period_ms, task->runs, task->wcet_us, task->max_latency_us, task->overruns, task->skipped);
+	}
+	printf("Utilisation %u permille (worst case), load %u permille (measured)\n", SCHEDULER_Utilisation(scheduler),
+			SCHEDULER_Load(scheduler));
+}
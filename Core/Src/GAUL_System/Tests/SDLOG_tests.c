@@ -0,0 +1,190 @@
+/*
+ * SDLOG_tests.c
+ *
+ * Log records at a fixed rate on the SD card model (SD_tests.c): the records are written
+ * every millisecond of simulated time and SDLOG_Process runs at the logging task period.
+ * The model checks the block headers and the sum of the record bytes it receives, and
+ * gives the SPI bus usage. A power loss is simulated by a new SD_Init without closing the
+ * log.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/SDLOG_tests.h"
+
+#include "GAUL_Drivers/Tests/SD_tests.h"
+
+#include <stdio.h>
+
+static uint32_t produced;        // Records given to SDLOG_Write
+static uint32_t produced_sum;    // Sum of the bytes of the records accepted
+static uint8_t record_counter;
+static uint32_t max_write_bytes;   // SPI bytes exchanged by a SDLOG_Write call
+static uint32_t max_process_bytes; // SPI bytes exchanged by a SDLOG_Process call
+
+static int8_t SDLOG_TESTS_Open(const SD_TESTS_Card *card) {
+	SD_TESTS_ModelReset(card);
+	produced = 0;
+	produced_sum = 0;
+	max_write_bytes = 0;
+	max_process_bytes = 0;
+	if (SD_TESTS_ModelInit() != 0) {
+		return -1;
+	}
+	return SDLOG_Init(0, SD_TESTS_MODEL_BLOCKS, SDLOG_TESTS_RESERVE_BLOCKS, SD_TESTS_ModelTimeUs() / 1000);
+}
+
+/**
+ * Log "rate_hz" records of "size" bytes per second for "duration_ms".
+ */
+static void SDLOG_TESTS_Log(uint16_t rate_hz, uint8_t size, uint32_t duration_ms) {
+	uint8_t record[64];
+	uint32_t due = 0;
+
+	for (uint32_t ms = 0; ms < duration_ms; ms++) {
+		for (due += rate_hz; due >= 1000; due -= 1000) {
+			uint32_t sum = 0;
+			for (uint8_t i = 0; i < size; i++) {
+				record[i] = record_counter++;
+				sum += record[i];
+			}
+			uint32_t before = SD_TESTS_ModelExchanges();
+			if (SDLOG_Write(record, size) == 0) {
+				produced_sum += sum;
+			}
+			produced++;
+			if (SD_TESTS_ModelExchanges() - before > max_write_bytes) {
+				max_write_bytes = SD_TESTS_ModelExchanges() - before;
+			}
+		}
+
+		if (ms % SDLOG_TESTS_TASK_PERIOD_MS == 0) {
+			uint32_t before = SD_TESTS_ModelExchanges();
+			SDLOG_Process();
+			if (SD_TESTS_ModelExchanges() - before > max_process_bytes) {
+				max_process_bytes = SD_TESTS_ModelExchanges() - before;
+			}
+		}
+		SD_TESTS_ModelAdvance(1000);
+	}
+}
+
+/**
+ * Seal the last block, let the task write everything and close the session.
+ */
+static int8_t SDLOG_TESTS_Close() {
+	const SDLOG_Stats *stats = SDLOG_GetStats();
+	SDLOG_Flush();
+	for (uint16_t i = 0;
+			i < 1000 && (stats->blocks_written < stats->blocks_sealed || SD_GetState() != SD_STATE_READY); i++) {
+		SD_TESTS_ModelAdvance(SDLOG_TESTS_TASK_PERIOD_MS * 1000);
+		SDLOG_Process();
+	}
+	return SDLOG_Close();
+}
+
+/**
+ * @retval 1 every record accepted reached the card in order, the writer never blocked
+ */
+static uint8_t SDLOG_TESTS_Check() {
+	const SDLOG_Stats *stats = SDLOG_GetStats();
+	const SD_TESTS_ModelStats *model = SD_TESTS_ModelGetStats();
+	return model->log_blocks == stats->blocks_sealed && model->bad_headers == 0 && model->out_of_order == 0
+			&& model->conflicts == 0 && model->payload_sum == produced_sum
+			&& stats->records + stats->dropped == produced && max_write_bytes == 0 && max_process_bytes <= 8;
+}
+
+static void SDLOG_TESTS_LogThroughput(uint32_t duration_ms) {
+	const SD_TESTS_ModelStats *model = SD_TESTS_ModelGetStats();
+	uint32_t bus_permille = (uint32_t)(model->bus_ns / duration_ms / 1000);
+	uint32_t busy_permille = model->busy_us / duration_ms;
+	printf("%lu bytes/s logged, SPI bus %lu permille, card busy %lu permille, ",
+			SDLOG_GetStats()->bytes * 1000 / duration_ms, bus_permille, busy_permille);
+	SDLOG_TESTS_LogStats();
+}
+
+void SDLOG_TESTS_Model_LogSTLINK() {
+	SD_TESTS_Card card = { 1, 1, 20, 1000, 0, 0 };
+	const SDLOG_Stats *stats = SDLOG_GetStats();
+	SDLOG_Session session;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: 500 records/s of 24 bytes for 8 s, 1 ms programming time: nothing dropped,
+	// the index holds the end of the session after SDLOG_Close
+	int8_t status = SDLOG_TESTS_Open(&card);
+	SDLOG_TESTS_Log(500, 24, 8000);
+	status |= SDLOG_TESTS_Close();
+	status |= SDLOG_ReadSession(0, 0, &session);
+	SDLOG_TESTS_LogThroughput(8000);
+	if (status == 0 && SDLOG_TESTS_Check() && stats->dropped == 0 && session.start_block == 1
+			&& session.end_block == 1 + stats->blocks_sealed
+			&& SD_TESTS_ModelGetStats()->pre_erase == SDLOG_TESTS_RESERVE_BLOCKS) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: 500 records/s of 12 bytes, the card is busy for 120 ms every 20 blocks: the
+	// second buffer absorbs it, nothing dropped
+	card.slow_busy_us = 120000;
+	card.slow_every = 20;
+	status = SDLOG_TESTS_Open(&card);
+	SDLOG_TESTS_Log(500, 12, 15000);
+	status |= SDLOG_TESTS_Close();
+	SDLOG_TESTS_LogThroughput(15000);
+	if (status == 0 && SDLOG_TESTS_Check() && stats->dropped == 0 && stats->max_waiting <= SDLOG_BUFFER_BLOCKS) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: 250 ms busy times (longest allowed) at 500 records/s of 24 bytes: records are
+	// dropped during the busy time, but the writer does not wait and the log continues
+	card.slow_busy_us = 250000;
+	status = SDLOG_TESTS_Open(&card);
+	SDLOG_TESTS_Log(500, 24, 8000);
+	status |= SDLOG_TESTS_Close();
+	SDLOG_TESTS_LogThroughput(8000);
+	if (status == 0 && SDLOG_TESTS_Check() && stats->dropped > 0 && stats->records > stats->dropped) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Test 4: power loss after 2 s, the next session finds the end of the first one with a
+	// few block reads and starts right after it
+	card.slow_every = 0;
+	status = SDLOG_TESTS_Open(&card);
+	SDLOG_TESTS_Log(500, 24, 2000);
+	uint32_t blocks = SD_TESTS_ModelGetStats()->log_blocks;
+	SD_TESTS_ModelPowerLoss();
+	status |= SD_TESTS_ModelInit();
+	uint32_t reads = SD_TESTS_ModelGetStats()->reads;
+	status |= SDLOG_Init(0, SD_TESTS_MODEL_BLOCKS, SDLOG_TESTS_RESERVE_BLOCKS, 0);
+	reads = SD_TESTS_ModelGetStats()->reads - reads;
+	uint8_t second = SDLOG_GetSession() == 1;
+	SDLOG_TESTS_Log(500, 24, 1000);
+	status |= SDLOG_TESTS_Close();
+	SDLOG_Session first;
+	status |= SDLOG_ReadSession(0, 0, &first);
+	status |= SDLOG_ReadSession(0, 1, &session);
+	printf("Power loss after %lu blocks, end found with %lu reads\n", blocks, reads);
+	if (status == 0 && second && first.end_block == first.start_block + blocks && session.start_block == first.end_block
+			&& session.end_block == session.start_block + stats->blocks_sealed && reads <= 10) {
+		printf("Test 4 passed\n");
+	} else {
+		printf("Test 4 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void SDLOG_TESTS_LogStats() {
+	const SDLOG_Stats *stats = SDLOG_GetStats();
+	printf("%lu records (%lu bytes), %lu dropped, %lu blocks sealed, %lu written, max %u waiting\n", stats->records,
+			stats->bytes, stats->dropped, stats->blocks_sealed, stats->blocks_written, stats->max_waiting);
+}
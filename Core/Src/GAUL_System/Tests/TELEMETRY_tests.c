@@ -0,0 +1,176 @@
+/*
+ * TELEMETRY_tests.c
+ *
+ * Simulate every flight phase for TELEMETRY_TESTS_PHASE_MS: the telemetry task runs at the
+ * FLIGHT default rate of the phase, sends the packets chosen by TELEMETRY_Next through the
+ * RFD900 queue, and a UART model sends 10 bits per byte at the simulated baud rate. The
+ * achieved rate of each packet type is measured per phase.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/TELEMETRY_tests.h"
+
+#include "GAUL_Drivers/RFD900.h"
+
+#include <stdio.h>
+
+static const char *TELEMETRY_TESTS_TYPE_NAMES[PACKET_TYPE_COUNT] = { "", "FLIGHT", "BARO", "GNSS", "HEALTH" };
+
+static UART_HandleTypeDef model_huart;
+
+// UART model (see RFD900_tests.c)
+static uint32_t model_baud;
+static uint32_t sim_us;
+static uint8_t line_busy;
+static uint32_t line_done_us;
+
+// Results of the last simulation, per phase
+static uint32_t rates_mHz[FLIGHT_PHASE_COUNT][PACKET_TYPE_COUNT];
+static uint32_t bytes_per_s[FLIGHT_PHASE_COUNT];
+static uint8_t max_pending;
+
+static int8_t TELEMETRY_TESTS_Transmit(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+	if (line_busy) {
+		return -1;
+	}
+	line_busy = 1;
+	line_done_us = sim_us + (uint32_t)size * 10 * 1000000 / model_baud;
+	return 0;
+}
+
+static void TELEMETRY_TESTS_AdvanceTo(uint32_t time_us) {
+	while (line_busy && line_done_us <= time_us) {
+		sim_us = line_done_us;
+		line_busy = 0;
+		RFD900_TxCallback(&model_huart);
+	}
+	sim_us = time_us;
+}
+
+/**
+ * Fly every phase with a telemetry configuration and a link speed.
+ */
+static void TELEMETRY_TESTS_Fly(const TELEMETRY_Config *config, uint32_t baud) {
+	FLIGHT_Config flight_config;
+	FLIGHT_DefaultConfig(&flight_config);
+
+	TELEMETRY telemetry;
+	PACKET_Data data = { 0 };
+	uint8_t frame[PACKET_MAX_FRAME_SIZE];
+
+	model_baud = baud;
+	sim_us = 0;
+	line_busy = 0;
+	max_pending = 0;
+	RFD900_Init(&model_huart, RFD900_DROP_OLDEST, TELEMETRY_TESTS_Transmit);
+	TELEMETRY_Init(&telemetry, config, 0);
+
+	uint32_t time_ms = 0;
+	for (uint8_t phase = 0; phase < FLIGHT_PHASE_COUNT; phase++) {
+		uint32_t phase_start_ms = time_ms;
+		uint16_t period_ms = flight_config.rates[phase].telemetry_period_ms;
+		TELEMETRY_SetPhase(&telemetry, phase, time_ms);
+
+		for (; time_ms < phase_start_ms + TELEMETRY_TESTS_PHASE_MS; time_ms += period_ms) {
+			TELEMETRY_TESTS_AdvanceTo(time_ms * 1000);
+			uint8_t type;
+			while ((type = TELEMETRY_Next(&telemetry, time_ms, RFD900_Pending())) != 0) {
+				data.time_ms = time_ms;
+				data.sequence++;
+				RFD900_Send(frame, PACKET_Encode(type, &data, frame));
+				if (RFD900_Pending() > max_pending) {
+					max_pending = RFD900_Pending();
+				}
+			}
+		}
+
+		for (uint8_t type = 1; type < PACKET_TYPE_COUNT; type++) {
+			rates_mHz[phase][type] = TELEMETRY_RatemHz(&telemetry, type, time_ms);
+		}
+		bytes_per_s[phase] = TELEMETRY_BytesPerSecond(&telemetry, time_ms);
+		TELEMETRY_TESTS_LogRates(&telemetry, time_ms);
+	}
+}
+
+/**
+ * @retval 1 rate within +/- 5% of the expected rate
+ */
+static uint8_t TELEMETRY_TESTS_Near(uint32_t rate_mHz, uint32_t expected_mHz) {
+	return rate_mHz * 100 >= expected_mHz * 95 && rate_mHz * 100 <= expected_mHz * 105;
+}
+
+void TELEMETRY_TESTS_Simulation_LogSTLINK() {
+	TELEMETRY_Config config;
+
+	// Debug timer High (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_SET);
+
+	// Test 1: default configuration at 9600 baud, every packet at its configured rate:
+	// position at 1 Hz on the pad and 5 Hz in descent, altitude at 10 Hz during ascent
+	printf("Default configuration, 9600 baud\n");
+	TELEMETRY_TESTS_Fly(NULL, 9600);
+	uint8_t ok = TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_PAD][PACKET_TYPE_GNSS], 1000)
+			&& TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_PAD][PACKET_TYPE_FLIGHT], 1000)
+			&& TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_BOOST][PACKET_TYPE_FLIGHT], 10000)
+			&& TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_COAST][PACKET_TYPE_FLIGHT], 10000)
+			&& TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_DROGUE][PACKET_TYPE_GNSS], 5000)
+			&& TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_MAIN][PACKET_TYPE_GNSS], 5000)
+			&& TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_BOOST][PACKET_TYPE_HEALTH], 100)
+			&& RFD900_GetStats()->dropped_oldest == 0;
+	for (uint8_t phase = 0; phase < FLIGHT_PHASE_COUNT; phase++) {
+		ok &= bytes_per_s[phase] <= TELEMETRY_DEFAULT_MAX_BYTES_PER_S;
+	}
+	if (ok) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: ceiling of 150 bytes/s, the altitude keeps 10 Hz in boost (140 bytes/s) and the
+	// lower priority packets get what is left
+	printf("150 bytes/s ceiling, 9600 baud\n");
+	TELEMETRY_DefaultConfig(&config);
+	config.max_bytes_per_s = 150;
+	TELEMETRY_TESTS_Fly(&config, 9600);
+	ok = TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_BOOST][PACKET_TYPE_FLIGHT], 10000)
+			&& rates_mHz[FLIGHT_PHASE_BOOST][PACKET_TYPE_GNSS] < 1000
+			&& TELEMETRY_TESTS_Near(rates_mHz[FLIGHT_PHASE_DROGUE][PACKET_TYPE_GNSS], 5000);
+	for (uint8_t phase = 0; phase < FLIGHT_PHASE_COUNT; phase++) {
+		// Budget plus the initial burst spread over the phase
+		ok &= bytes_per_s[phase] <= 150 + TELEMETRY_DEFAULT_BURST_BYTES * 1000 / TELEMETRY_TESTS_PHASE_MS;
+	}
+	if (ok) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: link at 1200 baud (120 bytes/s) but ceiling left at 720 bytes/s, the radio queue
+	// occupancy limits the packets: no frame dropped by the radio queue, and the altitude
+	// uses most of the link in boost
+	printf("Default configuration, 1200 baud\n");
+	TELEMETRY_TESTS_Fly(NULL, 1200);
+	ok = RFD900_GetStats()->dropped_oldest == 0 && max_pending <= TELEMETRY_DEFAULT_QUEUE_FULL
+			&& rates_mHz[FLIGHT_PHASE_BOOST][PACKET_TYPE_FLIGHT] >= 6000;
+	printf("Radio queue: %u waiting at most, %lu dropped\n", max_pending, RFD900_GetStats()->dropped_oldest);
+	if (ok) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Debug timer Low (to measure execution time with a digital analyzer)
+	HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
+}
+
+void TELEMETRY_TESTS_LogRates(const TELEMETRY *telemetry, uint32_t time_ms) {
+	printf("%-7s", FLIGHT_PhaseName(telemetry->phase));
+	for (uint8_t type = 1; type < PACKET_TYPE_COUNT; type++) {
+		uint32_t rate = TELEMETRY_RatemHz(telemetry, type, time_ms);
+		printf(" %s %2lu.%02lu Hz (%lu deferred)", TELEMETRY_TESTS_TYPE_NAMES[type], rate / 1000, rate % 1000 / 10,
+				telemetry->types[type].deferred);
+	}
+	printf(", %lu bytes/s\n", TELEMETRY_BytesPerSecond(telemetry, time_ms));
+}
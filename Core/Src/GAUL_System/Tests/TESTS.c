@@ -0,0 +1,51 @@
+/*
+ * TESTS.c
+ *
+ * Helpers shared by the tests (pseudo random generator, field comparison).
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/TESTS.h"
+
+#include <string.h>
+
+/**
+ * xorshift32 pseudo random generator.
+ *
+ * @param state: generator state, not 0 (0 stays 0).
+ *
+ * @return next value, also the new state
+ */
+uint32_t TESTS_Random(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/**
+ * Compare the fields of a table in two structures of the same type.
+ *
+ * @param a: first structure.
+ * @param b: second structure.
+ * @param fields: fields to compare (TESTS_FIELD), a NULL table is never equal.
+ *
+ * @retval 1 every field is equal
+ * @retval 0 a field differs
+ */
+uint8_t TESTS_FieldsEqual(const void *a, const void *b, const TESTS_Fields *fields) {
+	if (fields->fields == NULL) {
+		return 0;
+	}
+	for (uint8_t i = 0; i < fields->count; i++) {
+		const TESTS_Field *field = &fields->fields[i];
+		if (memcmp((const uint8_t *)a + field->offset, (const uint8_t *)b + field->offset, field->size) != 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
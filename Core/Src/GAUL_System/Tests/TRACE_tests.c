@@ -0,0 +1,119 @@
+/*
+ * TRACE_tests.c
+ *
+ * Check the trace ring with a captured output instead of ITM: record format, order,
+ * dropped records and busy output. Then compare the cost of TRACE and printf.
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: mathouqc
+ */
+
+#include "GAUL_System/Tests/TRACE_tests.h"
+
+#include "GAUL_System/PROFILER.h"
+
+#include <stdio.h>
+
+static uint32_t capture[TRACE_TESTS_CAPTURE_WORDS];
+static uint16_t capture_size;
+static uint8_t busy_toggle;
+
+static int8_t TRACE_TESTS_Capture(uint32_t word) {
+	if (capture_size >= TRACE_TESTS_CAPTURE_WORDS) {
+		return -1; // Busy
+	}
+	capture[capture_size++] = word;
+	return 0;
+}
+
+// Busy every other word, like a full ITM FIFO
+static int8_t TRACE_TESTS_CaptureBusy(uint32_t word) {
+	busy_toggle = !busy_toggle;
+	if (busy_toggle) {
+		return -1; // Busy
+	}
+	return TRACE_TESTS_Capture(word);
+}
+
+static uint32_t TRACE_TESTS_Header(uint16_t id, uint8_t argc) {
+	return ((uint32_t)TRACE_SYNC << 24) | ((uint32_t)argc << 16) | id;
+}
+
+void TRACE_TESTS_LogSTLINK() {
+	// Test 1: record format and order
+	TRACE_Init(TRACE_TESTS_Capture);
+	capture_size = 0;
+	TRACE0(TRACE_ID_DROPPED);
+	TRACE(TRACE_ID_TELEMETRY, 2, TRACE_Float(1.5f), 1);
+	TRACE(TRACE_ID_FLIGHT_TRANSITION, 1000, 0, 1, 1, TRACE_Float(-2.0f));
+	TRACE_Flush(UINT16_MAX);
+	if (capture_size == 2 + 5 + 7 && capture[0] == TRACE_TESTS_Header(TRACE_ID_DROPPED, 0)
+			&& capture[2] == TRACE_TESTS_Header(TRACE_ID_TELEMETRY, 3) && capture[4] == 2 && capture[5] == 0x3FC00000
+			&& capture[6] == 1 && capture[7] == TRACE_TESTS_Header(TRACE_ID_FLIGHT_TRANSITION, 5)
+			&& capture[9] == 1000 && capture[13] == 0xC0000000) {
+		printf("Test 1 passed\n");
+	} else {
+		printf("Test 1 failed\n");
+	}
+
+	// Test 2: ring full, records dropped then reported before the next record
+	TRACE_Init(TRACE_TESTS_Capture);
+	capture_size = 0;
+	uint16_t written = 0;
+	for (uint16_t i = 0; i < TRACE_BUFFER_WORDS; i++) {
+		TRACE(TRACE_ID_TELEMETRY, i, 0, 0); // 5 words
+		written++;
+	}
+	uint32_t dropped = TRACE_GetStats()->dropped;
+	TRACE_Flush(UINT16_MAX);
+	TRACE(TRACE_ID_TELEMETRY, 0xFFFF, 0, 0);
+	TRACE_Flush(UINT16_MAX);
+	uint16_t kept = TRACE_BUFFER_WORDS / 5;
+	uint16_t gap = kept * 5;
+	printf("%lu records, %lu dropped, max used %u words\n", TRACE_GetStats()->records, dropped, TRACE_GetStats()->max_used);
+	if (dropped == written - kept && capture[gap] == TRACE_TESTS_Header(TRACE_ID_DROPPED, 1)
+			&& capture[gap + 2] == dropped && capture[gap + 3] == TRACE_TESTS_Header(TRACE_ID_TELEMETRY, 3)
+			&& capture[gap + 5] == 0xFFFF && capture[(kept - 1) * 5 + 2] == kept - 1u) {
+		printf("Test 2 passed\n");
+	} else {
+		printf("Test 2 failed\n");
+	}
+
+	// Test 3: busy output, nothing lost and order kept
+	TRACE_Init(TRACE_TESTS_CaptureBusy);
+	capture_size = 0;
+	busy_toggle = 0;
+	for (uint16_t i = 0; i < 50; i++) {
+		TRACE(TRACE_ID_TELEMETRY, i, 0, 0);
+	}
+	uint16_t flushes = 0;
+	while (capture_size < 50 * 5 && flushes < 1000) {
+		TRACE_Flush(8);
+		flushes++;
+	}
+	uint8_t ordered = 1;
+	for (uint16_t i = 0; i < 50; i++) {
+		if (capture[i * 5 + 2] != i) {
+			ordered = 0;
+		}
+	}
+	if (capture_size == 50 * 5 && ordered) {
+		printf("Test 3 passed\n");
+	} else {
+		printf("Test 3 failed\n");
+	}
+
+	// Cost of a trace record compared to printf (logged)
+	char text[48];
+	PROFILER_Init();
+	TRACE_Init(TRACE_TESTS_Capture);
+	uint32_t start = DWT->CYCCNT;
+	TRACE(TRACE_ID_TELEMETRY, 2, TRACE_Float(1234.5f), 1);
+	uint32_t trace_cycles = DWT->CYCCNT - start;
+	start = DWT->CYCCNT;
+	snprintf(text, sizeof(text), "phase %lu %.1f m fix %lu\r\n", 2ul, 1234.5f, 1ul);
+	uint32_t format_cycles = DWT->CYCCNT - start;
+	printf("TRACE %lu cycles, snprintf %lu cycles (before sending)\n", trace_cycles, format_cycles);
+
+	TRACE_Init(NULL);
+}
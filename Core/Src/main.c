@@ -22,13 +22,58 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "stdio.h"
+#include "string.h"
 
 #include "GAUL_Drivers/BMP280.h"
+#include "GAUL_Drivers/DMASHARE.h"
+#include "GAUL_Drivers/EPO.h"
+#include "GAUL_Drivers/GNSSAID.h"
+#include "GAUL_Drivers/ICM20602.h"
 #include "GAUL_Drivers/L76LM33.h"
+#include "GAUL_Drivers/RFD900.h"
+#include "GAUL_Drivers/SD.h"
+#include "GAUL_Drivers/SPIBUS.h"
+#include "GAUL_Drivers/UARTERR.h"
+
+#include "GAUL_Flight/FLIGHT.h"
+#include "GAUL_Flight/FUSION.h"
+#include "GAUL_Flight/TRACK.h"
+
+#include "GAUL_System/BLACKBOX.h"
+#include "GAUL_System/LOGREC.h"
+#include "GAUL_System/PACKET.h"
+#include "GAUL_System/PROFILER.h"
+#include "GAUL_System/SCHEDULER.h"
+#include "GAUL_System/SDLOG.h"
+#include "GAUL_System/TELEMETRY.h"
+#include "GAUL_System/TRACE.h"
 
 #include "GAUL_Drivers/Tests/BMP280_tests.h"
+#include "GAUL_Drivers/Tests/EPO_tests.h"
+#include "GAUL_Drivers/Tests/GNSSAID_tests.h"
+#include "GAUL_Drivers/Tests/ICM20602_tests.h"
 #include "GAUL_Drivers/Tests/NMEA_tests.h"
 #include "GAUL_Drivers/Tests/L76LM33_tests.h"
+#include "GAUL_Drivers/Tests/RFD900_tests.h"
+#include "GAUL_Drivers/Tests/SD_tests.h"
+#include "GAUL_Drivers/Tests/SPIBUS_tests.h"
+#include "GAUL_Drivers/Tests/UARTERR_tests.h"
+#include "GAUL_Flight/Tests/APOGEE_tests.h"
+#include "GAUL_Flight/Tests/FLIGHT_tests.h"
+#include "GAUL_Flight/Tests/FUSION_tests.h"
+#include "GAUL_Flight/Tests/GEO_tests.h"
+#include "GAUL_Flight/Tests/LAUNCH_tests.h"
+#include "GAUL_Flight/Tests/MACHLOCK_tests.h"
+#include "GAUL_Flight/Tests/THRESHOLD_tests.h"
+#include "GAUL_Flight/Tests/TRACK_tests.h"
+#include "GAUL_System/Tests/BLACKBOX_tests.h"
+#include "GAUL_System/Tests/LOGREC_tests.h"
+#include "GAUL_System/Tests/PACKET_tests.h"
+#include "GAUL_System/Tests/PROFILER_tests.h"
+#include "GAUL_System/Tests/SCHEDULER_tests.h"
+#include "GAUL_System/Tests/SDLOG_tests.h"
+#include "GAUL_System/Tests/TELEMETRY_tests.h"
+#include "GAUL_System/Tests/TRACE_tests.h"
 
 /* USER CODE END Includes */
 
@@ -39,6 +84,20 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+// Index of the tasks in the scheduler table (table order is priority)
+#define TASK_ID_BARO      0
+#define TASK_ID_IMU       1
+#define TASK_ID_GNSS      2
+#define TASK_ID_LOG       3
+#define TASK_ID_TELEMETRY 4
+#define TASK_ID_EPO       5
+#define TASK_ID_TRACE     6
+
+#define TRACE_FLUSH_WORDS 64 // Words sent to the ITM per trace task run
+#define LOG_CAPTURE_CHUNKS 8 // Capture records per log task run (full ring written in ~0.5 s at 10 ms)
+
+#define IMU_VERTICAL_AXIS 2  // Accelerometer axis along the rocket (Z, up on the pad)
+#define IMU_TIMEOUT_MS 50 // Latest IMU sample older than this: no accelerometer for the flight state machine
 
 /* USER CODE END PD */
 
@@ -52,25 +111,438 @@ SPI_HandleTypeDef hspi2;
 
 UART_HandleTypeDef huart1;
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_spi2_tx;
+DMA_HandleTypeDef hdma_usart1_tx;
 
 /* USER CODE BEGIN PV */
+DMA_HandleTypeDef hdma_spi2_rx; // DMA1 Channel4, shared with USART1_TX (DMASHARE)
+
 BMP280 bmp_data;
 L76LM33 L76_data;
+FLIGHT flight;
+SCHEDULER scheduler;
+
+// IMU, FIFO drained every 10 ms (about 10 samples per burst read)
+ICM20602_Sample imu_samples[ICM20602_MAX_BURST];
+ICM20602_Sample imu_data;      // Latest sample
+uint8_t imu_valid = 0;         // 1: imu_data was read from the ICM20602 (not the zero initial value)
+uint32_t imu_time_ms;          // HAL tick of imu_data (the us time base wraps)
+uint16_t imu_errors = 0;
+FUSION fusion;                 // Altitude and velocity from the accelerometer and the barometer
+TRACK track;                   // GNSS position between the fixes, relative to the pad
+
+// Telemetry
+TELEMETRY telemetry;
+uint8_t telemetry_sequence = 0;
+uint16_t baro_errors = 0;
+uint16_t gnss_errors = 0;
+volatile int8_t gnss_navmode = 1; // Aviation mode, 1: pending, then the PMTK886 result
+
+// Flight log on the SD card
+LOGREC flight_log;
+uint8_t log_gnss = 0;          // 1: new GNSS position to log
+uint32_t log_health_ms = 0;    // Time of the last HEALTH record
+uint32_t log_uart_errors[UARTERR_PORTS]; // UART errors in the last UART records
+BLACKBOX blackbox;             // Full-rate samples before launch and apogee
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_SPI2_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_USART2_UART_Init(void);
 /* USER CODE BEGIN PFP */
+static void TASK_Baro(void);
+static void TASK_IMU(void);
+static void TASK_GNSS(void);
+static void TASK_Log(void);
+static void TASK_LogUart(LOGREC_Data *data);
+static void TASK_Telemetry(void);
+static void TASK_EPO(void);
+static void TASK_Trace(void);
+static void TASK_SetRates(void);
+static void TASK_Transition(void);
+static void TASK_MachLock(void);
+static void TASK_FillPacket(PACKET_Data *data, uint32_t time_ms);
+static float TASK_GetAltitude(void);
+static void GNSS_NavModeDone(uint16_t command, int8_t result);
+static void GNSS_GetPosition(uint32_t time_ms, TRACK_Estimate *estimate);
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
+// Periods are set from the flight phase rates by TASK_SetRates
+SCHEDULER_Task tasks[] = {
+  { .name = "baro", .function = TASK_Baro, .period_ms = 100, .offset_ms = 0 },
+  { .name = "imu", .function = TASK_IMU, .period_ms = 10, .offset_ms = 5 },
+  { .name = "gnss", .function = TASK_GNSS, .period_ms = 1000, .offset_ms = 3 },
+  { .name = "log", .function = TASK_Log, .period_ms = 1000, .offset_ms = 1 },
+  { .name = "telemetry", .function = TASK_Telemetry, .period_ms = 1000, .offset_ms = 7 },
+  { .name = "epo", .function = TASK_EPO, .period_ms = 50, .offset_ms = 4 },
+  { .name = "trace", .function = TASK_Trace, .period_ms = 10, .offset_ms = 9 },
+};
+
+/**
+ * Barometer and flight state machine.
+ */
+static void TASK_Baro(void) {
+  PROFILER_BEGIN(PROFILER_ZONE_BMP280_READ);
+  int8_t status = BMP280_ReadMeasurement(&bmp_data); // No pow() here, see TASK_GetAltitude
+  PROFILER_END(PROFILER_ZONE_BMP280_READ);
+  if (status != 0) {
+    baro_errors++;
+    return;
+  }
+
+  uint32_t time_ms;
+  uint32_t time_us = SCHEDULER_Time(&time_ms);
+  BLACKBOX_AddBaro(&blackbox, time_ms, bmp_data.press_Pa_Q8, (int16_t)(bmp_data.temp_C * 100));
+  int32_t alt_mm = BMP280_LinearAltitudeMm(&bmp_data);
+
+  FLIGHT_Measurement measurement = {
+    .time_ms = time_ms,
+    .alt_m = (float)alt_mm * 0.001f,
+    .press_Pa_Q8 = bmp_data.press_Pa_Q8,
+    .accel_mps2 = (float)imu_data.accel[IMU_VERTICAL_AXIS] * (FUSION_GRAVITY_MMS2 / 1000.0f) / ICM20602_ACCEL_LSB_PER_G,
+    .has_accel = imu_valid && time_ms - imu_time_ms < IMU_TIMEOUT_MS,
+  };
+  PROFILER_BEGIN(PROFILER_ZONE_FLIGHT_UPDATE);
+  int8_t transition = FLIGHT_Update(&flight, &measurement);
+  PROFILER_END(PROFILER_ZONE_FLIGHT_UPDATE);
+  // Applied at its time, even if the IMU burst covering it is not collected yet
+  FUSION_UpdateBaro(&fusion, alt_mm, time_us, flight.baro_trusted);
+  if (transition == 1) {
+    TASK_Transition();
+  }
+  if (flight.lock.transition != MACHLOCK_TRANSITION_NONE) {
+    TASK_MachLock();
+  }
+}
+
+/**
+ * Flight phase changed (flight.event): trace, log, pre-trigger capture and new task rates.
+ * Launch is back-dated, the capture keeps the samples before lift-off.
+ * The ODB1 has no pyro output: the APOGEE and MAIN events only record when the drogue
+ * and main would be deployed, the charges are fired by the recovery altimeters.
+ */
+static void TASK_Transition(void) {
+  TRACE(TRACE_ID_FLIGHT_TRANSITION, flight.event.time_ms, flight.event.from, flight.event.to, flight.event.reason,
+      TRACE_Float(flight.event.alt_m));
+  LOGREC_Data event = {
+    .time_ms = flight.event.time_ms,
+    .from = flight.event.from,
+    .to = flight.event.to,
+    .reason = flight.event.reason,
+    .alt_cm = (int32_t)(flight.event.alt_m * 100),
+  };
+  LOGREC_Write(&flight_log, LOGREC_TYPE_EVENT, &event);
+  if (flight.event.to == FLIGHT_PHASE_BOOST || flight.event.to == FLIGHT_PHASE_APOGEE) {
+    BLACKBOX_Trigger(&blackbox, flight.event.time_ms, flight.event.to);
+  }
+  if (flight.event.from == FLIGHT_PHASE_PAD) {
+    EPO_Abort(); // No more PMTK721 on USART2 once in flight
+  }
+  SDLOG_Flush(); // Phase change on the card at the next log run
+  TASK_SetRates();
+}
+
+/**
+ * Mach lock entered or left (flight.lock): trace and log, the barometer samples in between
+ * were not used by the apogee detector.
+ */
+static void TASK_MachLock(void) {
+  const MACHLOCK *lock = &flight.lock;
+  uint32_t time_ms = lock->transition == MACHLOCK_TRANSITION_ENTER ? lock->enter_time_ms : lock->exit_time_ms;
+
+  TRACE(TRACE_ID_MACHLOCK, time_ms, lock->transition, lock->reason, TRACE_Float(lock->velocity_mps),
+      TRACE_Float(flight.alt_m));
+  LOGREC_Data event = {
+    .time_ms = time_ms,
+    .lock = lock->transition,
+    .reason = lock->reason,
+    .vel_dms = (int16_t)(lock->velocity_mps * 10),
+    .alt_cm = (int32_t)(flight.alt_m * 100),
+  };
+  LOGREC_Write(&flight_log, LOGREC_TYPE_MACHLOCK, &event);
+}
+
+/**
+ * IMU: collect the burst read started at the previous run (DMA complete, the bus was
+ * released at the end of the transfer), then queue the next one. The burst has the
+ * highest priority on SPI2, it goes before an SD block waiting for the bus.
+ */
+static void TASK_IMU(void) {
+  int16_t count = ICM20602_Collect(imu_samples);
+  uint32_t now_ms;
+  uint32_t now_us = SCHEDULER_Time(&now_ms);
+  if (count > 0) {
+    imu_data = imu_samples[count - 1];
+    imu_time_ms = now_ms - (now_us - imu_data.time_us) / 1000;
+    imu_valid = 1;
+  }
+  PROFILER_BEGIN(PROFILER_ZONE_FUSION_PREDICT);
+  for (int16_t i = 0; i < count; i++) {
+    int32_t accel_mms2 = (int32_t)imu_samples[i].accel[IMU_VERTICAL_AXIS] * FUSION_GRAVITY_MMS2 / ICM20602_ACCEL_LSB_PER_G;
+    FUSION_Predict(&fusion, accel_mms2, imu_samples[i].time_us);
+    // Launch on every sample, lift-off back-dated within the burst
+    uint32_t sample_ms = now_ms - (now_us - imu_samples[i].time_us) / 1000; // Microseconds wrap, not ms
+    if (FLIGHT_UpdateAccel(&flight, accel_mms2, imu_samples[i].time_us, sample_ms) == 1) {
+      TASK_Transition();
+    }
+    if (flight.lock.transition != MACHLOCK_TRANSITION_NONE) {
+      TASK_MachLock(); // Entered at lift-off
+    }
+  }
+  PROFILER_END(PROFILER_ZONE_FUSION_PREDICT);
+
+  PROFILER_BEGIN(PROFILER_ZONE_ICM20602_READ);
+  int8_t status = ICM20602_StartRead(SCHEDULER_TimeUs());
+  PROFILER_END(PROFILER_ZONE_ICM20602_READ);
+  if (status == -1) {
+    imu_errors++;
+  }
+}
+
+/**
+ * GNSS read and parse.
+ */
+static void TASK_GNSS(void) {
+  PROFILER_BEGIN(PROFILER_ZONE_L76LM33_READ);
+  int8_t status = L76LM33_Read(&L76_data);
+  PROFILER_END(PROFILER_ZONE_L76LM33_READ);
+  if (status == -1) {
+    gnss_errors++;
+  }
+  if (status == 0) {
+    // Time to first fix, last fix kept in flash: erase stall (20 to 40 ms) only after the
+    // landing, on the pad programmed only while no launch detection is in progress
+    const GNSSAID_Stats *aid = GNSSAID_GetStats();
+    uint8_t first = aid->ttff_ms == 0;
+    uint8_t save = GNSSAID_SAVE_NONE;
+    if (flight.phase == FLIGHT_PHASE_LANDED) {
+      save = GNSSAID_SAVE_ANY;
+    } else if (flight.phase == FLIGHT_PHASE_PAD && LAUNCH_IsIdle(&flight.launch)) {
+      save = GNSSAID_SAVE_NO_ERASE;
+    }
+    GNSSAID_Update(&L76_data, save);
+    if (first && aid->ttff_ms != 0) {
+      TRACE(TRACE_ID_GNSS_FIRST_FIX, aid->ttff_ms, aid->aiding, aid->epo, aid->previous.ttff_ms, aid->previous.aiding);
+    }
+  }
+  if (status == 0 && L76_data.fix) {
+    TRACK_Fix fix = {
+      .time_ms = L76_data.fix_ms,
+      .latitude_e7 = L76_data.latitude_e7,
+      .longitude_e7 = L76_data.longitude_e7,
+      .speed_cms = (int32_t)(L76_data.speed_mps * 100),
+      .course_cdeg = (int32_t)(L76_data.course_deg * 100),
+      .altitude = L76_data.altitude_fix,
+      .altitude_ms = L76_data.altitude_ms,
+      .altitude_cm = (int32_t)(L76_data.altitude_m * 100),
+    };
+    if (flight.phase == FLIGHT_PHASE_PAD) {
+      TRACK_SetPad(&track, &fix); // Last fix on the pad, GNSS packets are relative to it
+    }
+    TRACK_Update(&track, &fix, HAL_GetTick());
+    log_gnss = 1;
+    BLACKBOX_AddGNSS(&blackbox, L76_data.fix_ms, L76_data.latitude_e7, L76_data.longitude_e7, L76_data.fix);
+  }
+}
+
+/**
+ * GNSS position at "time_ms" (HAL tick of the barometer sample), extrapolated from the last
+ * fix and blended into the next one (TRACK). Last fix as is when there is no fix.
+ */
+static void GNSS_GetPosition(uint32_t time_ms, TRACK_Estimate *estimate) {
+  if (TRACK_Predict(&track, time_ms, estimate) == -1) {
+    *estimate = (TRACK_Estimate) {
+      .latitude_e7 = L76_data.latitude_e7,
+      .longitude_e7 = L76_data.longitude_e7,
+    };
+  }
+}
+
+/**
+ * End of the aviation mode command (USART2 interrupt, during the barometer calibration).
+ */
+static void GNSS_NavModeDone(uint16_t command, int8_t result) {
+  (void)command;
+  gnss_navmode = result;
+}
+
+/**
+ * Flight log: FLIGHT and BARO records (GNSS after a new fix, extrapolated to the record
+ * time, HEALTH every second with UART after new UART errors, then the pre-trigger capture
+ * after launch and apogee) copied in the SD card block buffer,
+ * the card is written with DMA without waiting (block queued at low priority on SPI2,
+ * 0.3 ms at 18 MHz).
+ */
+static void TASK_Log(void) {
+  PACKET_Data packet;
+  LOGREC_Data data;
+  FUSION_State fusion_state;
+  TRACK_Estimate gnss;
+
+  if (!SDLOG_IsOpen()) {
+    return;
+  }
+
+  uint32_t time_ms = HAL_GetTick();
+  FUSION_GetState(&fusion, &fusion_state);
+  GNSS_GetPosition(time_ms, &gnss);
+  data = (LOGREC_Data) {
+    .time_ms = time_ms,
+    .alt_cm = (int32_t)(TASK_GetAltitude() * 100),
+    .vel_dms = (int16_t)(flight.apogee.velocity_mps * 10),
+    .accel_cms2 = (int16_t)(fusion_state.accel_mms2 / 10),
+    .phase = flight.phase,
+    .flags = L76_data.fix ? LOGREC_FLAG_FIX : 0,
+    .press_Pa_Q8 = bmp_data.press_Pa_Q8,
+    .temp_cC = (int16_t)(bmp_data.temp_C * 100),
+    .latitude_e7 = gnss.latitude_e7,
+    .longitude_e7 = gnss.longitude_e7,
+    .fix = L76_data.fix,
+  };
+  LOGREC_Write(&flight_log, LOGREC_TYPE_FLIGHT, &data);
+  LOGREC_Write(&flight_log, LOGREC_TYPE_BARO, &data);
+  if (log_gnss) {
+    log_gnss = 0;
+    LOGREC_Write(&flight_log, LOGREC_TYPE_GNSS, &data);
+  }
+  if (time_ms - log_health_ms >= 1000) {
+    log_health_ms = time_ms;
+    TASK_FillPacket(&packet, time_ms);
+    memcpy(data.counters, packet.counters, sizeof(data.counters));
+    LOGREC_Write(&flight_log, LOGREC_TYPE_HEALTH, &data);
+    TASK_LogUart(&data);
+  }
+  BLACKBOX_Flush(&blackbox, &flight_log, time_ms, LOG_CAPTURE_CHUNKS);
+
+  SDLOG_Process();
+}
+
+/**
+ * Flight log: UART record of each port with new errors (UARTERR counters).
+ */
+static void TASK_LogUart(LOGREC_Data *data) {
+  const UARTERR_Stats *stats = UARTERR_GetStats();
+
+  for (uint8_t port = 0; port < UARTERR_PORTS; port++) {
+    uint32_t errors = UARTERR_Errors(port);
+    if (errors == log_uart_errors[port]) {
+      continue;
+    }
+    log_uart_errors[port] = errors;
+    data->uart = port;
+    data->overruns = stats->overruns[port];
+    data->framing = stats->framing[port];
+    data->noise = stats->noise[port];
+    data->dma = stats->dma[port];
+    data->parity = stats->parity[port];
+    LOGREC_Write(&flight_log, LOGREC_TYPE_UART, data);
+  }
+}
+
+/**
+ * Telemetry.
+ */
+static void TASK_Telemetry(void) {
+  uint8_t frame[PACKET_MAX_FRAME_SIZE];
+  uint8_t type;
+  PACKET_Data data;
+
+  uint32_t time_ms = HAL_GetTick();
+  TASK_FillPacket(&data, time_ms);
+
+  // Packets due in this phase, within the link budget (queued, sent by DMA)
+  while ((type = TELEMETRY_Next(&telemetry, time_ms, RFD900_Pending())) != 0) {
+    data.sequence = telemetry_sequence++;
+    RFD900_Send(frame, PACKET_Encode(type, &data, frame));
+  }
+
+  TRACE(TRACE_ID_TELEMETRY, flight.phase, TRACE_Float(data.alt_dm * 0.1f), L76_data.fix);
+}
+
+/**
+ * EPO upload from the ground station: chunks received by the RFD900 interrupt (256 bytes ring
+ * filled in ~270 ms at 9600 baud), upload resumed after a failed record.
+ */
+static void TASK_EPO(void) {
+  uint8_t state = EPO_GetState();
+  EPO_Poll();
+  if (EPO_GetState() != state && (EPO_GetState() == EPO_DONE || EPO_GetState() == EPO_FAILED)) {
+    const EPO_Stats *stats = EPO_GetStats();
+    TRACE(TRACE_ID_EPO_UPLOAD, EPO_GetState(), stats->sent, stats->records, stats->end_ms - stats->start_ms,
+        stats->failures, stats->crc_errors);
+  }
+}
+
+/**
+ * Send the binary trace over ITM (lowest priority).
+ */
+static void TASK_Trace(void) {
+  TRACE_Flush(TRACE_FLUSH_WORDS);
+}
+
+/**
+ * Apply the rates of the current flight phase to the tasks.
+ */
+static void TASK_SetRates(void) {
+  const FLIGHT_Rates *rates = FLIGHT_GetRates(&flight);
+  SCHEDULER_SetPeriod(&scheduler, TASK_ID_BARO, rates->baro_period_ms);
+  SCHEDULER_SetPeriod(&scheduler, TASK_ID_GNSS, rates->gnss_period_ms);
+  SCHEDULER_SetPeriod(&scheduler, TASK_ID_LOG, rates->log_period_ms);
+  SCHEDULER_SetPeriod(&scheduler, TASK_ID_TELEMETRY, rates->telemetry_period_ms);
+  TELEMETRY_SetPhase(&telemetry, flight.phase, HAL_GetTick());
+}
+
+/**
+ * Barometric altitude of the last measurement with the exact formula (pow), for the log and
+ * the telemetry only. The flight tasks use BMP280_LinearAltitudeMm.
+ */
+static float TASK_GetAltitude(void) {
+  return BMP280_PressureToAltitude(bmp_data.press_Pa, bmp_data.press_ref_Pa);
+}
+
+/**
+ * Latest measurements and health counters, for the telemetry and the flight log.
+ */
+static void TASK_FillPacket(PACKET_Data *data, uint32_t time_ms) {
+  uint32_t overruns = 0;
+  TRACK_Estimate gnss;
+
+  GNSS_GetPosition(time_ms, &gnss);
+
+  for (uint8_t i = 0; i < scheduler.size; i++) {
+    overruns += scheduler.tasks[i].overruns;
+  }
+
+  *data = (PACKET_Data) {
+    .time_ms = time_ms,
+    .alt_dm = (int32_t)(TASK_GetAltitude() * 10),
+    .vel_dms = (int16_t)(flight.apogee.velocity_mps * 10),
+    .phase = flight.phase,
+    .fix = L76_data.fix,
+    .press_Pa = bmp_data.press_Pa_Q8 >> 8,
+    .temp_dC = (int16_t)(bmp_data.temp_C * 10),
+    .north_m = gnss.north_cm / 100,
+    .east_m = gnss.east_cm / 100,
+    .counters = {
+      [PACKET_COUNTER_RADIO_DROPPED] = RFD900_GetStats()->dropped_oldest,
+      [PACKET_COUNTER_TRACE_DROPPED] = TRACE_GetStats()->dropped,
+      [PACKET_COUNTER_TASK_OVERRUNS] = overruns,
+      [PACKET_COUNTER_BARO_ERRORS] = baro_errors,
+      [PACKET_COUNTER_GNSS_ERRORS] = gnss_errors,
+      [PACKET_COUNTER_GNSS_UART] = UARTERR_Errors(UARTERR_PORT_GNSS),
+      [PACKET_COUNTER_RADIO_UART] = UARTERR_Errors(UARTERR_PORT_RADIO),
+    },
+    .load_permille = SCHEDULER_Load(&scheduler),
+  };
+}
 
 /* USER CODE END 0 */
 
@@ -103,30 +575,170 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_SPI2_Init();
   MX_USART1_UART_Init();
   MX_USART2_UART_Init();
   /* USER CODE BEGIN 2 */
 
+  // Binary trace over ITM port 1 (decode with Tools/trace_decoder.py)
+  TRACE_Init(NULL);
+
+  // Cycle counter for execution time measurements
+  if (PROFILER_Init() != 0) {
+    DEBUG_PRINTF("PROFILER Initialization Error\r\n");
+  }
+
+  // SPI2 bus (barometer, IMU, SD card), DMA1 Channel4 shared by SPI2_RX and USART1_TX
+  SPIBUS_Init(&hspi2, NULL);
+  DMASHARE_Init();
+  DMASHARE_Register(DMASHARE_USER_USART1_TX, &hdma_usart1_tx, RFD900_Resume);
+  DMASHARE_Register(DMASHARE_USER_SPI2_RX, &hdma_spi2_rx, SPIBUS_Resume);
+
+  // UART errors counted, the reception stopped by an overrun is restarted in the USART interrupt
+  UARTERR_Init();
+  UARTERR_Register(UARTERR_PORT_GNSS, &huart2, L76LM33_RestartReceive);
+
+  // GNSS module, USART2 switched to the baud rate negotiated with the module. The flight
+  // continues without it (USART2 left at the factory baud rate, in case it answers later)
+  int8_t gnss_status = L76LM33_Init(&huart2, NULL);
+  if (gnss_status != 0) {
+    DEBUG_PRINTF("L76LM33 Initialization Error\r\n");
+    TRACE(TRACE_ID_GNSS_NOT_FOUND, L76LM33_GetLink()->init_ms, (uint32_t)L76LM33_BAUD_DEFAULT);
+  }
+  UARTERR_Clear(UARTERR_PORT_GNSS); // Framing errors at the wrong baud rates
+  if (gnss_status == 0 && (!L76LM33_GetLink()->fast || !L76LM33_GetLink()->rate_ok)) {
+    DEBUG_PRINTF("L76LM33 slow link: %lu baud, %u ms period\r\n", L76LM33_GetLink()->baud, L76LM33_GetLink()->period_ms);
+  }
+  // Warm start: last fix in flash and UTC time of the RTC given to the module, EPO window asked
+  GNSSAID_Init(NULL);
+  L76LM33_SetReplyHandler(GNSSAID_Reply);
+  if (GNSSAID_Start() == -1) {
+    DEBUG_PRINTF("GNSSAID aiding not queued\r\n");
+  }
+  // Aviation mode, acknowledged with interrupts during the barometer calibration
+  if (L76LM33_SetNavMode(L76LM33_NAVMODE_AVIATION, GNSS_NavModeDone) != 0) {
+    gnss_navmode = -1;
+  }
+
   // Barometer
   if (BMP280_Init(&bmp_data, &hspi2) != 0) {
-    printf("BMP280 Initialization Error\r\n");
+    DEBUG_PRINTF("BMP280 Initialization Error\r\n");
     // TODO: Buzzer or led 10 sec
     return -1; // Error
   }
+  if (gnss_navmode != 0) {
+    DEBUG_PRINTF("L76LM33 aviation mode not set (%d)\r\n", gnss_navmode);
+  }
+
+  // IMU (SPI2 bus), FIFO at 1 kHz, the flight continues on the barometer without it
+  if (ICM20602_Init(&hspi2, NULL) != 0) {
+    DEBUG_PRINTF("ICM20602 Initialization Error\r\n");
+  }
+
+  // Flight log on the SD card (SPI2 bus), the flight continues without it
+  if (SD_Init(&hspi2, NULL) != 0) {
+    DEBUG_PRINTF("SD Initialization Error\r\n");
+  } else if (SDLOG_Init(SDLOG_DEFAULT_FIRST_BLOCK, SDLOG_DEFAULT_BLOCKS, SDLOG_DEFAULT_RESERVE_BLOCKS,
+      HAL_GetTick()) != 0) {
+    DEBUG_PRINTF("SDLOG Initialization Error\r\n");
+  }
+  LOGREC_Init(&flight_log);
+  BLACKBOX_Init(&blackbox, BLACKBOX_DEFAULT_POST_MS);
+
+  // Telemetry radio, frames sent with DMA (keep the latest data when the link is saturated)
+  if (RFD900_Init(&huart1, RFD900_DROP_OLDEST, NULL) != 0) {
+    DEBUG_PRINTF("RFD900 Initialization Error\r\n");
+  }
+  UARTERR_Register(UARTERR_PORT_RADIO, &huart1, RFD900_RestartReceive);
+  // EPO file from the ground station on the pad, uploaded to the L76 as it arrives
+  EPO_Init(NULL);
+  if (RFD900_StartReceive(EPO_Receive) != 0 || EPO_StartLink() != 0) {
+    DEBUG_PRINTF("EPO link not started\r\n");
+  }
+
+  // Flight state machine
+  if (FLIGHT_Init(&flight, NULL, bmp_data.press_ref_Pa) != 0) {
+    DEBUG_PRINTF("FLIGHT Initialization Error\r\n");
+    return -1; // Error
+  }
 
-  // GNSS module
-  if (L76LM33_Init(&huart2) != 0) {
-    printf("L76LM33 Initialization Error\r\n");
-    // TODO: Buzzer or led 10 sec
+  // Baro/IMU altitude estimator (integer only, 1 kHz prediction)
+  if (FUSION_Init(&fusion, NULL) != 0) {
+    DEBUG_PRINTF("FUSION Initialization Error\r\n");
+  }
+
+  // GNSS dead reckoning between the fixes, pad frame
+  if (TRACK_Init(&track, NULL) != 0) {
+    DEBUG_PRINTF("TRACK Initialization Error\r\n");
+  }
+
+  // Telemetry packets per phase, 720 bytes/s at most on the radio
+  if (TELEMETRY_Init(&telemetry, NULL, HAL_GetTick()) != 0) {
+    DEBUG_PRINTF("TELEMETRY Initialization Error\r\n");
     return -1; // Error
   }
 
+  // Scheduler, SysTick time base and __WFI between tasks
+  if (SCHEDULER_Init(&scheduler, tasks, sizeof(tasks) / sizeof(tasks[0]), NULL, NULL) != 0) {
+    DEBUG_PRINTF("SCHEDULER Initialization Error\r\n");
+    return -1; // Error
+  }
+  TASK_SetRates();
+
+  // ICM20602 tests
+  //ICM20602_TESTS_Model_LogSTLINK();
+  //ICM20602_TESTS_Benchmark_LogSTLINK();
+  //ICM20602_TESTS_Read_LogSTLINK(&hspi2);
+
+  // GNSS tests (model of the module and USART2)
+  //L76LM33_TESTS_Model_LogSTLINK();
+  //GNSSAID_TESTS_Model_LogSTLINK();
+  //EPO_TESTS_Model_LogSTLINK();
+  //UARTERR_TESTS_Inject_LogSTLINK();
+
   // NMEA tests
   //NMEA_TESTS_ValidateRMC_LogSTLINK();
   //NMEA_TESTS_ParseRMC_LogSTLINK();
-
-  printf("Initialization success\r\n");
+  //NMEA_TESTS_ParseGGA_LogSTLINK();
+
+  // RFD900 tests
+  //RFD900_TESTS_Model_LogSTLINK();
+  //RFD900_TESTS_Send_LogSTLINK(&huart1);
+
+  // SPI2 bus tests
+  //SPIBUS_TESTS_Model_LogSTLINK();
+
+  // SD card and flight log tests
+  //SD_TESTS_Model_LogSTLINK();
+  //SD_TESTS_Card_LogSTLINK(&hspi2);
+  //SDLOG_TESTS_Model_LogSTLINK();
+  //LOGREC_TESTS_Fuzz_LogSTLINK();
+  //LOGREC_TESTS_Model_LogSTLINK();
+  //BLACKBOX_TESTS_Capture_LogSTLINK();
+
+  // Telemetry packet tests
+  //PACKET_TESTS_RoundTrip_LogSTLINK();
+  //PACKET_TESTS_Report_LogSTLINK();
+  //TELEMETRY_TESTS_Simulation_LogSTLINK();
+  //BMP280_TESTS_LinearAltitude_LogSTLINK();
+
+  // Flight logic tests
+  //FLIGHT_TESTS_Replay_LogSTLINK();
+  //APOGEE_TESTS_Replay_LogSTLINK();
+  //THRESHOLD_TESTS_Equivalence_LogSTLINK();
+  //MACHLOCK_TESTS_Replay_LogSTLINK();
+  //LAUNCH_TESTS_Replay_LogSTLINK();
+  //FUSION_TESTS_Replay_LogSTLINK();
+  //GEO_TESTS_Vincenty_LogSTLINK();
+  //TRACK_TESTS_Trajectories_LogSTLINK();
+
+  // Scheduler, profiler and trace tests
+  //SCHEDULER_TESTS_Simulation_LogSTLINK();
+  //PROFILER_TESTS_LogSTLINK();
+  //TRACE_TESTS_LogSTLINK();
+
+  DEBUG_PRINTF("Initialization success\r\n");
 
   /* USER CODE END 2 */
 
@@ -143,10 +755,14 @@ int main(void)
 
     // L76LM33
     //L76LM33_TESTS_ReadSentence_LogSTLINK();
-    //L76LM33_TESTS_ReadSentence_LogUART(&huart1);
-    L76LM33_TESTS_Read_LogSTLINK();
+    //L76LM33_TESTS_ReadSentence_LogUART();
+    //L76LM33_TESTS_Read_LogSTLINK();
+
+    // Execution time statistics (ITM, or &huart1 for the RFD900)
+    //PROFILER_Dump(NULL);
 
-    HAL_Delay(200);
+    // Tasks run at the rates of the current flight phase
+    SCHEDULER_Dispatch(&scheduler);
   }
   /* USER CODE END 3 */
 }
@@ -294,6 +910,25 @@ static void MX_USART2_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel4_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+  /* DMA1_Channel5_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -313,6 +948,12 @@ static void MX_GPIO_Init(void)
   /*Configure GPIO pin Output Level */
   HAL_GPIO_WritePin(BMP_CS_GPIO_Port, BMP_CS_Pin, GPIO_PIN_SET);
 
+  /*Configure GPIO pin Output Level */
+  HAL_GPIO_WritePin(ICM_CS_GPIO_Port, ICM_CS_Pin, GPIO_PIN_SET);
+
+  /*Configure GPIO pin Output Level */
+  HAL_GPIO_WritePin(SD_CS_GPIO_Port, SD_CS_Pin, GPIO_PIN_SET);
+
   /*Configure GPIO pin Output Level */
   HAL_GPIO_WritePin(DEBUG_GPIO_Port, DEBUG_Pin, GPIO_PIN_RESET);
 
@@ -323,6 +964,20 @@ static void MX_GPIO_Init(void)
   GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
   HAL_GPIO_Init(BMP_CS_GPIO_Port, &GPIO_InitStruct);
 
+  /*Configure GPIO pin : ICM_CS_Pin */
+  GPIO_InitStruct.Pin = ICM_CS_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(ICM_CS_GPIO_Port, &GPIO_InitStruct);
+
+  /*Configure GPIO pin : SD_CS_Pin */
+  GPIO_InitStruct.Pin = SD_CS_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(SD_CS_GPIO_Port, &GPIO_InitStruct);
+
   /*Configure GPIO pin : DEBUG_Pin */
   GPIO_InitStruct.Pin = DEBUG_Pin;
   GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
@@ -349,6 +1004,26 @@ int _write(int file, char *ptr, int len)
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
   L76LM33_RxCallback(huart);
+  RFD900_RxCallback(huart);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+  RFD900_TxCallback(huart);
+  L76LM33_TxCallback(huart);
+}
+
+// DMA errors of USART1 (receive errors are counted by UARTERR_IRQHandler)
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+  UARTERR_ErrorCallback(huart);
+}
+
+// SPI2 bus transfers, the bus calls SD_TxCallback and ICM20602_RxCallback
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+  SPIBUS_TxRxCallback(hspi);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+  SPIBUS_TxRxCallback(hspi);
 }
 /* USER CODE END 4 */
 
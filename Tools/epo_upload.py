@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+epo_upload.py
+
+Send an EPO file (MTK format, sets of 32 records of 72 bytes) to the rocket on the pad
+through the ground station RFD900 (GAUL_Drivers/EPO.c). The file is cut in chunks:
+"EP", index (uint16), count (uint16), 72 bytes of the record, CRC-16 of index to record,
+little endian. The flight computer keeps only the record it needs next and uploads it to
+the L76: the file is sent again in passes until every record went through (a record lost
+on the radio, or skipped while the L76 was writing, comes in the next pass).
+
+Usage:
+    python3 Tools/epo_upload.py EPO.DAT --port /dev/ttyUSB0 [--baud 9600] [--passes 3]
+    python3 Tools/epo_upload.py EPO.DAT --output stream.bin   (bytes that would be sent)
+"""
+
+import argparse
+import struct
+import sys
+
+RECORD_SIZE = 72
+SET_RECORDS = 32
+MAX_RECORDS = SET_RECORDS * 4 * 14  # EPO_MAX_RECORDS, 14 days
+SYNC = b"EP"
+CHUNK_SIZE = 2 + 4 + RECORD_SIZE + 2
+LINK_BYTES_PER_S = 960  # 9600 baud, 10 bits per byte
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, same as PACKET_CRC16."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def chunks(epo):
+    """Chunks of the whole file, in order."""
+    count = len(epo) // RECORD_SIZE
+    for index in range(count):
+        body = struct.pack("<HH", index, count) + epo[index * RECORD_SIZE:(index + 1) * RECORD_SIZE]
+        yield SYNC + body + struct.pack("<H", crc16(body))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Send an EPO file to the rocket through the radio")
+    parser.add_argument("epo", help="EPO file (MTK format)")
+    parser.add_argument("--port", help="serial port of the ground station radio")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--passes", type=int, default=3, help="times the whole file is sent")
+    parser.add_argument("--output", help="write the stream to a file instead of the radio")
+    arguments = parser.parse_args()
+
+    with open(arguments.epo, "rb") as file:
+        epo = file.read()
+    records = len(epo) // RECORD_SIZE
+    if len(epo) % (RECORD_SIZE * SET_RECORDS) != 0 or records == 0 or records > MAX_RECORDS:
+        sys.exit("%s: %u bytes, not whole sets of %u records of %u bytes (%u records at most)"
+                 % (arguments.epo, len(epo), SET_RECORDS, RECORD_SIZE, MAX_RECORDS))
+    stream = b"".join(chunks(epo))
+    print("%u records (%u sets), %u bytes per pass, ~%.0f s per pass at %u baud"
+          % (records, records // SET_RECORDS, len(stream), len(stream) * 10 / arguments.baud, arguments.baud))
+
+    if arguments.output:
+        with open(arguments.output, "wb") as file:
+            file.write(stream * arguments.passes)
+        return
+
+    if arguments.port is None:
+        parser.error("--port or --output required")
+    import serial  # pyserial
+    with serial.Serial(arguments.port, arguments.baud, timeout=1) as port:
+        for number in range(arguments.passes):
+            print("pass %u/%u" % (number + 1, arguments.passes))
+            port.write(stream)
+            port.flush()
+
+
+if __name__ == "__main__":
+    main()
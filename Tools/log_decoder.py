@@ -0,0 +1,345 @@
+#!/usr/bin/env python3
+"""
+log_decoder.py
+
+Decode the flight log of the SD card (GAUL_System/SDLOG.c and LOGREC.c) into one CSV file
+per record type, one column per field (time_ms first), ready for pandas or a spreadsheet.
+
+The card has no file system: block "first_block" is the index of the sessions (one per
+power-up), the session blocks follow. The end of a session not closed (power loss) is
+found by a binary search on the block headers, like SDLOG_FindEnd. Every block decodes
+alone (it starts with a TIME record), a corrupted record is counted and skipped.
+
+CAPTURE records carry the pages of the pre-trigger capture (GAUL_System/BLACKBOX.c) in
+chunks: a page is rebuilt from its chunks 0 to 27 in a row (a page with a chunk lost is
+dropped) and decoded into capture_baro.csv, capture_gnss.csv and capture_trigger.csv.
+
+Usage:
+    python3 Tools/log_decoder.py card.img --list          (sessions of the index)
+    python3 Tools/log_decoder.py card.img [--session N] [--out DIR]
+    sudo python3 Tools/log_decoder.py /dev/sdX --session N --out flight
+
+The image is read in chunks of whole blocks, records are checked with binascii.crc_hqx
+(CRC-16/CCITT-FALSE) and unpacked with precompiled struct formats: a 27 minute flight
+(16000 blocks) decodes in a few seconds.
+"""
+
+import argparse
+import binascii
+import csv
+import os
+import struct
+import sys
+
+BLOCK_SIZE = 512
+HEADER_SIZE = 16
+RECORD_SIZE = 16
+RECORDS_PER_BLOCK = (BLOCK_SIZE - HEADER_SIZE) // RECORD_SIZE
+LOG_MAGIC = 0x474F4C47    # "GLOG"
+INDEX_MAGIC = 0x58444947  # "GIDX"
+INDEX_VERSION = 1
+INDEX_HEADER_SIZE = 8
+SESSION_SIZE = 16
+OPEN = 0xFFFFFFFF
+CHUNK_BLOCKS = 2048       # 1 MB reads
+
+TYPE_TIME = 1
+TYPE_CAPTURE = 7
+COUNTERS = ["radio_dropped", "trace_dropped", "task_overruns", "baro_errors", "gnss_errors"]
+
+# Record type: (name, payload struct format, field names), same layout as LOGREC.c
+TYPES = {
+    1: ("time", "<IHI", ["session", "block"]),
+    2: ("baro", "<Ihi", ["press_Pa_Q8", "temp_cC", "alt_cm"]),
+    3: ("flight", "<ihhBB", ["alt_cm", "vel_dms", "accel_cms2", "phase", "flags"]),
+    4: ("gnss", "<iiBB", ["latitude_e7", "longitude_e7", "fix", "satellites"]),
+    5: ("event", "<BBBi3x", ["from", "to", "reason", "alt_cm"]),
+    6: ("health", "<5H", COUNTERS),
+    7: ("capture", "<B9s", ["chunk", "bytes"]),
+    8: ("uart", "<BHHHHB", ["port", "overruns", "framing", "noise", "dma", "parity"]),
+    9: ("machlock", "<BBhi2x", ["lock", "reason", "vel_dms", "alt_cm"]),
+}
+PREFIX = struct.Struct("<BBH")
+HEADER = struct.Struct("<IIHH")
+SESSION = struct.Struct("<IIII")
+UNPACK = {record_type: struct.Struct(fmt).unpack for record_type, (_, fmt, _) in TYPES.items()}
+EMPTY = (b"\xff" * RECORD_SIZE, b"\x00" * RECORD_SIZE)
+
+# Pre-trigger capture pages, same layout as BLACKBOX.h
+CAPTURE_CHUNK_SIZE = 9
+CAPTURE_PAGE_CHUNKS = 28
+CAPTURE_PAGE_HEADER = 2
+TAG_END, TAG_BARO, TAG_GNSS, TAG_TRIGGER, TAG_KEY = 0x00, 0x01, 0x02, 0x03, 0x80
+CAPTURE_FIELDS = {
+    TAG_BARO: ("capture_baro", ["press_Pa_Q8", "temp_cC"]),
+    TAG_GNSS: ("capture_gnss", ["latitude_e7", "longitude_e7", "fix"]),
+    TAG_TRIGGER: ("capture_trigger", ["reason"]),
+}
+KEY_BARO = struct.Struct("<IIh")
+KEY_GNSS = struct.Struct("<IiiB")
+KEY_TRIGGER = struct.Struct("<IB")
+
+
+class Image:
+    """Raw card image or block device, read by blocks."""
+
+    def __init__(self, path):
+        self.file = open(path, "rb")
+
+    def read(self, block, count=1):
+        self.file.seek(block * BLOCK_SIZE)
+        return self.file.read(count * BLOCK_SIZE)
+
+
+def read_index(image, first_block):
+    """Return the list of sessions (start, end, start time ms, reserved blocks)."""
+    index = image.read(first_block)
+    if len(index) < BLOCK_SIZE:
+        return []
+    magic, version, count = struct.unpack_from("<IHH", index)
+    if magic != INDEX_MAGIC or version != INDEX_VERSION:
+        return []
+    return [SESSION.unpack_from(index, INDEX_HEADER_SIZE + i * SESSION_SIZE) for i in range(count)]
+
+
+def block_valid(block, session, sequence):
+    if len(block) < BLOCK_SIZE:
+        return False
+    magic, block_sequence, block_session, _ = HEADER.unpack_from(block)
+    return magic == LOG_MAGIC and block_session == session and block_sequence == sequence
+
+
+def find_end(image, session, start, reserved, limit):
+    """First block after the session (binary search, like SDLOG_FindEnd)."""
+    low, high = start, limit
+    if 0 < reserved and start + reserved < high:
+        if not block_valid(image.read(start + reserved), session, reserved):
+            high = start + reserved
+    while low < high:
+        middle = (low + high) // 2
+        if block_valid(image.read(middle), session, middle - start):
+            low = middle + 1
+        else:
+            high = middle
+    return low
+
+
+def varint(page, p):
+    value = shift = 0
+    while shift < 35:
+        byte = page[p]
+        p += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value & 0xFFFFFFFF, p
+        shift += 7
+    raise IndexError("varint too long")
+
+
+def signed(page, p):
+    value, p = varint(page, p)
+    return (value >> 1) ^ -(value & 1), p
+
+
+def int32(value):
+    return (value + 0x80000000) % 0x100000000 - 0x80000000
+
+
+def decode_page(page):
+    """Samples of a capture page as (tag, time_ms, values...), like BLACKBOX_DecodePage.
+
+    Raises ValueError or IndexError if the page is malformed.
+    """
+    samples = []
+    baro = gnss = None
+    p = CAPTURE_PAGE_HEADER
+    while p < len(page) and page[p] != TAG_END:
+        tag = page[p]
+        p += 1
+        if tag == TAG_BARO | TAG_KEY:
+            baro = list(KEY_BARO.unpack_from(page, p))
+            p += KEY_BARO.size
+        elif tag == TAG_BARO and baro is not None:
+            delta, p = varint(page, p)
+            press, p = signed(page, p)
+            temp, p = signed(page, p)
+            baro = [(baro[0] + delta) & 0xFFFFFFFF, (baro[1] + press) & 0xFFFFFFFF, baro[2] + temp]
+        elif tag == TAG_GNSS | TAG_KEY:
+            gnss = list(KEY_GNSS.unpack_from(page, p))
+            p += KEY_GNSS.size
+        elif tag == TAG_GNSS and gnss is not None:
+            delta, p = varint(page, p)
+            latitude, p = signed(page, p)
+            longitude, p = signed(page, p)
+            gnss = [(gnss[0] + delta) & 0xFFFFFFFF, int32(gnss[1] + latitude), int32(gnss[2] + longitude), page[p]]
+            p += 1
+        elif tag == TAG_TRIGGER | TAG_KEY:
+            samples.append((TAG_TRIGGER,) + KEY_TRIGGER.unpack_from(page, p))
+            p += KEY_TRIGGER.size
+            continue
+        else:
+            raise ValueError("unknown tag 0x%02x" % tag)
+        samples.append((tag & ~TAG_KEY,) + tuple(baro if tag & ~TAG_KEY == TAG_BARO else gnss))
+    return samples
+
+
+class Capture:
+    """Pages of the pre-trigger capture rebuilt from the CAPTURE records."""
+
+    def __init__(self):
+        self.columns = {tag: [] for tag in CAPTURE_FIELDS}
+        self.page = bytearray()
+        self.next_chunk = None
+        self.pages = 0
+        self.dropped = 0
+
+    def chunk(self, index, data):
+        if index == 0:
+            if self.next_chunk is not None:
+                self.dropped += 1
+            self.page = bytearray()
+            self.next_chunk = 0
+        if index != self.next_chunk:
+            if self.next_chunk is not None:
+                self.dropped += 1
+            self.next_chunk = None
+            return
+        self.page += data
+        self.next_chunk += 1
+        if self.next_chunk < CAPTURE_PAGE_CHUNKS:
+            return
+        self.next_chunk = None
+        try:
+            samples = decode_page(bytes(self.page))
+        except (ValueError, IndexError, struct.error):
+            self.dropped += 1
+            return
+        self.pages += 1
+        for sample in samples:
+            self.columns[sample[0]].append(sample[1:])
+
+    def write_csv(self, directory):
+        for tag, rows in self.columns.items():
+            if not rows:
+                continue
+            name, fields = CAPTURE_FIELDS[tag]
+            with open(os.path.join(directory, name + ".csv"), "w", newline="") as file:
+                writer = csv.writer(file)
+                writer.writerow(["time_ms"] + fields)
+                writer.writerows(rows)
+
+
+class Decoder:
+    """Records of a session, in columns per record type."""
+
+    def __init__(self):
+        self.columns = {record_type: [] for record_type in TYPES}
+        self.sequence = None
+        self.records = 0
+        self.lost = 0
+        self.invalid = 0
+        self.bad_blocks = 0
+        self.capture = Capture()
+
+    def block(self, block, session, sequence):
+        if not block_valid(block, session, sequence):
+            self.bad_blocks += 1
+            return
+        base_ms = None
+        crc_hqx = binascii.crc_hqx
+        for offset in range(HEADER_SIZE, BLOCK_SIZE, RECORD_SIZE):
+            record = block[offset:offset + RECORD_SIZE]
+            if record in EMPTY:
+                continue
+            record_type, record_sequence, delta_ms = PREFIX.unpack_from(record)
+            if (crc_hqx(record[:14], 0xFFFF) != (record[14] << 8 | record[15]) or record_type not in TYPES
+                    or (record_type != TYPE_TIME and base_ms is None)):
+                self.invalid += 1
+                continue
+            values = UNPACK[record_type](record[4:14])
+            if record_type == TYPE_TIME:
+                base_ms = values[0]
+                values = values[1:]
+            if self.sequence is not None:
+                self.lost += (record_sequence - self.sequence - 1) & 0xFF
+            self.sequence = record_sequence
+            self.records += 1
+            if record_type == TYPE_CAPTURE:
+                self.capture.chunk(*values)
+                continue
+            self.columns[record_type].append((base_ms + delta_ms, record_sequence) + values)
+
+    def write_csv(self, directory):
+        os.makedirs(directory, exist_ok=True)
+        for record_type, rows in self.columns.items():
+            if not rows:
+                continue
+            name, _, fields = TYPES[record_type]
+            with open(os.path.join(directory, name + ".csv"), "w", newline="") as file:
+                writer = csv.writer(file)
+                writer.writerow(["time_ms", "sequence"] + fields)
+                writer.writerows(rows)
+        self.capture.write_csv(directory)
+
+
+def decode_session(image, first_block, session, limit):
+    sessions = read_index(image, first_block)
+    if session < 0:
+        session += len(sessions)
+    if not 0 <= session < len(sessions):
+        raise ValueError("no session %d in the index (%d sessions)" % (session, len(sessions)))
+    start, end, _, reserved = sessions[session]
+    if end == OPEN:
+        end = find_end(image, session, start, reserved, limit)
+
+    decoder = Decoder()
+    for chunk_start in range(start, end, CHUNK_BLOCKS):
+        count = min(CHUNK_BLOCKS, end - chunk_start)
+        data = image.read(chunk_start, count)
+        for i in range(count):
+            decoder.block(data[i * BLOCK_SIZE:(i + 1) * BLOCK_SIZE], session, chunk_start - start + i)
+    return decoder, start, end
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the flight log of the SD card")
+    parser.add_argument("image", help="raw card image or block device")
+    parser.add_argument("--first-block", type=int, default=0, help="index block (SDLOG_DEFAULT_FIRST_BLOCK)")
+    parser.add_argument("--blocks", type=int, default=0x400000, help="log region size (SDLOG_DEFAULT_BLOCKS)")
+    parser.add_argument("--list", action="store_true", help="list the sessions of the index")
+    parser.add_argument("--session", type=int, default=-1, help="session to decode (default: last)")
+    parser.add_argument("--out", default="log", help="output directory, one CSV per record type")
+    args = parser.parse_args()
+
+    image = Image(args.image)
+    limit = args.first_block + args.blocks
+    if args.list:
+        for i, (start, end, time_ms, reserved) in enumerate(read_index(image, args.first_block)):
+            state = "open" if end == OPEN else "%d blocks" % (end - start)
+            print("session %2d: block %d, %s, started at %d ms, %d blocks reserved" % (i, start, state, time_ms,
+                                                                                      reserved))
+        return 0
+
+    try:
+        decoder, start, end = decode_session(image, args.first_block, args.session, limit)
+    except ValueError as error:
+        print(error, file=sys.stderr)
+        return 1
+    decoder.write_csv(args.out)
+    print("blocks %d to %d: %d records, %d lost, %d invalid, %d bad blocks" % (start, end, decoder.records,
+                                                                             decoder.lost, decoder.invalid,
+                                                                             decoder.bad_blocks))
+    for record_type, rows in decoder.columns.items():
+        if rows:
+            print("  %-7s %7d" % (TYPES[record_type][0], len(rows)))
+    capture = decoder.capture
+    if capture.pages or capture.dropped:
+        print("capture: %d pages, %d dropped" % (capture.pages, capture.dropped))
+        for tag, rows in capture.columns.items():
+            if rows:
+                print("  %-15s %7d" % (CAPTURE_FIELDS[tag][0], len(rows)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
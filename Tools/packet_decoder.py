@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+packet_decoder.py
+
+Decode the binary telemetry packets (GAUL_System/PACKET.c) received by the ground station
+RFD900. Frames are separated by 0x00 (COBS), a corrupted frame is reported and decoding
+continues at the next frame.
+
+Usage:
+    python3 Tools/packet_decoder.py capture.bin       (raw bytes saved from the radio)
+    python3 Tools/packet_decoder.py --port /dev/ttyUSB0 [--baud 9600]   (needs pyserial)
+    python3 Tools/packet_decoder.py --report          (frame size and link usage per type)
+"""
+
+import argparse
+import math
+import sys
+
+PACKET_VERSION = 3
+HEADER_SIZE = 5
+CRC_SIZE = 2
+LINK_BYTES_PER_S = 960  # 9600 baud, 10 bits per byte
+
+PHASES = ["pad", "boost", "coast", "apogee", "drogue", "main", "landed", "?"]
+COUNTERS = ["radio_dropped", "trace_dropped", "task_overruns", "baro_errors", "gnss_errors",
+            "gnss_uart", "radio_uart"]
+
+# (name, bits, signed) in packing order, same layout as PACKET.c
+TYPES = {
+    1: ("FLIGHT", [("alt_dm", 20, True), ("vel_dms", 14, True), ("phase", 3, False), ("fix", 1, False)]),
+    2: ("BARO", [("press_Pa", 17, False), ("temp_dC", 11, True)]),
+    3: ("GNSS", [("north_m", 20, True), ("east_m", 20, True), ("fix", 1, False)]),
+    4: ("HEALTH", [(name, 16, False) for name in COUNTERS] + [("load_permille", 10, False)]),
+}
+
+
+def payload_size(fields):
+    return (sum(bits for _, bits, _ in fields) + 7) // 8
+
+
+def frame_size(fields):
+    return HEADER_SIZE + payload_size(fields) + CRC_SIZE + 2
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            raise ValueError("COBS error")
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class BitReader:
+    def __init__(self, data):
+        self.data = data
+        self.bit = 0
+
+    def get(self, bits, signed=False):
+        value = 0
+        for _ in range(bits):
+            value = (value << 1) | ((self.data[self.bit >> 3] >> (7 - (self.bit & 7))) & 1)
+            self.bit += 1
+        if signed and value & (1 << (bits - 1)):
+            value -= 1 << bits
+        return value
+
+
+def decode_frame(frame):
+    """Return (type name, fields dict) or raise ValueError."""
+    packet = cobs_decode(frame)
+    if len(packet) < HEADER_SIZE + CRC_SIZE:
+        raise ValueError("frame too short")
+    if crc16(packet[:-CRC_SIZE]) != (packet[-2] << 8 | packet[-1]):
+        raise ValueError("CRC error")
+    reader = BitReader(packet)
+    version = reader.get(3)
+    packet_type = reader.get(5)
+    if version != PACKET_VERSION or packet_type not in TYPES:
+        raise ValueError("unknown version %u type %u" % (version, packet_type))
+    name, fields = TYPES[packet_type]
+    if len(packet) != HEADER_SIZE + payload_size(fields) + CRC_SIZE:
+        raise ValueError("wrong size for %s" % name)
+    values = {"sequence": reader.get(8), "time_ms": reader.get(24)}
+    for field, bits, signed in fields:
+        values[field] = reader.get(bits, signed)
+    return name, values
+
+
+def format_values(name, values):
+    text = "%10u ms #%3u %-6s" % (values["time_ms"], values["sequence"], name)
+    if name == "FLIGHT":
+        text += " %8.1f m %7.1f m/s %-6s fix %u" % (values["alt_dm"] / 10, values["vel_dms"] / 10,
+                                                   PHASES[values["phase"]], values["fix"])
+    elif name == "BARO":
+        text += " %7u Pa %6.1f C" % (values["press_Pa"], values["temp_dC"] / 10)
+    elif name == "GNSS":
+        north, east = values["north_m"], values["east_m"]
+        text += " north %+7d east %+7d m, range %7.0f m bearing %5.1f deg fix %u" % (
+            north, east, math.hypot(east, north), math.degrees(math.atan2(east, north)) % 360, values["fix"])
+    elif name == "HEALTH":
+        text += " " + " ".join("%s=%u" % (counter, values[counter]) for counter in COUNTERS)
+        text += " load=%.1f%%" % (values["load_permille"] / 10)
+    return text
+
+
+def decode_stream(chunks, output=sys.stdout):
+    """Decode frames from an iterable of byte strings, return (frames, errors, lost)."""
+    frame = bytearray()
+    frames = errors = lost = 0
+    last_sequence = None
+    for chunk in chunks:
+        for byte in chunk:
+            if byte != 0:
+                frame.append(byte)
+                continue
+            if not frame:
+                continue
+            try:
+                name, values = decode_frame(bytes(frame))
+                if last_sequence is not None:
+                    lost += (values["sequence"] - last_sequence - 1) & 0xFF
+                last_sequence = values["sequence"]
+                frames += 1
+                output.write(format_values(name, values) + "\n")
+            except ValueError as error:
+                errors += 1
+                output.write("%s (%u bytes)\n" % (error, len(frame)))
+            frame.clear()
+    return frames, errors, lost
+
+
+def report(output=sys.stdout):
+    output.write("Type     payload  frame  bytes/s at 1 Hz / 10 Hz (link %u bytes/s)\n" % LINK_BYTES_PER_S)
+    for name, fields in TYPES.values():
+        size = frame_size(fields)
+        output.write("%-8s %7u %6u  %4u (%4.1f%%) / %4u (%4.1f%%)\n" % (
+            name, payload_size(fields), size, size, 100 * size / LINK_BYTES_PER_S,
+            10 * size, 1000 * size / LINK_BYTES_PER_S))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the binary telemetry packets")
+    parser.add_argument("capture", nargs="?", help="raw bytes received by the ground station radio")
+    parser.add_argument("--port", help="serial port of the ground station radio")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--report", action="store_true", help="print frame size and link usage per type")
+    arguments = parser.parse_args()
+
+    if arguments.report:
+        report()
+        return
+
+    if arguments.port:
+        import serial  # pyserial
+        with serial.Serial(arguments.port, arguments.baud, timeout=1) as port:
+            decode_stream(iter(lambda: port.read(64), None))
+        return
+
+    if arguments.capture is None:
+        parser.error("capture file or --port required")
+    with open(arguments.capture, "rb") as file:
+        frames, errors, lost = decode_stream([file.read()])
+    print("%u frames, %u rejected, %u lost (sequence)" % (frames, errors, lost))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+trace_decoder.py
+
+Decode the binary trace (GAUL_System/TRACE.c) from a raw SWO capture.
+
+The string table is generated from Core/Inc/GAUL_System/TRACE_MESSAGES.h: the message id
+is the position of the TRACE_MESSAGE line in the file. printf text sent on ITM port 0 is
+printed as is.
+
+Usage:
+    python3 Tools/trace_decoder.py capture.bin
+    python3 Tools/trace_decoder.py --table          (print the string table)
+
+The capture is the raw ITM stream, e.g. from OpenOCD:
+    itm port 0 on
+    itm port 1 on
+    tpiu config internal capture.bin uart off 72000000
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+TRACE_SYNC = 0xA5
+TRACE_PORT = 1
+TEXT_PORT = 0
+
+MESSAGES_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..",
+                             "Core", "Inc", "GAUL_System", "TRACE_MESSAGES.h")
+
+
+def load_table(path=MESSAGES_PATH):
+    """Return the list of (id name, format) in id order."""
+    table = []
+    pattern = re.compile(r'^\s*TRACE_MESSAGE\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+    with open(path, encoding="utf-8") as file:
+        for line in file:
+            match = pattern.match(line)
+            if match:
+                table.append((match.group(1), match.group(2).encode().decode("unicode_escape")))
+    return table
+
+
+CONVERSION = re.compile(r"%[-+ #0]*\d*(?:\.\d+)?(?:l|ll|h|hh)?([diuxXfeEgGc%])")
+
+
+def format_message(fmt, args):
+    """Apply a C format string to raw 32-bit arguments."""
+    values = iter(args)
+    out = []
+    position = 0
+    for match in CONVERSION.finditer(fmt):
+        out.append(fmt[position:match.start()])
+        position = match.end()
+        conversion = match.group(1)
+        spec = re.sub(r"(l|ll|h|hh)(?=[diuxXfeEgGc]$)", "", match.group(0))
+        if conversion == "%":
+            out.append("%")
+            continue
+        word = next(values, 0)
+        if conversion in "fFeEgG":
+            value = struct.unpack("<f", struct.pack("<I", word))[0]
+        elif conversion in "di":
+            value = word - (1 << 32) if word & 0x80000000 else word
+        elif conversion == "u":
+            spec = spec[:-1] + "d"
+            value = word
+        elif conversion == "c":
+            value = word & 0xFF
+        else:
+            value = word
+        out.append(spec % value)
+    out.append(fmt[position:])
+    return "".join(out)
+
+
+def itm_packets(data):
+    """Yield (port, payload bytes) of the ITM instrumentation packets."""
+    i = 0
+    while i < len(data):
+        header = data[i]
+        i += 1
+        if header == 0x00 or header == 0x80:
+            continue  # Synchronization
+        if header == 0x70:
+            continue  # Overflow
+        size = (1, 2, 4)[(header & 0x03) - 1] if header & 0x03 else 0
+        if size == 0:
+            # Timestamp or extension packet, skip continuation bytes
+            if header & 0x80:
+                while i < len(data) and data[i] & 0x80:
+                    i += 1
+                i += 1
+            continue
+        payload = data[i:i + size]
+        i += size
+        if header & 0x04:
+            continue  # Hardware source (DWT)
+        yield header >> 3, payload
+
+
+def decode(data, table, output=sys.stdout):
+    words = []
+    text = bytearray()
+    for port, payload in itm_packets(data):
+        if port == TEXT_PORT:
+            text += payload
+            while b"\n" in text:
+                line, _, text = text.partition(b"\n")
+                output.write("[printf] " + line.decode(errors="replace").rstrip("\r") + "\n")
+        elif port == TRACE_PORT and len(payload) == 4:
+            words.append(struct.unpack("<I", payload)[0])
+
+    i = 0
+    while i + 1 < len(words):
+        header = words[i]
+        if header >> 24 != TRACE_SYNC:
+            i += 1  # Lost synchronization, search next header
+            continue
+        argc = (header >> 16) & 0x0F
+        message_id = header & 0xFFFF
+        if i + 2 + argc > len(words):
+            break  # Incomplete record at the end of the capture
+        time_ms = words[i + 1]
+        args = words[i + 2:i + 2 + argc]
+        i += 2 + argc
+        if message_id < len(table):
+            name, fmt = table[message_id]
+            output.write("%10u ms %s\n" % (time_ms, format_message(fmt, args)))
+        else:
+            output.write("%10u ms unknown id %u %s\n" % (time_ms, message_id, args))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the binary ITM trace")
+    parser.add_argument("capture", nargs="?", help="raw SWO capture")
+    parser.add_argument("--messages", default=MESSAGES_PATH, help="path of TRACE_MESSAGES.h")
+    parser.add_argument("--table", action="store_true", help="print the string table")
+    arguments = parser.parse_args()
+
+    table = load_table(arguments.messages)
+    if arguments.table:
+        for message_id, (name, fmt) in enumerate(table):
+            print("%3u %-32s %s" % (message_id, name, fmt))
+        return
+    if arguments.capture is None:
+        parser.error("capture file required")
+
+    with open(arguments.capture, "rb") as file:
+        decode(file.read(), table)
+
+
+if __name__ == "__main__":
+    main()